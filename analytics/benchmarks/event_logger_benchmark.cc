@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+
+#include "analytics/benchmarks/local_collector.h"
+#include "analytics/src/desktop/event_logger.h"
+#include "analytics/src/include/firebase/analytics.h"
+#include "app/src/include/firebase/app.h"
+#include "app/src/semaphore.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+namespace {
+
+AppOptions MakeOptions() {
+  AppOptions options;
+  options.set_app_id("com.google.firebase.benchmark");
+  options.set_api_key("not_a_real_api_key");
+  options.set_project_id("not_a_real_project_id");
+  return options;
+}
+
+App* SharedApp() {
+  static App* app = []() {
+    LocalCollector::Install();
+    return App::Create(MakeOptions(), "benchmark");
+  }();
+  return app;
+}
+
+EventLogger* NewLogger(const EventLoggerSettings& settings) {
+  return new EventLogger(*SharedApp(), settings);
+}
+
+// Waits until the collector received `events` events in total.
+void WaitForUploads(EventLogger* logger, int64_t events) {
+  while (LocalCollector::events_.load() < events) {
+    Semaphore flushed(0);
+    logger->Flush(&flushed);
+    flushed.Wait();
+  }
+}
+
+// Cost to the caller of logging an event with a few parameters, which is all
+// an app pays on its own thread.
+void BM_AnalyticsLogEvent(benchmark::State& state) {
+  // Shared by the threads of a multithreaded run, which only start the loop
+  // once thread 0 created it, and only delete it once they all left it.
+  static EventLoggerSettings settings;
+  static EventLogger* logger = nullptr;
+  if (state.thread_index() == 0) {
+    settings = LocalLoggerSettings(kCollectorURL, "log_event");
+    logger = NewLogger(settings);
+  }
+  Parameter parameters[] = {Parameter("character", "mysterion"),
+                            Parameter("level", 42),
+                            Parameter("score", 1234.5)};
+  for (auto _ : state) {
+    logger->LogEvent("level_up", parameters, 3);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete logger;
+    logger = nullptr;
+    RemoveLoggerFiles(settings);
+  }
+}
+BENCHMARK(BM_AnalyticsLogEvent)->ThreadRange(1, 4)->UseRealTime();
+
+// Log range(0) events and wait until the collector received them, including
+// batching, the compressed disk queue and uploading.
+void BM_AnalyticsEndToEnd(benchmark::State& state) {
+  EventLoggerSettings settings =
+      LocalLoggerSettings(kCountedCollectorURL, "end_to_end");
+  EventLogger* logger = NewLogger(settings);
+  int64_t events = LocalCollector::events_.load();
+  int64_t bytes = LocalCollector::bytes_.load();
+
+  Parameter parameters[] = {Parameter("character", "mysterion"),
+                            Parameter("level", 42),
+                            Parameter("score", 1234.5)};
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      logger->LogEvent("level_up", parameters, 3);
+    }
+    events += state.range(0);
+    WaitForUploads(logger, events);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["uploaded_bytes_per_event"] = benchmark::Counter(
+      static_cast<double>(LocalCollector::bytes_.load() - bytes) /
+      static_cast<double>(state.iterations() * state.range(0)));
+  delete logger;
+  RemoveLoggerFiles(settings);
+}
+BENCHMARK(BM_AnalyticsEndToEnd)->ArgName("events")->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/benchmarks/local_collector.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "analytics/src/desktop/batch_store.h"
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_builder.h"
+#include "app/rest/util.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+const char kCollectorURL[] = "http://localhost/collect";
+const char kCountedCollectorURL[] = "http://localhost/counted";
+
+std::atomic<int64_t> LocalCollector::events_(0);
+std::atomic<int64_t> LocalCollector::bytes_(0);
+
+void LocalCollector::Install() {
+  rest::SetTransportBuilder([]() -> flatbuffers::unique_ptr<rest::Transport> {
+    return flatbuffers::unique_ptr<rest::Transport>(new LocalCollector());
+  });
+}
+
+void LocalCollector::PerformInternal(
+    rest::Request* request, rest::Response* response,
+    flatbuffers::unique_ptr<rest::Controller>* controller_out) {
+  std::string body;
+  request->ReadBodyIntoString(&body);
+  if (request->options().url.find(kCountedCollectorURL) == 0) {
+    // Each event has one timestamp.
+    int64_t events = 0;
+    for (size_t i = body.find("timestamp_micros"); i != std::string::npos;
+         i = body.find("timestamp_micros", i + 1)) {
+      ++events;
+    }
+    events_ += events;
+    bytes_ += static_cast<int64_t>(body.size());
+  }
+  response->set_status(rest::util::HttpSuccess);
+  response->MarkCompleted();
+}
+
+EventLoggerSettings LocalLoggerSettings(const char* upload_url,
+                                        const char* name) {
+  const char* dir = nullptr;
+  for (const char* variable : {"TEST_TMPDIR", "TMPDIR", "TEMP", "TMP"}) {
+    dir = getenv(variable);
+    if (dir && *dir) break;
+  }
+  EventLoggerSettings settings;
+  settings.upload_url = upload_url;
+  settings.path_prefix = std::string(dir && *dir ? dir : "/tmp") +
+                         "/firebase_analytics_benchmark_" + name + "_";
+  RemoveLoggerFiles(settings);
+  return settings;
+}
+
+void RemoveLoggerFiles(const EventLoggerSettings& settings) {
+  BatchStore(settings.path_prefix, settings.max_stored_batches).Clear();
+  std::remove((settings.path_prefix + "index").c_str());
+  std::remove((settings.path_prefix + "app_instance_id").c_str());
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
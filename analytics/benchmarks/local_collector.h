@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_ANALYTICS_BENCHMARKS_LOCAL_COLLECTOR_H_
+#define FIREBASE_ANALYTICS_BENCHMARKS_LOCAL_COLLECTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "analytics/src/desktop/event_logger.h"
+#include "app/rest/transport_interface.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+// Uploads to this URL are accepted without being counted.
+extern const char kCollectorURL[];
+// Only uploads to this URL are counted.
+extern const char kCountedCollectorURL[];
+
+// Stands in for the collection endpoint, so that benchmarks never upload
+// anything: accepts every batch, and counts the events and bytes sent to
+// kCountedCollectorURL.
+class LocalCollector : public rest::Transport {
+ public:
+  static std::atomic<int64_t> events_;
+  static std::atomic<int64_t> bytes_;
+
+  // Makes every rest transport created from now on a LocalCollector.
+  static void Install();
+
+ private:
+  void PerformInternal(
+      rest::Request* request, rest::Response* response,
+      flatbuffers::unique_ptr<rest::Controller>* controller_out) override;
+};
+
+// Returns settings for a logger that uploads to `upload_url` and keeps its
+// files in the temporary directory, under a prefix named after `name`. Files
+// left there by an earlier run are removed first.
+EventLoggerSettings LocalLoggerSettings(const char* upload_url,
+                                        const char* name);
+
+// Removes the files kept by a logger, which must have been deleted, with the
+// given settings.
+void RemoveLoggerFiles(const EventLoggerSettings& settings);
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
+
+#endif  // FIREBASE_ANALYTICS_BENCHMARKS_LOCAL_COLLECTOR_H_
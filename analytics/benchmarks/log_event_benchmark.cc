@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+
+#include "analytics/benchmarks/local_collector.h"
+#include "analytics/src/desktop/event_logger.h"
+#include "analytics/src/include/firebase/analytics.h"
+#include "analytics/src/include/firebase/analytics/event_names.h"
+#include "analytics/src/include/firebase/analytics/event_schema.h"
+#include "analytics/src/include/firebase/analytics/parameter_names.h"
+#include "app/src/include/firebase/app.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace analytics {
+namespace {
+
+// Compares the cost to the caller of logging a gameplay event with
+// Parameters, which builds a Variant for each value, and with an
+// EventSchema, which encodes the values into one buffer.
+
+// Initializes Analytics with a logger that keeps its files in the temporary
+// directory and uploads to a LocalCollector. Called by thread 0 before the
+// other threads of a run start logging.
+internal::EventLoggerSettings InitializeAnalytics() {
+  static App* app = []() {
+    internal::LocalCollector::Install();
+    AppOptions options;
+    options.set_app_id("com.google.firebase.benchmark");
+    options.set_api_key("not_a_real_api_key");
+    options.set_project_id("not_a_real_project_id");
+    return App::Create(options, "log_event_benchmark");
+  }();
+  internal::EventLoggerSettings settings = internal::LocalLoggerSettings(
+      internal::kCollectorURL, "log_event_api");
+  internal::Initialize(*app, settings);
+  return settings;
+}
+
+// Called by thread 0 once all threads of a run stopped logging.
+void TerminateAnalytics(const internal::EventLoggerSettings& settings) {
+  Terminate();
+  internal::RemoveLoggerFiles(settings);
+}
+
+void BM_LogEventWithParameters(benchmark::State& state) {
+  static internal::EventLoggerSettings settings;
+  if (state.thread_index() == 0) settings = InitializeAnalytics();
+  for (auto _ : state) {
+    Parameter parameters[] = {Parameter(kParameterLevel, 42),
+                              Parameter(kParameterScore, 1234.5),
+                              Parameter(kParameterCharacter, "mysterion")};
+    LogEvent(kEventLevelUp, parameters, 3);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) TerminateAnalytics(settings);
+}
+BENCHMARK(BM_LogEventWithParameters)->ThreadRange(1, 4)->UseRealTime();
+
+void BM_LogEventWithSchema(benchmark::State& state) {
+  static const EventSchema<int64_t, double, const char*> kLevelUp(
+      kEventLevelUp, kParameterLevel, kParameterScore, kParameterCharacter);
+  static internal::EventLoggerSettings settings;
+  if (state.thread_index() == 0) settings = InitializeAnalytics();
+  for (auto _ : state) {
+    LogEvent(kLevelUp, 42, 1234.5, "mysterion");
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) TerminateAnalytics(settings);
+}
+BENCHMARK(BM_LogEventWithSchema)->ThreadRange(1, 4)->UseRealTime();
+
+}  // namespace
+}  // namespace analytics
+}  // namespace firebase
@@ -380,6 +380,33 @@ void LogEvent(const char* name, const Parameter* parameters,
   });
 }
 
+namespace internal {
+
+// Log an event with parameters encoded by an EventSchema.
+void LogEncodedEvent(const char* name, const uint8_t* parameters,
+                     size_t size) {
+  FIREBASE_ASSERT_RETURN_VOID(IsInitialized());
+  JNIEnv* env = g_app->GetJNIEnv();
+  LogEvent(env, name, [env, parameters, size](jobject bundle) {
+    EncodedParameterReader reader(parameters, size);
+    while (reader.Next()) {
+      switch (reader.type()) {
+        case kEncodedParameterInt64:
+          AddToBundle(env, bundle, reader.name(), reader.int64_value());
+          break;
+        case kEncodedParameterDouble:
+          AddToBundle(env, bundle, reader.name(), reader.double_value());
+          break;
+        case kEncodedParameterString:
+          AddToBundle(env, bundle, reader.name(), reader.string_value());
+          break;
+      }
+    }
+  });
+}
+
+}  // namespace internal
+
 /// Initiates on-device conversion measurement given a user email address on iOS
 /// (no-op on Android). On iOS, requires dependency
 /// GoogleAppMeasurementOnDeviceConversion to be linked in, otherwise it is a
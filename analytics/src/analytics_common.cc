@@ -18,6 +18,8 @@
 
 #include <assert.h>
 
+#include <cstring>
+
 #include "analytics/src/include/firebase/analytics.h"
 #include "app/src/cleanup_notifier.h"
 #include "app/src/util.h"
@@ -93,6 +95,45 @@ void UnregisterTerminateOnDefaultAppDestroy() {
   }
 }
 
+bool EncodedParameterReader::Next() {
+  if (position_ >= end_) return false;
+  uint8_t type = *position_++;
+  name_ = ReadString();
+  if (name_ == nullptr) return false;
+  switch (type) {
+    case kEncodedParameterInt64:
+    case kEncodedParameterDouble: {
+      if (end_ - position_ < 8) return false;
+      if (type == kEncodedParameterInt64) {
+        memcpy(&int64_value_, position_, sizeof(int64_value_));
+      } else {
+        memcpy(&double_value_, position_, sizeof(double_value_));
+      }
+      position_ += 8;
+      break;
+    }
+    case kEncodedParameterString:
+      string_value_ = ReadString();
+      if (string_value_ == nullptr) return false;
+      break;
+    default:
+      return false;
+  }
+  type_ = static_cast<EncodedParameterType>(type);
+  return true;
+}
+
+const char* EncodedParameterReader::ReadString() {
+  const void* terminator = memchr(position_, '\0', end_ - position_);
+  if (terminator == nullptr) {
+    position_ = end_;
+    return nullptr;
+  }
+  const char* value = reinterpret_cast<const char*>(position_);
+  position_ = static_cast<const uint8_t*>(terminator) + 1;
+  return value;
+}
+
 }  // namespace internal
 }  // namespace analytics
 }  // namespace firebase
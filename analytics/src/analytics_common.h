@@ -17,6 +17,10 @@
 #ifndef FIREBASE_ANALYTICS_SRC_ANALYTICS_COMMON_H__
 #define FIREBASE_ANALYTICS_SRC_ANALYTICS_COMMON_H__
 
+#include <cstddef>
+#include <cstdint>
+
+#include "analytics/src/include/firebase/analytics/event_schema.h"
 #include "app/src/reference_counted_future_impl.h"
 
 namespace firebase {
@@ -59,6 +63,44 @@ void UnregisterTerminateOnDefaultAppDestroy();
 // This is implemented per platform.
 bool IsInitialized();
 
+// Reads the parameters encoded by an EventSchema, in order.
+class EncodedParameterReader {
+ public:
+  EncodedParameterReader(const uint8_t* data, size_t size)
+      : position_(data),
+        end_(data + size),
+        type_(kEncodedParameterInt64),
+        name_(nullptr),
+        int64_value_(0),
+        double_value_(0.0),
+        string_value_(nullptr) {}
+
+  // Moves to the next parameter. Returns false once every parameter was
+  // read, or if the rest of the data is malformed.
+  bool Next();
+
+  // The parameter read by the last call to Next(). Strings point into the
+  // encoded data.
+  EncodedParameterType type() const { return type_; }
+  const char* name() const { return name_; }
+  int64_t int64_value() const { return int64_value_; }
+  double double_value() const { return double_value_; }
+  const char* string_value() const { return string_value_; }
+
+ private:
+  // Reads a null-terminated string, or returns nullptr if it is not
+  // terminated before the end of the data.
+  const char* ReadString();
+
+  const uint8_t* position_;
+  const uint8_t* end_;
+  EncodedParameterType type_;
+  const char* name_;
+  int64_t int64_value_;
+  double double_value_;
+  const char* string_value_;
+};
+
 }  // namespace internal
 }  // namespace analytics
 }  // namespace firebase
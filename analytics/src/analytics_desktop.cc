@@ -1,5 +1,5 @@
 /*
- * Copyright 2016 Google LLC
+ * Copyright 2020 Google LLC
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,69 +14,95 @@
  * limitations under the License.
  */
 
-#include <sstream>
+#include <map>
+#include <string>
 
 #include "analytics/src/analytics_common.h"
+#include "analytics/src/desktop/event_logger.h"
 #include "analytics/src/include/firebase/analytics.h"
 #include "app/src/assert.h"
 #include "app/src/include/firebase/version.h"
+#include "app/src/log.h"
 
 namespace firebase {
 namespace analytics {
 
 DEFINE_FIREBASE_VERSION_STRING(FirebaseAnalytics);
 
-static bool g_initialized = false;
-static int g_fake_instance_id = 0;
+static internal::EventLogger* g_event_logger = nullptr;
 
 // Initialize the API.
-void Initialize(const ::firebase::App& /*app*/) {
-  g_initialized = true;
-  internal::RegisterTerminateOnDefaultAppDestroy();
-  internal::FutureData::Create();
-  g_fake_instance_id = 0;
+void Initialize(const ::firebase::App& app) {
+  internal::Initialize(app, internal::EventLoggerSettings());
 }
 
 namespace internal {
 
+void Initialize(const ::firebase::App& app,
+                const EventLoggerSettings& settings) {
+  if (g_event_logger) {
+    LogWarning("%s API already initialized", kAnalyticsModuleName);
+    return;
+  }
+  RegisterTerminateOnDefaultAppDestroy();
+  FutureData::Create();
+  g_event_logger = new EventLogger(app, settings);
+}
+
 // Determine whether the analytics module is initialized.
-bool IsInitialized() { return g_initialized; }
+bool IsInitialized() { return g_event_logger != nullptr; }
 
 }  // namespace internal
 
 // Terminate the API.
 void Terminate() {
+  if (!g_event_logger) {
+    LogWarning("%s API already shut down", internal::kAnalyticsModuleName);
+    return;
+  }
+  delete g_event_logger;
+  g_event_logger = nullptr;
   internal::FutureData::Destroy();
   internal::UnregisterTerminateOnDefaultAppDestroy();
-  g_initialized = false;
 }
 
 // Enable / disable measurement and reporting.
-void SetAnalyticsCollectionEnabled(bool /*enabled*/) {
+void SetAnalyticsCollectionEnabled(bool enabled) {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+  g_event_logger->SetCollectionEnabled(enabled);
 }
 
 // Enable / disable measurement and reporting.
 void SetConsent(const std::map<ConsentType, ConsentStatus>& consent_settings) {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+  // Events are only stored with analytics storage consent. Ads are not
+  // measured on desktop.
+  auto analytics_storage = consent_settings.find(kConsentTypeAnalyticsStorage);
+  if (analytics_storage != consent_settings.end()) {
+    g_event_logger->SetAnalyticsStorageGranted(analytics_storage->second ==
+                                               kConsentStatusGranted);
+  }
 }
 
 // Log an event with one string parameter.
-void LogEvent(const char* /*name*/, const char* /*parameter_name*/,
-              const char* /*parameter_value*/) {
-  FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+void LogEvent(const char* name, const char* parameter_name,
+              const char* parameter_value) {
+  Parameter parameter(parameter_name, parameter_value);
+  LogEvent(name, &parameter, 1);
 }
 
 // Log an event with one double parameter.
-void LogEvent(const char* /*name*/, const char* /*parameter_name*/,
-              const double /*parameter_value*/) {
-  FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+void LogEvent(const char* name, const char* parameter_name,
+              const double parameter_value) {
+  Parameter parameter(parameter_name, parameter_value);
+  LogEvent(name, &parameter, 1);
 }
 
 // Log an event with one 64-bit integer parameter.
-void LogEvent(const char* /*name*/, const char* /*parameter_name*/,
-              const int64_t /*parameter_value*/) {
-  FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+void LogEvent(const char* name, const char* parameter_name,
+              const int64_t parameter_value) {
+  Parameter parameter(parameter_name, parameter_value);
+  LogEvent(name, &parameter, 1);
 }
 
 // Log an event with one integer parameter (stored as a 64-bit integer).
@@ -92,11 +118,25 @@ void LogEvent(const char* name) {
 }
 
 // Log an event with associated parameters.
-void LogEvent(const char* /*name*/, const Parameter* /*parameters*/,
-              size_t /*number_of_parameters*/) {
+void LogEvent(const char* name, const Parameter* parameters,
+              size_t number_of_parameters) {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+  FIREBASE_ASSERT_RETURN_VOID(name != nullptr);
+  g_event_logger->LogEvent(name, parameters, number_of_parameters);
 }
 
+namespace internal {
+
+// Log an event with parameters encoded by an EventSchema.
+void LogEncodedEvent(const char* name, const uint8_t* parameters,
+                     size_t size) {
+  FIREBASE_ASSERT_RETURN_VOID(IsInitialized());
+  FIREBASE_ASSERT_RETURN_VOID(name != nullptr);
+  g_event_logger->LogEncodedEvent(name, parameters, size);
+}
+
+}  // namespace internal
+
 /// Initiates on-device conversion measurement given a user email address on iOS
 /// (no-op on Android). On iOS, requires dependency
 /// GoogleAppMeasurementOnDeviceConversion to be linked in, otherwise it is a
@@ -107,25 +147,29 @@ void InitiateOnDeviceConversionMeasurementWithEmailAddress(
 }
 
 // Set a user property to the given value.
-void SetUserProperty(const char* /*name*/, const char* /*value*/) {
+void SetUserProperty(const char* name, const char* value) {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+  FIREBASE_ASSERT_RETURN_VOID(name != nullptr);
+  g_event_logger->SetUserProperty(name, value);
 }
 
 // Sets the user ID property. This feature must be used in accordance with
 // <a href="https://www.google.com/policies/privacy">
 // Google's Privacy Policy</a>
-void SetUserId(const char* /*user_id*/) {
+void SetUserId(const char* user_id) {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+  g_event_logger->SetUserId(user_id);
 }
 
 // Sets the duration of inactivity that terminates the current session.
-void SetSessionTimeoutDuration(int64_t /*milliseconds*/) {
+void SetSessionTimeoutDuration(int64_t milliseconds) {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
+  g_event_logger->SetSessionTimeoutDuration(milliseconds);
 }
 
 void ResetAnalyticsData() {
   FIREBASE_ASSERT_RETURN_VOID(internal::IsInitialized());
-  g_fake_instance_id++;
+  g_event_logger->ResetAnalyticsData();
 }
 
 Future<std::string> GetAnalyticsInstanceId() {
@@ -133,13 +177,7 @@ Future<std::string> GetAnalyticsInstanceId() {
   auto* api = internal::FutureData::Get()->api();
   const auto future_handle =
       api->SafeAlloc<std::string>(internal::kAnalyticsFnGetAnalyticsInstanceId);
-  std::string instance_id = std::string("FakeAnalyticsInstanceId");
-  {
-    std::stringstream ss;
-    ss << g_fake_instance_id;
-    instance_id += ss.str();
-  }
-  api->CompleteWithResult(future_handle, 0, "", instance_id);
+  g_event_logger->GetAppInstanceId(api, future_handle);
   return Future<std::string>(api, future_handle.get());
 }
 
@@ -258,6 +258,34 @@ void LogEvent(const char* name, const Parameter* parameters, size_t number_of_pa
   [FIRAnalytics logEventWithName:@(name) parameters:parameters_dict];
 }
 
+namespace internal {
+
+// Log an event with parameters encoded by an EventSchema.
+void LogEncodedEvent(const char* name, const uint8_t* parameters, size_t size) {
+  FIREBASE_ASSERT_RETURN_VOID(IsInitialized());
+  NSMutableDictionary* parameters_dict = [NSMutableDictionary dictionary];
+  EncodedParameterReader reader(parameters, size);
+  while (reader.Next()) {
+    NSString* parameter_name = SafeString(reader.name());
+    switch (reader.type()) {
+      case kEncodedParameterInt64:
+        [parameters_dict setObject:[NSNumber numberWithLongLong:reader.int64_value()]
+                            forKey:parameter_name];
+        break;
+      case kEncodedParameterDouble:
+        [parameters_dict setObject:[NSNumber numberWithDouble:reader.double_value()]
+                            forKey:parameter_name];
+        break;
+      case kEncodedParameterString:
+        [parameters_dict setObject:SafeString(reader.string_value()) forKey:parameter_name];
+        break;
+    }
+  }
+  [FIRAnalytics logEventWithName:@(name) parameters:parameters_dict];
+}
+
+}  // namespace internal
+
 /// Initiates on-device conversion measurement given a user email address on iOS (no-op on
 /// Android). On iOS, requires dependency GoogleAppMeasurementOnDeviceConversion to be linked
 /// in, otherwise it is a no-op.
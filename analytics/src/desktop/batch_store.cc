@@ -0,0 +1,218 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/desktop/batch_store.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "app/rest/zlibwrapper.h"
+#include "app/src/log.h"
+#include "firebase/variant_serialization.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+namespace {
+
+// A batch file is the magic, the size of the serialized batch as a 32-bit
+// little-endian number, then the serialized batch compressed with zlib.
+const char kBatchMagic[] = {'F', 'A', 'B', '1'};
+const size_t kBatchHeaderSize = sizeof(kBatchMagic) + 4;
+
+// Guards against allocating a huge buffer for a corrupted file.
+const uint32_t kMaxSerializedBatchSize = 16 * 1024 * 1024;
+
+bool ReadFile(const std::string& path, std::string* contents) {
+  std::ifstream file(path, std::ios_base::binary);
+  if (!file) return false;
+  contents->assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+bool FileExists(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  return static_cast<bool>(file);
+}
+
+// Writes a file under a temporary name and then moves it in place, so a crash
+// never leaves a partially written file behind.
+bool WriteFile(const std::string& path, const void* data, size_t size) {
+  std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path,
+                       std::ios_base::trunc | std::ios_base::binary);
+    if (!file) {
+      LogError("Unable to open '%s' for writing.", temp_path.c_str());
+      return false;
+    }
+    file.write(static_cast<const char*>(data), size);
+    if (file.fail()) {
+      file.close();
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+  // Windows does not replace an existing file when renaming.
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0 &&
+      (std::remove(path.c_str()) != 0 ||
+       std::rename(temp_path.c_str(), path.c_str()) != 0)) {
+    LogError("Unable to move '%s' to '%s'.", temp_path.c_str(), path.c_str());
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool EncodeBatch(const Variant& batch, std::vector<uint8_t>* encoded) {
+  std::vector<uint8_t> serialized;
+  if (!SerializeVariant(batch, &serialized) ||
+      serialized.size() > kMaxSerializedBatchSize) {
+    return false;
+  }
+  uLongf compressed_size = ZLib::MinCompressbufSize(serialized.size());
+  encoded->resize(kBatchHeaderSize + compressed_size);
+  memcpy(encoded->data(), kBatchMagic, sizeof(kBatchMagic));
+  uint32_t size = static_cast<uint32_t>(serialized.size());
+  uint8_t* header = encoded->data() + sizeof(kBatchMagic);
+  for (int i = 0; i < 4; ++i) header[i] = static_cast<uint8_t>(size >> (8 * i));
+  ZLib zlib;
+  if (zlib.Compress(encoded->data() + kBatchHeaderSize, &compressed_size,
+                    serialized.data(), serialized.size()) != Z_OK) {
+    return false;
+  }
+  encoded->resize(kBatchHeaderSize + compressed_size);
+  return true;
+}
+
+bool DecodeBatch(const std::string& encoded, Variant* batch) {
+  if (encoded.size() < kBatchHeaderSize ||
+      memcmp(encoded.data(), kBatchMagic, sizeof(kBatchMagic)) != 0) {
+    return false;
+  }
+  const uint8_t* header =
+      reinterpret_cast<const uint8_t*>(encoded.data()) + sizeof(kBatchMagic);
+  uint32_t size = 0;
+  for (int i = 0; i < 4; ++i) {
+    size |= static_cast<uint32_t>(header[i]) << (8 * i);
+  }
+  if (size > kMaxSerializedBatchSize) return false;
+
+  std::vector<uint8_t> serialized(size);
+  uLongf serialized_size = size;
+  ZLib zlib;
+  if (zlib.Uncompress(
+          serialized.data(), &serialized_size,
+          reinterpret_cast<const Bytef*>(encoded.data()) + kBatchHeaderSize,
+          encoded.size() - kBatchHeaderSize) != Z_OK ||
+      serialized_size != size) {
+    return false;
+  }
+  return DeserializeVariant(serialized, batch) && batch->is_map();
+}
+
+}  // namespace
+
+BatchStore::BatchStore(const std::string& path_prefix, size_t max_batches)
+    : path_prefix_(path_prefix),
+      max_batches_(max_batches > 0 ? max_batches : 1),
+      first_(0),
+      next_(0),
+      warned_full_(false) {
+  LoadIndex();
+}
+
+bool BatchStore::Push(const Variant& batch) {
+  std::vector<uint8_t> encoded;
+  if (!EncodeBatch(batch, &encoded)) {
+    LogError("Unable to encode a batch of analytics events.");
+    return false;
+  }
+  if (size() >= max_batches_) {
+    if (!warned_full_) {
+      LogWarning("Too many analytics events waiting to be uploaded, dropping "
+                 "the oldest ones.");
+      warned_full_ = true;
+    }
+    Pop();
+  } else {
+    warned_full_ = false;
+  }
+  if (!WriteFile(BatchPath(next_), encoded.data(), encoded.size())) {
+    return false;
+  }
+  ++next_;
+  SaveIndex();
+  return true;
+}
+
+bool BatchStore::Front(Variant* batch) {
+  std::string encoded;
+  while (first_ < next_) {
+    std::string path = BatchPath(first_);
+    if (ReadFile(path, &encoded) && DecodeBatch(encoded, batch)) return true;
+    LogWarning("Dropping unreadable analytics events in '%s'.", path.c_str());
+    Pop();
+  }
+  return false;
+}
+
+void BatchStore::Pop() {
+  if (first_ == next_) return;
+  std::remove(BatchPath(first_).c_str());
+  ++first_;
+  SaveIndex();
+}
+
+void BatchStore::Clear() {
+  for (; first_ < next_; ++first_) std::remove(BatchPath(first_).c_str());
+  SaveIndex();
+}
+
+std::string BatchStore::BatchPath(uint64_t position) const {
+  return path_prefix_ + "batch-" + std::to_string(position);
+}
+
+std::string BatchStore::IndexPath() const { return path_prefix_ + "index"; }
+
+void BatchStore::LoadIndex() {
+  std::string index;
+  if (ReadFile(IndexPath(), &index)) {
+    unsigned long long first = 0, next = 0;  // NOLINT
+    if (sscanf(index.c_str(), "%llu %llu", &first, &next) == 2 &&
+        first <= next) {
+      first_ = first;
+      next_ = next;
+    }
+  }
+  // Pick up batches written after the index was last saved.
+  while (FileExists(BatchPath(next_))) ++next_;
+}
+
+void BatchStore::SaveIndex() const {
+  std::string index = std::to_string(first_) + " " + std::to_string(next_);
+  WriteFile(IndexPath(), index.data(), index.size());
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
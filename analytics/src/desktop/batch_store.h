@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_ANALYTICS_SRC_DESKTOP_BATCH_STORE_H_
+#define FIREBASE_ANALYTICS_SRC_DESKTOP_BATCH_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "firebase/variant.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+// Queue of event batches on disk, which keeps batches that have not been
+// uploaded yet across restarts.
+//
+// Each batch is serialized, compressed and written to a file of its own,
+// named after its position in the queue. A small index file records the
+// oldest and next positions, so nothing has to list the directory.
+//
+// Not thread-safe: the event logger only uses it from its worker thread.
+class BatchStore {
+ public:
+  // Stores the queue in files whose paths start with `path_prefix`, keeping
+  // at most `max_batches` batches. Loads a queue stored there earlier.
+  BatchStore(const std::string& path_prefix, size_t max_batches);
+
+  BatchStore(const BatchStore&) = delete;
+  BatchStore& operator=(const BatchStore&) = delete;
+
+  // Adds a batch at the end of the queue, dropping the oldest batch if the
+  // queue is full. Returns false if the batch could not be written.
+  bool Push(const Variant& batch);
+
+  // Reads the oldest batch into `batch`. Batches that can no longer be read
+  // are dropped. Returns false if the queue is empty.
+  bool Front(Variant* batch);
+
+  // Removes the oldest batch.
+  void Pop();
+
+  // Removes every batch.
+  void Clear();
+
+  size_t size() const { return static_cast<size_t>(next_ - first_); }
+
+ private:
+  std::string BatchPath(uint64_t position) const;
+  std::string IndexPath() const;
+
+  void LoadIndex();
+  void SaveIndex() const;
+
+  std::string path_prefix_;
+  size_t max_batches_;
+  // Position of the oldest batch.
+  uint64_t first_;
+  // Position the next batch is written to.
+  uint64_t next_;
+  // Whether dropping batches was logged since the store was last not full.
+  bool warned_full_;
+};
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
+
+#endif  // FIREBASE_ANALYTICS_SRC_DESKTOP_BATCH_STORE_H_
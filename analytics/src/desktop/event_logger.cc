@@ -0,0 +1,525 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/desktop/event_logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "analytics/src/analytics_common.h"
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_builder.h"
+#include "app/rest/transport_curl.h"
+#include "app/rest/transport_interface.h"
+#include "app/rest/util.h"
+#include "app/src/callback.h"
+#include "app/src/filesystem.h"
+#include "app/src/log.h"
+#include "app/src/time.h"
+#include "app/src/uuid.h"
+#include "app/src/variant_util.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+namespace {
+
+const char kAnalyticsDir[] = "firebase-analytics";
+const char kAppInstanceIdFilename[] = "app_instance_id";
+
+// Symbols that might not be allowed in filenames.
+const char kFilenameSymbols[] = "/\\?%*:|\"<>.,;=";
+
+// Keys of the Measurement Protocol request body, which is also how batches
+// are stored.
+const char kAppInstanceIdKey[] = "app_instance_id";
+const char kUserIdKey[] = "user_id";
+const char kUserPropertiesKey[] = "user_properties";
+const char kEventsKey[] = "events";
+const char kNameKey[] = "name";
+const char kParamsKey[] = "params";
+const char kTimestampMicrosKey[] = "timestamp_micros";
+const char kValueKey[] = "value";
+const char kSessionIdParameter[] = "session_id";
+
+const int64_t kDefaultSessionTimeoutInMilliseconds =
+    30 * firebase::internal::kMillisecondsPerMinute;
+
+// Batches uploaded in one go before the scheduler gets to run other work.
+const int kMaxUploadsPerRun = 10;
+
+std::string GetDefaultPathPrefix(const App& app) {
+  std::string error;
+  std::string dir = AppDataDir(kAnalyticsDir, /*should_create=*/true, &error);
+  if (!error.empty()) {
+    LogError("Unable to find a directory for analytics: %s", error.c_str());
+    return "";
+  }
+  std::string name = app.options().app_id();
+  std::string name_without_symbols;
+  name_without_symbols.reserve(name.size());
+  for (char c : name) {
+    if (strchr(kFilenameSymbols, c) == nullptr) name_without_symbols += c;
+  }
+  return dir + "/" + name_without_symbols + "-";
+}
+
+EventLoggerSettings ApplyDefaults(const App& app,
+                                  EventLoggerSettings settings) {
+  if (settings.path_prefix.empty()) {
+    settings.path_prefix = GetDefaultPathPrefix(app);
+  }
+  if (settings.api_secret.empty()) {
+    const char* api_secret = getenv(kApiSecretEnvironmentVariable);
+    if (api_secret) settings.api_secret = api_secret;
+  }
+  if (settings.max_batch_size == 0) settings.max_batch_size = 1;
+  return settings;
+}
+
+// Generates an app instance ID: 16 random bytes as 32 hex digits, the form
+// the Measurement Protocol expects.
+std::string GenerateAppInstanceId() {
+  firebase::internal::Uuid uuid;
+  uuid.Generate();
+  std::string id;
+  id.reserve(sizeof(uuid.data) * 2);
+  char hex[3];
+  for (uint8_t byte : uuid.data) {
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    id += hex;
+  }
+  return id;
+}
+
+// Loads the app instance ID stored at `path`, or generates and stores a new
+// one.
+std::string LoadAppInstanceId(const std::string& path, bool generate_new) {
+  if (!generate_new) {
+    std::ifstream file(path, std::ios_base::binary);
+    std::string id((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+    if (!id.empty()) return id;
+  }
+  std::string id = GenerateAppInstanceId();
+  std::ofstream file(path, std::ios_base::trunc | std::ios_base::binary);
+  file.write(id.data(), id.size());
+  if (file.fail()) {
+    LogError("Unable to save the analytics app instance ID in '%s'.",
+             path.c_str());
+  }
+  return id;
+}
+
+// Copies a parameter value, including the strings and blobs it only points
+// to, as the event outlives the caller's buffers.
+Variant CopyParameterValue(const Variant& value) {
+  if (value.is_static_string()) {
+    Variant copy(value);
+    copy.mutable_string();
+    return copy;
+  }
+  if (value.is_static_blob()) {
+    return Variant::FromMutableBlob(value.blob_data(), value.blob_size());
+  }
+  if (value.is_vector()) {
+    Variant copy = Variant::EmptyVector();
+    copy.vector().reserve(value.vector().size());
+    for (const Variant& item : value.vector()) {
+      copy.vector().push_back(CopyParameterValue(item));
+    }
+    return copy;
+  }
+  if (value.is_map()) {
+    Variant copy = Variant::EmptyMap();
+    for (const auto& entry : value.map()) {
+      // Batches can only be stored with string keys.
+      if (!entry.first.is_string()) {
+        LogWarning("Dropping a parameter map entry with a %s key.",
+                   Variant::TypeName(entry.first.type()));
+        continue;
+      }
+      copy.map()[CopyParameterValue(entry.first)] =
+          CopyParameterValue(entry.second);
+    }
+    return copy;
+  }
+  return value;
+}
+
+// Decodes parameters encoded by an EventSchema into a map of parameter names
+// to values.
+Variant DecodeParameters(const std::string& encoded) {
+  Variant parameters = Variant::EmptyMap();
+  EncodedParameterReader reader(
+      reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size());
+  while (reader.Next()) {
+    Variant& value = parameters.map()[std::string(reader.name())];
+    switch (reader.type()) {
+      case kEncodedParameterInt64:
+        value = reader.int64_value();
+        break;
+      case kEncodedParameterDouble:
+        value = reader.double_value();
+        break;
+      case kEncodedParameterString:
+        value = std::string(reader.string_value());
+        break;
+    }
+  }
+  return parameters;
+}
+
+// Whether an upload that failed with `status` may succeed later.
+bool IsRetryable(int status) {
+  return status == 0 || status == 408 || status == 429 || status >= 500;
+}
+
+}  // namespace
+
+EventLogger::EventLogger(const App& app, const EventLoggerSettings& settings)
+    : app_(app),
+      settings_(ApplyDefaults(app, settings)),
+      collection_enabled_(true),
+      storage_granted_(true),
+      session_timeout_ms_(kDefaultSessionTimeoutInMilliseconds),
+      flush_scheduled_(false),
+      store_(settings_.path_prefix, settings_.max_stored_batches),
+      user_properties_(Variant::EmptyMap()),
+      open_batch_(Variant::EmptyVector()),
+      session_id_(0),
+      last_event_ms_(0),
+      retry_delay_ms_(0),
+      retry_scheduled_(false),
+      warned_missing_api_secret_(false),
+      safe_this_(this) {
+  rest::InitTransportCurl();
+  app_instance_id_ =
+      LoadAppInstanceId(settings_.path_prefix + kAppInstanceIdFilename,
+                        /*generate_new=*/false);
+  // Upload what is left from the last run.
+  ScheduleWriteEvents(0, /*write_partial_batch=*/false);
+}
+
+EventLogger::~EventLogger() {
+  // Waits for a running upload to finish.
+  safe_this_.ClearReference();
+  scheduler_.CancelAllAndShutdownWorkerThread();
+  // Nothing runs on the scheduler anymore.
+  TakeEvents();
+  CloseBatch();
+  rest::CleanupTransportCurl();
+}
+
+void EventLogger::SetCollectionEnabled(bool enabled) {
+  collection_enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void EventLogger::SetAnalyticsStorageGranted(bool granted) {
+  storage_granted_.store(granted, std::memory_order_relaxed);
+}
+
+void EventLogger::LogEvent(const char* name, const Parameter* parameters,
+                           size_t number_of_parameters) {
+  if (!IsCollecting()) return;
+  PendingEvent* event = new PendingEvent();
+  event->name = name;
+  event->parameters = Variant::EmptyMap();
+  for (size_t i = 0; i < number_of_parameters; ++i) {
+    const Parameter& parameter = parameters[i];
+    event->parameters.map()[Variant(std::string(parameter.name))] =
+        CopyParameterValue(parameter.value);
+  }
+  PushEvent(event);
+}
+
+void EventLogger::LogEncodedEvent(const char* name, const uint8_t* parameters,
+                                  size_t size) {
+  if (!IsCollecting()) return;
+  PendingEvent* event = new PendingEvent();
+  event->name = name;
+  event->encoded_parameters.assign(reinterpret_cast<const char*>(parameters),
+                                   size);
+  PushEvent(event);
+}
+
+bool EventLogger::IsCollecting() const {
+  return collection_enabled_.load(std::memory_order_relaxed) &&
+         storage_granted_.load(std::memory_order_relaxed);
+}
+
+void EventLogger::PushEvent(PendingEvent* event) {
+  event->timestamp_ms =
+      static_cast<int64_t>(firebase::internal::GetTimestampEpoch());
+
+  size_t size = queue_.Push(event);
+  // At most one timed flush is pending, and it takes every event logged
+  // until it runs. Loading first keeps the common case free of writes to the
+  // shared flag.
+  if (!flush_scheduled_.load(std::memory_order_relaxed) &&
+      !flush_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+    scheduler_.Schedule(
+        callback::NewCallback(
+            [](ThisRef ref) {
+              ThisRefLock lock(&ref);
+              EventLogger* logger = lock.GetReference();
+              if (logger == nullptr) return;
+              logger->flush_scheduled_.store(false, std::memory_order_release);
+              logger->WriteEvents(/*write_partial_batch=*/true);
+            },
+            safe_this_),
+        static_cast<scheduler::ScheduleTimeMs>(settings_.flush_interval_ms));
+  }
+  if (size % settings_.max_batch_size == 0) {
+    ScheduleWriteEvents(0, /*write_partial_batch=*/false);
+  }
+}
+
+void EventLogger::SetUserProperty(const char* name, const char* value) {
+  PendingEvent* change = new PendingEvent();
+  change->type = PendingEvent::kUserProperty;
+  change->name = name;
+  if (value) change->parameters = std::string(value);
+  queue_.Push(change);
+}
+
+void EventLogger::SetUserId(const char* user_id) {
+  PendingEvent* change = new PendingEvent();
+  change->type = PendingEvent::kUserId;
+  if (user_id) change->parameters = std::string(user_id);
+  queue_.Push(change);
+}
+
+void EventLogger::SetSessionTimeoutDuration(int64_t milliseconds) {
+  session_timeout_ms_.store(milliseconds, std::memory_order_relaxed);
+}
+
+void EventLogger::ResetAnalyticsData() {
+  PendingEvent* reset = new PendingEvent();
+  reset->type = PendingEvent::kReset;
+  queue_.Push(reset);
+}
+
+void EventLogger::GetAppInstanceId(
+    ReferenceCountedFutureImpl* api,
+    const SafeFutureHandle<std::string>& handle) {
+  scheduler_.Schedule(callback::NewCallback(
+      [](ThisRef ref, ReferenceCountedFutureImpl* api,
+         SafeFutureHandle<std::string> handle) {
+        ThisRefLock lock(&ref);
+        EventLogger* logger = lock.GetReference();
+        if (logger == nullptr) return;
+        logger->TakeEvents();
+        api->CompleteWithResult(handle, 0, "", logger->app_instance_id_);
+      },
+      safe_this_, api, handle));
+}
+
+void EventLogger::Flush(Semaphore* flushed) {
+  scheduler_.Schedule(callback::NewCallback(
+      [](ThisRef ref, Semaphore* flushed) {
+        {
+          ThisRefLock lock(&ref);
+          EventLogger* logger = lock.GetReference();
+          if (logger != nullptr) {
+            logger->WriteEvents(/*write_partial_batch=*/true);
+          }
+        }
+        if (flushed) flushed->Post();
+      },
+      safe_this_, flushed));
+}
+
+void EventLogger::ScheduleWriteEvents(int64_t delay_ms,
+                                      bool write_partial_batch) {
+  scheduler_.Schedule(
+      callback::NewCallback(
+          [](ThisRef ref, bool write_partial_batch) {
+            ThisRefLock lock(&ref);
+            EventLogger* logger = lock.GetReference();
+            if (logger != nullptr) logger->WriteEvents(write_partial_batch);
+          },
+          safe_this_, write_partial_batch),
+      static_cast<scheduler::ScheduleTimeMs>(delay_ms));
+}
+
+void EventLogger::WriteEvents(bool write_partial_batch) {
+  TakeEvents();
+  if (write_partial_batch) CloseBatch();
+  Upload();
+}
+
+void EventLogger::TakeEvents() {
+  PendingEvent* events = queue_.TakeAll();
+  int64_t session_timeout_ms =
+      session_timeout_ms_.load(std::memory_order_relaxed);
+  for (PendingEvent* event = events; event; event = event->next) {
+    if (event->type != PendingEvent::kEvent) {
+      ApplyChange(event);
+      continue;
+    }
+    if (session_id_ == 0 ||
+        event->timestamp_ms - last_event_ms_ > session_timeout_ms) {
+      session_id_ =
+          event->timestamp_ms / firebase::internal::kMillisecondsPerSecond;
+    }
+    last_event_ms_ = event->timestamp_ms;
+    if (event->parameters.is_null()) {
+      event->parameters = DecodeParameters(event->encoded_parameters);
+    }
+    event->parameters.map()[kSessionIdParameter] = session_id_;
+
+    Variant entry = Variant::EmptyMap();
+    entry.map()[kNameKey] = event->name;
+    entry.map()[kParamsKey] = std::move(event->parameters);
+    entry.map()[kTimestampMicrosKey] = event->timestamp_ms * 1000;
+    open_batch_.vector().push_back(std::move(entry));
+    if (open_batch_.vector().size() >= settings_.max_batch_size) CloseBatch();
+  }
+  DeleteEvents(events);
+}
+
+void EventLogger::ApplyChange(PendingEvent* change) {
+  if (change->type == PendingEvent::kReset) {
+    open_batch_ = Variant::EmptyVector();
+    store_.Clear();
+    user_id_.clear();
+    user_properties_ = Variant::EmptyMap();
+    session_id_ = 0;
+    app_instance_id_ =
+        LoadAppInstanceId(settings_.path_prefix + kAppInstanceIdFilename,
+                          /*generate_new=*/true);
+    return;
+  }
+  // Events logged before the change keep the old value.
+  CloseBatch();
+  if (change->type == PendingEvent::kUserId) {
+    user_id_ = change->parameters.is_null()
+                   ? std::string()
+                   : change->parameters.string_value();
+  } else if (change->parameters.is_null()) {
+    user_properties_.map().erase(Variant(change->name));
+  } else {
+    Variant property = Variant::EmptyMap();
+    property.map()[kValueKey] = std::move(change->parameters);
+    user_properties_.map()[change->name] = property;
+  }
+}
+
+void EventLogger::CloseBatch() {
+  if (open_batch_.vector().empty()) return;
+  Variant batch = Variant::EmptyMap();
+  batch.map()[kAppInstanceIdKey] = app_instance_id_;
+  if (!user_id_.empty()) batch.map()[kUserIdKey] = user_id_;
+  if (!user_properties_.map().empty()) {
+    batch.map()[kUserPropertiesKey] = user_properties_;
+  }
+  batch.map()[kEventsKey] = std::move(open_batch_);
+  open_batch_ = Variant::EmptyVector();
+  store_.Push(batch);
+}
+
+void EventLogger::Upload() {
+  if (retry_scheduled_) return;
+  if (settings_.upload_url.empty() && settings_.api_secret.empty()) {
+    if (!warned_missing_api_secret_) {
+      warned_missing_api_secret_ = true;
+      LogWarning(
+          "Analytics events are kept on disk but not uploaded, as %s is not "
+          "set.",
+          kApiSecretEnvironmentVariable);
+    }
+    return;
+  }
+  Variant batch;
+  for (int i = 0; i < kMaxUploadsPerRun; ++i) {
+    if (!store_.Front(&batch)) return;
+    if (!UploadOldestBatch(batch)) {
+      ScheduleRetry();
+      return;
+    }
+  }
+  // Let other work run before uploading the rest.
+  if (store_.size() > 0) ScheduleWriteEvents(0, /*write_partial_batch=*/false);
+}
+
+bool EventLogger::UploadOldestBatch(const Variant& batch) {
+  rest::Request request;
+  request.set_url(GetUploadURL().c_str());
+  request.set_method(rest::util::kPost);
+  request.add_header(rest::util::kContentType, rest::util::kApplicationJson);
+  request.options().timeout_ms = kUploadTimeoutInMilliseconds;
+  std::string body = util::VariantToJson(batch);
+  request.set_post_fields(body.c_str(), body.size());
+
+  rest::Response response;
+  rest::CreateTransport()->Perform(request, &response);
+  int status = response.status();
+  if (status >= 200 && status < 300) {
+    retry_delay_ms_ = 0;
+  } else if (IsRetryable(status)) {
+    LogDebug("Failed to upload analytics events: http code %d", status);
+    return false;
+  } else {
+    LogWarning("Dropping analytics events the server rejected: http code %d",
+               status);
+  }
+  store_.Pop();
+  return true;
+}
+
+void EventLogger::ScheduleRetry() {
+  retry_delay_ms_ =
+      retry_delay_ms_ == 0
+          ? settings_.initial_retry_delay_ms
+          : std::min(retry_delay_ms_ * 2, settings_.max_retry_delay_ms);
+  retry_scheduled_ = true;
+  scheduler_.Schedule(
+      callback::NewCallback(
+          [](ThisRef ref) {
+            ThisRefLock lock(&ref);
+            EventLogger* logger = lock.GetReference();
+            if (logger == nullptr) return;
+            logger->retry_scheduled_ = false;
+            logger->Upload();
+          },
+          safe_this_),
+      static_cast<scheduler::ScheduleTimeMs>(retry_delay_ms_));
+}
+
+std::string EventLogger::GetUploadURL() const {
+  std::string url = settings_.upload_url.empty() ? kMeasurementProtocolURL
+                                                 : settings_.upload_url;
+  url += "?firebase_app_id=";
+  url += app_.options().app_id();
+  if (!settings_.api_secret.empty()) {
+    url += "&api_secret=";
+    url += settings_.api_secret;
+  }
+  return url;
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_ANALYTICS_SRC_DESKTOP_EVENT_LOGGER_H_
+#define FIREBASE_ANALYTICS_SRC_DESKTOP_EVENT_LOGGER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "analytics/src/desktop/batch_store.h"
+#include "analytics/src/desktop/event_queue.h"
+#include "analytics/src/include/firebase/analytics.h"
+#include "app/src/reference_counted_future_impl.h"
+#include "app/src/safe_reference.h"
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "firebase/app.h"
+#include "firebase/variant.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+// Batches are uploaded with the Google Analytics Measurement Protocol.
+const char* const kMeasurementProtocolURL =
+    "https://www.google-analytics.com/mp/collect";
+
+// The Measurement Protocol needs an API secret, which is not part of the app
+// options. It is read from this environment variable.
+const char* const kApiSecretEnvironmentVariable =
+    "FIREBASE_ANALYTICS_API_SECRET";
+
+const int kUploadTimeoutInMilliseconds = 30 * 1000;
+
+// Configures an EventLogger. The defaults suit apps; tests and benchmarks
+// change them.
+struct EventLoggerSettings {
+  EventLoggerSettings()
+      : max_batch_size(25),
+        flush_interval_ms(10 * 1000),
+        max_stored_batches(1000),
+        initial_retry_delay_ms(1000),
+        max_retry_delay_ms(5 * 60 * 1000) {}
+
+  // Where batches are uploaded. Empty to use kMeasurementProtocolURL.
+  std::string upload_url;
+  // API secret sent with every upload. Batches for kMeasurementProtocolURL
+  // stay on disk until there is one.
+  std::string api_secret;
+  // Prefix of the paths of the files the logger keeps. Empty to use the app
+  // data directory.
+  std::string path_prefix;
+  // Number of events in a full batch. The Measurement Protocol accepts up to
+  // 25 events per request.
+  size_t max_batch_size;
+  // Longest time a logged event waits before it is written to disk, even if
+  // its batch is not full.
+  int64_t flush_interval_ms;
+  // Number of batches kept on disk before the oldest are dropped.
+  size_t max_stored_batches;
+  // Delay before retrying a failed upload, doubled on each failure in a row
+  // up to max_retry_delay_ms.
+  int64_t initial_retry_delay_ms;
+  int64_t max_retry_delay_ms;
+};
+
+// Logs Analytics events on desktop.
+//
+// Logging an event only pushes it onto a lock-free queue, so callers never
+// wait on a lock, on the disk or on the network. A worker thread takes events
+// off the queue once a batch is full or flush_interval_ms after the queue
+// stopped being empty, and writes them in batches to a compressed queue on
+// disk. Batches are then uploaded oldest first, and removed once the server
+// accepted them. Failed uploads are retried with exponential backoff, and
+// batches left on disk are uploaded the next time the app runs.
+class EventLogger {
+ public:
+  EventLogger(const App& app, const EventLoggerSettings& settings);
+
+  // Writes events that were not written to disk yet, so they are uploaded
+  // the next time the app runs.
+  ~EventLogger();
+
+  EventLogger(const EventLogger&) = delete;
+  EventLogger& operator=(const EventLogger&) = delete;
+
+  // Events are dropped unless both collection and analytics storage are
+  // enabled.
+  void SetCollectionEnabled(bool enabled);
+  void SetAnalyticsStorageGranted(bool granted);
+
+  // Logs an event. Safe to call from any thread; does not block.
+  void LogEvent(const char* name, const Parameter* parameters,
+                size_t number_of_parameters);
+
+  // Logs an event with parameters encoded by an EventSchema. Only copies the
+  // encoded parameters; they are decoded on the scheduler.
+  void LogEncodedEvent(const char* name, const uint8_t* parameters,
+                       size_t size);
+
+  // Sets a user property, or removes it if value is null. Applies to events
+  // logged after this call.
+  void SetUserProperty(const char* name, const char* value);
+
+  // Sets the user ID, or removes it if user_id is null. Applies to events
+  // logged after this call.
+  void SetUserId(const char* user_id);
+
+  void SetSessionTimeoutDuration(int64_t milliseconds);
+
+  // Drops every event not uploaded yet, user properties and the user ID, and
+  // starts using a new app instance ID.
+  void ResetAnalyticsData();
+
+  // Completes `handle` with the app instance ID, once the calls made before
+  // this one have been applied.
+  void GetAppInstanceId(ReferenceCountedFutureImpl* api,
+                        const SafeFutureHandle<std::string>& handle);
+
+  // Writes every event logged so far to disk without waiting for its batch
+  // to fill, and starts uploading. Posts `flushed`, if given, once the events
+  // are written and an upload was attempted.
+  void Flush(Semaphore* flushed = nullptr);
+
+ private:
+  typedef firebase::internal::SafeReference<EventLogger> ThisRef;
+  typedef firebase::internal::SafeReferenceLock<EventLogger> ThisRefLock;
+
+  // Whether logged events are kept. Safe to call from any thread.
+  bool IsCollecting() const;
+
+  // Queues a logged event, and schedules writing it to disk. Safe to call
+  // from any thread.
+  void PushEvent(PendingEvent* event);
+
+  // The functions below run on the scheduler, unless noted otherwise.
+
+  // Schedules a call to WriteEvents().
+  void ScheduleWriteEvents(int64_t delay_ms, bool write_partial_batch);
+
+  // Moves the events in the queue into the open batch, closing every batch
+  // that fills up. Also closes the open batch if write_partial_batch is true.
+  // Then uploads closed batches.
+  void WriteEvents(bool write_partial_batch);
+
+  // Moves the events in the queue into the open batch, closing every batch
+  // that fills up, and applies queued changes.
+  void TakeEvents();
+
+  // Applies a queued change to the user ID, a user property, or a reset.
+  void ApplyChange(PendingEvent* change);
+
+  // Writes the open batch to the batch store, if it has any events.
+  void CloseBatch();
+
+  // Uploads stored batches, unless an upload is waiting to be retried.
+  void Upload();
+
+  // Uploads the oldest stored batch. Returns false if it should be retried
+  // later.
+  bool UploadOldestBatch(const Variant& batch);
+
+  // Schedules a retry of a failed upload, backing off on each failure.
+  void ScheduleRetry();
+
+  std::string GetUploadURL() const;
+
+  const App& app_;  // NOLINT
+  EventLoggerSettings settings_;
+
+  // Events logged but not yet taken by the scheduler.
+  EventQueue queue_;
+  std::atomic<bool> collection_enabled_;
+  std::atomic<bool> storage_granted_;
+  std::atomic<int64_t> session_timeout_ms_;
+  // Whether a flush of partial batches is scheduled.
+  std::atomic<bool> flush_scheduled_;
+
+  // Only used on the scheduler, or once the scheduler stopped.
+  BatchStore store_;
+  std::string app_instance_id_;
+  std::string user_id_;
+  // Maps user property names to their values.
+  Variant user_properties_;
+  // Events of the batch being filled.
+  Variant open_batch_;
+  // The current session started at session_id_ seconds since the epoch.
+  int64_t session_id_;
+  int64_t last_event_ms_;
+  // Delay before the next retry, 0 while uploads succeed.
+  int64_t retry_delay_ms_;
+  // Whether Upload() is scheduled to retry a failed upload.
+  bool retry_scheduled_;
+  bool warned_missing_api_secret_;
+
+  scheduler::Scheduler scheduler_;
+
+  ThisRef safe_this_;
+};
+
+// Initializes the Analytics API with a logger using the given settings rather
+// than the defaults, so that benchmarks can keep its files elsewhere and
+// upload to a stand-in. Defined in analytics_desktop.cc.
+void Initialize(const App& app, const EventLoggerSettings& settings);
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
+
+#endif  // FIREBASE_ANALYTICS_SRC_DESKTOP_EVENT_LOGGER_H_
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/desktop/event_queue.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+EventQueue::~EventQueue() { DeleteEvents(TakeAll()); }
+
+size_t EventQueue::Push(PendingEvent* event) {
+  size_t size = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+  event->next = head_.load(std::memory_order_relaxed);
+  while (!head_.compare_exchange_weak(event->next, event,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+  }
+  return size;
+}
+
+PendingEvent* EventQueue::TakeAll() {
+  PendingEvent* newest = head_.exchange(nullptr, std::memory_order_acquire);
+  // The stack is newest first, reverse it.
+  PendingEvent* oldest = nullptr;
+  size_t count = 0;
+  while (newest) {
+    PendingEvent* next = newest->next;
+    newest->next = oldest;
+    oldest = newest;
+    newest = next;
+    ++count;
+  }
+  size_.fetch_sub(count, std::memory_order_relaxed);
+  return oldest;
+}
+
+void DeleteEvents(PendingEvent* events) {
+  while (events) {
+    PendingEvent* next = events->next;
+    delete events;
+    events = next;
+  }
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_ANALYTICS_SRC_DESKTOP_EVENT_QUEUE_H_
+#define FIREBASE_ANALYTICS_SRC_DESKTOP_EVENT_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "firebase/variant.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+// An event that was logged but not added to a batch yet.
+//
+// Changes to the user ID, user properties and resets are queued alongside
+// events, so that they apply to exactly the events logged after them.
+struct PendingEvent {
+  enum Type {
+    kEvent,
+    // Sets the user ID to `parameters`, or removes it if that is null.
+    kUserId,
+    // Sets the user property `name` to `parameters`, or removes it if that is
+    // null.
+    kUserProperty,
+    // Drops the events before it, and everything known about the user.
+    kReset,
+  };
+
+  PendingEvent() : type(kEvent), timestamp_ms(0), next(nullptr) {}
+
+  Type type;
+  std::string name;
+  // Map of parameter names to values.
+  Variant parameters;
+  // Parameters encoded by an EventSchema, decoded into `parameters` once the
+  // event is taken off the queue.
+  std::string encoded_parameters;
+  // When the event was logged, in milliseconds since the epoch.
+  int64_t timestamp_ms;
+  // Links the events in an EventQueue.
+  PendingEvent* next;
+};
+
+// Queue of events with many producers and a single consumer, where producers
+// never wait for each other or for the consumer.
+//
+// Producers push onto a lock-free stack. The consumer takes the whole stack at
+// once, which is a single atomic exchange, and gets the events back in the
+// order they were pushed.
+class EventQueue {
+ public:
+  EventQueue() : head_(nullptr), size_(0) {}
+  ~EventQueue();
+
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+
+  // Adds an event to the queue, taking ownership of it. Returns the number of
+  // events in the queue including this one, which callers use to decide when
+  // the consumer should run. Safe to call from any thread.
+  size_t Push(PendingEvent* event);
+
+  // Removes every event from the queue and returns them as a list linked by
+  // PendingEvent::next, oldest first, or nullptr if the queue is empty. The
+  // caller owns the events. Only one thread may take events at a time.
+  PendingEvent* TakeAll();
+
+  // Number of events in the queue. Events being pushed concurrently may
+  // already be counted.
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  // Most recently pushed event.
+  std::atomic<PendingEvent*> head_;
+  // Counted before the event is linked in, so that TakeAll() never removes
+  // more than has been counted.
+  std::atomic<size_t> size_;
+};
+
+// Deletes a list of events returned by EventQueue::TakeAll().
+void DeleteEvents(PendingEvent* events);
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
+
+#endif  // FIREBASE_ANALYTICS_SRC_DESKTOP_EVENT_QUEUE_H_
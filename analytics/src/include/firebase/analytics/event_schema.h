@@ -0,0 +1,207 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_ANALYTICS_SRC_INCLUDE_FIREBASE_ANALYTICS_EVENT_SCHEMA_H_
+#define FIREBASE_ANALYTICS_SRC_INCLUDE_FIREBASE_ANALYTICS_EVENT_SCHEMA_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "firebase/analytics.h"
+
+namespace firebase {
+namespace analytics {
+
+/// @cond FIREBASE_APP_INTERNAL
+namespace internal {
+
+// Types of the parameters encoded by an EventSchema.
+enum EncodedParameterType {
+  kEncodedParameterInt64 = 1,
+  kEncodedParameterDouble = 2,
+  kEncodedParameterString = 3,
+};
+
+// Encoded parameters up to this size are built on the stack.
+const size_t kEncodedParametersInlineSize = 256;
+
+// Encodes the values of one parameter type. Each parameter is encoded as its
+// EncodedParameterType in one byte, its null-terminated name, then its value:
+// 8 bytes in native byte order for numbers, or the null-terminated string.
+template <typename T>
+struct ParameterEncoding {
+  static_assert(sizeof(T) == 0,
+                "EventSchema parameters must be int64_t, double or "
+                "const char*.");
+};
+
+template <>
+struct ParameterEncoding<int64_t> {
+  static const uint8_t kType = kEncodedParameterInt64;
+  static size_t Size(int64_t) { return sizeof(int64_t); }
+  static uint8_t* Write(int64_t value, uint8_t* out) {
+    memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+  }
+};
+
+template <>
+struct ParameterEncoding<double> {
+  static const uint8_t kType = kEncodedParameterDouble;
+  static size_t Size(double) { return sizeof(double); }
+  static uint8_t* Write(double value, uint8_t* out) {
+    memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+  }
+};
+
+template <>
+struct ParameterEncoding<const char*> {
+  static const uint8_t kType = kEncodedParameterString;
+  static size_t Size(const char* value) {
+    return (value ? strlen(value) : 0) + 1;
+  }
+  static uint8_t* Write(const char* value, uint8_t* out) {
+    size_t size = Size(value);
+    memcpy(out, value ? value : "", size);
+    return out + size;
+  }
+};
+
+// Keeps T out of template argument deduction, so that arguments are
+// converted to the types of the schema.
+template <typename T>
+struct NonDeduced {
+  typedef T type;
+};
+
+// Logs an event whose parameters were encoded by an EventSchema. Implemented
+// per platform.
+void LogEncodedEvent(const char* name, const uint8_t* parameters,
+                     size_t size);
+
+}  // namespace internal
+/// @endcond
+
+/// @brief The name and parameter types of an event, fixed at compile time.
+///
+/// Logging an event through a schema encodes its parameters into one compact
+/// buffer, without building a Parameter and a Variant for each one, which
+/// suits events logged at a high rate such as gameplay events. Each of
+/// `Types` is the type of one parameter, and must be `int64_t`, `double` or
+/// `const char*`.
+///
+/// Create a schema once, then log events with it:
+/// @code
+/// static const analytics::EventSchema<int64_t, double, const char*>
+///     kLevelUp(analytics::kEventLevelUp, analytics::kParameterLevel,
+///              analytics::kParameterScore, analytics::kParameterCharacter);
+///
+/// analytics::LogEvent(kLevelUp, 42, 1234.5, "mysterion");
+/// @endcode
+template <typename... Types>
+class EventSchema {
+ public:
+  /// @brief Creates a schema for events with the given names.
+  ///
+  /// @param[in] name Name of the event (see @ref LogEvent). Must outlive the
+  /// schema.
+  /// @param[in] parameter_names Name of each parameter (see Parameter::name),
+  /// in the order of `Types`. Must outlive the schema.
+  template <typename... Names>
+  explicit EventSchema(const char* name, Names... parameter_names)
+      : name_(name),
+        parameter_names_{{parameter_names...}},
+        fixed_size_(0) {
+    static_assert(sizeof...(Names) == sizeof...(Types),
+                  "EventSchema needs one name per parameter type.");
+    for (size_t i = 0; i < sizeof...(Types); ++i) {
+      parameter_name_sizes_[i] = strlen(parameter_names_[i]) + 1;
+      // The type of the parameter, and its name.
+      fixed_size_ += 1 + parameter_name_sizes_[i];
+    }
+  }
+
+  /// @brief Name of the events.
+  const char* name() const { return name_; }
+
+  /// @cond FIREBASE_APP_INTERNAL
+  // Size of the parameters encoded by Encode().
+  size_t EncodedSize(Types... values) const {
+    size_t value_sizes[] = {
+        0, internal::ParameterEncoding<Types>::Size(values)...};
+    size_t size = fixed_size_;
+    for (size_t value_size : value_sizes) size += value_size;
+    return size;
+  }
+
+  // Encodes the parameters into `out`, which must hold EncodedSize() bytes.
+  void Encode(uint8_t* out, Types... values) const {
+    size_t index = 0;
+    // Initializers are evaluated in order, so parameters are too.
+    uint8_t* unused[] = {out,
+                         (out = EncodeParameter(out, index++, values))...};
+    (void)unused;
+    (void)index;
+  }
+  /// @endcond
+
+ private:
+  template <typename T>
+  uint8_t* EncodeParameter(uint8_t* out, size_t index, T value) const {
+    *out++ = internal::ParameterEncoding<T>::kType;
+    memcpy(out, parameter_names_[index], parameter_name_sizes_[index]);
+    return internal::ParameterEncoding<T>::Write(
+        value, out + parameter_name_sizes_[index]);
+  }
+
+  const char* name_;
+  std::array<const char*, sizeof...(Types)> parameter_names_;
+  // Sizes of the parameter names, including their terminators.
+  std::array<size_t, sizeof...(Types)> parameter_name_sizes_;
+  // Size of the encoded parameters, not counting their values.
+  size_t fixed_size_;
+};
+
+/// @brief Log an event described by an EventSchema.
+///
+/// Equivalent to LogEvent(const char*, const Parameter*, size_t) with one
+/// Parameter per value, but cheaper for the caller.
+///
+/// @param[in] event Schema of the event.
+/// @param[in] values Value of each parameter of the schema, in order.
+template <typename... Types>
+void LogEvent(const EventSchema<Types...>& event,
+              typename internal::NonDeduced<Types>::type... values) {
+  size_t size = event.EncodedSize(values...);
+  uint8_t inline_buffer[internal::kEncodedParametersInlineSize];
+  std::vector<uint8_t> heap_buffer;
+  uint8_t* buffer = inline_buffer;
+  if (size > sizeof(inline_buffer)) {
+    heap_buffer.resize(size);
+    buffer = &heap_buffer[0];
+  }
+  event.Encode(buffer, values...);
+  internal::LogEncodedEvent(event.name(), buffer, size);
+}
+
+}  // namespace analytics
+}  // namespace firebase
+
+#endif  // FIREBASE_ANALYTICS_SRC_INCLUDE_FIREBASE_ANALYTICS_EVENT_SCHEMA_H_
@@ -23,6 +23,7 @@
 
 #include "analytics/src/analytics_common.h"
 #include "analytics/src/include/firebase/analytics.h"
+#include "analytics/src/include/firebase/analytics/event_schema.h"
 #include "app/src/include/firebase/app.h"
 #include "app/src/time.h"
 #include "app/tests/include/firebase/app_for_testing.h"
@@ -222,6 +223,22 @@ TEST_F(AnalyticsTest, TestLogEventParameters) {
   LogEvent("my_event", parameters, sizeof(parameters) / sizeof(parameters[0]));
 }
 
+TEST_F(AnalyticsTest, TestLogEventWithSchema) {
+  // Params are sorted alphabetically by mock.
+  AddExpectationAndroid("FirebaseAnalytics.logEvent",
+                        {"my_event",
+                         "my_param_double=1.01,my_param_int=101,"
+                         "my_param_string=my_value"});
+  AddExpectationApple("+[FIRAnalytics logEventWithName:parameters:]",
+                      {"my_event",
+                       "my_param_double=1.01,my_param_int=101,"
+                       "my_param_string=my_value"});
+
+  EventSchema<const char*, double, int64_t> schema(
+      "my_event", "my_param_string", "my_param_double", "my_param_int");
+  LogEvent(schema, "my_value", 1.01, 101);
+}
+
 TEST_F(AnalyticsTest,
        TestInitiateOnDeviceConversionMeasurementWithEmailAddress) {
   // InitiateOnDeviceConversionMeasurementWithEmailAddress is no-op on Android
@@ -283,7 +300,12 @@ TEST_F(AnalyticsTest, TestGetAnalyticsInstanceId) {
   // Wait for up to a second to fetch the ID.
   WaitForFutureWithTimeout(result, 1000, firebase::kFutureStatusComplete);
   EXPECT_EQ(firebase::kFutureStatusComplete, result.status());
+#if FIREBASE_PLATFORM_DESKTOP
+  // Desktop generates a real ID: 32 hex digits.
+  EXPECT_EQ(32, result.result()->size());
+#else
   EXPECT_EQ(std::string("FakeAnalyticsInstanceId0"), *result.result());
+#endif  // FIREBASE_PLATFORM_DESKTOP
 }
 
 }  // namespace analytics
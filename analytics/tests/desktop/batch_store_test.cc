@@ -0,0 +1,159 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/desktop/batch_store.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "firebase/variant.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+class BatchStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_prefix_ =
+        ::testing::TempDir() + "analytics-batch-store-" +
+        ::testing::UnitTest::GetInstance()->current_test_info()->name() + "-";
+    RemoveFiles();
+  }
+
+  void TearDown() override { RemoveFiles(); }
+
+  void RemoveFiles() {
+    std::remove((path_prefix_ + "index").c_str());
+    for (int i = 0; i < 10; ++i) {
+      std::remove((path_prefix_ + "batch-" + std::to_string(i)).c_str());
+    }
+  }
+
+  static Variant MakeBatch(int number) {
+    Variant batch = Variant::EmptyMap();
+    batch.map()["number"] = number;
+    batch.map()["events"] = std::vector<Variant>(
+        {Variant("an event"), Variant(std::string(1000, 'x'))});
+    return batch;
+  }
+
+  std::string path_prefix_;
+};
+
+TEST_F(BatchStoreTest, ReturnsBatchesOldestFirst) {
+  BatchStore store(path_prefix_, 10);
+  Variant batch;
+  EXPECT_FALSE(store.Front(&batch));
+
+  EXPECT_TRUE(store.Push(MakeBatch(1)));
+  EXPECT_TRUE(store.Push(MakeBatch(2)));
+  EXPECT_EQ(store.size(), 2);
+
+  ASSERT_TRUE(store.Front(&batch));
+  EXPECT_EQ(batch, MakeBatch(1));
+  store.Pop();
+  ASSERT_TRUE(store.Front(&batch));
+  EXPECT_EQ(batch, MakeBatch(2));
+  store.Pop();
+  EXPECT_FALSE(store.Front(&batch));
+  EXPECT_EQ(store.size(), 0);
+}
+
+TEST_F(BatchStoreTest, CompressesBatches) {
+  BatchStore store(path_prefix_, 10);
+  ASSERT_TRUE(store.Push(MakeBatch(1)));
+  std::ifstream file(path_prefix_ + "batch-0",
+                     std::ios_base::binary | std::ios_base::ate);
+  ASSERT_TRUE(file);
+  EXPECT_LT(static_cast<int>(file.tellg()), 500);
+}
+
+TEST_F(BatchStoreTest, KeepsBatchesAcrossInstances) {
+  {
+    BatchStore store(path_prefix_, 10);
+    store.Push(MakeBatch(1));
+    store.Push(MakeBatch(2));
+    store.Pop();
+    store.Push(MakeBatch(3));
+  }
+  BatchStore store(path_prefix_, 10);
+  EXPECT_EQ(store.size(), 2);
+  Variant batch;
+  ASSERT_TRUE(store.Front(&batch));
+  EXPECT_EQ(batch, MakeBatch(2));
+  store.Pop();
+  ASSERT_TRUE(store.Front(&batch));
+  EXPECT_EQ(batch, MakeBatch(3));
+}
+
+TEST_F(BatchStoreTest, FindsBatchesMissingFromTheIndex) {
+  {
+    BatchStore store(path_prefix_, 10);
+    store.Push(MakeBatch(1));
+    store.Push(MakeBatch(2));
+  }
+  // As if the app stopped after writing the batches but before the index.
+  std::remove((path_prefix_ + "index").c_str());
+  BatchStore store(path_prefix_, 10);
+  EXPECT_EQ(store.size(), 2);
+}
+
+TEST_F(BatchStoreTest, DropsOldestBatchesWhenFull) {
+  BatchStore store(path_prefix_, 2);
+  store.Push(MakeBatch(1));
+  store.Push(MakeBatch(2));
+  store.Push(MakeBatch(3));
+  EXPECT_EQ(store.size(), 2);
+  Variant batch;
+  ASSERT_TRUE(store.Front(&batch));
+  EXPECT_EQ(batch, MakeBatch(2));
+}
+
+TEST_F(BatchStoreTest, SkipsUnreadableBatches) {
+  BatchStore store(path_prefix_, 10);
+  store.Push(MakeBatch(1));
+  store.Push(MakeBatch(2));
+  {
+    std::ofstream file(path_prefix_ + "batch-0",
+                       std::ios_base::trunc | std::ios_base::binary);
+    file << "not a batch";
+  }
+  Variant batch;
+  ASSERT_TRUE(store.Front(&batch));
+  EXPECT_EQ(batch, MakeBatch(2));
+  EXPECT_EQ(store.size(), 1);
+}
+
+TEST_F(BatchStoreTest, Clear) {
+  {
+    BatchStore store(path_prefix_, 10);
+    store.Push(MakeBatch(1));
+    store.Push(MakeBatch(2));
+    store.Clear();
+    EXPECT_EQ(store.size(), 0);
+  }
+  BatchStore store(path_prefix_, 10);
+  Variant batch;
+  EXPECT_FALSE(store.Front(&batch));
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
@@ -0,0 +1,384 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/desktop/event_logger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "analytics/src/include/firebase/analytics.h"
+#include "analytics/src/include/firebase/analytics/event_schema.h"
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_builder.h"
+#include "app/rest/transport_interface.h"
+#include "app/rest/util.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/reference_counted_future_impl.h"
+#include "app/src/semaphore.h"
+#include "app/src/time.h"
+#include "app/src/variant_util.h"
+#include "app/tests/include/firebase/app_for_testing.h"
+#include "firebase/app.h"
+#include "firebase/future.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+const int kTimeoutInMilliseconds = 5000;
+const char kCollectorURL[] = "http://localhost/collect";
+
+// Stands in for the Measurement Protocol endpoint. Answers with the queued
+// statuses, then accepts every batch.
+class FakeCollector {
+ public:
+  void Handle(rest::Request* request, rest::Response* response) {
+    std::string body;
+    request->ReadBodyIntoString(&body);
+    MutexLock lock(mutex_);
+    urls_.push_back(request->options().url);
+    int status = rest::util::HttpSuccess;
+    if (!statuses_.empty()) {
+      status = statuses_.front();
+      statuses_.pop_front();
+    }
+    if (status == rest::util::HttpSuccess) {
+      accepted_.push_back(util::JsonToVariant(body.c_str()));
+    }
+    response->set_status(status);
+    response->MarkCompleted();
+  }
+
+  void QueueStatus(int status) {
+    MutexLock lock(mutex_);
+    statuses_.push_back(status);
+  }
+
+  std::vector<Variant> accepted() {
+    MutexLock lock(mutex_);
+    return accepted_;
+  }
+
+  std::vector<std::string> urls() {
+    MutexLock lock(mutex_);
+    return urls_;
+  }
+
+ private:
+  Mutex mutex_;
+  std::deque<int> statuses_;
+  std::vector<Variant> accepted_;
+  std::vector<std::string> urls_;
+};
+
+FakeCollector* g_collector = nullptr;
+
+class FakeCollectorTransport : public rest::Transport {
+ private:
+  void PerformInternal(
+      rest::Request* request, rest::Response* response,
+      flatbuffers::unique_ptr<rest::Controller>* controller_out) override {
+    g_collector->Handle(request, response);
+  }
+};
+
+// Names of the events in the accepted batches, by batch.
+std::vector<std::vector<std::string>> EventNames(
+    const std::vector<Variant>& batches) {
+  std::vector<std::vector<std::string>> names;
+  for (const Variant& batch : batches) {
+    names.emplace_back();
+    for (const Variant& event : batch.map().at(Variant("events")).vector()) {
+      names.back().push_back(event.map().at(Variant("name")).string_value());
+    }
+  }
+  return names;
+}
+
+class EventLoggerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_collector = &collector_;
+    rest::SetTransportBuilder([]() -> flatbuffers::unique_ptr<rest::Transport> {
+      return flatbuffers::unique_ptr<rest::Transport>(
+          new FakeCollectorTransport());
+    });
+    settings_.path_prefix =
+        ::testing::TempDir() + "analytics-" +
+        ::testing::UnitTest::GetInstance()->current_test_info()->name() + "-";
+    settings_.upload_url = kCollectorURL;
+    settings_.max_batch_size = 2;
+    // Only flush when the tests ask to.
+    settings_.flush_interval_ms = 60 * 1000;
+    settings_.initial_retry_delay_ms = 10;
+    settings_.max_retry_delay_ms = 40;
+    RemoveFiles();
+    app_.reset(testing::CreateApp());
+    logger_.reset(new EventLogger(*app_, settings_));
+  }
+
+  void TearDown() override {
+    logger_.reset(nullptr);
+    app_.reset(nullptr);
+    RemoveFiles();
+    g_collector = nullptr;
+  }
+
+  void RemoveFiles() {
+    std::remove((settings_.path_prefix + "app_instance_id").c_str());
+    std::remove((settings_.path_prefix + "index").c_str());
+    for (int i = 0; i < 20; ++i) {
+      std::remove(
+          (settings_.path_prefix + "batch-" + std::to_string(i)).c_str());
+    }
+  }
+
+  void Flush() {
+    Semaphore flushed(0);
+    logger_->Flush(&flushed);
+    ASSERT_TRUE(flushed.TimedWait(kTimeoutInMilliseconds));
+  }
+
+  std::string GetAppInstanceId() {
+    ReferenceCountedFutureImpl api(1);
+    SafeFutureHandle<std::string> handle = api.SafeAlloc<std::string>(0);
+    logger_->GetAppInstanceId(&api, handle);
+    Future<std::string> future(&api, handle.get());
+    for (int i = 0; i < kTimeoutInMilliseconds &&
+                    future.status() != kFutureStatusComplete;
+         ++i) {
+      ::firebase::internal::Sleep(1);
+    }
+    return future.status() == kFutureStatusComplete ? *future.result() : "";
+  }
+
+  // Waits until the collector accepted `count` batches.
+  bool WaitForAcceptedBatches(size_t count) {
+    for (int i = 0; i < kTimeoutInMilliseconds; ++i) {
+      if (collector_.accepted().size() >= count) return true;
+      ::firebase::internal::Sleep(1);
+    }
+    return false;
+  }
+
+  FakeCollector collector_;
+  EventLoggerSettings settings_;
+  std::unique_ptr<App> app_;
+  std::unique_ptr<EventLogger> logger_;
+};
+
+TEST_F(EventLoggerTest, UploadsEventsInBatches) {
+  logger_->LogEvent("first", nullptr, 0);
+  logger_->LogEvent("second", nullptr, 0);
+  logger_->LogEvent("third", nullptr, 0);
+  Flush();
+
+  std::vector<Variant> accepted = collector_.accepted();
+  EXPECT_THAT(EventNames(accepted),
+              ElementsAre(ElementsAre("first", "second"),
+                          ElementsAre("third")));
+  std::string app_instance_id = GetAppInstanceId();
+  EXPECT_THAT(app_instance_id, SizeIs(32));
+  for (const Variant& batch : accepted) {
+    EXPECT_EQ(batch.map().at(Variant("app_instance_id")),
+              Variant(app_instance_id));
+  }
+  std::vector<std::string> urls = collector_.urls();
+  ASSERT_THAT(urls, SizeIs(2));
+  EXPECT_THAT(urls[0], HasSubstr(kCollectorURL));
+  EXPECT_THAT(urls[0], HasSubstr(std::string("firebase_app_id=") +
+                                 app_->options().app_id()));
+}
+
+TEST_F(EventLoggerTest, CopiesParameters) {
+  char value[] = "original";
+  Parameter parameters[] = {Parameter("text", value),
+                            Parameter("number", 42),
+                            Parameter("fraction", 0.5)};
+  logger_->LogEvent("event", parameters, 3);
+  strcpy(value, "changed");  // NOLINT
+  Flush();
+
+  std::vector<Variant> accepted = collector_.accepted();
+  ASSERT_THAT(accepted, SizeIs(1));
+  const Variant& event =
+      accepted[0].map().at(Variant("events")).vector().at(0);
+  const Variant& params = event.map().at(Variant("params"));
+  EXPECT_EQ(params.map().at(Variant("text")), Variant("original"));
+  EXPECT_EQ(params.map().at(Variant("number")), Variant(42));
+  EXPECT_EQ(params.map().at(Variant("fraction")), Variant(0.5));
+  EXPECT_TRUE(params.map().at(Variant("session_id")).is_int64());
+  EXPECT_TRUE(event.map().at(Variant("timestamp_micros")).is_int64());
+}
+
+TEST_F(EventLoggerTest, DropsMapEntriesWithoutStringKeys) {
+  std::map<Variant, Variant> item;
+  item[Variant("name")] = "kept";
+  item[Variant(1)] = "dropped";
+  Parameter parameters[] = {Parameter("item", Variant(item))};
+  logger_->LogEvent("event", parameters, 1);
+  Flush();
+
+  std::vector<Variant> accepted = collector_.accepted();
+  ASSERT_THAT(accepted, SizeIs(1));
+  const Variant& event =
+      accepted[0].map().at(Variant("events")).vector().at(0);
+  const Variant& params = event.map().at(Variant("params"));
+  EXPECT_EQ(params.map().at(Variant("item")),
+            Variant(std::map<Variant, Variant>{
+                std::make_pair(Variant("name"), Variant("kept"))}));
+}
+
+TEST_F(EventLoggerTest, DecodesEncodedParameters) {
+  EventSchema<const char*, int64_t, double> schema("event", "text", "number",
+                                                   "fraction");
+  std::vector<uint8_t> encoded(schema.EncodedSize("original", 42, 0.5));
+  schema.Encode(encoded.data(), "original", 42, 0.5);
+  logger_->LogEncodedEvent(schema.name(), encoded.data(), encoded.size());
+  Flush();
+
+  std::vector<Variant> accepted = collector_.accepted();
+  ASSERT_THAT(accepted, SizeIs(1));
+  const Variant& event =
+      accepted[0].map().at(Variant("events")).vector().at(0);
+  EXPECT_EQ(event.map().at(Variant("name")), Variant("event"));
+  const Variant& params = event.map().at(Variant("params"));
+  EXPECT_EQ(params.map().at(Variant("text")), Variant("original"));
+  EXPECT_EQ(params.map().at(Variant("number")), Variant(42));
+  EXPECT_EQ(params.map().at(Variant("fraction")), Variant(0.5));
+  EXPECT_TRUE(params.map().at(Variant("session_id")).is_int64());
+}
+
+TEST_F(EventLoggerTest, AppliesUserChangesToLaterEvents) {
+  logger_->LogEvent("before", nullptr, 0);
+  logger_->SetUserId("user");
+  logger_->SetUserProperty("property", "value");
+  logger_->LogEvent("after", nullptr, 0);
+  Flush();
+
+  std::vector<Variant> accepted = collector_.accepted();
+  EXPECT_THAT(EventNames(accepted),
+              ElementsAre(ElementsAre("before"), ElementsAre("after")));
+  ASSERT_THAT(accepted, SizeIs(2));
+  EXPECT_EQ(accepted[0].map().count(Variant("user_id")), 0);
+  EXPECT_EQ(accepted[1].map().at(Variant("user_id")), Variant("user"));
+  EXPECT_EQ(accepted[1].map().at(Variant("user_properties")),
+            util::JsonToVariant("{\"property\": {\"value\": \"value\"}}"));
+}
+
+TEST_F(EventLoggerTest, RetriesFailedUploads) {
+  collector_.QueueStatus(503);
+  collector_.QueueStatus(0);
+  logger_->LogEvent("event", nullptr, 0);
+  Flush();
+
+  ASSERT_TRUE(WaitForAcceptedBatches(1));
+  EXPECT_THAT(EventNames(collector_.accepted()),
+              ElementsAre(ElementsAre("event")));
+  EXPECT_THAT(collector_.urls(), SizeIs(3));
+}
+
+TEST_F(EventLoggerTest, DropsRejectedBatches) {
+  collector_.QueueStatus(400);
+  logger_->LogEvent("rejected", nullptr, 0);
+  Flush();
+  logger_->LogEvent("accepted", nullptr, 0);
+  Flush();
+
+  EXPECT_THAT(EventNames(collector_.accepted()),
+              ElementsAre(ElementsAre("accepted")));
+}
+
+TEST_F(EventLoggerTest, KeepsEventsAcrossRestarts) {
+  // Retry too late for this run.
+  logger_.reset(nullptr);
+  settings_.initial_retry_delay_ms = 60 * 1000;
+  logger_.reset(new EventLogger(*app_, settings_));
+  collector_.QueueStatus(503);
+  logger_->LogEvent("uploaded later", nullptr, 0);
+  Flush();
+  logger_->LogEvent("not flushed", nullptr, 0);
+  std::string app_instance_id = GetAppInstanceId();
+  logger_.reset(nullptr);
+  EXPECT_THAT(collector_.accepted(), IsEmpty());
+
+  logger_.reset(new EventLogger(*app_, settings_));
+  ASSERT_TRUE(WaitForAcceptedBatches(2));
+  EXPECT_THAT(EventNames(collector_.accepted()),
+              ElementsAre(ElementsAre("uploaded later"),
+                          ElementsAre("not flushed")));
+  EXPECT_EQ(GetAppInstanceId(), app_instance_id);
+}
+
+TEST_F(EventLoggerTest, ResetAnalyticsData) {
+  logger_->SetUserId("user");
+  logger_->LogEvent("dropped", nullptr, 0);
+  std::string app_instance_id = GetAppInstanceId();
+
+  logger_->ResetAnalyticsData();
+  logger_->LogEvent("kept", nullptr, 0);
+  Flush();
+
+  std::string new_app_instance_id = GetAppInstanceId();
+  EXPECT_NE(new_app_instance_id, app_instance_id);
+  std::vector<Variant> accepted = collector_.accepted();
+  EXPECT_THAT(EventNames(accepted), ElementsAre(ElementsAre("kept")));
+  ASSERT_THAT(accepted, SizeIs(1));
+  EXPECT_EQ(accepted[0].map().count(Variant("user_id")), 0);
+  EXPECT_EQ(accepted[0].map().at(Variant("app_instance_id")),
+            Variant(new_app_instance_id));
+}
+
+TEST_F(EventLoggerTest, DropsEventsWithoutConsent) {
+  logger_->SetCollectionEnabled(false);
+  logger_->LogEvent("collection disabled", nullptr, 0);
+  logger_->SetCollectionEnabled(true);
+  logger_->SetAnalyticsStorageGranted(false);
+  logger_->LogEvent("storage denied", nullptr, 0);
+  logger_->SetAnalyticsStorageGranted(true);
+  logger_->LogEvent("logged", nullptr, 0);
+  Flush();
+
+  EXPECT_THAT(EventNames(collector_.accepted()),
+              ElementsAre(ElementsAre("logged")));
+}
+
+TEST_F(EventLoggerTest, FlushesPartialBatchesAfterInterval) {
+  logger_.reset(nullptr);
+  settings_.flush_interval_ms = 10;
+  logger_.reset(new EventLogger(*app_, settings_));
+  logger_->LogEvent("event", nullptr, 0);
+  ASSERT_TRUE(WaitForAcceptedBatches(1));
+  EXPECT_THAT(EventNames(collector_.accepted()),
+              ElementsAre(ElementsAre("event")));
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/desktop/event_queue.h"
+
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+using ::testing::ElementsAre;
+
+PendingEvent* NewEvent(const std::string& name) {
+  PendingEvent* event = new PendingEvent();
+  event->name = name;
+  return event;
+}
+
+std::vector<std::string> Names(PendingEvent* events) {
+  std::vector<std::string> names;
+  for (PendingEvent* event = events; event; event = event->next) {
+    names.push_back(event->name);
+  }
+  return names;
+}
+
+TEST(EventQueueTest, TakesEventsInOrder) {
+  EventQueue queue;
+  EXPECT_EQ(queue.TakeAll(), nullptr);
+  EXPECT_EQ(queue.Push(NewEvent("first")), 1);
+  EXPECT_EQ(queue.Push(NewEvent("second")), 2);
+  EXPECT_EQ(queue.Push(NewEvent("third")), 3);
+
+  PendingEvent* events = queue.TakeAll();
+  EXPECT_THAT(Names(events), ElementsAre("first", "second", "third"));
+  DeleteEvents(events);
+  EXPECT_EQ(queue.size(), 0);
+  EXPECT_EQ(queue.TakeAll(), nullptr);
+
+  EXPECT_EQ(queue.Push(NewEvent("fourth")), 1);
+  events = queue.TakeAll();
+  EXPECT_THAT(Names(events), ElementsAre("fourth"));
+  DeleteEvents(events);
+}
+
+TEST(EventQueueTest, DeletesEventsLeftInQueue) {
+  EventQueue queue;
+  queue.Push(NewEvent("left behind"));
+}
+
+TEST(EventQueueTest, TakesEveryEventPushedConcurrently) {
+  const int kThreads = 4;
+  const int kEventsPerThread = 10000;
+  EventQueue queue;
+  std::atomic<bool> done(false);
+  std::vector<std::vector<int>> taken(kThreads);
+
+  std::thread consumer([&]() {
+    bool last_pass = false;
+    while (!last_pass) {
+      last_pass = done.load();
+      PendingEvent* events = queue.TakeAll();
+      for (PendingEvent* event = events; event; event = event->next) {
+        taken[event->name[0] - 'a'].push_back(
+            static_cast<int>(event->timestamp_ms));
+      }
+      DeleteEvents(events);
+    }
+  });
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kThreads; ++i) {
+    producers.emplace_back([&queue, i]() {
+      for (int j = 0; j < kEventsPerThread; ++j) {
+        PendingEvent* event = NewEvent(std::string(1, 'a' + i));
+        event->timestamp_ms = j;
+        queue.Push(event);
+      }
+    });
+  }
+  for (std::thread& producer : producers) producer.join();
+  done = true;
+  consumer.join();
+
+  // Events from each thread arrive once each, in the order they were pushed.
+  for (int i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(taken[i].size(), kEventsPerThread);
+    for (int j = 0; j < kEventsPerThread; ++j) EXPECT_EQ(taken[i][j], j);
+  }
+  EXPECT_EQ(queue.size(), 0);
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "analytics/src/include/firebase/analytics/event_schema.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analytics/src/analytics_common.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace analytics {
+namespace internal {
+
+template <typename... Types>
+std::vector<uint8_t> Encode(const EventSchema<Types...>& schema,
+                            typename NonDeduced<Types>::type... values) {
+  std::vector<uint8_t> encoded(schema.EncodedSize(values...));
+  schema.Encode(encoded.data(), values...);
+  return encoded;
+}
+
+TEST(EventSchemaTest, EncodesParametersInOrder) {
+  EventSchema<int64_t, double, const char*> schema("level_up", "level",
+                                                   "score", "character");
+  EXPECT_STREQ(schema.name(), "level_up");
+  std::vector<uint8_t> encoded = Encode(schema, 42, 1234.5, "mysterion");
+
+  EncodedParameterReader reader(encoded.data(), encoded.size());
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.type(), kEncodedParameterInt64);
+  EXPECT_STREQ(reader.name(), "level");
+  EXPECT_EQ(reader.int64_value(), 42);
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.type(), kEncodedParameterDouble);
+  EXPECT_STREQ(reader.name(), "score");
+  EXPECT_EQ(reader.double_value(), 1234.5);
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.type(), kEncodedParameterString);
+  EXPECT_STREQ(reader.name(), "character");
+  EXPECT_STREQ(reader.string_value(), "mysterion");
+  EXPECT_FALSE(reader.Next());
+}
+
+TEST(EventSchemaTest, EncodesEventsWithoutParameters) {
+  EventSchema<> schema("tutorial_begin");
+  std::vector<uint8_t> encoded = Encode(schema);
+  EXPECT_TRUE(encoded.empty());
+  EncodedParameterReader reader(encoded.data(), encoded.size());
+  EXPECT_FALSE(reader.Next());
+}
+
+TEST(EventSchemaTest, EncodesLongAndNullStrings) {
+  EventSchema<const char*, const char*> schema("event", "long", "null");
+  std::string long_value(2 * kEncodedParametersInlineSize, 'x');
+  std::vector<uint8_t> encoded = Encode(schema, long_value.c_str(), nullptr);
+
+  EncodedParameterReader reader(encoded.data(), encoded.size());
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.string_value(), long_value);
+  ASSERT_TRUE(reader.Next());
+  EXPECT_STREQ(reader.string_value(), "");
+  EXPECT_FALSE(reader.Next());
+}
+
+TEST(EventSchemaTest, StopsAtMalformedData) {
+  EventSchema<int64_t, const char*> schema("event", "number", "text");
+  std::vector<uint8_t> encoded = Encode(schema, 1, "value");
+  // Cut the string short.
+  encoded.pop_back();
+
+  EncodedParameterReader reader(encoded.data(), encoded.size());
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.int64_value(), 1);
+  EXPECT_FALSE(reader.Next());
+  EXPECT_FALSE(reader.Next());
+
+  const uint8_t unknown_type[] = {42, 'a', 0};
+  EncodedParameterReader unknown_reader(unknown_type, sizeof(unknown_type));
+  EXPECT_FALSE(unknown_reader.Next());
+}
+
+}  // namespace internal
+}  // namespace analytics
+}  // namespace firebase
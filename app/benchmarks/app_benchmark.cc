@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "app/src/include/firebase/app.h"
+#include "app/src/include/firebase/internal/platform.h"
+#include "benchmark/benchmark.h"
+
+#if FIREBASE_PLATFORM_LINUX
+#include <unistd.h>
+#endif  // FIREBASE_PLATFORM_LINUX
+
+namespace firebase {
+namespace {
+
+AppOptions MakeOptions() {
+  AppOptions options;
+  options.set_app_id("com.google.firebase.benchmark");
+  options.set_api_key("not_a_real_api_key");
+  options.set_project_id("not_a_real_project_id");
+  return options;
+}
+
+// Resident set size of the process in bytes, or 0 if it is not known on this
+// platform.
+double GetResidentBytes() {
+#if FIREBASE_PLATFORM_LINUX
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+  long pages = 0;     // NOLINT
+  long resident = 0;  // NOLINT
+  int read = fscanf(statm, "%ld %ld", &pages, &resident);
+  fclose(statm);
+  if (read != 2) return 0;
+  return static_cast<double>(resident) * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif  // FIREBASE_PLATFORM_LINUX
+}
+
+void BM_AppCreateDestroy(benchmark::State& state) {
+  AppOptions options = MakeOptions();
+  for (auto _ : state) {
+    App* app = App::Create(options, "benchmark");
+    benchmark::DoNotOptimize(app);
+    delete app;
+  }
+}
+BENCHMARK(BM_AppCreateDestroy);
+
+// Create many named apps, as multi-tenant servers do, and report the memory
+// each one takes.
+void BM_AppCreateMany(benchmark::State& state) {
+  const int app_count = static_cast<int>(state.range(0));
+  AppOptions options = MakeOptions();
+  std::vector<App*> apps;
+  apps.reserve(app_count);
+  char name[32];
+  double bytes_per_app = 0;
+  for (auto _ : state) {
+    double resident_before = GetResidentBytes();
+    for (int i = 0; i < app_count; ++i) {
+      snprintf(name, sizeof(name), "tenant_%d", i);
+      apps.push_back(App::Create(options, name));
+    }
+    state.PauseTiming();
+    // Freed memory is reused by later iterations, so the first iteration
+    // shows the most growth.
+    double growth = (GetResidentBytes() - resident_before) / app_count;
+    if (growth > bytes_per_app) bytes_per_app = growth;
+    state.ResumeTiming();
+    for (size_t i = 0; i < apps.size(); ++i) delete apps[i];
+    apps.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * app_count);
+  state.counters["rss_bytes_per_app"] = bytes_per_app;
+}
+BENCHMARK(BM_AppCreateMany)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace firebase
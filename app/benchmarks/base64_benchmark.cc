@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include "app/src/base64.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+std::string MakeInput(size_t size) {
+  std::string input(size, '\0');
+  for (size_t i = 0; i < size; ++i) input[i] = static_cast<char>(i * 31);
+  return input;
+}
+
+void BM_Base64Encode(benchmark::State& state) {
+  std::string input = MakeInput(state.range(0));
+  std::string output;
+  for (auto _ : state) {
+    Base64EncodeWithPadding(input, &output);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Base64Encode)->Range(64, 64 << 10);
+
+void BM_Base64Decode(benchmark::State& state) {
+  std::string encoded;
+  Base64EncodeWithPadding(MakeInput(state.range(0)), &encoded);
+  std::string output;
+  for (auto _ : state) {
+    Base64Decode(encoded, &output);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK(BM_Base64Decode)->Range(64, 64 << 10);
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
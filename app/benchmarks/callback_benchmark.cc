@@ -0,0 +1,73 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/callback.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace callback {
+namespace {
+
+void Increment(int* count) { ++*count; }
+
+// Queue a batch of callbacks, then run them all with one poll.
+void BM_AddAndPollCallbacks(benchmark::State& state) {
+  Initialize();
+  int count = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < state.range(0); ++i) {
+      AddCallback(new CallbackValue1<int*>(&count, Increment));
+    }
+    PollCallbacks();
+  }
+  benchmark::DoNotOptimize(count);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  Terminate(true);
+}
+BENCHMARK(BM_AddAndPollCallbacks)->Arg(1)->Arg(16)->Arg(256);
+
+// Queue callbacks and remove them again before they are polled.
+void BM_AddAndRemoveCallback(benchmark::State& state) {
+  Initialize();
+  int count = 0;
+  for (auto _ : state) {
+    RemoveCallback(AddCallback(new CallbackValue1<int*>(&count, Increment)));
+  }
+  PollCallbacks();
+  benchmark::DoNotOptimize(count);
+  Terminate(true);
+}
+BENCHMARK(BM_AddAndRemoveCallback);
+
+// Queue callbacks from several threads while the main thread polls them, as
+// the SDK's background threads do.
+void BM_AddCallbackContended(benchmark::State& state) {
+  static int count = 0;
+  if (state.thread_index() == 0) Initialize();
+  for (auto _ : state) {
+    AddCallback(new CallbackValue1<int*>(&count, Increment));
+    if (state.thread_index() == 0) PollCallbacks();
+  }
+  if (state.thread_index() == 0) {
+    PollCallbacks();
+    Terminate(true);
+  }
+}
+BENCHMARK(BM_AddCallbackContended)->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace callback
+}  // namespace firebase
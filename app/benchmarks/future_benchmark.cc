@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/include/firebase/future.h"
+#include "app/src/reference_counted_future_impl.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace {
+
+enum BenchmarkFn { kBenchmarkFnRun, kBenchmarkFnCount };
+
+// Allocate a future, complete it and release it, as every async API call does.
+void BM_FutureAllocCompleteRelease(benchmark::State& state) {
+  ReferenceCountedFutureImpl future_impl(kBenchmarkFnCount);
+  for (auto _ : state) {
+    SafeFutureHandle<int> handle =
+        future_impl.SafeAlloc<int>(kBenchmarkFnRun, 0);
+    Future<int> future = MakeFuture(&future_impl, handle);
+    future_impl.CompleteWithResult(handle, 0, "", 42);
+    benchmark::DoNotOptimize(*future.result());
+  }
+}
+BENCHMARK(BM_FutureAllocCompleteRelease);
+
+// The same, without recording the future as the last result of an API call.
+void BM_FutureAllocCompleteReleaseNoLastResult(benchmark::State& state) {
+  ReferenceCountedFutureImpl future_impl(kBenchmarkFnCount);
+  for (auto _ : state) {
+    SafeFutureHandle<int> handle = future_impl.SafeAlloc<int>();
+    Future<int> future = MakeFuture(&future_impl, handle);
+    future_impl.CompleteWithResult(handle, 0, "", 42);
+    benchmark::DoNotOptimize(*future.result());
+  }
+}
+BENCHMARK(BM_FutureAllocCompleteReleaseNoLastResult);
+
+// Complete a future that has a completion callback.
+void BM_FutureCompleteWithCallback(benchmark::State& state) {
+  ReferenceCountedFutureImpl future_impl(kBenchmarkFnCount);
+  int completed = 0;
+  for (auto _ : state) {
+    SafeFutureHandle<int> handle = future_impl.SafeAlloc<int>();
+    Future<int> future = MakeFuture(&future_impl, handle);
+    future.OnCompletion(
+        [](const Future<int>& result, void* user_data) {
+          ++*static_cast<int*>(user_data);
+        },
+        &completed);
+    future_impl.CompleteWithResult(handle, 0, "", 42);
+  }
+  benchmark::DoNotOptimize(completed);
+}
+BENCHMARK(BM_FutureCompleteWithCallback);
+
+// Complete a future with several lambda callbacks added with AddOnCompletion.
+void BM_FutureCompleteWithLambdaCallbacks(benchmark::State& state) {
+  ReferenceCountedFutureImpl future_impl(kBenchmarkFnCount);
+  int completed = 0;
+  for (auto _ : state) {
+    SafeFutureHandle<int> handle = future_impl.SafeAlloc<int>();
+    Future<int> future = MakeFuture(&future_impl, handle);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      future.AddOnCompletion([&completed](const Future<int>&) { ++completed; });
+    }
+    future_impl.CompleteWithResult(handle, 0, "", 42);
+  }
+  benchmark::DoNotOptimize(completed);
+}
+BENCHMARK(BM_FutureCompleteWithLambdaCallbacks)->Arg(1)->Arg(4);
+
+// Read the status of a pending future, as polling loops do.
+void BM_FutureStatus(benchmark::State& state) {
+  ReferenceCountedFutureImpl future_impl(kBenchmarkFnCount);
+  SafeFutureHandle<int> handle = future_impl.SafeAlloc<int>();
+  Future<int> future = MakeFuture(&future_impl, handle);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(future.status());
+  }
+  future_impl.CompleteWithResult(handle, 0, "", 42);
+}
+BENCHMARK(BM_FutureStatus);
+
+// Copy a future, which takes a reference on the shared future data.
+void BM_FutureCopy(benchmark::State& state) {
+  ReferenceCountedFutureImpl future_impl(kBenchmarkFnCount);
+  SafeFutureHandle<int> handle = future_impl.SafeAlloc<int>();
+  Future<int> future = MakeFuture(&future_impl, handle);
+  for (auto _ : state) {
+    Future<int> copy(future);
+    benchmark::DoNotOptimize(&copy);
+  }
+  future_impl.CompleteWithResult(handle, 0, "", 42);
+}
+BENCHMARK(BM_FutureCopy);
+
+}  // namespace
+}  // namespace firebase
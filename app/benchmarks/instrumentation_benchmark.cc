@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/mutex_profiler.h"
+#include "app/src/trace.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+// Uncontended MutexLock, the baseline for profiled locks.
+void BM_MutexLock(benchmark::State& state) {
+  Mutex mutex(Mutex::kModeNonRecursive);
+  for (auto _ : state) {
+    MutexLock lock(mutex);
+  }
+}
+BENCHMARK(BM_MutexLock);
+
+// Uncontended profiled lock, with profiling off (0) or on (1).
+void BM_ProfiledMutexLock(benchmark::State& state) {
+  Mutex mutex(Mutex::kModeNonRecursive);
+  MutexProfiler::SetEnabled(state.range(0) != 0);
+  for (auto _ : state) {
+    FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex, "BM_ProfiledMutexLock::mutex");
+  }
+  MutexProfiler::SetEnabled(false);
+  MutexProfiler::ResetStats();
+}
+BENCHMARK(BM_ProfiledMutexLock)->Arg(0)->Arg(1);
+
+// A profiled lock shared by several threads.
+void BM_ProfiledMutexLockContended(benchmark::State& state) {
+  static Mutex* mutex = new Mutex(Mutex::kModeNonRecursive);
+  if (state.thread_index() == 0) MutexProfiler::SetEnabled(true);
+  for (auto _ : state) {
+    FIREBASE_PROFILED_MUTEX_LOCK(lock, *mutex, "BM_ProfiledMutexLock::mutex");
+  }
+  if (state.thread_index() == 0) {
+    MutexProfiler::SetEnabled(false);
+    MutexProfiler::ResetStats();
+  }
+}
+BENCHMARK(BM_ProfiledMutexLockContended)->ThreadRange(1, 8);
+
+// A trace span, with tracing off (0) or on (1).
+void BM_TraceScope(benchmark::State& state) {
+  Trace::SetEnabled(state.range(0) != 0);
+  for (auto _ : state) {
+    FIREBASE_TRACE_SCOPE("benchmark", "BM_TraceScope");
+  }
+  Trace::SetEnabled(false);
+  Trace::Clear();
+}
+BENCHMARK(BM_TraceScope)->Arg(0)->Arg(1);
+
+// Starting and ending a trace flow, with tracing off (0) or on (1).
+void BM_TraceFlow(benchmark::State& state) {
+  Trace::SetEnabled(state.range(0) != 0);
+  for (auto _ : state) {
+    uint64_t flow_id = FIREBASE_TRACE_NEW_FLOW_ID();
+    FIREBASE_TRACE_FLOW_BEGIN("benchmark", "Begin", flow_id);
+    FIREBASE_TRACE_SCOPE_FLOW_END("benchmark", "End", flow_id);
+  }
+  Trace::SetEnabled(false);
+  Trace::Clear();
+}
+BENCHMARK(BM_TraceFlow)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
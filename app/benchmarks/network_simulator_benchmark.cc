@@ -0,0 +1,129 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <string>
+
+#include "app/rest/network_simulator.h"
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_simulated.h"
+#include "app/rest/util.h"
+#include "app/src/time.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace rest {
+namespace {
+
+// Requests over a simulated network, to compare how retries and concurrent
+// requests fare as the network gets worse. The network is seeded, so each run
+// sees the same latencies and failures.
+
+// Answers every request with a body of the requested size.
+class FixedSizeServer : public Transport {
+ public:
+  explicit FixedSizeServer(size_t body_size) : body_(body_size, 'x') {}
+
+ private:
+  void PerformInternal(Request* request, Response* response,
+                       flatbuffers::unique_ptr<Controller>*) override {
+    response->set_status(util::HttpSuccess);
+    response->ProcessBody(body_.c_str(), body_.size());
+    response->MarkCompleted();
+  }
+
+  std::string body_;
+};
+
+// Performs a request, retrying failures up to `max_attempts` times with
+// exponential backoff. Returns the number of attempts made.
+int PerformWithRetries(Transport* transport, int max_attempts,
+                       int64_t initial_backoff_ms, bool* succeeded) {
+  int64_t backoff_ms = initial_backoff_ms;
+  for (int attempt = 1;; ++attempt) {
+    Request request;
+    request.set_url("http://localhost/resource");
+    Response response;
+    transport->Perform(&request, &response, nullptr);
+    *succeeded = response.status() == util::HttpSuccess;
+    if (*succeeded || attempt == max_attempts) return attempt;
+    internal::Sleep(backoff_ms);
+    backoff_ms *= 2;
+  }
+}
+
+// A request with up to 4 retries on a network that drops range(0)% of the
+// transfers.
+void BM_RequestWithRetries(benchmark::State& state) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 5;
+  conditions.distribution = kLatencyUniform;
+  conditions.jitter_ms = 2;
+  conditions.failure_rate = static_cast<double>(state.range(0)) / 100.0;
+  conditions.seed = 1;
+  NetworkSimulator network(conditions);
+  TransportSimulated transport(
+      &network, flatbuffers::unique_ptr<Transport>(new FixedSizeServer(1024)));
+
+  int64_t attempts = 0;
+  int64_t successes = 0;
+  for (auto _ : state) {
+    bool succeeded = false;
+    attempts += PerformWithRetries(&transport, 5, 10, &succeeded);
+    if (succeeded) ++successes;
+  }
+  double requests = static_cast<double>(state.iterations());
+  state.counters["attempts_per_request"] =
+      benchmark::Counter(static_cast<double>(attempts) / requests);
+  state.counters["success_rate"] =
+      benchmark::Counter(static_cast<double>(successes) / requests);
+}
+BENCHMARK(BM_RequestWithRetries)
+    ->ArgName("failure_percent")
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(30)
+    ->UseRealTime();
+
+// Concurrent requests for 16KB each on a shared 1MB/s link. Adding threads
+// hides latency until the bandwidth runs out.
+void BM_ConcurrentRequests(benchmark::State& state) {
+  static NetworkSimulator* network = []() {
+    NetworkConditions conditions;
+    conditions.latency_ms = 20;
+    conditions.bandwidth_bytes_per_second = 1024 * 1024;
+    conditions.seed = 1;
+    return new NetworkSimulator(conditions);
+  }();
+  TransportSimulated transport(
+      network,
+      flatbuffers::unique_ptr<Transport>(new FixedSizeServer(16 * 1024)));
+
+  for (auto _ : state) {
+    Request request;
+    request.set_url("http://localhost/resource");
+    Response response;
+    transport.Perform(&request, &response, nullptr);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * 16 * 1024);
+}
+BENCHMARK(BM_ConcurrentRequests)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+}  // namespace rest
+}  // namespace firebase
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "app/src/optional.h"
+#include "app/src/path.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace {
+
+// A path of the given depth, like the ones used for database references.
+std::string MakePathString(int depth) {
+  std::string path;
+  for (int i = 0; i < depth; ++i) {
+    if (i) path += "/";
+    path += "segment_";
+    path += static_cast<char>('a' + i % 26);
+  }
+  return path;
+}
+
+void BM_PathConstruct(benchmark::State& state) {
+  std::string path_string = "/" + MakePathString(state.range(0)) + "/";
+  for (auto _ : state) {
+    Path path(path_string);
+    benchmark::DoNotOptimize(path.c_str());
+  }
+}
+BENCHMARK(BM_PathConstruct)->Arg(1)->Arg(8)->Arg(32);
+
+void BM_PathGetChild(benchmark::State& state) {
+  Path parent(MakePathString(state.range(0)));
+  std::string child("-MhX2xyq8aZ3kVQh5nqF");
+  for (auto _ : state) {
+    Path path = parent.GetChild(child);
+    benchmark::DoNotOptimize(path.c_str());
+  }
+}
+BENCHMARK(BM_PathGetChild)->Arg(1)->Arg(8)->Arg(32);
+
+void BM_PathGetParent(benchmark::State& state) {
+  Path path(MakePathString(state.range(0)));
+  for (auto _ : state) {
+    Path parent = path.GetParent();
+    benchmark::DoNotOptimize(parent.c_str());
+  }
+}
+BENCHMARK(BM_PathGetParent)->Arg(1)->Arg(8)->Arg(32);
+
+void BM_PathIsParent(benchmark::State& state) {
+  Path child(MakePathString(state.range(0)));
+  Path parent = child.GetParent();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parent.IsParent(child));
+  }
+}
+BENCHMARK(BM_PathIsParent)->Arg(1)->Arg(8)->Arg(32);
+
+void BM_PathGetDirectories(benchmark::State& state) {
+  Path path(MakePathString(state.range(0)));
+  for (auto _ : state) {
+    std::vector<std::string> directories = path.GetDirectories();
+    benchmark::DoNotOptimize(directories.data());
+  }
+}
+BENCHMARK(BM_PathGetDirectories)->Arg(1)->Arg(8)->Arg(32);
+
+void BM_PathGetRelative(benchmark::State& state) {
+  Path to(MakePathString(state.range(0)));
+  Path from = to.GetParent().GetParent();
+  for (auto _ : state) {
+    Optional<Path> relative = Path::GetRelative(from, to);
+    benchmark::DoNotOptimize(relative.has_value());
+  }
+}
+BENCHMARK(BM_PathGetRelative)->Arg(2)->Arg(8)->Arg(32);
+
+}  // namespace
+}  // namespace firebase
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/safe_reference.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+// Work done while the lock is held, as a callback does.
+void DoWork(int64_t iterations) {
+  for (int64_t i = 0; i < iterations; ++i) {
+    benchmark::DoNotOptimize(i);
+  }
+}
+
+// A recursive mutex shared by several threads, which is how SafeReferenceLock
+// used to guard the reference.
+void BM_RecursiveMutexLockContended(benchmark::State& state) {
+  static Mutex* mutex = new Mutex(Mutex::kModeRecursive);
+  for (auto _ : state) {
+    MutexLock lock(*mutex);
+    DoWork(state.range(0));
+  }
+}
+BENCHMARK(BM_RecursiveMutexLockContended)->Arg(0)->Arg(200)->ThreadRange(1, 8);
+
+// A reference locked by several threads, as callbacks on different
+// schedulers do. Unlike the mutex, holding the lock does not stop other
+// threads from taking it.
+void BM_SafeReferenceLockContended(benchmark::State& state) {
+  static int value = 0;
+  static SafeReference<int>* ref = new SafeReference<int>(&value);
+  for (auto _ : state) {
+    SafeReferenceLock<int> lock(ref);
+    benchmark::DoNotOptimize(lock.GetReference());
+    DoWork(state.range(0));
+  }
+}
+BENCHMARK(BM_SafeReferenceLockContended)->Arg(0)->Arg(200)->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
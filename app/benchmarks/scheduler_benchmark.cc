@@ -0,0 +1,114 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "app/memory/atomic.h"
+#include "app/memory/unique_ptr.h"
+#include "app/src/callback.h"
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread_pool.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace {
+
+void PostSemaphore(Semaphore* semaphore) { semaphore->Post(); }
+
+// Returns a scheduler with its own worker thread if use_pool is 0, or one that
+// runs requests on the pool otherwise.
+UniquePtr<scheduler::Scheduler> MakeScheduler(int64_t use_pool,
+                                              ThreadPool* pool) {
+  return use_pool ? MakeUnique<scheduler::Scheduler>(pool)
+                  : MakeUnique<scheduler::Scheduler>();
+}
+
+// Time from scheduling a request to it running on the worker thread.
+void BM_SchedulerRoundTrip(benchmark::State& state) {
+  ThreadPool pool((ThreadPool::Options()));
+  UniquePtr<scheduler::Scheduler> scheduler =
+      MakeScheduler(state.range(0), &pool);
+  Semaphore done(0);
+  for (auto _ : state) {
+    scheduler->Schedule(
+        new callback::CallbackValue1<Semaphore*>(&done, PostSemaphore));
+    done.Wait();
+  }
+  state.SetLabel(state.range(0) ? "pool" : "dedicated thread");
+}
+BENCHMARK(BM_SchedulerRoundTrip)->Arg(0)->Arg(1)->UseRealTime();
+
+struct BatchState {
+  explicit BatchState(int size) : remaining(size), done(0) {}
+
+  compat::Atomic<int> remaining;
+  Semaphore done;
+};
+
+void CountDown(BatchState* batch) {
+  if (batch->remaining.fetch_sub(1) == 1) batch->done.Post();
+}
+
+// Schedule a batch of requests and wait for them all to run.
+void BM_SchedulerThroughput(benchmark::State& state) {
+  static const int kBatchSize = 256;
+  ThreadPool pool((ThreadPool::Options()));
+  UniquePtr<scheduler::Scheduler> scheduler =
+      MakeScheduler(state.range(0), &pool);
+  for (auto _ : state) {
+    BatchState batch(kBatchSize);
+    for (int i = 0; i < kBatchSize; ++i) {
+      scheduler->Schedule(
+          new callback::CallbackValue1<BatchState*>(&batch, CountDown));
+    }
+    batch.done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetLabel(state.range(0) ? "pool" : "dedicated thread");
+}
+BENCHMARK(BM_SchedulerThroughput)->Arg(0)->Arg(1)->UseRealTime();
+
+// Many components, each with its own serial queue, posting work to one pool.
+// Before the shared pool each of these queues was a dedicated thread, so the
+// "threads" counter is compared against the number of queues.
+void BM_ThreadPoolManyQueues(benchmark::State& state) {
+  const int queue_count = static_cast<int>(state.range(0));
+  ThreadPool::Options options;
+  options.max_threads = 4;
+  ThreadPool pool(options);
+  std::vector<UniquePtr<SerialQueue>> queues;
+  for (int i = 0; i < queue_count; ++i) {
+    queues.push_back(MakeUnique<SerialQueue>(&pool));
+  }
+  for (auto _ : state) {
+    BatchState batch(queue_count);
+    for (int i = 0; i < queue_count; ++i) {
+      queues[i]->Post(
+          new callback::CallbackValue1<BatchState*>(&batch, CountDown));
+    }
+    batch.done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * queue_count);
+  state.counters["threads"] =
+      static_cast<double>(pool.peak_thread_count());
+  state.counters["queues"] = queue_count;
+  queues.clear();
+}
+BENCHMARK(BM_ThreadPoolManyQueues)->Arg(1)->Arg(8)->Arg(64)->UseRealTime();
+
+}  // namespace
+}  // namespace firebase
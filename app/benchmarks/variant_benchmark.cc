@@ -0,0 +1,157 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/variant.h"
+#include "app/src/include/firebase/variant_serialization.h"
+#include "app/src/variant_util.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace {
+
+// A database style key, long enough not to fit in the small string buffer.
+std::string MakeKey(int index) {
+  char key[32];
+  snprintf(key, sizeof(key), "-MhX2xyq8aZ3k%07d", index);
+  return key;
+}
+
+// A map of children that each look like a small database record.
+Variant MakeRecords(int count) {
+  Variant records = Variant::EmptyMap();
+  for (int i = 0; i < count; ++i) {
+    Variant record = Variant::EmptyMap();
+    record.map()["name"] = Variant::FromMutableString("A user name");
+    record.map()["score"] = Variant::FromInt64(i);
+    record.map()["ratio"] = Variant::FromDouble(i / 7.0);
+    record.map()["active"] = Variant::FromBool(i % 2 == 0);
+    records.map()[Variant::FromMutableString(MakeKey(i))] = record;
+  }
+  return records;
+}
+
+void BM_VariantCopyMap(benchmark::State& state) {
+  Variant records = MakeRecords(state.range(0));
+  for (auto _ : state) {
+    Variant copy(records);
+    benchmark::DoNotOptimize(&copy);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VariantCopyMap)->Range(8, 4096);
+
+// Build a map keyed with mutable strings (0) or interned strings (1).
+void BM_VariantBuildMap(benchmark::State& state) {
+  static const int kKeyCount = 1024;
+  std::vector<std::string> keys;
+  for (int i = 0; i < kKeyCount; ++i) keys.push_back(MakeKey(i));
+  bool interned = state.range(0) != 0;
+  for (auto _ : state) {
+    Variant map = Variant::EmptyMap();
+    for (int i = 0; i < kKeyCount; ++i) {
+      Variant key = interned ? Variant::FromInternedString(keys[i])
+                             : Variant::FromMutableString(keys[i]);
+      map.map()[key] = Variant::FromInt64(i);
+    }
+    benchmark::DoNotOptimize(&map);
+  }
+  state.SetItemsProcessed(state.iterations() * kKeyCount);
+  state.SetLabel(interned ? "interned keys" : "mutable keys");
+}
+BENCHMARK(BM_VariantBuildMap)->Arg(0)->Arg(1);
+
+// Look up children of a large map by name.
+void BM_VariantMapLookup(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  Variant records = MakeRecords(count);
+  std::vector<std::string> keys;
+  for (int i = 0; i < count; ++i) keys.push_back(MakeKey(i));
+  const std::map<Variant, Variant>& map = records.map();
+  int index = 0;
+  for (auto _ : state) {
+    auto it = map.find(Variant::FromStaticString(keys[index].c_str()));
+    benchmark::DoNotOptimize(it);
+    if (++index == count) index = 0;
+  }
+}
+BENCHMARK(BM_VariantMapLookup)->Range(8, 4096);
+
+void BM_VariantSerialize(benchmark::State& state) {
+  Variant records = MakeRecords(state.range(0));
+  std::vector<uint8_t> buffer;
+  for (auto _ : state) {
+    SerializeVariant(records, &buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_VariantSerialize)->Range(8, 4096);
+
+void BM_VariantDeserialize(benchmark::State& state) {
+  std::vector<uint8_t> buffer;
+  SerializeVariant(MakeRecords(state.range(0)), &buffer);
+  for (auto _ : state) {
+    Variant records;
+    DeserializeVariant(buffer, &records);
+    benchmark::DoNotOptimize(&records);
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_VariantDeserialize)->Range(8, 4096);
+
+// Read one field of one record in place, without deserializing.
+void BM_SerializedVariantChild(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  std::vector<uint8_t> buffer;
+  SerializeVariant(MakeRecords(count), &buffer);
+  std::string key = MakeKey(count / 2);
+  for (auto _ : state) {
+    SerializedVariant root = SerializedVariant::FromBuffer(buffer);
+    benchmark::DoNotOptimize(root.child(key).child("score").int64_value());
+  }
+}
+BENCHMARK(BM_SerializedVariantChild)->Range(8, 4096);
+
+void BM_VariantToJson(benchmark::State& state) {
+  Variant records = MakeRecords(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    std::string json = util::VariantToJson(records);
+    size = json.size();
+    benchmark::DoNotOptimize(json.data());
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_VariantToJson)->Range(8, 4096);
+
+void BM_JsonToVariant(benchmark::State& state) {
+  std::string json = util::VariantToJson(MakeRecords(state.range(0)));
+  for (auto _ : state) {
+    Variant records = util::JsonToVariant(json.c_str());
+    benchmark::DoNotOptimize(&records);
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_JsonToVariant)->Range(8, 4096);
+
+}  // namespace
+}  // namespace firebase
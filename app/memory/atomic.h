@@ -89,6 +89,11 @@ class Atomic {
   // Returns the value as observed before the operation.
   T fetch_sub(T arg);
 
+  // Atomically replaces the stored value with desired if it is equal to
+  // expected. Otherwise, loads the stored value into expected.
+  // Returns whether the value was replaced.
+  bool compare_exchange_strong(T& expected, T desired);  // NOLINT
+
  private:
 #if defined(_STLPORT_VERSION)
   T value_;
@@ -119,6 +124,12 @@ T Atomic<T>::fetch_sub(T arg) {
   return __atomic_fetch_sub(&value_, arg, __ATOMIC_SEQ_CST);
 }
 
+template <typename T>
+bool Atomic<T>::compare_exchange_strong(T& expected, T desired) {  // NOLINT
+  return __atomic_compare_exchange_n(&value_, &expected, desired, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
 #else  // defined(_STLPORT_VERSION)
 
 template <typename T>
@@ -141,6 +152,11 @@ T Atomic<T>::fetch_sub(T arg) {
   return value_.fetch_sub(arg);
 }
 
+template <typename T>
+bool Atomic<T>::compare_exchange_strong(T& expected, T desired) {  // NOLINT
+  return value_.compare_exchange_strong(expected, desired);
+}
+
 #endif  // defined(_STLPORT_VERSION)
 
 }  // namespace compat
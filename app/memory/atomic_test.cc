@@ -56,6 +56,17 @@ TEST(AtomicTest,
   EXPECT_THAT(atomic.load(), Eq(0));
 }
 
+TEST(AtomicTest, CompareExchangeReplacesValueOnlyIfExpected) {
+  Atomic<uint64_t> atomic(kValue);
+  uint64_t expected = kUpdatedValue;
+  EXPECT_FALSE(atomic.compare_exchange_strong(expected, 0));
+  EXPECT_THAT(expected, Eq(kValue));
+  EXPECT_THAT(atomic.load(), Eq(kValue));
+
+  EXPECT_TRUE(atomic.compare_exchange_strong(expected, kUpdatedValue));
+  EXPECT_THAT(atomic.load(), Eq(kUpdatedValue));
+}
+
 TEST(AtomicTest, NewValueIsProperlyAssignedWithAssignmentOperator) {
   Atomic<uint64_t> atomic;
   atomic = kValue;
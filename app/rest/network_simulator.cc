@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/rest/network_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "app/src/time.h"
+
+namespace firebase {
+namespace rest {
+
+namespace {
+
+// Stops a link that loses every transfer from retransmitting forever.
+const int kMaxRetransmissions = 16;
+
+}  // namespace
+
+NetworkSimulator::NetworkSimulator(const NetworkConditions& conditions)
+    : conditions_(conditions), random_(conditions.seed), link_free_ms_(0) {}
+
+NetworkSimulator::Transfer NetworkSimulator::Send(size_t bytes) {
+  MutexLock lock(mutex_);
+  Transfer transfer;
+  transfer.failed = Draw(conditions_.failure_rate);
+  transfer.delay_ms = DrawLatencyMs();
+  if (transfer.failed) return transfer;
+
+  for (int i = 0; i < kMaxRetransmissions && Draw(conditions_.loss_rate);
+       ++i) {
+    transfer.delay_ms += conditions_.retransmission_timeout_ms;
+  }
+
+  if (conditions_.bandwidth_bytes_per_second > 0) {
+    uint64_t now = internal::GetTimestamp();
+    uint64_t send_ms = static_cast<uint64_t>(
+        bytes * internal::kMillisecondsPerSecond /
+        conditions_.bandwidth_bytes_per_second);
+    link_free_ms_ = std::max(link_free_ms_, now) + send_ms;
+    transfer.delay_ms += static_cast<int64_t>(link_free_ms_ - now);
+  }
+  return transfer;
+}
+
+void NetworkSimulator::SetConditions(const NetworkConditions& conditions) {
+  MutexLock lock(mutex_);
+  conditions_ = conditions;
+  random_.seed(conditions.seed);
+}
+
+NetworkConditions NetworkSimulator::conditions() const {
+  MutexLock lock(mutex_);
+  return conditions_;
+}
+
+int64_t NetworkSimulator::DrawLatencyMs() {
+  double latency = static_cast<double>(conditions_.latency_ms);
+  double jitter = static_cast<double>(conditions_.jitter_ms);
+  if (jitter <= 0.0) return conditions_.latency_ms;
+  switch (conditions_.distribution) {
+    case kLatencyConstant:
+      break;
+    case kLatencyUniform:
+      latency = std::uniform_real_distribution<double>(
+          latency - jitter, latency + jitter)(random_);
+      break;
+    case kLatencyNormal:
+      latency = std::normal_distribution<double>(latency, jitter)(random_);
+      break;
+  }
+  return std::max<int64_t>(0, static_cast<int64_t>(std::llround(latency)));
+}
+
+bool NetworkSimulator::Draw(double probability) {
+  // Probabilities that are off draw nothing, so that they do not shift the
+  // numbers drawn for the others.
+  if (probability <= 0.0) return false;
+  return std::uniform_real_distribution<double>(0.0, 1.0)(random_) <
+         probability;
+}
+
+}  // namespace rest
+}  // namespace firebase
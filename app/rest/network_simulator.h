@@ -0,0 +1,118 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_APP_REST_NETWORK_SIMULATOR_H_
+#define FIREBASE_APP_REST_NETWORK_SIMULATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "app/src/include/firebase/internal/mutex.h"
+
+namespace firebase {
+namespace rest {
+
+// How the latency of each transfer is spread around NetworkConditions'
+// latency_ms.
+enum LatencyDistribution {
+  // Every transfer takes exactly latency_ms.
+  kLatencyConstant,
+  // Uniformly distributed in [latency_ms - jitter_ms, latency_ms + jitter_ms].
+  kLatencyUniform,
+  // Normally distributed around latency_ms, with a standard deviation of
+  // jitter_ms.
+  kLatencyNormal,
+};
+
+// The conditions of a simulated network link.
+struct NetworkConditions {
+  NetworkConditions()
+      : latency_ms(0),
+        distribution(kLatencyConstant),
+        jitter_ms(0),
+        bandwidth_bytes_per_second(0),
+        failure_rate(0.0),
+        loss_rate(0.0),
+        retransmission_timeout_ms(200),
+        seed(0) {}
+
+  // One-way latency of each transfer.
+  int64_t latency_ms;
+  LatencyDistribution distribution;
+  int64_t jitter_ms;
+  // Throughput of the link, shared by all the transfers on it. 0 means
+  // unlimited.
+  int64_t bandwidth_bytes_per_second;
+  // Probability that a transfer fails and the connection is lost.
+  double failure_rate;
+  // Probability that a transfer is lost and has to be sent again, after
+  // retransmission_timeout_ms.
+  double loss_rate;
+  int64_t retransmission_timeout_ms;
+  // Seeds the random numbers, so that runs with the same seed see the same
+  // latencies, losses and failures.
+  uint32_t seed;
+};
+
+// Decides how long transfers over a simulated network link take, and whether
+// they fail. It does not move any data: transports that use it delay and fail
+// the traffic they carry as it says.
+//
+// The random numbers are drawn in the order transfers are sent, so a single
+// threaded run is deterministic for a given seed. Transfers queue for the
+// bandwidth of the link in real time, so they take longer when they are sent
+// concurrently, as they would on a real link.
+//
+// This class is thread-safe.
+class NetworkSimulator {
+ public:
+  // The outcome of one transfer.
+  struct Transfer {
+    Transfer() : delay_ms(0), failed(false) {}
+
+    // How long after being sent the transfer arrives, or fails.
+    int64_t delay_ms;
+    bool failed;
+  };
+
+  explicit NetworkSimulator(const NetworkConditions& conditions);
+
+  // Sends `bytes` bytes over the link.
+  Transfer Send(size_t bytes);
+
+  // Changes the conditions of the link, e.g. to simulate the network dropping
+  // out. The random numbers are seeded again.
+  void SetConditions(const NetworkConditions& conditions);
+
+  NetworkConditions conditions() const;
+
+ private:
+  int64_t DrawLatencyMs();
+  bool Draw(double probability);
+
+  mutable Mutex mutex_;
+  NetworkConditions conditions_;
+  std::mt19937 random_;
+  // When the link is done sending the transfers queued on it, as returned by
+  // internal::GetTimestamp().
+  uint64_t link_free_ms_;
+};
+
+}  // namespace rest
+}  // namespace firebase
+
+#endif  // FIREBASE_APP_REST_NETWORK_SIMULATOR_H_
@@ -47,6 +47,10 @@ struct RequestOptions {
   std::map<std::string, std::string> header;
   // The maximum time in milliseconds to allow the request and response.
   int64_t timeout_ms;
+  // The content encodings to accept for the response body, such as "gzip".
+  // The transport decodes the body before passing it to the response. Leave
+  // empty to only accept an unencoded body.
+  std::string accept_encoding;
 
   // Set true to make the library display more verbose info to help debug. Does
   // not really affect the connection.
@@ -16,6 +16,8 @@
 
 #include "app/rest/response.h"
 
+#include <algorithm>
+#include <cctype>
 #include <string>
 
 #include "app/rest/util.h"
@@ -24,6 +26,21 @@
 namespace firebase {
 namespace rest {
 
+namespace {
+
+bool CharLessIgnoringCase(char lhs, char rhs) {
+  return tolower(static_cast<unsigned char>(lhs)) <
+         tolower(static_cast<unsigned char>(rhs));
+}
+
+}  // namespace
+
+bool Response::HeaderNameLess::operator()(const std::string& lhs,
+                                          const std::string& rhs) const {
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+                                      rhs.end(), CharLessIgnoringCase);
+}
+
 Response::Response()
     : status_(0),
       header_completed_(false),
@@ -54,13 +71,25 @@ bool Response::ProcessHeader(const char* buffer, size_t length) {
 
     // Below we update this response object by each header.
     // Update fetch_time_ from Date.
-    if (key == util::kDate) {
+    if (!HeaderNameLess()(key, util::kDate) &&
+        !HeaderNameLess()(util::kDate, key)) {
       fetch_time_ = curl_getdate(value.c_str(), nullptr /* unused */);
     }
   }
   return true;
 }
 
+void Response::Reset() {
+  status_ = 0;
+  header_completed_ = false;
+  body_completed_ = false;
+  sdk_error_code_ = 0;
+  fetch_time_ = 0;
+  header_.clear();
+  body_.clear();
+  body_cache_.clear();
+}
+
 bool Response::ProcessBody(const char* buffer, size_t length) {
   // Since buffer may NOT neccessarily end with \0, pass in length in the init.
   std::string body(buffer, length);
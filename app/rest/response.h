@@ -76,6 +76,10 @@ class Response : public Transfer {
     body_completed_ = false;
   }
 
+  // Clears the status, header and body, so that the response can be reused
+  // for another request.
+  virtual void Reset();
+
   // Getters.
   int status() const { return status_; }
   bool header_completed() const { return header_completed_; }
@@ -90,8 +94,9 @@ class Response : public Transfer {
     sdk_error_code_ = sdk_error_code;
   }
 
-  // Get the field value for the specific field name in header. If no such field
-  // is found in the header, return nullptr.
+  // Get the field value for the specific field name in header, which is
+  // matched ignoring case. If no such field is found in the header, return
+  // nullptr.
   const char* GetHeader(const char* name);
 
   // Get the body. If no body line has been received yet, return empty string.
@@ -111,8 +116,14 @@ class Response : public Transfer {
   int sdk_error_code_;
   // When we start to receive response.
   std::time_t fetch_time_;
+  // Orders header field names ignoring case, as HTTP field names are
+  // case-insensitive.
+  struct HeaderNameLess {
+    bool operator()(const std::string& lhs, const std::string& rhs) const;
+  };
+
   // Stores key-value pairs in header.
-  std::map<std::string, std::string> header_;
+  std::map<std::string, std::string, HeaderNameLess> header_;
   // Stores body in pieces and as a whole.
   std::vector<std::string> body_;
   mutable std::string body_cache_;
@@ -46,6 +46,11 @@ void ResponseBinary::GetBody(const char** data, size_t* size) const {
   *size = body_gunzip_cache_.length();
 }
 
+void ResponseBinary::Reset() {
+  Response::Reset();
+  body_gunzip_cache_.clear();
+}
+
 std::string ResponseBinary::Gunzip(const char* input_data,
                                    size_t input_size) const {
   uLongf result_length = zlib_.GzipUncompressedLength(
@@ -36,6 +36,8 @@ class ResponseBinary : public Response {
   // By default we don't use decompression.
   virtual void set_use_gunzip(bool use_gunzip) { use_gunzip_ = use_gunzip; }
 
+  void Reset() override;
+
  private:
   std::string Gunzip(const char* input_data, size_t input_size) const;
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/rest/network_simulator.h"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace rest {
+
+std::vector<NetworkSimulator::Transfer> SendMany(NetworkSimulator* network,
+                                                 int count) {
+  std::vector<NetworkSimulator::Transfer> transfers;
+  for (int i = 0; i < count; ++i) transfers.push_back(network->Send(100));
+  return transfers;
+}
+
+TEST(NetworkSimulatorTest, ConstantLatency) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 30;
+  NetworkSimulator network(conditions);
+  for (const auto& transfer : SendMany(&network, 10)) {
+    EXPECT_EQ(transfer.delay_ms, 30);
+    EXPECT_FALSE(transfer.failed);
+  }
+}
+
+TEST(NetworkSimulatorTest, JitterStaysInRange) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 30;
+  conditions.distribution = kLatencyUniform;
+  conditions.jitter_ms = 10;
+  NetworkSimulator network(conditions);
+  bool varied = false;
+  for (const auto& transfer : SendMany(&network, 100)) {
+    EXPECT_GE(transfer.delay_ms, 20);
+    EXPECT_LE(transfer.delay_ms, 40);
+    varied = varied || transfer.delay_ms != 30;
+  }
+  EXPECT_TRUE(varied);
+
+  // Normally distributed latencies are never negative.
+  conditions.latency_ms = 1;
+  conditions.distribution = kLatencyNormal;
+  network.SetConditions(conditions);
+  for (const auto& transfer : SendMany(&network, 100)) {
+    EXPECT_GE(transfer.delay_ms, 0);
+  }
+}
+
+TEST(NetworkSimulatorTest, SameSeedGivesSameTransfers) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 30;
+  conditions.distribution = kLatencyNormal;
+  conditions.jitter_ms = 10;
+  conditions.failure_rate = 0.2;
+  conditions.loss_rate = 0.2;
+  conditions.seed = 42;
+  NetworkSimulator first(conditions);
+  NetworkSimulator second(conditions);
+  std::vector<NetworkSimulator::Transfer> first_transfers =
+      SendMany(&first, 100);
+  std::vector<NetworkSimulator::Transfer> second_transfers =
+      SendMany(&second, 100);
+  int failures = 0;
+  for (size_t i = 0; i < first_transfers.size(); ++i) {
+    EXPECT_EQ(first_transfers[i].delay_ms, second_transfers[i].delay_ms);
+    EXPECT_EQ(first_transfers[i].failed, second_transfers[i].failed);
+    if (first_transfers[i].failed) ++failures;
+  }
+  EXPECT_GT(failures, 0);
+  EXPECT_LT(failures, 100);
+
+  // Setting the conditions seeds again.
+  first.SetConditions(conditions);
+  EXPECT_EQ(SendMany(&first, 1)[0].delay_ms, first_transfers[0].delay_ms);
+}
+
+TEST(NetworkSimulatorTest, FailuresAndLosses) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 10;
+  conditions.failure_rate = 1.0;
+  NetworkSimulator network(conditions);
+  EXPECT_TRUE(network.Send(100).failed);
+
+  // A link that loses everything gives up retransmitting eventually.
+  conditions.failure_rate = 0.0;
+  conditions.loss_rate = 1.0;
+  conditions.retransmission_timeout_ms = 100;
+  network.SetConditions(conditions);
+  NetworkSimulator::Transfer transfer = network.Send(100);
+  EXPECT_FALSE(transfer.failed);
+  EXPECT_GT(transfer.delay_ms, 1000);
+  EXPECT_LT(transfer.delay_ms, 10000);
+}
+
+TEST(NetworkSimulatorTest, TransfersShareBandwidth) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 10;
+  conditions.bandwidth_bytes_per_second = 1000;
+  NetworkSimulator network(conditions);
+  // 100 bytes take 100ms, and the second transfer waits for the first.
+  EXPECT_NEAR(network.Send(100).delay_ms, 110, 5);
+  EXPECT_NEAR(network.Send(100).delay_ms, 210, 10);
+}
+
+}  // namespace rest
+}  // namespace firebase
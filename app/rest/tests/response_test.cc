@@ -74,6 +74,23 @@ TEST(ResponseTest, ProcessHeaderField) {
   EXPECT_STREQ("value", response.GetHeader("key"));
 }
 
+TEST(ResponseTest, HeaderFieldNamesIgnoreCase) {
+  Response response;
+  ProcessHeader("etag: \"abc\"\r\n", &response);
+  ProcessHeader("CONTENT-TYPE: application/json\r\n", &response);
+  EXPECT_STREQ("\"abc\"", response.GetHeader("ETag"));
+  EXPECT_STREQ("\"abc\"", response.GetHeader("etag"));
+  EXPECT_STREQ("application/json", response.GetHeader("Content-Type"));
+  EXPECT_STREQ(nullptr, response.GetHeader("ETag2"));
+}
+
+TEST(ResponseTest, ProcessLowerCaseDateHeader) {
+  Response response;
+  ProcessHeader("date: Wed, 05 Jul 2017 15:55:19 GMT\r\n", &response);
+  response.MarkCompleted();
+  EXPECT_EQ(1499270119, response.fetch_time());
+}
+
 // Below test the fetch-time logic for various test cases.
 TEST(ResponseTest, ProcessDateHeaderValidDate) {
   Response response;
@@ -98,5 +115,32 @@ TEST(ResponseTest, ProcessDateHeaderMissing) {
   EXPECT_LT(1499270119, response.fetch_time());
 }
 
+TEST(ResponseTest, Reset) {
+  Response response;
+  ProcessHeader("HTTP/1.1 200 OK\r\n", &response);
+  ProcessHeader("ETag: first\r\n", &response);
+  ProcessHeader("\r\n", &response);
+  response.ProcessBody("first body", strlen("first body"));
+  response.MarkCompleted();
+  EXPECT_STREQ("first body", response.GetBody());
+
+  response.Reset();
+  EXPECT_EQ(0, response.status());
+  EXPECT_FALSE(response.header_completed());
+  EXPECT_FALSE(response.body_completed());
+  EXPECT_EQ(0, response.fetch_time());
+  EXPECT_STREQ(nullptr, response.GetHeader("ETag"));
+  EXPECT_STREQ("", response.GetBody());
+
+  // The response can be reused for another request.
+  ProcessHeader("HTTP/1.1 304 Not Modified\r\n", &response);
+  ProcessHeader("ETag: second\r\n", &response);
+  ProcessHeader("\r\n", &response);
+  response.MarkCompleted();
+  EXPECT_EQ(304, response.status());
+  EXPECT_STREQ("second", response.GetHeader("ETag"));
+  EXPECT_STREQ("", response.GetBody());
+}
+
 }  // namespace rest
 }  // namespace firebase
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/rest/transport_simulated.h"
+
+#include <cstdint>
+#include <string>
+
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/util.h"
+#include "app/src/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace rest {
+
+// Echoes the body of each request, and counts them.
+class EchoServer : public Transport {
+ public:
+  explicit EchoServer(int* requests) : requests_(requests) {}
+
+ private:
+  void PerformInternal(Request* request, Response* response,
+                       flatbuffers::unique_ptr<Controller>*) override {
+    ++*requests_;
+    std::string body;
+    request->ReadBodyIntoString(&body);
+    response->set_status(util::HttpSuccess);
+    response->ProcessBody(body.c_str(), body.size());
+    response->MarkCompleted();
+  }
+
+  int* requests_;
+};
+
+TEST(TransportSimulatedTest, DelaysRequestAndResponse) {
+  NetworkConditions conditions;
+  conditions.latency_ms = 20;
+  NetworkSimulator network(conditions);
+  int requests = 0;
+  TransportSimulated transport(
+      &network, flatbuffers::unique_ptr<Transport>(new EchoServer(&requests)));
+
+  Request request;
+  request.set_url("http://localhost/echo");
+  request.set_post_fields("hello");
+  Response response;
+  uint64_t start = internal::GetTimestamp();
+  transport.Perform(&request, &response, nullptr);
+  // One latency each way.
+  EXPECT_GE(internal::GetTimestamp() - start, 40);
+  EXPECT_EQ(requests, 1);
+  EXPECT_EQ(response.status(), util::HttpSuccess);
+  EXPECT_TRUE(response.body_completed());
+  EXPECT_STREQ(response.GetBody(), "hello");
+}
+
+TEST(TransportSimulatedTest, FailuresLookLikeTimeouts) {
+  NetworkConditions conditions;
+  conditions.failure_rate = 1.0;
+  NetworkSimulator network(conditions);
+  int requests = 0;
+  TransportSimulated transport(
+      &network, flatbuffers::unique_ptr<Transport>(new EchoServer(&requests)));
+
+  Request request;
+  request.set_url("http://localhost/echo");
+  Response response;
+  transport.Perform(&request, &response, nullptr);
+  // The request never reached the server.
+  EXPECT_EQ(requests, 0);
+  EXPECT_EQ(response.status(), util::HttpRequestTimeout);
+  EXPECT_FALSE(response.header_completed());
+  EXPECT_FALSE(response.body_completed());
+}
+
+}  // namespace rest
+}  // namespace firebase
@@ -25,8 +25,10 @@
 #include "app/src/assert.h"
 #include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/include/firebase/internal/platform.h"
+#include "app/src/mutex_profiler.h"
 #include "app/src/semaphore.h"
 #include "app/src/thread.h"
+#include "app/src/trace.h"
 #include "app/src/util.h"
 #include "curl/curl.h"
 
@@ -61,7 +63,8 @@ struct TransportCurlActionData {
         curl(nullptr),
         request(nullptr),
         response(nullptr),
-        controller(nullptr) {}
+        controller(nullptr),
+        trace_flow_id(0) {}
   // Transport that scheduled this request.
   // Required by:
   // * kRequestedActionPerform
@@ -91,6 +94,9 @@ struct TransportCurlActionData {
   // Pointer to the controller.
   // Optionally used by kRequestedActionPerform.
   ControllerCurl* controller;
+  // Links the trace events of scheduling and starting a transfer.
+  // Optionally used by kRequestedActionPerform.
+  uint64_t trace_flow_id;
 
   // Create a quit action.
   static TransportCurlActionData Quit() {
@@ -111,6 +117,7 @@ struct TransportCurlActionData {
     transport_action.request = request;
     transport_action.response = response;
     transport_action.controller = controller;
+    transport_action.trace_flow_id = FIREBASE_TRACE_NEW_FLOW_ID();
     return transport_action;
   }
 
@@ -314,6 +321,9 @@ int g_initialize_count = 0;
 // Mutex for Curl initialization.
 Mutex* g_initialize_mutex = new Mutex();
 
+// Name of CurlThread::mutex_ in contention statistics.
+const char kCurlThreadMutexName[] = "CurlThread::mutex_";
+
 }  // namespace
 
 void InitTransportCurl() {
@@ -473,6 +483,11 @@ bool BackgroundTransportCurl::PerformBackground(Request* request) {
           "set http body read callback data");
   CheckOk(curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, options.timeout_ms),
           "set http timeout milliseconds");
+  CheckOk(curl_easy_setopt(curl_, CURLOPT_ACCEPT_ENCODING,
+                           options.accept_encoding.empty()
+                               ? nullptr
+                               : options.accept_encoding.c_str()),
+          "set accepted content encodings");
 
   // curl library is using http2 as default, so need to specify this.
   CheckOk(curl_easy_setopt(curl_, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1),
@@ -610,7 +625,9 @@ CurlThread::~CurlThread() {
 }
 
 void CurlThread::ScheduleAction(const TransportCurlActionData& action_data) {
-  MutexLock lock(mutex_);
+  FIREBASE_TRACE_FLOW_BEGIN("curl", "CurlThread::ScheduleAction",
+                            action_data.trace_flow_id);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kCurlThreadMutexName);
   action_data_queue_.push_back(action_data);
   action_data_signal_.Post();
 }
@@ -674,7 +691,7 @@ bool CurlThread::GetNextAction(TransportCurlActionData* data,
   } else {
     action_data_signal_.TryWait();
   }
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kCurlThreadMutexName);
   if (action_data_queue_.empty()) {
     return false;
   }
@@ -685,13 +702,13 @@ bool CurlThread::GetNextAction(TransportCurlActionData* data,
 }
 
 void CurlThread::AddTransfer(BackgroundTransportCurl* transport) {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kCurlThreadMutexName);
   assert(transport->response());
   transport_by_response_[transport->response()] = transport;
 }
 
 BackgroundTransportCurl* CurlThread::RemoveTransfer(Response* response) {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kCurlThreadMutexName);
   auto it = transport_by_response_.find(response);
   if (it == transport_by_response_.end()) return nullptr;
   BackgroundTransportCurl* transport = it->second;
@@ -771,6 +788,8 @@ void CurlThread::ProcessRequests() {
       // Act on the data.
       switch (action_data.action) {
         case kRequestedActionPerform: {
+          FIREBASE_TRACE_SCOPE_FLOW_END("curl", "CurlThread::StartTransfer",
+                                        action_data.trace_flow_id);
           BackgroundTransportCurl* transport;
           {
             MutexLock lock(mutex_);
@@ -878,7 +897,10 @@ void CurlThread::ProcessRequests() {
     }
 
     int running_handles;
-    curl_multi_perform(curl_multi, &running_handles);
+    {
+      FIREBASE_TRACE_SCOPE("curl", "curl_multi_perform");
+      curl_multi_perform(curl_multi, &running_handles);
+    }
 
     if (expected_running_handles != running_handles) {
       // Some transfers completed.
@@ -887,6 +909,7 @@ void CurlThread::ProcessRequests() {
       while ((message = curl_multi_info_read(curl_multi, &message_count))) {
         switch (message->msg) {
           case CURLMSG_DONE: {
+            FIREBASE_TRACE_SCOPE("curl", "CurlThread::CompleteTransfer");
             CURL* handle = message->easy_handle;
 
             // Get the response object and clean up the easy handle.
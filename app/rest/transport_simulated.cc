@@ -0,0 +1,73 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/rest/transport_simulated.h"
+
+#include <utility>
+
+#include "app/rest/util.h"
+#include "app/src/time.h"
+
+namespace firebase {
+namespace rest {
+
+namespace {
+
+// Size of a request on the wire, not counting the request line's constant
+// parts.
+size_t RequestSize(Request* request) {
+  const RequestOptions& options = request->options();
+  size_t size = options.method.size() + options.url.size();
+  for (const auto& header : options.header) {
+    size += header.first.size() + header.second.size();
+  }
+  return size + request->GetPostFieldsSize();
+}
+
+void Fail(Request* request, Response* response) {
+  response->set_status(util::HttpRequestTimeout);
+  request->MarkFailed();
+  response->MarkFailed();
+}
+
+}  // namespace
+
+TransportSimulated::TransportSimulated(
+    NetworkSimulator* network, flatbuffers::unique_ptr<Transport> server)
+    : network_(network), server_(std::move(server)) {}
+
+void TransportSimulated::PerformInternal(
+    Request* request, Response* response,
+    flatbuffers::unique_ptr<Controller>* controller_out) {
+  NetworkSimulator::Transfer upload = network_->Send(RequestSize(request));
+  internal::Sleep(upload.delay_ms);
+  if (upload.failed) {
+    Fail(request, response);
+    return;
+  }
+
+  server_->Perform(request, response, controller_out);
+
+  const char* body = nullptr;
+  size_t body_size = 0;
+  response->GetBody(&body, &body_size);
+  NetworkSimulator::Transfer download = network_->Send(body_size);
+  internal::Sleep(download.delay_ms);
+  if (download.failed) Fail(request, response);
+}
+
+}  // namespace rest
+}  // namespace firebase
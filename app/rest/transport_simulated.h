@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_APP_REST_TRANSPORT_SIMULATED_H_
+#define FIREBASE_APP_REST_TRANSPORT_SIMULATED_H_
+
+#include "app/rest/network_simulator.h"
+#include "app/rest/transport_interface.h"
+#include "flatbuffers/stl_emulation.h"
+
+namespace firebase {
+namespace rest {
+
+// Carries requests to another transport, standing in for the server (e.g. a
+// TransportMock), over a simulated network. Each request and its response is
+// delayed, and may fail, as the NetworkSimulator decides. Use it to measure
+// how retries, backoff and concurrent requests behave on a slow or lossy
+// network without one:
+//
+//   NetworkConditions conditions;
+//   conditions.latency_ms = 50;
+//   conditions.failure_rate = 0.1;
+//   NetworkSimulator network(conditions);
+//   TransportSimulated transport(
+//       &network, flatbuffers::unique_ptr<Transport>(new TransportMock()));
+//
+// A failed transfer is reported as TransportCurl reports a timeout: the
+// response has status HttpRequestTimeout, and both the request and the
+// response are marked failed. It is reported once the failure is noticed
+// rather than after the request's timeout, so that benchmarks do not wait.
+class TransportSimulated : public Transport {
+ public:
+  // `network` must outlive the transport. Several transports can share one
+  // network, and its bandwidth.
+  TransportSimulated(NetworkSimulator* network,
+                     flatbuffers::unique_ptr<Transport> server);
+  ~TransportSimulated() override {}
+
+ private:
+  void PerformInternal(
+      Request* request, Response* response,
+      flatbuffers::unique_ptr<Controller>* controller_out) override;
+
+  NetworkSimulator* network_;
+  flatbuffers::unique_ptr<Transport> server_;
+};
+
+}  // namespace rest
+}  // namespace firebase
+
+#endif  // FIREBASE_APP_REST_TRANSPORT_SIMULATED_H_
@@ -534,6 +534,8 @@ void App::RegisterLibrary(const char* library, const char* version) {
 
 void App::SetDefaultConfigPath(const char* /* path */) {}
 
+void App::SetMaxBackgroundThreads(int /* max_threads */) {}
+
 void App::SetDataCollectionDefaultEnabled(bool enabled) {
   if (!app::GetMethodId(app::kSetDataCollectionDefaultEnabled)) {
     LogError(
@@ -30,6 +30,7 @@
 #include "app/src/include/firebase/version.h"
 #include "app/src/log.h"
 #include "app/src/semaphore.h"
+#include "app/src/thread_pool.h"
 #include "app/src/util.h"
 
 namespace firebase {
@@ -191,6 +192,11 @@ void App::SetDefaultConfigPath(const char* path) {
   }
 }
 
+void App::SetMaxBackgroundThreads(int max_threads) {
+  ThreadPool::SetSharedMaxThreads(
+      max_threads > 0 ? static_cast<size_t>(max_threads) : 1);
+}
+
 void App::LogHeartbeat() const {
   if (internal_ != nullptr && internal_->heartbeat_controller_) {
     internal_->heartbeat_controller_->LogHeartbeat();
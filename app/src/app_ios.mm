@@ -287,6 +287,8 @@ const char* App::GetUserAgent() { return app_common::GetUserAgent(); }
 
 void App::SetDefaultConfigPath(const char* path) {}
 
+void App::SetMaxBackgroundThreads(int max_threads) {}
+
 void App::SetDataCollectionDefaultEnabled(bool enabled) {
   GetPlatformApp().dataCollectionDefaultEnabled = (enabled ? YES : NO);
 }
@@ -17,22 +17,46 @@
 #include <string.h>
 
 #include <cstdint>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "app/google_services_generated.h"
 #include "app/google_services_resource.h"
+#include "app/memory/shared_ptr.h"
 #include "app/src/assert.h"
 #include "app/src/include/firebase/app.h"
 #include "app/src/include/firebase/internal/common.h"
+#include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/include/firebase/internal/platform.h"
 #include "app/src/log.h"
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
 
 namespace firebase {
-// static
-AppOptions* AppOptions::LoadFromJsonConfig(const char* config,  // NOLINT
-                                           AppOptions* options) {
+
+namespace {
+
+typedef SharedPtr<std::vector<uint8_t>> ConfigBuffer;
+
+// Parsing a config means parsing the schema first, which is slow, and
+// processes that create many Apps usually load the same config each time, so
+// the flatbuffers parsed from the most recent configs are kept.
+const size_t kMaxCachedConfigs = 8;
+Mutex* g_config_cache_mutex = new Mutex(Mutex::kModeNonRecursive);
+std::map<std::string, ConfigBuffer>* g_config_cache = nullptr;
+
+// Parse a JSON config into a verified GoogleServices flatbuffer. Returns an
+// empty buffer if the config could not be parsed.
+ConfigBuffer ParseJsonConfig(const char* config) {
+  {
+    MutexLock lock(*g_config_cache_mutex);
+    if (g_config_cache) {
+      auto it = g_config_cache->find(config);
+      if (it != g_config_cache->end()) return it->second;
+    }
+  }
+
   // Initialize flatbuffer parser.
   flatbuffers::IDLOptions fbs_options;
   // Skip irrelevant and unsupported fields.
@@ -44,7 +68,7 @@ AppOptions* AppOptions::LoadFromJsonConfig(const char* config,  // NOLINT
       reinterpret_cast<const char*>(fbs::google_services_resource_data);
   // Evaluate beforehand due to b/63396663.
   bool parse_schema_ok = parser.Parse(schema);
-  FIREBASE_ASSERT_MESSAGE_RETURN(nullptr, parse_schema_ok,
+  FIREBASE_ASSERT_MESSAGE_RETURN(ConfigBuffer(), parse_schema_ok,
                                  "Failed to load Firebase resource schema: %s.",
                                  parser.error_.c_str());
 
@@ -54,17 +78,39 @@ AppOptions* AppOptions::LoadFromJsonConfig(const char* config,  // NOLINT
         "Failed to parse Firebase config: %s. Check the config string "
         "passed to App::CreateFromJsonConfig()",
         parser.error_.c_str());
-    return nullptr;
+    return ConfigBuffer();
   }
   uint8_t* buffer_pointer = parser.builder_.GetBufferPointer();
-  flatbuffers::Verifier verifier(buffer_pointer, parser.builder_.GetSize());
+  size_t buffer_size = parser.builder_.GetSize();
+  flatbuffers::Verifier verifier(buffer_pointer, buffer_size);
   if (!firebase::fbs::VerifyGoogleServicesBuffer(verifier)) {
     LogError(
         "Failed to parse Firebase config: integrity check failed. Check "
         "the config string passed to App::CreateFromJsonConfig()");
-    return nullptr;
+    return ConfigBuffer();
   }
 
+  ConfigBuffer buffer = MakeShared<std::vector<uint8_t>>(
+      buffer_pointer, buffer_pointer + buffer_size);
+  MutexLock lock(*g_config_cache_mutex);
+  if (!g_config_cache) {
+    g_config_cache = new std::map<std::string, ConfigBuffer>();
+  } else if (g_config_cache->size() >= kMaxCachedConfigs) {
+    g_config_cache->clear();
+  }
+  (*g_config_cache)[config] = buffer;
+  return buffer;
+}
+
+}  // namespace
+
+// static
+AppOptions* AppOptions::LoadFromJsonConfig(const char* config,  // NOLINT
+                                           AppOptions* options) {
+  ConfigBuffer buffer = ParseJsonConfig(config);
+  if (!buffer) return nullptr;
+  const uint8_t* buffer_pointer = buffer->data();
+
   AppOptions* new_options = nullptr;
   if (options == nullptr) {
     new_options = new AppOptions();
@@ -80,6 +80,8 @@ const char* App::GetUserAgent() { return app_common::GetUserAgent(); }
 
 void App::SetDefaultConfigPath(const char* /* path */) {}
 
+void App::SetMaxBackgroundThreads(int /* max_threads */) {}
+
 void App::SetDataCollectionDefaultEnabled(bool /* enabled */) {}
 
 bool App::IsDataCollectionDefaultEnabled() const { return true; }
@@ -21,14 +21,19 @@
 #include "app/memory/shared_ptr.h"
 #include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/log.h"
+#include "app/src/mutex_profiler.h"
 #include "app/src/semaphore.h"
 #include "app/src/thread.h"
+#include "app/src/trace.h"
 
 namespace firebase {
 namespace callback {
 
 class CallbackEntry;
 
+// Name of the callback queue's mutex in contention statistics.
+static const char kQueueMutexName[] = "CallbackQueue::mutex_";
+
 class CallbackQueue : public std::list<SharedPtr<CallbackEntry>> {
  public:
   CallbackQueue() {}
@@ -48,7 +53,12 @@ class CallbackEntry {
   // callback_mutex_ is used to enforce a critical section for callback
   // execution and destruction.
   CallbackEntry(Callback* callback, Mutex* callback_mutex)
-      : callback_(callback), mutex_(callback_mutex), executing_(false) {}
+      : callback_(callback),
+        mutex_(callback_mutex),
+        executing_(false),
+        trace_flow_id_(FIREBASE_TRACE_NEW_FLOW_ID()) {
+    FIREBASE_TRACE_FLOW_BEGIN("callback", "AddCallback", trace_flow_id_);
+  }
 
   // Destroy the callback.  This blocks if the callback is currently
   // executing.
@@ -64,7 +74,11 @@ class CallbackEntry {
       executing_ = true;
     }
 
-    callback_->Run();
+    {
+      FIREBASE_TRACE_SCOPE_FLOW_END("callback", "Callback::Run",
+                                    trace_flow_id_);
+      callback_->Run();
+    }
 
     {
       MutexLock lock(*mutex_);
@@ -99,6 +113,8 @@ class CallbackEntry {
   Mutex* mutex_;
   // A flag set to true when callback_ is about to be called.
   bool executing_;
+  // Links the trace events of queueing and running the callback.
+  uint64_t trace_flow_id_;
 };
 
 // Dispatches a queue of callbacks.
@@ -124,7 +140,7 @@ class CallbackDispatcher {
   // to the entry which can be optionally be removed prior to dispatch.
   void* AddCallback(Callback* callback) {
     auto entry = MakeShared<CallbackEntry>(callback, &execution_mutex_);
-    MutexLock lock(*queue_.mutex());
+    FIREBASE_PROFILED_MUTEX_LOCK(lock, *queue_.mutex(), kQueueMutexName);
     queue_.push_back(entry);
     return entry.get();
   }
@@ -135,7 +151,7 @@ class CallbackDispatcher {
   // NOTE: This does not remove the callback from the execution queue.
   // The queue is flushed on a call to DispatchCallbacks().
   bool DisableCallback(void* callback_reference) {
-    MutexLock lock(*queue_.mutex());
+    FIREBASE_PROFILED_MUTEX_LOCK(lock, *queue_.mutex(), kQueueMutexName);
     CallbackEntry* callback_entry =
         static_cast<CallbackEntry*>(callback_reference);
     return callback_entry->DisableCallback();
@@ -249,7 +265,7 @@ void Terminate(bool flush_all) {
 }
 
 void* AddCallback(Callback* callback) {
-  MutexLock lock(*g_callback_mutex);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, *g_callback_mutex, "g_callback_mutex");
   Initialize();
   return g_callback_dispatcher->AddCallback(callback);
 }
@@ -326,6 +342,7 @@ void PollCallbacks() {
     g_callback_thread_id = Thread::CurrentId();
     g_callback_thread_id_initialized = true;
     // Execute callbacks.
+    FIREBASE_TRACE_SCOPE("callback", "PollCallbacks");
     int dispatched = g_callback_dispatcher->DispatchCallbacks();
     // +1 added to the references to remove as we added a reference in
     // InitializeIfInitialized().
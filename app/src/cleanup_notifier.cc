@@ -19,30 +19,38 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <cstdint>
 
 namespace firebase {
 
-Mutex *CleanupNotifier::cleanup_notifiers_by_owner_mutex_ = new Mutex();
-std::map<void *, CleanupNotifier *>
-    *CleanupNotifier::cleanup_notifiers_by_owner_;
-
-CleanupNotifier::CleanupNotifier() : cleaned_up_(false) {
-  MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-  if (!cleanup_notifiers_by_owner_) {
-    cleanup_notifiers_by_owner_ = new std::map<void *, CleanupNotifier *>();
-  }
+namespace {
+
+// Owners are spread over shards, each with its own lock, so that apps and
+// components created and destroyed on different threads rarely contend.
+const size_t kOwnerShardCount = 16;
+
+struct OwnerShard {
+  // Guards notifiers_by_owner.
+  Mutex mutex;
+  // Cleanup notifiers of the owner objects in this shard.
+  std::map<void *, CleanupNotifier *> notifiers_by_owner;
+};
+
+OwnerShard &GetOwnerShard(void *owner) {
+  // Never deleted, as notifiers may outlive static destructors.
+  static OwnerShard *shards = new OwnerShard[kOwnerShardCount];
+  // The low bits of heap pointers are mostly zero, so skip them.
+  size_t hash = reinterpret_cast<uintptr_t>(owner) >> 4;
+  return shards[hash % kOwnerShardCount];
 }
 
+}  // namespace
+
+CleanupNotifier::CleanupNotifier() : cleaned_up_(false) {}
+
 CleanupNotifier::~CleanupNotifier() {
   CleanupAll();
   UnregisterAllOwners();
-  {
-    MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-    if (cleanup_notifiers_by_owner_ && cleanup_notifiers_by_owner_->empty()) {
-      delete cleanup_notifiers_by_owner_;
-      cleanup_notifiers_by_owner_ = nullptr;
-    }
-  }
 }
 
 void CleanupNotifier::RegisterObject(void *object, CleanupCallback callback) {
@@ -74,35 +82,37 @@ void CleanupNotifier::CleanupAll() {
 }
 
 void CleanupNotifier::UnregisterAllOwners() {
-  MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-  while (owners_.begin() != owners_.end()) {
-    UnregisterOwner(this, owners_[0]);
+  std::vector<void *> owners;
+  {
+    MutexLock lock(owners_mutex_);
+    owners = owners_;
   }
+  for (void *owner : owners) UnregisterOwner(this, owner);
 }
 
 void CleanupNotifier::RegisterOwner(CleanupNotifier *notifier, void *owner) {
-  MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-  assert(cleanup_notifiers_by_owner_);
-  auto it = cleanup_notifiers_by_owner_->find(owner);
-  if (it != cleanup_notifiers_by_owner_->end()) UnregisterOwner(it);
-  (*cleanup_notifiers_by_owner_)[owner] = notifier;
+  OwnerShard &shard = GetOwnerShard(owner);
+  MutexLock lock(shard.mutex);
+  CleanupNotifier *&registered = shard.notifiers_by_owner[owner];
+  if (registered) {
+    MutexLock owners_lock(registered->owners_mutex_);
+    auto *owners = &registered->owners_;
+    auto owner_it = std::find(owners->begin(), owners->end(), owner);
+    assert(owner_it != owners->end());
+    owners->erase(owner_it);
+  }
+  registered = notifier;
+  MutexLock owners_lock(notifier->owners_mutex_);
   notifier->owners_.push_back(owner);
 }
 
 void CleanupNotifier::UnregisterOwner(CleanupNotifier *notifier, void *owner) {
-  MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-  assert(cleanup_notifiers_by_owner_);
-  auto it = cleanup_notifiers_by_owner_->find(owner);
-  if (it != cleanup_notifiers_by_owner_->end()) UnregisterOwner(it);
-}
-
-void CleanupNotifier::UnregisterOwner(
-    std::map<void *, CleanupNotifier *>::iterator it) {
-  MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-  assert(cleanup_notifiers_by_owner_);
-  void *owner = it->first;
-  CleanupNotifier *notifier = it->second;
-  cleanup_notifiers_by_owner_->erase(it);
+  OwnerShard &shard = GetOwnerShard(owner);
+  MutexLock lock(shard.mutex);
+  auto it = shard.notifiers_by_owner.find(owner);
+  if (it == shard.notifiers_by_owner.end() || it->second != notifier) return;
+  shard.notifiers_by_owner.erase(it);
+  MutexLock owners_lock(notifier->owners_mutex_);
   auto *owners = &notifier->owners_;
   auto owner_it = std::find(owners->begin(), owners->end(), owner);
   assert(owner_it != owners->end());
@@ -110,10 +120,10 @@ void CleanupNotifier::UnregisterOwner(
 }
 
 CleanupNotifier *CleanupNotifier::FindByOwner(void *owner) {
-  MutexLock lock(*cleanup_notifiers_by_owner_mutex_);
-  if (!cleanup_notifiers_by_owner_) return nullptr;
-  auto it = cleanup_notifiers_by_owner_->find(owner);
-  return it != cleanup_notifiers_by_owner_->end() ? it->second : nullptr;
+  OwnerShard &shard = GetOwnerShard(owner);
+  MutexLock lock(shard.mutex);
+  auto it = shard.notifiers_by_owner.find(owner);
+  return it != shard.notifiers_by_owner.end() ? it->second : nullptr;
 }
 
 // NOLINTNEXTLINE - allow namespace overridden
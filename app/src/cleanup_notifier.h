@@ -79,28 +79,24 @@ class CleanupNotifier {
   // Notifiers can be register to multiple owner objects.
   static void RegisterOwner(CleanupNotifier *notifier, void *owner);
 
-  // Unregister a notifier from an owner object.
+  // Unregister a notifier from an owner object. Does nothing if another
+  // notifier replaced it since.
   static void UnregisterOwner(CleanupNotifier *notifier, void *owner);
 
   // Unregister this notifier with all owner objects.
   void UnregisterAllOwners();
 
-  // Unregister a notifier from an owner object.
-  static void UnregisterOwner(std::map<void *, CleanupNotifier *>::iterator it);
-
  private:
   // Guards callbacks_ and cleaned_up_.
   Mutex mutex_;
   std::map<void *, CleanupCallback> callbacks_;
   bool cleaned_up_;
+  // Guards owners_.
+  Mutex owners_mutex_;
   // List of owners of this notifier.
-  // This is the inverse of cleanup_notifiers_by_owner_ for a notifier.
+  // This is the inverse of the owner shards (see cleanup_notifier.cc) for a
+  // notifier.
   std::vector<void *> owners_;
-
-  // Guards owners_ and cleanup_notifiers_by_owner_.
-  static Mutex *cleanup_notifiers_by_owner_mutex_;
-  // Global map of cleanup notifiers bucketed by owner object.
-  static std::map<void *, CleanupNotifier *> *cleanup_notifiers_by_owner_;
 };
 
 // Typed wrapper for CleanupNotifier. Helpful if you only need to clean
@@ -21,49 +21,34 @@
 namespace firebase {
 namespace internal {
 
+FunctionRegistry::FunctionRegistry() {
+  for (auto& function : registered_functions_) {
+    function.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
 bool FunctionRegistry::RegisterFunction(
     FunctionId id, RegisteredFunction registered_function) {
-  MutexLock lock(map_mutex_);
-  auto itr = registered_functions_.find(id);
-  if (itr != registered_functions_.end()) {
-    return false;
-  } else {
-    registered_functions_[id] = registered_function;
-    return true;
-  }
+  RegisteredFunction unbound = nullptr;
+  return registered_functions_[id].compare_exchange_strong(
+      unbound, registered_function, std::memory_order_acq_rel);
 }
 
 bool FunctionRegistry::UnregisterFunction(FunctionId id) {
-  MutexLock lock(map_mutex_);
-  auto itr = registered_functions_.find(id);
-  if (itr == registered_functions_.end()) {
-    return false;
-  } else {
-    registered_functions_.erase(itr, itr);
-    return true;
-  }
+  return registered_functions_[id].exchange(
+             nullptr, std::memory_order_acq_rel) != nullptr;
 }
 
 bool FunctionRegistry::FunctionExists(FunctionId id) {
-  MutexLock lock(map_mutex_);
-  auto itr = registered_functions_.find(id);
-  return itr != registered_functions_.end();
+  return registered_functions_[id].load(std::memory_order_acquire) !=
+         nullptr;
 }
 
 bool FunctionRegistry::CallFunction(FunctionId id, App* app, void* args,
                                     void* out) {
-  RegisteredFunction function;
-  {
-    std::map<FunctionId, RegisteredFunction>::iterator itr;
-    MutexLock lock(map_mutex_);
-    itr = registered_functions_.find(id);
-    if (itr != registered_functions_.end()) {
-      function = itr->second;
-    } else {
-      return false;
-    }
-  }
-  return function(app, args, out);
+  RegisteredFunction function =
+      registered_functions_[id].load(std::memory_order_acquire);
+  return function != nullptr && function(app, args, out);
 }
 
 }  // namespace internal
@@ -17,7 +17,7 @@
 #ifndef FIREBASE_APP_SRC_FUNCTION_REGISTRY_H_
 #define FIREBASE_APP_SRC_FUNCTION_REGISTRY_H_
 
-#include <map>
+#include <atomic>
 
 #include "app/src/include/firebase/internal/mutex.h"
 
@@ -35,10 +35,18 @@ enum FunctionId {
   FnAuthGetCurrentUserUid,
   FnAuthAddAuthStateListener,
   FnAuthRemoveAuthStateListener,
+  FnInstallationsGetIdAsync,
+  FnInstallationsGetTokenAsync,
+  // Number of identifiers, must be last.
+  FunctionIdCount,
 };
 
 // Class for providing a generic way for firebase libraries to expose their
 // methods to each other, without requiring a link dependency.
+//
+// Functions are looked up on hot paths, such as every database connection
+// asking auth for a token, so no method takes a lock: each identifier has
+// its own atomic slot.
 class FunctionRegistry {
  public:
   // Template for the functions we pass around.  They will always accept a
@@ -49,22 +57,28 @@ class FunctionRegistry {
   typedef bool (*RegisteredFunction)(::firebase::App* app, void* args,
                                      void* out);
 
-  // Add a function to the registry, bound to a unique identifier.  Asserts
-  // if a function is already bound to that identifier.
+  FunctionRegistry();
+
+  FunctionRegistry(const FunctionRegistry&) = delete;
+  FunctionRegistry& operator=(const FunctionRegistry&) = delete;
+
+  // Add a function to the registry, bound to a unique identifier.  Returns
+  // false if a function is already bound to that identifier.
   bool RegisterFunction(FunctionId id, RegisteredFunction registered_function);
-  // Remove a function from the registry, or asserts if nothing is bound to that
-  // identifier.
+  // Remove a function from the registry.  Returns false if nothing is bound
+  // to that identifier.
   bool UnregisterFunction(FunctionId id);
   // Checks if an identifier has a function bound to it.
   bool FunctionExists(FunctionId id);
   // Executes a function if possible.  Returns false if the identifier is
   // is unbound, or if the function fails.  Results are returned via the "out"
-  // pointer.
+  // pointer.  The function may still be called after it was unregistered on
+  // another thread, so functions must handle their component being gone.
   bool CallFunction(FunctionId id, App* app, void* args, void* out);
 
  private:
-  std::map<FunctionId, RegisteredFunction> registered_functions_;
-  Mutex map_mutex_;
+  // Function bound to each identifier, or nullptr.
+  std::atomic<RegisteredFunction> registered_functions_[FunctionIdCount];
 };
 
 }  // namespace internal
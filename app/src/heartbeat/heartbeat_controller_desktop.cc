@@ -33,6 +33,7 @@
 #include "app/src/heartbeat/heartbeat_storage_desktop.h"
 #include "app/src/logger.h"
 #include "app/src/semaphore.h"
+#include "app/src/thread_pool.h"
 #include "app/src/variant_util.h"
 
 namespace firebase {
@@ -54,7 +55,7 @@ HeartbeatController::HeartbeatController(const std::string& app_id,
                                          const Logger& logger,
                                          const DateProvider& date_provider)
     : storage_(app_id, logger),
-      scheduler_(),
+      scheduler_(ThreadPool::Shared()),
       last_logged_date_(""),
       date_provider_(date_provider) {}
 
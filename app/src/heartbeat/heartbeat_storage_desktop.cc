@@ -16,12 +16,14 @@
 
 #include "app/src/heartbeat/heartbeat_storage_desktop.h"
 
+#include <string.h>
+
 #include <fstream>
-#include <regex>
 #include <vector>
 
 #include "app/logged_heartbeats_generated.h"
 #include "app/src/filesystem.h"
+#include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/logger.h"
 
 namespace firebase {
@@ -41,21 +43,39 @@ namespace {
 const char kHeartbeatDir[] = "firebase-heartbeat";
 const char kHeartbeatFilenamePrefix[] = "heartbeats-";
 
-std::string CreateFilename(const std::string& app_id, const Logger& logger) {
-  std::string error;
-  std::string app_dir =
-      AppDataDir(kHeartbeatDir, /*should_create=*/true, &error);
-  if (!error.empty()) {
-    logger.LogError(error.c_str());
-    return "";
+// Symbols that might not be allowed in filenames.
+const char kFilenameSymbols[] = "/\\?%*:|\"<>.,;=";
+
+// Returns the directory heartbeats are stored in, creating it if needed. The
+// directory is shared by all apps, so it is only looked up once.
+std::string GetHeartbeatDir(const Logger& logger) {
+  static Mutex* dir_mutex = new Mutex(Mutex::kModeNonRecursive);
+  static std::string* heartbeat_dir = new std::string();
+  MutexLock lock(*dir_mutex);
+  if (heartbeat_dir->empty()) {
+    std::string error;
+    std::string app_dir =
+        AppDataDir(kHeartbeatDir, /*should_create=*/true, &error);
+    if (!error.empty()) {
+      logger.LogError(error.c_str());
+      return "";
+    }
+    *heartbeat_dir = app_dir;
   }
+  return *heartbeat_dir;
+}
+
+std::string CreateFilename(const std::string& app_id, const Logger& logger) {
+  std::string app_dir = GetHeartbeatDir(logger);
   if (app_dir.empty()) {
     return "";
   }
 
-  // Remove any symbols from app_id that might not be allowed in filenames.
-  auto app_id_without_symbols =
-      std::regex_replace(app_id, std::regex("[/\\\\?%*:|\"<>.,;=]"), "");
+  std::string app_id_without_symbols;
+  app_id_without_symbols.reserve(app_id.size());
+  for (char c : app_id) {
+    if (strchr(kFilenameSymbols, c) == nullptr) app_id_without_symbols += c;
+  }
   // Note: fstream will convert / to \ if needed on windows.
   return app_dir + "/" + kHeartbeatFilenamePrefix + app_id_without_symbols;
 }
@@ -63,15 +83,7 @@ std::string CreateFilename(const std::string& app_id, const Logger& logger) {
 }  // namespace
 HeartbeatStorageDesktop::HeartbeatStorageDesktop(const std::string& app_id,
                                                  const Logger& logger)
-    : filename_(CreateFilename(app_id, logger)), logger_(logger) {
-  // Ensure the file exists, otherwise the first attempt to read it would
-  // fail.
-  std::ofstream file(filename_, std::ios_base::app);
-
-  if (!file) {
-    logger_.LogError("Unable to open '%s'.", filename_.c_str());
-  }
-}
+    : filename_(CreateFilename(app_id, logger)), logger_(logger) {}
 
 // Max size is arbitrary, just making sure that there is a sane limit.
 static const int kMaxBufferSize = 1024 * 500;
@@ -80,8 +92,15 @@ bool HeartbeatStorageDesktop::ReadTo(LoggedHeartbeats& heartbeats_output) {
   // Open the file and seek to the end
   std::ifstream file(filename_, std::ios_base::binary | std::ios_base::ate);
   if (!file) {
-    logger_.LogError("Unable to open '%s' for reading.", filename_.c_str());
-    return false;
+    // The file is created the first time it is needed, rather than when the
+    // storage is constructed, to keep App creation cheap.
+    std::ofstream new_file(filename_, std::ios_base::app);
+    if (!new_file) {
+      logger_.LogError("Unable to open '%s' for reading.", filename_.c_str());
+      return false;
+    }
+    heartbeats_output = LoggedHeartbeats();
+    return true;
   }
   // Current position in file is file size. Fail if file is too large.
   std::streamsize buffer_len = file.tellg();
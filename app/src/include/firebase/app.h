@@ -708,6 +708,11 @@ class App {
   // Note - when setting this, make sure to end the path with the appropriate
   // path separator!
   static void SetDefaultConfigPath(const char* path);
+
+  // On desktop, background work for all Apps runs on a shared pool of worker
+  // threads. This sets the maximum number of threads in that pool. Has no
+  // effect on other platforms.
+  static void SetMaxBackgroundThreads(int max_threads);
 #endif  // INTERNAL_EXPERIMENTAL
 
 #ifdef INTERNAL_EXPERIMENTAL
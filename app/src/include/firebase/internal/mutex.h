@@ -47,6 +47,10 @@ class Mutex {
   // Acquires the lock for this mutex, blocking until it is available.
   void Acquire();
 
+  // Acquires the lock for this mutex if it is available, without blocking.
+  // Returns whether the lock was acquired.
+  bool TryAcquire();
+
   // Releases the lock for this mutex acquired by a previous `Acquire()` call.
   void Release();
 
@@ -425,9 +425,10 @@ class Variant {
   ///
   /// @return The Variant's type.
   Type type() const {
-    // To avoid breaking user code, alias the small string type to mutable
-    // string.
-    if (type_ == kInternalTypeSmallString) {
+    // To avoid breaking user code, alias the small and interned string types
+    // to mutable string.
+    if (type_ == kInternalTypeSmallString ||
+        type_ == kInternalTypeInternedString) {
       return kTypeMutableString;
     }
 
@@ -482,7 +483,8 @@ class Variant {
   /// @note No matter which type of string the Variant contains, you can read
   /// its value via string_value().
   bool is_string() const {
-    return is_static_string() || is_mutable_string() || is_small_string();
+    return is_static_string() || is_mutable_string() || is_small_string() ||
+           is_interned_string();
   }
 
   /// @brief Get whether this Variant contains a static blob.
@@ -576,8 +578,10 @@ class Variant {
   /// @note If the Variant is not one of the two String types, this will assert.
   std::string& mutable_string() {
     if (type_ == kInternalTypeStaticString ||
-        type_ == kInternalTypeSmallString) {
-      // Automatically promote a static or small string to a mutable string.
+        type_ == kInternalTypeSmallString ||
+        type_ == kInternalTypeInternedString) {
+      // Automatically promote a static, small or interned string to a mutable
+      // string.
       set_mutable_string(string_value(), false);
     }
     assert_is_type(kTypeMutableString);
@@ -698,10 +702,21 @@ class Variant {
       return value_.mutable_string_value->c_str();
     else if (type_ == kInternalTypeStaticString)
       return value_.static_string_value;
+    else if (type_ == kInternalTypeInternedString)
+      return value_.interned_string_value;
     else  // if (type_ == kInternalTypeSmallString)
       return value_.small_string;
   }
 
+  /// @brief Get the length of a string, not including the null terminator.
+  ///
+  /// A mutable string may contain null characters, in which case this is
+  /// longer than strlen(string_value()).
+  ///
+  /// @note If the Variant is not of StaticString or MutableString type, this
+  /// will assert.
+  size_t string_size() const;
+
   /// @brief Const accessor for a Variant containing a string.
   ///
   /// @note Unlike the non-const accessor, this accessor cannot "promote" a
@@ -1030,6 +1045,32 @@ class Variant {
     return v;
   }
 
+  /// @brief Return a Variant containing an interned copy of a string.
+  ///
+  /// All interned copies of the same string share a single reference counted
+  /// buffer for as long as any of them exist, so copying the Variant, or
+  /// interning the same string again, does not allocate. This is useful for
+  /// strings that are repeated many times, such as the keys of large maps.
+  /// Strings short enough to be stored inside the Variant are not interned.
+  ///
+  /// The Variant's type will be MutableString. Calling the non-const
+  /// mutable_string() makes a private copy of the string.
+  ///
+  /// @param[in] value String value to intern.
+  ///
+  /// @returns A Variant containing the interned string.
+  static Variant FromInternedString(const std::string& value) {
+    return FromInternedString(value.data(), value.size());
+  }
+
+  /// @brief Return a Variant containing an interned copy of a string.
+  ///
+  /// @param[in] value Pointer to the characters of the string to intern.
+  /// @param[in] size Number of characters in the string.
+  ///
+  /// @returns A Variant containing the interned string.
+  static Variant FromInternedString(const char* value, size_t size);
+
   /// @brief Get the human-readable type name of a Variant type.
   ///
   /// @param[in] type Variant type to describe.
@@ -1069,6 +1110,9 @@ class Variant {
     // A c string stored in the Variant internal data blob as opposed to be
     // newed as a std::string. Max size is 16 bytes on x64 and 8 bytes on x86.
     kInternalTypeSmallString = kTypeMutableBlob + 1,
+    // A c string in a reference counted buffer shared by every Variant holding
+    // an interned copy of the same string.
+    kInternalTypeInternedString,
     // Not a valid type. Used to get the total number of Variant types.
     kMaxTypeValue,
   };
@@ -1108,6 +1152,11 @@ class Variant {
   // Get whether this Variant contains a small string.
   bool is_small_string() const { return type_ == kInternalTypeSmallString; }
 
+  // Get whether this Variant contains an interned string.
+  bool is_interned_string() const {
+    return type_ == kInternalTypeInternedString;
+  }
+
   // Current type contained in this Variant.
   InternalType type_;
 
@@ -1124,6 +1173,8 @@ class Variant {
     double double_value;
     bool bool_value;
     const char* static_string_value;
+    // Points into the shared buffer of an interned string.
+    const char* interned_string_value;
     std::string* mutable_string_value;
     std::vector<Variant>* vector_value;
     std::map<Variant, Variant>* map_value;
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_APP_SRC_INCLUDE_FIREBASE_VARIANT_SERIALIZATION_H_
+#define FIREBASE_APP_SRC_INCLUDE_FIREBASE_VARIANT_SERIALIZATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "firebase/variant.h"
+
+namespace firebase {
+
+namespace internal {
+class SerializedVariantHelper;
+}  // namespace internal
+
+/// @brief Serialize a Variant into a compact, versioned binary buffer.
+///
+/// The buffer can be turned back into a Variant with DeserializeVariant(), or
+/// read in place with SerializedVariant, which is much faster than a round
+/// trip through JSON for large Variant trees. The format is stable across
+/// releases of this SDK: newer releases can read buffers written by older
+/// ones.
+///
+/// Map keys must be strings, and maps and vectors may be nested at most 256
+/// deep. Variants that don't meet these limits can't be serialized.
+///
+/// @param[in] variant The Variant to serialize.
+/// @param[out] output Receives the serialized buffer, replacing any previous
+/// contents.
+///
+/// @returns true if the Variant was serialized, false otherwise.
+bool SerializeVariant(const Variant& variant, std::vector<uint8_t>* output);
+
+/// @brief Read a Variant from a buffer written by SerializeVariant().
+///
+/// Strings and blobs are copied, so the result does not refer to the buffer.
+///
+/// The whole buffer is checked before it is read, so a truncated or corrupted
+/// buffer is rejected rather than read out of bounds.
+///
+/// @param[in] data The serialized buffer.
+/// @param[in] size The size of the serialized buffer in bytes.
+/// @param[out] output Receives the Variant read from the buffer.
+///
+/// @returns true if the buffer was read, false if it was not written by a
+/// compatible version of SerializeVariant() or is corrupt.
+bool DeserializeVariant(const uint8_t* data, size_t size, Variant* output);
+
+/// @brief Read a Variant from a buffer written by SerializeVariant().
+///
+/// @see DeserializeVariant(const uint8_t*, size_t, Variant*)
+inline bool DeserializeVariant(const std::vector<uint8_t>& data,
+                               Variant* output) {
+  return DeserializeVariant(data.data(), data.size(), output);
+}
+
+/// @brief A read-only view of a value in a buffer written by
+/// SerializeVariant().
+///
+/// A SerializedVariant reads the value straight out of the buffer without
+/// converting it to a Variant, so it is cheap to create and to copy, and
+/// looking up a single value in a large tree does not need to read the rest of
+/// the tree. The buffer must stay alive and unmodified for as long as any view
+/// into it is in use.
+///
+/// Accessors for a type other than the view's own type return a default value
+/// rather than asserting.
+class SerializedVariant {
+ public:
+  /// @brief Create a view of a null value.
+  SerializedVariant();
+
+  /// @brief Create a view of the root value of a serialized buffer.
+  ///
+  /// @note The buffer is only checked for a valid header, so that creating a
+  /// view stays cheap for large buffers. Don't use this to read a buffer that
+  /// may have been corrupted or come from an untrusted source; use
+  /// DeserializeVariant() instead.
+  ///
+  /// @param[in] data The serialized buffer.
+  /// @param[in] size The size of the serialized buffer in bytes.
+  ///
+  /// @returns A view of the root value, or an invalid view of a null value if
+  /// the buffer was not written by a compatible version of SerializeVariant().
+  static SerializedVariant FromBuffer(const uint8_t* data, size_t size);
+
+  /// @brief Create a view of the root value of a serialized buffer.
+  static SerializedVariant FromBuffer(const std::vector<uint8_t>& data) {
+    return FromBuffer(data.data(), data.size());
+  }
+
+  /// @brief Get whether this view was created from a buffer written by a
+  /// compatible version of SerializeVariant().
+  bool is_valid() const { return valid_; }
+
+  /// @brief Get the type of the value.
+  ///
+  /// Strings are reported as kTypeStaticString and blobs as kTypeStaticBlob,
+  /// since they point into the buffer.
+  Variant::Type type() const;
+
+  /// @brief Get whether the value is null.
+  bool is_null() const { return type() == Variant::kTypeNull; }
+
+  /// @brief Get whether the value is a string.
+  bool is_string() const { return type() == Variant::kTypeStaticString; }
+
+  /// @brief Get whether the value is a vector.
+  bool is_vector() const { return type() == Variant::kTypeVector; }
+
+  /// @brief Get whether the value is a map.
+  bool is_map() const { return type() == Variant::kTypeMap; }
+
+  /// @brief Get the value as an integer.
+  int64_t int64_value() const;
+
+  /// @brief Get the value as a double.
+  double double_value() const;
+
+  /// @brief Get the value as a bool.
+  bool bool_value() const;
+
+  /// @brief Get the null-terminated characters of a string, stored in the
+  /// buffer. Returns an empty string if the value is not a string.
+  const char* string_value() const;
+
+  /// @brief Get the length of a string, not including the null terminator.
+  size_t string_size() const;
+
+  /// @brief Get the bytes of a blob, stored in the buffer.
+  const uint8_t* blob_data() const;
+
+  /// @brief Get the size of a blob in bytes.
+  size_t blob_size() const;
+
+  /// @brief Get the number of elements in a vector or entries in a map, or 0
+  /// for any other type.
+  size_t size() const;
+
+  /// @brief Get an element of a vector.
+  ///
+  /// @returns A view of the element, or of a null value if the index is out of
+  /// range or the value is not a vector.
+  SerializedVariant element(size_t index) const;
+
+  /// @brief Get the key of a map entry. Entries are sorted by key.
+  ///
+  /// @returns The null-terminated key, stored in the buffer, or an empty
+  /// string if the index is out of range or the value is not a map.
+  const char* key(size_t index) const;
+
+  /// @brief Get the value of a map entry. Entries are sorted by key.
+  ///
+  /// @returns A view of the value, or of a null value if the index is out of
+  /// range or the value is not a map.
+  SerializedVariant value(size_t index) const;
+
+  /// @brief Look up the value of a map entry by key, using a binary search.
+  ///
+  /// @returns A view of the value, or of a null value if there is no entry
+  /// with the given key or the value is not a map.
+  SerializedVariant child(const char* key) const;
+
+  /// @brief Look up the value of a map entry by key, using a binary search.
+  SerializedVariant child(const std::string& key) const {
+    return child(key.c_str());
+  }
+
+  /// @brief Convert the value, and everything below it, to a Variant.
+  ///
+  /// Strings and blobs are copied, so the result does not refer to the buffer.
+  Variant ToVariant() const;
+
+ private:
+  friend class internal::SerializedVariantHelper;
+
+  // Space for the reference into the buffer. Its layout is private to the
+  // implementation.
+  union Storage {
+    void* alignment;
+    uint8_t bytes[4 * sizeof(void*)];
+  };
+
+  Storage reference_;
+  bool valid_;
+};
+
+}  // namespace firebase
+
+#endif  // FIREBASE_APP_SRC_INCLUDE_FIREBASE_VARIANT_SERIALIZATION_H_
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/mutex_profiler.h"
+
+#include "app/src/time.h"
+
+namespace firebase {
+namespace internal {
+
+namespace {
+
+// All sites that have been reached, newest first.
+struct SiteList {
+  SiteList() : mutex(Mutex::kModeNonRecursive), head(nullptr) {}
+
+  Mutex mutex;
+  MutexSite* head;
+};
+
+// Never destroyed, so that sites can register during static initialization and
+// be reached during static destruction.
+SiteList* GetSiteList() {
+  static SiteList* site_list = new SiteList();
+  return site_list;
+}
+
+uint64_t TicksToNanoseconds(uint64_t ticks) {
+  return static_cast<uint64_t>(static_cast<double>(ticks) *
+                               Timer::GetTickPeriod() * kNanosecondsPerSecond);
+}
+
+}  // namespace
+
+compat::Atomic<int> MutexProfiler::enabled_;
+
+void MutexProfiler::SetEnabled(bool enabled) {
+  // Make sure the tick period is known before any lock reads the timer.
+  Timer::InitializeTickPeriod();
+  enabled_.store(enabled ? 1 : 0);
+}
+
+void MutexProfiler::ReportStats(MutexStatsCallback callback, void* user_data) {
+  SiteList* site_list = GetSiteList();
+  MutexSite* head;
+  {
+    MutexLock lock(site_list->mutex);
+    head = site_list->head;
+  }
+  // Sites are only ever added to the front of the list, so it can be walked
+  // without holding the lock, and the callback can lock profiled mutexes.
+  for (MutexSite* site = head; site; site = site->next_) {
+    MutexStats stats;
+    stats.mutex_name = site->mutex_name_;
+    stats.call_site = site->call_site_;
+    stats.acquisitions = site->acquisitions_.load();
+    stats.contended_acquisitions = site->contended_acquisitions_.load();
+    stats.total_wait_ns = TicksToNanoseconds(site->total_wait_ticks_.load());
+    stats.max_wait_ns = TicksToNanoseconds(site->max_wait_ticks_.load());
+    stats.total_hold_ns = TicksToNanoseconds(site->total_hold_ticks_.load());
+    stats.max_hold_ns = TicksToNanoseconds(site->max_hold_ticks_.load());
+    callback(stats, user_data);
+  }
+}
+
+void MutexProfiler::ResetStats() {
+  SiteList* site_list = GetSiteList();
+  MutexLock lock(site_list->mutex);
+  for (MutexSite* site = site_list->head; site; site = site->next_) {
+    site->acquisitions_.store(0);
+    site->contended_acquisitions_.store(0);
+    site->total_wait_ticks_.store(0);
+    site->max_wait_ticks_.store(0);
+    site->total_hold_ticks_.store(0);
+    site->max_hold_ticks_.store(0);
+  }
+}
+
+MutexSite::MutexSite(const char* mutex_name, const char* call_site)
+    : mutex_name_(mutex_name), call_site_(call_site), next_(nullptr) {
+  SiteList* site_list = GetSiteList();
+  MutexLock lock(site_list->mutex);
+  next_ = site_list->head;
+  site_list->head = this;
+}
+
+void MutexSite::RecordAcquire(bool contended, uint64_t wait_ticks) {
+  acquisitions_.fetch_add(1);
+  if (contended) contended_acquisitions_.fetch_add(1);
+  total_wait_ticks_.fetch_add(wait_ticks);
+  UpdateMax(&max_wait_ticks_, wait_ticks);
+}
+
+void MutexSite::RecordRelease(uint64_t hold_ticks) {
+  total_hold_ticks_.fetch_add(hold_ticks);
+  UpdateMax(&max_hold_ticks_, hold_ticks);
+}
+
+void MutexSite::UpdateMax(compat::Atomic<uint64_t>* max, uint64_t value) {
+  uint64_t current = max->load();
+  while (value > current && !max->compare_exchange_strong(current, value)) {
+  }
+}
+
+void ProfiledMutexLock::AcquireProfiled(MutexSite* site) {
+  site_ = site;
+  uint64_t start_ticks = Timer::GetTicks();
+  bool contended = !mutex_->TryAcquire();
+  if (contended) mutex_->Acquire();
+  acquired_ticks_ = Timer::GetTicks();
+  site_->RecordAcquire(contended, acquired_ticks_ - start_ticks);
+}
+
+void ProfiledMutexLock::RecordRelease() {
+  site_->RecordRelease(Timer::GetTicks() - acquired_ticks_);
+}
+
+}  // namespace internal
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_APP_SRC_MUTEX_PROFILER_H_
+#define FIREBASE_APP_SRC_MUTEX_PROFILER_H_
+
+#include <stdint.h>
+
+#include "app/memory/atomic.h"
+#include "app/src/include/firebase/internal/mutex.h"
+
+namespace firebase {
+namespace internal {
+
+// Contention statistics for one call site that locks a mutex.
+struct MutexStats {
+  // Name of the mutex, e.g. "Scheduler::request_mutex_".
+  const char* mutex_name;
+  // Name of the function that locks the mutex.
+  const char* call_site;
+  // Number of times the mutex was locked at this call site.
+  uint64_t acquisitions;
+  // Number of those times the mutex was already held by another thread.
+  uint64_t contended_acquisitions;
+  // Time spent waiting for the mutex.
+  uint64_t total_wait_ns;
+  uint64_t max_wait_ns;
+  // Time the mutex was held for.
+  uint64_t total_hold_ns;
+  uint64_t max_hold_ns;
+};
+
+// Called once for each call site by MutexProfiler::ReportStats().
+typedef void (*MutexStatsCallback)(const MutexStats& stats, void* user_data);
+
+// Records how long threads wait for and hold mutexes at call sites that lock
+// them with FIREBASE_PROFILED_MUTEX_LOCK.
+//
+// Profiling is off by default, in which case a profiled lock costs one extra
+// atomic load over MutexLock.
+class MutexProfiler {
+ public:
+  // Start or stop recording statistics. Statistics already recorded are kept.
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled() { return enabled_.load() != 0; }
+
+  // Pass the statistics of every call site that has been reached to the
+  // callback, in no particular order.
+  static void ReportStats(MutexStatsCallback callback, void* user_data);
+
+  // Clear all recorded statistics.
+  static void ResetStats();
+
+ private:
+  static compat::Atomic<int> enabled_;
+};
+
+// Statistics for one call site. Sites are created as function-local statics by
+// FIREBASE_PROFILED_MUTEX_LOCK, and are never destroyed.
+class MutexSite {
+ public:
+  MutexSite(const char* mutex_name, const char* call_site);
+
+  void RecordAcquire(bool contended, uint64_t wait_ticks);
+  void RecordRelease(uint64_t hold_ticks);
+
+ private:
+  friend class MutexProfiler;
+
+  MutexSite(const MutexSite&) = delete;
+  MutexSite& operator=(const MutexSite&) = delete;
+
+  static void UpdateMax(compat::Atomic<uint64_t>* max, uint64_t value);
+
+  const char* mutex_name_;
+  const char* call_site_;
+  compat::Atomic<uint64_t> acquisitions_;
+  compat::Atomic<uint64_t> contended_acquisitions_;
+  compat::Atomic<uint64_t> total_wait_ticks_;
+  compat::Atomic<uint64_t> max_wait_ticks_;
+  compat::Atomic<uint64_t> total_hold_ticks_;
+  compat::Atomic<uint64_t> max_hold_ticks_;
+  // Next site in the list of all sites.
+  MutexSite* next_;
+};
+
+// Acquires a mutex while in scope, like MutexLock, recording statistics for the
+// given site while the MutexProfiler is enabled.
+class ProfiledMutexLock {
+ public:
+  ProfiledMutexLock(Mutex& mutex, MutexSite* site)  // NOLINT
+      : mutex_(&mutex), site_(nullptr), acquired_ticks_(0) {
+    if (MutexProfiler::IsEnabled()) {
+      AcquireProfiled(site);
+    } else {
+      mutex_->Acquire();
+    }
+  }
+
+  ~ProfiledMutexLock() {
+    if (site_) RecordRelease();
+    mutex_->Release();
+  }
+
+ private:
+  ProfiledMutexLock(const ProfiledMutexLock&) = delete;
+  ProfiledMutexLock& operator=(const ProfiledMutexLock&) = delete;
+
+  void AcquireProfiled(MutexSite* site);
+  void RecordRelease();
+
+  Mutex* mutex_;
+  // Null if the profiler was disabled when the mutex was acquired.
+  MutexSite* site_;
+  uint64_t acquired_ticks_;
+};
+
+// Declares a ProfiledMutexLock named lock_name that holds mutex until the end
+// of the scope, recording statistics under mutex_name and the enclosing
+// function's name.
+#define FIREBASE_PROFILED_MUTEX_LOCK(lock_name, mutex, mutex_name)     \
+  static ::firebase::internal::MutexSite lock_name##_site(mutex_name, \
+                                                         __func__);  \
+  ::firebase::internal::ProfiledMutexLock lock_name(mutex, &lock_name##_site)
+
+}  // namespace internal
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
+
+#endif  // FIREBASE_APP_SRC_MUTEX_PROFILER_H_
@@ -55,6 +55,12 @@ void Mutex::Acquire() {
   (void)ret;
 }
 
+bool Mutex::TryAcquire() {
+  int ret = pthread_mutex_trylock(&mutex_);
+  // As with Acquire(), EINVAL is treated as success.
+  return ret == 0 || ret == EINVAL;
+}
+
 void Mutex::Release() {
   int ret = pthread_mutex_unlock(&mutex_);
 #if defined(__APPLE__)
@@ -37,6 +37,10 @@ void Mutex::Acquire() {
   (void)ret;
 }
 
+bool Mutex::TryAcquire() {
+  return WaitForSingleObject(synchronization_object_, 0) == WAIT_OBJECT_0;
+}
+
 void Mutex::Release() {
   if (mode_ & kModeRecursive) {
     ReleaseMutex(synchronization_object_);
@@ -25,6 +25,7 @@
 #include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/intrusive_list.h"
 #include "app/src/log.h"
+#include "app/src/mutex_profiler.h"
 
 // Set this to 1 to enable verbose logging in this module.
 #if !defined(FIREBASE_FUTURE_TRACE_ENABLE)
@@ -52,6 +53,9 @@ const FutureHandle ReferenceCountedFutureImpl::kInvalidHandle(
 
 namespace {
 
+// Name of mutex_ in contention statistics.
+const char kFutureMutexName[] = "ReferenceCountedFutureImpl::mutex_";
+
 // This class manages proxies to a Future.
 // The goal is to allow LastResult to return a proxy to a Future, so that we
 // don't have to duplicate the asynchronous call, but still have the Futures
@@ -151,11 +155,31 @@ struct CompletionCallbackData {
   // callback runs or the Future is destroyed.
   void (*callback_user_data_delete_fn)(void*);
 
+  // The user data in the CompletionCallbackHandle of this callback, which
+  // RemoveCompletionCallback matches. It is callback_user_data, except for
+  // callbacks added as a std::function: their callback_user_data points into
+  // this reused storage, so they get an ID that is never handed out again.
+  void* handle_user_data;
+
+#ifdef FIREBASE_USE_STD_FUNCTION
+  // The function called by a callback added with a std::function, which
+  // callback_user_data points to. Keeping it here saves allocating it
+  // separately.
+  std::function<void(const FutureBase&)> function;
+#endif  // FIREBASE_USE_STD_FUNCTION
+
+  CompletionCallbackData()
+      : completion_callback(nullptr),
+        callback_user_data(nullptr),
+        callback_user_data_delete_fn(nullptr),
+        handle_user_data(nullptr) {}
+
   CompletionCallbackData(FutureBase::CompletionCallback callback,
                          void* user_data, void (*user_data_delete_fn)(void*))
       : completion_callback(callback),
         callback_user_data(user_data),
-        callback_user_data_delete_fn(user_data_delete_fn) {}
+        callback_user_data_delete_fn(user_data_delete_fn),
+        handle_user_data(user_data) {}
 };
 
 using intrusive_list_iterator =
@@ -163,9 +187,53 @@ using intrusive_list_iterator =
 
 }  // anonymous namespace
 
+// Keeps the CompletionCallbackData of callbacks that have run or been removed
+// for reuse, so that futures with more than one callback do not allocate each
+// one once the pool is warm. Only used with ReferenceCountedFutureImpl::mutex_
+// held.
+class CompletionCallbackPool {
+ public:
+  CompletionCallbackPool()
+      : free_callbacks_(&CompletionCallbackData::node), free_count_(0) {}
+
+  ~CompletionCallbackPool() {
+    while (!free_callbacks_.empty()) {
+      CompletionCallbackData* data = &free_callbacks_.front();
+      free_callbacks_.pop_front();
+      delete data;
+    }
+  }
+
+  CompletionCallbackData* Allocate() {
+    if (free_callbacks_.empty()) return new CompletionCallbackData();
+    CompletionCallbackData* data = &free_callbacks_.front();
+    free_callbacks_.pop_front();
+    free_count_--;
+    return data;
+  }
+
+  void Free(CompletionCallbackData* data) {
+    if (free_count_ >= kMaxFreeCallbacks) {
+      delete data;
+      return;
+    }
+    free_callbacks_.push_front(*data);
+    free_count_++;
+  }
+
+ private:
+  // Callbacks freed beyond this many are deleted.
+  static const size_t kMaxFreeCallbacks = 256;
+
+  intrusive_list<CompletionCallbackData> free_callbacks_;
+  size_t free_count_;
+};
+
 struct FutureBackingData {
-  // Create with type-specific data.
-  explicit FutureBackingData(void* data, DataDeleteFn* delete_data_fn)
+  // Create with type-specific data. Callbacks that do not fit in
+  // inline_callback are allocated from callback_pool.
+  FutureBackingData(void* data, DataDeleteFn* delete_data_fn,
+                    CompletionCallbackPool* callback_pool)
       : status(kFutureStatusPending),
         error(0),
         reference_count(0),
@@ -175,6 +243,8 @@ struct FutureBackingData {
         context_data_delete_fn(nullptr),
         completion_single_callback(nullptr),
         completion_multiple_callbacks(&CompletionCallbackData::node),
+        inline_callback_in_use(false),
+        callback_pool(callback_pool),
         proxy(nullptr) {}
 
   // Call the type-specific destructor on data.
@@ -193,6 +263,14 @@ struct FutureBackingData {
   // Add a new callback to the list of callbacks.
   void AddCallbackData(CompletionCallbackData* callback);
 
+  // Allocate the data for a new callback, from inline_callback if it is free.
+  CompletionCallbackData* NewCallbackData(
+      FutureBase::CompletionCallback callback, void* user_data,
+      void (*user_data_delete_fn)(void*));
+
+  // Free data allocated by NewCallbackData().
+  void DeleteCallbackData(CompletionCallbackData* callback);
+
   // Deallocate the memory associated with a single callback and nullify its
   // pointer, and decrement the reference count.
   void ClearSingleCallbackData(CompletionCallbackData** field_to_clear);
@@ -233,16 +311,24 @@ struct FutureBackingData {
   DataDeleteFn* context_data_delete_fn;
 
   // A single function to call when the future completes.
-  // Dynamically allocated with 'new'.
+  // Allocated with NewCallbackData().
   CompletionCallbackData* completion_single_callback;
 
   // A list of functions to call when the future completes.
-  // Note that the elements of this list are themselves dynamically allocated
-  // using 'new', and must be deleted when removing them from the list.
+  // Note that the elements of this list are themselves allocated with
+  // NewCallbackData(), and must be freed with DeleteCallbackData() when
+  // removing them from the list.
   // (We can't use a list of pointers here, because intrusive_list requires
   // that the list element type must contain an instrusive_list_node.)
   intrusive_list<CompletionCallbackData> completion_multiple_callbacks;
 
+  // Storage for the first callback, as most futures only have one.
+  CompletionCallbackData inline_callback;
+  bool inline_callback_in_use;
+
+  // Where callbacks are allocated once inline_callback is in use.
+  CompletionCallbackPool* callback_pool;
+
   FutureProxyManager* proxy;
 };
 
@@ -293,6 +379,36 @@ void FutureBackingData::AddCallbackData(CompletionCallbackData* callback) {
   // ClearSingleCallbackData later.
 }
 
+CompletionCallbackData* FutureBackingData::NewCallbackData(
+    FutureBase::CompletionCallback callback, void* user_data,
+    void (*user_data_delete_fn)(void*)) {
+  CompletionCallbackData* data;
+  if (!inline_callback_in_use) {
+    inline_callback_in_use = true;
+    data = &inline_callback;
+  } else {
+    data = callback_pool->Allocate();
+  }
+  data->completion_callback = callback;
+  data->callback_user_data = user_data;
+  data->callback_user_data_delete_fn = user_data_delete_fn;
+  data->handle_user_data = user_data;
+  return data;
+}
+
+void FutureBackingData::DeleteCallbackData(CompletionCallbackData* callback) {
+#ifdef FIREBASE_USE_STD_FUNCTION
+  // Release whatever the function captured now, rather than when the data is
+  // reused.
+  callback->function = nullptr;
+#endif  // FIREBASE_USE_STD_FUNCTION
+  if (callback == &inline_callback) {
+    inline_callback_in_use = false;
+  } else {
+    callback_pool->Free(callback);
+  }
+}
+
 void FutureBackingData::ClearSingleCallbackData(
     CompletionCallbackData** field_to_clear) {
   if (*field_to_clear == nullptr) {
@@ -302,7 +418,7 @@ void FutureBackingData::ClearSingleCallbackData(
     (*field_to_clear)
         ->callback_user_data_delete_fn((*field_to_clear)->callback_user_data);
   }
-  delete *field_to_clear;
+  DeleteCallbackData(*field_to_clear);
   *field_to_clear = nullptr;
   reference_count--;
 }
@@ -328,6 +444,11 @@ FutureApiInterface::~FutureApiInterface() {}
 const char ReferenceCountedFutureImpl::kErrorMessageFutureIsNoLongerValid[] =
     "Invalid Future";
 
+ReferenceCountedFutureImpl::ReferenceCountedFutureImpl(size_t last_result_count)
+    : next_future_handle_(kInvalidFutureHandle + 1),
+      last_results_(last_result_count),
+      callback_pool_(new CompletionCallbackPool()) {}
+
 ReferenceCountedFutureImpl::~ReferenceCountedFutureImpl() {
   // All futures should be released before we destroy ourselves.
   for (size_t i = 0; i < last_results_.size(); ++i) {
@@ -351,18 +472,20 @@ ReferenceCountedFutureImpl::~ReferenceCountedFutureImpl() {
     backings_.erase(it);
     delete backing;
   }
+  delete callback_pool_;
 }
 
 FutureHandle ReferenceCountedFutureImpl::AllocInternal(
     int fn_idx, void* data, void (*delete_data_fn)(void* data_to_delete)) {
   // Backings get deleted in ReleaseFuture() and ~ReferenceCountedFutureImpl().
-  FutureBackingData* backing = new FutureBackingData(data, delete_data_fn);
+  FutureBackingData* backing =
+      new FutureBackingData(data, delete_data_fn, callback_pool_);
 
   // Allocate a unique handle and insert the new backing into the map.
   // Note that it's theoretically possible to have a handle collision if we
   // allocate four billion more handles before releasing one. We ignore this
   // possibility.
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kFutureMutexName);
   const FutureHandleId id = AllocHandleId();
   FIREBASE_FUTURE_TRACE("API: Allocated handle id %d", id);
   backings_.insert(BackingPair(id, backing));
@@ -479,14 +602,14 @@ void ReferenceCountedFutureImpl::UnregisterFutureForCleanup(
 }
 
 void ReferenceCountedFutureImpl::ReferenceFuture(const FutureHandle& handle) {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kFutureMutexName);
   BackingFromHandle(handle.id())->reference_count++;
   FIREBASE_FUTURE_TRACE("API: Reference handle %d, ref count %d", handle.id(),
                         BackingFromHandle(handle.id())->reference_count);
 }
 
 void ReferenceCountedFutureImpl::ReleaseFuture(const FutureHandle& handle) {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kFutureMutexName);
   FIREBASE_FUTURE_TRACE("API: Release future %d", (int)handle.id());
 
   // If a Future exists with a handle, then the backing should still exist for
@@ -516,14 +639,14 @@ void ReferenceCountedFutureImpl::ReleaseFuture(const FutureHandle& handle) {
 
 FutureStatus ReferenceCountedFutureImpl::GetFutureStatus(
     const FutureHandle& handle) const {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kFutureMutexName);
   const FutureBackingData* backing = BackingFromHandle(handle.id());
   return backing == nullptr ? kFutureStatusInvalid : backing->status;
 }
 
 int ReferenceCountedFutureImpl::GetFutureError(
     const FutureHandle& handle) const {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kFutureMutexName);
   const FutureBackingData* backing = BackingFromHandle(handle.id());
   return backing == nullptr ? kErrorFutureIsNoLongerValid : backing->error;
 }
@@ -538,7 +661,7 @@ const char* ReferenceCountedFutureImpl::GetFutureErrorMessage(
 
 const void* ReferenceCountedFutureImpl::GetFutureResult(
     const FutureHandle& handle) const {
-  MutexLock lock(mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, mutex_, kFutureMutexName);
   const FutureBackingData* backing = BackingFromHandle(handle.id());
   return backing == nullptr || backing->status != kFutureStatusComplete
              ? nullptr
@@ -557,10 +680,6 @@ ReferenceCountedFutureImpl::AddCompletionCallback(
     const FutureHandle& handle, FutureBase::CompletionCallback callback,
     void* user_data, void (*user_data_delete_fn_ptr)(void*),
     bool single_completion) {
-  // Record the callback parameters.
-  CompletionCallbackData* callback_data =
-      new CompletionCallbackData(callback, user_data, user_data_delete_fn_ptr);
-
   // To handle the case where the future is already complete and we want to
   // call the callback immediately, we acquire the mutex directly, so that
   // it can be freed in ReleaseMutexAndRunCallbacks, prior to calling the
@@ -571,10 +690,12 @@ ReferenceCountedFutureImpl::AddCompletionCallback(
   FutureBackingData* backing = BackingFromHandle(handle.id());
   if (backing == nullptr) {
     mutex_.Release();
-    delete callback_data;
     return detail::CompletionCallbackHandle();
   }
 
+  // Record the callback parameters.
+  CompletionCallbackData* callback_data =
+      backing->NewCallbackData(callback, user_data, user_data_delete_fn_ptr);
   if (single_completion) {
     backing->SetSingleCallbackData(&backing->completion_single_callback,
                                    callback_data);
@@ -604,7 +725,7 @@ class CompletionMatcher {
       : match_(callback, user_data, user_data_delete_fn) {}
   bool operator()(const CompletionCallbackData& data) const {
     return data.completion_callback == match_.completion_callback &&
-           data.callback_user_data == match_.callback_user_data &&
+           data.handle_user_data == match_.handle_user_data &&
            data.callback_user_data_delete_fn ==
                match_.callback_user_data_delete_fn;
   }
@@ -645,25 +766,10 @@ static void CallStdFunction(const FutureBase& future, void* function_void) {
   }
 }
 
-static void DeleteStdFunction(void* function_void) {
-  if (function_void) {
-    std::function<void(const FutureBase&)>* function =
-        reinterpret_cast<std::function<void(const FutureBase&)>*>(
-            function_void);
-    delete function;
-  }
-}
-
 detail::CompletionCallbackHandle
 ReferenceCountedFutureImpl::AddCompletionCallbackLambda(
     const FutureHandle& handle, std::function<void(const FutureBase&)> callback,
     bool single_completion) {
-  // Record the callback parameters.
-  CompletionCallbackData* completion_callback_data = new CompletionCallbackData(
-      /*callback=*/CallStdFunction,
-      /*user_data=*/new std::function<void(const FutureBase&)>(callback),
-      /*user_data_delete_fn=*/DeleteStdFunction);
-
   // To handle the case where the future is already complete and we want to
   // call the callback immediately, we acquire the mutex directly, so that
   // it can be freed in ReleaseMutexAndRunCallbacks, prior to calling the
@@ -674,10 +780,24 @@ ReferenceCountedFutureImpl::AddCompletionCallbackLambda(
   FutureBackingData* backing = BackingFromHandle(handle.id());
   if (backing == nullptr) {
     mutex_.Release();
-    delete completion_callback_data;
     return detail::CompletionCallbackHandle();
   }
 
+  // Record the callback parameters. The function is stored in the callback
+  // data, which is passed to CallStdFunction as the user data.
+  CompletionCallbackData* completion_callback_data = backing->NewCallbackData(
+      /*callback=*/CallStdFunction, /*user_data=*/nullptr,
+      /*user_data_delete_fn=*/nullptr);
+  completion_callback_data->function = std::move(callback);
+  completion_callback_data->callback_user_data =
+      &completion_callback_data->function;
+  completion_callback_data->handle_user_data =
+      reinterpret_cast<void*>(++last_callback_id_);
+  detail::CompletionCallbackHandle callback_handle(
+      completion_callback_data->completion_callback,
+      completion_callback_data->handle_user_data,
+      completion_callback_data->callback_user_data_delete_fn);
+
   if (single_completion) {
     backing->SetSingleCallbackData(&backing->completion_single_callback,
                                    completion_callback_data);
@@ -692,10 +812,7 @@ ReferenceCountedFutureImpl::AddCompletionCallbackLambda(
     return detail::CompletionCallbackHandle();
   } else {
     mutex_.Release();
-    return detail::CompletionCallbackHandle(
-        completion_callback_data->completion_callback,
-        completion_callback_data->callback_user_data,
-        completion_callback_data->callback_user_data_delete_fn);
+    return callback_handle;
   }
 }
 
@@ -32,6 +32,7 @@ namespace firebase {
 // FutureBackingData holds the important data for each Future. These are held by
 // ReferenceCountedFutureImpl and indexed by FutureHandleId.
 struct FutureBackingData;
+class CompletionCallbackPool;
 
 // Value for an invalid future handle. Default futures (which don't reference
 // any real operation) have this handle ID.
@@ -112,9 +113,7 @@ class ReferenceCountedFutureImpl : public detail::FutureApiInterface {
   /// function.
   static constexpr int kNoFunctionIndex = -1;
 
-  explicit ReferenceCountedFutureImpl(size_t last_result_count)
-      : next_future_handle_(kInvalidFutureHandle + 1),
-        last_results_(last_result_count) {}
+  explicit ReferenceCountedFutureImpl(size_t last_result_count);
   ~ReferenceCountedFutureImpl() override;
 
   // Implementation of detail::FutureApiInterface.
@@ -585,6 +584,13 @@ class ReferenceCountedFutureImpl : public detail::FutureApiInterface {
   bool is_running_callback_ = false;
 
   bool is_orphaned_ = false;
+
+  /// Completion callback data kept for reuse by this instance's futures.
+  CompletionCallbackPool* callback_pool_;
+
+  /// The ID given to the last callback added as a std::function, which
+  /// identifies it in its CompletionCallbackHandle.
+  uintptr_t last_callback_id_ = 0;
 };
 
 /// Specialize the case where the data is void since we don't need to
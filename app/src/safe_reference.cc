@@ -0,0 +1,119 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "app/src/safe_reference.h"
+
+#include "app/src/include/firebase/internal/platform.h"
+
+#if FIREBASE_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif  // FIREBASE_PLATFORM_WINDOWS
+
+namespace firebase {
+namespace internal {
+
+namespace {
+
+// The most recently created guard on the calling thread, which links to the
+// guards created before it.
+#if FIREBASE_PLATFORM_WINDOWS
+DWORD GetGuardKey() {
+  static DWORD tls_index = TlsAlloc();
+  return tls_index;
+}
+
+SafeReferenceGuard* GetCurrentGuard() {
+  return static_cast<SafeReferenceGuard*>(TlsGetValue(GetGuardKey()));
+}
+
+void SetCurrentGuard(SafeReferenceGuard* guard) {
+  TlsSetValue(GetGuardKey(), guard);
+}
+#else
+pthread_key_t CreateGuardKey() {
+  pthread_key_t key;
+  pthread_key_create(&key, nullptr);
+  return key;
+}
+
+pthread_key_t GetGuardKey() {
+  static pthread_key_t key = CreateGuardKey();
+  return key;
+}
+
+SafeReferenceGuard* GetCurrentGuard() {
+  return static_cast<SafeReferenceGuard*>(pthread_getspecific(GetGuardKey()));
+}
+
+void SetCurrentGuard(SafeReferenceGuard* guard) {
+  pthread_setspecific(GetGuardKey(), guard);
+}
+#endif  // FIREBASE_PLATFORM_WINDOWS
+
+}  // namespace
+
+SafeReferenceState::SafeReferenceState()
+    : clear_mutex_(Mutex::kModeNonRecursive), exited_(0) {}
+
+void SafeReferenceState::Clear() {
+  MutexLock lock(clear_mutex_);
+  uint32_t state = state_.load();
+  while (!(state & kClearedBit) &&
+         !state_.compare_exchange_strong(state, state | kClearedBit)) {
+  }
+  // Waiting for the calling thread's own guards would never finish, so
+  // detach them: they stop counting, and return null from now on.
+  for (SafeReferenceGuard* guard = GetCurrentGuard(); guard;
+       guard = guard->previous_) {
+    if (guard->state_ == this) {
+      guard->state_ = nullptr;
+      guard->ref_ = nullptr;
+      state_.fetch_sub(1);
+    }
+  }
+  // Guards that fail to enter are counted briefly, so the count can rise
+  // again while waiting.
+  state = state_.load();
+  while (state & kCountMask) {
+    if (state & kWaitingBit) {
+      exited_.Wait();
+      state = state_.load();
+    } else if (state_.compare_exchange_strong(state, state | kWaitingBit)) {
+      state |= kWaitingBit;
+    }
+  }
+  while ((state & kWaitingBit) &&
+         !state_.compare_exchange_strong(state, state & ~kWaitingBit)) {
+  }
+}
+
+SafeReferenceGuard::SafeReferenceGuard(SafeReferenceState* state, void* ref)
+    : state_(state), ref_(ref), previous_(GetCurrentGuard()) {
+  if (!state_->Enter()) {
+    state_ = nullptr;
+    ref_ = nullptr;
+  }
+  SetCurrentGuard(this);
+}
+
+SafeReferenceGuard::~SafeReferenceGuard() {
+  SetCurrentGuard(previous_);
+  if (state_) state_->Exit();
+}
+
+}  // namespace internal
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
@@ -15,13 +15,90 @@
 #ifndef FIREBASE_APP_SRC_SAFE_REFERENCE_H_
 #define FIREBASE_APP_SRC_SAFE_REFERENCE_H_
 
+#include <stdint.h>
+
+#include "app/memory/atomic.h"
 #include "app/memory/shared_ptr.h"
 #include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/semaphore.h"
 
 namespace firebase {
 namespace internal {
 
-// TODO(b/130544650): Add unit test to this file.
+class SafeReferenceGuard;
+
+// Liveness state shared by all copies of a SafeReference.
+//
+// Guards are counted in a single atomic word, so taking and releasing a guard
+// never blocks, and any number of threads can hold guards at once. Clear()
+// marks the reference as cleared, which makes new guards fail, then waits for
+// the guards still held by other threads to be released.
+class SafeReferenceState {
+ public:
+  SafeReferenceState();
+
+  // Counts a new guard. Returns false, without counting it, if the reference
+  // has been cleared.
+  bool Enter() {
+    if (state_.fetch_add(1) & kClearedBit) {
+      Exit();
+      return false;
+    }
+    return true;
+  }
+
+  // Releases a guard counted by Enter().
+  void Exit() {
+    uint32_t previous = state_.fetch_sub(1);
+    // Wake Clear() when the last guard it is waiting for is released.
+    if ((previous & kWaitingBit) && (previous & kCountMask) == 1) {
+      exited_.Post();
+    }
+  }
+
+  // Makes new guards fail and waits until guards held by other threads are
+  // released. Guards held by the calling thread are detached instead, so an
+  // object can be cleared, and deleted, from within one of its own callbacks.
+  void Clear();
+
+ private:
+  static const uint32_t kClearedBit = 0x80000000;
+  static const uint32_t kWaitingBit = 0x40000000;
+  static const uint32_t kCountMask = kWaitingBit - 1;
+
+  // kClearedBit once cleared, kWaitingBit while Clear() waits for guards to
+  // be released, plus the number of guards held.
+  compat::Atomic<uint32_t> state_;
+  // Only held while clearing, so that concurrent calls to Clear() all wait.
+  Mutex clear_mutex_;
+  // Posted when the last guard is released while Clear() waits.
+  Semaphore exited_;
+};
+
+// Keeps a SafeReferenceState from being cleared while it exists. Guards are
+// tracked per thread, so they must be destroyed in the reverse order to which
+// they are created on each thread, as scoped objects are.
+class SafeReferenceGuard {
+ public:
+  SafeReferenceGuard(SafeReferenceState* state, void* ref);
+  ~SafeReferenceGuard();
+
+  // The guarded reference, or null if it has been cleared.
+  void* reference() const { return ref_; }
+
+ private:
+  friend class SafeReferenceState;
+
+  SafeReferenceGuard(const SafeReferenceGuard&) = delete;
+  SafeReferenceGuard& operator=(const SafeReferenceGuard&) = delete;
+
+  // Null if the reference was cleared when the guard was created, or if
+  // Clear() was called on the guard's thread since.
+  SafeReferenceState* state_;
+  void* ref_;
+  // The guard created before this one on the same thread.
+  SafeReferenceGuard* previous_;
+};
 
 // SafeReference owns a pointers to an object which can be deleted in anytime.
 // SafeReference can be shared to different thread that potentially have longer
@@ -30,47 +107,48 @@ namespace internal {
 // callback but do not want to keep track of every callback it scheduled.
 // When the object is about to be deleted, the object itself or the owner of
 // the object is responsible to use ClearReference() to clear the reference.
-// When any thread need to get the reference, it should either lock the mutex
-// before calling GetReferenceUnsafe() or simply use SafeReferenceLock.
+// When any thread need to get the reference, it should use SafeReferenceLock.
+//
+// SafeReferenceLock only guarantees that the object is not deleted while the
+// lock is held. It does not stop other threads from using the object at the
+// same time, which callers that share a scheduler get from the scheduler.
 template <typename T>
 class SafeReference {
  public:
   explicit SafeReference(T* ref) : data_(new ReferenceData(ref)) {}
 
-  Mutex& GetMutex() { return data_->mutex; }
-
-  T* GetReferenceUnsafe() { return data_->ref; }
-
-  void ClearReference() {
-    MutexLock lock(data_->mutex);
-    data_->ref = nullptr;
-  }
+  // Blocks until no other thread holds a SafeReferenceLock on the reference,
+  // after which every SafeReferenceLock returns null.
+  void ClearReference() { data_->state.Clear(); }
 
  private:
+  template <typename U>
+  friend class SafeReferenceLock;
+
   struct ReferenceData {
-    explicit ReferenceData(T* ref) : mutex(Mutex::kModeRecursive), ref(ref) {}
+    explicit ReferenceData(T* ref) : ref(ref) {}
 
-    Mutex mutex;
-    T* ref;
+    SafeReferenceState state;
+    // Never changes, the state tracks whether it is still valid.
+    T* const ref;
   };
 
   SharedPtr<ReferenceData> data_;
 };
 
-// SafeReferenceLock is used to lock and to safely obtain the reference.
-// When this is created, it locks the reference immediately so that no other
-// thread can modify the reference.  It releases the reference once deleted.
+// SafeReferenceLock is used to safely obtain the reference. While it exists,
+// ClearReference() waits for it to be released, unless called from the same
+// thread, in which case GetReference() returns null from then on.
 template <typename T>
 class SafeReferenceLock {
  public:
   explicit SafeReferenceLock(SafeReference<T>* ref)
-      : ref_(ref), lock_(ref->GetMutex()) {}
+      : guard_(&ref->data_->state, ref->data_->ref) {}
 
-  T* GetReference() { return ref_->GetReferenceUnsafe(); }
+  T* GetReference() { return static_cast<T*>(guard_.reference()); }
 
  private:
-  SafeReference<T>* ref_;
-  MutexLock lock_;
+  SafeReferenceGuard guard_;
 };
 
 // A macro to check if the safe_reference is valid.  Early out if not.
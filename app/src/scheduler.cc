@@ -18,7 +18,9 @@
 
 #include <cassert>
 
+#include "app/src/mutex_profiler.h"
 #include "app/src/time.h"
+#include "app/src/trace.h"
 
 namespace firebase {
 namespace scheduler {
@@ -58,25 +60,44 @@ Scheduler::RequestData::RequestData(RequestId id, callback::Callback* cb,
       delay_ms(delay),
       repeat_ms(repeat),
       due_timestamp(0),
-      status(new RequestStatusBlock(repeat > 0)) {}
+      status(new RequestStatusBlock(repeat > 0)),
+      trace_flow_id(FIREBASE_TRACE_NEW_FLOW_ID()) {
+  FIREBASE_TRACE_FLOW_BEGIN("scheduler", "Scheduler::Schedule", trace_flow_id);
+}
 
 Scheduler::Scheduler()
     : thread_(nullptr),
+      thread_id_(),
       next_request_id_(0),
       terminating_(false),
-      request_mutex_(Mutex::kModeRecursive),
+      request_mutex_(Mutex::kModeNonRecursive),
       sleep_sem_(0) {}
 
+Scheduler::Scheduler(ThreadPool* pool)
+    : thread_(nullptr),
+      thread_id_(),
+      next_request_id_(0),
+      terminating_(false),
+      request_mutex_(Mutex::kModeNonRecursive),
+      sleep_sem_(0),
+      queue_(MakeUnique<SerialQueue>(pool)) {}
+
 Scheduler::~Scheduler() { CancelAllAndShutdownWorkerThread(); }
 
 void Scheduler::CancelAllAndShutdownWorkerThread() {
   {
     // Notify the worker thread to stop processing anymore requests.
-    MutexLock lock(request_mutex_);
+    FIREBASE_PROFILED_MUTEX_LOCK(lock, request_mutex_,
+                                 "Scheduler::request_mutex_");
     if (terminating_) return;
     terminating_ = true;
   }
 
+  if (queue_) {
+    queue_->Shutdown();
+    return;
+  }
+
   // Signal the thread to wake if it is sleeping due to no callbacks in queue
   sleep_sem_.Post();
 
@@ -92,7 +113,16 @@ RequestHandle Scheduler::Schedule(callback::Callback* callback,
                                   ScheduleTimeMs repeat /* = 0 */) {
   assert(callback);
 
-  MutexLock lock(request_mutex_);
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, request_mutex_,
+                               "Scheduler::request_mutex_");
+
+  if (queue_) {
+    RequestDataPtr request(
+        new RequestData(++next_request_id_, callback, delay, repeat));
+    RequestHandle handler(request->status);
+    if (!terminating_) PostToQueue(request, delay);
+    return handler;
+  }
 
   if (!thread_ && !terminating_) {
     thread_ = new Thread(WorkerThreadRoutine, this);
@@ -111,6 +141,13 @@ RequestHandle Scheduler::Schedule(callback::Callback* callback,
   return handler;
 }
 
+bool Scheduler::IsCurrentThread() {
+  if (queue_) return queue_->IsCurrentThread();
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, request_mutex_,
+                               "Scheduler::request_mutex_");
+  return thread_ != nullptr && Thread::IsCurrentThread(thread_id_);
+}
+
 #ifdef FIREBASE_USE_STD_FUNCTION
 RequestHandle Scheduler::Schedule(const std::function<void(void)>& callback,
                                   ScheduleTimeMs delay /* = 0 */,
@@ -122,6 +159,11 @@ RequestHandle Scheduler::Schedule(const std::function<void(void)>& callback,
 void Scheduler::WorkerThreadRoutine(void* data) {
   Scheduler* scheduler = static_cast<Scheduler*>(data);
   assert(scheduler);
+  {
+    FIREBASE_PROFILED_MUTEX_LOCK(lock, scheduler->request_mutex_,
+                                 "Scheduler::request_mutex_");
+    scheduler->thread_id_ = Thread::CurrentId();
+  }
 
   while (true) {
     uint64_t current = internal::GetTimestamp();
@@ -131,7 +173,8 @@ void Scheduler::WorkerThreadRoutine(void* data) {
 
     // Check if the top request in the queue is due.
     {
-      MutexLock lock(scheduler->request_mutex_);
+      FIREBASE_PROFILED_MUTEX_LOCK(lock, scheduler->request_mutex_,
+                                   "Scheduler::request_mutex_");
       if (!scheduler->request_queue_.empty()) {
         auto due = scheduler->request_queue_.top()->due_timestamp;
         if (due <= current) {
@@ -158,7 +201,8 @@ void Scheduler::WorkerThreadRoutine(void* data) {
       }
 
       // Check if the scheduler is terminating after sleep.
-      MutexLock lock(scheduler->request_mutex_);
+      FIREBASE_PROFILED_MUTEX_LOCK(lock, scheduler->request_mutex_,
+                                   "Scheduler::request_mutex_");
       if (scheduler->terminating_) {
         return;
       }
@@ -167,7 +211,8 @@ void Scheduler::WorkerThreadRoutine(void* data) {
     // If the top request is due, trigger the callback.  If the repeat interval
     // is non-zero, move it back to queue.
     if (request && scheduler->TriggerCallback(request)) {
-      MutexLock lock(scheduler->request_mutex_);
+      FIREBASE_PROFILED_MUTEX_LOCK(lock, scheduler->request_mutex_,
+                                   "Scheduler::request_mutex_");
       ScheduleTimeMs repeat = request->repeat_ms;
       scheduler->AddToQueue(Move(request), current, repeat);
     }
@@ -183,9 +228,40 @@ void Scheduler::AddToQueue(RequestDataPtr request, uint64_t current,
   request_queue_.push(Move(request));
 }
 
+class Scheduler::QueuedRequest : public callback::Callback {
+ public:
+  QueuedRequest(Scheduler* scheduler, const RequestDataPtr& request)
+      : scheduler_(scheduler), request_(request) {}
+
+  void Run() override {
+    if (scheduler_->TriggerCallback(request_)) {
+      FIREBASE_PROFILED_MUTEX_LOCK(lock, scheduler_->request_mutex_,
+                                   "Scheduler::request_mutex_");
+      if (!scheduler_->terminating_) {
+        scheduler_->PostToQueue(request_, request_->repeat_ms);
+      }
+    }
+  }
+
+ private:
+  Scheduler* scheduler_;
+  RequestDataPtr request_;
+};
+
+void Scheduler::PostToQueue(const RequestDataPtr& request,
+                            ScheduleTimeMs delay) {
+  queue_->Post(new QueuedRequest(this, request), delay);
+}
+
 bool Scheduler::TriggerCallback(const RequestDataPtr& request) {
   MutexLock lock(request->status->mutex);
   if (request->cb && !request->status->cancelled) {
+    // Repeating requests keep their flow going from one run to the next.
+    FIREBASE_TRACE_SCOPE_FLOW("scheduler", "Scheduler::Run",
+                              request->trace_flow_id,
+                              request->repeat_ms > 0
+                                  ? internal::Trace::kFlowStep
+                                  : internal::Trace::kFlowEnd);
     request->cb->Run();
     request->status->triggered = true;
 
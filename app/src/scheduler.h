@@ -20,10 +20,12 @@
 #include <queue>
 
 #include "app/memory/shared_ptr.h"
+#include "app/memory/unique_ptr.h"
 #include "app/src/callback.h"
 #include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/semaphore.h"
 #include "app/src/thread.h"
+#include "app/src/thread_pool.h"
 #include "firebase/internal/common.h"
 
 namespace firebase {
@@ -90,6 +92,11 @@ class Scheduler {
  public:
   Scheduler();
 
+  // Create a scheduler that runs its callbacks on a serial queue of the given
+  // thread pool rather than on a thread of its own. Callbacks still run one at
+  // a time and in order, but not necessarily on the same thread.
+  explicit Scheduler(ThreadPool* pool);
+
   // When a scheduler is deleted, all the future callback will be discarded.
   // The scheduler does not guarentee to trigger any callback scheduled before
   // the deletion or any the potentially due callback
@@ -123,6 +130,10 @@ class Scheduler {
   // Cancel all scheduled callbacks and shut down the worker thread.
   void CancelAllAndShutdownWorkerThread();
 
+  // Whether this is called from a callback run by this scheduler, which must
+  // not wait for other callbacks to run.
+  bool IsCurrentThread();
+
  private:
   typedef uint64_t RequestId;
   // The request data for all scheduled callback.
@@ -147,6 +158,10 @@ class Scheduler {
 
     // Status block shared with handlers
     SharedPtr<RequestStatusBlock> status;
+
+    // Links the trace events of scheduling and running the request, or 0 if
+    // tracing was disabled when the request was created.
+    uint64_t trace_flow_id;
   };
 
   // SharedPtr of request data.  Ideally this should be UniquePtr and there
@@ -172,6 +187,9 @@ class Scheduler {
   // The worker thread to process scheduled callback.
   Thread* thread_;
 
+  // The id of thread_, set by the thread itself once it runs.
+  Thread::Id thread_id_;
+
   // Generate next available request id.
   RequestId next_request_id_;
 
@@ -185,7 +203,9 @@ class Scheduler {
                       RequestDataPtrComparer>
       request_queue_;
 
-  // Mutex to guard next_request_id_, terminating_ and request_queue_
+  // Mutex to guard next_request_id_, terminating_, request_queue_ and
+  // thread_id_. It is never held while a callback runs, so it need not be
+  // recursive.
   Mutex request_mutex_;
 
   // A semaphore with its count equivalent to the number of unfinished
@@ -206,6 +226,15 @@ class Scheduler {
   // Trigger the callback.  Return true if this callback repeats and is not
   // cancelled yet.
   bool TriggerCallback(const RequestDataPtr& request);
+
+  // Post the request to queue_, to be triggered after the given delay.
+  void PostToQueue(const RequestDataPtr& request, ScheduleTimeMs delay);
+
+  // Runs a request posted to queue_.
+  class QueuedRequest;
+
+  // If set, callbacks run on this queue instead of on thread_.
+  UniquePtr<SerialQueue> queue_;
 };
 
 }  // namespace scheduler
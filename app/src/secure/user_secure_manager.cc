@@ -18,6 +18,7 @@
 #include "app/src/callback.h"
 #include "app/src/include/firebase/internal/platform.h"
 #include "app/src/secure/user_secure_internal.h"
+#include "app/src/thread_pool.h"
 
 // Only build this implementation on desktop. If building for iOS or Android,
 // omit it entirely. Until we implement UserSecureInternal for those platforms,
@@ -186,7 +187,7 @@ Future<void> UserSecureManager::DeleteAllData() {
 void UserSecureManager::CreateScheduler() {
   MutexLock lock(*s_scheduler_mutex_);
   if (s_scheduler_ == nullptr) {
-    s_scheduler_ = new scheduler::Scheduler();
+    s_scheduler_ = new scheduler::Scheduler(ThreadPool::Shared());
     // reset count
     s_scheduler_ref_count_ = 0;
   }
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/thread_pool.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include "app/src/time.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sched.h>
+#endif
+
+namespace firebase {
+
+namespace {
+
+// Name the calling thread, and pin it to the given CPUs, where the platform
+// supports it.
+void ConfigureCurrentThread(const std::string& name,
+                            const std::vector<int>& cpu_affinity) {
+#if defined(__linux__)
+  // Linux limits thread names to 15 characters.
+  pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(__APPLE__)
+  pthread_setname_np(name.c_str());
+#else
+  (void)name;
+#endif
+
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!cpu_affinity.empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : cpu_affinity) {
+      CPU_SET(cpu, &cpus);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#else
+  (void)cpu_affinity;
+#endif
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(const Options& options)
+    : options_(options),
+      mutex_(Mutex::kModeNonRecursive),
+      wake_sem_(0),
+      idle_workers_(0),
+      peak_thread_count_(0),
+      shutting_down_(false),
+      next_sequence_(0),
+      next_worker_index_(0) {
+  if (options_.max_threads == 0) options_.max_threads = 1;
+}
+
+ThreadPool::~ThreadPool() {
+  std::vector<Worker*> workers;
+  std::vector<Timer> timers;
+  {
+    MutexLock lock(mutex_);
+    assert(runnable_.empty());
+    shutting_down_ = true;
+    workers.swap(workers_);
+    for (size_t i = 0; i < workers.size(); ++i) {
+      wake_sem_.Post();
+    }
+    timers.swap(timers_);
+  }
+  // Timers can only belong to queues that have been destroyed without
+  // shutting down, which is a bug, but don't leak their tasks.
+  for (const Timer& timer : timers) {
+    delete timer.task;
+  }
+  for (Worker* worker : workers) {
+    worker->thread.Join();
+    delete worker;
+  }
+}
+
+ThreadPool* ThreadPool::Shared() {
+  static ThreadPool* shared_pool = new ThreadPool(Options());
+  return shared_pool;
+}
+
+void ThreadPool::SetSharedMaxThreads(size_t max_threads) {
+  Shared()->set_max_threads(max_threads);
+}
+
+void ThreadPool::set_max_threads(size_t max_threads) {
+  MutexLock lock(mutex_);
+  options_.max_threads = max_threads > 0 ? max_threads : 1;
+  // Wake idle workers, so that any above the new budget exit, and start more
+  // workers if there is waiting work that can now run.
+  for (size_t i = 0; i < idle_workers_; ++i) {
+    wake_sem_.Post();
+  }
+  for (size_t i = 0; i < runnable_.size(); ++i) {
+    WakeWorker();
+  }
+}
+
+size_t ThreadPool::max_threads() const {
+  MutexLock lock(mutex_);
+  return options_.max_threads;
+}
+
+size_t ThreadPool::thread_count() const {
+  MutexLock lock(mutex_);
+  return LiveWorkerCount();
+}
+
+size_t ThreadPool::peak_thread_count() const {
+  MutexLock lock(mutex_);
+  return peak_thread_count_;
+}
+
+void ThreadPool::Post(SerialQueue* queue, callback::Callback* task,
+                      uint64_t delay_ms) {
+  if (delay_ms == 0) {
+    Enqueue(queue, task);
+    return;
+  }
+  Timer timer;
+  timer.due_timestamp = internal::GetTimestamp() + delay_ms;
+  timer.sequence = next_sequence_++;
+  timer.queue = queue;
+  timer.task = task;
+  timers_.push_back(timer);
+  std::push_heap(timers_.begin(), timers_.end(), TimerComparer());
+  queue->pending_timers_++;
+  // Make sure a worker is around to fire the timer, and that a waiting worker
+  // notices if it is now the earliest one.
+  if (idle_workers_ > 0) {
+    wake_sem_.Post();
+  } else if (LiveWorkerCount() == 0) {
+    WakeWorker();
+  }
+}
+
+void ThreadPool::Enqueue(SerialQueue* queue, callback::Callback* task) {
+  queue->ready_.push_back(task);
+  if (!queue->scheduled_) {
+    queue->scheduled_ = true;
+    runnable_.push_back(queue);
+    WakeWorker();
+  }
+}
+
+void ThreadPool::WakeWorker() {
+  if (shutting_down_) return;
+  if (idle_workers_ > 0) {
+    wake_sem_.Post();
+    return;
+  }
+  ReapFinishedWorkers();
+  if (workers_.size() >= options_.max_threads) return;
+  Worker* worker = new Worker(this);
+  workers_.push_back(worker);
+  peak_thread_count_ = std::max(peak_thread_count_, workers_.size());
+  // The new thread waits for mutex_, which is held by the caller, before it
+  // touches the worker.
+  worker->thread = Thread(WorkerRoutine, worker);
+}
+
+size_t ThreadPool::LiveWorkerCount() const {
+  size_t count = 0;
+  for (const Worker* worker : workers_) {
+    if (!worker->finished) count++;
+  }
+  return count;
+}
+
+void ThreadPool::ReapFinishedWorkers() {
+  auto iter = workers_.begin();
+  while (iter != workers_.end()) {
+    Worker* worker = *iter;
+    if (worker->finished) {
+      // The thread does not touch the pool after setting finished, so this
+      // will not wait for long.
+      worker->thread.Join();
+      delete worker;
+      iter = workers_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void ThreadPool::WorkerRoutine(void* data) {
+  Worker* worker = static_cast<Worker*>(data);
+  worker->pool->RunWorker(worker);
+}
+
+void ThreadPool::RunWorker(Worker* worker) {
+  std::string name;
+  std::vector<int> cpu_affinity;
+  {
+    MutexLock lock(mutex_);
+    char index[16];
+    snprintf(index, sizeof(index), "-%d", next_worker_index_++);
+    name = options_.name + index;
+    cpu_affinity = options_.cpu_affinity;
+  }
+  ConfigureCurrentThread(name, cpu_affinity);
+
+  mutex_.Acquire();
+  while (!shutting_down_) {
+    // Move timers that are due to their queues.
+    uint64_t now = internal::GetTimestamp();
+    while (!timers_.empty() && timers_.front().due_timestamp <= now) {
+      std::pop_heap(timers_.begin(), timers_.end(), TimerComparer());
+      Timer timer = timers_.back();
+      timers_.pop_back();
+      timer.queue->pending_timers_--;
+      Enqueue(timer.queue, timer.task);
+    }
+
+    if (!runnable_.empty()) {
+      SerialQueue* queue = runnable_.front();
+      runnable_.pop_front();
+      callback::Callback* task = queue->ready_.front();
+      queue->ready_.pop_front();
+      queue->running_ = true;
+      queue->running_thread_ = Thread::CurrentId();
+      worker->current_queue = queue;
+
+      mutex_.Release();
+      task->Run();
+      delete task;
+      mutex_.Acquire();
+
+      // The queue may have been destroyed by its own task.
+      if (worker->current_queue != nullptr) {
+        worker->current_queue = nullptr;
+        queue->running_ = false;
+        if (!queue->ready_.empty() && !queue->shut_down_) {
+          runnable_.push_back(queue);
+        } else {
+          queue->scheduled_ = false;
+        }
+        if (queue->idle_sem_) {
+          queue->idle_sem_->Post();
+          queue->idle_sem_ = nullptr;
+        }
+      }
+      continue;
+    }
+
+    // Leave if the budget has shrunk below the number of running threads.
+    if (LiveWorkerCount() > options_.max_threads) break;
+
+    // Wait for more work, or until the next timer is due.
+    bool has_timers = !timers_.empty();
+    int wait_ms = options_.idle_timeout_ms;
+    if (has_timers) {
+      uint64_t due = timers_.front().due_timestamp;
+      wait_ms = due > now ? static_cast<int>(std::min<uint64_t>(
+                                due - now, options_.idle_timeout_ms))
+                          : 0;
+      if (wait_ms == 0) continue;
+    }
+    idle_workers_++;
+    mutex_.Release();
+    bool woken = wake_sem_.TimedWait(wait_ms);
+    mutex_.Acquire();
+    idle_workers_--;
+
+    // Exit once idle for long enough, unless there are timers to fire.
+    if (!woken && timers_.empty() && runnable_.empty()) break;
+  }
+  worker->finished = true;
+  mutex_.Release();
+}
+
+SerialQueue::SerialQueue(ThreadPool* pool)
+    : pool_(pool),
+      pending_timers_(0),
+      scheduled_(false),
+      running_(false),
+      running_thread_(),
+      shut_down_(false),
+      idle_sem_(nullptr) {
+  assert(pool_);
+}
+
+SerialQueue::~SerialQueue() {
+  Shutdown();
+  MutexLock lock(pool_->mutex_);
+  if (running_) {
+    // This is being destroyed by its own task. Stop the worker running it from
+    // touching the queue afterwards.
+    for (ThreadPool::Worker* worker : pool_->workers_) {
+      if (worker->current_queue == this) worker->current_queue = nullptr;
+    }
+  }
+}
+
+void SerialQueue::Post(callback::Callback* task, uint64_t delay_ms) {
+  assert(task);
+  {
+    MutexLock lock(pool_->mutex_);
+    if (!shut_down_) {
+      pool_->Post(this, task, delay_ms);
+      return;
+    }
+  }
+  // Deleted without holding the pool's lock, as deleting a task can run
+  // arbitrary destructors, which may post to a queue themselves.
+  delete task;
+}
+
+void SerialQueue::Shutdown() {
+  Semaphore idle_sem(0);
+  bool wait = false;
+  // Deleted once the pool's lock is released, see Post().
+  std::vector<callback::Callback*> cancelled;
+  {
+    MutexLock lock(pool_->mutex_);
+    if (!shut_down_) {
+      shut_down_ = true;
+      cancelled.assign(ready_.begin(), ready_.end());
+      ready_.clear();
+
+      if (pending_timers_ > 0) {
+        std::vector<ThreadPool::Timer>& timers = pool_->timers_;
+        auto end = std::remove_if(
+            timers.begin(), timers.end(),
+            [this, &cancelled](const ThreadPool::Timer& timer) {
+              if (timer.queue != this) return false;
+              cancelled.push_back(timer.task);
+              return true;
+            });
+        timers.erase(end, timers.end());
+        std::make_heap(timers.begin(), timers.end(),
+                       ThreadPool::TimerComparer());
+        pending_timers_ = 0;
+      }
+
+      if (scheduled_ && !running_) {
+        std::deque<SerialQueue*>& runnable = pool_->runnable_;
+        runnable.erase(std::remove(runnable.begin(), runnable.end(), this),
+                       runnable.end());
+        scheduled_ = false;
+      }
+    }
+    if (running_ && !Thread::IsCurrentThread(running_thread_)) {
+      idle_sem_ = &idle_sem;
+      wait = true;
+    }
+  }
+  for (callback::Callback* task : cancelled) {
+    delete task;
+  }
+  if (wait) idle_sem.Wait();
+}
+
+bool SerialQueue::IsCurrentThread() const {
+  MutexLock lock(pool_->mutex_);
+  return running_ && Thread::IsCurrentThread(running_thread_);
+}
+
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
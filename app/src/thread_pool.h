@@ -0,0 +1,216 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_APP_SRC_THREAD_POOL_H_
+#define FIREBASE_APP_SRC_THREAD_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "app/src/callback.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread.h"
+
+namespace firebase {
+
+class SerialQueue;
+
+// A bounded pool of worker threads that runs tasks posted to SerialQueues.
+//
+// Worker threads are started on demand, up to the pool's thread budget, and
+// exit again after they have been idle for a while, so a pool costs no threads
+// while there is nothing to do. Tasks posted to the same SerialQueue run one at
+// a time in the order they become due, while tasks on different queues run in
+// parallel on as many threads as the budget allows.
+//
+// Most of the SDK shares the single process-wide pool returned by Shared(), so
+// the number of background threads stays bounded no matter how many Apps and
+// components are created.
+class ThreadPool {
+ public:
+  struct Options {
+    Options() : name("firebase"), max_threads(16), idle_timeout_ms(10000) {}
+
+    // Prefix of the names given to worker threads, on platforms that support
+    // naming threads. Names are truncated to fit the platform's limit.
+    std::string name;
+    // The maximum number of worker threads.
+    size_t max_threads;
+    // How long an idle worker thread waits for more work before it exits.
+    int idle_timeout_ms;
+    // If not empty, worker threads are pinned to these CPUs. Only supported on
+    // Linux; ignored elsewhere.
+    std::vector<int> cpu_affinity;
+  };
+
+  explicit ThreadPool(const Options& options);
+
+  // Stops all worker threads, waiting for running tasks to finish. Tasks that
+  // have not started yet are discarded. All SerialQueues using this pool must
+  // be destroyed first.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // The process-wide pool, which is created the first time it is used and
+  // never destroyed.
+  static ThreadPool* Shared();
+
+  // Set the thread budget of the shared pool. This can be called at any time;
+  // if the budget shrinks, surplus threads exit once they are idle.
+  static void SetSharedMaxThreads(size_t max_threads);
+
+  // Set the thread budget of this pool.
+  void set_max_threads(size_t max_threads);
+  size_t max_threads() const;
+
+  // The number of worker threads currently running.
+  size_t thread_count() const;
+
+  // The highest number of worker threads that ran at the same time.
+  size_t peak_thread_count() const;
+
+ private:
+  friend class SerialQueue;
+
+  struct Timer {
+    uint64_t due_timestamp;
+    // Breaks ties between timers with the same due time, so they fire in the
+    // order they were posted.
+    uint64_t sequence;
+    SerialQueue* queue;
+    callback::Callback* task;
+  };
+
+  struct TimerComparer {
+    bool operator()(const Timer& lhs, const Timer& rhs) const {
+      return lhs.due_timestamp > rhs.due_timestamp ||
+             (lhs.due_timestamp == rhs.due_timestamp &&
+              lhs.sequence > rhs.sequence);
+    }
+  };
+
+  struct Worker {
+    explicit Worker(ThreadPool* pool)
+        : pool(pool), finished(false), current_queue(nullptr) {}
+
+    ThreadPool* pool;
+    Thread thread;
+    // Set when the thread is about to exit, so it can be joined.
+    bool finished;
+    // The queue whose task this worker is running, or null. Cleared if the
+    // queue is destroyed by its own task.
+    SerialQueue* current_queue;
+  };
+
+  // Everything below must be called with mutex_ held.
+
+  void Post(SerialQueue* queue, callback::Callback* task, uint64_t delay_ms);
+  // Add a task that is due now to its queue, and make the queue runnable.
+  void Enqueue(SerialQueue* queue, callback::Callback* task);
+  // Wake an idle worker, or start a new one if there is room in the budget.
+  void WakeWorker();
+  // The number of workers that have not finished.
+  size_t LiveWorkerCount() const;
+  // Join threads that have exited.
+  void ReapFinishedWorkers();
+
+  static void WorkerRoutine(void* data);
+  void RunWorker(Worker* worker);
+
+  Options options_;
+
+  mutable Mutex mutex_;
+
+  // Posted once for each piece of work made available to the workers, and when
+  // the pool is shutting down.
+  Semaphore wake_sem_;
+
+  std::vector<Worker*> workers_;
+  // Number of workers waiting for work.
+  size_t idle_workers_;
+  size_t peak_thread_count_;
+  bool shutting_down_;
+
+  uint64_t next_sequence_;
+  // Tasks that are not due yet, kept as a heap ordered by TimerComparer. This
+  // is not a std::priority_queue so that a queue's timers can be removed when
+  // it shuts down.
+  std::vector<Timer> timers_;
+  // Used to number worker threads in their names.
+  int next_worker_index_;
+
+  // Queues that have a task ready to run, and are not running one already.
+  std::deque<SerialQueue*> runnable_;
+};
+
+// A sequence of tasks that run one at a time on a ThreadPool.
+//
+// Tasks run in the order they become due. Tasks with the same due time run in
+// the order they were posted.
+class SerialQueue {
+ public:
+  explicit SerialQueue(ThreadPool* pool);
+
+  // Discards pending tasks and waits for a running task to finish, as
+  // Shutdown() does.
+  ~SerialQueue();
+
+  SerialQueue(const SerialQueue&) = delete;
+  SerialQueue& operator=(const SerialQueue&) = delete;
+
+  // Run the task, which the queue takes ownership of, after the given delay.
+  // Tasks posted after Shutdown() are discarded.
+  void Post(callback::Callback* task, uint64_t delay_ms = 0);
+
+  // Discard all pending tasks, and stop accepting new ones. If a task is
+  // running on another thread, this waits for it to finish. It is safe to call
+  // this from a task running on this queue.
+  void Shutdown();
+
+  // Whether the calling thread is running a task from this queue.
+  bool IsCurrentThread() const;
+
+ private:
+  friend class ThreadPool;
+
+  ThreadPool* pool_;
+
+  // Everything below is guarded by the pool's mutex.
+
+  // Tasks that are due, in the order they should run.
+  std::deque<callback::Callback*> ready_;
+  // Number of this queue's tasks in the pool's timers.
+  size_t pending_timers_;
+  // Whether the queue is in the pool's runnable list or running a task.
+  bool scheduled_;
+  bool running_;
+  Thread::Id running_thread_;
+  bool shut_down_;
+  // Posted when the running task finishes, if Shutdown() is waiting for it.
+  Semaphore* idle_sem_;
+};
+
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
+
+#endif  // FIREBASE_APP_SRC_THREAD_POOL_H_
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/trace.h"
+
+#include <stdio.h>
+
+#include <atomic>
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/include/firebase/internal/platform.h"
+#include "app/src/time.h"
+
+#if FIREBASE_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif  // FIREBASE_PLATFORM_WINDOWS
+
+namespace firebase {
+namespace internal {
+
+namespace {
+
+// Number of events kept for each thread.
+const uint64_t kEventsPerThread = 4096;
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  // Chrome trace event phase: 'X' for complete events, 'i' for instant
+  // events.
+  char phase;
+  Trace::FlowPhase flow_phase;
+  int thread_id;
+  uint64_t flow_id;
+  uint64_t start_us;
+  uint64_t duration_us;
+};
+
+// A TraceEvent stored as words that can be read while the owning thread
+// overwrites them.
+enum EventWord {
+  kWordCategory,
+  kWordName,
+  // phase, flow_phase << 8 and thread_id << 32.
+  kWordKind,
+  kWordFlowId,
+  kWordStart,
+  kWordDuration,
+  kWordCount
+};
+
+struct TraceSlot {
+  // Odd while the owning thread is writing the slot, otherwise
+  // 2 * (index of the event in the slot + 1). Readers use this to detect
+  // events that were overwritten while being read.
+  std::atomic<uint64_t> sequence;
+  std::atomic<uint64_t> words[kWordCount];
+};
+
+// Events recorded by one thread at a time. Only the owning thread writes to
+// a buffer. When the thread exits the buffer goes to a free list and is
+// reused by the next thread that records an event, so there are never more
+// buffers than threads that recorded events at the same time. Buffers are
+// never freed, so that a trace can be read while threads exit, and the
+// events of an exited thread are kept until its buffer is reused and
+// wraps around.
+struct ThreadBuffer {
+  ThreadBuffer() : thread_id(0), next_buffer(nullptr), next_free(nullptr) {}
+
+  // ID of the thread that owns the buffer.
+  int thread_id;
+  // Index of the next event to write.
+  compat::Atomic<uint64_t> end;
+  // Index of the first event not discarded by Trace::Clear().
+  compat::Atomic<uint64_t> begin;
+  TraceSlot slots[kEventsPerThread];
+  ThreadBuffer* next_buffer;
+  ThreadBuffer* next_free;
+};
+
+// All thread buffers, newest first, and the ones not owned by a thread.
+struct BufferList {
+  BufferList()
+      : mutex(Mutex::kModeNonRecursive),
+        head(nullptr),
+        free_head(nullptr),
+        count(0),
+        thread_count(0) {}
+
+  Mutex mutex;
+  ThreadBuffer* head;
+  ThreadBuffer* free_head;
+  int count;
+  int thread_count;
+};
+
+BufferList* GetBufferList() {
+  static BufferList* buffer_list = new BufferList();
+  return buffer_list;
+}
+
+ThreadBuffer* AcquireThreadBuffer() {
+  BufferList* buffer_list = GetBufferList();
+  MutexLock lock(buffer_list->mutex);
+  ThreadBuffer* buffer = buffer_list->free_head;
+  if (buffer) {
+    buffer_list->free_head = buffer->next_free;
+    buffer->next_free = nullptr;
+  } else {
+    buffer = new ThreadBuffer();
+    buffer->next_buffer = buffer_list->head;
+    buffer_list->head = buffer;
+    ++buffer_list->count;
+  }
+  buffer->thread_id = ++buffer_list->thread_count;
+  return buffer;
+}
+
+// Called when a thread that recorded events exits.
+#if FIREBASE_PLATFORM_WINDOWS
+void WINAPI ReleaseThreadBuffer(void* data) {
+#else
+void ReleaseThreadBuffer(void* data) {
+#endif  // FIREBASE_PLATFORM_WINDOWS
+  if (!data) return;
+  ThreadBuffer* buffer = static_cast<ThreadBuffer*>(data);
+  BufferList* buffer_list = GetBufferList();
+  MutexLock lock(buffer_list->mutex);
+  buffer->next_free = buffer_list->free_head;
+  buffer_list->free_head = buffer;
+}
+
+// Returns the calling thread's buffer, acquiring it on first use.
+#if FIREBASE_PLATFORM_WINDOWS
+ThreadBuffer* GetThreadBuffer() {
+  // Unlike TLS, fiber local storage calls back when a thread exits.
+  static DWORD fls_index = FlsAlloc(ReleaseThreadBuffer);
+  ThreadBuffer* buffer = static_cast<ThreadBuffer*>(FlsGetValue(fls_index));
+  if (!buffer) {
+    buffer = AcquireThreadBuffer();
+    FlsSetValue(fls_index, buffer);
+  }
+  return buffer;
+}
+#else
+pthread_key_t CreateThreadBufferKey() {
+  pthread_key_t key;
+  pthread_key_create(&key, ReleaseThreadBuffer);
+  return key;
+}
+
+ThreadBuffer* GetThreadBuffer() {
+  static pthread_key_t key = CreateThreadBufferKey();
+  ThreadBuffer* buffer = static_cast<ThreadBuffer*>(pthread_getspecific(key));
+  if (!buffer) {
+    buffer = AcquireThreadBuffer();
+    pthread_setspecific(key, buffer);
+  }
+  return buffer;
+}
+#endif  // FIREBASE_PLATFORM_WINDOWS
+
+// Writes and reads slots as a sequence lock, with every word of the event
+// accessed atomically so that a read racing with a write is well defined.
+void RecordEvent(const TraceEvent& event) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  uint64_t index = buffer->end.load();
+  TraceSlot& slot = buffer->slots[index % kEventsPerThread];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  uint64_t words[kWordCount];
+  words[kWordCategory] = reinterpret_cast<uintptr_t>(event.category);
+  words[kWordName] = reinterpret_cast<uintptr_t>(event.name);
+  words[kWordKind] = static_cast<unsigned char>(event.phase) |
+                     (static_cast<uint64_t>(event.flow_phase) << 8) |
+                     (static_cast<uint64_t>(buffer->thread_id) << 32);
+  words[kWordFlowId] = event.flow_id;
+  words[kWordStart] = event.start_us;
+  words[kWordDuration] = event.duration_us;
+  for (int i = 0; i < kWordCount; ++i) {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  buffer->end.store(index + 1);
+}
+
+// Copies the event at index out of its slot. Returns false if the slot does
+// not hold it, or the owning thread overwrote it while it was copied.
+bool ReadEvent(const ThreadBuffer& buffer, uint64_t index, TraceEvent* event) {
+  const TraceSlot& slot = buffer.slots[index % kEventsPerThread];
+  uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence != 2 * index + 2) return false;
+  uint64_t words[kWordCount];
+  for (int i = 0; i < kWordCount; ++i) {
+    words[i] = slot.words[i].load(std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence.load(std::memory_order_relaxed) != sequence) return false;
+  event->category = reinterpret_cast<const char*>(
+      static_cast<uintptr_t>(words[kWordCategory]));
+  event->name =
+      reinterpret_cast<const char*>(static_cast<uintptr_t>(words[kWordName]));
+  event->phase = static_cast<char>(words[kWordKind] & 0xff);
+  event->flow_phase =
+      static_cast<Trace::FlowPhase>((words[kWordKind] >> 8) & 0xff);
+  event->thread_id = static_cast<int>(words[kWordKind] >> 32);
+  event->flow_id = words[kWordFlowId];
+  event->start_us = words[kWordStart];
+  event->duration_us = words[kWordDuration];
+  return true;
+}
+
+void AppendJsonString(const char* value, std::string* json) {
+  json->push_back('"');
+  for (const char* c = value; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      json->push_back('\\');
+      json->push_back(*c);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+      json->append(escaped);
+    } else {
+      json->push_back(*c);
+    }
+  }
+  json->push_back('"');
+}
+
+void AppendEventJson(const TraceEvent& event, char phase, int thread_id,
+                     uint64_t timestamp_us, std::string* json) {
+  if (json->size() > 1) json->push_back(',');
+  json->append("{\"name\":");
+  AppendJsonString(event.name, json);
+  json->append(",\"cat\":");
+  AppendJsonString(event.category, json);
+  char fields[160];
+  snprintf(fields, sizeof(fields),
+           ",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%llu", phase,
+           thread_id, static_cast<unsigned long long>(timestamp_us));
+  json->append(fields);
+  if (phase == 'X') {
+    snprintf(fields, sizeof(fields), ",\"dur\":%llu",
+             static_cast<unsigned long long>(event.duration_us));
+    json->append(fields);
+  } else if (phase == 'i') {
+    json->append(",\"s\":\"t\"");
+  } else {
+    snprintf(fields, sizeof(fields), ",\"id\":%llu",
+             static_cast<unsigned long long>(event.flow_id));
+    json->append(fields);
+    // Bind the end of the flow to the event it is recorded with, rather than
+    // the next event on the thread.
+    if (phase == 'f') json->append(",\"bp\":\"e\"");
+  }
+  json->push_back('}');
+}
+
+// Appends the event, and the flow event linked to it if any.
+void AppendEventsJson(const TraceEvent& event, std::string* json) {
+  AppendEventJson(event, event.phase, event.thread_id, event.start_us, json);
+  if (event.flow_id != 0) {
+    char flow_phase = 0;
+    switch (event.flow_phase) {
+      case Trace::kFlowBegin:
+        flow_phase = 's';
+        break;
+      case Trace::kFlowStep:
+        flow_phase = 't';
+        break;
+      case Trace::kFlowEnd:
+        flow_phase = 'f';
+        break;
+      case Trace::kFlowNone:
+        break;
+    }
+    if (flow_phase) {
+      AppendEventJson(event, flow_phase, event.thread_id, event.start_us,
+                      json);
+    }
+  }
+}
+
+}  // namespace
+
+compat::Atomic<int> Trace::enabled_;
+
+void Trace::SetEnabled(bool enabled) {
+  // Make sure the tick period is known before any span reads the timer.
+  Timer::InitializeTickPeriod();
+  enabled_.store(enabled ? 1 : 0);
+}
+
+void Trace::Clear() {
+  BufferList* buffer_list = GetBufferList();
+  MutexLock lock(buffer_list->mutex);
+  for (ThreadBuffer* buffer = buffer_list->head; buffer;
+       buffer = buffer->next_buffer) {
+    buffer->begin.store(buffer->end.load());
+  }
+}
+
+std::string Trace::ToJson() {
+  std::string json("[");
+  BufferList* buffer_list = GetBufferList();
+  ThreadBuffer* head;
+  {
+    MutexLock lock(buffer_list->mutex);
+    head = buffer_list->head;
+  }
+  // Buffers are only ever added to the front of the list, so it can be walked
+  // without holding the lock.
+  for (ThreadBuffer* buffer = head; buffer; buffer = buffer->next_buffer) {
+    uint64_t end = buffer->end.load();
+    uint64_t begin = buffer->begin.load();
+    if (end > kEventsPerThread && begin < end - kEventsPerThread) {
+      begin = end - kEventsPerThread;
+    }
+    for (uint64_t index = begin; index < end; ++index) {
+      TraceEvent event;
+      if (ReadEvent(*buffer, index, &event)) AppendEventsJson(event, &json);
+    }
+  }
+  json.append("]");
+  return std::string("{\"traceEvents\":") + json +
+         ",\"displayTimeUnit\":\"ms\"}";
+}
+
+int Trace::ThreadBufferCount() {
+  BufferList* buffer_list = GetBufferList();
+  MutexLock lock(buffer_list->mutex);
+  return buffer_list->count;
+}
+
+bool Trace::WriteJson(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (!file) return false;
+  std::string json = ToJson();
+  bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+  return fclose(file) == 0 && written;
+}
+
+uint64_t Trace::NewFlowId() {
+  static compat::Atomic<uint64_t> next_flow_id;
+  return IsEnabled() ? next_flow_id.fetch_add(1) + 1 : 0;
+}
+
+uint64_t Trace::NowMicroseconds() {
+  return static_cast<uint64_t>(static_cast<double>(Timer::GetTicks()) *
+                               Timer::GetTickPeriod() * 1000000.0);
+}
+
+void Trace::AddInstant(const char* category, const char* name) {
+  TraceEvent event;
+  event.category = category;
+  event.name = name;
+  event.phase = 'i';
+  event.flow_phase = kFlowNone;
+  event.flow_id = 0;
+  event.start_us = NowMicroseconds();
+  event.duration_us = 0;
+  RecordEvent(event);
+}
+
+void Trace::AddComplete(const char* category, const char* name,
+                        uint64_t start_us, uint64_t duration_us,
+                        uint64_t flow_id, FlowPhase flow_phase) {
+  TraceEvent event;
+  event.category = category;
+  event.name = name;
+  event.phase = 'X';
+  event.flow_phase = flow_phase;
+  event.flow_id = flow_id;
+  event.start_us = start_us;
+  event.duration_us = duration_us;
+  RecordEvent(event);
+}
+
+}  // namespace internal
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
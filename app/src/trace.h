@@ -0,0 +1,192 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIREBASE_APP_SRC_TRACE_H_
+#define FIREBASE_APP_SRC_TRACE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "app/memory/atomic.h"
+
+// Lightweight tracing of the SDK's internal work, written out in the Chrome
+// trace event format, which chrome://tracing and https://ui.perfetto.dev can
+// display.
+//
+// Code is instrumented with the FIREBASE_TRACE_* macros below. Tracing is off
+// until Trace::SetEnabled(true) is called, and while it is off each macro
+// costs one atomic load. Building with FIREBASE_DISABLE_TRACING defined
+// removes the macros entirely.
+//
+// Each thread records events into its own fixed size ring buffer without
+// taking any locks, so only the most recent events of each thread are kept.
+//
+// Work that hops between threads, such as a request that is scheduled on one
+// thread and run on another, is linked with a flow ID:
+//
+//   uint64_t flow_id = FIREBASE_TRACE_NEW_FLOW_ID();
+//   FIREBASE_TRACE_FLOW_BEGIN("scheduler", "Schedule", flow_id);
+//   ...
+//   // Later, on another thread.
+//   FIREBASE_TRACE_SCOPE_FLOW_END("scheduler", "Run", flow_id);
+//
+// Category and event names must be string literals, or otherwise outlive the
+// trace.
+
+namespace firebase {
+namespace internal {
+
+class Trace {
+ public:
+  // Start or stop recording events. Events already recorded are kept.
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled() { return enabled_.load() != 0; }
+
+  // Discard all recorded events.
+  static void Clear();
+
+  // Return the recorded events as a Chrome trace format JSON object.
+  static std::string ToJson();
+
+  // Write the recorded events as Chrome trace format JSON to a file.
+  // Returns false if the file could not be written.
+  static bool WriteJson(const char* path);
+
+  // The number of per-thread event buffers allocated so far. Threads that
+  // exit hand their buffer to the next thread that records an event.
+  static int ThreadBufferCount();
+
+  // Return a new ID to link events in a flow, or 0 if tracing is disabled.
+  static uint64_t NewFlowId();
+
+  // Microseconds since an arbitrary point, used to timestamp events.
+  static uint64_t NowMicroseconds();
+
+  // Record an instantaneous event.
+  static void AddInstant(const char* category, const char* name);
+
+  // Record an event that started at start_us and lasted duration_us. If
+  // flow_id is not 0, the event is also linked to the flow: it starts the flow
+  // if flow_phase is kFlowBegin, continues it if kFlowStep, or ends it if
+  // kFlowEnd.
+  enum FlowPhase { kFlowNone, kFlowBegin, kFlowStep, kFlowEnd };
+  static void AddComplete(const char* category, const char* name,
+                          uint64_t start_us, uint64_t duration_us,
+                          uint64_t flow_id = 0,
+                          FlowPhase flow_phase = kFlowNone);
+
+ private:
+  static compat::Atomic<int> enabled_;
+};
+
+// Records an event covering the lifetime of this object, if tracing is
+// enabled when it is created.
+class TraceSpan {
+ public:
+  TraceSpan(const char* category, const char* name, uint64_t flow_id = 0,
+            Trace::FlowPhase flow_phase = Trace::kFlowNone)
+      : category_(category),
+        name_(name),
+        flow_id_(flow_id),
+        flow_phase_(flow_phase),
+        start_us_(0),
+        enabled_(Trace::IsEnabled()) {
+    if (enabled_) start_us_ = Trace::NowMicroseconds();
+  }
+
+  ~TraceSpan() {
+    if (enabled_) {
+      Trace::AddComplete(category_, name_, start_us_,
+                         Trace::NowMicroseconds() - start_us_, flow_id_,
+                         flow_phase_);
+    }
+  }
+
+ private:
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  const char* category_;
+  const char* name_;
+  uint64_t flow_id_;
+  Trace::FlowPhase flow_phase_;
+  uint64_t start_us_;
+  bool enabled_;
+};
+
+}  // namespace internal
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace firebase
+
+#define FIREBASE_TRACE_CONCAT_INNER(a, b) a##b
+#define FIREBASE_TRACE_CONCAT(a, b) FIREBASE_TRACE_CONCAT_INNER(a, b)
+
+#if defined(FIREBASE_DISABLE_TRACING)
+
+#define FIREBASE_TRACE_NEW_FLOW_ID() (static_cast<uint64_t>(0))
+#define FIREBASE_TRACE_SCOPE(category, name)
+#define FIREBASE_TRACE_SCOPE_FLOW(category, name, flow_id, flow_phase)
+#define FIREBASE_TRACE_SCOPE_FLOW_END(category, name, flow_id)
+#define FIREBASE_TRACE_FLOW_BEGIN(category, name, flow_id)
+#define FIREBASE_TRACE_INSTANT(category, name)
+
+#else  // !defined(FIREBASE_DISABLE_TRACING)
+
+// Evaluates to a new flow ID, or 0 if tracing is disabled.
+#define FIREBASE_TRACE_NEW_FLOW_ID() (::firebase::internal::Trace::NewFlowId())
+
+// Records an event covering the rest of the enclosing scope.
+#define FIREBASE_TRACE_SCOPE(category, name)                         \
+  ::firebase::internal::TraceSpan FIREBASE_TRACE_CONCAT(trace_span_, \
+                                                        __LINE__)(   \
+      category, name)
+
+// Records an event covering the rest of the enclosing scope, which is linked
+// to the given flow as described by a Trace::FlowPhase.
+#define FIREBASE_TRACE_SCOPE_FLOW(category, name, flow_id, flow_phase) \
+  ::firebase::internal::TraceSpan FIREBASE_TRACE_CONCAT(trace_span_,   \
+                                                        __LINE__)(     \
+      category, name, flow_id, flow_phase)
+
+// Records an event covering the rest of the enclosing scope, which ends the
+// given flow.
+#define FIREBASE_TRACE_SCOPE_FLOW_END(category, name, flow_id)       \
+  ::firebase::internal::TraceSpan FIREBASE_TRACE_CONCAT(trace_span_, \
+                                                        __LINE__)(   \
+      category, name, flow_id, ::firebase::internal::Trace::kFlowEnd)
+
+// Records a short event that starts the given flow.
+#define FIREBASE_TRACE_FLOW_BEGIN(category, name, flow_id)                 \
+  do {                                                                     \
+    if ((flow_id) != 0) {                                                  \
+      ::firebase::internal::Trace::AddComplete(                            \
+          category, name, ::firebase::internal::Trace::NowMicroseconds(), \
+          0, flow_id, ::firebase::internal::Trace::kFlowBegin);           \
+    }                                                                      \
+  } while (0)
+
+// Records an instantaneous event.
+#define FIREBASE_TRACE_INSTANT(category, name)                 \
+  do {                                                         \
+    if (::firebase::internal::Trace::IsEnabled()) {            \
+      ::firebase::internal::Trace::AddInstant(category, name); \
+    }                                                          \
+  } while (0)
+
+#endif  // defined(FIREBASE_DISABLE_TRACING)
+
+#endif  // FIREBASE_APP_SRC_TRACE_H_
@@ -18,15 +18,140 @@
 
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <atomic>
 #include <iomanip>
+#include <new>
 #include <sstream>
+#include <unordered_map>
 
 #include "app/src/assert.h"
+#include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/include/firebase/internal/platform.h"
 
 namespace firebase {
 
+namespace {
+
+// The header of the buffer holding an interned string. The characters of the
+// string, including a null terminator, follow it in the same allocation, so a
+// Variant only needs to store a pointer to the characters.
+struct InternedString {
+  std::atomic<int32_t> ref_count;
+  size_t size;
+
+  char* chars() { return reinterpret_cast<char*>(this + 1); }
+
+  static InternedString* FromChars(const char* chars) {
+    return reinterpret_cast<InternedString*>(const_cast<char*>(chars)) - 1;
+  }
+};
+
+// A string that the intern table is keyed by, without owning the characters.
+struct InternKey {
+  const char* data;
+  size_t size;
+
+  bool operator==(const InternKey& other) const {
+    return size == other.size && memcmp(data, other.data, size) == 0;
+  }
+};
+
+struct InternKeyHash {
+  size_t operator()(const InternKey& key) const {
+    // FNV-1a.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < key.size; ++i) {
+      hash ^= static_cast<uint8_t>(key.data[i]);
+      hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+// Every live interned string, keyed by its contents. Strings are removed when
+// the last Variant referring to them is destroyed.
+struct InternTable {
+  Mutex mutex;
+  std::unordered_map<InternKey, InternedString*, InternKeyHash> strings;
+};
+
+InternTable& GetInternTable() {
+  // Never destroyed, so that Variants in static storage can still release
+  // their strings during shutdown.
+  static InternTable* table = new InternTable();
+  return *table;
+}
+
+const char* InternString(const char* data, size_t size) {
+  InternTable& table = GetInternTable();
+  MutexLock lock(table.mutex);
+  auto found = table.strings.find(InternKey{data, size});
+  if (found != table.strings.end()) {
+    found->second->ref_count.fetch_add(1, std::memory_order_relaxed);
+    return found->second->chars();
+  }
+  void* buffer = ::operator new(sizeof(InternedString) + size + 1);
+  InternedString* interned = new (buffer) InternedString();
+  interned->ref_count.store(1, std::memory_order_relaxed);
+  interned->size = size;
+  memcpy(interned->chars(), data, size);
+  interned->chars()[size] = '\0';
+  table.strings[InternKey{interned->chars(), size}] = interned;
+  return interned->chars();
+}
+
+void RetainInternedString(const char* chars) {
+  InternedString::FromChars(chars)->ref_count.fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void ReleaseInternedString(const char* chars) {
+  InternedString* interned = InternedString::FromChars(chars);
+  // Other references can be dropped without the lock. The last one must be
+  // dropped under the lock, so that InternString cannot find the string while
+  // it is being freed.
+  int32_t count = interned->ref_count.load(std::memory_order_relaxed);
+  while (count > 1) {
+    if (interned->ref_count.compare_exchange_weak(count, count - 1,
+                                                  std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+  InternTable& table = GetInternTable();
+  MutexLock lock(table.mutex);
+  if (interned->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    table.strings.erase(InternKey{interned->chars(), interned->size});
+    interned->~InternedString();
+    ::operator delete(interned);
+  }
+}
+
+}  // namespace
+
+Variant Variant::FromInternedString(const char* value, size_t size) {
+  Variant v;
+  if (size < kMaxSmallStringSize) {
+    // Short strings are cheaper to store inline than to share.
+    v.set_mutable_string(std::string(value, size));
+    return v;
+  }
+  v.Clear(static_cast<Type>(kInternalTypeInternedString));
+  v.value_.interned_string_value = InternString(value, size);
+  return v;
+}
+
+size_t Variant::string_size() const {
+  assert_is_string();
+  if (type_ == kInternalTypeMutableString) {
+    return value_.mutable_string_value->size();
+  } else if (type_ == kInternalTypeInternedString) {
+    return InternedString::FromChars(value_.interned_string_value)->size;
+  }
+  return strlen(string_value());
+}
+
 Variant& Variant::operator=(const Variant& other) {
   if (this != &other) {
     Clear(static_cast<Type>(other.type_));
@@ -58,6 +183,11 @@ Variant& Variant::operator=(const Variant& other) {
         strcpy(value_.small_string, other.value_.small_string);  // NOLINT
         break;
       }
+      case kInternalTypeInternedString: {
+        value_.interned_string_value = other.value_.interned_string_value;
+        RetainInternedString(value_.interned_string_value);
+        break;
+      }
       case kInternalTypeVector: {
         set_vector(other.vector());
         break;
@@ -123,6 +253,11 @@ Variant& Variant::operator=(Variant&& other) noexcept {
         other.value_.small_string[0] = '\0';
         break;
       }
+      case kInternalTypeInternedString: {
+        value_.interned_string_value = other.value_.interned_string_value;
+        other.value_.interned_string_value = nullptr;
+        break;
+      }
       case kInternalTypeVector: {
         value_.vector_value = other.value_.vector_value;
         other.value_.vector_value = nullptr;
@@ -173,6 +308,13 @@ bool Variant::operator==(const Variant& other) const {
     case kInternalTypeMutableString:
     case kInternalTypeStaticString:
     case kInternalTypeSmallString:
+    case kInternalTypeInternedString:
+      // Interned copies of the same string share a buffer.
+      if (type_ == kInternalTypeInternedString &&
+          other.type_ == kInternalTypeInternedString) {
+        return value_.interned_string_value ==
+               other.value_.interned_string_value;
+      }
       // string == performs string comparison
       return strcmp(string_value(), other.string_value()) == 0;
     case kInternalTypeVector:
@@ -197,6 +339,16 @@ bool Variant::operator==(const Variant& other) const {
 }
 
 bool Variant::operator<(const Variant& other) const {
+  // Strings are by far the most common map keys, so compare them directly.
+  if (is_string() && other.is_string()) {
+    if (type_ == kInternalTypeInternedString &&
+        other.type_ == kInternalTypeInternedString &&
+        value_.interned_string_value == other.value_.interned_string_value) {
+      return false;
+    }
+    return strcmp(string_value(), other.string_value()) < 0;
+  }
+
   Type left_type = type();
   Type right_type = other.type();
 
@@ -245,6 +397,7 @@ bool Variant::operator<(const Variant& other) const {
     case kInternalTypeMutableString:
     case kInternalTypeStaticString:
     case kInternalTypeSmallString:
+    case kInternalTypeInternedString:
       return strcmp(string_value(), other.string_value()) < 0;
     case kInternalTypeVector: {
       auto i = vector().begin();
@@ -318,6 +471,13 @@ void Variant::Clear(Type new_type) {
       value_.small_string[0] = '\0';
       break;
     }
+    case kInternalTypeInternedString: {
+      if (value_.interned_string_value != nullptr) {
+        ReleaseInternedString(value_.interned_string_value);
+        value_.interned_string_value = nullptr;
+      }
+      break;
+    }
     case kInternalTypeVector: {
       if (new_type != kTypeVector || value_.vector_value == nullptr) {
         delete value_.vector_value;
@@ -384,6 +544,10 @@ void Variant::Clear(Type new_type) {
       value_.small_string[0] = '\0';
       break;
     }
+    case kInternalTypeInternedString: {
+      value_.interned_string_value = nullptr;
+      break;
+    }
     case kInternalTypeVector: {
       if (old_type != kInternalTypeVector || value_.vector_value == nullptr) {
         value_.vector_value = new std::vector<Variant>(0);
@@ -414,7 +578,8 @@ const char* const Variant::kTypeNames[] = {
     // In case you want to iterate through these for some reason.
     "Null",         "Int64",         "Double",      "Bool",
     "StaticString", "MutableString", "Vector",      "Map",
-    "StaticBlob",   "MutableBlob",   "SmallString", nullptr,
+    "StaticBlob",   "MutableBlob",   "SmallString", "InternedString",
+    nullptr,
 };
 
 void Variant::assert_is_type(Variant::Type type) const {
@@ -485,7 +650,8 @@ Variant Variant::AsString() const {
     }
     case kInternalTypeMutableString:
     case kInternalTypeStaticString:
-    case kInternalTypeSmallString: {
+    case kInternalTypeSmallString:
+    case kInternalTypeInternedString: {
       return *this;
     }
     default: {
@@ -507,7 +673,8 @@ Variant Variant::AsInt64() const {
     }
     case kInternalTypeMutableString:
     case kInternalTypeStaticString:
-    case kInternalTypeSmallString: {
+    case kInternalTypeSmallString:
+    case kInternalTypeInternedString: {
       return Variant::FromInt64(strtol(string_value(), nullptr, 10));  // NOLINT
     }
     default: {
@@ -529,7 +696,8 @@ Variant Variant::AsDouble() const {
     }
     case kInternalTypeMutableString:
     case kInternalTypeStaticString:
-    case kInternalTypeSmallString: {
+    case kInternalTypeSmallString:
+    case kInternalTypeInternedString: {
       return Variant::FromDouble(strtod(string_value(), nullptr));
     }
     default: {
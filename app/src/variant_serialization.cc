@@ -0,0 +1,497 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/include/firebase/variant_serialization.h"
+
+#include <string.h>
+
+#include <new>
+
+#include "app/src/log.h"
+#include "flatbuffers/flexbuffers.h"
+
+#define FLEXBUFFER_BUILDER_STARTING_SIZE 512
+
+namespace firebase {
+
+namespace {
+
+// Every serialized buffer starts with this header, followed by a flexbuffer
+// holding the value. The header is padded to 8 bytes so that the flexbuffer
+// stays aligned.
+const uint8_t kMagic[] = {'F', 'V', 'A', 'R'};
+const uint8_t kFormatVersion = 1;
+const size_t kHeaderSize = 8;
+
+// Maps and vectors may be nested at most this deep, so that reading a buffer
+// can't run out of stack.
+const int kMaxDepth = 256;
+
+// A flexbuffer containing a single null value.
+const uint8_t kNullFlexbuffer[] = {0, 0, 1};
+
+flexbuffers::Reference NullReference() {
+  return flexbuffers::GetRoot(kNullFlexbuffer, sizeof(kNullFlexbuffer));
+}
+
+bool WriteVariant(const Variant& variant, int depth,
+                  flexbuffers::Builder* fbb);
+
+bool WriteMap(const std::map<Variant, Variant>& map, int depth,
+              flexbuffers::Builder* fbb) {
+  size_t start = fbb->StartMap();
+  for (auto iter = map.begin(); iter != map.end(); ++iter) {
+    // Flexbuffers only supports string keys. Converting other keys to strings
+    // could make two keys the same, such as 1 and "1", so they are rejected.
+    if (!iter->first.is_string()) {
+      LogError("Only strings may be used as map keys.");
+      fbb->EndMap(start);
+      return false;
+    }
+    // Keys are ordered by their null-terminated characters, so that is all
+    // that has to be stored to keep them apart.
+    const char* key = iter->first.string_value();
+    fbb->Key(key, strlen(key));
+    if (!WriteVariant(iter->second, depth, fbb)) {
+      fbb->EndMap(start);
+      return false;
+    }
+  }
+  fbb->EndMap(start);
+  return true;
+}
+
+bool WriteVector(const std::vector<Variant>& vector, int depth,
+                 flexbuffers::Builder* fbb) {
+  size_t start = fbb->StartVector();
+  for (auto iter = vector.begin(); iter != vector.end(); ++iter) {
+    if (!WriteVariant(*iter, depth, fbb)) {
+      fbb->EndVector(start, false, false);
+      return false;
+    }
+  }
+  fbb->EndVector(start, false, false);
+  return true;
+}
+
+bool WriteVariant(const Variant& variant, int depth,
+                  flexbuffers::Builder* fbb) {
+  switch (variant.type()) {
+    case Variant::kTypeNull:
+      fbb->Null();
+      return true;
+    case Variant::kTypeInt64:
+      fbb->Int(variant.int64_value());
+      return true;
+    case Variant::kTypeDouble:
+      fbb->Double(variant.double_value());
+      return true;
+    case Variant::kTypeBool:
+      fbb->Bool(variant.bool_value());
+      return true;
+    case Variant::kTypeStaticString:
+    case Variant::kTypeMutableString:
+      fbb->String(variant.string_value(), variant.string_size());
+      return true;
+    case Variant::kTypeVector:
+    case Variant::kTypeMap:
+      if (depth >= kMaxDepth) {
+        LogError("Variants nested more than %d deep can't be serialized.",
+                 kMaxDepth);
+        return false;
+      }
+      return variant.is_vector()
+                 ? WriteVector(variant.vector(), depth + 1, fbb)
+                 : WriteMap(variant.map(), depth + 1, fbb);
+    case Variant::kTypeStaticBlob:
+    case Variant::kTypeMutableBlob:
+      fbb->Blob(variant.blob_data(), variant.blob_size());
+      return true;
+  }
+  return false;
+}
+
+Variant ReadVariant(const flexbuffers::Reference& ref) {
+  switch (ref.GetType()) {
+    case flexbuffers::FBT_BOOL:
+      return Variant(ref.AsBool());
+    case flexbuffers::FBT_INT:
+    case flexbuffers::FBT_INDIRECT_INT:
+    case flexbuffers::FBT_UINT:
+    case flexbuffers::FBT_INDIRECT_UINT:
+      return Variant(ref.AsInt64());
+    case flexbuffers::FBT_FLOAT:
+    case flexbuffers::FBT_INDIRECT_FLOAT:
+      return Variant(ref.AsDouble());
+    case flexbuffers::FBT_STRING: {
+      flexbuffers::String str = ref.AsString();
+      return Variant(std::string(str.c_str(), str.size()));
+    }
+    case flexbuffers::FBT_BLOB: {
+      flexbuffers::Blob blob = ref.AsBlob();
+      return Variant::FromMutableBlob(blob.data(), blob.size());
+    }
+    case flexbuffers::FBT_VECTOR: {
+      flexbuffers::Vector vector = ref.AsVector();
+      Variant result = Variant::EmptyVector();
+      result.vector().reserve(vector.size());
+      for (size_t i = 0; i < vector.size(); i++) {
+        result.vector().push_back(ReadVariant(vector[i]));
+      }
+      return result;
+    }
+    case flexbuffers::FBT_MAP: {
+      flexbuffers::Map map = ref.AsMap();
+      flexbuffers::TypedVector keys = map.Keys();
+      flexbuffers::Vector values = map.Values();
+      Variant result = Variant::EmptyMap();
+      std::map<Variant, Variant>& result_map = result.map();
+      for (size_t i = 0; i < keys.size(); i++) {
+        // Keys are sorted, so each one can be appended to the end of the map.
+        Variant key(std::string(keys[i].AsKey()));
+        result_map.insert(result_map.end(),
+                          std::make_pair(key, ReadVariant(values[i])));
+      }
+      return result;
+    }
+    default:
+      // Nothing else is written by SerializeVariant.
+      return Variant::Null();
+  }
+}
+
+// Reads an unsigned little-endian integer of the given width in bytes, the way
+// flexbuffers stores sizes and offsets.
+uint64_t ReadUInt(const uint8_t* data, uint8_t width) {
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < width; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+bool IsValidWidth(uint64_t width) {
+  return width == 1 || width == 2 || width == 4 || width == 8;
+}
+
+// Checks that a flexbuffer holds only the types SerializeVariant() writes, and
+// that every size and offset in it stays inside the buffer. Flexbuffers are
+// read without any bounds checks, so a truncated or corrupted buffer has to be
+// caught before it is read.
+class BufferVerifier {
+ public:
+  BufferVerifier(const uint8_t* buffer, size_t size)
+      : buffer_(buffer), end_(buffer + size), values_left_(size) {}
+
+  bool VerifyRoot() {
+    // The buffer ends with the root value, its packed type and its width.
+    if (end_ - buffer_ < 3) return false;
+    uint8_t width = end_[-1];
+    if (!IsValidWidth(width) || end_ - buffer_ < 2 + width) return false;
+    return VerifyValue(end_ - 2 - width, width, end_[-2], 0);
+  }
+
+ private:
+  // Whether the given number of bytes starting at data are inside the buffer.
+  bool InBuffer(const uint8_t* data, uint64_t size) const {
+    return data >= buffer_ && data <= end_ &&
+           size <= static_cast<uint64_t>(end_ - data);
+  }
+
+  // Follows the offset of the given width stored at data. Offsets always point
+  // back towards the start of the buffer.
+  bool Indirect(const uint8_t* data, uint8_t width,
+                const uint8_t** target) const {
+    uint64_t offset = ReadUInt(data, width);
+    if (offset > static_cast<uint64_t>(data - buffer_)) return false;
+    *target = data - offset;
+    return true;
+  }
+
+  // Reads the size that prefixes a string, blob, vector or map.
+  bool ReadSize(const uint8_t* data, uint8_t width, uint64_t* size) const {
+    if (data - buffer_ < width) return false;
+    *size = ReadUInt(data - width, width);
+    return true;
+  }
+
+  // Verifies the value stored in parent_width bytes at data, which the caller
+  // has checked are inside the buffer.
+  bool VerifyValue(const uint8_t* data, uint8_t parent_width,
+                   uint8_t packed_type, int depth) {
+    // Values may share storage, so count them to bound the work done on a
+    // buffer that refers to the same values over and over.
+    if (values_left_ == 0) return false;
+    --values_left_;
+    uint8_t width = static_cast<uint8_t>(1 << (packed_type & 3));
+    const uint8_t* target;
+    uint64_t size;
+    switch (packed_type >> 2) {
+      case flexbuffers::FBT_NULL:
+      case flexbuffers::FBT_BOOL:
+      case flexbuffers::FBT_INT:
+      case flexbuffers::FBT_UINT:
+      case flexbuffers::FBT_FLOAT:
+        return true;
+      case flexbuffers::FBT_INDIRECT_INT:
+      case flexbuffers::FBT_INDIRECT_UINT:
+      case flexbuffers::FBT_INDIRECT_FLOAT:
+        return Indirect(data, parent_width, &target) &&
+               InBuffer(target, width);
+      case flexbuffers::FBT_STRING:
+        // Strings are followed by a null terminator.
+        return Indirect(data, parent_width, &target) &&
+               ReadSize(target, width, &size) && InBuffer(target, size) &&
+               target + size < end_ && target[size] == '\0';
+      case flexbuffers::FBT_BLOB:
+        return Indirect(data, parent_width, &target) &&
+               ReadSize(target, width, &size) && InBuffer(target, size);
+      case flexbuffers::FBT_VECTOR:
+        return depth < kMaxDepth && Indirect(data, parent_width, &target) &&
+               ReadSize(target, width, &size) &&
+               VerifyElements(target, width, size, depth + 1);
+      case flexbuffers::FBT_MAP:
+        return depth < kMaxDepth && Indirect(data, parent_width, &target) &&
+               ReadSize(target, width, &size) &&
+               VerifyKeys(target, width, size) &&
+               VerifyElements(target, width, size, depth + 1);
+      default:
+        // Nothing else is written by SerializeVariant.
+        return false;
+    }
+  }
+
+  // Verifies the elements of a vector or the values of a map. Each element is
+  // stored in width bytes, and followed by a packed type byte per element.
+  bool VerifyElements(const uint8_t* data, uint8_t width, uint64_t size,
+                      int depth) {
+    if (size > static_cast<uint64_t>(end_ - data) / (width + 1)) return false;
+    const uint8_t* types = data + size * width;
+    for (uint64_t i = 0; i < size; ++i) {
+      if (!VerifyValue(data + i * width, width, types[i], depth)) return false;
+    }
+    return true;
+  }
+
+  // Verifies the keys of a map. A map's size is preceded by the offset to a
+  // vector of its keys and the width of that vector's elements, each of which
+  // is the offset to a null-terminated key.
+  bool VerifyKeys(const uint8_t* data, uint8_t width, uint64_t size) {
+    if (data - buffer_ < 3 * width) return false;
+    const uint8_t* keys_field = data - 3 * width;
+    uint64_t keys_width = ReadUInt(keys_field + width, width);
+    const uint8_t* keys;
+    uint64_t keys_size;
+    if (!IsValidWidth(keys_width) || !Indirect(keys_field, width, &keys) ||
+        !ReadSize(keys, static_cast<uint8_t>(keys_width), &keys_size) ||
+        keys_size != size ||
+        size > static_cast<uint64_t>(end_ - keys) / keys_width) {
+      return false;
+    }
+    for (uint64_t i = 0; i < size; ++i) {
+      const uint8_t* key;
+      if (!Indirect(keys + i * keys_width, static_cast<uint8_t>(keys_width),
+                    &key) ||
+          memchr(key, '\0', end_ - key) == nullptr) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const uint8_t* buffer_;
+  const uint8_t* end_;
+  size_t values_left_;
+};
+
+}  // namespace
+
+namespace internal {
+
+// Converts between a SerializedVariant and the flexbuffer reference it stores.
+class SerializedVariantHelper {
+ public:
+  static const flexbuffers::Reference& Get(const SerializedVariant& view) {
+    return *reinterpret_cast<const flexbuffers::Reference*>(
+        view.reference_.bytes);
+  }
+
+  static void Set(SerializedVariant* view, const flexbuffers::Reference& ref) {
+    static_assert(
+        sizeof(flexbuffers::Reference) <= sizeof(SerializedVariant::Storage),
+        "SerializedVariant::Storage is too small for flexbuffers::Reference");
+    new (view->reference_.bytes) flexbuffers::Reference(ref);
+  }
+
+  static SerializedVariant Make(const flexbuffers::Reference& ref,
+                                bool valid) {
+    SerializedVariant view;
+    Set(&view, ref);
+    view.valid_ = valid;
+    return view;
+  }
+};
+
+}  // namespace internal
+
+using internal::SerializedVariantHelper;
+
+bool SerializeVariant(const Variant& variant, std::vector<uint8_t>* output) {
+  flexbuffers::Builder fbb(FLEXBUFFER_BUILDER_STARTING_SIZE);
+  if (!WriteVariant(variant, 0, &fbb)) return false;
+  fbb.Finish();
+  const std::vector<uint8_t>& buffer = fbb.GetBuffer();
+
+  output->clear();
+  output->reserve(kHeaderSize + buffer.size());
+  output->insert(output->end(), kMagic, kMagic + sizeof(kMagic));
+  output->push_back(kFormatVersion);
+  output->resize(kHeaderSize, 0);
+  output->insert(output->end(), buffer.begin(), buffer.end());
+  return true;
+}
+
+bool DeserializeVariant(const uint8_t* data, size_t size, Variant* output) {
+  SerializedVariant view = SerializedVariant::FromBuffer(data, size);
+  if (!view.is_valid()) return false;
+  BufferVerifier verifier(data + kHeaderSize, size - kHeaderSize);
+  if (!verifier.VerifyRoot()) {
+    LogError("Unable to read corrupt serialized Variant");
+    return false;
+  }
+  *output = view.ToVariant();
+  return true;
+}
+
+SerializedVariant::SerializedVariant() : valid_(false) {
+  SerializedVariantHelper::Set(this, NullReference());
+}
+
+SerializedVariant SerializedVariant::FromBuffer(const uint8_t* data,
+                                                size_t size) {
+  // The smallest flexbuffer is a one byte value followed by its type and
+  // width.
+  if (data == nullptr || size < kHeaderSize + 3 ||
+      memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    return SerializedVariant();
+  }
+  // Versions are only ever added to, so any version up to the current one can
+  // be read.
+  uint8_t version = data[sizeof(kMagic)];
+  if (version == 0 || version > kFormatVersion) {
+    LogError("Unable to read serialized Variant with format version %d",
+             static_cast<int>(version));
+    return SerializedVariant();
+  }
+  return SerializedVariantHelper::Make(
+      flexbuffers::GetRoot(data + kHeaderSize, size - kHeaderSize), true);
+}
+
+Variant::Type SerializedVariant::type() const {
+  switch (SerializedVariantHelper::Get(*this).GetType()) {
+    case flexbuffers::FBT_BOOL:
+      return Variant::kTypeBool;
+    case flexbuffers::FBT_INT:
+    case flexbuffers::FBT_INDIRECT_INT:
+    case flexbuffers::FBT_UINT:
+    case flexbuffers::FBT_INDIRECT_UINT:
+      return Variant::kTypeInt64;
+    case flexbuffers::FBT_FLOAT:
+    case flexbuffers::FBT_INDIRECT_FLOAT:
+      return Variant::kTypeDouble;
+    case flexbuffers::FBT_STRING:
+      return Variant::kTypeStaticString;
+    case flexbuffers::FBT_BLOB:
+      return Variant::kTypeStaticBlob;
+    case flexbuffers::FBT_VECTOR:
+      return Variant::kTypeVector;
+    case flexbuffers::FBT_MAP:
+      return Variant::kTypeMap;
+    default:
+      return Variant::kTypeNull;
+  }
+}
+
+int64_t SerializedVariant::int64_value() const {
+  return SerializedVariantHelper::Get(*this).AsInt64();
+}
+
+double SerializedVariant::double_value() const {
+  return SerializedVariantHelper::Get(*this).AsDouble();
+}
+
+bool SerializedVariant::bool_value() const {
+  return SerializedVariantHelper::Get(*this).AsBool();
+}
+
+const char* SerializedVariant::string_value() const {
+  return SerializedVariantHelper::Get(*this).AsString().c_str();
+}
+
+size_t SerializedVariant::string_size() const {
+  return SerializedVariantHelper::Get(*this).AsString().size();
+}
+
+const uint8_t* SerializedVariant::blob_data() const {
+  return SerializedVariantHelper::Get(*this).AsBlob().data();
+}
+
+size_t SerializedVariant::blob_size() const {
+  return SerializedVariantHelper::Get(*this).AsBlob().size();
+}
+
+size_t SerializedVariant::size() const {
+  const flexbuffers::Reference& ref = SerializedVariantHelper::Get(*this);
+  if (ref.GetType() == flexbuffers::FBT_VECTOR) return ref.AsVector().size();
+  if (ref.GetType() == flexbuffers::FBT_MAP) return ref.AsMap().size();
+  return 0;
+}
+
+SerializedVariant SerializedVariant::element(size_t index) const {
+  const flexbuffers::Reference& ref = SerializedVariantHelper::Get(*this);
+  if (ref.GetType() != flexbuffers::FBT_VECTOR) return SerializedVariant();
+  flexbuffers::Vector vector = ref.AsVector();
+  if (index >= vector.size()) return SerializedVariant();
+  return SerializedVariantHelper::Make(vector[index], valid_);
+}
+
+const char* SerializedVariant::key(size_t index) const {
+  const flexbuffers::Reference& ref = SerializedVariantHelper::Get(*this);
+  if (ref.GetType() != flexbuffers::FBT_MAP) return "";
+  flexbuffers::TypedVector keys = ref.AsMap().Keys();
+  if (index >= keys.size()) return "";
+  return keys[index].AsKey();
+}
+
+SerializedVariant SerializedVariant::value(size_t index) const {
+  const flexbuffers::Reference& ref = SerializedVariantHelper::Get(*this);
+  if (ref.GetType() != flexbuffers::FBT_MAP) return SerializedVariant();
+  flexbuffers::Vector values = ref.AsMap().Values();
+  if (index >= values.size()) return SerializedVariant();
+  return SerializedVariantHelper::Make(values[index], valid_);
+}
+
+SerializedVariant SerializedVariant::child(const char* key) const {
+  const flexbuffers::Reference& ref = SerializedVariantHelper::Get(*this);
+  if (ref.GetType() != flexbuffers::FBT_MAP) return SerializedVariant();
+  return SerializedVariantHelper::Make(ref.AsMap()[key], valid_);
+}
+
+Variant SerializedVariant::ToVariant() const {
+  return ReadVariant(SerializedVariantHelper::Get(*this));
+}
+
+}  // namespace firebase
@@ -16,6 +16,8 @@
 
 #include "app/src/variant_util.h"
 
+#include <string.h>
+
 #include <sstream>
 
 #include "app/src/assert.h"
@@ -186,27 +188,35 @@ std::string StdVectorToJson(const std::vector<Variant>& vector) {
   return ss.str();
 }
 
-Variant FlexbufferVectorToVariant(const flexbuffers::Vector& vector) {
+namespace {
+
+Variant FlexbufferToVariant(const flexbuffers::Reference& ref,
+                            bool intern_keys);
+
+Variant FlexbufferVectorToVariant(const flexbuffers::Vector& vector,
+                                  bool intern_keys) {
   Variant result = Variant::EmptyVector();
   result.vector().reserve(vector.size());
   for (size_t i = 0; i < vector.size(); i++) {
-    result.vector().push_back(FlexbufferToVariant(vector[i]));
+    result.vector().push_back(FlexbufferToVariant(vector[i], intern_keys));
   }
   return result;
 }
 
-Variant FlexbufferMapToVariant(const flexbuffers::Map& map) {
+Variant FlexbufferMapToVariant(const flexbuffers::Map& map, bool intern_keys) {
   Variant result = Variant::EmptyMap();
   flexbuffers::TypedVector keys = map.Keys();
   for (size_t i = 0; i < keys.size(); i++) {
     flexbuffers::Reference key = keys[i];
     flexbuffers::Reference value = map[key.AsKey()];
-    result.map()[FlexbufferToVariant(key)] = FlexbufferToVariant(value);
+    result.map()[FlexbufferToVariant(key, intern_keys)] =
+        FlexbufferToVariant(value, intern_keys);
   }
   return result;
 }
 
-Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
+Variant FlexbufferToVariant(const flexbuffers::Reference& ref,
+                            bool intern_keys) {
   switch (ref.GetType()) {
     case flexbuffers::FBT_NULL:
       return Variant::Null();
@@ -222,10 +232,13 @@ Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
       return Variant(ref.AsDouble());
     case flexbuffers::FBT_STRING:
       return Variant::MutableStringFromStaticString(ref.AsString().c_str());
-    case flexbuffers::FBT_KEY:
-      return Variant::MutableStringFromStaticString(ref.AsKey());
+    case flexbuffers::FBT_KEY: {
+      const char* key = ref.AsKey();
+      return intern_keys ? Variant::FromInternedString(key, strlen(key))
+                         : Variant::MutableStringFromStaticString(key);
+    }
     case flexbuffers::FBT_MAP:
-      return FlexbufferMapToVariant(ref.AsMap());
+      return FlexbufferMapToVariant(ref.AsMap(), intern_keys);
     case flexbuffers::FBT_VECTOR_BOOL:
     case flexbuffers::FBT_VECTOR_FLOAT2:
     case flexbuffers::FBT_VECTOR_FLOAT3:
@@ -242,7 +255,7 @@ Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
     case flexbuffers::FBT_VECTOR_UINT4:
     case flexbuffers::FBT_VECTOR_UINT:
     case flexbuffers::FBT_VECTOR:
-      return FlexbufferVectorToVariant(ref.AsVector());
+      return FlexbufferVectorToVariant(ref.AsVector(), intern_keys);
 
     case flexbuffers::FBT_BLOB:
       LogError("Flexbuffers containing blobs are not supported.");
@@ -251,7 +264,7 @@ Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
   return Variant::Null();
 }
 
-Variant JsonToVariant(const char* json) {
+Variant JsonToVariant(const char* json, bool intern_keys) {
   flatbuffers::Parser parser;
   flexbuffers::Builder builder;
   if (!json || !parser.ParseFlexBuffer(json, nullptr, &builder)) {
@@ -259,7 +272,27 @@ Variant JsonToVariant(const char* json) {
   }
   const std::vector<uint8_t>& buffer = builder.GetBuffer();
   flexbuffers::Reference root = flexbuffers::GetRoot(buffer);
-  return FlexbufferToVariant(root);
+  return FlexbufferToVariant(root, intern_keys);
+}
+
+}  // namespace
+
+Variant FlexbufferVectorToVariant(const flexbuffers::Vector& vector) {
+  return FlexbufferVectorToVariant(vector, false);
+}
+
+Variant FlexbufferMapToVariant(const flexbuffers::Map& map) {
+  return FlexbufferMapToVariant(map, false);
+}
+
+Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
+  return FlexbufferToVariant(ref, false);
+}
+
+Variant JsonToVariant(const char* json) { return JsonToVariant(json, false); }
+
+Variant JsonToVariantWithInternedKeys(const char* json) {
+  return JsonToVariant(json, true);
 }
 
 bool VariantToFlexbuffer(const Variant& variant, flexbuffers::Builder* fbb) {
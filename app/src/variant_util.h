@@ -28,6 +28,10 @@ namespace util {
 // Convert from a JSON string to a Variant.
 Variant JsonToVariant(const char* json);
 
+// Convert from a JSON string to a Variant whose map keys are interned (see
+// Variant::FromInternedString), for data that holds the same keys many times.
+Variant JsonToVariantWithInternedKeys(const char* json);
+
 // Converts a Variant to a JSON string.
 std::string VariantToJson(const Variant& variant);
 std::string VariantToJson(const Variant& variant, bool prettyPrint);
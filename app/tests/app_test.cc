@@ -39,6 +39,7 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "flatbuffers/util.h"
 
@@ -418,6 +419,24 @@ TEST_F(AppTest, TestCreateMultipleTimes) {
   delete firebase_app[0];
 }
 
+TEST_F(AppTest, TestCreateManyNamedApps) {
+  const int kAppCount = 100;
+  char name[32];
+  std::vector<std::unique_ptr<App>> apps;
+  for (int i = 0; i < kAppCount; ++i) {
+    snprintf(name, sizeof(name), "tenant_%d", i);
+    apps.push_back(CreateFirebaseApp(name));
+    ASSERT_NE(nullptr, apps.back());
+  }
+  for (int i = 0; i < kAppCount; ++i) {
+    snprintf(name, sizeof(name), "tenant_%d", i);
+    EXPECT_EQ(apps[i].get(), App::GetInstance(name));
+    EXPECT_STREQ(name, apps[i]->name());
+  }
+  apps.clear();
+  EXPECT_EQ(nullptr, App::GetInstance("tenant_0"));
+}
+
 // The following tests call GetInstance().
 
 TEST_F(AppTest, TestGetDefaultInstance) {
@@ -543,6 +562,25 @@ TEST_F(AppTest, TestReadOptionsFromResource) {
   EXPECT_STREQ("fake project id", options.project_id());
 }
 
+TEST_F(AppTest, TestReadOptionsFromSameConfigRepeatedly) {
+  std::string json_file = test_data_dir_ + "/google-services.json";
+  std::string config;
+  EXPECT_TRUE(flatbuffers::LoadFile(json_file.c_str(), false, &config));
+  for (int i = 0; i < 3; ++i) {
+    AppOptions app_options;
+    app_options.set_storage_bucket("existing bucket");
+    EXPECT_EQ(&app_options,
+              AppOptions::LoadFromJsonConfig(config.c_str(), &app_options));
+    EXPECT_STREQ("fake mobilesdk app id", app_options.app_id());
+    EXPECT_STREQ("fake api key", app_options.api_key());
+    EXPECT_STREQ("fake project id", app_options.project_id());
+    // Options that are not in the config are left alone.
+    EXPECT_STREQ("existing bucket", app_options.storage_bucket());
+  }
+  EXPECT_EQ(nullptr, AppOptions::LoadFromJsonConfig("{ broken", nullptr));
+  EXPECT_EQ(nullptr, AppOptions::LoadFromJsonConfig("{ broken", nullptr));
+}
+
 // Test that calling app.create() with no options tries to load from the local
 // file google-services-desktop.json, before giving up.
 TEST_F(AppTest, TestDefaultStart) {
@@ -16,6 +16,9 @@
 
 #include "app/src/cleanup_notifier.h"
 
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -293,6 +296,29 @@ TEST_F(CleanupNotifierOwnerRegistryTest,
   EXPECT_TRUE(subscriber_deleted);
 }
 
+TEST_F(CleanupNotifierOwnerRegistryTest, RegisterOwnersConcurrently) {
+  const int kThreads = 4;
+  const int kOwnersPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([]() {
+      std::vector<int> owners(kOwnersPerThread);
+      for (int& owner : owners) {
+        Object cleanup_object(0);
+        {
+          CleanupNotifier notifier;
+          notifier.RegisterOwner(&owner);
+          EXPECT_EQ(&notifier, CleanupNotifier::FindByOwner(&owner));
+          notifier.RegisterObject(&cleanup_object, Object::IncrementCounter);
+        }
+        EXPECT_EQ(1, cleanup_object.counter);
+        EXPECT_EQ(nullptr, CleanupNotifier::FindByOwner(&owner));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
 class TypedCleanupNotifierTest : public ::testing::Test {};
 
 namespace {
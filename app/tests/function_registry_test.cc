@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/function_registry.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+bool ReturnArgs(App* app, void* args, void* out) {
+  *static_cast<void**>(out) = args;
+  return true;
+}
+
+bool Fail(App* app, void* args, void* out) { return false; }
+
+TEST(FunctionRegistryTest, CallsRegisteredFunctions) {
+  FunctionRegistry registry;
+  int args = 0;
+  void* out = nullptr;
+  EXPECT_FALSE(registry.FunctionExists(FnAuthGetCurrentToken));
+  EXPECT_FALSE(
+      registry.CallFunction(FnAuthGetCurrentToken, nullptr, &args, &out));
+
+  EXPECT_TRUE(registry.RegisterFunction(FnAuthGetCurrentToken, ReturnArgs));
+  EXPECT_TRUE(registry.FunctionExists(FnAuthGetCurrentToken));
+  EXPECT_FALSE(registry.FunctionExists(FnAuthGetTokenAsync));
+  EXPECT_TRUE(
+      registry.CallFunction(FnAuthGetCurrentToken, nullptr, &args, &out));
+  EXPECT_EQ(out, &args);
+
+  EXPECT_TRUE(registry.RegisterFunction(FnAuthGetTokenAsync, Fail));
+  EXPECT_FALSE(registry.CallFunction(FnAuthGetTokenAsync, nullptr, &args,
+                                     &out));
+}
+
+TEST(FunctionRegistryTest, RegistersOneFunctionPerId) {
+  FunctionRegistry registry;
+  EXPECT_TRUE(registry.RegisterFunction(FnAuthGetCurrentToken, ReturnArgs));
+  EXPECT_FALSE(registry.RegisterFunction(FnAuthGetCurrentToken, Fail));
+  void* out = nullptr;
+  EXPECT_TRUE(
+      registry.CallFunction(FnAuthGetCurrentToken, nullptr, nullptr, &out));
+}
+
+TEST(FunctionRegistryTest, UnregistersFunctions) {
+  FunctionRegistry registry;
+  EXPECT_FALSE(registry.UnregisterFunction(FnAuthGetCurrentToken));
+  EXPECT_TRUE(registry.RegisterFunction(FnAuthGetCurrentToken, ReturnArgs));
+  EXPECT_TRUE(registry.UnregisterFunction(FnAuthGetCurrentToken));
+  EXPECT_FALSE(registry.FunctionExists(FnAuthGetCurrentToken));
+  void* out = nullptr;
+  EXPECT_FALSE(
+      registry.CallFunction(FnAuthGetCurrentToken, nullptr, nullptr, &out));
+  // The identifier can be bound again.
+  EXPECT_TRUE(registry.RegisterFunction(FnAuthGetCurrentToken, Fail));
+}
+
+TEST(FunctionRegistryTest, CallsWhileFunctionsComeAndGo) {
+  FunctionRegistry registry;
+  std::atomic<bool> done(false);
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back([&registry, &done]() {
+      int args = 0;
+      while (!done.load()) {
+        void* out = nullptr;
+        if (registry.CallFunction(FnAuthGetCurrentToken, nullptr, &args,
+                                  &out)) {
+          EXPECT_EQ(out, &args);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(registry.RegisterFunction(FnAuthGetCurrentToken, ReturnArgs));
+    EXPECT_TRUE(registry.UnregisterFunction(FnAuthGetCurrentToken));
+  }
+  done = true;
+  for (std::thread& caller : callers) caller.join();
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
@@ -26,6 +26,7 @@
 #include <functional>
 #include <vector>
 
+#include "app/memory/shared_ptr.h"
 #include "app/src/reference_counted_future_impl.h"
 #include "app/src/semaphore.h"
 #include "app/src/thread.h"
@@ -941,6 +942,67 @@ TEST_F(FutureTest, TestCallbackOrdering) {
   EXPECT_THAT(ordered_results, Eq(std::vector<int>{-1, 5, 4, 2, 1}));
 }
 
+// Test that state captured by callbacks is released as soon as the callbacks
+// are replaced, removed or run, even though their storage is reused.
+TEST_F(FutureTest, TestCallbackCapturesReleased) {
+  SharedPtr<int> captured = MakeShared<int>(0);
+  future_.OnCompletion([captured](const Future<TestResult>&) {});
+  auto callback_handle =
+      future_.AddOnCompletion([captured](const Future<TestResult>&) {});
+  future_.AddOnCompletion([captured](const Future<TestResult>&) {});
+  EXPECT_THAT(captured.use_count(), Eq(4));
+
+  future_.OnCompletion([](const Future<TestResult>&) {});
+  EXPECT_THAT(captured.use_count(), Eq(3));
+  future_.RemoveOnCompletion(callback_handle);
+  EXPECT_THAT(captured.use_count(), Eq(2));
+  future_impl_.Complete(handle_, 0);
+  EXPECT_THAT(captured.use_count(), Eq(1));
+}
+
+// Test that the handle of a removed callback does not match a later callback
+// that reuses its storage.
+TEST_F(FutureTest, TestRemovedCallbackHandleDoesNotMatchReusedStorage) {
+  future_.OnCompletion([](const Future<TestResult>&) {});
+  int first_called = 0;
+  int second_called = 0;
+  auto first_handle = future_.AddOnCompletion(
+      [&first_called](const Future<TestResult>&) { ++first_called; });
+  future_.RemoveOnCompletion(first_handle);
+  auto second_handle = future_.AddOnCompletion(
+      [&second_called](const Future<TestResult>&) { ++second_called; });
+  future_.RemoveOnCompletion(first_handle);
+  future_impl_.Complete(handle_, 0);
+  EXPECT_THAT(first_called, Eq(0));
+  EXPECT_THAT(second_called, Eq(1));
+  // Removing a callback that has run does nothing.
+  future_.RemoveOnCompletion(second_handle);
+}
+
+// Test that callbacks run correctly on many futures, whose callback storage
+// is reused from futures that have completed.
+TEST_F(FutureTest, TestCallbacksOnManyFutures) {
+  static const int kFutures = 100;
+  static const int kCallbacksPerFuture = 4;
+  int times_called = 0;
+  for (int i = 0; i < kFutures; ++i) {
+    SafeFutureHandle<TestResult> handle = future_impl_.SafeAlloc<TestResult>();
+    Future<TestResult> future = MakeFuture(&future_impl_, handle);
+    std::vector<int> ordered_results;
+    future.OnCompletion(
+        [&](const Future<TestResult>&) { ordered_results.push_back(0); });
+    for (int j = 1; j <= kCallbacksPerFuture; ++j) {
+      future.AddOnCompletion([&ordered_results, j](const Future<TestResult>&) {
+        ordered_results.push_back(j);
+      });
+    }
+    future.AddOnCompletion([&](const Future<TestResult>&) { ++times_called; });
+    future_impl_.Complete(handle, 0);
+    EXPECT_THAT(ordered_results, Eq(std::vector<int>{0, 1, 2, 3, 4}));
+  }
+  EXPECT_THAT(times_called, Eq(kFutures));
+}
+
 // Verify futures are not leaked when copied, using the implicit memory leak
 // checker. When futures are allocated in the same LastResult function slot, a
 // new handle should be allocated the old handle should be removed and hence be
@@ -16,6 +16,7 @@
 
 #include "app/src/heartbeat/heartbeat_storage_desktop.h"
 
+#include <cstdio>
 #include <fstream>
 #include <future>
 #include <thread>
@@ -126,6 +127,17 @@ TEST_F(HeartbeatStorageDesktopTest, ReadNonexistentFile) {
   ASSERT_EQ(read_heartbeats.heartbeats.size(), 0);
 }
 
+TEST_F(HeartbeatStorageDesktopTest, ReadCreatesMissingFile) {
+  HeartbeatStorageDesktop storage =
+      HeartbeatStorageDesktop("missing_file_app_id", logger_);
+  std::remove(storage.GetFilename());
+
+  LoggedHeartbeats read_heartbeats;
+  ASSERT_TRUE(storage.ReadTo(read_heartbeats));
+  EXPECT_EQ(read_heartbeats.last_logged_date, "");
+  EXPECT_TRUE(std::ifstream(storage.GetFilename()).good());
+}
+
 TEST_F(HeartbeatStorageDesktopTest, FilenameIgnoresSymbolsInAppId) {
   std::string app_id = "idstart/\\?%*:|\"<>.,;=idend";
   HeartbeatStorageDesktop storage = HeartbeatStorageDesktop(app_id, logger_);
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/mutex_profiler.h"
+
+#include <string.h>
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread.h"
+#include "app/src/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::StrEq;
+
+const char kTestMutexName[] = "MutexProfilerTest::mutex";
+
+class MutexProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    MutexProfiler::ResetStats();
+    MutexProfiler::SetEnabled(true);
+  }
+
+  void TearDown() override { MutexProfiler::SetEnabled(false); }
+
+  // Find the statistics recorded for the test mutex.
+  static MutexStats GetStats() {
+    MutexStats result;
+    memset(&result, 0, sizeof(result));
+    MutexProfiler::ReportStats(
+        [](const MutexStats& stats, void* user_data) {
+          if (strcmp(stats.mutex_name, kTestMutexName) == 0) {
+            *static_cast<MutexStats*>(user_data) = stats;
+          }
+        },
+        &result);
+    return result;
+  }
+};
+
+void LockTestMutex(Mutex* mutex) {
+  FIREBASE_PROFILED_MUTEX_LOCK(lock, *mutex, kTestMutexName);
+}
+
+TEST_F(MutexProfilerTest, CountsAcquisitions) {
+  Mutex mutex(Mutex::kModeNonRecursive);
+  for (int i = 0; i < 10; ++i) {
+    LockTestMutex(&mutex);
+  }
+  MutexStats stats = GetStats();
+  EXPECT_THAT(stats.mutex_name, StrEq(kTestMutexName));
+  EXPECT_THAT(stats.call_site, StrEq("LockTestMutex"));
+  EXPECT_THAT(stats.acquisitions, Eq(10u));
+  EXPECT_THAT(stats.contended_acquisitions, Eq(0u));
+  EXPECT_THAT(stats.total_hold_ns, Ge(stats.max_hold_ns));
+}
+
+TEST_F(MutexProfilerTest, DoesNotRecordWhileDisabled) {
+  Mutex mutex;
+  MutexProfiler::SetEnabled(false);
+  LockTestMutex(&mutex);
+  EXPECT_THAT(GetStats().acquisitions, Eq(0u));
+
+  MutexProfiler::SetEnabled(true);
+  LockTestMutex(&mutex);
+  EXPECT_THAT(GetStats().acquisitions, Eq(1u));
+
+  MutexProfiler::ResetStats();
+  EXPECT_THAT(GetStats().acquisitions, Eq(0u));
+}
+
+TEST_F(MutexProfilerTest, RecursiveLockIsNotContended) {
+  Mutex mutex(Mutex::kModeRecursive);
+  mutex.Acquire();
+  LockTestMutex(&mutex);
+  mutex.Release();
+  EXPECT_THAT(GetStats().contended_acquisitions, Eq(0u));
+}
+
+struct ContentionState {
+  ContentionState() : mutex(Mutex::kModeNonRecursive), started(0) {}
+
+  Mutex mutex;
+  Semaphore started;
+};
+
+TEST_F(MutexProfilerTest, RecordsContention) {
+  ContentionState state;
+  state.mutex.Acquire();
+  Thread thread(
+      [](ContentionState* state) {
+        state->started.Post();
+        LockTestMutex(&state->mutex);
+      },
+      &state);
+  state.started.Wait();
+  Sleep(20);
+  state.mutex.Release();
+  thread.Join();
+
+  MutexStats stats = GetStats();
+  EXPECT_THAT(stats.acquisitions, Eq(1u));
+  EXPECT_THAT(stats.contended_acquisitions, Eq(1u));
+  EXPECT_THAT(stats.max_wait_ns, Ge(10 * kNanosecondsPerMillisecond));
+  EXPECT_THAT(stats.total_wait_ns, Eq(stats.max_wait_ns));
+}
+
+TEST(MutexTest, TryAcquire) {
+  Mutex mutex(Mutex::kModeNonRecursive);
+  EXPECT_TRUE(mutex.TryAcquire());
+  Thread thread([](Mutex* mutex) { EXPECT_FALSE(mutex->TryAcquire()); },
+                &mutex);
+  thread.Join();
+  mutex.Release();
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
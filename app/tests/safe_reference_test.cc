@@ -0,0 +1,215 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/safe_reference.h"
+
+#include <vector>
+
+#include "app/memory/atomic.h"
+#include "app/memory/unique_ptr.h"
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsNull;
+
+struct Object {
+  Object() : safe_this(this), value(1) {}
+  ~Object() { safe_this.ClearReference(); }
+
+  SafeReference<Object> safe_this;
+  int value;
+};
+
+typedef SafeReference<Object> ObjectRef;
+typedef SafeReferenceLock<Object> ObjectRefLock;
+
+TEST(SafeReferenceTest, ReturnsReferenceUntilCleared) {
+  int value = 0;
+  SafeReference<int> ref(&value);
+  SafeReference<int> copy = ref;
+  {
+    SafeReferenceLock<int> lock(&copy);
+    EXPECT_THAT(lock.GetReference(), Eq(&value));
+  }
+  ref.ClearReference();
+  SafeReferenceLock<int> lock(&copy);
+  EXPECT_THAT(lock.GetReference(), IsNull());
+}
+
+TEST(SafeReferenceTest, ClearingTwiceIsHarmless) {
+  int value = 0;
+  SafeReference<int> ref(&value);
+  ref.ClearReference();
+  ref.ClearReference();
+  SafeReferenceLock<int> lock(&ref);
+  EXPECT_THAT(lock.GetReference(), IsNull());
+}
+
+TEST(SafeReferenceTest, ClearsFromWithinLockOnSameThread) {
+  Object* object = new Object();
+  ObjectRef ref = object->safe_this;
+  ObjectRefLock outer(&ref);
+  {
+    ObjectRefLock inner(&ref);
+    ASSERT_THAT(inner.GetReference(), Eq(object));
+    // Deleting the object clears the reference while both locks are held.
+    delete inner.GetReference();
+    EXPECT_THAT(inner.GetReference(), IsNull());
+  }
+  EXPECT_THAT(outer.GetReference(), IsNull());
+}
+
+TEST(SafeReferenceTest, LocksOnOtherReferencesAreKept) {
+  int first = 0;
+  int second = 0;
+  SafeReference<int> first_ref(&first);
+  SafeReference<int> second_ref(&second);
+  SafeReferenceLock<int> first_lock(&first_ref);
+  SafeReferenceLock<int> second_lock(&second_ref);
+  first_ref.ClearReference();
+  EXPECT_THAT(first_lock.GetReference(), IsNull());
+  EXPECT_THAT(second_lock.GetReference(), Eq(&second));
+}
+
+TEST(SafeReferenceTest, LocksDoNotExcludeEachOther) {
+  struct Context {
+    Context() : ref(&value), value(0), first_locked(0), second_locked(0) {}
+    SafeReference<int> ref;
+    int value;
+    Semaphore first_locked;
+    Semaphore second_locked;
+  } context;
+
+  // Each thread waits for the other while holding a lock, which would
+  // deadlock if locks excluded each other.
+  Thread first(
+      [](Context* context) {
+        SafeReferenceLock<int> lock(&context->ref);
+        context->first_locked.Post();
+        context->second_locked.Wait();
+        EXPECT_THAT(lock.GetReference(), Eq(&context->value));
+      },
+      &context);
+  Thread second(
+      [](Context* context) {
+        SafeReferenceLock<int> lock(&context->ref);
+        context->second_locked.Post();
+        context->first_locked.Wait();
+        EXPECT_THAT(lock.GetReference(), Eq(&context->value));
+      },
+      &context);
+  first.Join();
+  second.Join();
+}
+
+TEST(SafeReferenceTest, ClearWaitsForLockOnAnotherThread) {
+  struct Context {
+    Context() : locked(0), release(0) {}
+    UniquePtr<Object> object;
+    Semaphore locked;
+    Semaphore release;
+    compat::Atomic<int> cleared;
+  } context;
+  context.object = MakeUnique<Object>();
+  ObjectRef ref = context.object->safe_this;
+
+  Thread holder(
+      [](Context* context) {
+        ObjectRef ref = context->object->safe_this;
+        ObjectRefLock lock(&ref);
+        context->locked.Post();
+        context->release.Wait();
+        // The object must not be deleted while the lock is held.
+        EXPECT_THAT(lock.GetReference()->value, Eq(1));
+        EXPECT_THAT(context->cleared.load(), Eq(0));
+      },
+      &context);
+  context.locked.Wait();
+
+  Thread deleter(
+      [](Context* context) {
+        context->object.reset(nullptr);
+        context->cleared.store(1);
+      },
+      &context);
+  internal::Sleep(50);
+  EXPECT_THAT(context.cleared.load(), Eq(0));
+  context.release.Post();
+  holder.Join();
+  deleter.Join();
+  EXPECT_THAT(context.cleared.load(), Eq(1));
+  ObjectRefLock lock(&ref);
+  EXPECT_THAT(lock.GetReference(), IsNull());
+}
+
+// Many schedulers run callbacks that lock the same reference while it is
+// cleared. No callback may see the object after it has been deleted.
+TEST(SafeReferenceTest, SchedulersLockWhileCleared) {
+  static const int kSchedulers = 8;
+  static const int kCallbacksPerScheduler = 2000;
+
+  struct Context {
+    explicit Context(Object* object)
+        : ref(object->safe_this), started(0), finished(0) {}
+    ObjectRef ref;
+    Semaphore started;
+    Semaphore finished;
+    compat::Atomic<int> live;
+    compat::Atomic<int> cleared;
+  };
+
+  Object* object = new Object();
+  Context context(object);
+  std::vector<UniquePtr<scheduler::Scheduler>> schedulers;
+  for (int i = 0; i < kSchedulers; ++i) {
+    schedulers.push_back(MakeUnique<scheduler::Scheduler>());
+    for (int j = 0; j < kCallbacksPerScheduler; ++j) {
+      schedulers.back()->Schedule(new callback::CallbackValue1<Context*>(
+          &context, [](Context* context) {
+            if (context->live.load() == 0) context->started.Post();
+            ObjectRefLock lock(&context->ref);
+            Object* object = lock.GetReference();
+            if (object) {
+              // ASan reports this read if the object was deleted.
+              context->live.fetch_add(object->value);
+            } else {
+              context->cleared.fetch_add(1);
+            }
+            context->finished.Post();
+          }));
+    }
+  }
+  context.started.Wait();
+  delete object;
+  for (int i = 0; i < kSchedulers * kCallbacksPerScheduler; ++i) {
+    context.finished.Wait();
+  }
+  schedulers.clear();
+  EXPECT_THAT(context.live.load() + context.cleared.load(),
+              Eq(kSchedulers * kCallbacksPerScheduler));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
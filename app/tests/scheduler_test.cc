@@ -17,7 +17,9 @@
 #include "app/src/scheduler.h"
 
 #include "app/memory/atomic.h"
+#include "app/memory/unique_ptr.h"
 #include "app/src/semaphore.h"
+#include "app/src/thread_pool.h"
 #include "app/src/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -65,6 +67,11 @@ class SchedulerTest : public ::testing::Test {
     }
   }
 
+  static void CheckIsCurrentThread(Scheduler* scheduler) {
+    EXPECT_TRUE(scheduler->IsCurrentThread());
+    callback_sem1_.Post();
+  }
+
   static compat::Atomic<int> atomic_count_;
   static Semaphore callback_sem1_;
   static Semaphore callback_sem2_;
@@ -360,5 +367,91 @@ TEST_F(SchedulerTest, DeleteScheduler) {
          trigger_rate);
 }
 
+TEST_F(SchedulerTest, ThreadPoolTriggerOrder) {
+  ThreadPool::Options options;
+  options.max_threads = 2;
+  ThreadPool pool(options);
+  {
+    Scheduler scheduler(&pool);
+    std::vector<int> expected;
+    for (int i = 0; i < kThreadTestIteration; ++i) {
+      scheduler.Schedule(
+          new callback::CallbackValue1<int>(i, AddValueInOrder), 1);
+      expected.push_back(i);
+    }
+
+    for (int i = 0; i < kThreadTestIteration; ++i) {
+      EXPECT_TRUE(callback_sem1_.TimedWait(1000));
+    }
+    EXPECT_THAT(ordered_value_, Eq(expected));
+  }
+}
+
+TEST_F(SchedulerTest, ThreadPoolRepeatAndCancel) {
+  ThreadPool::Options options;
+  options.max_threads = 1;
+  ThreadPool pool(options);
+  {
+    Scheduler scheduler(&pool);
+    RequestHandle handle = scheduler.Schedule(
+        new callback::CallbackVoid(SemaphorePost1), 0, 1);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(callback_sem1_.TimedWait(1000));
+    }
+    EXPECT_TRUE(handle.Cancel());
+    EXPECT_TRUE(handle.IsCancelled());
+  }
+}
+
+TEST_F(SchedulerTest, ThreadPoolSharedBySchedulers) {
+  ThreadPool::Options options;
+  options.max_threads = 2;
+  ThreadPool pool(options);
+  {
+    std::vector<UniquePtr<Scheduler>> schedulers;
+    for (int i = 0; i < 100; ++i) {
+      schedulers.push_back(MakeUnique<Scheduler>(&pool));
+      schedulers.back()->Schedule(new callback::CallbackVoid(AddCount));
+    }
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(callback_sem1_.TimedWait(1000));
+    }
+    EXPECT_THAT(atomic_count_.load(), Eq(100));
+    EXPECT_LE(pool.peak_thread_count(), 2u);
+  }
+}
+
+TEST_F(SchedulerTest, ThreadPoolCancelAll) {
+  ThreadPool pool((ThreadPool::Options()));
+  Scheduler scheduler(&pool);
+  for (int i = 0; i < kThreadTestIteration; ++i) {
+    scheduler.Schedule(new callback::CallbackVoid(AddCount));
+  }
+  scheduler.CancelAllAndShutdownWorkerThread();
+  int count = atomic_count_.load();
+  // Nothing runs after shutting down.
+  scheduler.Schedule(new callback::CallbackVoid(AddCount));
+  internal::Sleep(10);
+  EXPECT_THAT(atomic_count_.load(), Eq(count));
+}
+
+TEST_F(SchedulerTest, IsCurrentThread) {
+  EXPECT_FALSE(scheduler_.IsCurrentThread());
+  scheduler_.Schedule(new callback::CallbackValue1<Scheduler*>(
+      &scheduler_, CheckIsCurrentThread));
+  EXPECT_TRUE(callback_sem1_.TimedWait(1000));
+  EXPECT_FALSE(scheduler_.IsCurrentThread());
+}
+
+TEST_F(SchedulerTest, ThreadPoolIsCurrentThread) {
+  ThreadPool pool((ThreadPool::Options()));
+  Scheduler scheduler(&pool);
+  EXPECT_FALSE(scheduler.IsCurrentThread());
+  scheduler.Schedule(new callback::CallbackValue1<Scheduler*>(
+      &scheduler, CheckIsCurrentThread));
+  EXPECT_TRUE(callback_sem1_.TimedWait(1000));
+  EXPECT_FALSE(scheduler.IsCurrentThread());
+}
+
 }  // namespace scheduler
 }  // namespace firebase
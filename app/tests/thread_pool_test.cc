@@ -0,0 +1,218 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/thread_pool.h"
+
+#include <vector>
+
+#include "app/memory/atomic.h"
+#include "app/memory/unique_ptr.h"
+#include "app/src/callback.h"
+#include "app/src/semaphore.h"
+#include "app/src/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace {
+
+using ::testing::Eq;
+
+struct TaskState {
+  TaskState() : done(0), running(0), max_running(0), mutex() {}
+
+  Semaphore done;
+  compat::Atomic<int> running;
+  compat::Atomic<int> max_running;
+  Mutex mutex;
+  std::vector<int> order;
+};
+
+// Records how many tasks run at the same time, and the order they run in.
+void RecordTask(TaskState* state, int value) {
+  int running = state->running.fetch_add(1) + 1;
+  {
+    MutexLock lock(state->mutex);
+    if (running > state->max_running.load()) state->max_running.store(running);
+    state->order.push_back(value);
+  }
+  internal::Sleep(1);
+  state->running.fetch_sub(1);
+  state->done.Post();
+}
+
+callback::Callback* NewRecordTask(TaskState* state, int value) {
+  return new callback::CallbackValue2<TaskState*, int>(state, value,
+                                                       RecordTask);
+}
+
+void BlockTask(Semaphore* started, Semaphore* release) {
+  started->Post();
+  release->Wait();
+}
+
+TEST(ThreadPoolTest, RunsQueueInOrder) {
+  ThreadPool pool((ThreadPool::Options()));
+  TaskState state;
+  {
+    SerialQueue queue(&pool);
+    std::vector<int> expected;
+    for (int i = 0; i < 100; ++i) {
+      queue.Post(NewRecordTask(&state, i));
+      expected.push_back(i);
+    }
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(state.done.TimedWait(1000));
+    }
+    EXPECT_THAT(state.order, Eq(expected));
+    EXPECT_THAT(state.max_running.load(), Eq(1));
+  }
+}
+
+TEST(ThreadPoolTest, RunsDelayedTasksByDueTime) {
+  ThreadPool pool((ThreadPool::Options()));
+  TaskState state;
+  {
+    SerialQueue queue(&pool);
+    queue.Post(NewRecordTask(&state, 3), 30);
+    queue.Post(NewRecordTask(&state, 2), 20);
+    queue.Post(NewRecordTask(&state, 1));
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(state.done.TimedWait(1000));
+    }
+    EXPECT_THAT(state.order, Eq(std::vector<int>{1, 2, 3}));
+  }
+}
+
+TEST(ThreadPoolTest, RunsQueuesInParallelWithinBudget) {
+  ThreadPool::Options options;
+  options.max_threads = 3;
+  ThreadPool pool(options);
+  TaskState state;
+  {
+    std::vector<UniquePtr<SerialQueue>> queues;
+    for (int i = 0; i < 50; ++i) {
+      queues.push_back(MakeUnique<SerialQueue>(&pool));
+      for (int j = 0; j < 4; ++j) {
+        queues.back()->Post(NewRecordTask(&state, i));
+      }
+    }
+    for (int i = 0; i < 200; ++i) {
+      EXPECT_TRUE(state.done.TimedWait(1000));
+    }
+  }
+  EXPECT_GT(state.max_running.load(), 1);
+  EXPECT_LE(state.max_running.load(), 3);
+  EXPECT_LE(pool.peak_thread_count(), 3u);
+}
+
+TEST(ThreadPoolTest, IdleThreadsExit) {
+  ThreadPool::Options options;
+  options.idle_timeout_ms = 10;
+  ThreadPool pool(options);
+  TaskState state;
+  {
+    SerialQueue queue(&pool);
+    queue.Post(NewRecordTask(&state, 0));
+    EXPECT_TRUE(state.done.TimedWait(1000));
+  }
+  for (int i = 0; i < 100 && pool.thread_count() > 0; ++i) {
+    internal::Sleep(10);
+  }
+  EXPECT_THAT(pool.thread_count(), Eq(0u));
+}
+
+TEST(ThreadPoolTest, ShutdownDiscardsPendingTasks) {
+  ThreadPool pool((ThreadPool::Options()));
+  TaskState state;
+  Semaphore started(0);
+  Semaphore release(0);
+  SerialQueue queue(&pool);
+  queue.Post(new callback::CallbackValue2<Semaphore*, Semaphore*>(
+      &started, &release, BlockTask));
+  queue.Post(NewRecordTask(&state, 0));
+  queue.Post(NewRecordTask(&state, 1), 10);
+  EXPECT_TRUE(started.TimedWait(1000));
+
+  release.Post();
+  queue.Shutdown();
+  queue.Post(NewRecordTask(&state, 2));
+  internal::Sleep(20);
+  EXPECT_THAT(state.order, Eq(std::vector<int>()));
+}
+
+// Posts a task to another queue when deleted, as a task holding the last
+// reference to something that posts from its destructor does.
+class PostOnDelete : public callback::Callback {
+ public:
+  PostOnDelete(SerialQueue* queue, TaskState* state)
+      : queue_(queue), state_(state) {}
+  ~PostOnDelete() override { queue_->Post(NewRecordTask(state_, 0)); }
+  void Run() override {}
+
+ private:
+  SerialQueue* queue_;
+  TaskState* state_;
+};
+
+TEST(ThreadPoolTest, DiscardedTasksCanPost) {
+  ThreadPool pool((ThreadPool::Options()));
+  TaskState state;
+  SerialQueue other(&pool);
+  SerialQueue queue(&pool);
+  queue.Post(new PostOnDelete(&other, &state), 1000);
+  queue.Shutdown();
+  EXPECT_TRUE(state.done.TimedWait(1000));
+  queue.Post(new PostOnDelete(&other, &state));
+  EXPECT_TRUE(state.done.TimedWait(1000));
+}
+
+TEST(ThreadPoolTest, ShrinkingBudgetLimitsThreads) {
+  ThreadPool pool((ThreadPool::Options()));
+  pool.set_max_threads(1);
+  EXPECT_THAT(pool.max_threads(), Eq(1u));
+  TaskState state;
+  {
+    std::vector<UniquePtr<SerialQueue>> queues;
+    for (int i = 0; i < 10; ++i) {
+      queues.push_back(MakeUnique<SerialQueue>(&pool));
+      queues.back()->Post(NewRecordTask(&state, i));
+    }
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(state.done.TimedWait(1000));
+    }
+  }
+  EXPECT_THAT(state.max_running.load(), Eq(1));
+}
+
+void DeleteQueue(SerialQueue* queue, Semaphore* done) {
+  EXPECT_TRUE(queue->IsCurrentThread());
+  delete queue;
+  done->Post();
+}
+
+TEST(ThreadPoolTest, QueueCanBeDeletedByItsOwnTask) {
+  ThreadPool pool((ThreadPool::Options()));
+  Semaphore done(0);
+  SerialQueue* queue = new SerialQueue(&pool);
+  EXPECT_FALSE(queue->IsCurrentThread());
+  queue->Post(new callback::CallbackValue2<SerialQueue*, Semaphore*>(
+      queue, &done, DeleteQueue));
+  EXPECT_TRUE(done.TimedWait(1000));
+}
+
+}  // namespace
+}  // namespace firebase
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/trace.h"
+
+#include <stdio.h>
+
+#include <set>
+#include <string>
+
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::StartsWith;
+
+// Count the occurrences of a substring.
+int CountOf(const std::string& json, const std::string& value) {
+  int count = 0;
+  for (size_t position = json.find(value); position != std::string::npos;
+       position = json.find(value, position + value.size())) {
+    ++count;
+  }
+  return count;
+}
+
+class TraceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Trace::Clear();
+    Trace::SetEnabled(true);
+  }
+
+  void TearDown() override {
+    Trace::SetEnabled(false);
+    Trace::Clear();
+  }
+};
+
+TEST_F(TraceTest, RecordsSpansAndInstants) {
+  {
+    FIREBASE_TRACE_SCOPE("test", "Span");
+    FIREBASE_TRACE_INSTANT("test", "Instant");
+  }
+  std::string json = Trace::ToJson();
+  EXPECT_THAT(json, StartsWith("{\"traceEvents\":["));
+  EXPECT_THAT(json,
+              HasSubstr("{\"name\":\"Span\",\"cat\":\"test\",\"ph\":\"X\""));
+  EXPECT_THAT(json,
+              HasSubstr("{\"name\":\"Instant\",\"cat\":\"test\",\"ph\":\"i\""));
+  EXPECT_THAT(CountOf(json, "\"dur\":"), Eq(1));
+}
+
+TEST_F(TraceTest, DoesNotRecordWhileDisabled) {
+  Trace::SetEnabled(false);
+  {
+    FIREBASE_TRACE_SCOPE("test", "Span");
+    FIREBASE_TRACE_INSTANT("test", "Instant");
+  }
+  EXPECT_THAT(FIREBASE_TRACE_NEW_FLOW_ID(), Eq(0u));
+  EXPECT_THAT(Trace::ToJson(), Not(HasSubstr("\"test\"")));
+}
+
+TEST_F(TraceTest, ClearDiscardsEvents) {
+  FIREBASE_TRACE_INSTANT("test", "Before");
+  Trace::Clear();
+  FIREBASE_TRACE_INSTANT("test", "After");
+  std::string json = Trace::ToJson();
+  EXPECT_THAT(json, Not(HasSubstr("\"Before\"")));
+  EXPECT_THAT(json, HasSubstr("\"After\""));
+}
+
+TEST_F(TraceTest, LinksFlowAcrossThreads) {
+  uint64_t flow_id = FIREBASE_TRACE_NEW_FLOW_ID();
+  ASSERT_THAT(flow_id, Not(Eq(0u)));
+  FIREBASE_TRACE_FLOW_BEGIN("test", "Send", flow_id);
+  Thread thread(
+      [](uint64_t* flow_id) {
+        FIREBASE_TRACE_SCOPE_FLOW_END("test", "Receive", *flow_id);
+      },
+      &flow_id);
+  thread.Join();
+
+  std::string json = Trace::ToJson();
+  char id[32];
+  snprintf(id, sizeof(id), "\"id\":%llu",
+           static_cast<unsigned long long>(flow_id));
+  EXPECT_THAT(json,
+              HasSubstr("{\"name\":\"Send\",\"cat\":\"test\",\"ph\":\"s\""));
+  EXPECT_THAT(json,
+              HasSubstr("{\"name\":\"Receive\",\"cat\":\"test\",\"ph\":\"f\""));
+  EXPECT_THAT(CountOf(json, id), Eq(2));
+  EXPECT_THAT(json, HasSubstr("\"bp\":\"e\""));
+}
+
+TEST_F(TraceTest, KeepsMostRecentEventsOfEachThread) {
+  static const int kEvents = 10000;
+  Thread thread([] {
+    for (int i = 0; i < kEvents; ++i) {
+      FIREBASE_TRACE_INSTANT("test", "Event");
+    }
+  });
+  thread.Join();
+  int recorded = CountOf(Trace::ToJson(), "\"Event\"");
+  EXPECT_GT(recorded, 0);
+  EXPECT_LT(recorded, kEvents);
+}
+
+TEST_F(TraceTest, ReusesBuffersOfExitedThreads) {
+  FIREBASE_TRACE_INSTANT("test", "Main");
+  int buffer_count = Trace::ThreadBufferCount();
+  static const int kThreads = 20;
+  for (int i = 0; i < kThreads; ++i) {
+    Thread thread([] { FIREBASE_TRACE_INSTANT("test", "Exited"); });
+    thread.Join();
+  }
+  EXPECT_LE(Trace::ThreadBufferCount(), buffer_count + 1);
+  // The events of every thread are kept, each with its own thread ID.
+  std::string json = Trace::ToJson();
+  EXPECT_THAT(CountOf(json, "\"Exited\""), Eq(kThreads));
+  std::set<std::string> thread_ids;
+  for (size_t position = json.find("\"Exited\"");
+       position != std::string::npos;
+       position = json.find("\"Exited\"", position + 1)) {
+    size_t tid = json.find("\"tid\":", position);
+    thread_ids.insert(json.substr(tid, json.find(',', tid) - tid));
+  }
+  EXPECT_THAT(thread_ids.size(), Eq(static_cast<size_t>(kThreads)));
+}
+
+TEST_F(TraceTest, ReadsWhileThreadsRecord) {
+  Thread thread([] {
+    for (int i = 0; i < 100000; ++i) {
+      FIREBASE_TRACE_SCOPE("test", "Busy");
+    }
+  });
+  for (int i = 0; i < 10; ++i) {
+    std::string json = Trace::ToJson();
+    EXPECT_THAT(json, StartsWith("{\"traceEvents\":["));
+  }
+  thread.Join();
+}
+
+TEST_F(TraceTest, LinksScheduledRequestToItsRun) {
+  Semaphore ran(0);
+  {
+    scheduler::Scheduler scheduler;
+    scheduler.Schedule(new callback::CallbackValue1<Semaphore*>(
+        &ran, [](Semaphore* ran) { ran->Post(); }));
+    ran.Wait();
+  }
+  std::string json = Trace::ToJson();
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"Scheduler::Schedule\",\"cat\":"
+                              "\"scheduler\",\"ph\":\"s\""));
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"Scheduler::Run\",\"cat\":"
+                              "\"scheduler\",\"ph\":\"f\""));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace firebase
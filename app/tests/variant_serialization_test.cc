@@ -0,0 +1,225 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "app/src/include/firebase/variant_serialization.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/variant.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::Eq;
+using ::testing::StrEq;
+
+namespace firebase {
+namespace testing {
+
+Variant TestVariant() {
+  static const uint8_t kBlob[] = {1, 2, 3, 0, 4};
+  return std::map<Variant, Variant>{
+      std::make_pair("int", 12345),
+      std::make_pair("double", 3.5),
+      std::make_pair("bool", true),
+      std::make_pair("null", Variant::Null()),
+      std::make_pair("string", "I am just great, thanks for asking!"),
+      std::make_pair("blob", Variant::FromStaticBlob(kBlob, sizeof(kBlob))),
+      std::make_pair("vector", std::vector<Variant>{1, "two", 3.0}),
+      std::make_pair("map", std::map<Variant, Variant>{
+                                std::make_pair("aaa", 1),
+                                std::make_pair("bbb", 2),
+                            }),
+  };
+}
+
+TEST(VariantSerializationTest, RoundTrip) {
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(SerializeVariant(TestVariant(), &buffer));
+
+  Variant result;
+  ASSERT_TRUE(DeserializeVariant(buffer, &result));
+  EXPECT_THAT(result, Eq(TestVariant()));
+  EXPECT_THAT(result.map()[Variant("blob")].type(),
+              Eq(Variant::kTypeMutableBlob));
+}
+
+TEST(VariantSerializationTest, RoundTripScalars) {
+  std::vector<Variant> values{Variant::Null(), Variant(0), Variant(-1),
+                              Variant(INT64_MAX), Variant(0.25),
+                              Variant(false), Variant(""),
+                              Variant::EmptyVector(), Variant::EmptyMap()};
+  for (const Variant& value : values) {
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(SerializeVariant(value, &buffer));
+    Variant result;
+    ASSERT_TRUE(DeserializeVariant(buffer, &result));
+    EXPECT_THAT(result, Eq(value));
+  }
+}
+
+TEST(VariantSerializationTest, StringsMayContainNullCharacters) {
+  const std::string kString("a string long enough\0to not be small", 36);
+  Variant value;
+  value.set_mutable_string(kString);
+  ASSERT_THAT(value.string_size(), Eq(kString.size()));
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(SerializeVariant(value, &buffer));
+
+  SerializedVariant view = SerializedVariant::FromBuffer(buffer);
+  EXPECT_THAT(std::string(view.string_value(), view.string_size()),
+              Eq(kString));
+  Variant result;
+  ASSERT_TRUE(DeserializeVariant(buffer, &result));
+  EXPECT_THAT(result.string_size(), Eq(kString.size()));
+  EXPECT_THAT(result.mutable_string(), Eq(kString));
+}
+
+TEST(VariantSerializationTest, FailsOnNonStringKeys) {
+  std::vector<uint8_t> buffer;
+  EXPECT_FALSE(SerializeVariant(
+      std::map<Variant, Variant>{std::make_pair(1, "a"),
+                                 std::make_pair("1", "b")},
+      &buffer));
+  EXPECT_FALSE(SerializeVariant(
+      std::map<Variant, Variant>{
+          std::make_pair(Variant(std::vector<Variant>{1}), 1)},
+      &buffer));
+}
+
+TEST(VariantSerializationTest, FailsOnDeeplyNestedVariants) {
+  Variant value(1);
+  for (int i = 0; i < 256; ++i) {
+    value = std::vector<Variant>{value};
+  }
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(SerializeVariant(value, &buffer));
+  Variant result;
+  EXPECT_TRUE(DeserializeVariant(buffer, &result));
+
+  value = std::vector<Variant>{value};
+  EXPECT_FALSE(SerializeVariant(value, &buffer));
+}
+
+TEST(VariantSerializationTest, RejectsInvalidBuffers) {
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(SerializeVariant(Variant(100), &buffer));
+
+  Variant result;
+  EXPECT_FALSE(DeserializeVariant(nullptr, 0, &result));
+  EXPECT_FALSE(DeserializeVariant(buffer.data(), 4, &result));
+  EXPECT_FALSE(SerializedVariant::FromBuffer(buffer.data(), 4).is_valid());
+
+  std::vector<uint8_t> bad_magic = buffer;
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(DeserializeVariant(bad_magic, &result));
+
+  std::vector<uint8_t> future_version = buffer;
+  future_version[4] = 100;
+  EXPECT_FALSE(DeserializeVariant(future_version, &result));
+  EXPECT_FALSE(SerializedVariant::FromBuffer(future_version).is_valid());
+
+  ASSERT_TRUE(DeserializeVariant(buffer, &result));
+  EXPECT_THAT(result, Eq(Variant(100)));
+}
+
+TEST(VariantSerializationTest, RejectsCorruptBuffers) {
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(SerializeVariant(TestVariant(), &buffer));
+
+  // Every truncated buffer, and every buffer with one byte changed, must be
+  // either rejected or read without reading outside of it.
+  Variant result;
+  for (size_t size = 0; size < buffer.size(); ++size) {
+    std::vector<uint8_t> truncated(buffer.begin(), buffer.begin() + size);
+    DeserializeVariant(truncated, &result);
+  }
+  for (size_t i = 8; i < buffer.size(); ++i) {
+    for (int byte = 0; byte < 256; ++byte) {
+      std::vector<uint8_t> corrupt = buffer;
+      corrupt[i] = static_cast<uint8_t>(byte);
+      DeserializeVariant(corrupt, &result);
+    }
+  }
+}
+
+TEST(VariantSerializationTest, ReadInPlace) {
+  std::vector<uint8_t> buffer;
+  ASSERT_TRUE(SerializeVariant(TestVariant(), &buffer));
+
+  SerializedVariant root = SerializedVariant::FromBuffer(buffer);
+  ASSERT_TRUE(root.is_valid());
+  EXPECT_TRUE(root.is_map());
+  EXPECT_THAT(root.size(), Eq(TestVariant().map().size()));
+
+  EXPECT_THAT(root.child("int").type(), Eq(Variant::kTypeInt64));
+  EXPECT_THAT(root.child("int").int64_value(), Eq(12345));
+  EXPECT_THAT(root.child("double").double_value(), Eq(3.5));
+  EXPECT_TRUE(root.child("bool").bool_value());
+  EXPECT_TRUE(root.child("null").is_null());
+
+  SerializedVariant str = root.child("string");
+  EXPECT_TRUE(str.is_string());
+  EXPECT_THAT(str.string_value(),
+              StrEq("I am just great, thanks for asking!"));
+  EXPECT_THAT(str.string_size(), Eq(strlen(str.string_value())));
+  // Strings are read straight out of the buffer.
+  EXPECT_GE(str.string_value(), reinterpret_cast<const char*>(buffer.data()));
+  EXPECT_LT(str.string_value(),
+            reinterpret_cast<const char*>(buffer.data() + buffer.size()));
+
+  SerializedVariant blob = root.child("blob");
+  EXPECT_THAT(blob.type(), Eq(Variant::kTypeStaticBlob));
+  ASSERT_THAT(blob.blob_size(), Eq(5u));
+  EXPECT_THAT(blob.blob_data()[4], Eq(4));
+
+  SerializedVariant vector = root.child("vector");
+  EXPECT_TRUE(vector.is_vector());
+  ASSERT_THAT(vector.size(), Eq(3u));
+  EXPECT_THAT(vector.element(1).string_value(), StrEq("two"));
+  EXPECT_TRUE(vector.element(3).is_null());
+
+  SerializedVariant map = root.child("map");
+  ASSERT_THAT(map.size(), Eq(2u));
+  EXPECT_THAT(map.key(0), StrEq("aaa"));
+  EXPECT_THAT(map.value(0).int64_value(), Eq(1));
+  EXPECT_THAT(map.key(1), StrEq("bbb"));
+  EXPECT_THAT(map.value(1).int64_value(), Eq(2));
+  EXPECT_THAT(map.key(2), StrEq(""));
+  EXPECT_THAT(map.ToVariant(), Eq(TestVariant().map()[Variant("map")]));
+
+  // Missing children and accessors of the wrong type return defaults.
+  EXPECT_TRUE(root.child("missing").is_null());
+  EXPECT_TRUE(root.child("int").child("aaa").is_null());
+  EXPECT_THAT(root.child("int").size(), Eq(0u));
+  EXPECT_THAT(root.child("int").string_value(), StrEq(""));
+  EXPECT_TRUE(root.element(0).is_null());
+}
+
+TEST(VariantSerializationTest, DefaultViewIsNull) {
+  SerializedVariant view;
+  EXPECT_FALSE(view.is_valid());
+  EXPECT_TRUE(view.is_null());
+  EXPECT_THAT(view.size(), Eq(0u));
+  EXPECT_THAT(view.ToVariant(), Eq(Variant::Null()));
+}
+
+}  // namespace testing
+}  // namespace firebase
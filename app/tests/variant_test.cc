@@ -16,6 +16,8 @@
 
 #include "app/src/include/firebase/variant.h"
 
+#include <string.h>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -40,6 +42,8 @@ class VariantInternal {
  public:
   static constexpr uint32_t kInternalTypeSmallString =
       Variant::kInternalTypeSmallString;
+  static constexpr uint32_t kInternalTypeInternedString =
+      Variant::kInternalTypeInternedString;
 
   static uint32_t type(const Variant& v) { return v.type_; }
 };
@@ -309,6 +313,71 @@ TEST_F(VariantTest, TestSmallString) {
   EXPECT_THAT(v1c.string_value(), StrEq("b"));
 }
 
+TEST_F(VariantTest, TestInternedString) {
+  Variant v1 = Variant::FromInternedString(kTestMutableString);
+  EXPECT_THAT(VariantInternal::type(v1),
+              Eq(VariantInternal::kInternalTypeInternedString));
+  EXPECT_THAT(v1.type(), Eq(Variant::kTypeMutableString));
+  EXPECT_TRUE(v1.is_string());
+  EXPECT_THAT(v1.string_value(), StrEq(kTestMutableString.c_str()));
+  EXPECT_EQ(v1, Variant(kTestMutableString));
+
+  // Interning the same string again, or copying the Variant, shares the buffer.
+  Variant v2 = Variant::FromInternedString(kTestMutableString);
+  Variant v3(v1);
+  EXPECT_EQ(v1.string_value(), v2.string_value());
+  EXPECT_EQ(v1.string_value(), v3.string_value());
+  EXPECT_EQ(v1, v2);
+  EXPECT_NE(v1, Variant::FromInternedString(kTestSmallString));
+  EXPECT_TRUE(Variant::FromInternedString(kTestSmallString) < v1);
+
+#ifdef FIREBASE_USE_MOVE_OPERATORS
+  Variant temp(v1);
+  Variant v4(std::move(temp));
+  EXPECT_THAT(VariantInternal::type(v4),
+              Eq(VariantInternal::kInternalTypeInternedString));
+  EXPECT_EQ(v1.string_value(), v4.string_value());
+#endif
+
+  // Modifying the string makes a private copy.
+  v3.mutable_string().append("!");
+  EXPECT_THAT(VariantInternal::type(v3),
+              Eq(static_cast<uint32_t>(Variant::kTypeMutableString)));
+  EXPECT_THAT(v3.string_value(), StrEq((kTestMutableString + "!").c_str()));
+  EXPECT_THAT(v1.string_value(), StrEq(kTestMutableString.c_str()));
+  EXPECT_THAT(v2.string_value(), StrEq(kTestMutableString.c_str()));
+
+  // The buffer outlives any single reference to it.
+  v1 = Variant::Null();
+  EXPECT_THAT(v2.string_value(), StrEq(kTestMutableString.c_str()));
+  EXPECT_THAT(v2.AsString().string_value(), StrEq(kTestMutableString.c_str()));
+
+  // Interned strings work as map keys.
+  std::map<Variant, Variant> map;
+  map[Variant::FromInternedString("key")] = 1;
+  EXPECT_THAT(map[Variant("key")], Eq(Variant(1)));
+  EXPECT_EQ(map.size(), 1u);
+}
+
+TEST_F(VariantTest, TestStringSize) {
+  EXPECT_THAT(Variant(kTestString).string_size(), Eq(strlen(kTestString)));
+  EXPECT_THAT(Variant(kTestSmallString).string_size(),
+              Eq(kTestSmallString.size()));
+  EXPECT_THAT(Variant(kTestMutableString).string_size(),
+              Eq(kTestMutableString.size()));
+  EXPECT_THAT(Variant::FromInternedString(kTestMutableString).string_size(),
+              Eq(kTestMutableString.size()));
+
+  // Mutable strings keep any null characters in them.
+  std::string with_null = kTestMutableString;
+  with_null[4] = '\0';
+  Variant v;
+  v.set_mutable_string(with_null);
+  EXPECT_THAT(v.string_size(), Eq(with_null.size()));
+  EXPECT_THAT(Variant::FromInternedString(with_null).string_size(),
+              Eq(with_null.size()));
+}
+
 TEST_F(VariantTest, TestBasicVector) {
   Variant v1(kTestInt64);
   Variant v2(kTestString);
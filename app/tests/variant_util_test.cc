@@ -30,6 +30,7 @@ namespace {
 using ::firebase::Variant;
 using ::firebase::testing::cppsdk::EqualsJson;
 using ::firebase::util::JsonToVariant;
+using ::firebase::util::JsonToVariantWithInternedKeys;
 using ::firebase::util::VariantToFlexbuffer;
 using ::firebase::util::VariantToJson;
 using ::flexbuffers::GetRoot;
@@ -128,6 +129,32 @@ TEST(UtilDesktopTest, JsonToVariantMap) {
               Eq(nested_map));
 }
 
+TEST(UtilDesktopTest, JsonToVariantWithInternedKeys) {
+  Variant result = JsonToVariantWithInternedKeys(
+      "{"
+      "  \"-MhvZ2bRmdvDxs5hQGjK\": {\"-MhvZ2bRmdvDxs5hQGjL\": 1},"
+      "  \"-MhvZ2bRmdvDxs5hQGjL\": {\"-MhvZ2bRmdvDxs5hQGjK\": 2}"
+      "}");
+  std::map<Variant, Variant> expected{
+      std::make_pair("-MhvZ2bRmdvDxs5hQGjK",
+                     std::map<Variant, Variant>{
+                         std::make_pair("-MhvZ2bRmdvDxs5hQGjL", 1)}),
+      std::make_pair("-MhvZ2bRmdvDxs5hQGjL",
+                     std::map<Variant, Variant>{
+                         std::make_pair("-MhvZ2bRmdvDxs5hQGjK", 2)}),
+  };
+  EXPECT_THAT(result, Eq(Variant(expected)));
+
+  // Keys with the same contents share their characters, wherever they are.
+  const std::map<Variant, Variant>& map = result.map();
+  auto first = map.begin();
+  auto second = map.rbegin();
+  EXPECT_EQ(first->first.string_value(),
+            second->second.map().begin()->first.string_value());
+  EXPECT_EQ(second->first.string_value(),
+            first->second.map().begin()->first.string_value());
+}
+
 TEST(UtilDesktopTest, VariantToJsonNull) {
   EXPECT_THAT(VariantToJson(Variant::Null()), EqualsJson("null"));
 }
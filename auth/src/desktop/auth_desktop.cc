@@ -82,6 +82,53 @@ Future<ResultT> DoSignInWithCredential(Promise<ResultT> promise,
   return promise.LastResult();
 }
 
+// AuthStateListener that fetches a token for the function registry once the
+// persistent cache is loaded. It deletes itself when the token future
+// completes.
+class PendingTokenListener : public AuthStateListener {
+ public:
+  PendingTokenListener(AuthData* auth_data, bool force_refresh)
+      : auth_data_(auth_data),
+        force_refresh_(force_refresh),
+        promise_(&auth_data->future_impl,
+                 kInternalFn_GetTokenForFunctionRegistry) {}
+  ~PendingTokenListener() override {}
+
+  Future<std::string> future() { return promise_.future(); }
+
+  void OnAuthStateChanged(Auth* auth) override {
+    auth->RemoveAuthStateListener(this);
+    // The cache is loaded now, so this no longer waits.
+    Future<std::string> token;
+    bool force_refresh = force_refresh_;
+    auth_data_->app->function_registry()->CallFunction(
+        internal::FnAuthGetTokenAsync, auth_data_->app, &force_refresh, &token);
+    if (token.status() == kFutureStatusInvalid) {
+      // Without a signed-in user there is no token.
+      promise_.CompleteWithResult(std::string());
+      delete this;
+      return;
+    }
+    token.OnCompletion(
+        [](const Future<std::string>& result, void* data) {
+          auto* listener = static_cast<PendingTokenListener*>(data);
+          if (result.error() == kAuthErrorNone) {
+            listener->promise_.CompleteWithResult(*result.result());
+          } else {
+            listener->promise_.Fail(static_cast<AuthError>(result.error()),
+                                    result.error_message());
+          }
+          delete listener;
+        },
+        this);
+  }
+
+ private:
+  AuthData* auth_data_;
+  bool force_refresh_;
+  Promise<std::string> promise_;
+};
+
 }  // namespace
 
 void* CreatePlatformAuth(App* const app) {
@@ -150,9 +197,9 @@ uint64_t IdTokenRefreshListener::GetTokenTimestamp() {
 bool Auth::GetAuthTokenForRegistry(App* app, void* /*unused*/, void* out) {
   Auth* auth = Auth::FindAuth(app);
   if (auth) {
-    // Make sure the persistent cache is loaded.
-    auth->current_user();
-
+    // Doesn't wait for the persisted user to be loaded, as callers may run on
+    // the ThreadPool that loads it. Until then there is no token, as if nobody
+    // were signed in.
     auto result = static_cast<std::string*>(out);
     MutexLock lock(auth->auth_data_->token_listener_mutex);
     auto auth_impl = static_cast<AuthImpl*>(auth->auth_data_->auth_impl);
@@ -176,6 +223,19 @@ bool Auth::GetAuthTokenAsyncForRegistry(App* app, void* force_refresh,
 
   Auth* auth = Auth::FindAuth(app);
   if (auth) {
+    {
+      // current_user() would wait for the persisted user to be loaded. Callers
+      // run on schedulers that share a ThreadPool with the load, which may be
+      // queued behind them, so hand out a future that completes after it.
+      MutexLock lock(auth->auth_data_->listeners_mutex);
+      if (auth->auth_data_->persistent_cache_load_pending) {
+        auto* listener =
+            new PendingTokenListener(auth->auth_data_, *in_force_refresh);
+        if (out_future) *out_future = listener->future();
+        auth->AddAuthStateListener(listener);
+        return true;
+      }
+    }
     User* user = auth->current_user();
     if (user) {
       Future<std::string> future = user->GetTokenInternal(
@@ -189,7 +249,7 @@ bool Auth::GetAuthTokenAsyncForRegistry(App* app, void* force_refresh,
   return false;
 }
 
-bool Auth::GetCurrentUserUidForRegistry(App* app, void* /*unused*/, void* out) {
+bool Auth::GetCurrentUserUidForRegistry(App* app, void* args, void* out) {
   auto* out_string = static_cast<std::string*>(out);
   if (out_string) {
     // Reset the output regardless of outcome.
@@ -199,6 +259,13 @@ bool Auth::GetCurrentUserUidForRegistry(App* app, void* /*unused*/, void* out) {
   Auth* auth = Auth::FindAuth(app);
   if (!auth) return false;
 
+  {
+    // Like GetAuthTokenAsyncForRegistry, don't wait for current_user().
+    MutexLock lock(auth->auth_data_->listeners_mutex);
+    bool loading = auth->auth_data_->persistent_cache_load_pending;
+    if (args) *static_cast<bool*>(args) = loading;
+    if (loading) return false;
+  }
   User* user = auth->current_user();
   if (!user) return false;
 
@@ -159,7 +159,9 @@ struct AuthImpl {
   // listeners are called before any user-supplied ones.
   UniquePtr<FunctionRegistryAuthStateListener> internal_listeners;
 
-  // Serializes all REST call from this object.
+  // Serializes all REST call from this object. The calls block until the
+  // server responds, so this has a thread of its own rather than running on
+  // the shared ThreadPool.
   scheduler::Scheduler scheduler_;
 
   // Synchronization primative for tracking sate of FederatedAuth futures.
@@ -541,6 +541,7 @@ class Auth {
   // Provides access to the auth token for the current user.  Returns the
   // current user's auth token, or an empty string, if there isn't one.
   // Note that this can potentially return an expired token from the cache.
+  // On desktop there is no token while the persisted user is being loaded.
   static bool GetAuthTokenForRegistry(App* app, void* /*unused*/, void* out);
 
   // Provides asynchronous access to the auth token for the current user. Allow
@@ -553,9 +554,10 @@ class Auth {
   // Provides access to the current user's uid, equivalent to calling
   // this->current_user()->uid(). Returns the current user's uid or an empty
   // string, if there isn't one. The out pointer is expected to point to an
-  // instance of std::string.
-  static bool GetCurrentUserUidForRegistry(App* app, void* /*unused*/,
-                                           void* out);
+  // instance of std::string. On desktop this returns false rather than wait
+  // while the persisted user is being loaded; if args is not null, it points
+  // to a bool set to whether that is the case.
+  static bool GetCurrentUserUidForRegistry(App* app, void* args, void* out);
 
   // Starts and stops a thread to ensure that the cached auth token is never
   // kept long enough for it to expire.  Refcounted, so multiple classes can
@@ -23,8 +23,13 @@
 #include "app/rest/transport_builder.h"
 #include "app/rest/transport_curl.h"
 #include "app/rest/transport_mock.h"
+#include "app/src/callback.h"
+#include "app/src/function_registry.h"
 #include "app/src/include/firebase/app.h"
 #include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread_pool.h"
 #include "app/tests/include/firebase/app_for_testing.h"
 #include "auth/src/desktop/sign_in_flow.h"
 #include "auth/src/desktop/user_desktop.h"
@@ -858,6 +863,75 @@ TEST_F(AuthDesktopTest, TestSendPasswordResetEmail) {
       firebase_auth_->SendPasswordResetEmail("fake_email@example.com"));
 }
 
+namespace {
+
+struct TokenRequest {
+  App* app;
+  Semaphore auth_created{0};
+  Semaphore requested{0};
+  bool succeeded = false;
+  Future<std::string> token;
+  std::string current_token;
+  bool uid_succeeded = false;
+  bool loading = false;
+};
+
+void RequestTokenAfterAuthCreated(TokenRequest* request) {
+  request->auth_created.Wait();
+  bool force_refresh = false;
+  ::firebase::internal::FunctionRegistry* registry =
+      request->app->function_registry();
+  request->succeeded = registry->CallFunction(
+      ::firebase::internal::FnAuthGetTokenAsync, request->app, &force_refresh,
+      &request->token);
+  registry->CallFunction(::firebase::internal::FnAuthGetCurrentToken,
+                         request->app, nullptr, &request->current_token);
+  std::string uid;
+  request->uid_succeeded =
+      registry->CallFunction(::firebase::internal::FnAuthGetCurrentUserUid,
+                             request->app, &request->loading, &uid);
+  request->requested.Post();
+}
+
+}  // namespace
+
+// A task on the only thread of the shared pool asks for a token and the uid
+// while the persisted user is loaded by a task queued behind it on the same
+// thread.
+TEST(AuthDesktopThreadPoolTest, RegistryDoesNotWaitForPersistenceLoad) {
+  rest::SetTransportBuilder([]() -> flatbuffers::unique_ptr<rest::Transport> {
+    return flatbuffers::unique_ptr<rest::Transport>(new rest::TransportMock());
+  });
+  size_t max_threads = ThreadPool::Shared()->max_threads();
+  ThreadPool::SetSharedMaxThreads(1);
+  AppOptions options = testing::MockAppOptions();
+  options.set_app_id("com.firebase.test");
+  options.set_api_key(API_KEY);
+  std::unique_ptr<App> app(App::Create(options));
+  {
+    scheduler::Scheduler scheduler(ThreadPool::Shared());
+    TokenRequest request;
+    request.app = app.get();
+    scheduler.Schedule(new callback::CallbackValue1<TokenRequest*>(
+        &request, RequestTokenAfterAuthCreated));
+
+    std::unique_ptr<Auth> auth(Auth::GetAuth(app.get()));
+    request.auth_created.Post();
+    ASSERT_TRUE(request.requested.TimedWait(5000));
+    EXPECT_TRUE(request.succeeded);
+    EXPECT_NE(kFutureStatusInvalid, request.token.status());
+    EXPECT_EQ("", request.current_token);
+    EXPECT_FALSE(request.uid_succeeded);
+    EXPECT_TRUE(request.loading);
+    WaitForFuture(request.token);
+
+    auth.reset(nullptr);
+  }
+  app.reset(nullptr);
+  ThreadPool::SetSharedMaxThreads(max_threads);
+  firebase::testing::cppsdk::ConfigReset();
+}
+
 TEST(UserViewTest, TestCopyUserView) {
   // Construct from UserData.
   UserData user1;
@@ -0,0 +1,73 @@
+# Copyright 2020 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+include(CMakeParseArguments)
+
+# firebase_cpp_cc_benchmark(
+#   target
+#   SOURCES sources...
+#   DEPENDS libraries...
+#   INCLUDES include directories...
+#   DEFINES definitions...
+# )
+#
+# Defines a new Google Benchmark executable target with the given target name,
+# sources, and dependencies.  Implicitly adds DEPENDS on benchmark and
+# benchmark_main.
+#
+# Also defines a run_<target> target that runs the benchmarks and writes the
+# results as JSON to <target>.json in the build directory, which can be
+# compared with scripts/compare_benchmarks.py.
+function(firebase_cpp_cc_benchmark name)
+  if (ANDROID OR IOS)
+    return()
+  endif()
+
+  set(multi DEPENDS SOURCES INCLUDES DEFINES)
+  # Parse the arguments into cc_benchmark_SOURCES, ..._DEPENDS, etc.
+  cmake_parse_arguments(cc_benchmark "" "" "${multi}" ${ARGN})
+
+  list(APPEND cc_benchmark_DEPENDS benchmark benchmark_main)
+
+  if (APPLE)
+    list(APPEND cc_benchmark_DEPENDS
+         "-framework Foundation"
+         "-framework Security")
+  endif()
+
+  add_executable(${name} ${cc_benchmark_SOURCES})
+  target_include_directories(${name}
+    PRIVATE
+      ${FIREBASE_SOURCE_DIR}
+      ${cc_benchmark_INCLUDES}
+  )
+  target_link_libraries(${name} PRIVATE ${cc_benchmark_DEPENDS})
+  target_compile_definitions(${name}
+    PRIVATE
+      -DINTERNAL_EXPERIMENTAL=1
+      ${cc_benchmark_DEFINES}
+  )
+
+  add_custom_target(run_${name}
+    COMMAND ${name}
+      --benchmark_out=${CMAKE_BINARY_DIR}/${name}.json
+      --benchmark_out_format=json
+      --benchmark_repetitions=5
+      --benchmark_report_aggregates_only=true
+    DEPENDS ${name}
+    WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+    COMMENT "Running ${name}"
+    USES_TERMINAL
+  )
+endfunction()
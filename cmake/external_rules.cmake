@@ -60,6 +60,12 @@ function(download_external_sources)
     set(FIREBASE_DOWNLOAD_GTEST OFF)
   endif()
 
+  if(FIREBASE_CPP_BUILD_BENCHMARKS)
+    check_use_local_directory(GOOGLEBENCHMARK)
+  else()
+    set(DOWNLOAD_GOOGLEBENCHMARK OFF)
+  endif()
+
   # If a GITHUB_TOKEN is present, use it for all external project downloads.
   # This will prevent GitHub runners from being throttled by GitHub.
   if(DEFINED ENV{GITHUB_TOKEN})
@@ -83,6 +89,7 @@ function(download_external_sources)
       -DDOWNLOAD_CURL=${DOWNLOAD_CURL}
       -DDOWNLOAD_FLATBUFFERS=${DOWNLOAD_FLATBUFFERS}
       -DDOWNLOAD_GOOGLETEST=${FIREBASE_DOWNLOAD_GTEST}
+      -DDOWNLOAD_GOOGLEBENCHMARK=${DOWNLOAD_GOOGLEBENCHMARK}
       -DDOWNLOAD_LIBUV=${DOWNLOAD_LIBUV}
       -DDOWNLOAD_UWEBSOCKETS=${DOWNLOAD_UWEBSOCKETS}
       -DDOWNLOAD_ZLIB=${DOWNLOAD_ZLIB}
@@ -90,6 +97,7 @@ function(download_external_sources)
       -DEXTERNAL_PROJECT_HTTP_HEADER=${EXTERNAL_PROJECT_HTTP_HEADER}
       -DFIREBASE_CPP_BUILD_TESTS=${FIREBASE_CPP_BUILD_TESTS}
       -DFIREBASE_CPP_BUILD_STUB_TESTS=${FIREBASE_CPP_BUILD_STUB_TESTS}
+      -DFIREBASE_CPP_BUILD_BENCHMARKS=${FIREBASE_CPP_BUILD_BENCHMARKS}
       -DFIRESTORE_DEP_SOURCE=${FIRESTORE_DEP_SOURCE}
       ${PROJECT_SOURCE_DIR}/cmake/external
     OUTPUT_FILE ${PROJECT_BINARY_DIR}/external/output_cmake_config.txt
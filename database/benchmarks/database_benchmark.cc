@@ -0,0 +1,234 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/app.h"
+#include "app/src/include/firebase/future.h"
+#include "app/src/include/firebase/internal/platform.h"
+#include "app/src/semaphore.h"
+#include "app/src/variant_util.h"
+#include "benchmark/benchmark.h"
+#include "database/src/include/firebase/database.h"
+#include "database/tests/desktop/test/local_database_server.h"
+
+#if FIREBASE_PLATFORM_LINUX
+#include <unistd.h>
+#endif  // FIREBASE_PLATFORM_LINUX
+
+namespace firebase {
+namespace database {
+namespace {
+
+using internal::connection::GenerateTree;
+using internal::connection::LocalDatabaseServer;
+
+// Writes, large reads and reconnects through the public API, against a
+// LocalDatabaseServer installed in place of the service. The data is
+// generated, so each run moves the same bytes.
+
+AppOptions MakeOptions() {
+  AppOptions options;
+  options.set_app_id("com.google.firebase.benchmark");
+  options.set_api_key("not_a_real_api_key");
+  options.set_project_id("not_a_real_project_id");
+  return options;
+}
+
+LocalDatabaseServer* GetServer() {
+  static LocalDatabaseServer* server = []() {
+    LocalDatabaseServer* server = new LocalDatabaseServer();
+    server->Install();
+    return server;
+  }();
+  return server;
+}
+
+Database* GetDatabase() {
+  static Database* database = []() {
+    GetServer();
+    App* app = App::Create(MakeOptions(), "database_benchmark");
+    return Database::GetInstance(app, "https://local.firebaseio.com");
+  }();
+  return database;
+}
+
+// Blocks until `future` completes, and returns its error.
+int Await(const FutureBase& future) {
+  Semaphore completed(0);
+  future.OnCompletion(
+      [](const FutureBase&, void* completed) {
+        static_cast<Semaphore*>(completed)->Post();
+      },
+      &completed);
+  completed.Wait();
+  return future.error();
+}
+
+// Writes of range(0) bytes, each waiting for the server's acknowledgement.
+void BM_SetValue(benchmark::State& state) {
+  DatabaseReference reference = GetDatabase()->GetReference("set_value");
+  Variant value(std::string(static_cast<size_t>(state.range(0)), 'x'));
+  for (auto _ : state) {
+    if (Await(reference.SetValue(value)) != kErrorNone) {
+      state.SkipWithError("SetValue failed");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetValue)->Arg(16)->Arg(1024)->Arg(64 * 1024)->UseRealTime();
+
+// Reads of a tree with range(0) children per node, 3 levels deep, with 64 byte
+// leaves. The larger trees arrive split into many frames.
+void BM_GetLargeSnapshot(benchmark::State& state) {
+  int children = static_cast<int>(state.range(0));
+  Variant tree = GenerateTree(children, 3, 64);
+  GetServer()->SetValue("snapshot", tree);
+  int64_t tree_size = static_cast<int64_t>(util::VariantToJson(tree).size());
+
+  DatabaseReference reference = GetDatabase()->GetReference("snapshot");
+  for (auto _ : state) {
+    if (Await(reference.GetValue()) != kErrorNone) {
+      state.SkipWithError("GetValue failed");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * tree_size);
+}
+BENCHMARK(BM_GetLargeSnapshot)
+    ->ArgName("children")
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(32)
+    ->UseRealTime();
+
+// Time from the server dropping every connection until a write goes through
+// again.
+void BM_Reconnect(benchmark::State& state) {
+  LocalDatabaseServer* server = GetServer();
+  DatabaseReference reference = GetDatabase()->GetReference("reconnect");
+  Await(reference.SetValue(0));
+  int64_t connections = server->connections_accepted();
+
+  int64_t value = 0;
+  for (auto _ : state) {
+    server->DisconnectAll();
+    if (Await(reference.SetValue(++value)) != kErrorNone) {
+      state.SkipWithError("SetValue failed");
+      break;
+    }
+  }
+  state.counters["connections_per_iteration"] = benchmark::Counter(
+      static_cast<double>(server->connections_accepted() - connections) /
+      static_cast<double>(state.iterations()));
+}
+BENCHMARK(BM_Reconnect)->UseRealTime();
+
+// Resident set size of the process in bytes, or 0 if it is not known on this
+// platform.
+double GetResidentBytes() {
+#if FIREBASE_PLATFORM_LINUX
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+  long pages = 0;     // NOLINT
+  long resident = 0;  // NOLINT
+  int read = fscanf(statm, "%ld %ld", &pages, &resident);
+  fclose(statm);
+  if (read != 2) return 0;
+  return static_cast<double>(resident) * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif  // FIREBASE_PLATFORM_LINUX
+}
+
+// Posts a semaphore once the first value arrives.
+class LoadedListener : public ValueListener {
+ public:
+  LoadedListener() : loaded_(0), posted_(false) {}
+  void OnValueChanged(const DataSnapshot&) override {
+    if (!posted_) {
+      posted_ = true;
+      loaded_.Post();
+    }
+  }
+  void OnCancelled(const Error&, const char*) override { loaded_.Post(); }
+  void Wait() { loaded_.Wait(); }
+
+ private:
+  Semaphore loaded_;
+  bool posted_;
+};
+
+// range(0) Apps each listening to the same tree of 16 children per node, 3
+// levels deep, through their own Database, with shared connections enabled if
+// range(1). Each iteration creates the databases, waits for the data to load
+// and deletes them again. Reports the connections and the resident memory the
+// databases take once loaded.
+void BM_SharedConnection(benchmark::State& state) {
+  int count = static_cast<int>(state.range(0));
+  bool shared = state.range(1) != 0;
+  LocalDatabaseServer* server = GetServer();
+  server->SetValue("shared_connection", GenerateTree(16, 3, 64));
+
+  std::vector<App*> apps;
+  for (int i = 0; i < count; ++i) {
+    apps.push_back(App::Create(
+        MakeOptions(), ("shared_connection_" + std::to_string(i)).c_str()));
+  }
+  int connections = 0;
+  double resident_bytes = 0;
+  for (auto _ : state) {
+    int connected_before = server->connected_clients();
+    double resident_before = GetResidentBytes();
+    std::vector<Database*> databases;
+    std::vector<LoadedListener> listeners(count);
+    for (int i = 0; i < count; ++i) {
+      Database* database =
+          Database::GetInstance(apps[i], "https://local.firebaseio.com");
+      database->set_shared_connection_enabled(shared);
+      database->GetReference("shared_connection")
+          .AddValueListener(&listeners[i]);
+      databases.push_back(database);
+    }
+    for (LoadedListener& listener : listeners) listener.Wait();
+    connections = server->connected_clients() - connected_before;
+    resident_bytes = GetResidentBytes() - resident_before;
+    for (Database* database : databases) delete database;
+  }
+  for (App* app : apps) delete app;
+
+  state.counters["connections"] = connections;
+  if (resident_bytes > 0) {
+    state.counters["rss_per_database"] = resident_bytes / count;
+  }
+}
+BENCHMARK(BM_SharedConnection)
+    ->ArgNames({"databases", "shared"})
+    ->Args({8, 0})
+    ->Args({8, 1})
+    ->Args({32, 0})
+    ->Args({32, 1})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace database
+}  // namespace firebase
@@ -0,0 +1,224 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/internal/platform.h"
+#include "app/src/include/firebase/variant.h"
+#include "benchmark/benchmark.h"
+#include "database/src/desktop/push_child_name_generator.h"
+#include "database/src/desktop/util_desktop.h"
+
+#if FIREBASE_PLATFORM_LINUX
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif  // defined(__GLIBC__)
+#elif FIREBASE_PLATFORM_OSX
+#include <mach/mach.h>
+#endif  // FIREBASE_PLATFORM_LINUX, FIREBASE_PLATFORM_OSX
+
+// Every allocation in this binary is counted, which is why these benchmarks
+// have a target of their own.
+namespace {
+std::atomic<uint64_t> g_allocations(0);
+std::atomic<uint64_t> g_allocated_bytes(0);
+// Bytes allocated and not freed yet, where the allocator can tell the size of
+// a block being freed.
+std::atomic<int64_t> g_live_bytes(0);
+
+void ReleaseBlock(void* ptr) {
+#if defined(__GLIBC__)
+  if (ptr != nullptr) {
+    g_live_bytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(ptr)),
+                           std::memory_order_relaxed);
+  }
+#endif  // defined(__GLIBC__)
+  free(ptr);
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+#if defined(__GLIBC__)
+  g_live_bytes.fetch_add(static_cast<int64_t>(malloc_usable_size(ptr)),
+                         std::memory_order_relaxed);
+#endif  // defined(__GLIBC__)
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { ReleaseBlock(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { ReleaseBlock(ptr); }
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace {
+
+// The memory used by trees keyed by push IDs, such as a chat room's messages,
+// with and without interning the keys. Each tree is held as many times as the
+// sync tree holds a query's data: in the server cache, the event cache and the
+// snapshot handed to the listener.
+const int kCopies = 3;
+
+// The resident set size of the process, or 0 where it is not known.
+uint64_t GetResidentBytes() {
+#if FIREBASE_PLATFORM_LINUX
+#if defined(__GLIBC__)
+  // Hand memory freed by earlier runs back to the system, so that it is not
+  // reused without showing up in the figure.
+  malloc_trim(0);
+#endif  // defined(__GLIBC__)
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return 0;
+  unsigned long long size = 0;   // NOLINT
+  unsigned long long pages = 0;  // NOLINT
+  int read = fscanf(statm, "%llu %llu", &size, &pages);
+  fclose(statm);
+  return read == 2 ? pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#elif FIREBASE_PLATFORM_OSX
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.resident_size;
+#else
+  return 0;
+#endif  // FIREBASE_PLATFORM_LINUX, FIREBASE_PLATFORM_OSX
+}
+
+// The keys of count messages added with push(), one per millisecond.
+std::vector<std::string> MakePushIds(int64_t count) {
+  PushChildNameGenerator generator;
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    keys.push_back(generator.GeneratePushChildName(1600000000000 + i));
+  }
+  return keys;
+}
+
+// A chat message as it is stored under its push ID.
+Variant MakeMessage(int64_t index) {
+  Variant message = Variant::EmptyMap();
+  message.map()["author"] = Variant::FromMutableString("user-4213");
+  message.map()["text"] =
+      Variant::FromMutableString("A message long enough to be allocated.");
+  message.map()["timestamp"] = Variant::FromInt64(1600000000000 + index);
+  return message;
+}
+
+// How the children of the tree are keyed.
+enum Keys {
+  // Plain strings, as every decoded tree was keyed before keys were interned.
+  kPlainKeys,
+  // Interned strings, inserted directly.
+  kInternedKeys,
+  // Through VariantUpdateChild, as the database does when it applies the
+  // server's updates, which interns the keys. Its time includes parsing each
+  // key as a path.
+  kUpdateChild,
+};
+
+// Builds the tree, then copies it into the other places that hold it.
+std::vector<Variant> BuildCopies(const std::vector<std::string>& keys,
+                                 Keys how) {
+  std::vector<Variant> copies;
+  copies.reserve(kCopies);
+  copies.push_back(Variant::EmptyMap());
+  Variant& tree = copies.back();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    Variant message = MakeMessage(static_cast<int64_t>(i));
+    switch (how) {
+      case kPlainKeys:
+        tree.map()[Variant::FromMutableString(keys[i])] = message;
+        break;
+      case kInternedKeys:
+        tree.map()[Variant::FromInternedString(keys[i])] = message;
+        break;
+      case kUpdateChild:
+        VariantUpdateChild(&tree, keys[i], message);
+        break;
+    }
+  }
+  for (int i = 1; i < kCopies; ++i) {
+    copies.push_back(copies.front());
+  }
+  return copies;
+}
+
+// Allocations, allocated bytes, live heap bytes and resident memory per
+// message of a tree of range(0) messages, keyed as range(1) says.
+void BM_PushIdTreeMemory(benchmark::State& state) {
+  std::vector<std::string> keys = MakePushIds(state.range(0));
+  Keys how = static_cast<Keys>(state.range(1));
+
+  // Measured once, while the trees are alive. Resident memory is only a rough
+  // figure, since the allocator may still reuse memory freed earlier.
+  uint64_t allocations = g_allocations.load();
+  uint64_t allocated_bytes = g_allocated_bytes.load();
+  int64_t live_bytes = g_live_bytes.load();
+  uint64_t resident_bytes = GetResidentBytes();
+  {
+    std::vector<Variant> copies = BuildCopies(keys, how);
+    allocations = g_allocations.load() - allocations;
+    allocated_bytes = g_allocated_bytes.load() - allocated_bytes;
+    live_bytes = g_live_bytes.load() - live_bytes;
+    uint64_t resident_after = GetResidentBytes();
+    resident_bytes =
+        resident_after > resident_bytes ? resident_after - resident_bytes : 0;
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(BuildCopies(keys, how));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  double messages = static_cast<double>(state.range(0));
+  state.counters["allocs_per_message"] = allocations / messages;
+  state.counters["bytes_per_message"] = allocated_bytes / messages;
+  if (live_bytes > 0) {
+    state.counters["live_bytes_per_message"] = live_bytes / messages;
+  }
+  if (GetResidentBytes() != 0) {
+    state.counters["rss_per_message"] = resident_bytes / messages;
+  }
+}
+BENCHMARK(BM_PushIdTreeMemory)
+    ->ArgNames({"messages", "keys"})
+    ->Args({1000, kPlainKeys})
+    ->Args({1000, kInternedKeys})
+    ->Args({1000, kUpdateChild})
+    ->Args({100000, kPlainKeys})
+    ->Args({100000, kInternedKeys})
+    ->Args({100000, kUpdateChild})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
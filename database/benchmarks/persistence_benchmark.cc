@@ -0,0 +1,378 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <string>
+
+#include "app/memory/unique_ptr.h"
+#include "app/src/filesystem.h"
+#include "app/src/include/firebase/variant.h"
+#include "app/src/logger.h"
+#include "app/src/path.h"
+#include "benchmark/benchmark.h"
+#include "database/src/common/query_spec.h"
+#include "database/src/desktop/core/cache_policy.h"
+#include "database/src/desktop/core/tracked_query_manager.h"
+#include "database/src/desktop/persistence/caching_persistence_storage_engine.h"
+#include "database/src/desktop/persistence/level_db_persistence_storage_engine.h"
+#include "database/src/desktop/persistence/persistence_manager.h"
+#include "database/src/desktop/push_child_name_generator.h"
+#include "database/tests/desktop/test/local_database_server.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace {
+
+// The LevelDB storage engine on its own, without a Repo, so that the cost of
+// committing to disk is not hidden behind the scheduler.
+
+UniquePtr<LevelDbPersistenceStorageEngine> OpenEngine(
+    const char* name, LoggerBase* logger, const GroupCommitOptions& options) {
+  std::string path = AppDataDir(
+      (std::string("firebase_database_benchmarks/") + name).c_str());
+  auto engine = MakeUnique<LevelDbPersistenceStorageEngine>(logger, options);
+  if (path.empty() || !engine->Initialize(path)) {
+    return UniquePtr<LevelDbPersistenceStorageEngine>();
+  }
+  return engine;
+}
+
+// Writes one 256 byte server update in its own transaction, as the Repo does
+// for each message from the server.
+void PersistServerUpdate(LevelDbPersistenceStorageEngine* engine, int64_t i) {
+  static const Variant* value = new Variant(std::string(256, 'x'));
+  char path[32];
+  snprintf(path, sizeof(path), "items/item%04d", static_cast<int>(i % 1024));
+  engine->BeginTransaction();
+  engine->OverwriteServerCache(Path(path), *value);
+  engine->SetTransactionSuccessful();
+  engine->EndTransaction();
+}
+
+GroupCommitOptions MakeOptions(benchmark::State& state) {
+  GroupCommitOptions options;
+  // With a window of 0 every transaction is committed on its own.
+  if (state.range(0) > 0) {
+    options.max_pending_bytes = 64 * 1024;
+    options.max_pending_milliseconds = static_cast<uint64_t>(state.range(0));
+  }
+  options.sync = state.range(1) != 0;
+  return options;
+}
+
+// Throughput of a burst of server updates, committed per transaction or
+// grouped over a window of range(0) milliseconds, synced to disk if range(1).
+void BM_PersistServerUpdates(benchmark::State& state) {
+  SystemLogger logger;
+  auto engine = OpenEngine("server_updates", &logger, MakeOptions(state));
+  if (!engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  int64_t i = 0;
+  for (auto _ : state) {
+    PersistServerUpdate(engine.get(), i++);
+  }
+  // Whatever is still pending is committed untimed; it is at most one group.
+  engine->Flush();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PersistServerUpdates)
+    ->ArgNames({"window_ms", "sync"})
+    ->Args({0, 0})
+    ->Args({10, 0})
+    ->Args({0, 1})
+    ->Args({10, 1})
+    ->UseRealTime();
+
+// Latency of a user write whose future waits for it to be committed, as the
+// Repo flushes before acknowledging writes.
+void BM_PersistAndFlush(benchmark::State& state) {
+  SystemLogger logger;
+  auto engine = OpenEngine("flushed_writes", &logger, MakeOptions(state));
+  if (!engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  int64_t i = 0;
+  for (auto _ : state) {
+    PersistServerUpdate(engine.get(), i++);
+    engine->Flush();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PersistAndFlush)
+    ->ArgNames({"window_ms", "sync"})
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->UseRealTime();
+
+// Runs func in a transaction of its own, as the persistence manager does.
+template <typename Func>
+void RunInTransaction(PersistenceStorageEngine* engine, const Func& func) {
+  engine->BeginTransaction();
+  func();
+  engine->SetTransactionSuccessful();
+  engine->EndTransaction();
+}
+
+// The keys of a list of count items added with push(), one per millisecond.
+std::set<std::string> MakePushIdKeys(int64_t count) {
+  PushChildNameGenerator generator;
+  std::set<std::string> keys;
+  for (int64_t i = 0; i < count; ++i) {
+    keys.insert(generator.GeneratePushChildName(1600000000000 + i));
+  }
+  return keys;
+}
+
+// Saving a user write, and removing it once the server acknowledges it.
+void BM_SaveUserWrite(benchmark::State& state) {
+  SystemLogger logger;
+  auto engine = OpenEngine("user_writes", &logger, GroupCommitOptions());
+  if (!engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  RunInTransaction(engine.get(), [&]() { engine->RemoveAllUserWrites(); });
+  Variant value(std::string(64, 'x'));
+  WriteId write_id = 0;
+  for (auto _ : state) {
+    RunInTransaction(engine.get(), [&]() {
+      engine->SaveUserOverwrite(Path("chat/messages/message"), value,
+                                ++write_id);
+    });
+    RunInTransaction(engine.get(),
+                     [&]() { engine->RemoveUserWrite(write_id); });
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SaveUserWrite);
+
+// Loading range(0) outstanding user writes, as the Repo does on startup.
+void BM_LoadUserWrites(benchmark::State& state) {
+  SystemLogger logger;
+  auto engine = OpenEngine("load_user_writes", &logger, GroupCommitOptions());
+  if (!engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  Variant value(std::string(64, 'x'));
+  RunInTransaction(engine.get(), [&]() {
+    engine->RemoveAllUserWrites();
+    for (WriteId write_id = 1; write_id <= state.range(0); ++write_id) {
+      engine->SaveUserOverwrite(Path("chat/messages/message"), value,
+                                write_id);
+    }
+  });
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(engine->LoadUserWrites());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadUserWrites)->ArgName("writes")->Arg(10)->Arg(1000);
+
+// Adding and removing one key of a tracked query with range(0) keys, as the
+// persistence manager does for each server update to a complete query. The
+// cost should not depend on the number of keys.
+void BM_UpdateTrackedQueryKeys(benchmark::State& state) {
+  SystemLogger logger;
+  auto engine = OpenEngine("update_tracked_query_keys", &logger,
+                           GroupCommitOptions());
+  if (!engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  std::set<std::string> keys = MakePushIdKeys(state.range(0));
+  RunInTransaction(engine.get(),
+                   [&]() { engine->SaveTrackedQueryKeys(1, keys); });
+  std::set<std::string> none;
+  std::set<std::string> key{"-new-key"};
+  for (auto _ : state) {
+    RunInTransaction(engine.get(),
+                     [&]() { engine->UpdateTrackedQueryKeys(1, key, none); });
+    RunInTransaction(engine.get(),
+                     [&]() { engine->UpdateTrackedQueryKeys(1, none, key); });
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_UpdateTrackedQueryKeys)->ArgName("keys")->Arg(10)->Arg(10000);
+
+// Loading the keys of a tracked query with range(0) keys, as the persistence
+// manager does to serve a query from the cache.
+void BM_LoadTrackedQueryKeys(benchmark::State& state) {
+  SystemLogger logger;
+  auto engine = OpenEngine("load_tracked_query_keys", &logger,
+                           GroupCommitOptions());
+  if (!engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  std::set<std::string> keys = MakePushIdKeys(state.range(0));
+  RunInTransaction(engine.get(),
+                   [&]() { engine->SaveTrackedQueryKeys(1, keys); });
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(engine->LoadTrackedQueryKeys(1));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadTrackedQueryKeys)->ArgName("keys")->Arg(10)->Arg(10000);
+
+// Attaching and detaching a view on a query with 1000 children, as a UI does
+// when it shows and hides a list, with an in-memory tier of range(0) bytes in
+// front of LevelDB. With no tier, every attach rebuilds the data from disk.
+void BM_AttachDetachQuery(benchmark::State& state) {
+  SystemLogger logger;
+  auto level_db_engine =
+      OpenEngine("attach_detach", &logger, GroupCommitOptions());
+  if (!level_db_engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  auto caching_engine = MakeUnique<CachingPersistenceStorageEngine>(
+      Move(level_db_engine), static_cast<size_t>(state.range(0)), &logger);
+  CachingPersistenceStorageEngine* caching_engine_ptr = caching_engine.get();
+  UniquePtr<PersistenceStorageEngine> storage_engine = Move(caching_engine);
+  auto tracked_query_manager =
+      MakeUnique<TrackedQueryManager>(storage_engine.get(), &logger);
+  PersistenceManager manager(Move(storage_engine), Move(tracked_query_manager),
+                             MakeUnique<LRUCachePolicy>(10 * 1024 * 1024),
+                             &logger);
+
+  QuerySpec query(Path("rooms/lobby"));
+  manager.RunInTransaction([&]() {
+    manager.SetQueryActive(query);
+    manager.UpdateServerCache(query, connection::GenerateTree(10, 3, 16));
+    manager.SetQueryComplete(query);
+    manager.SetQueryInactive(query);
+    return true;
+  });
+  uint64_t hits = caching_engine_ptr->hit_count();
+  uint64_t misses = caching_engine_ptr->miss_count();
+
+  // Each in its own transaction, as SyncTree adds and removes registrations.
+  for (auto _ : state) {
+    manager.RunInTransaction([&]() {
+      manager.SetQueryActive(query);
+      benchmark::DoNotOptimize(manager.ServerCache(query));
+      return true;
+    });
+    manager.RunInTransaction([&]() {
+      manager.SetQueryInactive(query);
+      return true;
+    });
+  }
+  state.SetItemsProcessed(state.iterations());
+  hits = caching_engine_ptr->hit_count() - hits;
+  misses = caching_engine_ptr->miss_count() - misses;
+  state.counters["hit_ratio"] = benchmark::Counter(
+      hits + misses == 0 ? 0.0
+                         : static_cast<double>(hits) /
+                               static_cast<double>(hits + misses));
+}
+BENCHMARK(BM_AttachDetachQuery)
+    ->ArgName("memory_tier_bytes")
+    ->Arg(0)
+    ->Arg(2 * 1024 * 1024);
+
+// An LRU policy that checks the cache size after every server update, so that
+// a prune can be started without writing a thousand updates first.
+class CheckEveryUpdateCachePolicy : public LRUCachePolicy {
+ public:
+  explicit CheckEveryUpdateCachePolicy(uint64_t max_size_bytes)
+      : LRUCachePolicy(max_size_bytes) {}
+
+  bool ShouldCheckCacheSize(uint64_t) const override { return true; }
+};
+
+// Pruning a cache of range(0) inactive queries of 1 KB each down to half its
+// size, as the Repo does a step at a time on the persistence thread. The time
+// is that of the whole prune; max_step_ms is the longest the thread is held
+// by a single step.
+void BM_PruneCache(benchmark::State& state) {
+  const int64_t query_count = state.range(0);
+  const uint64_t query_bytes = 1024;
+  SystemLogger logger;
+  // A database of its own for each size, so that none is left over from
+  // a run with a larger cache.
+  std::string name = "prune_cache_" + std::to_string(query_count);
+  auto level_db_engine =
+      OpenEngine(name.c_str(), &logger, GroupCommitOptions());
+  if (!level_db_engine) {
+    state.SkipWithError("Could not open LevelDB");
+    return;
+  }
+  UniquePtr<PersistenceStorageEngine> storage_engine = Move(level_db_engine);
+  auto tracked_query_manager =
+      MakeUnique<TrackedQueryManager>(storage_engine.get(), &logger);
+  PersistenceManager manager(
+      Move(storage_engine), Move(tracked_query_manager),
+      MakeUnique<CheckEveryUpdateCachePolicy>(query_count * query_bytes / 2),
+      &logger);
+
+  Variant value(std::string(query_bytes, 'x'));
+  double max_step_ms = 0;
+  int64_t steps = 0;
+  for (auto _ : state) {
+    // Fill the cache again with whatever the last iteration pruned.
+    manager.RunInTransaction([&]() {
+      char path[32];
+      for (int64_t i = 0; i < query_count; ++i) {
+        snprintf(path, sizeof(path), "rooms/room%06d", static_cast<int>(i));
+        QuerySpec query{Path(path)};
+        manager.SetQueryActive(query);
+        manager.UpdateServerCache(query, value);
+        manager.SetQueryInactive(query);
+      }
+      return true;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    bool more = true;
+    while (more) {
+      auto step_start = std::chrono::steady_clock::now();
+      more = manager.PruneCacheStep();
+      auto step_end = std::chrono::steady_clock::now();
+      max_step_ms = std::max(
+          max_step_ms, std::chrono::duration<double, std::milli>(step_end -
+                                                                 step_start)
+                           .count());
+      ++steps;
+    }
+    state.SetIterationTime(std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count());
+  }
+  state.SetItemsProcessed(state.iterations() * query_count);
+  state.counters["steps"] = benchmark::Counter(
+      static_cast<double>(steps), benchmark::Counter::kAvgIterations);
+  state.counters["max_step_ms"] = max_step_ms;
+}
+BENCHMARK(BM_PruneCache)
+    ->ArgName("queries")
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
@@ -0,0 +1,149 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "app/src/include/firebase/variant.h"
+#include "app/src/path.h"
+#include "benchmark/benchmark.h"
+#include "database/src/desktop/push_child_name_generator.h"
+#include "database/src/desktop/util_desktop.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace {
+
+// Path resolution on a node with range(0) children keyed by push IDs, as in a
+// large list of chat messages. The keys are looked up in a shuffled order, so
+// the results are not helped by the previous lookup.
+
+std::vector<std::string> MakePushIds(int64_t count) {
+  PushChildNameGenerator generator;
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    keys.push_back(generator.GeneratePushChildName(1600000000000 + i));
+  }
+  // A fixed permutation, so that every run looks keys up in the same order.
+  uint64_t state = 0x9e3779b97f4a7c15;
+  for (size_t i = keys.size(); i > 1; --i) {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    std::swap(keys[i - 1], keys[(state >> 33) % i]);
+  }
+  return keys;
+}
+
+Variant MakeMessages(const std::vector<std::string>& keys) {
+  Variant messages = Variant::EmptyMap();
+  for (const std::string& key : keys) {
+    Variant message = Variant::EmptyMap();
+    message.map()["text"] = Variant::FromMutableString("Hello");
+    messages.map()[Variant::FromMutableString(key)] = message;
+  }
+  return messages;
+}
+
+std::vector<Path> MakePaths(const std::vector<std::string>& keys) {
+  std::vector<Path> paths;
+  paths.reserve(keys.size());
+  for (const std::string& key : keys) {
+    paths.push_back(Path("messages").GetChild(key).GetChild("text"));
+  }
+  return paths;
+}
+
+void BM_VariantGetChild(benchmark::State& state) {
+  std::vector<std::string> keys = MakePushIds(state.range(0));
+  Variant root = Variant::EmptyMap();
+  root.map()["messages"] = MakeMessages(keys);
+  std::vector<Path> paths = MakePaths(keys);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(VariantGetChild(&root, paths[i]));
+    if (++i == paths.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VariantGetChild)->ArgName("children")->Arg(100)->Arg(100000);
+
+void BM_GetInternalVariant(benchmark::State& state) {
+  std::vector<std::string> keys = MakePushIds(state.range(0));
+  Variant root = Variant::EmptyMap();
+  root.map()["messages"] = MakeMessages(keys);
+  std::vector<Path> paths = MakePaths(keys);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GetInternalVariant(&root, paths[i]));
+    if (++i == paths.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetInternalVariant)->ArgName("children")->Arg(100)->Arg(100000);
+
+// Overwrites one existing leaf per iteration, as a server update does.
+void BM_VariantUpdateChild(benchmark::State& state) {
+  std::vector<std::string> keys = MakePushIds(state.range(0));
+  Variant root = Variant::EmptyMap();
+  root.map()["messages"] = MakeMessages(keys);
+  std::vector<Path> paths = MakePaths(keys);
+  Variant value = Variant::FromMutableString("Edited");
+  size_t i = 0;
+  for (auto _ : state) {
+    VariantUpdateChild(&root, paths[i], value);
+    if (++i == paths.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VariantUpdateChild)->ArgName("children")->Arg(100)->Arg(100000);
+
+// The lookup alone in the std::map behind Variant::map(), and in a hash index
+// over the same keys, to bound what a hashed child map could save.
+void BM_ChildMapFind(benchmark::State& state) {
+  std::vector<std::string> keys = MakePushIds(state.range(0));
+  Variant messages = MakeMessages(keys);
+  const std::map<Variant, Variant>& children = messages.map();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        children.find(Variant::FromStaticString(keys[i].c_str())));
+    if (++i == keys.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChildMapFind)->ArgName("children")->Arg(100)->Arg(100000);
+
+void BM_HashIndexFind(benchmark::State& state) {
+  std::vector<std::string> keys = MakePushIds(state.range(0));
+  Variant messages = MakeMessages(keys);
+  std::unordered_map<std::string, const Variant*> index;
+  for (const auto& child : messages.map()) {
+    index[child.first.string_value()] = &child.second;
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.find(keys[i]));
+    if (++i == keys.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HashIndexFind)->ArgName("children")->Arg(100)->Arg(100000);
+
+}  // namespace
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
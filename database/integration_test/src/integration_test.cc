@@ -680,6 +680,34 @@ TEST_F(FirebaseDatabaseTest, TestUpdateChildren) {
           Pair("timestamp", TimestampIsNear(current_time_milliseconds))));
 }
 
+TEST_F(FirebaseDatabaseTest, TestWarmUp) {
+  const char* test_name = test_info_->name();
+
+  SignIn();
+
+  firebase::database::DatabaseReference ref = CreateWorkingPath();
+  WaitForCompletion(ref.Child(test_name).SetValue(
+                        std::map<std::string, std::string>{
+                            {"small", "x"}, {"large", std::string(100, 'y')}}),
+                    "SetValue");
+
+  std::vector<firebase::database::Query> queries{
+      ref.Child(test_name).Child("large"), ref.Child(test_name).Child("small"),
+      ref.Child(test_name).Child("missing")};
+  firebase::Future<std::vector<size_t>> warm_up_future =
+      database_->WarmUp(queries);
+  WaitForCompletion(warm_up_future, "WarmUp");
+  ASSERT_EQ(warm_up_future.result()->size(), 3u);
+  EXPECT_GT((*warm_up_future.result())[0], (*warm_up_future.result())[1]);
+  EXPECT_GT((*warm_up_future.result())[1], 0u);
+  EXPECT_EQ(database_->WarmUpLastResult().status(),
+            firebase::kFutureStatusComplete);
+
+  for (firebase::database::Query& query : queries) {
+    query.SetKeepSynchronized(false);
+  }
+}
+
 // TODO(drsanta): Disabled test due to an assertion in Firebase Android SDK.
 // The issue should should be fixed in the next Android SDK release after
 // 19.15.0.
@@ -529,6 +529,18 @@ void DatabaseInternal::SetPersistenceEnabled(bool enabled) const {
   util::CheckAndClearJniExceptions(env);
 }
 
+void DatabaseInternal::SetPersistenceSyncEnabled(bool enabled) {
+  if (enabled) {
+    logger_.LogWarning("Synced persistence is not supported on Android.");
+  }
+}
+
+void DatabaseInternal::SetSharedConnectionEnabled(bool enabled) {
+  if (enabled) {
+    logger_.LogWarning("Shared connections are not supported on Android.");
+  }
+}
+
 void DatabaseInternal::set_log_level(LogLevel log_level) {
   FIREBASE_ASSERT_RETURN_VOID(log_level <
                               (sizeof(kCppLogLevelToLoggerLevelName) /
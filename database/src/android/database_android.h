@@ -71,6 +71,12 @@ class DatabaseInternal {
 
   void SetPersistenceEnabled(bool enabled) const;
 
+  // Not supported on Android, which manages its own disk cache.
+  void SetPersistenceSyncEnabled(bool enabled);
+
+  // Not supported on Android, which manages its own connections.
+  void SetSharedConnectionEnabled(bool enabled);
+
   // Set the logging verbosity.
   // kLogLevelDebug and kLogLevelVerbose are interpreted as the same level by
   // the Android implementation.
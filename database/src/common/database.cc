@@ -15,9 +15,12 @@
 #include "database/src/include/firebase/database.h"
 
 #include <assert.h>
+#include <stdint.h>
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "app/src/app_common.h"
 #include "app/src/assert.h"
@@ -25,7 +28,11 @@
 #include "app/src/include/firebase/app.h"
 #include "app/src/include/firebase/internal/platform.h"
 #include "app/src/include/firebase/version.h"
+#include "app/src/reference_counted_future_impl.h"
+#include "app/src/thread.h"
+#include "app/src/time.h"
 #include "app/src/util.h"
+#include "app/src/variant_util.h"
 
 // DatabaseInternal is defined in these 3 files, one implementation for each OS.
 #if FIREBASE_PLATFORM_ANDROID
@@ -61,6 +68,143 @@ namespace {
 DatabaseMap::key_type MakeKey(App* app, const std::string& url) {
   return std::make_pair(std::string(app->name()), url);
 }
+
+enum DatabaseFn {
+  kDatabaseFnWarmUp = 0,
+  kDatabaseFnCount,
+};
+
+// Tracks the queries of a single WarmUp() call that are still loading.
+struct WarmUpData {
+  WarmUpData(Database* database, ReferenceCountedFutureImpl* api,
+             const SafeFutureHandle<std::vector<size_t>>& handle,
+             size_t query_count)
+      : database(database),
+        api(api),
+        handle(handle),
+        remaining(query_count),
+        sizes(query_count, 0),
+        error(kErrorNone) {}
+
+  Database* database;
+  ReferenceCountedFutureImpl* api;
+  SafeFutureHandle<std::vector<size_t>> handle;
+  size_t remaining;
+  std::vector<size_t> sizes;
+  // The first error reported by any query.
+  int error;
+  std::string error_message;
+  // The thread completing the future, once every query has finished.
+  Thread::Id completing_thread;
+};
+
+// Identifies one query of a WarmUp() call to its completion callback.
+struct WarmUpQuery {
+  WarmUpData* data;
+  size_t index;
+};
+
+// The queries of every WarmUp() call that are still loading, by the token
+// passed to their completion callback. When a database is deleted, the futures
+// of its queries are dropped without completing, so its entries are removed
+// here instead. Tokens are never reused, so a callback that races with the
+// deletion finds nothing.
+Mutex g_warm_up_mutex;  // NOLINT
+std::map<uintptr_t, WarmUpQuery>* g_warm_up_queries = nullptr;
+uintptr_t g_next_warm_up_token = 0;
+// The WarmUp() calls whose futures are being completed. Their futures are
+// completed without g_warm_up_mutex held, as the callbacks may call back into
+// the database, so deleting a database waits for its calls here.
+std::set<WarmUpData*>* g_completing_warm_ups = nullptr;
+
+// Record the outcome of one query. Once every query has finished, returns the
+// call, which must then be passed to CompleteWarmUp() after g_warm_up_mutex is
+// released; otherwise returns null. g_warm_up_mutex must be held.
+WarmUpData* FinishWarmUpQuery(WarmUpData* data, size_t index, size_t size,
+                              int error, const char* error_message) {
+  data->sizes[index] = size;
+  if (error != kErrorNone && data->error == kErrorNone) {
+    data->error = error;
+    data->error_message = error_message ? error_message : "";
+  }
+  if (--data->remaining > 0) return nullptr;
+  if (g_completing_warm_ups == nullptr) {
+    g_completing_warm_ups = new std::set<WarmUpData*>();
+  }
+  data->completing_thread = Thread::CurrentId();
+  g_completing_warm_ups->insert(data);
+  return data;
+}
+
+// Complete the future of a call returned by FinishWarmUpQuery(), and delete
+// it. g_warm_up_mutex must not be held.
+void CompleteWarmUp(WarmUpData* data) {
+  data->api->CompleteWithResult(data->handle, data->error,
+                                data->error_message.c_str(), data->sizes);
+  MutexLock lock(g_warm_up_mutex);
+  g_completing_warm_ups->erase(data);
+  delete data;
+}
+
+void OnWarmUpQueryComplete(const Future<DataSnapshot>& result,
+                           void* user_data) {
+  size_t size = 0;
+  if (result.error() == kErrorNone && result.result() != nullptr) {
+    // The size of the data as it would be sent over the wire.
+    size = util::VariantToJson(result.result()->value()).size();
+  }
+  WarmUpData* finished = nullptr;
+  {
+    MutexLock lock(g_warm_up_mutex);
+    if (g_warm_up_queries == nullptr) return;
+    auto iter =
+        g_warm_up_queries->find(reinterpret_cast<uintptr_t>(user_data));
+    if (iter == g_warm_up_queries->end()) return;
+    WarmUpQuery query = iter->second;
+    g_warm_up_queries->erase(iter);
+    finished = FinishWarmUpQuery(query.data, query.index, size,
+                                 result.error(), result.error_message());
+  }
+  if (finished) CompleteWarmUp(finished);
+}
+
+// Returns true if a call of `database` is being completed by another thread.
+// A call completed by this thread is deleting its own database from a
+// callback, which the future API allows. g_warm_up_mutex must be held.
+bool IsCompletingWarmUp(void* database) {
+  if (g_completing_warm_ups == nullptr) return false;
+  for (WarmUpData* data : *g_completing_warm_ups) {
+    if (data->database == database &&
+        !Thread::IsCurrentThread(data->completing_thread)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Drop the WarmUp() calls of a database that is being deleted. Their futures
+// were released along with the database's future API, which is deleted once
+// the calls being completed have finished with it.
+void ReleaseWarmUps(void* database) {
+  MutexLock lock(g_warm_up_mutex);
+  while (IsCompletingWarmUp(database)) {
+    g_warm_up_mutex.Release();
+    firebase::internal::Sleep(1);
+    g_warm_up_mutex.Acquire();
+  }
+  if (g_warm_up_queries == nullptr) return;
+  std::set<WarmUpData*> released;
+  for (auto iter = g_warm_up_queries->begin();
+       iter != g_warm_up_queries->end();) {
+    if (iter->second.data->database == database) {
+      released.insert(iter->second.data);
+      iter = g_warm_up_queries->erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  for (WarmUpData* data : released) delete data;
+}
 }  // namespace
 
 Database* Database::GetInstance(App* app, const char* url,
@@ -100,6 +244,7 @@ Database* Database::GetInstance(App* app, InitResult* init_result_out) {
 Database::Database(::firebase::App* app, internal::DatabaseInternal* internal)
     : internal_(internal) {
   if (internal_->initialized()) {
+    internal_->future_manager().AllocFutureApi(this, kDatabaseFnCount);
     CleanupNotifier* app_notifier = CleanupNotifier::FindByOwner(app);
     assert(app_notifier);
     app_notifier->RegisterObject(this, [](void* object) {
@@ -128,6 +273,7 @@ void Database::DeleteInternal() {
     CleanupNotifier* app_notifier = CleanupNotifier::FindByOwner(my_app);
     assert(app_notifier);
     app_notifier->UnregisterObject(this);
+    internal_->future_manager().ReleaseFutureApi(this);
   }
 
   {
@@ -195,6 +341,78 @@ void Database::set_persistence_enabled(bool enabled) {
   if (internal_) internal_->SetPersistenceEnabled(enabled);
 }
 
+void Database::set_persistence_sync_enabled(bool enabled) {
+  if (internal_) internal_->SetPersistenceSyncEnabled(enabled);
+}
+
+void Database::set_shared_connection_enabled(bool enabled) {
+  if (internal_) internal_->SetSharedConnectionEnabled(enabled);
+}
+
+Future<std::vector<size_t>> Database::WarmUp(
+    const std::vector<Query>& queries) {
+  if (!internal_ || !internal_->initialized()) {
+    return Future<std::vector<size_t>>();
+  }
+  ReferenceCountedFutureImpl* api =
+      internal_->future_manager().GetFutureApi(this);
+  SafeFutureHandle<std::vector<size_t>> handle =
+      api->SafeAlloc<std::vector<size_t>>(kDatabaseFnWarmUp);
+  if (queries.empty()) {
+    api->CompleteWithResult(handle, kErrorNone, "", std::vector<size_t>());
+    return MakeFuture(api, handle);
+  }
+
+  // The calls still loading when this database is deleted are dropped.
+  internal_->cleanup().RegisterObject(this, ReleaseWarmUps);
+
+  {
+    MutexLock lock(g_warm_up_mutex);
+    if (g_warm_up_queries == nullptr) {
+      g_warm_up_queries = new std::map<uintptr_t, WarmUpQuery>();
+    }
+  }
+
+  // Requests are issued without waiting for earlier ones to complete, so the
+  // listens are pipelined over the connection in priority order. The lock is
+  // not held while calling into the database, which may complete queries
+  // synchronously. `data` stays valid until its last query is finished.
+  WarmUpData* data = new WarmUpData(this, api, handle, queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    Query query = queries[i];
+    query.SetKeepSynchronized(true);
+    Future<DataSnapshot> value = query.GetValue();
+    if (value.status() == kFutureStatusInvalid) {
+      WarmUpData* finished = nullptr;
+      {
+        MutexLock lock(g_warm_up_mutex);
+        finished =
+            FinishWarmUpQuery(data, i, 0, kErrorUnknownError, "Invalid query");
+      }
+      if (finished) CompleteWarmUp(finished);
+    } else {
+      uintptr_t token;
+      {
+        MutexLock lock(g_warm_up_mutex);
+        token = ++g_next_warm_up_token;
+        (*g_warm_up_queries)[token] = WarmUpQuery{data, i};
+      }
+      value.OnCompletion(OnWarmUpQueryComplete,
+                         reinterpret_cast<void*>(token));
+    }
+  }
+  return MakeFuture(api, handle);
+}
+
+Future<std::vector<size_t>> Database::WarmUpLastResult() {
+  if (!internal_ || !internal_->initialized()) {
+    return Future<std::vector<size_t>>();
+  }
+  return static_cast<const Future<std::vector<size_t>>&>(
+      internal_->future_manager().GetFutureApi(this)->LastResult(
+          kDatabaseFnWarmUp));
+}
+
 void Database::set_log_level(LogLevel log_level) {
   if (internal_) internal_->set_log_level(log_level);
 }
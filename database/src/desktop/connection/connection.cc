@@ -288,7 +288,9 @@ void Connection::HandleIncomingFrame(const char* msg) {
 }
 
 void Connection::ProcessMessage(const char* message) {
-  Variant message_data = util::JsonToVariant(message);
+  // The data in a message ends up in the caches, which hold the same child
+  // names many times over.
+  Variant message_data = util::JsonToVariantWithInternedKeys(message);
   logger_->LogDebug("%s ProcessMessage (length: %d)", log_id_.c_str(),
                     strlen(message));
 
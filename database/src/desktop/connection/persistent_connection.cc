@@ -23,6 +23,7 @@
 #include "app/src/log.h"
 #include "app/src/path.h"
 #include "app/src/time.h"
+#include "app/src/trace.h"
 #include "app/src/variant_util.h"
 #include "database/src/desktop/core/constants.h"
 #include "database/src/desktop/core/tag.h"
@@ -246,6 +247,7 @@ void PersistentConnection::HandleConnectStatsResponse(
 }
 
 void PersistentConnection::OnDataMessage(const Variant& message) {
+  FIREBASE_TRACE_SCOPE("database", "PersistentConnection::OnDataMessage");
   FIREBASE_DEV_ASSERT(message.is_map());
 
   SAFE_REFERENCE_RETURN_VOID_IF_INVALID(ThisRefLock, lock, safe_this_);
@@ -475,6 +477,11 @@ bool PersistentConnection::IsInterrupted() {
   return IsInterruptedInternal(kInterruptManual);
 }
 
+void PersistentConnection::SetApp(App* app) {
+  FIREBASE_DEV_ASSERT(app);
+  app_ = app;
+}
+
 void PersistentConnection::InterruptInternal(InterruptReason reason) {
   logger_->LogDebug("%s Connection interrupted for: %d", log_id_.c_str(),
                     static_cast<int>(reason));
@@ -915,6 +922,7 @@ void PersistentConnection::SendSensitive(const char* action, bool sensitive,
                                          ResponsePtr response,
                                          ConnectionResponseHandler callback,
                                          uint64_t outstanding_id) {
+  FIREBASE_TRACE_SCOPE("database", "PersistentConnection::SendSensitive");
   FIREBASE_DEV_ASSERT(realtime_);
 
   // Varient only accept int64_t
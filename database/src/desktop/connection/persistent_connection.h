@@ -186,6 +186,11 @@ class PersistentConnection : public ConnectionEventHandler {
   // This should only be called from scheduler thread.
   bool IsInterrupted();
 
+  // Change the App whose credentials are used to authenticate the connection.
+  // The new credentials are used the next time a token is fetched.
+  // This should only be called from scheduler thread.
+  void SetApp(App* app);
+
  private:
   // Enum of all the reason to interrupt the connection.
   // There can be multiple reason to interrupt.  Only when all reason is
@@ -21,16 +21,29 @@ namespace database {
 namespace internal {
 namespace connection {
 
+namespace {
+// The custom websocket client factory, if any.
+WebSocketClientFactory g_web_socket_client_factory = nullptr;
+}  // namespace
+
 UniquePtr<WebSocketClientInterface> CreateWebSocketClient(
     const HostInfo& info, WebSocketClientEventHandler* delegate,
     const char* opt_last_session_id, Logger* logger,
     scheduler::Scheduler* scheduler) {
+  if (g_web_socket_client_factory) {
+    return g_web_socket_client_factory(info, delegate, opt_last_session_id,
+                                       logger, scheduler);
+  }
   // Currently we use uWebSockets implementation.
   std::string uri = info.GetConnectionUrl(opt_last_session_id);
   return MakeUnique<WebSocketClientImpl>(uri, info.user_agent(), logger,
                                          scheduler, delegate);
 }
 
+void SetWebSocketClientFactory(WebSocketClientFactory factory) {
+  g_web_socket_client_factory = factory;
+}
+
 }  // namespace connection
 }  // namespace internal
 }  // namespace database
@@ -32,6 +32,18 @@ UniquePtr<WebSocketClientInterface> CreateWebSocketClient(
     const char* opt_last_session_id, Logger* logger,
     scheduler::Scheduler* scheduler);
 
+// Creates a websocket client. Takes the same arguments as
+// CreateWebSocketClient().
+typedef UniquePtr<WebSocketClientInterface> (*WebSocketClientFactory)(
+    const HostInfo& info, WebSocketClientEventHandler* delegate,
+    const char* opt_last_session_id, Logger* logger,
+    scheduler::Scheduler* scheduler);
+
+// Set a custom factory for CreateWebSocketClient() to use, e.g. to carry
+// connections over a simulated network in benchmarks. Pass nullptr to go back
+// to the default client.
+void SetWebSocketClientFactory(WebSocketClientFactory factory);
+
 }  // namespace connection
 }  // namespace internal
 }  // namespace database
@@ -0,0 +1,162 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "database/src/desktop/connection/web_socket_client_simulated.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "app/src/callback.h"
+#include "app/src/time.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace connection {
+
+WebSocketClientSimulated::WebSocketClientSimulated(
+    rest::NetworkSimulator* network, const std::string& uri,
+    scheduler::Scheduler* scheduler, WebSocketClientEventHandler* handler)
+    : network_(network),
+      uri_(uri),
+      scheduler_(scheduler),
+      handler_(handler),
+      upstream_arrival_ms_(0),
+      downstream_arrival_ms_(0),
+      safe_this_(this) {}
+
+WebSocketClientSimulated::~WebSocketClientSimulated() {
+  // Drop the deliveries still in flight, then the wrapped client.
+  safe_this_.ClearReference();
+  client_.reset(nullptr);
+}
+
+void WebSocketClientSimulated::set_client(
+    UniquePtr<WebSocketClientInterface> client) {
+  client_ = std::move(client);
+}
+
+void WebSocketClientSimulated::Connect(int timeout_ms) {
+  Transfer(true, Delivery(Delivery::kConnect, timeout_ms, nullptr));
+}
+
+void WebSocketClientSimulated::Close() {
+  Transfer(true, Delivery(Delivery::kClose, 0, nullptr));
+}
+
+void WebSocketClientSimulated::Send(const char* msg) {
+  Transfer(true, Delivery(Delivery::kSend, 0, msg));
+}
+
+void WebSocketClientSimulated::OnOpen() {
+  Transfer(false, Delivery(Delivery::kOnOpen, 0, nullptr));
+}
+
+void WebSocketClientSimulated::OnMessage(const char* msg) {
+  Transfer(false, Delivery(Delivery::kOnMessage, 0, msg));
+}
+
+void WebSocketClientSimulated::OnClose() {
+  Transfer(false, Delivery(Delivery::kOnClose, 0, nullptr));
+}
+
+void WebSocketClientSimulated::OnError(
+    const WebSocketClientErrorData& error_data) {
+  Transfer(false, Delivery(Delivery::kOnError, 0, nullptr));
+}
+
+void WebSocketClientSimulated::Transfer(bool upstream,
+                                        const Delivery& delivery) {
+  // Held while sending, so that transfers draw from the network in the order
+  // they are queued.
+  MutexLock lock(mutex_);
+  rest::NetworkSimulator::Transfer transfer =
+      network_->Send(delivery.message.size());
+  if (transfer.failed) {
+    switch (delivery.type) {
+      case Delivery::kConnect:
+        // The connection could not be established.
+        upstream = false;
+        downstream_.push(Delivery(Delivery::kOnError, 0, nullptr));
+        break;
+      case Delivery::kSend:
+      case Delivery::kOnOpen:
+      case Delivery::kOnMessage:
+        // The connection was lost, and the message with it.
+        upstream = true;
+        upstream_.push(Delivery(Delivery::kClose, 0, nullptr));
+        break;
+      default:
+        // The connection is going away anyway.
+        (upstream ? upstream_ : downstream_).push(delivery);
+        break;
+    }
+  } else {
+    (upstream ? upstream_ : downstream_).push(delivery);
+  }
+
+  uint64_t now = firebase::internal::GetTimestamp();
+  uint64_t& last_arrival_ms =
+      upstream ? upstream_arrival_ms_ : downstream_arrival_ms_;
+  last_arrival_ms = std::max(
+      last_arrival_ms, now + static_cast<uint64_t>(transfer.delay_ms));
+  scheduler_->Schedule(
+      callback::NewCallback(
+          [](ThisRef ref, bool upstream) {
+            ThisRefLock lock(&ref);
+            WebSocketClientSimulated* client = lock.GetReference();
+            if (client != nullptr) client->DeliverNext(upstream);
+          },
+          safe_this_, upstream),
+      last_arrival_ms - now);
+}
+
+void WebSocketClientSimulated::DeliverNext(bool upstream) {
+  Delivery delivery(Delivery::kClose, 0, nullptr);
+  {
+    MutexLock lock(mutex_);
+    std::queue<Delivery>& deliveries = upstream ? upstream_ : downstream_;
+    delivery = std::move(deliveries.front());
+    deliveries.pop();
+  }
+
+  switch (delivery.type) {
+    case Delivery::kConnect:
+      if (client_) client_->Connect(delivery.timeout_ms);
+      break;
+    case Delivery::kSend:
+      if (client_) client_->Send(delivery.message.c_str());
+      break;
+    case Delivery::kClose:
+      if (client_) client_->Close();
+      break;
+    case Delivery::kOnOpen:
+      if (handler_) handler_->OnOpen();
+      break;
+    case Delivery::kOnMessage:
+      if (handler_) handler_->OnMessage(delivery.message.c_str());
+      break;
+    case Delivery::kOnClose:
+      if (handler_) handler_->OnClose();
+      break;
+    case Delivery::kOnError:
+      if (handler_) handler_->OnError(WebSocketClientErrorData(uri_.c_str()));
+      break;
+  }
+}
+
+}  // namespace connection
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
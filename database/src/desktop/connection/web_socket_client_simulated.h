@@ -0,0 +1,149 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FIREBASE_DATABASE_SRC_DESKTOP_CONNECTION_WEB_SOCKET_CLIENT_SIMULATED_H_
+#define FIREBASE_DATABASE_SRC_DESKTOP_CONNECTION_WEB_SOCKET_CLIENT_SIMULATED_H_
+
+#include <cstdint>
+#include <queue>
+#include <string>
+
+#include "app/memory/unique_ptr.h"
+#include "app/rest/network_simulator.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/safe_reference.h"
+#include "app/src/scheduler.h"
+#include "database/src/desktop/connection/web_socket_client_interface.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace connection {
+
+// Carries a websocket connection over a simulated network. Everything sent
+// by the handler, and every event of the wrapped client, is delayed as the
+// NetworkSimulator decides, in order. A transfer that fails drops the
+// connection: a failed connection attempt is reported with OnError(), and a
+// failed message closes the wrapped client, which reports OnClose(). Like
+// WebSocketClientImpl, it calls the handler on the given scheduler's thread.
+//
+// The wrapped client must send its events to this client, so it is set after
+// construction, e.g. from a factory passed to SetWebSocketClientFactory():
+//
+//   UniquePtr<WebSocketClientInterface> CreateSimulatedClient(
+//       const HostInfo& info, WebSocketClientEventHandler* delegate,
+//       const char* opt_last_session_id, Logger* logger,
+//       scheduler::Scheduler* scheduler) {
+//     std::string uri = info.GetConnectionUrl(opt_last_session_id);
+//     auto client = MakeUnique<WebSocketClientSimulated>(
+//         &g_network, uri, scheduler, delegate);
+//     client->set_client(MakeUnique<WebSocketClientImpl>(
+//         uri, info.user_agent(), logger, scheduler, client.get()));
+//     return client;
+//   }
+class WebSocketClientSimulated : public WebSocketClientInterface,
+                                 public WebSocketClientEventHandler {
+ public:
+  // `network` must outlive the client.
+  WebSocketClientSimulated(rest::NetworkSimulator* network,
+                           const std::string& uri,
+                           scheduler::Scheduler* scheduler,
+                           WebSocketClientEventHandler* handler);
+  ~WebSocketClientSimulated() override;
+
+  // WebSocketClientSimulated is neither copyable nor movable.
+  WebSocketClientSimulated(const WebSocketClientSimulated&) = delete;
+  WebSocketClientSimulated& operator=(const WebSocketClientSimulated&) =
+      delete;
+
+  // Sets the client that carries the connection. Must be called before
+  // Connect().
+  void set_client(UniquePtr<WebSocketClientInterface> client);
+
+  // BEGIN WebSocketClientInterface
+  void Connect(int timeout_ms) override;
+  void Close() override;
+  void Send(const char* msg) override;
+  // END WebSocketClientInterface
+
+  // BEGIN WebSocketClientEventHandler
+  void OnOpen() override;
+  void OnMessage(const char* msg) override;
+  void OnClose() override;
+  void OnError(const WebSocketClientErrorData& error_data) override;
+  // END WebSocketClientEventHandler
+
+ private:
+  // Something waiting to arrive at the other end of the simulated network.
+  struct Delivery {
+    enum Type {
+      // To the wrapped client.
+      kConnect,
+      kSend,
+      kClose,
+      // To the handler.
+      kOnOpen,
+      kOnMessage,
+      kOnClose,
+      kOnError,
+    };
+
+    Delivery(Type type, int timeout_ms, const char* message)
+        : type(type), timeout_ms(timeout_ms), message(message ? message : "") {}
+
+    Type type;
+    int timeout_ms;
+    std::string message;
+  };
+
+  // Sends `delivery` over the network towards the server when `upstream` is
+  // true, or towards the handler otherwise.
+  void Transfer(bool upstream, const Delivery& delivery);
+
+  // Delivers the oldest delivery sent in one direction.
+  void DeliverNext(bool upstream);
+
+  rest::NetworkSimulator* network_;
+  const std::string uri_;
+  scheduler::Scheduler* scheduler_;
+  WebSocketClientEventHandler* handler_;
+  UniquePtr<WebSocketClientInterface> client_;
+
+  // Deliveries in each direction, in the order they were sent. Like a TCP
+  // stream, a delivery never arrives before the ones sent ahead of it. Each
+  // is delivered by a callback scheduled for when it arrives, which takes the
+  // oldest one, so that callbacks due in the same millisecond cannot reorder
+  // them.
+  Mutex mutex_;
+  std::queue<Delivery> upstream_;
+  std::queue<Delivery> downstream_;
+  // When the last delivery sent in each direction arrives, as returned by
+  // firebase::internal::GetTimestamp().
+  uint64_t upstream_arrival_ms_;
+  uint64_t downstream_arrival_ms_;
+
+  // Safe reference to this, for the deliveries scheduled on scheduler_.
+  // Cleared in the destructor.
+  typedef firebase::internal::SafeReference<WebSocketClientSimulated> ThisRef;
+  typedef firebase::internal::SafeReferenceLock<WebSocketClientSimulated>
+      ThisRefLock;
+  ThisRef safe_this_;
+};
+
+}  // namespace connection
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
+
+#endif  // FIREBASE_DATABASE_SRC_DESKTOP_CONNECTION_WEB_SOCKET_CLIENT_SIMULATED_H_
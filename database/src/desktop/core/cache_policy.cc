@@ -54,6 +54,8 @@ uint64_t LRUCachePolicy::GetMaxNumberOfQueriesToKeep() const {
   return kMaxNumberOfPrunableQueriesToKeep;
 }
 
+uint64_t LRUCachePolicy::GetMaxSizeBytes() const { return max_size_bytes_; }
+
 }  // namespace internal
 }  // namespace database
 }  // namespace firebase
@@ -34,6 +34,9 @@ class CachePolicy {
   virtual double GetPercentOfQueriesToPruneAtOnce() const = 0;
 
   virtual uint64_t GetMaxNumberOfQueriesToKeep() const = 0;
+
+  // The size the server cache is pruned down to.
+  virtual uint64_t GetMaxSizeBytes() const = 0;
 };
 
 class LRUCachePolicy : public CachePolicy {
@@ -52,6 +55,8 @@ class LRUCachePolicy : public CachePolicy {
 
   uint64_t GetMaxNumberOfQueriesToKeep() const override;
 
+  uint64_t GetMaxSizeBytes() const override;
+
  private:
   const uint64_t max_size_bytes_;
 };
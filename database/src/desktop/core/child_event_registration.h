@@ -49,6 +49,8 @@ class ChildEventRegistration : public EventRegistration {
 
   bool MatchesListener(const void* listener_ptr) const override;
 
+  const DatabaseInternal* database() const override { return database_; }
+
  private:
   DatabaseInternal* database_;
   ChildListener* listener_;
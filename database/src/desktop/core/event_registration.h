@@ -25,6 +25,7 @@ namespace firebase {
 namespace database {
 namespace internal {
 
+class DatabaseInternal;
 struct Event;
 
 // An EventRegistration is an abstract class that can contain any kind of event
@@ -59,6 +60,10 @@ class EventRegistration {
   // share a common base class.
   virtual bool MatchesListener(const void* listener_ptr) const = 0;
 
+  // The database this EventRegistration delivers events through, or null if
+  // it does not belong to a database.
+  virtual const DatabaseInternal* database() const { return nullptr; }
+
   const QuerySpec& query_spec() const { return query_spec_; }
 
   bool is_user_initiated() { return is_user_initiated_; }
@@ -19,6 +19,7 @@
 #include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/log.h"
 #include "app/src/scheduler.h"
+#include "app/src/thread_pool.h"
 #include "app/src/variant_util.h"
 #include "database/src/desktop/connection/persistent_connection.h"
 #include "database/src/desktop/core/constants.h"
@@ -31,6 +32,7 @@
 #include "database/src/desktop/database_desktop.h"
 #include "database/src/desktop/database_reference_desktop.h"
 #include "database/src/desktop/mutable_data_desktop.h"
+#include "database/src/desktop/persistence/caching_persistence_storage_engine.h"
 #include "database/src/desktop/persistence/level_db_persistence_storage_engine.h"
 #include "database/src/desktop/persistence/noop_persistence_manager.h"
 #include "database/src/desktop/persistence/persistence_manager_interface.h"
@@ -80,10 +82,13 @@ class TransactionResponse : public connection::Response {
 };
 
 Repo::Repo(App* app, DatabaseInternal* database, const char* url,
-           Logger* logger, bool persistence_enabled)
+           Logger* logger, bool persistence_enabled,
+           bool persistence_sync_enabled)
     : database_(database),
       host_info_(),
       persistence_enabled_(persistence_enabled),
+      persistence_sync_enabled_(persistence_sync_enabled),
+      persistence_flush_scheduled_(false),
       connection_(),
       server_time_offset_(0),
       next_write_id_(0),
@@ -102,7 +107,9 @@ Repo::Repo(App* app, DatabaseInternal* database, const char* url,
   {
     MutexLock lock(g_scheduler_mutex);
     g_scheduler_ref_count++;
-    if (s_scheduler_ == nullptr) s_scheduler_ = new scheduler::Scheduler();
+    if (s_scheduler_ == nullptr) {
+      s_scheduler_ = new scheduler::Scheduler(ThreadPool::Shared());
+    }
   }
 
   connection_.reset(new connection::PersistentConnection(
@@ -125,6 +132,7 @@ Repo::~Repo() {
   // Terminate the connection immediately to prevent messages from arriving
   // while the SyncTree is being torn down.
   safe_this_.ClearReference();
+  if (persistence_flush_handle_.IsValid()) persistence_flush_handle_.Cancel();
   connection_.reset(nullptr);
   {
     MutexLock lock(g_scheduler_mutex);
@@ -146,38 +154,73 @@ void Repo::AddEventCallback(UniquePtr<EventRegistration> event_registration) {
   PostEvents(events);
 }
 
-void Repo::RemoveEventCallback(void* listener_ptr,
+void Repo::RemoveEventCallback(const DatabaseInternal* database,
+                               void* listener_ptr,
                                const QuerySpec& query_spec) {
   std::vector<Event> events;
   if (StringStartsWith(query_spec.path.str(), kDotInfo)) {
     events = info_sync_tree_->RemoveEventRegistration(query_spec, listener_ptr,
-                                                      kErrorNone);
+                                                      database, kErrorNone);
   } else {
     events = server_sync_tree_->RemoveEventRegistration(
-        query_spec, listener_ptr, kErrorNone);
+        query_spec, listener_ptr, database, kErrorNone);
   }
   PostEvents(events);
 }
 
-class OnDisconnectResponse : public connection::Response {
+// A request whose future is completed when the server responds. The future
+// belongs to the database that made the request, so when that database stops
+// using this Repo the future is completed early and the response leaves it
+// alone.
+class FutureResponse : public connection::Response {
+ public:
+  FutureResponse(DatabaseInternal* database, ReferenceCountedFutureImpl* api,
+                 const SafeFutureHandle<void>& handle,
+                 ResponseCallback callback)
+      : connection::Response(callback),
+        database_(database),
+        api_(api),
+        handle_(handle) {
+    assert(api != nullptr);
+  }
+
+  DatabaseInternal* database() const { return database_; }
+
+  // Complete the future, unless it was already released.
+  void CompleteFuture(Error error, const char* error_message) {
+    if (api_ != nullptr) api_->Complete(handle_, error, error_message);
+  }
+
+  // Complete the future now with the given error, and detach it from the
+  // database so that the response does not complete it again.
+  void ReleaseFuture(Error error) {
+    CompleteFuture(error, database::GetErrorMessage(error));
+    api_ = nullptr;
+    database_ = nullptr;
+  }
+
+ private:
+  DatabaseInternal* database_;
+  ReferenceCountedFutureImpl* api_;
+  SafeFutureHandle<void> handle_;
+};
+
+class OnDisconnectResponse : public FutureResponse {
  public:
-  OnDisconnectResponse(Repo* repo, const SafeFutureHandle<void>& handle,
+  OnDisconnectResponse(Repo* repo, DatabaseInternal* database,
+                       const SafeFutureHandle<void>& handle,
                        ReferenceCountedFutureImpl* ref_future, const Path& path,
                        const Variant& data, ResponseCallback callback)
-      : connection::Response(callback),
+      : FutureResponse(database, ref_future, handle, callback),
         repo_(repo),
-        handle_(handle),
-        ref_future_(ref_future),
         path_(path),
-        data_(data) {
-    assert(ref_future != nullptr);
-  }
+        data_(data) {}
 
   void MarkComplete() {
     if (!HasError()) {
-      ref_future_->Complete(handle_, kErrorNone);
+      CompleteFuture(kErrorNone, nullptr);
     } else {
-      ref_future_->Complete(handle_, GetErrorCode(), GetErrorMessage().c_str());
+      CompleteFuture(GetErrorCode(), GetErrorMessage().c_str());
     }
   }
 
@@ -187,17 +230,16 @@ class OnDisconnectResponse : public connection::Response {
 
  private:
   Repo* repo_;
-  SafeFutureHandle<void> handle_;
-  ReferenceCountedFutureImpl* ref_future_;
   Path path_;
   Variant data_;
 };
 
-void Repo::OnDisconnectSetValue(const SafeFutureHandle<void>& handle,
+void Repo::OnDisconnectSetValue(DatabaseInternal* database,
+                                const SafeFutureHandle<void>& handle,
                                 ReferenceCountedFutureImpl* ref_future,
                                 const Path& path, const Variant& data) {
   connection::ResponsePtr response = MakeShared<OnDisconnectResponse>(
-      this, handle, ref_future, path, data,
+      this, database, handle, ref_future, path, data,
       [](const connection::ResponsePtr& ptr) {
         OnDisconnectResponse* response =
             static_cast<OnDisconnectResponse*>(ptr.get());
@@ -206,6 +248,7 @@ void Repo::OnDisconnectSetValue(const SafeFutureHandle<void>& handle,
           response->repo()->on_disconnect_.Remember(response->path(),
                                                     response->data());
         }
+        response->repo()->outstanding_future_responses_.erase(ptr.get());
         response->MarkComplete();
       });
 
@@ -216,6 +259,7 @@ void Repo::OnDisconnectSetValue(const SafeFutureHandle<void>& handle,
           OnDisconnectResponse* response =
               static_cast<OnDisconnectResponse*>(ptr.get());
           assert(response);
+          lock.GetReference()->outstanding_future_responses_[ptr.get()] = ptr;
           lock.GetReference()->connection()->OnDisconnectPut(
               response->path(), response->data(), ptr);
         }
@@ -223,11 +267,12 @@ void Repo::OnDisconnectSetValue(const SafeFutureHandle<void>& handle,
       safe_this_, response));
 }
 
-void Repo::OnDisconnectCancel(const SafeFutureHandle<void>& handle,
+void Repo::OnDisconnectCancel(DatabaseInternal* database,
+                              const SafeFutureHandle<void>& handle,
                               ReferenceCountedFutureImpl* ref_future,
                               const Path& path) {
   connection::ResponsePtr response = MakeShared<OnDisconnectResponse>(
-      this, handle, ref_future, path, Variant::Null(),
+      this, database, handle, ref_future, path, Variant::Null(),
       [](const connection::ResponsePtr& ptr) {
         OnDisconnectResponse* response =
             static_cast<OnDisconnectResponse*>(ptr.get());
@@ -235,6 +280,7 @@ void Repo::OnDisconnectCancel(const SafeFutureHandle<void>& handle,
         if (!response->HasError()) {
           response->repo()->on_disconnect_.Forget(response->path());
         }
+        response->repo()->outstanding_future_responses_.erase(ptr.get());
         response->MarkComplete();
       });
 
@@ -245,6 +291,7 @@ void Repo::OnDisconnectCancel(const SafeFutureHandle<void>& handle,
           OnDisconnectResponse* response =
               static_cast<OnDisconnectResponse*>(ptr.get());
           assert(response);
+          lock.GetReference()->outstanding_future_responses_[ptr.get()] = ptr;
           lock.GetReference()->connection()->OnDisconnectCancel(
               response->path(), ptr);
         }
@@ -252,11 +299,12 @@ void Repo::OnDisconnectCancel(const SafeFutureHandle<void>& handle,
       safe_this_, response));
 }
 
-void Repo::OnDisconnectUpdate(const SafeFutureHandle<void>& handle,
+void Repo::OnDisconnectUpdate(DatabaseInternal* database,
+                              const SafeFutureHandle<void>& handle,
                               ReferenceCountedFutureImpl* ref_future,
                               const Path& path, const Variant& data) {
   connection::ResponsePtr response = MakeShared<OnDisconnectResponse>(
-      this, handle, ref_future, path, data,
+      this, database, handle, ref_future, path, data,
       [](const connection::ResponsePtr& ptr) {
         OnDisconnectResponse* response =
             static_cast<OnDisconnectResponse*>(ptr.get());
@@ -272,6 +320,7 @@ void Repo::OnDisconnectUpdate(const SafeFutureHandle<void>& handle,
             }
           }
         }
+        response->repo()->outstanding_future_responses_.erase(ptr.get());
         response->MarkComplete();
       });
 
@@ -282,6 +331,7 @@ void Repo::OnDisconnectUpdate(const SafeFutureHandle<void>& handle,
           OnDisconnectResponse* response =
               static_cast<OnDisconnectResponse*>(ptr.get());
           assert(response);
+          lock.GetReference()->outstanding_future_responses_[ptr.get()] = ptr;
           lock.GetReference()->connection()->OnDisconnectMerge(
               response->path(), response->data(), ptr);
         }
@@ -301,23 +351,20 @@ void Repo::PurgeOutstandingWrites() {
 // Transaction Response class to pass to PersistentConnection.
 // This is used to capture all the data to use when ResponseCallback is
 // triggered.
-class SetValueResponse : public connection::Response {
+class SetValueResponse : public FutureResponse {
  public:
-  SetValueResponse(const Repo::ThisRef& repo, const Path& path,
-                   WriteId write_id, ReferenceCountedFutureImpl* api,
+  SetValueResponse(const Repo::ThisRef& repo, DatabaseInternal* database,
+                   const Path& path, WriteId write_id,
+                   ReferenceCountedFutureImpl* api,
                    SafeFutureHandle<void> handle, ResponseCallback callback)
-      : connection::Response(callback),
+      : FutureResponse(database, api, handle, callback),
         repo_ref_(repo),
         path_(path),
-        write_id_(write_id),
-        api_(api),
-        handle_(handle) {}
+        write_id_(write_id) {}
 
   Repo::ThisRef& repo_ref() { return repo_ref_; }
   const Path& path() { return path_; }
   WriteId write_id() { return write_id_; }
-  ReferenceCountedFutureImpl* api() { return api_; }
-  SafeFutureHandle<void> handle() { return handle_; }
 
  private:
   // Repo reference
@@ -327,13 +374,10 @@ class SetValueResponse : public connection::Response {
   Path path_;
 
   WriteId write_id_;
-
-  ReferenceCountedFutureImpl* api_;
-
-  SafeFutureHandle<void> handle_;
 };
 
-void Repo::SetValue(const Path& path, const Variant& new_data_unresolved,
+void Repo::SetValue(DatabaseInternal* database, const Path& path,
+                    const Variant& new_data_unresolved,
                     ReferenceCountedFutureImpl* api,
                     SafeFutureHandle<void> handle) {
   Variant server_values = GenerateServerValues(server_time_offset_);
@@ -346,28 +390,18 @@ void Repo::SetValue(const Path& path, const Variant& new_data_unresolved,
       kPersist);
   PostEvents(events);
 
-  connection_->Put(path, new_data_unresolved,
-                   MakeShared<SetValueResponse>(
-                       Repo::ThisRef(this), path, write_id, api, handle,
-                       [](const connection::ResponsePtr& ptr) {
-                         auto* response =
-                             static_cast<SetValueResponse*>(ptr.get());
-                         Repo::ThisRefLock lock(&response->repo_ref());
-                         Repo* repo = lock.GetReference();
-                         repo->AckWriteAndRerunTransactions(
-                             response->write_id(), response->path(),
-                             response->GetErrorCode());
-                         response->api()->Complete(
-                             response->handle(), response->GetErrorCode(),
-                             GetErrorMessage(response->GetErrorCode()));
-                       }));
+  connection::ResponsePtr response = MakeShared<SetValueResponse>(
+      Repo::ThisRef(this), database, path, write_id, api, handle,
+      &Repo::HandleWriteResponse);
+  outstanding_future_responses_[response.get()] = response;
+  connection_->Put(path, new_data_unresolved, response);
 
   Path affected_path = AbortTransactions(path, kErrorOverriddenBySet);
   RerunTransactions(affected_path);
 }
 
-void Repo::UpdateChildren(const Path& path, const Variant& data,
-                          ReferenceCountedFutureImpl* api,
+void Repo::UpdateChildren(DatabaseInternal* database, const Path& path,
+                          const Variant& data, ReferenceCountedFutureImpl* api,
                           SafeFutureHandle<void> handle) {
   CompoundWrite updates = CompoundWrite::FromVariantMerge(data);
   if (updates.IsEmpty()) {
@@ -385,21 +419,11 @@ void Repo::UpdateChildren(const Path& path, const Variant& data,
       path, updates, resolved, write_id, kPersist);
   PostEvents(events);
 
-  connection_->Merge(path, data,
-                     MakeShared<SetValueResponse>(
-                         Repo::ThisRef(this), path, write_id, api, handle,
-                         [](const connection::ResponsePtr& ptr) {
-                           auto* response =
-                               static_cast<SetValueResponse*>(ptr.get());
-                           Repo::ThisRefLock lock(&response->repo_ref());
-                           Repo* repo = lock.GetReference();
-                           repo->AckWriteAndRerunTransactions(
-                               response->write_id(), response->path(),
-                               response->GetErrorCode());
-                           response->api()->Complete(
-                               response->handle(), response->GetErrorCode(),
-                               GetErrorMessage(response->GetErrorCode()));
-                         }));
+  connection::ResponsePtr response = MakeShared<SetValueResponse>(
+      Repo::ThisRef(this), database, path, write_id, api, handle,
+      &Repo::HandleWriteResponse);
+  outstanding_future_responses_[response.get()] = response;
+  connection_->Merge(path, data, response);
 
   updates.write_tree().CallOnEach(
       Path(), [this](const Path& path_from_root, const Variant& variant) {
@@ -409,6 +433,17 @@ void Repo::UpdateChildren(const Path& path, const Variant& data,
       });
 }
 
+void Repo::HandleWriteResponse(const connection::ResponsePtr& ptr) {
+  auto* response = static_cast<SetValueResponse*>(ptr.get());
+  Repo::ThisRefLock lock(&response->repo_ref());
+  Repo* repo = lock.GetReference();
+  repo->outstanding_future_responses_.erase(ptr.get());
+  repo->AckWriteAndRerunTransactions(response->write_id(), response->path(),
+                                     response->GetErrorCode());
+  response->CompleteFuture(response->GetErrorCode(),
+                           GetErrorMessage(response->GetErrorCode()));
+}
+
 void Repo::AckWriteAndRerunTransactions(WriteId write_id, const Path& path,
                                         Error error) {
   if (error == kErrorWriteCanceled) {
@@ -424,19 +459,37 @@ void Repo::AckWriteAndRerunTransactions(WriteId write_id, const Path& path,
     RerunTransactions(path);
   }
   PostEvents(events);
+  // Commit any grouped writes before the caller's future completes.
+  server_sync_tree_->FlushPersistence();
 }
 
+// Writes from consecutive transactions are grouped into a single LevelDB
+// commit until either this many bytes are pending or the oldest pending write
+// is kPersistenceGroupCommitWindowMs old.
+static const size_t kPersistenceGroupCommitBytes = 64 * 1024;
+static const uint64_t kPersistenceGroupCommitWindowMs = 10;
+
+// Recently loaded server cache subtrees are kept decoded in memory up to this
+// many bytes, so that attaching views does not always rebuild them from disk.
+static const size_t kServerCacheMemoryTierBytes = 2 * 1024 * 1024;
+
 static UniquePtr<PersistenceManagerInterface> CreatePersistenceManager(
-    const char* app_data_path, LoggerBase* logger) {
+    const char* app_data_path, const GroupCommitOptions& group_commit_options,
+    LoggerBase* logger) {
   static const uint64_t kDefaultCacheSize = 10 * 1024 * 1024;
 
-  auto persistence_storage_engine =
-      MakeUnique<LevelDbPersistenceStorageEngine>(logger);
+  auto level_db_storage_engine =
+      MakeUnique<LevelDbPersistenceStorageEngine>(logger,
+                                                  group_commit_options);
 
-  if (!persistence_storage_engine->Initialize(app_data_path)) {
+  if (!level_db_storage_engine->Initialize(app_data_path)) {
     logger->LogError("Could not initialize persistence");
     return UniquePtr<PersistenceManager>();
   }
+  UniquePtr<PersistenceStorageEngine> persistence_storage_engine =
+      MakeUnique<CachingPersistenceStorageEngine>(
+          std::move(level_db_storage_engine), kServerCacheMemoryTierBytes,
+          logger);
   auto tracked_query_manager =
       MakeUnique<TrackedQueryManager>(persistence_storage_engine.get(), logger);
 
@@ -493,8 +546,15 @@ void Repo::DeferredInitialization() {
     // Set up persistence manager
     UniquePtr<PersistenceManagerInterface> persistence_manager;
     if (persistence_enabled_) {
-      persistence_manager =
-          CreatePersistenceManager(app_data_path.c_str(), logger_);
+      GroupCommitOptions group_commit_options;
+      group_commit_options.max_pending_bytes = kPersistenceGroupCommitBytes;
+      group_commit_options.max_pending_milliseconds =
+          kPersistenceGroupCommitWindowMs;
+      group_commit_options.sync = persistence_sync_enabled_;
+      group_commit_options.pending_writes_callback = OnPersistenceWritesPending;
+      group_commit_options.pending_writes_callback_data = this;
+      persistence_manager = CreatePersistenceManager(
+          app_data_path.c_str(), group_commit_options, logger_);
     } else {
       persistence_manager = MakeUnique<NoopPersistenceManager>();
     }
@@ -527,6 +587,33 @@ void Repo::DeferredInitialization() {
   UpdateInfo(kDotInfoConnected, false);
 }
 
+void Repo::OnPersistenceWritesPending(void* repo) {
+  static_cast<Repo*>(repo)->SchedulePersistenceFlush();
+}
+
+void Repo::SchedulePersistenceFlush() {
+  if (persistence_flush_scheduled_) return;
+  persistence_flush_scheduled_ = true;
+  // Make sure grouped writes are committed even if no further transactions
+  // arrive to trigger the commit. The cache is pruned a step at a time from
+  // here too, so that other work on the scheduler runs in between steps.
+  persistence_flush_handle_ = s_scheduler_->Schedule(
+      NewCallback(
+          [](ThisRef ref) {
+            ThisRefLock lock(&ref);
+            Repo* repo = lock.GetReference();
+            if (repo == nullptr) return;
+            repo->persistence_flush_scheduled_ = false;
+            SyncTree* sync_tree = repo->server_sync_tree_.get();
+            sync_tree->FlushPersistence();
+            if (sync_tree->PrunePersistence()) {
+              repo->SchedulePersistenceFlush();
+            }
+          },
+          safe_this_),
+      kPersistenceGroupCommitWindowMs);
+}
+
 void Repo::PostEvents(const std::vector<Event>& events) {
   for (const Event& event : events) {
     if (event.type != kEventTypeError) {
@@ -617,6 +704,67 @@ void Repo::OnDataUpdate(const Path& path, const Variant& data, bool is_merge,
   PostEvents(events);
 }
 
+void Repo::SetPrimaryDatabase(DatabaseInternal* database) {
+  database_ = database;
+  connection_->SetApp(database->GetApp());
+}
+
+void Repo::ReleaseDatabase(DatabaseInternal* database) {
+  // Writes and onDisconnect operations already sent still go through, but
+  // their futures are completed now.
+  for (auto& entry : outstanding_future_responses_) {
+    auto* response = static_cast<FutureResponse*>(entry.first);
+    if (response->database() == database) {
+      response->ReleaseFuture(kErrorWriteCanceled);
+    }
+  }
+
+  std::vector<Event> events;
+  ReleaseTransactions(&transaction_queue_tree_, database, &events);
+  PruneCompletedTransactions(&transaction_queue_tree_);
+  PostEvents(events);
+}
+
+void Repo::ReleaseTransactions(Tree<std::vector<TransactionDataPtr>>* node,
+                               DatabaseInternal* database,
+                               std::vector<Event>* events) {
+  Optional<std::vector<TransactionDataPtr>>& queue = node->value();
+  if (queue.has_value()) {
+    for (const TransactionDataPtr& transaction : *queue) {
+      if (transaction->database != database ||
+          transaction->status == TransactionData::kStatusComplete) {
+        continue;
+      }
+      RemoveEventCallback(database, transaction->outstanding_listener.get(),
+                          QuerySpec(transaction->path));
+      transaction->ref_future->Complete(
+          transaction->future_handle, kErrorWriteCanceled,
+          GetErrorMessage(kErrorWriteCanceled));
+      if (transaction->status == TransactionData::kStatusSent ||
+          transaction->status == TransactionData::kStatusSentNeedsAbort) {
+        // The server still answers a sent transaction. Abort it then as if it
+        // was overridden by a set, which reverts its local write.
+        transaction->status = TransactionData::kStatusSentNeedsAbort;
+        transaction->abort_reason = kErrorOverriddenBySet;
+      } else {
+        if (transaction->status != TransactionData::kStatusNeedsAbort ||
+            transaction->abort_reason != kErrorWriteCanceled) {
+          Extend(events, server_sync_tree_->AckUserWrite(
+                             transaction->current_write_id, kAckRevert,
+                             kDoNotPersist, server_time_offset_));
+        }
+        transaction->status = TransactionData::kStatusComplete;
+      }
+      // Nothing may call back into the database from now on.
+      transaction->database = nullptr;
+      transaction->ref_future = nullptr;
+    }
+  }
+  for (auto& key_subtree_pair : node->children()) {
+    ReleaseTransactions(&key_subtree_pair.second, database, events);
+  }
+}
+
 void Repo::SetKeepSynchronized(const QuerySpec& query_spec,
                                bool keep_synchronized) {
   server_sync_tree_->SetKeepSynchronized(query_spec, keep_synchronized);
@@ -632,7 +780,7 @@ class NoopListener : public ValueListener {
   }
 };
 
-void Repo::StartTransaction(const Path& path,
+void Repo::StartTransaction(DatabaseInternal* database, const Path& path,
                             DoTransactionWithContext transaction_function,
                             void* context, void (*delete_context)(void*),
                             bool trigger_local_events,
@@ -643,23 +791,23 @@ void Repo::StartTransaction(const Path& path,
   // to be done in this block.  This is ok, this block is guaranteed to be our
   // own event loop
   DatabaseReferenceInternal* ref_impl =
-      new DatabaseReferenceInternal(database_, path);
+      new DatabaseReferenceInternal(database, path);
   DatabaseReference watch_ref(ref_impl);
   UniquePtr<NoopListener> listener = MakeUnique<NoopListener>();
   NoopListener* listener_ptr = listener.get();
   QuerySpec query_spec(path);
   AddEventCallback(
-      MakeUnique<ValueEventRegistration>(database_, listener_ptr, query_spec));
+      MakeUnique<ValueEventRegistration>(database, listener_ptr, query_spec));
 
   TransactionDataPtr transaction_data = MakeShared<TransactionData>(
-      handle, api, query_spec.path, transaction_function, context,
+      database, handle, api, query_spec.path, transaction_function, context,
       delete_context, trigger_local_events, std::move(listener));
 
   // Run transaction initially.
   Variant current_state = GetLatestState(path);
   transaction_data->current_input_snapshot = current_state;
   MutableDataInternal* mutable_data_impl =
-      new MutableDataInternal(database_, current_state);
+      new MutableDataInternal(database, current_state);
   MutableData mutable_current(mutable_data_impl);
 
   TransactionResult result = transaction_function(&mutable_current, context);
@@ -672,7 +820,7 @@ void Repo::StartTransaction(const Path& path,
                                            kErrorWriteCanceled);
     // If there was an error, the listener must be removed to prevent calls to
     // it in case the listener is destroyed.
-    RemoveEventCallback(listener_ptr, query_spec);
+    RemoveEventCallback(database, listener_ptr, query_spec);
   } else {
     // Mark as run and add to our queue.
     transaction_data->status = TransactionData::kStatusRun;
@@ -796,7 +944,8 @@ void Repo::AbortTransactionsAtNode(Tree<std::vector<TransactionDataPtr>>* node,
             transaction->status == TransactionData::kStatusRun,
             "Unexpected transaction status in abort");
         // We can abort this immediately.
-        RemoveEventCallback(transaction->outstanding_listener.get(),
+        RemoveEventCallback(transaction->database,
+                            transaction->outstanding_listener.get(),
                             QuerySpec(transaction->path));
         if (reason == kErrorOverriddenBySet) {
           Extend(&events, server_sync_tree_->AckUserWrite(
@@ -947,12 +1096,17 @@ void Repo::HandleTransactionResponse(const connection::ResponsePtr& ptr) {
       TransactionDataPtr& transaction = future_to_complete.transaction;
       const Variant& node = future_to_complete.node;
 
-      DataSnapshot snapshot(new DataSnapshotInternal(
-          database_, node, QuerySpec(transaction->path)));
-      transaction->ref_future->CompleteWithResult(transaction->future_handle,
-                                                  kErrorNone, snapshot);
+      // The future is gone if the database that started the transaction
+      // stopped using this Repo while it was outstanding.
+      if (transaction->ref_future != nullptr) {
+        DataSnapshot snapshot(new DataSnapshotInternal(
+            transaction->database, node, QuerySpec(transaction->path)));
+        transaction->ref_future->CompleteWithResult(transaction->future_handle,
+                                                    kErrorNone, snapshot);
+      }
 
-      RemoveEventCallback(transaction->outstanding_listener.get(),
+      RemoveEventCallback(transaction->database,
+                          transaction->outstanding_listener.get(),
                           QuerySpec(path));
     }
   } else {
@@ -1038,7 +1192,7 @@ void Repo::RerunTransactionQueue(const std::vector<TransactionDataPtr>& queue,
         transaction->current_input_snapshot = current_input;
 
         MutableDataInternal* mutable_data_impl =
-            new MutableDataInternal(database_, current_input);
+            new MutableDataInternal(transaction->database, current_input);
         MutableData mutable_data(mutable_data_impl);
         Error error = kErrorNone;
         TransactionResult result = transaction->transaction_function(
@@ -1081,7 +1235,7 @@ void Repo::RerunTransactionQueue(const std::vector<TransactionDataPtr>& queue,
     if (abort_transaction) {
       transaction->status = TransactionData::kStatusComplete;
       DatabaseReferenceInternal* database_ref_impl =
-          new DatabaseReferenceInternal(database_, path);
+          new DatabaseReferenceInternal(transaction->database, path);
       DatabaseReference ref(database_ref_impl);
 
       futures_to_complete.push_back(FutureToComplete(
@@ -1092,7 +1246,8 @@ void Repo::RerunTransactionQueue(const std::vector<TransactionDataPtr>& queue,
       // callback until later.
       Repo::scheduler().Schedule(NewCallback(
           [](Repo* repo, TransactionDataPtr transaction) {
-            repo->RemoveEventCallback(transaction->outstanding_listener.get(),
+            repo->RemoveEventCallback(transaction->database,
+                                      transaction->outstanding_listener.get(),
                                       QuerySpec(transaction->path));
           },
           this, transaction));
@@ -1104,8 +1259,9 @@ void Repo::RerunTransactionQueue(const std::vector<TransactionDataPtr>& queue,
     TransactionDataPtr& transaction = future_to_complete.transaction;
     Error& abort_reason = future_to_complete.abort_reason;
     Variant& node = future_to_complete.node;
+    if (transaction->ref_future == nullptr) continue;
     DataSnapshot snapshot(new DataSnapshotInternal(
-        database_, node, QuerySpec(transaction->path)));
+        transaction->database, node, QuerySpec(transaction->path)));
     transaction->ref_future->CompleteWithResult(transaction->future_handle,
                                                 abort_reason, snapshot);
   }
@@ -15,6 +15,7 @@
 #ifndef FIREBASE_DATABASE_SRC_DESKTOP_CORE_REPO_H_
 #define FIREBASE_DATABASE_SRC_DESKTOP_CORE_REPO_H_
 
+#include <map>
 #include <vector>
 
 #include "app/memory/unique_ptr.h"
@@ -46,7 +47,7 @@ class Repo : public connection::PersistentConnectionEventHandler {
   typedef firebase::internal::SafeReferenceLock<Repo> ThisRefLock;
 
   Repo(App* app, DatabaseInternal* database, const char* url, Logger* logger,
-       bool persistence_enabled);
+       bool persistence_enabled, bool persistence_sync_enabled = false);
 
   ~Repo() override;
 
@@ -54,27 +55,34 @@ class Repo : public connection::PersistentConnectionEventHandler {
 
   void AddEventCallback(UniquePtr<EventRegistration> event_registration);
 
-  void RemoveEventCallback(void* listener_ptr, const QuerySpec& query_spec);
+  // Remove the event registration for the given listener that was made
+  // through the given database.
+  void RemoveEventCallback(const DatabaseInternal* database, void* listener_ptr,
+                           const QuerySpec& query_spec);
 
-  void OnDisconnectSetValue(const SafeFutureHandle<void>& handle,
+  void OnDisconnectSetValue(DatabaseInternal* database,
+                            const SafeFutureHandle<void>& handle,
                             ReferenceCountedFutureImpl* ref_future,
                             const Path& path, const Variant& data);
 
-  void OnDisconnectCancel(const SafeFutureHandle<void>& handle,
+  void OnDisconnectCancel(DatabaseInternal* database,
+                          const SafeFutureHandle<void>& handle,
                           ReferenceCountedFutureImpl* ref_future,
                           const Path& path);
 
-  void OnDisconnectUpdate(const SafeFutureHandle<void>& handle,
+  void OnDisconnectUpdate(DatabaseInternal* database,
+                          const SafeFutureHandle<void>& handle,
                           ReferenceCountedFutureImpl* ref_future,
                           const Path& path, const Variant& data);
 
   void PurgeOutstandingWrites();
 
-  void SetValue(const Path& path, const Variant& data,
-                ReferenceCountedFutureImpl* api, SafeFutureHandle<void> handle);
+  void SetValue(DatabaseInternal* database, const Path& path,
+                const Variant& data, ReferenceCountedFutureImpl* api,
+                SafeFutureHandle<void> handle);
 
-  void UpdateChildren(const Path& path, const Variant& data,
-                      ReferenceCountedFutureImpl* api,
+  void UpdateChildren(DatabaseInternal* database, const Path& path,
+                      const Variant& data, ReferenceCountedFutureImpl* api,
                       SafeFutureHandle<void> handle);
 
   void AckWriteAndRerunTransactions(WriteId write_id, const Path& path,
@@ -84,7 +92,7 @@ class Repo : public connection::PersistentConnectionEventHandler {
 
   void SetKeepSynchronized(const QuerySpec& query_spec, bool keep_synchronized);
 
-  void StartTransaction(const Path& path,
+  void StartTransaction(DatabaseInternal* database, const Path& path,
                         DoTransactionWithContext transaction_function,
                         void* context, void (*delete_context)(void*),
                         bool trigger_local_events,
@@ -108,6 +116,23 @@ class Repo : public connection::PersistentConnectionEventHandler {
 
   const std::string& url() const { return url_; }
 
+  // The database that events raised by this Repo are delivered through.
+  DatabaseInternal* database() const { return database_; }
+
+  // When the Repo is shared between several databases, hand it over to
+  // another one of them after the current primary database is deleted. The
+  // connection then authenticates using the new database's App.
+  // Must be called on the scheduler thread.
+  void SetPrimaryDatabase(DatabaseInternal* database);
+
+  // When the Repo is shared between several databases, drop everything that
+  // refers to a database that stops using it: the futures of its outstanding
+  // writes and onDisconnect operations are completed with
+  // kErrorWriteCanceled, and its transactions are aborted. Its event
+  // registrations must be removed separately.
+  // Must be called on the scheduler thread.
+  void ReleaseDatabase(DatabaseInternal* database);
+
   static scheduler::Scheduler& scheduler() { return *s_scheduler_; }
 
   ThisRef& this_ref() { return safe_this_; }
@@ -120,6 +145,12 @@ class Repo : public connection::PersistentConnectionEventHandler {
   void AbortTransactionsAtNode(Tree<std::vector<TransactionDataPtr>>* node,
                                Error reason);
 
+  void ReleaseTransactions(Tree<std::vector<TransactionDataPtr>>* node,
+                           DatabaseInternal* database,
+                           std::vector<Event>* events);
+
+  static void HandleWriteResponse(const connection::ResponsePtr& ptr);
+
   // Defers any initialization that is potentially expensive (e.g. disk access)
   // and must be run on the run loop
   void DeferredInitialization();
@@ -158,6 +189,11 @@ class Repo : public connection::PersistentConnectionEventHandler {
 
   void UpdateInfo(const std::string& key, const Variant& value);
 
+  // Arranges for grouped persisted writes to be committed, and the cache to be
+  // pruned, once the group commit window has passed.
+  void SchedulePersistenceFlush();
+  static void OnPersistenceWritesPending(void* repo);
+
   DatabaseInternal* database_;
 
   SparseSnapshotTree on_disconnect_;
@@ -175,6 +211,15 @@ class Repo : public connection::PersistentConnectionEventHandler {
 
   bool persistence_enabled_;
 
+  // Whether every commit to persistence waits for the data to reach the disk.
+  bool persistence_sync_enabled_;
+
+  // Commits persisted writes that are being held back to be grouped with later
+  // writes. Only armed while there is something to commit or prune, and only
+  // used on the scheduler.
+  scheduler::RequestHandle persistence_flush_handle_;
+  bool persistence_flush_scheduled_;
+
   // Firebase websocket connection with wire protocol support
   UniquePtr<connection::PersistentConnection> connection_;
 
@@ -190,6 +235,12 @@ class Repo : public connection::PersistentConnectionEventHandler {
 
   Tree<std::vector<TransactionDataPtr>> transaction_queue_tree_;
 
+  // Writes and onDisconnect operations waiting for the server, so that their
+  // futures can be released if their database stops using this Repo. Only
+  // used on the scheduler.
+  std::map<connection::Response*, connection::ResponsePtr>
+      outstanding_future_responses_;
+
   // Safe reference to this.  Set in constructor and cleared in destructor
   // Should be safe to be copied to any thread.
   ThisRef safe_this_;
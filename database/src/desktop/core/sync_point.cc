@@ -115,7 +115,8 @@ std::vector<Event> SyncPoint::AddEventRegistration(
 }
 
 std::vector<Event> SyncPoint::RemoveEventRegistration(
-    const QuerySpec& query_spec, void* listener_ptr, Error cancel_error,
+    const QuerySpec& query_spec, void* listener_ptr,
+    const DatabaseInternal* database, Error cancel_error,
     std::vector<QuerySpec>* out_removed) {
   std::vector<Event> cancel_events;
 
@@ -123,8 +124,8 @@ std::vector<Event> SyncPoint::RemoveEventRegistration(
   if (QuerySpecIsDefault(query_spec)) {
     for (auto iter = views_.begin(); iter != views_.end();) {
       View& view = iter->second;
-      Extend(&cancel_events,
-             view.RemoveEventRegistration(listener_ptr, cancel_error));
+      Extend(&cancel_events, view.RemoveEventRegistration(
+                                 listener_ptr, database, cancel_error));
       if (view.IsEmpty()) {
         // We'll deal with complete views later.
         if (!QuerySpecLoadsAllData(view.query_spec())) {
@@ -140,7 +141,8 @@ std::vector<Event> SyncPoint::RemoveEventRegistration(
     View* view = MapGet(&views_, query_spec.params);
     if (view) {
       Extend(&cancel_events,
-             view->RemoveEventRegistration(listener_ptr, cancel_error));
+             view->RemoveEventRegistration(listener_ptr, database,
+                                           cancel_error));
       if (view->IsEmpty()) {
         // We'll deal with complete views later.
         if (!QuerySpecLoadsAllData(query_spec)) {
@@ -76,10 +76,12 @@ class SyncPoint {
   // for the specified view(s).
   //
   // If event_registration is null, remove all callbacks.
+  // If database is not null, only callbacks registered through it are removed.
   // cancel_error If a cancel_error is provided, appropriate cancel events will
   // be returned.
   std::vector<Event> RemoveEventRegistration(
-      const QuerySpec& query_spec, void* listener_ptr, Error cancel_error,
+      const QuerySpec& query_spec, void* listener_ptr,
+      const DatabaseInternal* database, Error cancel_error,
       std::vector<QuerySpec>* out_removed);
 
   // Return the list of views that have and incomplete (i.e. filtered) view of
@@ -23,6 +23,7 @@
 #include "app/src/log.h"
 #include "app/src/optional.h"
 #include "app/src/path.h"
+#include "app/src/trace.h"
 #include "app/src/variant_util.h"
 #include "database/src/common/query_spec.h"
 #include "database/src/desktop/core/event_registration.h"
@@ -48,6 +49,7 @@ bool SyncTree::IsEmpty() { return sync_point_tree_.IsEmpty(); }
 std::vector<Event> SyncTree::AckUserWrite(WriteId write_id, AckStatus revert,
                                           Persist persist,
                                           int64_t server_time_offset) {
+  FIREBASE_TRACE_SCOPE("database", "SyncTree::AckUserWrite");
   std::vector<Event> results;
   persistence_manager_->RunInTransaction([&, this]() -> bool {
     if (persist) {
@@ -98,6 +100,7 @@ std::vector<Event> SyncTree::AckUserWrite(WriteId write_id, AckStatus revert,
 
 std::vector<Event> SyncTree::AddEventRegistration(
     UniquePtr<EventRegistration> event_registration) {
+  FIREBASE_TRACE_SCOPE("database", "SyncTree::AddEventRegistration");
   std::vector<Event> events;
 
   persistence_manager_->RunInTransaction([&, this]() -> bool {
@@ -333,6 +336,7 @@ std::vector<Event> SyncTree::ApplyServerMerge(
 //    result.
 std::vector<Event> SyncTree::ApplyOperationToSyncPoints(
     const Operation& operation) {
+  FIREBASE_TRACE_SCOPE("database", "SyncTree::ApplyOperation");
   WriteTreeRef child_writes = pending_write_tree_->ChildWrites(Path());
   return ApplyOperationHelper(operation, &sync_point_tree_, nullptr,
                               &child_writes);
@@ -493,9 +497,15 @@ std::vector<Event> SyncTree::RemoveAllWrites() {
   return results;
 }
 
+void SyncTree::FlushPersistence() { persistence_manager_->Flush(); }
+
+bool SyncTree::PrunePersistence() {
+  return persistence_manager_->PruneCacheStep();
+}
+
 std::vector<Event> SyncTree::RemoveAllEventRegistrations(
     const QuerySpec& query_spec, Error error) {
-  return RemoveEventRegistration(query_spec, nullptr, error);
+  return RemoveEventRegistration(query_spec, nullptr, nullptr, error);
 }
 
 Optional<Variant> SyncTree::CalcCompleteEventCache(
@@ -530,7 +540,7 @@ void SyncTree::SetKeepSynchronized(const QuerySpec& query_spec,
         MakeUnique<KeepSyncedEventRegistration>(this, query_spec));
     keep_synced_queries_.insert(query_spec);
   } else if (!keep_synchronized && contains) {
-    RemoveEventRegistration(query_spec, this, kErrorNone);
+    RemoveEventRegistration(query_spec, this, nullptr, kErrorNone);
     keep_synced_queries_.erase(query_spec);
   }
 }
@@ -600,7 +610,9 @@ static void CollectDistinctViewsForSubTree(Tree<SyncPoint>* subtree,
 }
 
 std::vector<Event> SyncTree::RemoveEventRegistration(
-    const QuerySpec& query_spec, void* listener_ptr, Error cancel_error) {
+    const QuerySpec& query_spec, void* listener_ptr,
+    const DatabaseInternal* database, Error cancel_error) {
+  FIREBASE_TRACE_SCOPE("database", "SyncTree::RemoveEventRegistration");
   std::vector<Event> cancel_events;
   persistence_manager_->RunInTransaction([&]() {
     // Find the sync_point first. Then deal with whether or not it has matching
@@ -616,7 +628,7 @@ std::vector<Event> SyncTree::RemoveEventRegistration(
          maybe_sync_point->ViewExistsForQuery(query_spec))) {
       std::vector<QuerySpec> removed;
       cancel_events = maybe_sync_point->RemoveEventRegistration(
-          query_spec, listener_ptr, cancel_error, &removed);
+          query_spec, listener_ptr, database, cancel_error, &removed);
       if (maybe_sync_point->IsEmpty()) {
         Tree<SyncPoint>* subtree = sync_point_tree_.GetChild(query_spec.path);
         if (subtree) subtree->value().reset();
@@ -129,9 +129,11 @@ class SyncTree {
 
   // Remove the event registration corresponding to the given query_spec and
   // listener pointer, and generate any necessary cancel events that result from
-  // the change to the sync tree.
+  // the change to the sync tree. If database is not null, only a registration
+  // made through that database is removed.
   virtual std::vector<Event> RemoveEventRegistration(
-      const QuerySpec& query_spec, void* listener_ptr, Error cancelError);
+      const QuerySpec& query_spec, void* listener_ptr,
+      const DatabaseInternal* database, Error cancelError);
 
   // Calculate the complete local cache at the given path, ignoring the writes
   // with given WriteIds.
@@ -143,6 +145,14 @@ class SyncTree {
   // evennts.
   virtual void SetKeepSynchronized(const QuerySpec& query_spec, bool keep);
 
+  // Commit any persisted writes that are being held back so that they can be
+  // grouped with later writes.
+  virtual void FlushPersistence();
+
+  // Do a bounded amount of any pending persistence cache pruning. Returns true
+  // if there is more pruning left to do.
+  virtual bool PrunePersistence();
+
  private:
   // For a given new listen, manage the de-duplication of outstanding
   // subscriptions.
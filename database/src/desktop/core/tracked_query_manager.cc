@@ -18,6 +18,8 @@
 #include <cstdint>
 #include <ctime>
 #include <map>
+#include <set>
+#include <vector>
 
 #include "app/src/assert.h"
 #include "app/src/path.h"
@@ -61,12 +63,6 @@ static bool IsQueryPrunablePredicate(const TrackedQuery& query) {
   return !query.active;
 }
 
-// Returns true if the given TrackedQuery is not prunable. A query is considered
-// prunable if it is not active.
-static bool IsQueryUnprunablePredicate(const TrackedQuery& query) {
-  return query.active;
-}
-
 static QuerySpec GetNormalizedQuery(const QuerySpec& query_spec) {
   // If the query loads all data, we don't care about order_by.
   // So just treat it as a default query.
@@ -85,6 +81,8 @@ TrackedQueryManager::TrackedQueryManager(
     : storage_engine_(storage_engine),
       tracked_query_tree_(),
       next_query_id_(0),
+      prune_candidates_(),
+      next_prune_candidate_(0),
       logger_(logger) {
   ResetPreviouslyActiveTrackedQueries();
 
@@ -209,8 +207,7 @@ static uint64_t CalculateCountToPrune(const CachePolicy& cache_policy,
 
 PruneForest TrackedQueryManager::PruneOldQueries(
     const CachePolicy& cache_policy) {
-  std::vector<TrackedQuery> prunable =
-      GetQueriesMatching(IsQueryPrunablePredicate);
+  std::vector<TrackedQuery> prunable = GetPrunableQueriesByLastUse();
   uint64_t count_to_prune =
       CalculateCountToPrune(cache_policy, prunable.size());
 
@@ -218,35 +215,50 @@ PruneForest TrackedQueryManager::PruneOldQueries(
                     static_cast<int>(prunable.size()),
                     static_cast<int>(count_to_prune));
 
-  std::sort(prunable.begin(), prunable.end(),
-            [](const TrackedQuery& q1, const TrackedQuery& q2) {
-              return q1.last_use < q2.last_use;
-            });
+  prunable.resize(count_to_prune);
+  return PruneQueries(prunable);
+}
 
-  // Prune the queries that are no longer needed.
-  PruneForest forest;
-  PruneForestRef forest_ref(&forest);
-  for (uint64_t i = 0; i < count_to_prune; i++) {
-    const TrackedQuery& to_prune = prunable[i];
-    forest_ref.Prune(to_prune.query_spec.path);
-    RemoveTrackedQuery(to_prune.query_spec);
-  }
-  // Keep the rest of the prunable queries.
-  for (uint64_t i = count_to_prune; i < prunable.size(); i++) {
-    const TrackedQuery& to_keep = prunable[i];
-    forest_ref.Keep(to_keep.query_spec.path);
-  }
-  // Also keep the unprunable queries.
-  std::vector<TrackedQuery> unprunable =
-      GetQueriesMatching(IsQueryUnprunablePredicate);
-
-  logger_->LogDebug("Unprunable queries: %i",
-                    static_cast<int>(unprunable.size()));
-  for (const TrackedQuery& to_keep : unprunable) {
-    forest_ref.Keep(to_keep.query_spec.path);
+void TrackedQueryManager::StartPruningLeastRecentlyUsedQueries() {
+  prune_candidates_ = GetPrunableQueriesByLastUse();
+  next_prune_candidate_ = 0;
+}
+
+PruneForest TrackedQueryManager::PruneLeastRecentlyUsedQueries(
+    uint64_t count_to_prune, uint64_t bytes_to_free, uint64_t max_count,
+    uint64_t* bytes_freed) {
+  // Queries at the same location share their cached data, so only count it
+  // once.
+  std::set<Path> counted_paths;
+  std::vector<TrackedQuery> to_prune;
+  uint64_t bytes = 0;
+  while (to_prune.size() < max_count &&
+         (to_prune.size() < count_to_prune || bytes < bytes_to_free) &&
+         next_prune_candidate_ < prune_candidates_.size()) {
+    const TrackedQuery& candidate = prune_candidates_[next_prune_candidate_++];
+    // Skip the queries that were removed or used since the pass started.
+    const TrackedQuery* tracked_query = FindTrackedQuery(candidate.query_spec);
+    if (tracked_query == nullptr ||
+        tracked_query->query_id != candidate.query_id ||
+        tracked_query->active ||
+        tracked_query->last_use != candidate.last_use) {
+      continue;
+    }
+    const Path& path = candidate.query_spec.path;
+    if (counted_paths.insert(path).second) {
+      bytes += storage_engine_->ServerCacheEstimatedSizeInBytes(path);
+    }
+    to_prune.push_back(candidate);
   }
 
-  return forest;
+  logger_->LogDebug(
+      "Pruning least recently used queries. Candidates left: %i Count to "
+      "prune: %i Estimated bytes freed: %i",
+      static_cast<int>(prune_candidates_.size() - next_prune_candidate_),
+      static_cast<int>(to_prune.size()), static_cast<int>(bytes));
+
+  if (bytes_freed) *bytes_freed = bytes;
+  return PruneQueries(to_prune);
 }
 
 std::set<std::string> TrackedQueryManager::GetKnownCompleteChildren(
@@ -305,6 +317,11 @@ uint64_t TrackedQueryManager::CountOfPrunableQueries() {
   return GetQueriesMatching(IsQueryPrunablePredicate).size();
 }
 
+uint64_t TrackedQueryManager::CountOfQueriesToPrune(
+    const CachePolicy& cache_policy) {
+  return CalculateCountToPrune(cache_policy, CountOfPrunableQueries());
+}
+
 void TrackedQueryManager::ResetPreviouslyActiveTrackedQueries() {
   storage_engine_->BeginTransaction();
   storage_engine_->ResetPreviouslyActiveTrackedQueries(0);
@@ -384,6 +401,44 @@ std::vector<TrackedQuery> TrackedQueryManager::GetQueriesMatching(
   return matching;
 }
 
+std::vector<TrackedQuery> TrackedQueryManager::GetPrunableQueriesByLastUse() {
+  std::vector<TrackedQuery> prunable =
+      GetQueriesMatching(IsQueryPrunablePredicate);
+  std::sort(prunable.begin(), prunable.end(),
+            [](const TrackedQuery& q1, const TrackedQuery& q2) {
+              return q1.last_use < q2.last_use;
+            });
+  return prunable;
+}
+
+PruneForest TrackedQueryManager::PruneQueries(
+    const std::vector<TrackedQuery>& to_prune) {
+  // Prune the queries that are no longer needed.
+  PruneForest forest;
+  PruneForestRef forest_ref(&forest);
+  for (const TrackedQuery& query : to_prune) {
+    forest_ref.Prune(query.query_spec.path);
+    RemoveTrackedQuery(query.query_spec);
+  }
+  // Keep the locations of the queries left at, above or below the pruned ones.
+  // Queries anywhere else do not share any cached data with them.
+  for (const TrackedQuery& query : to_prune) {
+    const Path& path = query.query_spec.path;
+    tracked_query_tree_.CallOnEach(
+        path, [&forest_ref](const Path& kept_path, TrackedQueryMap&) {
+          forest_ref.Keep(kept_path);
+        });
+    for (Path ancestor = path; !ancestor.empty();) {
+      ancestor = ancestor.GetParent();
+      if (tracked_query_tree_.GetValueAt(ancestor) != nullptr) {
+        forest_ref.Keep(ancestor);
+      }
+    }
+  }
+
+  return forest;
+}
+
 }  // namespace internal
 }  // namespace database
 }  // namespace firebase
@@ -107,6 +107,21 @@ class TrackedQueryManagerInterface {
   // policy.
   virtual PruneForest PruneOldQueries(const CachePolicy& cache_policy) = 0;
 
+  // Start a pruning pass, taking the prunable queries in order of last use for
+  // the following calls to PruneLeastRecentlyUsedQueries to remove in turn.
+  virtual void StartPruningLeastRecentlyUsedQueries() = 0;
+
+  // Remove the least recently used prunable queries of the current pruning
+  // pass, until at least count_to_prune of them are removed and the data
+  // cached for them is estimated to take at least bytes_to_free bytes, but
+  // never more than max_count queries. Queries removed or used since the pass
+  // started are skipped. The estimated number of bytes freed is written to
+  // bytes_freed.
+  virtual PruneForest PruneLeastRecentlyUsedQueries(uint64_t count_to_prune,
+                                                    uint64_t bytes_to_free,
+                                                    uint64_t max_count,
+                                                    uint64_t* bytes_freed) = 0;
+
   // Return the keys of the completed TrackedQueries at the given location.
   virtual std::set<std::string> GetKnownCompleteChildren(const Path& path) = 0;
 
@@ -120,6 +135,10 @@ class TrackedQueryManagerInterface {
   // Returns the number of TrackedQueries that can be pruned (i.e. are
   // inactive).
   virtual uint64_t CountOfPrunableQueries() = 0;
+
+  // Returns the number of TrackedQueries that the given cache policy would
+  // remove at once.
+  virtual uint64_t CountOfQueriesToPrune(const CachePolicy& cache_policy) = 0;
 };
 
 class TrackedQueryManager : public TrackedQueryManagerInterface {
@@ -159,6 +178,21 @@ class TrackedQueryManager : public TrackedQueryManagerInterface {
   // policy.
   PruneForest PruneOldQueries(const CachePolicy& cache_policy) override;
 
+  // Start a pruning pass, taking the prunable queries in order of last use for
+  // the following calls to PruneLeastRecentlyUsedQueries to remove in turn.
+  void StartPruningLeastRecentlyUsedQueries() override;
+
+  // Remove the least recently used prunable queries of the current pruning
+  // pass, until at least count_to_prune of them are removed and the data
+  // cached for them is estimated to take at least bytes_to_free bytes, but
+  // never more than max_count queries. Queries removed or used since the pass
+  // started are skipped. The estimated number of bytes freed is written to
+  // bytes_freed.
+  PruneForest PruneLeastRecentlyUsedQueries(uint64_t count_to_prune,
+                                            uint64_t bytes_to_free,
+                                            uint64_t max_count,
+                                            uint64_t* bytes_freed) override;
+
   // Return the keys of the completed TrackedQueries at the given location.
   std::set<std::string> GetKnownCompleteChildren(const Path& path) override;
 
@@ -173,6 +207,10 @@ class TrackedQueryManager : public TrackedQueryManagerInterface {
   // inactive).
   uint64_t CountOfPrunableQueries() override;
 
+  // Returns the number of TrackedQueries that the given cache policy would
+  // remove at once.
+  uint64_t CountOfQueriesToPrune(const CachePolicy& cache_policy) override;
+
  private:
   // Resets the timestamp on active tracked queries.
   void ResetPreviouslyActiveTrackedQueries();
@@ -198,6 +236,13 @@ class TrackedQueryManager : public TrackedQueryManagerInterface {
   std::vector<TrackedQuery> GetQueriesMatching(
       TrackedQueryPredicateFn predicate);
 
+  // Return the prunable TrackedQueries, least recently used first.
+  std::vector<TrackedQuery> GetPrunableQueriesByLastUse();
+
+  // Remove the given queries, returning a forest that prunes their locations
+  // and keeps those of every other query.
+  PruneForest PruneQueries(const std::vector<TrackedQuery>& to_prune);
+
   // DB, where we permanently store tracked queries.
   PersistenceStorageEngine* storage_engine_;
 
@@ -207,6 +252,12 @@ class TrackedQueryManager : public TrackedQueryManagerInterface {
   // ID we'll assign to the next tracked query.
   QueryId next_query_id_;
 
+  // The prunable queries as of the start of the current pruning pass, least
+  // recently used first, and the index of the next one to consider. Sorting
+  // them once per pass keeps each step proportional to what it prunes.
+  std::vector<TrackedQuery> prune_candidates_;
+  size_t next_prune_candidate_;
+
   LoggerBase* logger_;
 };
 
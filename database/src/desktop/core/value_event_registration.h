@@ -49,6 +49,8 @@ class ValueEventRegistration : public EventRegistration {
 
   bool MatchesListener(const void* listener_ptr) const override;
 
+  const DatabaseInternal* database() const override { return database_; }
+
  private:
   DatabaseInternal* database_;
   ValueListener* listener_;
@@ -14,9 +14,13 @@
 
 #include "database/src/desktop/database_desktop.h"
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <queue>
 #include <stack>
+#include <string>
+#include <vector>
 
 #include "app/memory/shared_ptr.h"
 #include "app/src/app_common.h"
@@ -25,8 +29,11 @@
 #include "app/src/include/firebase/app.h"
 #include "app/src/include/firebase/future.h"
 #include "app/src/reference_counted_future_impl.h"
+#include "app/src/semaphore.h"
 #include "app/src/variant_util.h"
+#include "database/src/desktop/core/child_event_registration.h"
 #include "database/src/desktop/core/indexed_variant.h"
+#include "database/src/desktop/core/value_event_registration.h"
 #include "database/src/desktop/data_snapshot_desktop.h"
 #include "database/src/desktop/database_reference_desktop.h"
 #include "database/src/desktop/mutable_data_desktop.h"
@@ -43,6 +50,59 @@ namespace internal {
 
 Mutex g_database_reference_constructor_mutex;  // NOLINT
 
+// A Repo shared by every database that connects to the same url as the same
+// user with shared connections enabled.
+struct SharedRepo {
+  SharedRepo() : system_logger(), logger(&system_logger) {}
+
+  // The Repo can outlive the database that created it, so it logs through
+  // loggers of its own. Declared first so that the Repo is destroyed before
+  // them.
+  SystemLogger system_logger;
+  Logger logger;
+
+  SharedPtr<Repo> repo;
+
+  // The databases using the Repo. The first one is the Repo's primary
+  // database, whose App is used to authenticate the connection.
+  std::vector<DatabaseInternal*> databases;
+};
+
+namespace {
+
+Mutex g_shared_repos_mutex;  // NOLINT
+// Several Repos can share a key for a while after the user of one of them
+// changes; any of them can be joined.
+std::multimap<std::string, SharedPtr<SharedRepo>>* g_shared_repos = nullptr;
+
+std::multimap<std::string, SharedPtr<SharedRepo>>::iterator FindSharedRepo(
+    const std::string& key, DatabaseInternal* database) {
+  auto range = g_shared_repos->equal_range(key);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    const std::vector<DatabaseInternal*>& databases = iter->second->databases;
+    if (std::find(databases.begin(), databases.end(), database) !=
+        databases.end()) {
+      return iter;
+    }
+  }
+  return g_shared_repos->end();
+}
+
+// Returns the uid of the signed in user, or an empty string if there is none.
+// Auth does not wait for the persisted user to be loaded, so until then this
+// returns a stand-in that names the App, which no other database shares. The
+// Auth state listener moves the database on once the user is known.
+std::string GetCurrentUserUid(App* app) {
+  std::string uid;
+  bool loading = false;
+  app->function_registry()->CallFunction(
+      ::firebase::internal::FnAuthGetCurrentUserUid, app, &loading, &uid);
+  // Uids never contain a newline.
+  return loading ? std::string("\nloading ") + app->name() : uid;
+}
+
+}  // namespace
+
 SingleValueListener::SingleValueListener(DatabaseInternal* database,
                                          const QuerySpec& query_spec,
                                          ReferenceCountedFutureImpl* future,
@@ -74,8 +134,11 @@ DatabaseInternal::DatabaseInternal(App* app, const char* url)
       cleanup_(),
       database_url_(url),
       constructor_url_(url),
+      persistence_enabled_(false),
+      persistence_sync_enabled_(false),
+      shared_connection_enabled_(false),
       logger_(app_common::FindAppLoggerByName(app->name())),
-      repo_(nullptr) {
+      repo_() {
   assert(app);
   assert(url);
 
@@ -90,6 +153,13 @@ DatabaseInternal::~DatabaseInternal() {
   // If initialization failed, there is nothing to clean up.
   if (app_ == nullptr) return;
 
+  if (shared_connection_enabled_) {
+    app_->function_registry()->CallFunction(
+        ::firebase::internal::FnAuthRemoveAuthStateListener, app_,
+        reinterpret_cast<void*>(OnAuthStateChanged), this);
+  }
+  ReleaseSharedRepo();
+
   app_->function_registry()->CallFunction(
       ::firebase::internal::FnAuthStopTokenListener, app_, nullptr, nullptr);
 }
@@ -187,6 +257,22 @@ void DatabaseInternal::SetPersistenceEnabled(bool enabled) {
   }
 }
 
+void DatabaseInternal::SetPersistenceSyncEnabled(bool enabled) {
+  MutexLock lock(repo_mutex_);
+  // Only change durability if the repo has not yet been initialized.
+  if (!repo_) {
+    persistence_sync_enabled_ = enabled;
+  }
+}
+
+void DatabaseInternal::SetSharedConnectionEnabled(bool enabled) {
+  MutexLock lock(repo_mutex_);
+  // Only change the connection if the repo has not yet been initialized.
+  if (!repo_) {
+    shared_connection_enabled_ = enabled;
+  }
+}
+
 void DatabaseInternal::set_log_level(LogLevel log_level) {
   logger_.SetLogLevel(log_level);
 }
@@ -303,10 +389,228 @@ EventRegistration* DatabaseInternal::ActiveEventRegistration(
 }
 
 void DatabaseInternal::EnsureRepo() {
-  MutexLock lock(repo_mutex_);
-  if (!repo_) {
-    repo_ = MakeUnique<Repo>(app_, this, database_url_.c_str(), &logger_,
-                             persistence_enabled_);
+  {
+    MutexLock lock(repo_mutex_);
+    if (repo_) return;
+
+    if (!shared_connection_enabled_) {
+      repo_ = MakeShared<Repo>(app_, this, database_url_.c_str(), &logger_,
+                               persistence_enabled_, persistence_sync_enabled_);
+      return;
+    }
+    JoinSharedRepo(GetCurrentUserUid(app_));
+  }
+  // Registered once the Repo is in place, as Auth may call back right away.
+  app_->function_registry()->CallFunction(
+      ::firebase::internal::FnAuthAddAuthStateListener, app_,
+      reinterpret_cast<void*>(OnAuthStateChanged), this);
+}
+
+void DatabaseInternal::JoinSharedRepo(const std::string& uid) {
+  // Databases can only share a connection if they would authenticate as the
+  // same user and agree on whether to persist data.
+  std::string key =
+      database_url_ + "|" + uid + "|" +
+      (persistence_enabled_
+           ? (persistence_sync_enabled_ ? "persisted-sync" : "persisted")
+           : "memory");
+
+  MutexLock shared_lock(g_shared_repos_mutex);
+  if (g_shared_repos == nullptr) {
+    g_shared_repos = new std::multimap<std::string, SharedPtr<SharedRepo>>();
+  }
+  SharedPtr<SharedRepo> shared_repo;
+  auto iter = g_shared_repos->find(key);
+  if (iter == g_shared_repos->end()) {
+    shared_repo = MakeShared<SharedRepo>();
+    shared_repo->logger.SetLogLevel(logger_.GetLogLevel());
+    shared_repo->repo =
+        MakeShared<Repo>(app_, this, database_url_.c_str(),
+                         &shared_repo->logger, persistence_enabled_,
+                         persistence_sync_enabled_);
+    g_shared_repos->insert(std::make_pair(key, shared_repo));
+  } else {
+    shared_repo = iter->second;
+    logger_.LogDebug("Sharing the connection to %s", database_url_.c_str());
+  }
+  shared_repo->databases.push_back(this);
+  shared_repo_key_ = key;
+  shared_repo_uid_ = uid;
+  repo_ = shared_repo->repo;
+}
+
+void DatabaseInternal::LeaveSharedRepo(SharedRepoDeparture* departure) {
+  {
+    MutexLock shared_lock(g_shared_repos_mutex);
+    auto iter = FindSharedRepo(shared_repo_key_, this);
+    FIREBASE_ASSERT(iter != g_shared_repos->end());
+    departure->shared_repo = iter->second;
+    std::vector<DatabaseInternal*>& databases = iter->second->databases;
+    databases.erase(std::find(databases.begin(), databases.end(), this));
+    // Nobody can join a Repo that no database uses any more. It is destroyed
+    // along with the last reference to it, outside of any lock.
+    if (databases.empty()) g_shared_repos->erase(iter);
+  }
+  {
+    MutexLock lock(listener_mutex_);
+    for (const auto& query_spec_entry : event_registration_lookup_) {
+      for (const auto& listener_entry : query_spec_entry.second) {
+        departure->registrations.push_back(
+            std::make_pair(query_spec_entry.first, listener_entry.first));
+      }
+    }
+    event_registration_lookup_.clear();
+  }
+  departure->database = this;
+  repo_.reset();
+  shared_repo_key_.clear();
+  shared_repo_uid_.clear();
+}
+
+void DatabaseInternal::FinishLeavingSharedRepo(SharedRepoDeparture* departure) {
+  if (!departure->shared_repo) return;
+
+  // The Repo can outlive the database, so detach everything that refers to
+  // the database before it goes away: its event registrations, and the
+  // futures of its writes and transactions. This runs on the scheduler, which
+  // is the calling thread when a database is deleted from a listener or a
+  // completion callback.
+  auto detach = [](Repo::ThisRef ref, SharedRepoDeparture* departure,
+                   Semaphore* done) {
+    Repo::ThisRefLock lock(&ref);
+    Repo* repo = lock.GetReference();
+    if (repo != nullptr) {
+      for (const auto& registration : departure->registrations) {
+        repo->RemoveEventCallback(departure->database, registration.second,
+                                  registration.first);
+      }
+      repo->ReleaseDatabase(departure->database);
+      // If the database was the primary, hand the Repo over to one that still
+      // uses it. Checked here rather than when leaving, as a detach run
+      // inline can overtake one that is still queued.
+      MutexLock shared_lock(g_shared_repos_mutex);
+      const std::vector<DatabaseInternal*>& databases =
+          departure->shared_repo->databases;
+      if (repo->database() == departure->database && !databases.empty()) {
+        repo->SetPrimaryDatabase(databases.front());
+      }
+    }
+    if (done != nullptr) done->Post();
+  };
+  Repo::ThisRef ref = departure->shared_repo->repo->this_ref();
+  if (Repo::scheduler().IsCurrentThread()) {
+    detach(ref, departure, nullptr);
+  } else {
+    Semaphore done(0);
+    Repo::scheduler().Schedule(NewCallback(detach, ref, departure, &done));
+    done.Wait();
+  }
+  departure->shared_repo.reset();
+}
+
+void DatabaseInternal::ReleaseSharedRepo() {
+  SharedRepoDeparture departure;
+  {
+    MutexLock lock(repo_mutex_);
+    if (shared_repo_key_.empty()) return;
+    LeaveSharedRepo(&departure);
+  }
+  FinishLeavingSharedRepo(&departure);
+}
+
+void DatabaseInternal::OnAuthStateChanged(void* context) {
+  auto* database = static_cast<DatabaseInternal*>(context);
+  std::string uid = GetCurrentUserUid(database->app_);
+  SharedRepoDeparture departure;
+  std::vector<UniquePtr<EventRegistration>> registrations;
+  SharedPtr<Repo> repo;
+  {
+    MutexLock lock(database->repo_mutex_);
+    if (database->shared_repo_key_.empty() ||
+        uid == database->shared_repo_uid_) {
+      return;
+    }
+    {
+      MutexLock shared_lock(g_shared_repos_mutex);
+      auto iter = FindSharedRepo(database->shared_repo_key_, database);
+      FIREBASE_ASSERT(iter != g_shared_repos->end());
+      SharedPtr<SharedRepo> shared_repo = iter->second;
+      if (shared_repo->databases.size() == 1) {
+        // Nobody else uses the Repo, and its connection authenticates through
+        // this database's App, so it now belongs to the new user.
+        g_shared_repos->erase(iter);
+        std::string key = database->shared_repo_key_;
+        key.replace(database->database_url_.size() + 1,
+                    database->shared_repo_uid_.size(), uid);
+        g_shared_repos->insert(std::make_pair(key, shared_repo));
+        database->shared_repo_key_ = key;
+        database->shared_repo_uid_ = uid;
+        return;
+      }
+    }
+
+    // The other databases stay with the old user. Move this database's
+    // listeners over to a Repo of the new user's; its writes and transactions
+    // in flight are cancelled.
+    database->logger_.LogDebug(
+        "The user changed, no longer sharing the connection to %s",
+        database->database_url_.c_str());
+    std::vector<std::pair<QuerySpec, ValueListener*>> value_listeners;
+    std::vector<std::pair<QuerySpec, ChildListener*>> child_listeners;
+    {
+      MutexLock listener_lock(database->listener_mutex_);
+      for (const auto& query_spec_entry :
+           database->event_registration_lookup_) {
+        const QuerySpec& query_spec = query_spec_entry.first;
+        std::vector<ValueListener*> values;
+        std::vector<ChildListener*> children;
+        database->value_listeners_by_query_.Get(query_spec, &values);
+        database->child_listeners_by_query_.Get(query_spec, &children);
+        for (const auto& listener_entry : query_spec_entry.second) {
+          void* listener_ptr = listener_entry.first;
+          for (ValueListener* listener : values) {
+            if (listener == listener_ptr) {
+              value_listeners.push_back(std::make_pair(query_spec, listener));
+            }
+          }
+          for (ChildListener* listener : children) {
+            if (listener == listener_ptr) {
+              child_listeners.push_back(std::make_pair(query_spec, listener));
+            }
+          }
+        }
+      }
+    }
+    database->LeaveSharedRepo(&departure);
+    database->JoinSharedRepo(uid);
+
+    for (const auto& entry : value_listeners) {
+      registrations.push_back(MakeUnique<ValueEventRegistration>(
+          database, entry.second, entry.first));
+      database->AddEventRegistration(entry.first, entry.second,
+                                     registrations.back().get());
+    }
+    for (const auto& entry : child_listeners) {
+      registrations.push_back(MakeUnique<ChildEventRegistration>(
+          database, entry.second, entry.first));
+      database->AddEventRegistration(entry.first, entry.second,
+                                     registrations.back().get());
+    }
+    repo = database->repo_;
+  }
+
+  // Without any lock held, as this waits for the scheduler unless it runs on
+  // it.
+  FinishLeavingSharedRepo(&departure);
+  for (UniquePtr<EventRegistration>& registration : registrations) {
+    Repo::scheduler().Schedule(NewCallback(
+        [](Repo::ThisRef ref, UniquePtr<EventRegistration> registration) {
+          Repo::ThisRefLock lock(&ref);
+          if (lock.GetReference() != nullptr) {
+            lock.GetReference()->AddEventCallback(Move(registration));
+          }
+        },
+        repo->this_ref(), Move(registration)));
   }
 }
 
@@ -18,7 +18,10 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "app/memory/shared_ptr.h"
 #include "app/memory/unique_ptr.h"
 #include "app/src/cleanup_notifier.h"
 #include "app/src/future_manager.h"
@@ -48,6 +51,20 @@ extern Mutex g_database_reference_constructor_mutex;
 
 typedef int64_t WriteId;
 
+struct SharedRepo;
+
+// What a database that stops using a shared Repo leaves behind, to be cleaned
+// up once no lock is held.
+struct SharedRepoDeparture {
+  SharedRepoDeparture() : shared_repo(), database(nullptr) {}
+
+  // Keeps the Repo alive until the database is detached from it.
+  SharedPtr<SharedRepo> shared_repo;
+  DatabaseInternal* database;
+  // The event registrations the database made on the Repo.
+  std::vector<std::pair<QuerySpec, void*>> registrations;
+};
+
 class SingleValueListener : public ValueListener {
  public:
   SingleValueListener(DatabaseInternal* database, const QuerySpec& query_spec,
@@ -93,6 +110,14 @@ class DatabaseInternal {
 
   void SetPersistenceEnabled(bool enabled);
 
+  // Make every commit to the persistence cache wait for the data to reach the
+  // disk.
+  void SetPersistenceSyncEnabled(bool enabled);
+
+  // Allow this database to share its Repo, and therefore its connection and
+  // local cache, with other databases using the same url and user.
+  void SetSharedConnectionEnabled(bool enabled);
+
   // Set the logging verbosity.
   void set_log_level(LogLevel log_level);
 
@@ -148,6 +173,26 @@ class DatabaseInternal {
  private:
   void EnsureRepo();
 
+  // Start using the shared Repo for this database's url and the given user,
+  // creating it if there is none. repo_mutex_ must be held.
+  void JoinSharedRepo(const std::string& uid);
+
+  // Stop using a Repo that is shared with other databases, recording what is
+  // left to do in departure. repo_mutex_ must be held.
+  void LeaveSharedRepo(SharedRepoDeparture* departure);
+
+  // Detach the departed database from the Repo, destroying the Repo if nobody
+  // else uses it. No lock may be held, as this waits for the scheduler unless
+  // called on it.
+  static void FinishLeavingSharedRepo(SharedRepoDeparture* departure);
+
+  void ReleaseSharedRepo();
+
+  // Called by Auth when the signed in user changes. A database that shares
+  // its Repo moves to a Repo of the new user's, so that it never reads or
+  // writes as another user.
+  static void OnAuthStateChanged(void* database);
+
   App* app_;
 
   ListenerCollection<ValueListener> value_listeners_by_query_;
@@ -178,12 +223,25 @@ class DatabaseInternal {
 
   bool persistence_enabled_;
 
+  bool persistence_sync_enabled_;
+
+  bool shared_connection_enabled_;
+
+  // The key of the shared Repo used by this database, or "" if this database
+  // owns its Repo.
+  std::string shared_repo_key_;
+
+  // The user the shared Repo was joined as.
+  std::string shared_repo_uid_;
+
   // The logger for this instance of the database.
   Logger logger_;
 
   Mutex repo_mutex_;
   // The local copy of the repository, for offline support and local caching.
-  UniquePtr<Repo> repo_;
+  // This may be shared with other databases if shared connections are
+  // enabled.
+  SharedPtr<Repo> repo_;
 };
 
 }  // namespace internal
@@ -124,11 +124,11 @@ Future<void> DatabaseReferenceInternal::RemoveValue() {
       ref_future()->SafeAlloc<void>(kDatabaseReferenceFnRemoveValue);
 
   Repo::scheduler().Schedule(NewCallback(
-      [](Repo* repo, Path path, ReferenceCountedFutureImpl* api,
-         SafeFutureHandle<void> handle) {
-        repo->SetValue(path, Variant::Null(), api, handle);
+      [](Repo* repo, DatabaseInternal* database, Path path,
+         ReferenceCountedFutureImpl* api, SafeFutureHandle<void> handle) {
+        repo->SetValue(database, path, Variant::Null(), api, handle);
       },
-      database_->repo(), query_spec_.path, ref_future(), handle));
+      database_->repo(), database_, query_spec_.path, ref_future(), handle));
   return MakeFuture(ref_future(), handle);
 }
 
@@ -144,16 +144,17 @@ Future<DataSnapshot> DatabaseReferenceInternal::RunTransaction(
       kDatabaseReferenceFnRunTransaction, DataSnapshot(nullptr));
 
   Repo::scheduler().Schedule(NewCallback(
-      [](Repo* repo, Path path, DoTransactionWithContext transaction_function,
-         void* context, void (*delete_context)(void*),
-         bool trigger_local_events, ReferenceCountedFutureImpl* api,
+      [](Repo* repo, DatabaseInternal* database, Path path,
+         DoTransactionWithContext transaction_function, void* context,
+         void (*delete_context)(void*), bool trigger_local_events,
+         ReferenceCountedFutureImpl* api,
          SafeFutureHandle<DataSnapshot> handle) {
-        repo->StartTransaction(path, transaction_function, context,
+        repo->StartTransaction(database, path, transaction_function, context,
                                delete_context, trigger_local_events, api,
                                handle);
       },
-      database_->repo(), query_spec_.path, transaction_function, context,
-      delete_context, trigger_local_events, ref_future(), handle));
+      database_->repo(), database_, query_spec_.path, transaction_function,
+      context, delete_context, trigger_local_events, ref_future(), handle));
 
   return MakeFuture(ref_future(), handle);
 }
@@ -174,13 +175,13 @@ Future<void> DatabaseReferenceInternal::SetPriority(const Variant& priority) {
                            kErrorMsgInvalidVariantForPriority);
   } else {
     Repo::scheduler().Schedule(NewCallback(
-        [](Repo* repo, Path path, Variant priority,
+        [](Repo* repo, DatabaseInternal* database, Path path, Variant priority,
            ReferenceCountedFutureImpl* api, SafeFutureHandle<void> handle) {
           ConvertVectorToMap(&priority);
-          repo->SetValue(path, priority, api, handle);
+          repo->SetValue(database, path, priority, api, handle);
         },
-        database_->repo(), query_spec_.path.GetChild(kPriorityKey), priority,
-        ref_future(), handle));
+        database_->repo(), database_, query_spec_.path.GetChild(kPriorityKey),
+        priority, ref_future(), handle));
   }
   return MakeFuture(ref_future(), handle);
 }
@@ -198,12 +199,13 @@ Future<void> DatabaseReferenceInternal::SetValue(const Variant& value) {
                            kErrorMsgConflictSetValue);
   } else {
     Repo::scheduler().Schedule(NewCallback(
-        [](Repo* repo, Path path, Variant value,
+        [](Repo* repo, DatabaseInternal* database, Path path, Variant value,
            ReferenceCountedFutureImpl* api, SafeFutureHandle<void> handle) {
           ConvertVectorToMap(&value);
-          repo->SetValue(path, value, api, handle);
+          repo->SetValue(database, path, value, api, handle);
         },
-        database_->repo(), query_spec_.path, value, ref_future(), handle));
+        database_->repo(), database_, query_spec_.path, value, ref_future(),
+        handle));
   }
   return MakeFuture(ref_future(), handle);
 }
@@ -245,13 +247,14 @@ Future<void> DatabaseReferenceInternal::SetValueAndPriority(
           std::make_pair(kVirtualChildKeyPriority, priority)};
     }
     Repo::scheduler().Schedule(NewCallback(
-        [](Repo* repo, Path path, Variant value_priority,
-           ReferenceCountedFutureImpl* api, SafeFutureHandle<void> handle) {
+        [](Repo* repo, DatabaseInternal* database, Path path,
+           Variant value_priority, ReferenceCountedFutureImpl* api,
+           SafeFutureHandle<void> handle) {
           ConvertVectorToMap(&value_priority);
-          repo->SetValue(path, value_priority, api, handle);
+          repo->SetValue(database, path, value_priority, api, handle);
         },
-        database_->repo(), query_spec_.path, value_priority, ref_future(),
-        handle));
+        database_->repo(), database_, query_spec_.path, value_priority,
+        ref_future(), handle));
   }
   return MakeFuture(ref_future(), handle);
 }
@@ -269,12 +272,13 @@ Future<void> DatabaseReferenceInternal::UpdateChildren(const Variant& values) {
                            kErrorMsgInvalidVariantForUpdateChildren);
   } else {
     Repo::scheduler().Schedule(NewCallback(
-        [](Repo* repo, Path path, Variant values,
+        [](Repo* repo, DatabaseInternal* database, Path path, Variant values,
            ReferenceCountedFutureImpl* api, SafeFutureHandle<void> handle) {
           ConvertVectorToMap(&values);
-          repo->UpdateChildren(path, values, api, handle);
+          repo->UpdateChildren(database, path, values, api, handle);
         },
-        database_->repo(), query_spec_.path, values, ref_future(), handle));
+        database_->repo(), database_, query_spec_.path, values, ref_future(),
+        handle));
   }
   return MakeFuture(ref_future(), handle);
 }
@@ -51,7 +51,7 @@ DisconnectionHandlerInternal::~DisconnectionHandlerInternal() {
 Future<void> DisconnectionHandlerInternal::Cancel() {
   SafeFutureHandle<void> handle =
       future()->SafeAlloc<void>(kDisconnectionHandlerFnCancel);
-  database_->repo()->OnDisconnectCancel(handle, future(), path_);
+  database_->repo()->OnDisconnectCancel(database_, handle, future(), path_);
   return MakeFuture(future(), handle);
 }
 
@@ -63,7 +63,7 @@ Future<void> DisconnectionHandlerInternal::CancelLastResult() {
 Future<void> DisconnectionHandlerInternal::RemoveValue() {
   SafeFutureHandle<void> handle =
       future()->SafeAlloc<void>(kDisconnectionHandlerFnRemoveValue);
-  database_->repo()->OnDisconnectSetValue(handle, future(), path_,
+  database_->repo()->OnDisconnectSetValue(database_, handle, future(), path_,
                                           Variant::Null());
   return MakeFuture(future(), handle);
 }
@@ -80,7 +80,8 @@ Future<void> DisconnectionHandlerInternal::SetValue(Variant value) {
     future()->Complete(handle, kErrorConflictingOperationInProgress,
                        kErrorMsgConflictSetValue);
   } else {
-    database_->repo()->OnDisconnectSetValue(handle, future(), path_, value);
+    database_->repo()->OnDisconnectSetValue(database_, handle, future(), path_,
+                                            value);
   }
   return MakeFuture(future(), handle);
 }
@@ -105,7 +106,8 @@ Future<void> DisconnectionHandlerInternal::SetValueAndPriority(
     Variant data = Variant::EmptyMap();
     data.map()[kVirtualChildKeyValue] = value;
     data.map()[kVirtualChildKeyPriority] = priority;
-    database_->repo()->OnDisconnectSetValue(handle, future(), path_, data);
+    database_->repo()->OnDisconnectSetValue(database_, handle, future(), path_,
+                                            data);
   }
   return MakeFuture(future(), handle);
 }
@@ -122,7 +124,8 @@ Future<void> DisconnectionHandlerInternal::UpdateChildren(Variant values) {
     future()->Complete(handle, kErrorInvalidVariantType,
                        kErrorMsgInvalidVariantForUpdateChildren);
   } else {
-    database_->repo()->OnDisconnectUpdate(handle, future(), path_, values);
+    database_->repo()->OnDisconnectUpdate(database_, handle, future(), path_,
+                                          values);
   }
   return MakeFuture(future(), handle);
 }
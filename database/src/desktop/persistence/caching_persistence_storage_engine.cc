@@ -0,0 +1,266 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "database/src/desktop/persistence/caching_persistence_storage_engine.h"
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/variant.h"
+#include "app/src/path.h"
+#include "database/src/desktop/persistence/persistence_storage_engine.h"
+#include "database/src/desktop/util_desktop.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+
+static const char kCacheKeySeparator = '/';
+
+// Rough per-node overhead of a std::map node, on top of its key and value.
+static const size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+// Estimate how much memory a Variant tree occupies. This only needs to be
+// good enough to keep the cache roughly within its budget.
+static size_t EstimateVariantSize(const Variant& variant) {
+  size_t size = sizeof(Variant);
+  if (variant.is_mutable_string()) {
+    size += variant.mutable_string().capacity();
+  } else if (variant.is_map()) {
+    for (const auto& key_value : variant.map()) {
+      size += kMapNodeOverhead;
+      size += EstimateVariantSize(key_value.first);
+      size += EstimateVariantSize(key_value.second);
+    }
+  } else if (variant.is_vector()) {
+    for (const Variant& item : variant.vector()) {
+      size += EstimateVariantSize(item);
+    }
+  }
+  return size;
+}
+
+CachingPersistenceStorageEngine::CachingPersistenceStorageEngine(
+    UniquePtr<PersistenceStorageEngine> engine, size_t max_cached_bytes,
+    LoggerBase* logger)
+    : engine_(std::move(engine)),
+      max_cached_bytes_(max_cached_bytes),
+      cache_(),
+      lru_list_(),
+      cached_bytes_(0),
+      hit_count_(0),
+      miss_count_(0),
+      logger_(logger) {}
+
+CachingPersistenceStorageEngine::~CachingPersistenceStorageEngine() {
+  logger_->LogDebug("Server cache memory tier: %i hits, %i misses",
+                    static_cast<int>(hit_count_),
+                    static_cast<int>(miss_count_));
+}
+
+void CachingPersistenceStorageEngine::SaveUserOverwrite(const Path& path,
+                                                        const Variant& data,
+                                                        WriteId write_id) {
+  engine_->SaveUserOverwrite(path, data, write_id);
+}
+
+void CachingPersistenceStorageEngine::SaveUserMerge(
+    const Path& path, const CompoundWrite& children, WriteId write_id) {
+  engine_->SaveUserMerge(path, children, write_id);
+}
+
+void CachingPersistenceStorageEngine::RemoveUserWrite(WriteId write_id) {
+  engine_->RemoveUserWrite(write_id);
+}
+
+std::vector<UserWriteRecord> CachingPersistenceStorageEngine::LoadUserWrites() {
+  return engine_->LoadUserWrites();
+}
+
+void CachingPersistenceStorageEngine::RemoveAllUserWrites() {
+  engine_->RemoveAllUserWrites();
+}
+
+Variant CachingPersistenceStorageEngine::ServerCache(const Path& path) {
+  // Look for this path, and then each of its ancestors, in the cache.
+  Path cached_path = path;
+  while (true) {
+    auto iter = cache_.find(CacheKey(cached_path));
+    if (iter != cache_.end()) {
+      hit_count_++;
+      CacheEntry& entry = iter->second;
+      lru_list_.splice(lru_list_.begin(), lru_list_, entry.lru_position);
+      Optional<Path> relative_path = Path::GetRelative(cached_path, path);
+      return VariantGetChild(&entry.data, *relative_path);
+    }
+    if (cached_path.empty()) break;
+    cached_path = cached_path.GetParent();
+  }
+
+  miss_count_++;
+  Variant result = engine_->ServerCache(path);
+  size_t size = EstimateVariantSize(result);
+  if (size <= max_cached_bytes_) {
+    // Anything cached below this path is now redundant.
+    Invalidate(path);
+    std::string key = CacheKey(path);
+    lru_list_.push_front(key);
+    CacheEntry& entry = cache_[key];
+    entry.data = result;
+    entry.size = size;
+    entry.lru_position = lru_list_.begin();
+    cached_bytes_ += size;
+    EvictIfNeeded();
+  }
+  return result;
+}
+
+void CachingPersistenceStorageEngine::OverwriteServerCache(
+    const Path& path, const Variant& data) {
+  Invalidate(path);
+  engine_->OverwriteServerCache(path, data);
+}
+
+void CachingPersistenceStorageEngine::MergeIntoServerCache(
+    const Path& path, const Variant& data) {
+  Invalidate(path);
+  engine_->MergeIntoServerCache(path, data);
+}
+
+void CachingPersistenceStorageEngine::MergeIntoServerCache(
+    const Path& path, const CompoundWrite& children) {
+  Invalidate(path);
+  engine_->MergeIntoServerCache(path, children);
+}
+
+uint64_t CachingPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes()
+    const {
+  return engine_->ServerCacheEstimatedSizeInBytes();
+}
+
+uint64_t CachingPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes(
+    const Path& path) const {
+  return engine_->ServerCacheEstimatedSizeInBytes(path);
+}
+
+void CachingPersistenceStorageEngine::SaveTrackedQuery(
+    const TrackedQuery& tracked_query) {
+  engine_->SaveTrackedQuery(tracked_query);
+}
+
+void CachingPersistenceStorageEngine::DeleteTrackedQuery(QueryId query_id) {
+  engine_->DeleteTrackedQuery(query_id);
+}
+
+std::vector<TrackedQuery>
+CachingPersistenceStorageEngine::LoadTrackedQueries() {
+  return engine_->LoadTrackedQueries();
+}
+
+void CachingPersistenceStorageEngine::ResetPreviouslyActiveTrackedQueries(
+    uint64_t last_use) {
+  engine_->ResetPreviouslyActiveTrackedQueries(last_use);
+}
+
+void CachingPersistenceStorageEngine::SaveTrackedQueryKeys(
+    QueryId query_id, const std::set<std::string>& keys) {
+  engine_->SaveTrackedQueryKeys(query_id, keys);
+}
+
+void CachingPersistenceStorageEngine::UpdateTrackedQueryKeys(
+    QueryId query_id, const std::set<std::string>& added,
+    const std::set<std::string>& removed) {
+  engine_->UpdateTrackedQueryKeys(query_id, added, removed);
+}
+
+std::set<std::string> CachingPersistenceStorageEngine::LoadTrackedQueryKeys(
+    QueryId query_id) {
+  return engine_->LoadTrackedQueryKeys(query_id);
+}
+
+std::set<std::string> CachingPersistenceStorageEngine::LoadTrackedQueryKeys(
+    const std::set<QueryId>& query_ids) {
+  return engine_->LoadTrackedQueryKeys(query_ids);
+}
+
+void CachingPersistenceStorageEngine::PruneCache(
+    const Path& root, const PruneForestRef& prune_forest) {
+  if (prune_forest.PrunesAnything()) {
+    Invalidate(root);
+  }
+  engine_->PruneCache(root, prune_forest);
+}
+
+bool CachingPersistenceStorageEngine::BeginTransaction() {
+  return engine_->BeginTransaction();
+}
+
+void CachingPersistenceStorageEngine::EndTransaction() {
+  engine_->EndTransaction();
+}
+
+void CachingPersistenceStorageEngine::SetTransactionSuccessful() {
+  engine_->SetTransactionSuccessful();
+}
+
+void CachingPersistenceStorageEngine::Flush() { engine_->Flush(); }
+
+std::string CachingPersistenceStorageEngine::CacheKey(const Path& path) {
+  if (path.empty()) return std::string();
+  return path.str() + kCacheKeySeparator;
+}
+
+void CachingPersistenceStorageEngine::Invalidate(const Path& path) {
+  if (cache_.empty()) return;
+
+  // Drop the entry at this path and everything cached below it. Because every
+  // key ends in a separator, those are exactly the keys with this prefix.
+  std::string key = CacheKey(path);
+  auto iter = cache_.lower_bound(key);
+  while (iter != cache_.end() && StringStartsWith(iter->first, key)) {
+    auto next = iter;
+    ++next;
+    Erase(iter);
+    iter = next;
+  }
+
+  // Drop the entries for every ancestor, which contain this path.
+  Path ancestor = path;
+  while (!ancestor.empty()) {
+    ancestor = ancestor.GetParent();
+    auto ancestor_iter = cache_.find(CacheKey(ancestor));
+    if (ancestor_iter != cache_.end()) {
+      Erase(ancestor_iter);
+    }
+  }
+}
+
+void CachingPersistenceStorageEngine::Erase(CacheMap::iterator iter) {
+  cached_bytes_ -= iter->second.size;
+  lru_list_.erase(iter->second.lru_position);
+  cache_.erase(iter);
+}
+
+void CachingPersistenceStorageEngine::EvictIfNeeded() {
+  while (cached_bytes_ > max_cached_bytes_ && !lru_list_.empty()) {
+    Erase(cache_.find(lru_list_.back()));
+  }
+}
+
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
@@ -0,0 +1,146 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FIREBASE_DATABASE_SRC_DESKTOP_PERSISTENCE_CACHING_PERSISTENCE_STORAGE_ENGINE_H_
+#define FIREBASE_DATABASE_SRC_DESKTOP_PERSISTENCE_CACHING_PERSISTENCE_STORAGE_ENGINE_H_
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "app/memory/unique_ptr.h"
+#include "app/src/include/firebase/variant.h"
+#include "app/src/logger.h"
+#include "app/src/path.h"
+#include "database/src/desktop/core/compound_write.h"
+#include "database/src/desktop/core/tracked_query_manager.h"
+#include "database/src/desktop/persistence/persistence_storage_engine.h"
+#include "database/src/desktop/persistence/prune_forest.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+
+// A PersistenceStorageEngine that keeps recently loaded server cache subtrees
+// in memory in front of another storage engine, so that repeatedly attaching
+// views to the same location does not have to rebuild the data from disk each
+// time.
+//
+// All calls are forwarded to the wrapped engine. Cached subtrees are evicted
+// in least-recently-used order once their estimated size exceeds the given
+// budget, and any cached subtree that overlaps a location that is written or
+// pruned is dropped, so the cache never returns data that differs from what
+// the wrapped engine would return.
+class CachingPersistenceStorageEngine : public PersistenceStorageEngine {
+ public:
+  CachingPersistenceStorageEngine(UniquePtr<PersistenceStorageEngine> engine,
+                                  size_t max_cached_bytes, LoggerBase* logger);
+
+  ~CachingPersistenceStorageEngine() override;
+
+  void SaveUserOverwrite(const Path& path, const Variant& data,
+                         WriteId write_id) override;
+  void SaveUserMerge(const Path& path, const CompoundWrite& children,
+                     WriteId write_id) override;
+  void RemoveUserWrite(WriteId write_id) override;
+  std::vector<UserWriteRecord> LoadUserWrites() override;
+  void RemoveAllUserWrites() override;
+
+  // Returns the cached data at the given path if this path or one of its
+  // ancestors has been loaded recently, otherwise loads it from the wrapped
+  // engine and caches it.
+  Variant ServerCache(const Path& path) override;
+
+  void OverwriteServerCache(const Path& path, const Variant& data) override;
+  void MergeIntoServerCache(const Path& path, const Variant& data) override;
+  void MergeIntoServerCache(const Path& path,
+                            const CompoundWrite& children) override;
+  uint64_t ServerCacheEstimatedSizeInBytes() const override;
+  uint64_t ServerCacheEstimatedSizeInBytes(const Path& path) const override;
+  void SaveTrackedQuery(const TrackedQuery& tracked_query) override;
+  void DeleteTrackedQuery(QueryId query_id) override;
+  std::vector<TrackedQuery> LoadTrackedQueries() override;
+  void ResetPreviouslyActiveTrackedQueries(uint64_t last_use) override;
+  void SaveTrackedQueryKeys(QueryId query_id,
+                            const std::set<std::string>& keys) override;
+  void UpdateTrackedQueryKeys(QueryId query_id,
+                              const std::set<std::string>& added,
+                              const std::set<std::string>& removed) override;
+  std::set<std::string> LoadTrackedQueryKeys(QueryId query_id) override;
+  std::set<std::string> LoadTrackedQueryKeys(
+      const std::set<QueryId>& query_ids) override;
+  void PruneCache(const Path& root,
+                  const PruneForestRef& prune_forest) override;
+  bool BeginTransaction() override;
+  void EndTransaction() override;
+  void SetTransactionSuccessful() override;
+  void Flush() override;
+
+  // The number of ServerCache calls that were answered from memory.
+  uint64_t hit_count() const { return hit_count_; }
+
+  // The number of ServerCache calls that had to load from the wrapped engine.
+  uint64_t miss_count() const { return miss_count_; }
+
+  // The estimated number of bytes held by the in-memory cache.
+  size_t cached_bytes() const { return cached_bytes_; }
+
+ private:
+  struct CacheEntry {
+    Variant data;
+    size_t size;
+    // Position of this entry's key in lru_list_.
+    std::list<std::string>::iterator lru_position;
+  };
+
+  typedef std::map<std::string, CacheEntry> CacheMap;
+
+  // Returns the key under which the data at the given path is cached. Keys
+  // end in a separator so that all descendants of a path share its key as a
+  // prefix.
+  static std::string CacheKey(const Path& path);
+
+  // Drop every cached subtree that contains or is contained by the given path.
+  void Invalidate(const Path& path);
+
+  void Erase(CacheMap::iterator iter);
+
+  // Evict least recently used entries until the cache fits in its budget.
+  void EvictIfNeeded();
+
+  UniquePtr<PersistenceStorageEngine> engine_;
+
+  size_t max_cached_bytes_;
+
+  CacheMap cache_;
+
+  // Cache keys ordered from most to least recently used.
+  std::list<std::string> lru_list_;
+
+  size_t cached_bytes_;
+
+  uint64_t hit_count_;
+
+  uint64_t miss_count_;
+
+  LoggerBase* logger_;
+};
+
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
+
+#endif  // FIREBASE_DATABASE_SRC_DESKTOP_PERSISTENCE_CACHING_PERSISTENCE_STORAGE_ENGINE_H_
@@ -14,6 +14,8 @@
 
 #include "database/src/desktop/persistence/flatbuffer_conversions.h"
 
+#include <string.h>
+
 #include "app/src/include/firebase/variant.h"
 #include "app/src/variant_util.h"
 #include "database/src/common/query_spec.h"
@@ -76,8 +78,12 @@ Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
       return Variant(ref.AsDouble());
     case flexbuffers::FBT_STRING:
       return Variant::MutableStringFromStaticString(ref.AsString().c_str());
-    case flexbuffers::FBT_KEY:
-      return Variant::MutableStringFromStaticString(ref.AsKey());
+    case flexbuffers::FBT_KEY: {
+      // Keys repeat across many sibling nodes and cached snapshots, so share a
+      // single copy of each.
+      const char* key = ref.AsKey();
+      return Variant::FromInternedString(key, strlen(key));
+    }
     case flexbuffers::FBT_MAP:
       return FlexbufferMapToVariant(ref.AsMap());
     case flexbuffers::FBT_VECTOR_BOOL:
@@ -156,6 +156,11 @@ uint64_t InMemoryPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes()
   return EstimateVariantMemoryUsage(server_cache_);
 }
 
+uint64_t InMemoryPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes(
+    const Path& path) const {
+  return EstimateVariantMemoryUsage(VariantGetChild(&server_cache_, path));
+}
+
 void InMemoryPersistenceStorageEngine::SaveTrackedQuery(
     const TrackedQuery& tracked_query) {
   // No persistence, so nothing to save.
@@ -106,6 +106,12 @@ class InMemoryPersistenceStorageEngine : public PersistenceStorageEngine {
   // @return The estimated server cache size.
   uint64_t ServerCacheEstimatedSizeInBytes() const override;
 
+  // Estimate the size of the Server Cache at and below the given path.
+  //
+  // @param path The location to estimate the size of.
+  // @return The estimated size of the server cache at the given path.
+  uint64_t ServerCacheEstimatedSizeInBytes(const Path& path) const override;
+
   // Write the tracked query to the cache.
   //
   // @param tracked_query the tracked query to persist.
@@ -171,6 +177,9 @@ class InMemoryPersistenceStorageEngine : public PersistenceStorageEngine {
   // Declare that a transaction completed successfully.
   void SetTransactionSuccessful() override;
 
+  // Nothing is ever held back, so there is nothing to flush.
+  void Flush() override {}
+
  protected:
   void VerifyInTransaction();
 
@@ -14,7 +14,11 @@
 
 #include "database/src/desktop/persistence/level_db_persistence_storage_engine.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -23,6 +27,7 @@
 #include "app/src/include/firebase/variant.h"
 #include "app/src/log.h"
 #include "app/src/path.h"
+#include "app/src/time.h"
 #include "app/src/variant_util.h"
 #include "database/src/common/query_spec.h"
 #include "database/src/desktop/core/compound_write.h"
@@ -60,23 +65,31 @@ using leveldb::WriteOptions;
 static const char kDbKeyUserWriteRecords[] = "$user_write_records/";
 static const char kDbKeyTrackedQueries[] = "$tracked_queries/";
 static const char kDbKeyTrackedQueryKeys[] = "$tracked_query_keys/";
+static const char kDbKeySchemaVersion[] = "$schema_version";
 
 static const char kSeparator = '/';
 
+// The layout of the records kept under the special database paths:
+//
+// 1: Record IDs are written in decimal, and each tracked query key is stored
+//    in its own entry. Databases written with this layout have no
+//    kDbKeySchemaVersion entry.
+// 2: Record IDs are written as fixed width big-endian integers so that records
+//    are iterated in ID order, and the keys of a tracked query are packed into
+//    a single entry. Keys added or removed since the entry was last written
+//    are recorded one per entry below it, e.g. "$tracked_query_keys/<id>/key",
+//    with a kTrackedQueryKeyAdded or kTrackedQueryKeyRemoved value.
+static const char kSchemaVersion = 2;
+
+static const char kTrackedQueryKeyAdded = '+';
+static const char kTrackedQueryKeyRemoved = '-';
+
 static const Slice kValueSlice(".value/");
 
 namespace firebase {
 namespace database {
 namespace internal {
 
-// A utility function to get the pointer one character past the end of a string.
-// This is used for finding the sentinal to pass to functions that take pairs of
-// iterators (specifically, vector::insert).
-template <size_t n>
-const char* StringEnd(const char (&str)[n]) {
-  return str + strlen(str);
-}
-
 // A utility class to make iterating over paths easier.
 // The way iterators are used in LevelDB is somewhat verbose and unidiomatic.
 // This helper class wraps the creation, destruction and iteration of LevelDB
@@ -182,10 +195,109 @@ static bool SliceEndsWith(const Slice& slice, const Slice& end) {
          Slice(slice.data() + slice.size() - end.size(), end.size()) == end;
 }
 
+// Append the ID as a fixed width big-endian integer. Unlike decimal, this
+// sorts in numeric order, and one ID can never be a prefix of another.
+static void AppendId(uint64_t id, std::string* out) {
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<char>((id >> shift) & 0xff));
+  }
+}
+
+static std::string IdKey(const char* prefix, uint64_t id) {
+  std::string key(prefix);
+  AppendId(id, &key);
+  key += kSeparator;
+  return key;
+}
+
+static std::string UserWriteRecordKey(WriteId write_id) {
+  return IdKey(kDbKeyUserWriteRecords, static_cast<uint64_t>(write_id));
+}
+
+static std::string TrackedQueryKey(QueryId query_id) {
+  return IdKey(kDbKeyTrackedQueries, query_id);
+}
+
+static std::string TrackedQueryKeysKey(QueryId query_id) {
+  return IdKey(kDbKeyTrackedQueryKeys, query_id);
+}
+
+// The prefix of the keys of the server cache at and below the given path.
+static std::string ServerCacheKeyPrefix(const Path& path) {
+  std::string prefix;
+  if (!path.empty()) {
+    prefix += kSeparator;
+    prefix += path.str();
+  }
+  prefix += kSeparator;
+  return prefix;
+}
+
+static void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+static bool ReadVarint(Slice* input, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && !input->empty(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>((*input)[0]);
+    input->remove_prefix(1);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+// Pack a set of keys into a single value. The keys are sorted, so each one is
+// written as the length of the prefix it shares with the previous key,
+// followed by the length and bytes of the rest of it.
+static std::string EncodeKeySet(const std::set<std::string>& keys) {
+  std::string result;
+  const std::string* previous = nullptr;
+  for (const std::string& key : keys) {
+    size_t shared = 0;
+    if (previous) {
+      size_t max_shared = std::min(previous->size(), key.size());
+      while (shared < max_shared && (*previous)[shared] == key[shared]) {
+        shared++;
+      }
+    }
+    AppendVarint(shared, &result);
+    AppendVarint(key.size() - shared, &result);
+    result.append(key, shared, std::string::npos);
+    previous = &key;
+  }
+  return result;
+}
+
+static bool DecodeKeySet(Slice input, std::set<std::string>* out_keys) {
+  std::string key;
+  while (!input.empty()) {
+    uint64_t shared;
+    uint64_t unshared;
+    if (!ReadVarint(&input, &shared) || !ReadVarint(&input, &unshared) ||
+        shared > key.size() || unshared > input.size()) {
+      return false;
+    }
+    key.resize(shared);
+    key.append(input.data(), unshared);
+    input.remove_prefix(unshared);
+    out_keys->insert(key);
+  }
+  return true;
+}
+
+// Collects the writes of a single operation. When committed, the writes are
+// handed to the storage engine, which may hold them back to be grouped with
+// the writes of later transactions.
 class BufferedWriteBatch {
  public:
-  explicit BufferedWriteBatch(DB* database)
-      : database_(database),
+  explicit BufferedWriteBatch(LevelDbPersistenceStorageEngine* engine)
+      : engine_(engine),
         buffer_(),
         offset_slices_(),
         batch_(),
@@ -227,29 +339,36 @@ class BufferedWriteBatch {
     return true;
   }
 
-  // Delete the old data at this location.
+  // Delete the old data at this location, including data that has been
+  // written but not yet committed to the database.
   void DeleteLocation(const std::string& path) {
-    for (auto& child : ChildrenAtPath(database_, path)) {
+    for (auto& child : ChildrenAtPath(engine_->database_.get(), path)) {
       batch_.Delete(child.key());
       has_operation_to_write_ = true;
     }
+    if (!engine_->pending_keys_.empty()) {
+      engine_->DeletePendingKeysWithPrefix(path, &batch_);
+      has_operation_to_write_ = true;
+    }
   }
 
   void Commit() {
     // We should not attempt to commit if an error was detected.
     FIREBASE_ASSERT(error_detected_ == false);
 
+    std::vector<std::string> put_keys;
+    put_keys.reserve(offset_slices_.size());
     for (const KeyValuePair& key_value_pair : offset_slices_) {
       const OffsetSlice& key = key_value_pair.first;
       const OffsetSlice& value = key_value_pair.second;
 
       batch_.Put(ToSlice(key), ToSlice(value));
+      put_keys.push_back(ToSlice(key).ToString());
       has_operation_to_write_ = true;
     }
 
     if (has_operation_to_write_) {
-      WriteOptions options;
-      database_->Write(options, &batch_);
+      engine_->AddPendingWrites(batch_, &put_keys);
     }
   }
 
@@ -271,7 +390,7 @@ class BufferedWriteBatch {
   // A key/value pair to insert into the database, represented as OffsetSlices.
   typedef std::pair<OffsetSlice, OffsetSlice> KeyValuePair;
 
-  DB* database_;
+  LevelDbPersistenceStorageEngine* engine_;
 
   // Buffer to populate with the data that we're going to be adding to leveldb.
   std::vector<uint8_t> buffer_;
@@ -282,7 +401,7 @@ class BufferedWriteBatch {
   // The complete list of operations to perform atomically.
   WriteBatch batch_;
 
-  // We should not call DB::Write if we have nothing to write.
+  // We should not hand anything to the engine if we have nothing to write.
   bool has_operation_to_write_;
 
   // An error was detected while collecting data to write. This should not be
@@ -292,7 +411,20 @@ class BufferedWriteBatch {
 
 LevelDbPersistenceStorageEngine::LevelDbPersistenceStorageEngine(
     LoggerBase* logger)
-    : database_(nullptr), inside_transaction_(false), logger_(logger) {}
+    : LevelDbPersistenceStorageEngine(logger, GroupCommitOptions()) {}
+
+LevelDbPersistenceStorageEngine::LevelDbPersistenceStorageEngine(
+    LoggerBase* logger, const GroupCommitOptions& options)
+    : database_(nullptr),
+      inside_transaction_(false),
+      group_commit_options_(options),
+      pending_batch_(),
+      pending_keys_(),
+      pending_bytes_(0),
+      pending_server_cache_writes_(),
+      pending_since_ms_(0),
+      pending_writes_reported_(false),
+      logger_(logger) {}
 
 bool LevelDbPersistenceStorageEngine::Initialize(
     const std::string& level_db_path) {
@@ -307,35 +439,125 @@ bool LevelDbPersistenceStorageEngine::Initialize(
     assert(false);
   }
   database_.reset(database);
-  return status.ok();
+  return status.ok() && MigrateSchema();
 }
 
-LevelDbPersistenceStorageEngine::~LevelDbPersistenceStorageEngine() {}
+// Parse the decimal ID at the start of a key written with schema version 1,
+// e.g. "123/" or "123/child".
+static bool ParseDecimalId(Slice key, uint64_t* id, Slice* rest) {
+  size_t digits = 0;
+  while (digits < key.size() && key[digits] >= '0' && key[digits] <= '9') {
+    digits++;
+  }
+  if (digits == 0 || digits == key.size() || key[digits] != kSeparator) {
+    return false;
+  }
+  *id = std::strtoull(std::string(key.data(), digits).c_str(), nullptr, 10);
+  *rest = Slice(key.data() + digits + 1, key.size() - digits - 1);
+  return true;
+}
+
+bool LevelDbPersistenceStorageEngine::MigrateSchema() {
+  std::string version;
+  Status status =
+      database_->Get(ReadOptions(), kDbKeySchemaVersion, &version);
+  if (status.ok() && version.size() == 1 && version[0] == kSchemaVersion) {
+    return true;
+  }
+  if (!status.ok() && !status.IsNotFound()) {
+    logger_->LogError("Failed to read persistence schema version: %s",
+                      status.ToString().c_str());
+    return false;
+  }
+  if (status.ok()) {
+    logger_->LogError("Unsupported persistence schema version %i",
+                      version.empty() ? -1 : static_cast<int>(version[0]));
+    return false;
+  }
+
+  // There is no version entry, so this is either a new database or one that
+  // was written with schema version 1.
+  WriteBatch batch;
+  int migrated = 0;
+  const char* id_prefixes[] = {kDbKeyUserWriteRecords, kDbKeyTrackedQueries};
+  for (const char* prefix : id_prefixes) {
+    for (auto& child : ChildrenAtPath(database_.get(), prefix)) {
+      Slice key = child.key();
+      key.remove_prefix(strlen(prefix));
+      uint64_t id;
+      Slice rest;
+      batch.Delete(child.key());
+      if (ParseDecimalId(key, &id, &rest) && rest.empty()) {
+        batch.Put(IdKey(prefix, id), child.value());
+        migrated++;
+      }
+    }
+  }
+  std::map<QueryId, std::set<std::string>> tracked_query_keys;
+  for (auto& child : ChildrenAtPath(database_.get(), kDbKeyTrackedQueryKeys)) {
+    Slice key = child.key();
+    key.remove_prefix(strlen(kDbKeyTrackedQueryKeys));
+    uint64_t id;
+    Slice rest;
+    batch.Delete(child.key());
+    if (ParseDecimalId(key, &id, &rest)) {
+      tracked_query_keys[id].insert(child.value().ToString());
+      migrated++;
+    }
+  }
+  for (const auto& entry : tracked_query_keys) {
+    batch.Put(TrackedQueryKeysKey(entry.first), EncodeKeySet(entry.second));
+  }
+  batch.Put(kDbKeySchemaVersion, Slice(&kSchemaVersion, 1));
+
+  WriteOptions options;
+  options.sync = true;
+  status = database_->Write(options, &batch);
+  if (!status.ok()) {
+    logger_->LogError("Failed to migrate persistence schema: %s",
+                      status.ToString().c_str());
+    return false;
+  }
+  if (migrated > 0) {
+    logger_->LogDebug("Migrated %i persisted records to schema version %i",
+                      migrated, static_cast<int>(kSchemaVersion));
+  }
+  return true;
+}
+
+template <typename BuildFunc>
+void LevelDbPersistenceStorageEngine::AppendFlatbuffer(
+    const BuildFunc& build_func, std::vector<uint8_t>* buffer) {
+  builder_.Clear();
+  builder_.Finish(build_func(&builder_));
+  buffer->insert(buffer->end(), builder_.GetBufferPointer(),
+                 builder_.GetBufferPointer() + builder_.GetSize());
+}
+
+LevelDbPersistenceStorageEngine::~LevelDbPersistenceStorageEngine() {
+  if (database_) Flush();
+}
 
 void LevelDbPersistenceStorageEngine::SaveUserOverwrite(const Path& path,
                                                         const Variant& data,
                                                         WriteId write_id) {
   VerifyInsideTransaction();
   UserWriteRecord user_write_record(write_id, path, data, true);
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
   buffered_write_batch.AddWrite(
       // Key
       [&write_id](std::vector<uint8_t>* buffer) {
-        buffer->insert(buffer->end(), kDbKeyUserWriteRecords,
-                       StringEnd(kDbKeyUserWriteRecords));
-        std::string id_str = std::to_string(write_id);
-        buffer->insert(buffer->end(), id_str.begin(), id_str.end());
-        buffer->insert(buffer->end(), static_cast<uint8_t>(kSeparator));
+        std::string key = UserWriteRecordKey(write_id);
+        buffer->insert(buffer->end(), key.begin(), key.end());
         return true;
       },
       // Value
-      [&user_write_record](std::vector<uint8_t>* buffer) {
-        flatbuffers::FlatBufferBuilder builder;
-        auto persisted_user_write_record =
-            FlatbufferFromUserWriteRecord(&builder, user_write_record);
-        builder.Finish(persisted_user_write_record);
-        buffer->insert(buffer->end(), builder.GetBufferPointer(),
-                       builder.GetBufferPointer() + builder.GetSize());
+      [this, &user_write_record](std::vector<uint8_t>* buffer) {
+        AppendFlatbuffer(
+            [&user_write_record](flatbuffers::FlatBufferBuilder* builder) {
+              return FlatbufferFromUserWriteRecord(builder, user_write_record);
+            },
+            buffer);
         return true;
       });
   buffered_write_batch.Commit();
@@ -345,25 +567,21 @@ void LevelDbPersistenceStorageEngine::SaveUserMerge(
     const Path& path, const CompoundWrite& children, WriteId write_id) {
   VerifyInsideTransaction();
   UserWriteRecord user_write_record(write_id, path, children);
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
   buffered_write_batch.AddWrite(
       // Key
       [&write_id](std::vector<uint8_t>* buffer) {
-        buffer->insert(buffer->end(), kDbKeyUserWriteRecords,
-                       StringEnd(kDbKeyUserWriteRecords));
-        std::string id_str = std::to_string(write_id);
-        buffer->insert(buffer->end(), id_str.begin(), id_str.end());
-        buffer->insert(buffer->end(), static_cast<uint8_t>(kSeparator));
+        std::string key = UserWriteRecordKey(write_id);
+        buffer->insert(buffer->end(), key.begin(), key.end());
         return true;
       },
       // Value
-      [&user_write_record](std::vector<uint8_t>* buffer) {
-        flatbuffers::FlatBufferBuilder builder;
-        auto persisted_user_write_record =
-            FlatbufferFromUserWriteRecord(&builder, user_write_record);
-        builder.Finish(persisted_user_write_record);
-        buffer->insert(buffer->end(), builder.GetBufferPointer(),
-                       builder.GetBufferPointer() + builder.GetSize());
+      [this, &user_write_record](std::vector<uint8_t>* buffer) {
+        AppendFlatbuffer(
+            [&user_write_record](flatbuffers::FlatBufferBuilder* builder) {
+              return FlatbufferFromUserWriteRecord(builder, user_write_record);
+            },
+            buffer);
         return true;
       });
   buffered_write_batch.Commit();
@@ -371,14 +589,14 @@ void LevelDbPersistenceStorageEngine::SaveUserMerge(
 
 void LevelDbPersistenceStorageEngine::RemoveUserWrite(WriteId write_id) {
   VerifyInsideTransaction();
-  std::string key =
-      kDbKeyUserWriteRecords + std::to_string(write_id) + kSeparator;
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  std::string key = UserWriteRecordKey(write_id);
+  BufferedWriteBatch buffered_write_batch(this);
   buffered_write_batch.DeleteLocation(key);
   buffered_write_batch.Commit();
 }
 
 std::vector<UserWriteRecord> LevelDbPersistenceStorageEngine::LoadUserWrites() {
+  Flush();
   std::vector<UserWriteRecord> result;
   for (auto& child : ChildrenAtPath(database_.get(), kDbKeyUserWriteRecords)) {
     const PersistedUserWriteRecord* user_write_record =
@@ -389,7 +607,7 @@ std::vector<UserWriteRecord> LevelDbPersistenceStorageEngine::LoadUserWrites() {
 }
 void LevelDbPersistenceStorageEngine::RemoveAllUserWrites() {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
   buffered_write_batch.DeleteLocation(kDbKeyUserWriteRecords);
   buffered_write_batch.Commit();
 }
@@ -441,13 +659,9 @@ static void VariantAddCachedValue(Variant* variant, const Path& path,
 }
 
 Variant LevelDbPersistenceStorageEngine::ServerCache(const Path& path) {
+  Flush();
   Variant result;
-  std::string full_path;
-  if (!path.empty()) {
-    full_path += kSeparator;
-    full_path += path.str();
-  }
-  full_path += kSeparator;
+  std::string full_path = ServerCacheKeyPrefix(path);
   for (auto& child : ChildrenAtPath(database_.get(), full_path)) {
     flexbuffers::Reference reference = flexbuffers::GetRoot(
         reinterpret_cast<const uint8_t*>(child.value().data()),
@@ -602,7 +816,7 @@ static bool PrepareBatchOverwrite(const Path& path, const Variant& data,
 void LevelDbPersistenceStorageEngine::OverwriteServerCache(
     const Path& path, const Variant& data) {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
 
   bool success = PrepareBatchOverwrite(path, data, &buffered_write_batch);
   if (!success) return;
@@ -619,7 +833,7 @@ void LevelDbPersistenceStorageEngine::MergeIntoServerCache(
     return;
   }
 
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
 
   // Gather the changes in the merge.
   for (const auto& key_value : data.map()) {
@@ -638,7 +852,7 @@ void LevelDbPersistenceStorageEngine::MergeIntoServerCache(
 void LevelDbPersistenceStorageEngine::MergeIntoServerCache(
     const Path& path, const CompoundWrite& children) {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
 
   // Gather the changes in the merge.
   bool success = true;
@@ -657,8 +871,31 @@ void LevelDbPersistenceStorageEngine::MergeIntoServerCache(
 
 uint64_t LevelDbPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes()
     const {
+  // Writes that have not been committed yet are not visible to iterators, so
+  // account for them separately, in place of the entries they replace.
   uint64_t result = 0;
   for (auto& child : ChildrenAtPath(database_.get(), "/")) {
+    if (!pending_server_cache_writes_.empty() &&
+        pending_server_cache_writes_.count(child.key().ToString()) != 0) {
+      continue;
+    }
+    result += child.key().size();
+    result += child.value().size();
+  }
+  for (const auto& write : pending_server_cache_writes_) {
+    if (write.second < 0) continue;
+    result += write.first.size();
+    result += static_cast<uint64_t>(write.second);
+  }
+  return result;
+}
+
+uint64_t LevelDbPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes(
+    const Path& path) const {
+  // Only committed writes are counted, as they are cheap to find by location.
+  uint64_t result = 0;
+  for (auto& child :
+       ChildrenAtPath(database_.get(), ServerCacheKeyPrefix(path))) {
     result += child.key().size();
     result += child.value().size();
   }
@@ -668,25 +905,21 @@ uint64_t LevelDbPersistenceStorageEngine::ServerCacheEstimatedSizeInBytes()
 void LevelDbPersistenceStorageEngine::SaveTrackedQuery(
     const TrackedQuery& tracked_query) {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  BufferedWriteBatch buffered_write_batch(this);
   buffered_write_batch.AddWrite(
       // Key
       [&tracked_query](std::vector<uint8_t>* buffer) {
-        buffer->insert(buffer->end(), kDbKeyTrackedQueries,
-                       StringEnd(kDbKeyTrackedQueries));
-        std::string id_str = std::to_string(tracked_query.query_id);
-        buffer->insert(buffer->end(), id_str.begin(), id_str.end());
-        buffer->insert(buffer->end(), static_cast<uint8_t>(kSeparator));
+        std::string key = TrackedQueryKey(tracked_query.query_id);
+        buffer->insert(buffer->end(), key.begin(), key.end());
         return true;
       },
       // Value
-      [&tracked_query](std::vector<uint8_t>* buffer) {
-        flatbuffers::FlatBufferBuilder builder;
-        auto persisted_tracked_query =
-            FlatbufferFromTrackedQuery(&builder, tracked_query);
-        builder.Finish(persisted_tracked_query);
-        buffer->insert(buffer->end(), builder.GetBufferPointer(),
-                       builder.GetBufferPointer() + builder.GetSize());
+      [this, &tracked_query](std::vector<uint8_t>* buffer) {
+        AppendFlatbuffer(
+            [&tracked_query](flatbuffers::FlatBufferBuilder* builder) {
+              return FlatbufferFromTrackedQuery(builder, tracked_query);
+            },
+            buffer);
         return true;
       });
 
@@ -695,14 +928,15 @@ void LevelDbPersistenceStorageEngine::SaveTrackedQuery(
 
 void LevelDbPersistenceStorageEngine::DeleteTrackedQuery(QueryId query_id) {
   VerifyInsideTransaction();
-  std::string key = kDbKeyTrackedQueries + std::to_string(query_id);
-  BufferedWriteBatch buffered_write_batch(database_.get());
+  std::string key = TrackedQueryKey(query_id);
+  BufferedWriteBatch buffered_write_batch(this);
   buffered_write_batch.DeleteLocation(key);
   buffered_write_batch.Commit();
 }
 
 std::vector<TrackedQuery>
 LevelDbPersistenceStorageEngine::LoadTrackedQueries() {
+  Flush();
   std::vector<TrackedQuery> result;
   for (auto& child : ChildrenAtPath(database_.get(), kDbKeyTrackedQueries)) {
     const PersistedTrackedQuery* tracked_query =
@@ -715,9 +949,8 @@ LevelDbPersistenceStorageEngine::LoadTrackedQueries() {
 void LevelDbPersistenceStorageEngine::ResetPreviouslyActiveTrackedQueries(
     uint64_t last_use) {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
-
-  flatbuffers::FlatBufferBuilder builder;
+  Flush();
+  BufferedWriteBatch buffered_write_batch(this);
 
   for (auto& child : ChildrenAtPath(database_.get(), kDbKeyTrackedQueries)) {
     const PersistedTrackedQuery* persisted_tracked_query =
@@ -738,16 +971,12 @@ void LevelDbPersistenceStorageEngine::ResetPreviouslyActiveTrackedQueries(
             return true;
           },
           // Value
-          [&builder, &tracked_query](std::vector<uint8_t>* buffer) {
-            // Write FlexBuffer value to buffer.
-            auto new_persisted_tracked_query =
-                FlatbufferFromTrackedQuery(&builder, tracked_query);
-            builder.Finish(new_persisted_tracked_query);
-            buffer->insert(buffer->end(), builder.GetBufferPointer(),
-                           builder.GetBufferPointer() + builder.GetSize());
-            // Prepare for next iteration.
-            builder.Clear();
-
+          [this, &tracked_query](std::vector<uint8_t>* buffer) {
+            AppendFlatbuffer(
+                [&tracked_query](flatbuffers::FlatBufferBuilder* builder) {
+                  return FlatbufferFromTrackedQuery(builder, tracked_query);
+                },
+                buffer);
             return true;
           });
     }
@@ -756,34 +985,33 @@ void LevelDbPersistenceStorageEngine::ResetPreviouslyActiveTrackedQueries(
 }
 
 static bool SaveTrackedQueryKeysInternal(
-    BufferedWriteBatch* buffered_write_batch, DB* database, QueryId query_id,
+    BufferedWriteBatch* buffered_write_batch, QueryId query_id,
     const std::set<std::string>& keys) {
-  std::string prefix =
-      kDbKeyTrackedQueryKeys + std::to_string(query_id) + kSeparator;
-  for (const std::string& key : keys) {
-    bool success = buffered_write_batch->AddWrite(
-        // Key
-        [&prefix, &key](std::vector<uint8_t>* buffer) {
-          buffer->insert(buffer->end(), prefix.begin(), prefix.end());
-          buffer->insert(buffer->end(), key.begin(), key.end());
-          return true;
-        },
-        // Value
-        [&key](std::vector<uint8_t>* buffer) {
-          buffer->insert(buffer->end(), key.begin(), key.end());
-          return true;
-        });
-    if (!success) return false;
+  std::string db_key = TrackedQueryKeysKey(query_id);
+  // This replaces the packed entry as well as any changes recorded since.
+  buffered_write_batch->DeleteLocation(db_key);
+  if (keys.empty()) {
+    return true;
   }
-  return true;
+  return buffered_write_batch->AddWrite(
+      // Key
+      [&db_key](std::vector<uint8_t>* buffer) {
+        buffer->insert(buffer->end(), db_key.begin(), db_key.end());
+        return true;
+      },
+      // Value
+      [&keys](std::vector<uint8_t>* buffer) {
+        std::string packed_keys = EncodeKeySet(keys);
+        buffer->insert(buffer->end(), packed_keys.begin(), packed_keys.end());
+        return true;
+      });
 }
 
 void LevelDbPersistenceStorageEngine::SaveTrackedQueryKeys(
     QueryId query_id, const std::set<std::string>& keys) {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
-  SaveTrackedQueryKeysInternal(&buffered_write_batch, database_.get(), query_id,
-                               keys);
+  BufferedWriteBatch buffered_write_batch(this);
+  SaveTrackedQueryKeysInternal(&buffered_write_batch, query_id, keys);
   buffered_write_batch.Commit();
 }
 
@@ -791,39 +1019,76 @@ void LevelDbPersistenceStorageEngine::UpdateTrackedQueryKeys(
     QueryId query_id, const std::set<std::string>& added,
     const std::set<std::string>& removed) {
   VerifyInsideTransaction();
-  BufferedWriteBatch buffered_write_batch(database_.get());
-  for (const std::string& key_to_remove : removed) {
-    std::string path_to_remove = kDbKeyTrackedQueryKeys +
-                                 std::to_string(query_id) + kSeparator +
-                                 key_to_remove + kSeparator;
-    buffered_write_batch.DeleteLocation(path_to_remove);
-  }
-  SaveTrackedQueryKeysInternal(&buffered_write_batch, database_.get(), query_id,
-                               added);
+  // Record each change in its own entry rather than rewriting the packed
+  // entry, which would mean reading it back first. A key that is both removed
+  // and added ends up added, as its later write wins.
+  std::string db_key = TrackedQueryKeysKey(query_id);
+  BufferedWriteBatch buffered_write_batch(this);
+  auto add_change = [&](const std::string& key, char change) {
+    buffered_write_batch.AddWrite(
+        // Key
+        [&db_key, &key](std::vector<uint8_t>* buffer) {
+          buffer->insert(buffer->end(), db_key.begin(), db_key.end());
+          buffer->insert(buffer->end(), key.begin(), key.end());
+          return true;
+        },
+        // Value
+        [change](std::vector<uint8_t>* buffer) {
+          buffer->push_back(static_cast<uint8_t>(change));
+          return true;
+        });
+  };
+  for (const std::string& key : removed) {
+    add_change(key, kTrackedQueryKeyRemoved);
+  }
+  for (const std::string& key : added) {
+    add_change(key, kTrackedQueryKeyAdded);
+  }
   buffered_write_batch.Commit();
 }
 
 static void LoadTrackedQueryKeysInternal(DB* database, QueryId query_id,
+                                         LoggerBase* logger,
                                          std::set<std::string>* out_result) {
-  std::string path =
-      kDbKeyTrackedQueryKeys + std::to_string(query_id) + kSeparator;
-  for (auto& child : ChildrenAtPath(database, path)) {
-    out_result->insert(child.value().ToString());
+  std::string db_key = TrackedQueryKeysKey(query_id);
+  // The packed entry sorts first, followed by the changes recorded since.
+  std::set<std::string> keys;
+  bool corrupt = false;
+  for (auto& child : ChildrenAtPath(database, db_key)) {
+    Slice key = child.key();
+    key.remove_prefix(db_key.size());
+    Slice value = child.value();
+    if (key.empty()) {
+      corrupt |= !DecodeKeySet(value, &keys);
+    } else if (value == Slice(&kTrackedQueryKeyAdded, 1)) {
+      keys.insert(key.ToString());
+    } else if (value == Slice(&kTrackedQueryKeyRemoved, 1)) {
+      keys.erase(key.ToString());
+    } else {
+      corrupt = true;
+    }
+  }
+  if (corrupt) {
+    logger->LogError("Corrupt tracked query keys for query %i",
+                     static_cast<int>(query_id));
   }
+  out_result->insert(keys.begin(), keys.end());
 }
 
 std::set<std::string> LevelDbPersistenceStorageEngine::LoadTrackedQueryKeys(
     QueryId query_id) {
+  Flush();
   std::set<std::string> result;
-  LoadTrackedQueryKeysInternal(database_.get(), query_id, &result);
+  LoadTrackedQueryKeysInternal(database_.get(), query_id, logger_, &result);
   return result;
 }
 
 std::set<std::string> LevelDbPersistenceStorageEngine::LoadTrackedQueryKeys(
     const std::set<QueryId>& query_ids) {
+  Flush();
   std::set<std::string> result;
   for (QueryId query_id : query_ids) {
-    LoadTrackedQueryKeysInternal(database_.get(), query_id, &result);
+    LoadTrackedQueryKeysInternal(database_.get(), query_id, logger_, &result);
   }
   return result;
 }
@@ -834,10 +1099,11 @@ void LevelDbPersistenceStorageEngine::PruneCache(
   if (!prune_forest.PrunesAnything()) {
     return;
   }
+  Flush();
 
   WriteBatch batch;
   bool has_operation_to_write = false;
-  std::string root_str = kSeparator + root.str() + kSeparator;
+  std::string root_str = ServerCacheKeyPrefix(root);
   for (auto& child : ChildrenAtPath(database_.get(), root_str)) {
     Slice key = child.key();
     key.remove_prefix(root.str().size() + 1 /* leading slash */);
@@ -849,8 +1115,8 @@ void LevelDbPersistenceStorageEngine::PruneCache(
   }
 
   if (has_operation_to_write) {
-    WriteOptions options;
-    database_->Write(options, &batch);
+    std::vector<std::string> put_keys;
+    AddPendingWrites(batch, &put_keys);
   }
 }
 
@@ -867,11 +1133,103 @@ void LevelDbPersistenceStorageEngine::EndTransaction() {
   FIREBASE_ASSERT_MESSAGE(inside_transaction_,
                           "EndTransaction called when not in a transaction");
   inside_transaction_ = false;
+  MaybeFlush();
+  if (pending_bytes_ != 0 && !pending_writes_reported_) {
+    pending_writes_reported_ = true;
+    if (group_commit_options_.pending_writes_callback) {
+      group_commit_options_.pending_writes_callback(
+          group_commit_options_.pending_writes_callback_data);
+    }
+  }
   logger_->LogDebug("Transaction completed.");
 }
 
 void LevelDbPersistenceStorageEngine::SetTransactionSuccessful() {}
 
+void LevelDbPersistenceStorageEngine::Flush() {
+  if (pending_bytes_ == 0) return;
+  WriteOptions options;
+  options.sync = group_commit_options_.sync;
+  Status status = database_->Write(options, &pending_batch_);
+  if (!status.ok()) {
+    logger_->LogError("Failed to commit %i bytes to persistence: %s",
+                      static_cast<int>(pending_bytes_),
+                      status.ToString().c_str());
+  }
+  pending_batch_.Clear();
+  pending_keys_.clear();
+  pending_server_cache_writes_.clear();
+  pending_bytes_ = 0;
+  pending_writes_reported_ = false;
+}
+
+namespace {
+
+// Records the server cache entries that a batch puts and deletes, in order, so
+// that later writes to the same key replace earlier ones.
+class ServerCacheWriteRecorder : public WriteBatch::Handler {
+ public:
+  explicit ServerCacheWriteRecorder(std::map<std::string, int64_t>* writes)
+      : writes_(writes) {}
+
+  void Put(const Slice& key, const Slice& value) override {
+    if (IsServerCacheKey(key)) {
+      (*writes_)[key.ToString()] = static_cast<int64_t>(value.size());
+    }
+  }
+
+  void Delete(const Slice& key) override {
+    if (IsServerCacheKey(key)) (*writes_)[key.ToString()] = -1;
+  }
+
+ private:
+  static bool IsServerCacheKey(const Slice& key) {
+    return !key.empty() && key[0] == kSeparator;
+  }
+
+  std::map<std::string, int64_t>* writes_;
+};
+
+}  // namespace
+
+void LevelDbPersistenceStorageEngine::AddPendingWrites(
+    const WriteBatch& batch, std::vector<std::string>* put_keys) {
+  if (pending_bytes_ == 0) {
+    pending_since_ms_ = firebase::internal::GetTimestamp();
+  }
+  pending_batch_.Append(batch);
+  // The batch header is not part of the data being written.
+  static const size_t kWriteBatchHeaderSize = WriteBatch().ApproximateSize();
+  pending_bytes_ += batch.ApproximateSize() - kWriteBatchHeaderSize;
+  for (std::string& key : *put_keys) {
+    pending_keys_.insert(std::move(key));
+  }
+  ServerCacheWriteRecorder recorder(&pending_server_cache_writes_);
+  batch.Iterate(&recorder);
+}
+
+void LevelDbPersistenceStorageEngine::DeletePendingKeysWithPrefix(
+    const std::string& prefix, WriteBatch* batch) {
+  // Keys are not removed from pending_keys_ here, since the batch they are
+  // deleted in may never be committed. Deleting a key twice is harmless.
+  for (auto iter = pending_keys_.lower_bound(prefix);
+       iter != pending_keys_.end() && StringStartsWith(*iter, prefix);
+       ++iter) {
+    batch->Delete(*iter);
+  }
+}
+
+void LevelDbPersistenceStorageEngine::MaybeFlush() {
+  if (pending_bytes_ == 0) return;
+  const GroupCommitOptions& options = group_commit_options_;
+  if (options.max_pending_bytes == 0 ||
+      pending_bytes_ >= options.max_pending_bytes ||
+      firebase::internal::GetTimestamp() - pending_since_ms_ >=
+          options.max_pending_milliseconds) {
+    Flush();
+  }
+}
+
 void LevelDbPersistenceStorageEngine::VerifyInsideTransaction() {
   FIREBASE_ASSERT_MESSAGE(inside_transaction_,
                           "Transaction expected to already be in progress.");
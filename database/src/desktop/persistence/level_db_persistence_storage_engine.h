@@ -15,6 +15,12 @@
 #ifndef FIREBASE_DATABASE_SRC_DESKTOP_PERSISTENCE_LEVEL_DB_PERSISTENCE_STORAGE_ENGINE_H_
 #define FIREBASE_DATABASE_SRC_DESKTOP_PERSISTENCE_LEVEL_DB_PERSISTENCE_STORAGE_ENGINE_H_
 
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "app/memory/unique_ptr.h"
 #include "app/src/include/firebase/variant.h"
 #include "app/src/logger.h"
@@ -24,7 +30,9 @@
 #include "database/src/desktop/core/tracked_query_manager.h"
 #include "database/src/desktop/persistence/persistence_storage_engine.h"
 #include "database/src/desktop/persistence/prune_forest.h"
+#include "flatbuffers/flatbuffers.h"
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 namespace firebase {
 namespace database {
@@ -32,14 +40,50 @@ namespace internal {
 
 class DatabaseInternal;
 
+// Controls how the writes made by consecutive transactions are grouped
+// together before being committed to LevelDB.
+struct GroupCommitOptions {
+  GroupCommitOptions()
+      : max_pending_bytes(0),
+        max_pending_milliseconds(0),
+        sync(false),
+        pending_writes_callback(nullptr),
+        pending_writes_callback_data(nullptr) {}
+
+  // Once at least this many bytes of writes are pending they are committed at
+  // the end of the current transaction. If 0, every transaction is committed
+  // as soon as it ends.
+  size_t max_pending_bytes;
+
+  // Once the oldest pending write is at least this old, pending writes are
+  // committed at the end of the current transaction.
+  uint64_t max_pending_milliseconds;
+
+  // If true, every commit waits for LevelDB to sync its log to disk before
+  // returning. Otherwise the data is handed to the OS and may be lost if the
+  // machine (but not the process) crashes.
+  bool sync;
+
+  // Called with pending_writes_callback_data when a transaction ends leaving
+  // writes pending and nothing was pending before. Unless a later transaction
+  // commits them, the owner must call Flush() to do so, e.g. from a timer
+  // armed for max_pending_milliseconds. May be null.
+  void (*pending_writes_callback)(void* data);
+  void* pending_writes_callback_data;
+};
+
 class LevelDbPersistenceStorageEngine : public PersistenceStorageEngine {
  public:
   explicit LevelDbPersistenceStorageEngine(LoggerBase* logger);
 
+  LevelDbPersistenceStorageEngine(LoggerBase* logger,
+                                  const GroupCommitOptions& options);
+
   ~LevelDbPersistenceStorageEngine() override;
 
   // Opening up the database may fail, so we have to initialize the database in
-  // a separate step.
+  // a separate step. Databases written with an older layout are migrated to
+  // the current one.
   bool Initialize(const std::string& level_db_path);
 
   // Write data to the local cache, overwriting the data at the given path.
@@ -109,6 +153,12 @@ class LevelDbPersistenceStorageEngine : public PersistenceStorageEngine {
   // @return The estimated server cache size.
   uint64_t ServerCacheEstimatedSizeInBytes() const override;
 
+  // Estimate the size of the Server Cache at and below the given path.
+  //
+  // @param path The location to estimate the size of.
+  // @return The estimated size of the server cache at the given path.
+  uint64_t ServerCacheEstimatedSizeInBytes(const Path& path) const override;
+
   // Write the tracked query to the cache.
   //
   // @param tracked_query the tracked query to persist.
@@ -180,13 +230,70 @@ class LevelDbPersistenceStorageEngine : public PersistenceStorageEngine {
   // Declare that a transaction completed successfully.
   void SetTransactionSuccessful() override;
 
+  // Commit any writes that are being held back to be grouped with those of
+  // later transactions.
+  void Flush() override;
+
+  // The number of bytes of writes that have not yet been committed.
+  size_t pending_bytes() const { return pending_bytes_; }
+
  private:
+  friend class BufferedWriteBatch;
+
   void VerifyInsideTransaction();
 
+  // Bring a database written with an older layout up to date.
+  bool MigrateSchema();
+
+  // Append the serialized flatbuffer produced by the given function to the
+  // buffer, reusing builder_ between records.
+  template <typename BuildFunc>
+  void AppendFlatbuffer(const BuildFunc& build_func,
+                        std::vector<uint8_t>* buffer);
+
+  // Append the given batch to the writes pending commit. put_keys are the keys
+  // written by the batch, so that later deletes can find them before they have
+  // been committed.
+  void AddPendingWrites(const leveldb::WriteBatch& batch,
+                        std::vector<std::string>* put_keys);
+
+  // Delete every pending key that begins with the given prefix.
+  void DeletePendingKeysWithPrefix(const std::string& prefix,
+                                   leveldb::WriteBatch* batch);
+
+  // Commit the pending writes if the group commit policy says it is time.
+  void MaybeFlush();
+
   UniquePtr<leveldb::DB> database_;
 
   bool inside_transaction_;
 
+  GroupCommitOptions group_commit_options_;
+
+  // Reused to serialize records so that its buffer is not reallocated for each
+  // write.
+  flatbuffers::FlatBufferBuilder builder_;
+
+  // Writes from finished transactions that have not yet been committed.
+  leveldb::WriteBatch pending_batch_;
+
+  // Keys that have been put in pending_batch_.
+  std::set<std::string> pending_keys_;
+
+  // Approximate number of key and value bytes in pending_batch_.
+  size_t pending_bytes_;
+
+  // The server cache entries written by pending_batch_, with the size of the
+  // value put, or -1 where the entry is deleted. They stand in for the
+  // committed entries when estimating the size of the server cache.
+  std::map<std::string, int64_t> pending_server_cache_writes_;
+
+  // The time at which the oldest write in pending_batch_ was added.
+  uint64_t pending_since_ms_;
+
+  // Whether pending_writes_callback has been called for the pending writes.
+  bool pending_writes_reported_;
+
   LoggerBase* logger_;
 };
 
@@ -108,6 +108,10 @@ bool NoopPersistenceManager::RunInTransaction(std::function<bool()> func) {
   return success;
 }
 
+void NoopPersistenceManager::Flush() {}
+
+bool NoopPersistenceManager::PruneCacheStep() { return false; }
+
 }  // namespace internal
 }  // namespace database
 }  // namespace firebase
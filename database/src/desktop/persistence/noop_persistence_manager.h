@@ -121,6 +121,12 @@ class NoopPersistenceManager : public PersistenceManagerInterface {
   // BeingTransaction and EndTransaction.
   bool RunInTransaction(std::function<bool()> func) override;
 
+  // Nothing is persisted, so there is nothing to flush.
+  void Flush() override;
+
+  // Nothing is persisted, so there is nothing to prune.
+  bool PruneCacheStep() override;
+
  private:
   bool inside_transaction_;
 };
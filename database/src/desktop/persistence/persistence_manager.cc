@@ -14,6 +14,7 @@
 
 #include "database/src/desktop/persistence/persistence_manager.h"
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <string>
@@ -22,6 +23,7 @@
 #include "app/src/assert.h"
 #include "app/src/log.h"
 #include "app/src/path.h"
+#include "app/src/trace.h"
 #include "app/src/variant_util.h"
 #include "database/src/common/query_spec.h"
 #include "database/src/desktop/core/tracked_query_manager.h"
@@ -41,17 +43,23 @@ PersistenceManager::PersistenceManager(
       tracked_query_manager_(std::move(tracked_query_manager)),
       cache_policy_(std::move(cache_policy)),
       server_cache_updates_since_last_prune_check_(0),
+      prune_check_pending_(false),
+      prune_in_progress_(false),
+      queries_left_to_prune_(0),
+      bytes_left_to_prune_(0),
       logger_(logger) {}
 
 void PersistenceManager::SaveUserOverwrite(const Path& path,
                                            const Variant& variant,
                                            WriteId write_id) {
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::SaveUserOverwrite");
   storage_engine_->SaveUserOverwrite(path, variant, write_id);
 }
 
 void PersistenceManager::SaveUserMerge(const Path& path,
                                        const CompoundWrite& children,
                                        WriteId write_id) {
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::SaveUserMerge");
   storage_engine_->SaveUserMerge(path, children, write_id);
 }
 
@@ -85,6 +93,7 @@ std::vector<UserWriteRecord> PersistenceManager::LoadUserWrites() {
 }
 
 CacheNode PersistenceManager::ServerCache(const QuerySpec& query_spec) {
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::ServerCache");
   std::set<std::string> tracked_keys;
   bool found_tracked_keys = false;
   bool complete;
@@ -125,6 +134,7 @@ CacheNode PersistenceManager::ServerCache(const QuerySpec& query_spec) {
 
 void PersistenceManager::UpdateServerCache(const QuerySpec& query_spec,
                                            const Variant& variant) {
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::UpdateServerCache");
   if (QuerySpecLoadsAllData(query_spec)) {
     storage_engine_->OverwriteServerCache(query_spec.path, variant);
   } else {
@@ -136,6 +146,7 @@ void PersistenceManager::UpdateServerCache(const QuerySpec& query_spec,
 
 void PersistenceManager::UpdateServerCache(const Path& path,
                                            const CompoundWrite& children) {
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::UpdateServerCache");
   storage_engine_->MergeIntoServerCache(path, children);
   DoPruneCheckAfterServerUpdate();
 }
@@ -193,27 +204,10 @@ void PersistenceManager::DoPruneCheckAfterServerUpdate() {
   if (cache_policy_->ShouldCheckCacheSize(
           server_cache_updates_since_last_prune_check_)) {
     logger_->LogDebug("Reached prune check threshold.");
-
     server_cache_updates_since_last_prune_check_ = 0;
-    bool can_prune = true;
-    uint64_t cache_size = storage_engine_->ServerCacheEstimatedSizeInBytes();
-    logger_->LogDebug("Cache size: %i", static_cast<int>(cache_size));
-
-    while (can_prune &&
-           cache_policy_->ShouldPrune(
-               cache_size, tracked_query_manager_->CountOfPrunableQueries())) {
-      PruneForest prune_forest =
-          tracked_query_manager_->PruneOldQueries(*cache_policy_);
-      PruneForestRef prune_forest_ref(&prune_forest);
-      if (prune_forest_ref.PrunesAnything()) {
-        storage_engine_->PruneCache(Path(), prune_forest_ref);
-      } else {
-        can_prune = false;
-      }
-      cache_size = storage_engine_->ServerCacheEstimatedSizeInBytes();
-      logger_->LogDebug("Cache size after prune: %i",
-                        static_cast<int>(cache_size));
-    }
+    // Measuring and pruning the cache can take a long time, so leave it to
+    // PruneCacheStep rather than doing it in the middle of a server update.
+    prune_check_pending_ = true;
   }
 }
 
@@ -228,6 +222,75 @@ bool PersistenceManager::RunInTransaction(
   return success;
 }
 
+void PersistenceManager::Flush() {
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::Flush");
+  storage_engine_->Flush();
+}
+
+// The most queries removed by a single PruneCacheStep.
+static const uint64_t kMaxQueriesToPrunePerStep = 50;
+
+bool PersistenceManager::PruneCacheStep() {
+  if (!prune_check_pending_ && !prune_in_progress_) {
+    return false;
+  }
+  FIREBASE_TRACE_SCOPE("persistence", "PersistenceManager::PruneCacheStep");
+
+  if (!prune_in_progress_) {
+    prune_check_pending_ = false;
+    uint64_t cache_size = storage_engine_->ServerCacheEstimatedSizeInBytes();
+    logger_->LogDebug("Cache size: %i", static_cast<int>(cache_size));
+    if (!cache_policy_->ShouldPrune(
+            cache_size, tracked_query_manager_->CountOfPrunableQueries())) {
+      return false;
+    }
+    // Prune the queries the cache policy asks for, and then keep pruning the
+    // least recently used ones until the cache fits in its size limit.
+    uint64_t max_size = cache_policy_->GetMaxSizeBytes();
+    queries_left_to_prune_ =
+        tracked_query_manager_->CountOfQueriesToPrune(*cache_policy_);
+    bytes_left_to_prune_ = cache_size > max_size ? cache_size - max_size : 0;
+    tracked_query_manager_->StartPruningLeastRecentlyUsedQueries();
+    prune_in_progress_ = true;
+  }
+
+  uint64_t count_to_prune =
+      std::min(queries_left_to_prune_, kMaxQueriesToPrunePerStep);
+  uint64_t bytes_pruned = 0;
+  bool pruned_anything = false;
+  RunInTransaction([&]() {
+    PruneForest prune_forest =
+        tracked_query_manager_->PruneLeastRecentlyUsedQueries(
+            count_to_prune, bytes_left_to_prune_, kMaxQueriesToPrunePerStep,
+            &bytes_pruned);
+    PruneForestRef prune_forest_ref(&prune_forest);
+    pruned_anything = prune_forest_ref.PrunesAnything();
+    if (!pruned_anything) {
+      return true;
+    }
+    // Only visit the cache below the pruned locations instead of all of it.
+    std::vector<Path> prune_roots;
+    prune_forest.CallOnEach(Path(), [&prune_roots](const Path& path,
+                                                   bool& prune) {
+      if (prune) prune_roots.push_back(path);
+    });
+    for (const Path& root : prune_roots) {
+      storage_engine_->PruneCache(root, prune_forest_ref.GetChild(root));
+    }
+    return true;
+  });
+
+  queries_left_to_prune_ -= count_to_prune;
+  bytes_left_to_prune_ -= std::min(bytes_left_to_prune_, bytes_pruned);
+  logger_->LogDebug("Estimated bytes left to prune: %i",
+                    static_cast<int>(bytes_left_to_prune_));
+  if (!pruned_anything ||
+      (queries_left_to_prune_ == 0 && bytes_left_to_prune_ == 0)) {
+    prune_in_progress_ = false;
+  }
+  return prune_in_progress_;
+}
+
 }  // namespace internal
 }  // namespace database
 }  // namespace firebase
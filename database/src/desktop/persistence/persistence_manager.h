@@ -123,6 +123,15 @@ class PersistenceManager : public PersistenceManagerInterface {
   // BeingTransaction and EndTransaction.
   bool RunInTransaction(std::function<bool()> transaction_func) override;
 
+  // Commit any writes that the storage engine is holding back to group with
+  // later transactions.
+  void Flush() override;
+
+  // Prune at most a few queries worth of data from the server cache, so that
+  // a large prune does not stall the thread that persistence runs on. Returns
+  // true if there is more pruning left to do.
+  bool PruneCacheStep() override;
+
  private:
   void DoPruneCheckAfterServerUpdate();
 
@@ -134,6 +143,14 @@ class PersistenceManager : public PersistenceManagerInterface {
 
   uint64_t server_cache_updates_since_last_prune_check_;
 
+  // Whether the cache size should be checked by the next PruneCacheStep.
+  bool prune_check_pending_;
+
+  // Whether a prune is in progress, and how much is left to remove in it.
+  bool prune_in_progress_;
+  uint64_t queries_left_to_prune_;
+  uint64_t bytes_left_to_prune_;
+
   Mutex transaction_mutex_;
 
   LoggerBase* logger_;
@@ -108,6 +108,14 @@ class PersistenceManagerInterface {
                                       const std::set<std::string>& removed) = 0;
 
   virtual bool RunInTransaction(std::function<bool()> transaction_func) = 0;
+
+  // Commit any writes that the storage engine is holding back to group with
+  // later transactions.
+  virtual void Flush() = 0;
+
+  // Do a bounded amount of the cache pruning that server updates have made
+  // necessary. Returns true if there is more pruning left to do.
+  virtual bool PruneCacheStep() = 0;
 };
 
 }  // namespace internal
@@ -162,6 +162,13 @@ class PersistenceStorageEngine {
   // @return The estimated server cache size.
   virtual uint64_t ServerCacheEstimatedSizeInBytes() const = 0;
 
+  // Estimate the size of the Server Cache at and below the given path, on the
+  // same scale as ServerCacheEstimatedSizeInBytes().
+  //
+  // @param path The location to estimate the size of.
+  // @return The estimated size of the server cache at the given path.
+  virtual uint64_t ServerCacheEstimatedSizeInBytes(const Path& path) const = 0;
+
   // Write the tracked query to the cache.
   //
   // @param tracked_query the tracked query to persist.
@@ -231,6 +238,10 @@ class PersistenceStorageEngine {
 
   // Declare that a transaction completed successfully.
   virtual void SetTransactionSuccessful() = 0;
+
+  // Commit any writes that have been held back to be grouped with the writes
+  // of later transactions.
+  virtual void Flush() = 0;
 };
 
 }  // namespace internal
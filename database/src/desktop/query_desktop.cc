@@ -240,13 +240,15 @@ void QueryInternal::RemoveEventRegistration(void* listener_ptr,
   }
 
   Repo::scheduler().Schedule(NewCallback(
-      [](Repo::ThisRef ref, void* listener_ptr, QuerySpec query_spec) {
+      [](Repo::ThisRef ref, DatabaseInternal* database, void* listener_ptr,
+         QuerySpec query_spec) {
         Repo::ThisRefLock lock(&ref);
         if (lock.GetReference() != nullptr) {
-          lock.GetReference()->RemoveEventCallback(listener_ptr, query_spec);
+          lock.GetReference()->RemoveEventCallback(database, listener_ptr,
+                                                   query_spec);
         }
       },
-      database_->repo()->this_ref(), listener_ptr, query_spec));
+      database_->repo()->this_ref(), database_, listener_ptr, query_spec));
 }
 
 void QueryInternal::RemoveEventRegistration(ValueListener* listener,
@@ -56,15 +56,20 @@ struct TransactionData {
   };
 
   // This constructor is primarily used for testing
-  TransactionData() : delete_context(nullptr), outstanding_listener(nullptr) {}
+  TransactionData()
+      : database(nullptr),
+        delete_context(nullptr),
+        outstanding_listener(nullptr) {}
 
   // Constructor to capture all data for a RunTransaction request
-  TransactionData(const SafeFutureHandle<DataSnapshot>& handle,
+  TransactionData(DatabaseInternal* database,
+                  const SafeFutureHandle<DataSnapshot>& handle,
                   ReferenceCountedFutureImpl* ref_future, const Path& path,
                   DoTransactionWithContext function, void* context,
                   void (*delete_context)(void*), bool trigger_local_events,
                   UniquePtr<ValueListener> outstanding_listener)
-      : future_handle(handle),
+      : database(database),
+        future_handle(handle),
         ref_future(ref_future),
         path(path),
         transaction_function(function),
@@ -85,6 +90,10 @@ struct TransactionData {
     return transaction_order > other.transaction_order;
   }
 
+  // The database that started this transaction. Snapshots handed back to the
+  // developer belong to it.
+  DatabaseInternal* database;
+
   // References for Future to fulfill
   SafeFutureHandle<DataSnapshot> future_handle;
   ReferenceCountedFutureImpl* ref_future;
@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -85,6 +86,47 @@ bool PatchVariant(const Variant& patch_data, Variant* out_data) {
   return true;
 }
 
+// Children are kept in the std::map that Variant::map() exposes rather than in
+// a flat or hashed index. map() hands callers a mutable std::map& that the
+// rest of the database holds on to and edits in place, so any other
+// representation would have to be converted back into a std::map on nearly
+// every access, and a side index could be invalidated behind its back. At
+// 100000 children the std::map find is about 2us of a 4-5us path update
+// (util_benchmark.cc), which bounds what a hashed index could save here.
+//
+// Returns a Variant that can be used to look up the given key in a Variant
+// map without copying it. The result refers to the key's characters, so it must
+// not outlive the key and must never be inserted into a map.
+static Variant LookupKey(const std::string& key) {
+  return Variant::FromStaticString(key.c_str());
+}
+
+// Returns a Variant to insert the given key into a Variant map with. The same
+// child names recur across siblings and across the copies of a tree that the
+// caches hold, so they share one copy of each.
+static Variant InsertionKey(const std::string& key) {
+  return Variant::FromInternedString(key);
+}
+
+// Updates the child of the given map Variant at the given key, removing the
+// child again if it ends up empty. The child is only looked up once.
+static void VariantUpdateMapChild(Variant* variant, const std::string& key,
+                                  const Path& path, const Variant& value) {
+  std::map<Variant, Variant>& map = variant->map();
+  Variant lookup_key = LookupKey(key);
+  auto iter = map.lower_bound(lookup_key);
+  if (iter == map.end() || lookup_key < iter->first) {
+    iter = map.insert(iter, std::make_pair(InsertionKey(key), Variant::Null()));
+  }
+  VariantUpdateChild(&iter->second, path, value);
+  if (VariantIsEmpty(iter->second)) {
+    map.erase(iter);
+  }
+  if (VariantIsEmpty(*variant)) {
+    *variant = Variant::Null();
+  }
+}
+
 static const Variant& VariantGetImmediateChild(const Variant* variant,
                                                const std::string& key) {
   if (VariantIsLeaf(*variant)) {
@@ -97,7 +139,7 @@ static const Variant& VariantGetImmediateChild(const Variant* variant,
     if (IsPriorityKey(key)) {
       return GetVariantPriority(*variant);
     } else {
-      const Variant* result = MapGet(&variant->map(), key);
+      const Variant* result = MapGet(&variant->map(), LookupKey(key));
       return result ? *result : kNullVariant;
     }
   }
@@ -134,14 +176,7 @@ void VariantUpdateChild(Variant* variant, const Path& path,
     *variant = value;
   } else if (variant->is_null()) {
     *variant = Variant::EmptyMap();
-    Variant& immediate_child = variant->map()[front];
-    VariantUpdateChild(&immediate_child, path.PopFrontDirectory(), value);
-    if (VariantIsEmpty(immediate_child)) {
-      variant->map().erase(variant->map().find(front));
-    }
-    if (VariantIsEmpty(*variant)) {
-      *variant = Variant::Null();
-    }
+    VariantUpdateMapChild(variant, front, path.PopFrontDirectory(), value);
   } else if (VariantIsLeaf(*variant)) {
     std::string front = path.FrontDirectory().str();
     if (VariantIsEmpty(value) && !IsPriorityKey(front)) {
@@ -156,27 +191,13 @@ void VariantUpdateChild(Variant* variant, const Path& path,
       if (dot_value_iter != variant->map().end()) {
         variant->map().erase(dot_value_iter);
       }
-      Variant& immediate_child = variant->map()[front];
-      VariantUpdateChild(&immediate_child, path.PopFrontDirectory(), value);
-      if (VariantIsEmpty(immediate_child)) {
-        variant->map().erase(variant->map().find(front));
-      }
-      if (VariantIsEmpty(*variant)) {
-        *variant = Variant::Null();
-      }
+      VariantUpdateMapChild(variant, front, path.PopFrontDirectory(), value);
     }
   } else {
     if (IsPriorityKey(front)) {
       CombineValueAndPriorityInPlace(variant, value);
     } else {
-      Variant& immediate_child = variant->map()[front];
-      VariantUpdateChild(&immediate_child, path.PopFrontDirectory(), value);
-      if (VariantIsEmpty(immediate_child)) {
-        variant->map().erase(variant->map().find(front));
-      }
-      if (VariantIsEmpty(*variant)) {
-        *variant = Variant::Null();
-      }
+      VariantUpdateMapChild(variant, front, path.PopFrontDirectory(), value);
     }
   }
 }
@@ -189,7 +210,7 @@ void VariantUpdateChild(Variant* variant, const std::string& key,
 Variant* GetInternalVariant(Variant* variant, const Path& path) {
   Variant* result = variant;
   for (const std::string& directory : path.GetDirectories()) {
-    result = GetInternalVariant(result, directory);
+    result = GetInternalVariant(result, LookupKey(directory));
     if (result == nullptr) break;
   }
   return result;
@@ -227,9 +248,10 @@ Variant* MakeVariantAtPath(Variant* variant, const Path& path) {
     map.erase(kValueKey);
 
     // Create the new map if necessary.
-    auto iter = map.find(directory);
+    auto iter = map.find(LookupKey(directory));
     if (iter == map.end()) {
-      auto insertion = map.insert(std::make_pair(directory, Variant::Null()));
+      auto insertion =
+          map.insert(std::make_pair(InsertionKey(directory), Variant::Null()));
       iter = insertion.first;
       bool success = insertion.second;
       assert(success);
@@ -689,7 +711,7 @@ bool VariantIsEmpty(const Variant& variant) {
     if (map.empty()) return true;
     // If there's only one element and it's the priority then this is
     // effectively an empty map.
-    if (map.size() == 1 && !GetVariantPriority(value->map()).is_null()) {
+    if (map.size() == 1 && !GetVariantPriority(*value).is_null()) {
       return true;
     }
   }
@@ -14,6 +14,7 @@
 
 #include "database/src/desktop/view/view.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "app/memory/unique_ptr.h"
@@ -110,8 +111,8 @@ void View::AddEventRegistration(UniquePtr<EventRegistration> registration) {
   event_registrations_.emplace_back(std::move(registration));
 }
 
-std::vector<Event> View::RemoveEventRegistration(void* listener_ptr,
-                                                 Error cancel_error) {
+std::vector<Event> View::RemoveEventRegistration(
+    void* listener_ptr, const DatabaseInternal* database, Error cancel_error) {
   // If there was an error, clear out all the registrations and generate the
   // proper events for each one.
   if (cancel_error != kErrorNone) {
@@ -135,11 +136,20 @@ std::vector<Event> View::RemoveEventRegistration(void* listener_ptr,
     for (auto iter = event_registrations_.begin();
          iter != event_registrations_.end(); ++iter) {
       UniquePtr<EventRegistration>& event_registration = *iter;
-      if (event_registration->MatchesListener(listener_ptr)) {
+      if (event_registration->MatchesListener(listener_ptr) &&
+          (database == nullptr || event_registration->database() == database)) {
         event_registrations_.erase(iter);
         break;
       }
     }
+  } else if (database) {
+    // Remove every event registration made through the given database.
+    event_registrations_.erase(
+        std::remove_if(event_registrations_.begin(), event_registrations_.end(),
+                       [database](const UniquePtr<EventRegistration>& reg) {
+                         return reg->database() == database;
+                       }),
+        event_registrations_.end());
   } else {
     // If no specific listener was specified, remove all event registrations.
     event_registrations_.clear();
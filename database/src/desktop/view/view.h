@@ -66,8 +66,10 @@ class View {
   void AddEventRegistration(UniquePtr<EventRegistration> registration);
 
   // Removes an EventRegistration given the pointer to its listener. If no
-  // listener_ptr is supplied, all registrations are removed.
+  // listener_ptr is supplied, all registrations are removed. If a database is
+  // supplied, only a registration made through that database matches.
   std::vector<Event> RemoveEventRegistration(void* listener_ptr,
+                                             const DatabaseInternal* database,
                                              Error cancel_error);
 
   // Apply an operation to the view. If available, you may specify a complete
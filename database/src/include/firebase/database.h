@@ -15,6 +15,8 @@
 #ifndef FIREBASE_DATABASE_SRC_INCLUDE_FIREBASE_DATABASE_H_
 #define FIREBASE_DATABASE_SRC_INCLUDE_FIREBASE_DATABASE_H_
 
+#include <vector>
+
 #include "firebase/app.h"
 #include "firebase/database/common.h"
 #include "firebase/database/data_snapshot.h"
@@ -163,6 +165,56 @@ class Database {
   /// (disk) storage, or false to discard pending writes when the app exists.
   void set_persistence_enabled(bool enabled);
 
+  /// Set whether writes to the on-device cache wait for the data to reach the
+  /// disk. By default the data is handed to the operating system, which is
+  /// faster but can lose the most recent writes if the device loses power.
+  /// Enable this if those writes must survive a power loss.
+  ///
+  /// @note This is only supported on desktop platforms, only matters when
+  /// persistence is enabled, and should be called before creating any
+  /// instances of DatabaseReference. It has no effect on Android and iOS.
+  ///
+  /// @param[in] enabled Set this to true to sync every commit to disk, or
+  /// false (the default) to let the operating system write it back.
+  void set_persistence_sync_enabled(bool enabled);
+
+  /// Allow this Database instance to share its connection to the server with
+  /// other Database instances that use the same database URL and are signed
+  /// in as the same user (for example the same database accessed through
+  /// several Firebase Apps). Instances that share a connection also share
+  /// their local cache, so data loaded through one is immediately available
+  /// to the others without another round trip to the server.
+  ///
+  /// @note This is only supported on desktop platforms, and should be called
+  /// before creating any instances of DatabaseReference. It has no effect on
+  /// Android and iOS, which manage their connections themselves.
+  ///
+  /// @param[in] enabled Set this to true to share the connection, or false
+  /// (the default) to give this instance its own connection.
+  void set_shared_connection_enabled(bool enabled);
+
+  /// @brief Keep the given queries synchronized and fetch their data, for
+  /// example to warm up the local cache when the app starts.
+  ///
+  /// Calls Query::SetKeepSynchronized(true) on every query and requests all
+  /// of them from the server at once, in the order given, so the first queries
+  /// in the list are the first to be sent and answered. If persistence is
+  /// enabled, the data is written to disk as it arrives.
+  ///
+  /// @param[in] queries The queries to warm up, in order of priority.
+  ///
+  /// @returns A Future that completes once the data for every query is
+  /// available locally. Its result holds the approximate size, in bytes, of
+  /// the data loaded for each query, in the same order as `queries`. If any
+  /// query fails, the Future completes with that query's error and the sizes
+  /// of the queries that did load.
+  Future<std::vector<size_t>> WarmUp(const std::vector<Query>& queries);
+
+  /// @brief Get the result of the most recent call to WarmUp().
+  ///
+  /// @returns The result of the most recent call to WarmUp().
+  Future<std::vector<size_t>> WarmUpLastResult();
+
   /// Set the log verbosity of this Database instance.
   ///
   /// The log filtering is cumulative with Firebase App. That is, this library's
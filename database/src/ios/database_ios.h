@@ -89,6 +89,12 @@ class DatabaseInternal {
   // Sets whether pending write data will persist between application exits.
   void SetPersistenceEnabled(bool enabled);
 
+  // Not supported on iOS, which manages its own disk cache.
+  void SetPersistenceSyncEnabled(bool enabled);
+
+  // Not supported on iOS, which manages its own connections.
+  void SetSharedConnectionEnabled(bool enabled);
+
   // Set the logging verbosity.
   // The iOS implementation only enables logging for kLogLevelVerbose &
   // kLogLevelDebug, logging is disabled in for all other levels.
@@ -111,6 +111,18 @@ void DatabaseInternal::SetPersistenceEnabled(bool enabled) {
   }
 }
 
+void DatabaseInternal::SetPersistenceSyncEnabled(bool enabled) {
+  if (enabled) {
+    logger_.LogWarning("Synced persistence is not supported on iOS.");
+  }
+}
+
+void DatabaseInternal::SetSharedConnectionEnabled(bool enabled) {
+  if (enabled) {
+    logger_.LogWarning("Shared connections are not supported on iOS.");
+  }
+}
+
 void DatabaseInternal::set_log_level(LogLevel log_level) {
   // iOS FIRDatabase only supports logging or not logging.  Since the default logging level (Info)
   // should be quiet except for notices that can be resolved by the developer fixing their code,
@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "database/src/desktop/connection/web_socket_client_simulated.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using ::testing::ElementsAre;
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace connection {
+
+// Stands in for a websocket connected to an echo server.
+class LoopbackClient : public WebSocketClientInterface {
+ public:
+  explicit LoopbackClient(WebSocketClientEventHandler* handler)
+      : handler_(handler) {}
+
+  void Connect(int timeout_ms) override { handler_->OnOpen(); }
+  void Close() override { handler_->OnClose(); }
+  void Send(const char* msg) override { handler_->OnMessage(msg); }
+
+ private:
+  WebSocketClientEventHandler* handler_;
+};
+
+// Records the events it receives.
+class RecordingHandler : public WebSocketClientEventHandler {
+ public:
+  RecordingHandler() : received_(0) {}
+
+  void OnOpen() override { Record("open"); }
+  void OnMessage(const char* msg) override { Record(msg); }
+  void OnClose() override { Record("close"); }
+  void OnError(const WebSocketClientErrorData& error_data) override {
+    Record("error " + error_data.GetUri());
+  }
+
+  // Waits for `count` more events.
+  bool WaitFor(int count) {
+    for (int i = 0; i < count; ++i) {
+      if (!received_.TimedWait(5000)) return false;
+    }
+    return true;
+  }
+
+  std::vector<std::string> events() {
+    MutexLock lock(mutex_);
+    return events_;
+  }
+
+ private:
+  void Record(const std::string& event) {
+    {
+      MutexLock lock(mutex_);
+      events_.push_back(event);
+    }
+    received_.Post();
+  }
+
+  Mutex mutex_;
+  std::vector<std::string> events_;
+  Semaphore received_;
+};
+
+class WebSocketClientSimulatedTest : public ::testing::Test {
+ protected:
+  void CreateClient(const rest::NetworkConditions& conditions) {
+    network_.reset(new rest::NetworkSimulator(conditions));
+    client_.reset(new WebSocketClientSimulated(network_.get(), "ws://sim",
+                                               &scheduler_, &handler_));
+    client_->set_client(MakeUnique<LoopbackClient>(client_.get()));
+  }
+
+  scheduler::Scheduler scheduler_;
+  RecordingHandler handler_;
+  std::unique_ptr<rest::NetworkSimulator> network_;
+  std::unique_ptr<WebSocketClientSimulated> client_;
+};
+
+TEST_F(WebSocketClientSimulatedTest, DeliversEventsInOrder) {
+  rest::NetworkConditions conditions;
+  conditions.latency_ms = 10;
+  conditions.distribution = rest::kLatencyUniform;
+  conditions.jitter_ms = 10;
+  CreateClient(conditions);
+
+  client_->Connect(1000);
+  client_->Send("1");
+  client_->Send("2");
+  client_->Send("3");
+  client_->Close();
+  ASSERT_TRUE(handler_.WaitFor(5));
+  EXPECT_THAT(handler_.events(), ElementsAre("open", "1", "2", "3", "close"));
+}
+
+TEST_F(WebSocketClientSimulatedTest, FailedConnectReportsError) {
+  rest::NetworkConditions conditions;
+  conditions.failure_rate = 1.0;
+  CreateClient(conditions);
+
+  client_->Connect(1000);
+  ASSERT_TRUE(handler_.WaitFor(1));
+  EXPECT_THAT(handler_.events(), ElementsAre("error ws://sim"));
+}
+
+TEST_F(WebSocketClientSimulatedTest, FailedMessageDropsConnection) {
+  rest::NetworkConditions conditions;
+  CreateClient(conditions);
+  client_->Connect(1000);
+  ASSERT_TRUE(handler_.WaitFor(1));
+
+  conditions.failure_rate = 1.0;
+  network_->SetConditions(conditions);
+  client_->Send("lost");
+  ASSERT_TRUE(handler_.WaitFor(1));
+  EXPECT_THAT(handler_.events(), ElementsAre("open", "close"));
+}
+
+}  // namespace connection
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
@@ -64,6 +64,13 @@ TEST(LRUCachePolicy, GetPercentOfQueriesToPruneAtOnce) {
   EXPECT_EQ(cache_policy.GetPercentOfQueriesToPruneAtOnce(), .2);
 }
 
+TEST(LRUCachePolicy, GetMaxSizeBytes) {
+  const uint64_t kMaxSizeBytes = 1000;
+  LRUCachePolicy cache_policy(kMaxSizeBytes);
+
+  EXPECT_EQ(cache_policy.GetMaxSizeBytes(), kMaxSizeBytes);
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace database
@@ -277,7 +277,7 @@ void SyncTreeTest::RunTest(const test_data::TestCase* test_spec,
         ASSERT_NE(event_registration, nullptr);
         std::vector<Event> actual = sync_tree_->RemoveEventRegistration(
             event_registration->query_spec(),
-            static_cast<void*>(event_registration), kErrorNone);
+            static_cast<void*>(event_registration), nullptr, kErrorNone);
         EXPECT_THAT(actual, Pointwise(EventEq(), expected));
         break;
       }
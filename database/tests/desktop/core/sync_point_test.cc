@@ -189,7 +189,7 @@ TEST_F(SyncPointTest, RemoveEventRegistration_FromCompleteView) {
   // ...And then remove one of them.
   std::vector<QuerySpec> removed_specs;
   sync_point_.RemoveEventRegistration(another_query_spec, &another_listener,
-                                      kErrorNone, &removed_specs);
+                                      nullptr, kErrorNone, &removed_specs);
 
   // There should be no incomplete views.
   std::vector<const View*> view_results = sync_point_.GetIncompleteQueryViews();
@@ -249,7 +249,7 @@ TEST_F(SyncPointTest, RemoveEventRegistration_FromIncompleteView) {
   // ...And then remove one of them.
   std::vector<QuerySpec> removed_specs;
   sync_point_.RemoveEventRegistration(another_query_spec, &another_listener,
-                                      kErrorNone, &removed_specs);
+                                      nullptr, kErrorNone, &removed_specs);
 
   // There should be one incomplete view remaining.
   std::vector<const View*> view_results = sync_point_.GetIncompleteQueryViews();
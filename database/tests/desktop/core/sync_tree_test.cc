@@ -696,30 +696,30 @@ TEST_F(SyncTreeTest, RemoveEventRegistration) {
   // This will not cause any calls to StopListening because the listener
   // is listening on aaa and redirecting changes to this location internally.
   EXPECT_CALL(*persistence_manager_, SetQueryInactive(query_spec1)).Times(2);
-  results =
-      sync_tree_->RemoveEventRegistration(query_spec1, &listener1, kErrorNone);
+  results = sync_tree_->RemoveEventRegistration(query_spec1, &listener1,
+                                                nullptr, kErrorNone);
   EXPECT_EQ(results, std::vector<Event>{});
-  results =
-      sync_tree_->RemoveEventRegistration(query_spec1, &listener2, kErrorNone);
+  results = sync_tree_->RemoveEventRegistration(query_spec1, &listener2,
+                                                nullptr, kErrorNone);
   EXPECT_EQ(results, std::vector<Event>{});
 
   // Expect nothing to happen.
   results = sync_tree_->RemoveEventRegistration(
-      query_spec1, &unassigned_listener, kErrorNone);
+      query_spec1, &unassigned_listener, nullptr, kErrorNone);
   EXPECT_EQ(results, std::vector<Event>{});
 
   // This will cause the ListenProvider to stop listening on aaa because it is
   // the rootmost listener on this location.
   EXPECT_CALL(*persistence_manager_, SetQueryInactive(query_spec3));
   EXPECT_CALL(*listen_provider_, StopListening(query_spec3, Tag()));
-  results =
-      sync_tree_->RemoveEventRegistration(query_spec3, &listener3, kErrorNone);
+  results = sync_tree_->RemoveEventRegistration(query_spec3, &listener3,
+                                                nullptr, kErrorNone);
   EXPECT_EQ(results, std::vector<Event>{});
 
   // In the case of an error, no explicit call to StopListening is made. This
   // is expected. However, we will stop tracking the query.
   EXPECT_CALL(*persistence_manager_, SetQueryInactive(query_spec4));
-  results = sync_tree_->RemoveEventRegistration(query_spec4, nullptr,
+  results = sync_tree_->RemoveEventRegistration(query_spec4, nullptr, nullptr,
                                                 kErrorExpiredToken);
 
   // I have to manually construct this because normally constructing an 'error'
@@ -746,8 +746,8 @@ TEST_F(SyncTreeDeathTest, RemoveEventRegistration) {
       new ChildEventRegistration(nullptr, &listener, query_spec);
   sync_tree_->AddEventRegistration(
       UniquePtr<ChildEventRegistration>(event_registration));
-  EXPECT_DEATH(sync_tree_->RemoveEventRegistration(query_spec, &listener,
-                                                   kErrorExpiredToken),
+  EXPECT_DEATH(sync_tree_->RemoveEventRegistration(
+                   query_spec, &listener, nullptr, kErrorExpiredToken),
                DEATHTEST_SIGABRT);
 }
 
@@ -403,6 +403,114 @@ TEST_F(TrackedQueryManagerTest, CountOfPrunableQueries) {
   EXPECT_EQ(manager_->CountOfPrunableQueries(), 2);
 }
 
+TEST(TrackedQueryManager, PruneLeastRecentlyUsedQueries) {
+  NiceMock<MockPersistenceStorageEngine> storage_engine;
+  SystemLogger logger;
+  ON_CALL(storage_engine, LoadTrackedQueries())
+      .WillByDefault(Return(std::vector<TrackedQuery>{
+          TrackedQuery(100, QuerySpec(Path("ccc")), 3,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(200, QuerySpec(Path("aaa")), 1,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(300, QuerySpec(Path("bbb")), 2,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(400, QuerySpec(Path("ddd")), 0,
+                       TrackedQuery::kComplete, TrackedQuery::kActive),
+      }));
+  ON_CALL(storage_engine, ServerCacheEstimatedSizeInBytes(Path("aaa")))
+      .WillByDefault(Return(10));
+  ON_CALL(storage_engine, ServerCacheEstimatedSizeInBytes(Path("bbb")))
+      .WillByDefault(Return(20));
+  ON_CALL(storage_engine, ServerCacheEstimatedSizeInBytes(Path("ccc")))
+      .WillByDefault(Return(30));
+  TrackedQueryManager manager(&storage_engine, &logger);
+  manager.StartPruningLeastRecentlyUsedQueries();
+
+  // The least recently used queries are pruned until enough bytes are freed.
+  uint64_t bytes_freed = 0;
+  PruneForest result =
+      manager.PruneLeastRecentlyUsedQueries(0, 25, 50, &bytes_freed);
+  PruneForest expected;
+  PruneForestRef expected_ref(&expected);
+  expected_ref.Prune(Path("aaa"));
+  expected_ref.Prune(Path("bbb"));
+  EXPECT_EQ(PruneForestRef(&result), expected_ref);
+  EXPECT_EQ(bytes_freed, 30);
+  EXPECT_EQ(manager.CountOfPrunableQueries(), 1);
+
+  // No more than max_count queries are pruned.
+  result = manager.PruneLeastRecentlyUsedQueries(5, 1000, 0, &bytes_freed);
+  EXPECT_FALSE(PruneForestRef(&result).PrunesAnything());
+  EXPECT_EQ(bytes_freed, 0);
+  EXPECT_EQ(manager.CountOfPrunableQueries(), 1);
+}
+
+TEST(TrackedQueryManager, PruneLeastRecentlyUsedQueriesKeepsRelatedQueries) {
+  NiceMock<MockPersistenceStorageEngine> storage_engine;
+  SystemLogger logger;
+  ON_CALL(storage_engine, LoadTrackedQueries())
+      .WillByDefault(Return(std::vector<TrackedQuery>{
+          TrackedQuery(100, QuerySpec(Path("aaa/bbb")), 1,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(200, QuerySpec(Path("xxx/yyy")), 2,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(300, QuerySpec(Path("aaa/bbb/ccc")), 0,
+                       TrackedQuery::kComplete, TrackedQuery::kActive),
+          TrackedQuery(400, QuerySpec(Path("xxx")), 0,
+                       TrackedQuery::kComplete, TrackedQuery::kActive),
+          TrackedQuery(500, QuerySpec(Path("zzz")), 0,
+                       TrackedQuery::kComplete, TrackedQuery::kActive),
+      }));
+  TrackedQueryManager manager(&storage_engine, &logger);
+  manager.StartPruningLeastRecentlyUsedQueries();
+
+  // Only the queries below or above the pruned ones are kept.
+  PruneForest result = manager.PruneLeastRecentlyUsedQueries(2, 0, 50, nullptr);
+  PruneForest expected;
+  PruneForestRef expected_ref(&expected);
+  expected_ref.Prune(Path("aaa/bbb"));
+  expected_ref.Prune(Path("xxx/yyy"));
+  expected_ref.Keep(Path("aaa/bbb/ccc"));
+  expected_ref.Keep(Path("xxx"));
+  EXPECT_EQ(PruneForestRef(&result), expected_ref);
+}
+
+TEST(TrackedQueryManager, PruneLeastRecentlyUsedQueriesContinuesThePass) {
+  NiceMock<MockPersistenceStorageEngine> storage_engine;
+  SystemLogger logger;
+  ON_CALL(storage_engine, LoadTrackedQueries())
+      .WillByDefault(Return(std::vector<TrackedQuery>{
+          TrackedQuery(100, QuerySpec(Path("aaa")), 1,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(200, QuerySpec(Path("bbb")), 2,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+          TrackedQuery(300, QuerySpec(Path("ccc")), 3,
+                       TrackedQuery::kComplete, TrackedQuery::kInactive),
+      }));
+  TrackedQueryManager manager(&storage_engine, &logger);
+  manager.StartPruningLeastRecentlyUsedQueries();
+
+  PruneForest result = manager.PruneLeastRecentlyUsedQueries(1, 0, 50, nullptr);
+  PruneForest expected;
+  PruneForestRef expected_ref(&expected);
+  expected_ref.Prune(Path("aaa"));
+  EXPECT_EQ(PruneForestRef(&result), expected_ref);
+
+  // A query used since the pass started is skipped, and the next step carries
+  // on from where the last one stopped.
+  manager.SetQueryActiveFlag(QuerySpec(Path("bbb")), TrackedQuery::kActive);
+  manager.SetQueryActiveFlag(QuerySpec(Path("bbb")), TrackedQuery::kInactive);
+  result = manager.PruneLeastRecentlyUsedQueries(1, 0, 50, nullptr);
+  expected = PruneForest();
+  expected_ref.Prune(Path("ccc"));
+  EXPECT_EQ(PruneForestRef(&result), expected_ref);
+
+  // Once the pass has run out of queries, nothing more is pruned.
+  result = manager.PruneLeastRecentlyUsedQueries(1, 0, 50, nullptr);
+  EXPECT_FALSE(PruneForestRef(&result).PrunesAnything());
+  EXPECT_EQ(manager.CountOfPrunableQueries(), 1);
+}
+
 }  // namespace internal
 }  // namespace database
 }  // namespace firebase
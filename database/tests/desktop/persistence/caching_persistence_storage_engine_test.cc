@@ -0,0 +1,147 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "database/src/desktop/persistence/caching_persistence_storage_engine.h"
+
+#include "app/src/logger.h"
+#include "database/tests/desktop/test/mock_persistence_storage_engine.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::Test;
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace {
+
+class CachingPersistenceStorageEngineTest : public Test {
+ public:
+  void SetUp() override { CreateEngine(1024 * 1024); }
+
+  void TearDown() override { delete engine_; }
+
+ protected:
+  void CreateEngine(size_t max_cached_bytes) {
+    storage_engine_ = new NiceMock<MockPersistenceStorageEngine>();
+    UniquePtr<PersistenceStorageEngine> storage_engine_ptr(storage_engine_);
+    engine_ = new CachingPersistenceStorageEngine(
+        std::move(storage_engine_ptr), max_cached_bytes, &logger_);
+  }
+
+  MockPersistenceStorageEngine* storage_engine_;
+  SystemLogger logger_;
+
+  CachingPersistenceStorageEngine* engine_;
+};
+
+TEST_F(CachingPersistenceStorageEngineTest, RepeatedReadsHitMemory) {
+  Variant data = std::map<Variant, Variant>{std::make_pair("bbb", 100)};
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("aaa")))
+      .Times(1)
+      .WillOnce(Return(data));
+
+  EXPECT_EQ(engine_->ServerCache(Path("aaa")), data);
+  EXPECT_EQ(engine_->ServerCache(Path("aaa")), data);
+  EXPECT_EQ(engine_->miss_count(), 1u);
+  EXPECT_EQ(engine_->hit_count(), 1u);
+  EXPECT_GT(engine_->cached_bytes(), 0u);
+}
+
+TEST_F(CachingPersistenceStorageEngineTest, ChildReadsHitAncestor) {
+  Variant data = std::map<Variant, Variant>{std::make_pair("bbb", 100)};
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("aaa")))
+      .WillOnce(Return(data));
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("aaa/bbb"))).Times(0);
+
+  engine_->ServerCache(Path("aaa"));
+  EXPECT_EQ(engine_->ServerCache(Path("aaa/bbb")), Variant(100));
+  EXPECT_EQ(engine_->hit_count(), 1u);
+}
+
+TEST_F(CachingPersistenceStorageEngineTest, WritesInvalidateOverlappingData) {
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("aaa")))
+      .WillOnce(Return(Variant(1)))
+      .WillOnce(Return(Variant(2)))
+      .WillOnce(Return(Variant(3)));
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("zzz")))
+      .WillOnce(Return(Variant(4)));
+
+  EXPECT_EQ(engine_->ServerCache(Path("aaa")), Variant(1));
+  EXPECT_EQ(engine_->ServerCache(Path("zzz")), Variant(4));
+
+  // A write below the cached location.
+  engine_->OverwriteServerCache(Path("aaa/bbb"), Variant(2));
+  EXPECT_EQ(engine_->ServerCache(Path("aaa")), Variant(2));
+
+  // A write above the cached location.
+  engine_->MergeIntoServerCache(Path(), CompoundWrite());
+  EXPECT_EQ(engine_->ServerCache(Path("aaa")), Variant(3));
+
+  EXPECT_EQ(engine_->miss_count(), 4u);
+}
+
+TEST_F(CachingPersistenceStorageEngineTest, UnrelatedWritesKeepData) {
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("aaa/bbb")))
+      .WillOnce(Return(Variant(1)));
+
+  engine_->ServerCache(Path("aaa/bbb"));
+  engine_->OverwriteServerCache(Path("aaa/bbbb"), Variant(2));
+  engine_->OverwriteServerCache(Path("aaa/ccc"), Variant(3));
+  EXPECT_EQ(engine_->ServerCache(Path("aaa/bbb")), Variant(1));
+  EXPECT_EQ(engine_->hit_count(), 1u);
+}
+
+TEST_F(CachingPersistenceStorageEngineTest, EvictsLeastRecentlyUsed) {
+  delete engine_;
+  // Enough room for two small leaves but not three.
+  CreateEngine(sizeof(Variant) * 2);
+
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("aaa")))
+      .WillOnce(Return(Variant(1)));
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("bbb")))
+      .Times(2)
+      .WillRepeatedly(Return(Variant(2)));
+  EXPECT_CALL(*storage_engine_, ServerCache(Path("ccc")))
+      .WillOnce(Return(Variant(3)));
+
+  engine_->ServerCache(Path("aaa"));
+  engine_->ServerCache(Path("bbb"));
+  engine_->ServerCache(Path("aaa"));
+  // Evicts bbb, which was used least recently.
+  engine_->ServerCache(Path("ccc"));
+  engine_->ServerCache(Path("bbb"));
+  EXPECT_EQ(engine_->hit_count(), 1u);
+  EXPECT_EQ(engine_->miss_count(), 4u);
+}
+
+TEST_F(CachingPersistenceStorageEngineTest, ForwardsTransactions) {
+  EXPECT_CALL(*storage_engine_, BeginTransaction()).WillOnce(Return(true));
+  EXPECT_CALL(*storage_engine_, SetTransactionSuccessful());
+  EXPECT_CALL(*storage_engine_, EndTransaction());
+  EXPECT_CALL(*storage_engine_, Flush());
+
+  EXPECT_TRUE(engine_->BeginTransaction());
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  engine_->Flush();
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
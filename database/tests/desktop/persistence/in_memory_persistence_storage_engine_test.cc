@@ -297,6 +297,24 @@ TEST_F(InMemoryPersistenceStorageEngineTest, ServerCacheEstimatedSizeInBytes) {
             9 * sizeof(Variant) + 4 * kKeyLengths + 2 * kValueLengths);
 }
 
+TEST_F(InMemoryPersistenceStorageEngineTest,
+       ServerCacheEstimatedSizeInBytesAtPath) {
+  engine_.BeginTransaction();
+  engine_.OverwriteServerCache(Path("aaaa/bbbb"),
+                               Variant::FromMutableString("abcdefghijklm"));
+  engine_.OverwriteServerCache(Path("cccc/dddd"),
+                               Variant::FromMutableString("nopqrstuvwxyz"));
+  engine_.SetTransactionSuccessful();
+  engine_.EndTransaction();
+
+  EXPECT_EQ(engine_.ServerCacheEstimatedSizeInBytes(Path("aaaa")),
+            engine_.ServerCacheEstimatedSizeInBytes(Path("cccc")));
+  EXPECT_LT(engine_.ServerCacheEstimatedSizeInBytes(Path("aaaa")),
+            engine_.ServerCacheEstimatedSizeInBytes());
+  EXPECT_EQ(engine_.ServerCacheEstimatedSizeInBytes(Path("eeee")),
+            sizeof(Variant));
+}
+
 // Disable DeathTest in Release mode because it depends on a crash
 // caused by `assert` which has no effect when NDEBUG is defined
 #ifdef NDEBUG
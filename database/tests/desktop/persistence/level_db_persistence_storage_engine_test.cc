@@ -397,6 +397,30 @@ TEST_F(LevelDbPersistenceStorageEngineTest, ServerCacheEstimatedSizeInBytes) {
   });
 }
 
+TEST_F(LevelDbPersistenceStorageEngineTest,
+       ServerCacheEstimatedSizeInBytesAtPath) {
+  InitializeLevelDb(test_info_->name());
+
+  std::string long_string(1024, 'x');
+
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa/bbb"), long_string);
+  engine_->OverwriteServerCache(Path("aaa/ccc"), long_string);
+  engine_->OverwriteServerCache(Path("aaab"), long_string);
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  RunTwice([this]() {
+    // Only the data at and below the path is counted, not data at sibling
+    // paths that share a prefix with it.
+    EXPECT_NEAR(engine_->ServerCacheEstimatedSizeInBytes(Path("aaa")),
+                2 * (1024 + strlen("aaa/bbb")), 32);
+    EXPECT_NEAR(engine_->ServerCacheEstimatedSizeInBytes(Path("aaa/bbb")),
+                1024 + strlen("aaa/bbb"), 16);
+    EXPECT_EQ(engine_->ServerCacheEstimatedSizeInBytes(Path("zzz")), 0);
+  });
+}
+
 TEST_F(LevelDbPersistenceStorageEngineTest, SaveTrackedQuery) {
   InitializeLevelDb(test_info_->name());
 
@@ -543,6 +567,149 @@ TEST_F(LevelDbPersistenceStorageEngineTest, UpdateTrackedQueryKeys) {
   });
 }
 
+TEST_F(LevelDbPersistenceStorageEngineTest, UpdateTrackedQueryKeysChangesKeys) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->SaveTrackedQueryKeys(100,
+                                std::set<std::string>{"key1", "key2", "key3"});
+  engine_->UpdateTrackedQueryKeys(100, std::set<std::string>{"key4"},
+                                  std::set<std::string>{"key1", "key3"});
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  RunTwice([this]() {
+    std::set<std::string> result = engine_->LoadTrackedQueryKeys(100);
+    std::set<std::string> expected{"key2", "key4"};
+    EXPECT_THAT(result, Pointwise(Eq(), expected));
+  });
+}
+
+TEST_F(LevelDbPersistenceStorageEngineTest,
+       SaveTrackedQueryKeysReplacesUpdates) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->SaveTrackedQueryKeys(100, std::set<std::string>{"key1", "key2"});
+  engine_->UpdateTrackedQueryKeys(100, std::set<std::string>{"key3"},
+                                  std::set<std::string>{"key1"});
+  engine_->SaveTrackedQueryKeys(100, std::set<std::string>{"key5"});
+  // A key that is both added and removed ends up added.
+  engine_->UpdateTrackedQueryKeys(100, std::set<std::string>{"key1", "key6"},
+                                  std::set<std::string>{"key5", "key6"});
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  RunTwice([this]() {
+    std::set<std::string> result = engine_->LoadTrackedQueryKeys(100);
+    std::set<std::string> expected{"key1", "key6"};
+    EXPECT_THAT(result, Pointwise(Eq(), expected));
+  });
+}
+
+TEST_F(LevelDbPersistenceStorageEngineTest, LoadUserWritesInIdOrder) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->SaveUserOverwrite(Path("aaa"), Variant(10), 10);
+  engine_->SaveUserOverwrite(Path("aaa"), Variant(9), 9);
+  engine_->SaveUserOverwrite(Path("aaa"), Variant(256), 256);
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  RunTwice([this]() {
+    std::vector<UserWriteRecord> result = engine_->LoadUserWrites();
+    std::vector<UserWriteRecord> expected{
+        UserWriteRecord(9, Path("aaa"), Variant(9), true),
+        UserWriteRecord(10, Path("aaa"), Variant(10), true),
+        UserWriteRecord(256, Path("aaa"), Variant(256), true)};
+    EXPECT_THAT(result, Pointwise(Eq(), expected));
+  });
+}
+
+TEST_F(LevelDbPersistenceStorageEngineTest, DeleteTrackedQueryKeepsOtherIds) {
+  InitializeLevelDb(test_info_->name());
+
+  TrackedQuery tracked_query_a(1, QuerySpec(Path("aaa")), 1234,
+                               TrackedQuery::kComplete, TrackedQuery::kActive);
+  TrackedQuery tracked_query_b(10, QuerySpec(Path("bbb")), 5678,
+                               TrackedQuery::kComplete, TrackedQuery::kActive);
+
+  engine_->BeginTransaction();
+  engine_->SaveTrackedQuery(tracked_query_a);
+  engine_->SaveTrackedQuery(tracked_query_b);
+  engine_->DeleteTrackedQuery(1);
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  RunTwice([this, &tracked_query_b]() {
+    std::vector<TrackedQuery> result = engine_->LoadTrackedQueries();
+    std::vector<TrackedQuery> expected{tracked_query_b};
+    EXPECT_THAT(result, Pointwise(Eq(), expected));
+  });
+}
+
+TEST_F(LevelDbPersistenceStorageEngineTest, MigratesSchemaVersion1) {
+  database_path_ = GetTestTmpDir(test_info_->name());
+
+  // Write records the way schema version 1 laid them out.
+  {
+    leveldb::Options options;
+    options.create_if_missing = true;
+    leveldb::DestroyDB(database_path_, options);
+    leveldb::DB* database;
+    ASSERT_TRUE(leveldb::DB::Open(options, database_path_, &database).ok());
+    leveldb::WriteBatch batch;
+
+    flatbuffers::FlatBufferBuilder builder;
+    builder.Finish(FlatbufferFromUserWriteRecord(
+        &builder, UserWriteRecord(10, Path("aaa"), Variant(10), true)));
+    batch.Put("$user_write_records/10/",
+              leveldb::Slice(
+                  reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                  builder.GetSize()));
+    builder.Clear();
+    builder.Finish(FlatbufferFromUserWriteRecord(
+        &builder, UserWriteRecord(9, Path("aaa"), Variant(9), true)));
+    batch.Put("$user_write_records/9/",
+              leveldb::Slice(
+                  reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                  builder.GetSize()));
+    builder.Clear();
+    builder.Finish(FlatbufferFromTrackedQuery(
+        &builder,
+        TrackedQuery(5, QuerySpec(Path("bbb")), 1234, TrackedQuery::kComplete,
+                     TrackedQuery::kActive)));
+    batch.Put("$tracked_queries/5/",
+              leveldb::Slice(
+                  reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                  builder.GetSize()));
+    batch.Put("$tracked_query_keys/5/key1", "key1");
+    batch.Put("$tracked_query_keys/5/key2", "key2");
+    ASSERT_TRUE(database->Write(leveldb::WriteOptions(), &batch).ok());
+    delete database;
+  }
+
+  ASSERT_TRUE(engine_->Initialize(database_path_));
+  RunTwice([this]() {
+    std::vector<UserWriteRecord> user_writes = engine_->LoadUserWrites();
+    std::vector<UserWriteRecord> expected_user_writes{
+        UserWriteRecord(9, Path("aaa"), Variant(9), true),
+        UserWriteRecord(10, Path("aaa"), Variant(10), true)};
+    EXPECT_THAT(user_writes, Pointwise(Eq(), expected_user_writes));
+
+    std::vector<TrackedQuery> tracked_queries = engine_->LoadTrackedQueries();
+    std::vector<TrackedQuery> expected_tracked_queries{
+        TrackedQuery(5, QuerySpec(Path("bbb")), 1234, TrackedQuery::kComplete,
+                     TrackedQuery::kActive)};
+    EXPECT_THAT(tracked_queries, Pointwise(Eq(), expected_tracked_queries));
+
+    std::set<std::string> keys = engine_->LoadTrackedQueryKeys(5);
+    std::set<std::string> expected_keys{"key1", "key2"};
+    EXPECT_THAT(keys, Pointwise(Eq(), expected_keys));
+  });
+}
+
 TEST_F(LevelDbPersistenceStorageEngineTest, PruneCache) {
   InitializeLevelDb(test_info_->name());
 
@@ -591,6 +758,44 @@ TEST_F(LevelDbPersistenceStorageEngineTest, PruneCache) {
   });
 }
 
+TEST_F(LevelDbPersistenceStorageEngineTest, PruneCacheAtRoot) {
+  InitializeLevelDb(test_info_->name());
+
+  // clang-format off
+  Variant initial_data = std::map<Variant, Variant>{
+          std::make_pair("delete_me", std::map<Variant, Variant>{
+              std::make_pair("but_keep_me", 111),
+              std::make_pair("ill_be_gone", 222),
+          }),
+          std::make_pair("keep_me", 333),
+      };
+  // clang-format on
+
+  PruneForest prune_forest;
+  PruneForestRef prune_forest_ref(&prune_forest);
+  prune_forest_ref.Prune(Path("delete_me"));
+  prune_forest_ref.Keep(Path("delete_me/but_keep_me"));
+
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path(), initial_data);
+  engine_->PruneCache(Path(), prune_forest_ref);
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  RunTwice([this]() {
+    Variant result = engine_->ServerCache(Path());
+    // clang-format off
+    Variant expected = std::map<Variant, Variant>{
+            std::make_pair("delete_me", std::map<Variant, Variant>{
+                std::make_pair("but_keep_me", 111),
+            }),
+            std::make_pair("keep_me", 333),
+        };
+    // clang-format on
+    EXPECT_EQ(result, expected);
+  });
+}
+
 TEST_F(LevelDbPersistenceStorageEngineTest, BeginTransaction) {
   // BeginTransaction should return true, indicating success.
   EXPECT_TRUE(engine_->BeginTransaction());
@@ -601,6 +806,144 @@ TEST_F(LevelDbPersistenceStorageEngineTest, EndTransaction) {
   engine_->EndTransaction();
 }
 
+TEST_F(LevelDbPersistenceStorageEngineTest, EndTransactionCommitsByDefault) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa/bbb"), Variant("some value"));
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  EXPECT_EQ(engine_->pending_bytes(), 0u);
+}
+
+// Uses a group commit policy that never commits on its own, so that writes
+// only reach LevelDB when flushed.
+class LevelDbPersistenceStorageEngineGroupCommitTest
+    : public LevelDbPersistenceStorageEngineTest {
+ protected:
+  void SetUp() override {
+    GroupCommitOptions options;
+    options.max_pending_bytes = 1024 * 1024;
+    options.max_pending_milliseconds = 60 * 60 * 1000;
+    engine_ = new LevelDbPersistenceStorageEngine(&logger_, options);
+  }
+};
+
+TEST_F(LevelDbPersistenceStorageEngineGroupCommitTest, GroupsTransactions) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa/bbb"), Variant("some value"));
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  size_t first_pending_bytes = engine_->pending_bytes();
+  EXPECT_GT(first_pending_bytes, 0u);
+
+  engine_->BeginTransaction();
+  engine_->SaveUserOverwrite(Path("ccc"), Variant("user value"), 100);
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  EXPECT_GT(engine_->pending_bytes(), first_pending_bytes);
+
+  engine_->Flush();
+  EXPECT_EQ(engine_->pending_bytes(), 0u);
+
+  // Deleting the engine commits anything still pending, so the data must
+  // survive a restart.
+  RunTwice([this]() {
+    EXPECT_EQ(engine_->ServerCache(Path("aaa/bbb")), Variant("some value"));
+    std::vector<UserWriteRecord> expected{
+        UserWriteRecord(100, Path("ccc"), "user value", true)};
+    EXPECT_THAT(engine_->LoadUserWrites(), Pointwise(Eq(), expected));
+  });
+}
+
+TEST_F(LevelDbPersistenceStorageEngineGroupCommitTest,
+       OverwriteRemovesPendingChildren) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa/bbb"), Variant("some value"));
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+
+  // aaa/bbb has not been committed yet, but overwriting aaa must still remove
+  // it.
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa/ccc"), Variant("other value"));
+  engine_->OverwriteServerCache(Path("aaa"),
+                                std::map<Variant, Variant>{
+                                    std::make_pair("ddd", "new value"),
+                                });
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  EXPECT_GT(engine_->pending_bytes(), 0u);
+
+  RunTwice([this]() {
+    Variant expected = std::map<Variant, Variant>{
+        std::make_pair("ddd", "new value"),
+    };
+    EXPECT_EQ(engine_->ServerCache(Path("aaa")), expected);
+  });
+}
+
+TEST_F(LevelDbPersistenceStorageEngineGroupCommitTest,
+       ServerCacheEstimatedSizeInBytesCountsPendingServerCacheWrites) {
+  InitializeLevelDb(test_info_->name());
+
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa"), std::string(1024, 'x'));
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  engine_->Flush();
+
+  // The pending write replaces the committed one, and user writes are not part
+  // of the server cache.
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("aaa"), std::string(512, 'x'));
+  engine_->SaveUserOverwrite(Path("bbb"), std::string(4096, 'x'), 100);
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  EXPECT_GT(engine_->pending_bytes(), 0u);
+
+  uint64 expected = 512 + strlen("aaa");
+  EXPECT_NEAR(engine_->ServerCacheEstimatedSizeInBytes(), expected, 16);
+  engine_->Flush();
+  EXPECT_NEAR(engine_->ServerCacheEstimatedSizeInBytes(), expected, 16);
+}
+
+TEST_F(LevelDbPersistenceStorageEngineTest,
+       ReportsPendingWritesOncePerGroup) {
+  GroupCommitOptions options;
+  options.max_pending_bytes = 1024 * 1024;
+  options.max_pending_milliseconds = 60 * 60 * 1000;
+  int reports = 0;
+  options.pending_writes_callback = [](void* reports) {
+    ++*static_cast<int*>(reports);
+  };
+  options.pending_writes_callback_data = &reports;
+  delete engine_;
+  engine_ = new LevelDbPersistenceStorageEngine(&logger_, options);
+  InitializeLevelDb(test_info_->name());
+
+  for (int i = 0; i < 3; ++i) {
+    engine_->BeginTransaction();
+    engine_->OverwriteServerCache(Path("aaa"), Variant(i));
+    engine_->SetTransactionSuccessful();
+    engine_->EndTransaction();
+  }
+  EXPECT_EQ(reports, 1);
+
+  // Once flushed, the next write starts a new group.
+  engine_->Flush();
+  engine_->BeginTransaction();
+  engine_->OverwriteServerCache(Path("bbb"), Variant("value"));
+  engine_->SetTransactionSuccessful();
+  engine_->EndTransaction();
+  EXPECT_EQ(reports, 2);
+}
+
 // Many functions are designed to assert if called outside a transaction. Ensure
 // they crash as expected.
 using LevelDbPersistenceStorageEngineDeathTest =
@@ -21,8 +21,10 @@
 #include "gtest/gtest.h"
 
 using testing::_;
+using testing::DoAll;
 using testing::NiceMock;
 using testing::Return;
+using testing::SetArgPointee;
 using testing::StrictMock;
 using testing::Test;
 
@@ -365,6 +367,7 @@ TEST(PersistenceManager, DoPruneCheckAfterServerUpdate_DoNotCheckCacheSize) {
   EXPECT_CALL(*cache_policy, ShouldCheckCacheSize(_)).WillOnce(Return(false));
 
   manager.UpdateServerCache(QuerySpec(), Variant());
+  EXPECT_FALSE(manager.PruneCacheStep());
 }
 
 TEST(PersistenceManager, DoPruneCheckAfterServerUpdate_DoCheckCacheSize) {
@@ -387,12 +390,16 @@ TEST(PersistenceManager, DoPruneCheckAfterServerUpdate_DoCheckCacheSize) {
 
   // After the server cache is updated, DoPruneCheckAfterServerUpdate will be
   // called. It should call CachePolicy::ShouldCheckCacheSize once, and if it
-  // returns true, it will then check if it should prune anything. If
-  // CachePolicy::ShouldPrune returns false, nothing else will happen.
+  // returns true, the next PruneCacheStep will check if it should prune
+  // anything. If CachePolicy::ShouldPrune returns false, nothing else will
+  // happen.
   EXPECT_CALL(*cache_policy, ShouldCheckCacheSize(_)).WillOnce(Return(true));
   EXPECT_CALL(*cache_policy, ShouldPrune(_, _)).WillOnce(Return(false));
 
   manager.UpdateServerCache(QuerySpec(), Variant());
+  EXPECT_FALSE(manager.PruneCacheStep());
+  // The check is only done once.
+  EXPECT_FALSE(manager.PruneCacheStep());
 }
 
 TEST(PersistenceManager, DoPruneCheckAfterServerUpdate_PruneStuff) {
@@ -415,21 +422,83 @@ TEST(PersistenceManager, DoPruneCheckAfterServerUpdate_PruneStuff) {
 
   // After the server cache is updated, DoPruneCheckAfterServerUpdate will be
   // called. It should call CachePolicy::ShouldCheckCacheSize once, and if it
-  // returns true, it will then check if it should prune anything. If
-  // CachePolicy::ShouldPrune returns true, it will pass the prune tree to
-  // StorageEngine::PruneCache.
+  // returns true, the next PruneCacheStep will check if it should prune
+  // anything. If CachePolicy::ShouldPrune returns true, it will prune enough
+  // queries to get the cache under its maximum size, and pass the locations
+  // they pruned to StorageEngine::PruneCache.
   EXPECT_CALL(*cache_policy, ShouldCheckCacheSize(_)).WillOnce(Return(true));
-  EXPECT_CALL(*cache_policy, ShouldPrune(_, _))
-      .WillOnce(Return(true))
-      .WillOnce(Return(false));
+  EXPECT_CALL(*cache_policy, ShouldPrune(1100, _)).WillOnce(Return(true));
+  EXPECT_CALL(*cache_policy, GetMaxSizeBytes()).WillOnce(Return(100));
+  EXPECT_CALL(*storage_engine, ServerCacheEstimatedSizeInBytes())
+      .WillOnce(Return(1100));
+  EXPECT_CALL(*tracked_query_manager, CountOfQueriesToPrune(_))
+      .WillOnce(Return(2));
+  PruneForest prune_forest;
+  PruneForestRef prune_forest_ref(&prune_forest);
+  prune_forest_ref.Prune(Path("aaa/bbb"));
+  prune_forest_ref.Keep(Path("aaa/bbb/ccc"));
+  prune_forest_ref.Prune(Path("ddd"));
+  prune_forest_ref.Keep(Path("eee"));
+  EXPECT_CALL(*tracked_query_manager,
+              PruneLeastRecentlyUsedQueries(2, 1000, _, _))
+      .WillOnce(DoAll(SetArgPointee<3>(1000), Return(prune_forest)));
+  EXPECT_CALL(*storage_engine,
+              PruneCache(Path("aaa/bbb"),
+                         prune_forest_ref.GetChild(Path("aaa/bbb"))));
+  EXPECT_CALL(*storage_engine,
+              PruneCache(Path("ddd"), prune_forest_ref.GetChild(Path("ddd"))));
+
+  manager.UpdateServerCache(QuerySpec(), Variant());
+  EXPECT_FALSE(manager.PruneCacheStep());
+}
+
+TEST(PersistenceManager, PruneCacheStep_PrunesInBoundedSteps) {
+  MockPersistenceStorageEngine* storage_engine =
+      new NiceMock<MockPersistenceStorageEngine>();
+  UniquePtr<MockPersistenceStorageEngine> storage_engine_ptr(storage_engine);
+
+  MockTrackedQueryManager* tracked_query_manager =
+      new NiceMock<MockTrackedQueryManager>();
+  UniquePtr<MockTrackedQueryManager> tracked_query_manager_ptr(
+      tracked_query_manager);
+
+  MockCachePolicy* cache_policy = new StrictMock<MockCachePolicy>();
+  UniquePtr<MockCachePolicy> cache_policy_ptr(cache_policy);
+
+  SystemLogger logger;
+  PersistenceManager manager(std::move(storage_engine_ptr),
+                             std::move(tracked_query_manager_ptr),
+                             std::move(cache_policy_ptr), &logger);
+
+  // The cache size is only measured once, and each step prunes at most 50
+  // queries.
+  EXPECT_CALL(*cache_policy, ShouldCheckCacheSize(_)).WillOnce(Return(true));
+  EXPECT_CALL(*cache_policy, ShouldPrune(_, _)).WillOnce(Return(true));
+  EXPECT_CALL(*cache_policy, GetMaxSizeBytes()).WillOnce(Return(1000));
+  EXPECT_CALL(*storage_engine, ServerCacheEstimatedSizeInBytes())
+      .WillOnce(Return(1000));
+  EXPECT_CALL(*tracked_query_manager, CountOfQueriesToPrune(_))
+      .WillOnce(Return(120));
+  EXPECT_CALL(*tracked_query_manager, StartPruningLeastRecentlyUsedQueries())
+      .Times(1);
   PruneForest prune_forest;
   prune_forest.set_value(true);
-  EXPECT_CALL(*tracked_query_manager, PruneOldQueries(_))
+  EXPECT_CALL(*tracked_query_manager,
+              PruneLeastRecentlyUsedQueries(50, 0, 50, _))
+      .Times(2)
+      .WillRepeatedly(Return(prune_forest));
+  EXPECT_CALL(*tracked_query_manager,
+              PruneLeastRecentlyUsedQueries(20, 0, 50, _))
       .WillOnce(Return(prune_forest));
   EXPECT_CALL(*storage_engine,
-              PruneCache(Path(), PruneForestRef(&prune_forest)));
+              PruneCache(Path(), PruneForestRef(&prune_forest)))
+      .Times(3);
 
   manager.UpdateServerCache(QuerySpec(), Variant());
+  EXPECT_TRUE(manager.PruneCacheStep());
+  EXPECT_TRUE(manager.PruneCacheStep());
+  EXPECT_FALSE(manager.PruneCacheStep());
+  EXPECT_FALSE(manager.PruneCacheStep());
 }
 
 TEST_F(PersistenceManagerTest, RunInTransaction_StdFunctionSuccess) {
@@ -0,0 +1,484 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "database/tests/desktop/test/local_database_server.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "app/src/assert.h"
+#include "app/src/callback.h"
+#include "app/src/safe_reference.h"
+#include "app/src/time.h"
+#include "app/src/variant_util.h"
+#include "database/src/desktop/connection/util_connection.h"
+#include "database/src/desktop/connection/web_socket_client_simulated.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace connection {
+
+const size_t LocalDatabaseServer::kMaxFrameSize = 16384;
+
+namespace {
+
+// The server installed by LocalDatabaseServer::Install(), if any.
+LocalDatabaseServer* g_installed_server = nullptr;
+
+// Wraps a message in the envelope of a data message.
+std::string DataMessage(const Variant& data) {
+  Variant message = Variant::EmptyMap();
+  message.map()["t"] = "d";
+  message.map()["d"] = data;
+  return util::VariantToJson(message);
+}
+
+std::string WirePath(const Path& path) {
+  return path.empty() ? "/" : path.str();
+}
+
+const Variant& MapGet(const Variant& map, const char* key) {
+  static const Variant* null_variant = new Variant();
+  if (!map.is_map()) return *null_variant;
+  auto it = map.map().find(Variant(key));
+  return it == map.map().end() ? *null_variant : it->second;
+}
+
+// Returns the data at `path` under `root`, or a null Variant.
+Variant GetChild(const Variant& root, const Path& path) {
+  const Variant* node = &root;
+  for (const std::string& key : path.GetDirectories()) {
+    node = &MapGet(*node, key.c_str());
+  }
+  return *node;
+}
+
+// Writes `value` at keys[index..] under `node`. Writing null deletes the data,
+// along with the parents it leaves empty.
+void SetChild(Variant* node, const std::vector<std::string>& keys,
+              size_t index, const Variant& value) {
+  if (index == keys.size()) {
+    *node = value;
+    return;
+  }
+  if (!node->is_map()) {
+    if (value.is_null()) return;
+    *node = Variant::EmptyMap();
+  }
+  Variant key(keys[index]);
+  Variant& child = node->map()[key];
+  SetChild(&child, keys, index + 1, value);
+  if (child.is_null() || (child.is_map() && child.map().empty())) {
+    node->map().erase(key);
+  }
+}
+
+void SetChild(Variant* root, const Path& path, const Variant& value) {
+  SetChild(root, path.GetDirectories(), 0, value);
+  if (root->is_map() && root->map().empty()) *root = Variant::Null();
+}
+
+Variant OkResponse() {
+  Variant response = Variant::EmptyMap();
+  response.map()["s"] = "ok";
+  response.map()["d"] = Variant::EmptyMap();
+  return response;
+}
+
+}  // namespace
+
+// A websocket connected to a LocalDatabaseServer.
+class LocalDatabaseClient : public WebSocketClientInterface {
+ public:
+  LocalDatabaseClient(LocalDatabaseServer* server,
+                      scheduler::Scheduler* scheduler,
+                      WebSocketClientEventHandler* handler)
+      : server_(server),
+        scheduler_(scheduler),
+        handler_(handler),
+        connected_(false),
+        expected_frames_(0),
+        safe_this_(this) {}
+
+  ~LocalDatabaseClient() override {
+    safe_this_.ClearReference();
+    MutexLock lock(server_->mutex_);
+    if (connected_) server_->CloseLocked(this);
+  }
+
+  void Connect(int timeout_ms) override {
+    MutexLock lock(server_->mutex_);
+    if (!connected_) server_->OpenLocked(this);
+  }
+
+  void Close() override {
+    MutexLock lock(server_->mutex_);
+    if (connected_) server_->CloseLocked(this);
+  }
+
+  void Send(const char* msg) override {
+    MutexLock lock(server_->mutex_);
+    if (!connected_) return;
+
+    // Reassemble messages split into frames, like Connection does.
+    if (expected_frames_ > 0) {
+      incoming_buffer_ += msg;
+      if (--expected_frames_ == 0) {
+        server_->HandleRequestLocked(
+            this, util::JsonToVariant(incoming_buffer_.c_str()));
+        incoming_buffer_.clear();
+      }
+      return;
+    }
+    if (strlen(msg) <= 6) {
+      // A frame count, or "0" to keep the connection alive.
+      expected_frames_ = std::max(0, atoi(msg));  // NOLINT
+      return;
+    }
+    server_->HandleRequestLocked(this, util::JsonToVariant(msg));
+  }
+
+  bool connected() const { return connected_; }
+  void set_connected(bool connected) { connected_ = connected; }
+
+  // Sends a message to the handler, split into frames if it is too large.
+  void DeliverLocked(const std::string& message) {
+    size_t size = message.size();
+    if (size <= LocalDatabaseServer::kMaxFrameSize) {
+      ScheduleEvent(kMessage, message);
+      return;
+    }
+    size_t frames = (size + LocalDatabaseServer::kMaxFrameSize - 1) /
+                    LocalDatabaseServer::kMaxFrameSize;
+    std::stringstream frame_count;
+    frame_count << frames;
+    ScheduleEvent(kMessage, frame_count.str());
+    for (size_t i = 0; i < size; i += LocalDatabaseServer::kMaxFrameSize) {
+      ScheduleEvent(kMessage,
+                    message.substr(i, LocalDatabaseServer::kMaxFrameSize));
+    }
+  }
+
+  void OpenedLocked() { ScheduleEvent(kOpen, std::string()); }
+  void ClosedLocked() { ScheduleEvent(kClose, std::string()); }
+
+ private:
+  enum Event { kOpen, kMessage, kClose };
+
+  typedef firebase::internal::SafeReference<LocalDatabaseClient> ThisRef;
+  typedef firebase::internal::SafeReferenceLock<LocalDatabaseClient>
+      ThisRefLock;
+
+  // Calls the handler on the scheduler, in order.
+  void ScheduleEvent(Event event, const std::string& message) {
+    if (event == kMessage) server_->bytes_sent_ += message.size();
+    scheduler_->Schedule(callback::NewCallback(
+        [](ThisRef ref, Event event, std::string message) {
+          ThisRefLock lock(&ref);
+          LocalDatabaseClient* client = lock.GetReference();
+          if (client == nullptr || client->handler_ == nullptr) return;
+          switch (event) {
+            case kOpen:
+              client->handler_->OnOpen();
+              break;
+            case kMessage:
+              client->handler_->OnMessage(message.c_str());
+              break;
+            case kClose:
+              client->handler_->OnClose();
+              break;
+          }
+        },
+        safe_this_, event, message));
+  }
+
+  LocalDatabaseServer* server_;
+  scheduler::Scheduler* scheduler_;
+  WebSocketClientEventHandler* handler_;
+
+  // Guarded by the server's mutex.
+  bool connected_;
+  int expected_frames_;
+  std::string incoming_buffer_;
+
+  ThisRef safe_this_;
+};
+
+LocalDatabaseServer::LocalDatabaseServer()
+    : network_(nullptr),
+      installed_(false),
+      connections_accepted_(0),
+      requests_received_(0),
+      bytes_sent_(0) {}
+
+LocalDatabaseServer::~LocalDatabaseServer() {
+  MutexLock lock(mutex_);
+  FIREBASE_ASSERT_MESSAGE(clients_.empty(),
+                          "LocalDatabaseServer deleted with clients connected");
+  if (installed_) {
+    SetWebSocketClientFactory(nullptr);
+    g_installed_server = nullptr;
+  }
+}
+
+UniquePtr<WebSocketClientInterface> LocalDatabaseServer::CreateClient(
+    scheduler::Scheduler* scheduler, WebSocketClientEventHandler* handler) {
+  return MakeUnique<LocalDatabaseClient>(this, scheduler, handler);
+}
+
+void LocalDatabaseServer::Install(rest::NetworkSimulator* network) {
+  MutexLock lock(mutex_);
+  FIREBASE_ASSERT_MESSAGE(g_installed_server == nullptr,
+                          "Another LocalDatabaseServer is installed");
+  network_ = network;
+  installed_ = true;
+  g_installed_server = this;
+  SetWebSocketClientFactory(CreateInstalledClient);
+}
+
+UniquePtr<WebSocketClientInterface> LocalDatabaseServer::CreateInstalledClient(
+    const HostInfo& info, WebSocketClientEventHandler* delegate,
+    const char* opt_last_session_id, Logger* logger,
+    scheduler::Scheduler* scheduler) {
+  LocalDatabaseServer* server = g_installed_server;
+  if (server->network_ == nullptr) {
+    return server->CreateClient(scheduler, delegate);
+  }
+  UniquePtr<WebSocketClientSimulated> client =
+      MakeUnique<WebSocketClientSimulated>(
+          server->network_, info.GetConnectionUrl(opt_last_session_id),
+          scheduler, delegate);
+  client->set_client(server->CreateClient(scheduler, client.get()));
+  return UniquePtr<WebSocketClientInterface>(Move(client));
+}
+
+Variant LocalDatabaseServer::GetValue(const std::string& path) {
+  MutexLock lock(mutex_);
+  return GetChild(root_, Path(path));
+}
+
+void LocalDatabaseServer::SetValue(const std::string& path,
+                                   const Variant& value) {
+  MutexLock lock(mutex_);
+  PutLocked(Path(path), value);
+}
+
+void LocalDatabaseServer::UpdateChildren(const std::string& path,
+                                         const Variant& updates) {
+  MutexLock lock(mutex_);
+  MergeLocked(Path(path), updates);
+}
+
+void LocalDatabaseServer::DisconnectAll() {
+  MutexLock lock(mutex_);
+  while (!clients_.empty()) CloseLocked(clients_.back());
+}
+
+int LocalDatabaseServer::connected_clients() {
+  MutexLock lock(mutex_);
+  return static_cast<int>(clients_.size());
+}
+
+int64_t LocalDatabaseServer::connections_accepted() {
+  MutexLock lock(mutex_);
+  return connections_accepted_;
+}
+
+int64_t LocalDatabaseServer::requests_received() {
+  MutexLock lock(mutex_);
+  return requests_received_;
+}
+
+int64_t LocalDatabaseServer::bytes_sent() {
+  MutexLock lock(mutex_);
+  return bytes_sent_;
+}
+
+void LocalDatabaseServer::OpenLocked(LocalDatabaseClient* client) {
+  client->set_connected(true);
+  clients_.push_back(client);
+  ++connections_accepted_;
+  client->OpenedLocked();
+
+  // The hello handshake.
+  std::stringstream session_id;
+  session_id << "local-" << connections_accepted_;
+  Variant hello = Variant::EmptyMap();
+  hello.map()["ts"] =
+      static_cast<int64_t>(firebase::internal::GetTimestampEpoch());
+  hello.map()["v"] = "5";
+  hello.map()["h"] = "localhost";
+  hello.map()["s"] = session_id.str();
+  Variant control = Variant::EmptyMap();
+  control.map()["t"] = "h";
+  control.map()["d"] = hello;
+  Variant message = Variant::EmptyMap();
+  message.map()["t"] = "c";
+  message.map()["d"] = control;
+  client->DeliverLocked(util::VariantToJson(message));
+}
+
+void LocalDatabaseServer::CloseLocked(LocalDatabaseClient* client) {
+  client->set_connected(false);
+  clients_.erase(std::remove(clients_.begin(), clients_.end(), client),
+                 clients_.end());
+  listens_.erase(std::remove_if(listens_.begin(), listens_.end(),
+                                [client](const Listen& listen) {
+                                  return listen.client == client;
+                                }),
+                 listens_.end());
+  client->ClosedLocked();
+
+  auto it = on_disconnects_.find(client);
+  if (it != on_disconnects_.end()) {
+    std::vector<OnDisconnectOperation> operations = Move(it->second);
+    on_disconnects_.erase(it);
+    for (const OnDisconnectOperation& operation : operations) {
+      if (operation.action == "o") {
+        PutLocked(operation.path, operation.data);
+      } else {
+        MergeLocked(operation.path, operation.data);
+      }
+    }
+  }
+}
+
+void LocalDatabaseServer::HandleRequestLocked(LocalDatabaseClient* client,
+                                              const Variant& message) {
+  // Anything but a data message, e.g. a keep-alive, is ignored.
+  if (MapGet(message, "t") != Variant("d")) return;
+  const Variant& request = MapGet(message, "d");
+  const Variant& action = MapGet(request, "a");
+  if (!action.is_string()) return;
+  ++requests_received_;
+
+  Variant response = Variant::EmptyMap();
+  response.map()["r"] = MapGet(request, "r");
+  response.map()["b"] = HandleActionLocked(client, action.string_value(),
+                                           MapGet(request, "b"));
+  // Whether or not the client is still connected, e.g. after a failed put
+  // closed it, there is no one else to send the response to.
+  if (client->connected()) client->DeliverLocked(DataMessage(response));
+}
+
+Variant LocalDatabaseServer::HandleActionLocked(LocalDatabaseClient* client,
+                                                const std::string& action,
+                                                const Variant& body) {
+  Path path(MapGet(body, "p").AsString().string_value());
+  const Variant& data = MapGet(body, "d");
+  const Variant& tag = MapGet(body, "t");
+
+  if (action == "q") {
+    // Listen. The data comes first, then the response.
+    Listen listen = {client, path, tag};
+    listens_.push_back(listen);
+    PushLocked(client, "d", path, GetChild(root_, path), tag);
+  } else if (action == "n") {
+    // Unlisten.
+    listens_.erase(std::remove_if(listens_.begin(), listens_.end(),
+                                  [&](const Listen& listen) {
+                                    return listen.client == client &&
+                                           listen.path == path &&
+                                           listen.tag == tag;
+                                  }),
+                   listens_.end());
+  } else if (action == "p") {
+    PutLocked(path, data);
+  } else if (action == "m") {
+    MergeLocked(path, data);
+  } else if (action == "o" || action == "om") {
+    OnDisconnectOperation operation = {action, path, data};
+    on_disconnects_[client].push_back(operation);
+  } else if (action == "oc") {
+    auto it = on_disconnects_.find(client);
+    if (it != on_disconnects_.end()) {
+      std::vector<OnDisconnectOperation>& operations = it->second;
+      operations.erase(
+          std::remove_if(operations.begin(), operations.end(),
+                         [&path](const OnDisconnectOperation& operation) {
+                           return path.IsParent(operation.path);
+                         }),
+          operations.end());
+    }
+  } else if (action != "s" && action != "auth" && action != "gauth" &&
+             action != "unauth") {
+    Variant response = Variant::EmptyMap();
+    response.map()["s"] = "invalid_action";
+    response.map()["d"] = "Unknown action: " + action;
+    return response;
+  }
+  return OkResponse();
+}
+
+void LocalDatabaseServer::PutLocked(const Path& path, const Variant& value) {
+  SetChild(&root_, path, value);
+  for (const Listen& listen : listens_) {
+    if (listen.path.IsParent(path)) {
+      PushLocked(listen.client, "d", path, value, listen.tag);
+    } else if (path.IsParent(listen.path)) {
+      PushLocked(listen.client, "d", listen.path,
+                 GetChild(root_, listen.path), listen.tag);
+    }
+  }
+}
+
+void LocalDatabaseServer::MergeLocked(const Path& path,
+                                      const Variant& updates) {
+  if (!updates.is_map()) return;
+  for (const auto& update : updates.map()) {
+    SetChild(&root_, path.GetChild(update.first.AsString().string_value()),
+             update.second);
+  }
+  for (const Listen& listen : listens_) {
+    if (listen.path.IsParent(path)) {
+      PushLocked(listen.client, "m", path, updates, listen.tag);
+    } else if (path.IsParent(listen.path)) {
+      PushLocked(listen.client, "d", listen.path,
+                 GetChild(root_, listen.path), listen.tag);
+    }
+  }
+}
+
+void LocalDatabaseServer::PushLocked(LocalDatabaseClient* client,
+                                     const char* action, const Path& path,
+                                     const Variant& data, const Variant& tag) {
+  Variant body = Variant::EmptyMap();
+  body.map()["p"] = WirePath(path);
+  body.map()["d"] = data;
+  if (!tag.is_null()) body.map()["t"] = tag;
+  Variant push = Variant::EmptyMap();
+  push.map()["a"] = action;
+  push.map()["b"] = body;
+  client->DeliverLocked(DataMessage(push));
+}
+
+Variant GenerateTree(int children, int depth, size_t leaf_size) {
+  if (depth <= 0) return Variant(std::string(leaf_size, 'x'));
+  Variant node = Variant::EmptyMap();
+  for (int i = 0; i < children; ++i) {
+    char key[16];
+    snprintf(key, sizeof(key), "child%04d", i);
+    node.map()[key] = GenerateTree(children, depth - 1, leaf_size);
+  }
+  return node;
+}
+
+}  // namespace connection
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
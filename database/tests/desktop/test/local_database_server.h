@@ -0,0 +1,168 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FIREBASE_DATABASE_TESTS_DESKTOP_TEST_LOCAL_DATABASE_SERVER_H_
+#define FIREBASE_DATABASE_TESTS_DESKTOP_TEST_LOCAL_DATABASE_SERVER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "app/memory/unique_ptr.h"
+#include "app/rest/network_simulator.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/include/firebase/variant.h"
+#include "app/src/logger.h"
+#include "app/src/path.h"
+#include "app/src/scheduler.h"
+#include "database/src/desktop/connection/host_info.h"
+#include "database/src/desktop/connection/web_socket_client_interface.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace connection {
+
+class LocalDatabaseClient;
+
+// An in-process stand-in for the Realtime Database service, speaking the
+// wire protocol that Connection and PersistentConnection use: the hello
+// handshake, listen and unlisten, put and merge, onDisconnect operations,
+// keep-alives, and frame splitting in both directions. Writes from any client
+// are pushed to every client listening at an overlapping path.
+//
+// It is meant for hermetic tests and benchmarks, so it keeps things simple:
+// queries are answered with all the data at their path, compare-and-put
+// always succeeds, and every client is authorized.
+//
+// Install() makes the SDK connect to the server instead of the network,
+// optionally over a NetworkSimulator for latency and failures. Tests can also
+// script the data on the server with SetValue() and UpdateChildren(), and
+// drop every connection with DisconnectAll() to measure reconnecting.
+//
+// This class is thread-safe. It must outlive the clients connected to it.
+class LocalDatabaseServer {
+ public:
+  LocalDatabaseServer();
+  ~LocalDatabaseServer();
+
+  // LocalDatabaseServer is neither copyable nor movable.
+  LocalDatabaseServer(const LocalDatabaseServer&) = delete;
+  LocalDatabaseServer& operator=(const LocalDatabaseServer&) = delete;
+
+  // Creates a client connected to this server, which calls `handler` on
+  // `scheduler`'s thread like WebSocketClientImpl does.
+  UniquePtr<WebSocketClientInterface> CreateClient(
+      scheduler::Scheduler* scheduler, WebSocketClientEventHandler* handler);
+
+  // Makes CreateWebSocketClient() connect to this server until it is deleted.
+  // Connections are carried over `network` if it is not null, which must
+  // outlive the server. Only one server can be installed at a time.
+  void Install(rest::NetworkSimulator* network = nullptr);
+
+  // Returns the data at `path`, or a null Variant.
+  Variant GetValue(const std::string& path);
+
+  // Writes `value` at `path` as a client put would, and pushes it to the
+  // listening clients.
+  void SetValue(const std::string& path, const Variant& value);
+
+  // Writes each of the children in the map `updates` under `path` as a client
+  // merge would, and pushes them to the listening clients.
+  void UpdateChildren(const std::string& path, const Variant& updates);
+
+  // Closes every connection, as the service does when it goes away. Clients
+  // see the connection as lost, and reconnect.
+  void DisconnectAll();
+
+  // Number of clients currently connected.
+  int connected_clients();
+  // Number of connections accepted since the server was created.
+  int64_t connections_accepted();
+  // Number of requests received from clients.
+  int64_t requests_received();
+  // Number of bytes sent to clients, counting every frame.
+  int64_t bytes_sent();
+
+  // The largest frame the server sends, and Connection sends. Larger
+  // messages are split into frames.
+  static const size_t kMaxFrameSize;
+
+ private:
+  friend class LocalDatabaseClient;
+
+  struct Listen {
+    LocalDatabaseClient* client;
+    Path path;
+    // Null for queries loading all the data at their path.
+    Variant tag;
+  };
+
+  struct OnDisconnectOperation {
+    std::string action;
+    Path path;
+    Variant data;
+  };
+
+  // The WebSocketClientFactory that Install() sets.
+  static UniquePtr<WebSocketClientInterface> CreateInstalledClient(
+      const HostInfo& info, WebSocketClientEventHandler* delegate,
+      const char* opt_last_session_id, Logger* logger,
+      scheduler::Scheduler* scheduler);
+
+  // Called by clients, with mutex_ held.
+  void OpenLocked(LocalDatabaseClient* client);
+  void CloseLocked(LocalDatabaseClient* client);
+  void HandleRequestLocked(LocalDatabaseClient* client,
+                           const Variant& request);
+
+  // Handles one request action, and returns the body of its response.
+  Variant HandleActionLocked(LocalDatabaseClient* client,
+                             const std::string& action, const Variant& body);
+
+  // Writes data, and pushes it to the listening clients.
+  void PutLocked(const Path& path, const Variant& value);
+  void MergeLocked(const Path& path, const Variant& updates);
+
+  // Sends a data push to a client.
+  void PushLocked(LocalDatabaseClient* client, const char* action,
+                  const Path& path, const Variant& data, const Variant& tag);
+
+  Mutex mutex_;
+  Variant root_;
+  std::vector<LocalDatabaseClient*> clients_;
+  std::vector<Listen> listens_;
+  std::map<LocalDatabaseClient*, std::vector<OnDisconnectOperation>>
+      on_disconnects_;
+  rest::NetworkSimulator* network_;
+  bool installed_;
+
+  int64_t connections_accepted_;
+  int64_t requests_received_;
+  int64_t bytes_sent_;
+};
+
+// Builds a tree for benchmarks with `children` children per node, `depth`
+// levels deep, whose leaves are strings of `leaf_size` bytes. The same
+// arguments always build the same tree.
+Variant GenerateTree(int children, int depth, size_t leaf_size);
+
+}  // namespace connection
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
+
+#endif  // FIREBASE_DATABASE_TESTS_DESKTOP_TEST_LOCAL_DATABASE_SERVER_H_
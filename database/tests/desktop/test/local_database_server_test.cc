@@ -0,0 +1,277 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "database/tests/desktop/test/local_database_server.h"
+
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/scheduler.h"
+#include "app/src/semaphore.h"
+#include "app/src/variant_util.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace database {
+namespace internal {
+namespace connection {
+
+// Records the messages it receives, reassembling split messages.
+class RecordingHandler : public WebSocketClientEventHandler {
+ public:
+  RecordingHandler() : expected_frames_(0), frame_count_(0), received_(0) {}
+
+  void OnOpen() override { Record("open"); }
+  void OnMessage(const char* msg) override {
+    std::string message(msg);
+    if (expected_frames_ == 0 && message.size() <= 6) {
+      expected_frames_ = std::stoi(message);
+      frame_count_ += expected_frames_;
+      return;
+    }
+    if (expected_frames_ > 0) {
+      buffer_ += message;
+      if (--expected_frames_ > 0) return;
+      message.swap(buffer_);
+      buffer_.clear();
+    }
+    Record(message);
+  }
+  void OnClose() override { Record("close"); }
+  void OnError(const WebSocketClientErrorData& error_data) override {
+    Record("error");
+  }
+
+  // Waits for `count` more events.
+  bool WaitFor(int count) {
+    for (int i = 0; i < count; ++i) {
+      if (!received_.TimedWait(5000)) return false;
+    }
+    return true;
+  }
+
+  std::vector<std::string> events() {
+    MutexLock lock(mutex_);
+    return events_;
+  }
+
+  // Returns the messages received as Variants, skipping other events.
+  std::vector<Variant> messages() {
+    std::vector<Variant> messages;
+    for (const std::string& event : events()) {
+      if (event[0] == '{') {
+        messages.push_back(util::JsonToVariant(event.c_str()));
+      }
+    }
+    return messages;
+  }
+
+  // Number of frames split messages arrived in. Only read once the events
+  // have arrived.
+  int frame_count() const { return frame_count_; }
+
+ private:
+  void Record(const std::string& event) {
+    {
+      MutexLock lock(mutex_);
+      events_.push_back(event);
+    }
+    received_.Post();
+  }
+
+  // Only used on the scheduler's thread.
+  int expected_frames_;
+  int frame_count_;
+  std::string buffer_;
+
+  Mutex mutex_;
+  std::vector<std::string> events_;
+  Semaphore received_;
+};
+
+std::string Request(int id, const char* action, const Variant& body) {
+  Variant request = Variant::EmptyMap();
+  request.map()["r"] = id;
+  request.map()["a"] = action;
+  request.map()["b"] = body;
+  Variant message = Variant::EmptyMap();
+  message.map()["t"] = "d";
+  message.map()["d"] = request;
+  return util::VariantToJson(message);
+}
+
+Variant Body(const char* path, const Variant& data = Variant::Null()) {
+  Variant body = Variant::EmptyMap();
+  body.map()["p"] = path;
+  if (!data.is_null()) body.map()["d"] = data;
+  return body;
+}
+
+// Returns message["d"]["b"], the body of a response or a push.
+const Variant& MessageBody(const Variant& message) {
+  return message.map().at("d").map().at("b");
+}
+
+class LocalDatabaseServerTest : public ::testing::Test {
+ protected:
+  // Connects a client, and waits for the handshake.
+  UniquePtr<WebSocketClientInterface> Connect(RecordingHandler* handler) {
+    UniquePtr<WebSocketClientInterface> client =
+        server_.CreateClient(&scheduler_, handler);
+    client->Connect(1000);
+    EXPECT_TRUE(handler->WaitFor(2));
+    return client;
+  }
+
+  LocalDatabaseServer server_;
+  scheduler::Scheduler scheduler_;
+};
+
+TEST_F(LocalDatabaseServerTest, SendsHandshakeWhenOpened) {
+  RecordingHandler handler;
+  UniquePtr<WebSocketClientInterface> client = Connect(&handler);
+
+  std::vector<std::string> events = handler.events();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0], "open");
+  Variant hello = util::JsonToVariant(events[1].c_str());
+  EXPECT_EQ(hello.map()["t"], "c");
+  EXPECT_EQ(hello.map()["d"].map()["t"], "h");
+  EXPECT_EQ(hello.map()["d"].map()["d"].map()["s"], "local-1");
+  EXPECT_EQ(server_.connected_clients(), 1);
+
+  client->Close();
+  ASSERT_TRUE(handler.WaitFor(1));
+  EXPECT_EQ(handler.events().back(), "close");
+  EXPECT_EQ(server_.connected_clients(), 0);
+}
+
+TEST_F(LocalDatabaseServerTest, ListenReceivesDataThenResponse) {
+  server_.SetValue("a/b", 1);
+  RecordingHandler handler;
+  UniquePtr<WebSocketClientInterface> client = Connect(&handler);
+
+  client->Send("0");  // A keep-alive is ignored.
+  client->Send(Request(1, "q", Body("/a")).c_str());
+  ASSERT_TRUE(handler.WaitFor(2));
+
+  std::vector<Variant> messages = handler.messages();
+  ASSERT_EQ(messages.size(), 3);
+  const Variant& push = messages[1].map().at("d");
+  EXPECT_EQ(push.map().at("a"), "d");
+  EXPECT_EQ(MessageBody(messages[1]).map().at("p"), "a");
+  EXPECT_EQ(util::VariantToJson(MessageBody(messages[1]).map().at("d")),
+            "{\"b\":1}");
+  EXPECT_EQ(messages[2].map().at("d").map().at("r"), 1);
+  EXPECT_EQ(MessageBody(messages[2]).map().at("s"), "ok");
+  EXPECT_EQ(server_.requests_received(), 1);
+
+  client->Close();
+  ASSERT_TRUE(handler.WaitFor(1));
+}
+
+TEST_F(LocalDatabaseServerTest, PutIsPushedToOtherListeners) {
+  RecordingHandler listener_handler;
+  UniquePtr<WebSocketClientInterface> listener = Connect(&listener_handler);
+  listener->Send(Request(1, "q", Body("/")).c_str());
+  ASSERT_TRUE(listener_handler.WaitFor(2));
+
+  RecordingHandler writer_handler;
+  UniquePtr<WebSocketClientInterface> writer = Connect(&writer_handler);
+  writer->Send(Request(1, "p", Body("/x/y", "value")).c_str());
+  ASSERT_TRUE(writer_handler.WaitFor(1));
+  ASSERT_TRUE(listener_handler.WaitFor(1));
+
+  Variant push = MessageBody(listener_handler.messages().back());
+  EXPECT_EQ(push.map().at("p"), "x/y");
+  EXPECT_EQ(push.map().at("d"), "value");
+  EXPECT_EQ(server_.GetValue("x/y"), "value");
+
+  // Deleting the value removes its empty parents.
+  writer->Send(Request(2, "p", Body("/x/y", Variant::Null())).c_str());
+  ASSERT_TRUE(writer_handler.WaitFor(1));
+  EXPECT_TRUE(server_.GetValue("x").is_null());
+
+  server_.DisconnectAll();
+  ASSERT_TRUE(listener_handler.WaitFor(2));
+  ASSERT_TRUE(writer_handler.WaitFor(1));
+}
+
+TEST_F(LocalDatabaseServerTest, SplitsAndReassemblesLargeMessages) {
+  Variant tree = GenerateTree(4, 3, 1024);
+  RecordingHandler handler;
+  UniquePtr<WebSocketClientInterface> client = Connect(&handler);
+
+  // A request larger than a frame, split like Connection does.
+  std::string request = Request(1, "p", Body("/tree", tree));
+  ASSERT_GT(request.size(), LocalDatabaseServer::kMaxFrameSize);
+  size_t frames = request.size() / LocalDatabaseServer::kMaxFrameSize + 1;
+  client->Send(std::to_string(frames).c_str());
+  for (size_t i = 0; i < frames; ++i) {
+    client->Send(request
+                     .substr(i * LocalDatabaseServer::kMaxFrameSize,
+                             LocalDatabaseServer::kMaxFrameSize)
+                     .c_str());
+  }
+  ASSERT_TRUE(handler.WaitFor(1));
+  EXPECT_EQ(server_.GetValue("tree"), tree);
+
+  // The data is split again when the client listens to it.
+  client->Send(Request(2, "q", Body("/tree")).c_str());
+  ASSERT_TRUE(handler.WaitFor(2));
+  std::vector<Variant> messages = handler.messages();
+  EXPECT_EQ(MessageBody(messages[messages.size() - 2]).map().at("d"), tree);
+  EXPECT_GT(handler.frame_count(), 1);
+
+  client->Close();
+  ASSERT_TRUE(handler.WaitFor(1));
+}
+
+TEST_F(LocalDatabaseServerTest, DisconnectAppliesOnDisconnectOperations) {
+  RecordingHandler handler;
+  UniquePtr<WebSocketClientInterface> client = Connect(&handler);
+  client->Send(Request(1, "o", Body("/status", "offline")).c_str());
+  client->Send(Request(2, "o", Body("/cancelled", true)).c_str());
+  client->Send(Request(3, "oc", Body("/cancelled")).c_str());
+  ASSERT_TRUE(handler.WaitFor(3));
+  EXPECT_TRUE(server_.GetValue("status").is_null());
+
+  server_.DisconnectAll();
+  ASSERT_TRUE(handler.WaitFor(1));
+  EXPECT_EQ(handler.events().back(), "close");
+  EXPECT_EQ(server_.GetValue("status"), "offline");
+  EXPECT_TRUE(server_.GetValue("cancelled").is_null());
+
+  // The client can connect again.
+  client->Connect(1000);
+  ASSERT_TRUE(handler.WaitFor(2));
+  EXPECT_EQ(server_.connections_accepted(), 2);
+  client->Close();
+  ASSERT_TRUE(handler.WaitFor(1));
+}
+
+TEST(GenerateTreeTest, BuildsTheSameTree) {
+  Variant tree = GenerateTree(3, 2, 8);
+  EXPECT_EQ(tree, GenerateTree(3, 2, 8));
+  ASSERT_TRUE(tree.is_map());
+  EXPECT_EQ(tree.map().size(), 3);
+  EXPECT_EQ(tree.map()["child0002"].map()["child0000"],
+            std::string(8, 'x'));
+}
+
+}  // namespace connection
+}  // namespace internal
+}  // namespace database
+}  // namespace firebase
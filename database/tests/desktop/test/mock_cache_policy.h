@@ -36,6 +36,7 @@ class MockCachePolicy : public CachePolicy {
               (uint64_t server_updates_since_last_check), (const, override));
   MOCK_METHOD(double, GetPercentOfQueriesToPruneAtOnce, (), (const, override));
   MOCK_METHOD(uint64_t, GetMaxNumberOfQueriesToKeep, (), (const, override));
+  MOCK_METHOD(uint64_t, GetMaxSizeBytes, (), (const, override));
 };
 
 }  // namespace internal
@@ -47,6 +47,8 @@ class MockPersistenceStorageEngine : public PersistenceStorageEngine {
   MOCK_METHOD(void, MergeIntoServerCache,
               (const Path& path, const CompoundWrite& children), (override));
   MOCK_METHOD(uint64_t, ServerCacheEstimatedSizeInBytes, (), (const, override));
+  MOCK_METHOD(uint64_t, ServerCacheEstimatedSizeInBytes, (const Path& path),
+              (const, override));
   MOCK_METHOD(void, SaveTrackedQuery, (const TrackedQuery& tracked_query),
               (override));
   MOCK_METHOD(void, DeleteTrackedQuery, (QueryId tracked_query_id), (override));
@@ -70,6 +72,7 @@ class MockPersistenceStorageEngine : public PersistenceStorageEngine {
   MOCK_METHOD(bool, BeginTransaction, (), (override));
   MOCK_METHOD(void, EndTransaction, (), (override));
   MOCK_METHOD(void, SetTransactionSuccessful, (), (override));
+  MOCK_METHOD(void, Flush, (), (override));
 };
 
 }  // namespace internal
@@ -39,11 +39,18 @@ class MockTrackedQueryManager : public TrackedQueryManagerInterface {
   MOCK_METHOD(bool, IsQueryComplete, (const QuerySpec& query), (override));
   MOCK_METHOD(PruneForest, PruneOldQueries, (const CachePolicy& cache_policy),
               (override));
+  MOCK_METHOD(void, StartPruningLeastRecentlyUsedQueries, (), (override));
+  MOCK_METHOD(PruneForest, PruneLeastRecentlyUsedQueries,
+              (uint64_t count_to_prune, uint64_t bytes_to_free,
+               uint64_t max_count, uint64_t* bytes_freed),
+              (override));
   MOCK_METHOD(std::set<std::string>, GetKnownCompleteChildren,
               (const Path& path), (override));
   MOCK_METHOD(void, EnsureCompleteTrackedQuery, (const Path& path), (override));
   MOCK_METHOD(bool, HasActiveDefaultQuery, (const Path& path), (override));
   MOCK_METHOD(uint64_t, CountOfPrunableQueries, (), (override));
+  MOCK_METHOD(uint64_t, CountOfQueriesToPrune,
+              (const CachePolicy& cache_policy), (override));
 };
 
 }  // namespace internal
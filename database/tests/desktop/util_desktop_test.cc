@@ -713,6 +713,37 @@ TEST(UtilDesktopTest, VariantUpdateChild_MapVariant) {
             }));
 }
 
+TEST(UtilDesktopTest, VariantUpdateChild_ManyChildren) {
+  const int kChildCount = 1000;
+  Variant variant;
+  for (int i = 0; i < kChildCount; i++) {
+    // Keys longer than the small string optimization, like push ids.
+    std::string key = "-child_key_number_" + std::to_string(i);
+    VariantUpdateChild(&variant, Path(key + "/value"), i);
+  }
+  ASSERT_TRUE(variant.is_map());
+  EXPECT_EQ(variant.map().size(), static_cast<size_t>(kChildCount));
+
+  for (int i = 0; i < kChildCount; i++) {
+    std::string key = "-child_key_number_" + std::to_string(i);
+    EXPECT_EQ(VariantGetChild(&variant, Path(key + "/value")), Variant(i));
+    const Variant* child = GetInternalVariant(&variant, Path(key));
+    ASSERT_NE(child, nullptr);
+    EXPECT_EQ(*child, Variant(std::map<Variant, Variant>{
+                          std::make_pair("value", i)}));
+  }
+  // The map owns copies of its keys.
+  for (const auto& entry : variant.map()) {
+    EXPECT_FALSE(entry.first.is_static_string());
+  }
+
+  for (int i = 0; i < kChildCount; i++) {
+    std::string key = "-child_key_number_" + std::to_string(i);
+    VariantUpdateChild(&variant, Path(key + "/value"), Variant::Null());
+  }
+  EXPECT_EQ(variant, Variant::Null());
+}
+
 TEST(UtilDesktopTest, VariantUpdateImmediateChild_NullVariant) {
   Variant null_variant;
 
@@ -313,7 +313,8 @@ TEST(View, RemoveEventRegistration_RemoveOne) {
   };
 
   EXPECT_THAT(
-      view.RemoveEventRegistration(static_cast<void*>(&listener3), kErrorNone),
+      view.RemoveEventRegistration(static_cast<void*>(&listener3), nullptr,
+                                   kErrorNone),
       Pointwise(Eq(), expected_events));
 }
 
@@ -345,7 +346,7 @@ TEST(View, RemoveEventRegistration_RemoveAll) {
   view.AddEventRegistration(UniquePtr<ValueEventRegistration>(registration4));
 
   std::vector<Event> results =
-      view.RemoveEventRegistration(nullptr, kErrorDisconnected);
+      view.RemoveEventRegistration(nullptr, nullptr, kErrorDisconnected);
 
   EXPECT_EQ(results.size(), 4);
 
@@ -374,6 +375,44 @@ TEST(View, RemoveEventRegistration_RemoveAll) {
   EXPECT_EQ(results[3].event_registration_ownership_ptr.get(), registration4);
 }
 
+TEST(View, RemoveEventRegistration_ByDatabase) {
+  QuerySpec query_spec;
+  query_spec.path = Path("test/path");
+  CacheNode cache(IndexedVariant(Variant(), query_spec.params), true, false);
+  ViewCache initial_view_cache(cache, cache);
+  View view(query_spec, initial_view_cache);
+
+  // Only the addresses of the databases are compared.
+  char databases[2];
+  auto* database1 = reinterpret_cast<DatabaseInternal*>(&databases[0]);
+  auto* database2 = reinterpret_cast<DatabaseInternal*>(&databases[1]);
+  DummyValueListener listener1;
+  DummyValueListener listener2;
+
+  ValueEventRegistration* registration1 =
+      new ValueEventRegistration(database1, &listener1, QuerySpec());
+  ValueEventRegistration* registration2 =
+      new ValueEventRegistration(database2, &listener1, QuerySpec());
+  ValueEventRegistration* registration3 =
+      new ValueEventRegistration(database1, &listener2, QuerySpec());
+  view.AddEventRegistration(UniquePtr<EventRegistration>(registration1));
+  view.AddEventRegistration(UniquePtr<EventRegistration>(registration2));
+  view.AddEventRegistration(UniquePtr<EventRegistration>(registration3));
+
+  // The same listener registered through another database is left alone.
+  EXPECT_TRUE(view.RemoveEventRegistration(static_cast<void*>(&listener1),
+                                           database2, kErrorNone)
+                  .empty());
+  ASSERT_EQ(view.event_registrations().size(), 2);
+  EXPECT_EQ(view.event_registrations()[0].get(), registration1);
+  EXPECT_EQ(view.event_registrations()[1].get(), registration3);
+
+  // Without a listener, everything registered through the database goes.
+  EXPECT_TRUE(view.RemoveEventRegistration(nullptr, database1, kErrorNone)
+                  .empty());
+  EXPECT_TRUE(view.IsEmpty());
+}
+
 // View::ApplyOperation tests omitted. It just calls through to the functions
 // ViewProcessor::ApplyOperation and GenerateEventsForChanges, and it is
 // difficult to mock the interaction. Those functions are themselves tested in
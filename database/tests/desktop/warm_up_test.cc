@@ -0,0 +1,137 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/app.h"
+#include "app/src/include/firebase/future.h"
+#include "app/src/semaphore.h"
+#include "app/src/thread.h"
+#include "app/src/variant_util.h"
+#include "app/tests/include/firebase/app_for_testing.h"
+#include "database/src/include/firebase/database.h"
+#include "database/tests/desktop/test/local_database_server.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+
+namespace firebase {
+namespace database {
+namespace {
+
+using internal::connection::LocalDatabaseServer;
+
+const char kDatabaseUrl[] = "https://local.firebaseio.com";
+
+class WarmUpTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    server_.Install();
+    server_.SetValue("a", "value");
+    server_.SetValue("b/c", 1);
+    app_ = testing::CreateApp();
+    database_ = Database::GetInstance(app_, kDatabaseUrl);
+  }
+
+  void TearDown() override {
+    delete database_;
+    delete app_;
+  }
+
+  std::vector<Query> Queries() {
+    return {database_->GetReference("a"), database_->GetReference("b")};
+  }
+
+  // Blocks until `future` completes, or 5 seconds have passed.
+  static bool Await(const FutureBase& future) {
+    Semaphore completed(0);
+    future.OnCompletion(
+        [](const FutureBase&, void* completed) {
+          static_cast<Semaphore*>(completed)->Post();
+        },
+        &completed);
+    return completed.TimedWait(5000);
+  }
+
+  // Deleted after the database, whose connection must not outlive it.
+  LocalDatabaseServer server_;
+  App* app_;
+  Database* database_;
+};
+
+TEST_F(WarmUpTest, CompletesWithTheSizeOfEachQuery) {
+  Future<std::vector<size_t>> future = database_->WarmUp(Queries());
+  ASSERT_TRUE(Await(future));
+  EXPECT_EQ(future.error(), kErrorNone);
+  EXPECT_THAT(*future.result(),
+              ElementsAre(util::VariantToJson(Variant("value")).size(),
+                          util::VariantToJson(server_.GetValue("b")).size()));
+  EXPECT_EQ(database_->WarmUpLastResult(), future);
+}
+
+// Shared with the callback of the first WarmUp() call, which calls WarmUp()
+// again from another thread and waits for it to return.
+struct NestedWarmUp {
+  explicit NestedWarmUp(Database* database)
+      : database(database), returned(0), returned_in_time(false), done(0) {}
+
+  Database* database;
+  std::vector<Query> queries;
+  Thread thread;
+  Future<std::vector<size_t>> future;
+  Semaphore returned;
+  bool returned_in_time;
+  Semaphore done;
+};
+
+void WarmUpAgain(void* user_data) {
+  NestedWarmUp* nested = static_cast<NestedWarmUp*>(user_data);
+  nested->future = nested->database->WarmUp(nested->queries);
+  nested->returned.Post();
+}
+
+// The future is completed without any lock held that WarmUp() takes, so its
+// callbacks can wait for other threads calling into the database.
+TEST_F(WarmUpTest, CallbackMayWaitForAnotherWarmUp) {
+  NestedWarmUp nested(database_);
+  nested.queries = Queries();
+  Future<std::vector<size_t>> future = database_->WarmUp(Queries());
+  future.OnCompletion(
+      [](const Future<std::vector<size_t>>&, void* user_data) {
+        NestedWarmUp* nested = static_cast<NestedWarmUp*>(user_data);
+        nested->thread = Thread(WarmUpAgain, user_data);
+        nested->returned_in_time = nested->returned.TimedWait(5000);
+        nested->done.Post();
+      },
+      &nested);
+  ASSERT_TRUE(nested.done.TimedWait(10000));
+  nested.thread.Join();
+  EXPECT_TRUE(nested.returned_in_time);
+  ASSERT_TRUE(Await(nested.future));
+  EXPECT_EQ(nested.future.error(), kErrorNone);
+}
+
+TEST_F(WarmUpTest, DeletingTheDatabaseDropsPendingCalls) {
+  Future<std::vector<size_t>> future = database_->WarmUp(Queries());
+  delete database_;
+  database_ = nullptr;
+  // The future is either complete, or was released with the database.
+  EXPECT_NE(future.status(), kFutureStatusPending);
+}
+
+}  // namespace
+}  // namespace database
+}  // namespace firebase
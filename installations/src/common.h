@@ -22,6 +22,10 @@ enum InstallationsFn {
   kInstallationsFnGetId,
   kInstallationsFnGetToken,
   kInstallationsFnDelete,
+  // Used by other products through the function registry, so that they do
+  // not replace the results of the public calls.
+  kInstallationsFnGetIdForRegistry,
+  kInstallationsFnGetTokenForRegistry,
   kInstallationsFnCount
 };
 
@@ -0,0 +1,179 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "installations/src/desktop/installation_store.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+
+#include "app/src/filesystem.h"
+#include "app/src/include/firebase/internal/platform.h"
+#include "app/src/log.h"
+#include "app/src/variant_util.h"
+#include "firebase/variant.h"
+
+#if !FIREBASE_PLATFORM_WINDOWS
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !FIREBASE_PLATFORM_WINDOWS
+
+namespace firebase {
+namespace installations {
+namespace internal {
+
+namespace {
+
+const char kInstallationsDir[] = "firebase-installations";
+const char kInstallationFilenamePrefix[] = "installation-";
+
+// Symbols that might not be allowed in filenames.
+const char kFilenameSymbols[] = "/\\?%*:|\"<>.,;=";
+
+const char kFidKey[] = "fid";
+const char kRefreshTokenKey[] = "refreshToken";
+const char kAuthTokenKey[] = "authToken";
+const char kAuthTokenExpirationKey[] = "authTokenExpiration";
+
+std::string GetDefaultFilePath(const App& app) {
+  std::string error;
+  std::string dir = AppDataDir(kInstallationsDir, /*should_create=*/true,
+                               &error);
+  if (!error.empty()) {
+    LogError("Unable to find a directory for installations: %s",
+             error.c_str());
+    return "";
+  }
+  // Each app has its own installation.
+  std::string name = std::string(app.name()) + "-" + app.options().app_id();
+  std::string name_without_symbols;
+  name_without_symbols.reserve(name.size());
+  for (char c : name) {
+    if (strchr(kFilenameSymbols, c) == nullptr) name_without_symbols += c;
+  }
+  return dir + "/" + kInstallationFilenamePrefix + name_without_symbols;
+}
+
+// Returns the string stored under `key`, or an empty string.
+std::string GetString(const Variant& stored, const char* key) {
+  auto it = stored.map().find(Variant(key));
+  if (it == stored.map().end() || !it->second.is_string()) return "";
+  return it->second.string_value();
+}
+
+// Writes `contents` to a new file at `path` that only the user can read, as it
+// holds the installation's refresh token. Any file already at `path` is
+// replaced.
+bool WritePrivateFile(const std::string& path, const std::string& contents) {
+  // Make sure the file is created with the permissions below, rather than
+  // reusing one left behind with others.
+  std::remove(path.c_str());
+#if FIREBASE_PLATFORM_WINDOWS
+  // Files in the app data directory are only accessible to the user.
+  std::ofstream file(path, std::ios_base::trunc | std::ios_base::binary);
+  if (!file) return false;
+  file.write(contents.data(), contents.size());
+  file.close();
+  return !file.fail();
+#else
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd < 0) return false;
+  const char* data = contents.data();
+  size_t left = contents.size();
+  while (left > 0) {
+    ssize_t written = write(fd, data, left);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    data += written;
+    left -= static_cast<size_t>(written);
+  }
+  return close(fd) == 0 && left == 0;
+#endif  // FIREBASE_PLATFORM_WINDOWS
+}
+
+}  // namespace
+
+InstallationStore::InstallationStore(const App& app)
+    : file_path_(GetDefaultFilePath(app)) {}
+
+InstallationStore::InstallationStore(const std::string& file_path)
+    : file_path_(file_path) {}
+
+bool InstallationStore::Load(InstallationData* data) const {
+  if (file_path_.empty()) return false;
+  std::ifstream file(file_path_, std::ios_base::binary);
+  if (!file) return false;
+  std::string json((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  Variant stored = util::JsonToVariant(json.c_str());
+  if (!stored.is_map()) {
+    LogWarning("Ignoring unreadable installation in '%s'",
+               file_path_.c_str());
+    return false;
+  }
+  std::string fid = GetString(stored, kFidKey);
+  if (fid.empty()) return false;
+  data->fid = fid;
+  data->refresh_token = GetString(stored, kRefreshTokenKey);
+  data->auth_token = GetString(stored, kAuthTokenKey);
+  auto expiration = stored.map().find(Variant(kAuthTokenExpirationKey));
+  data->auth_token_expiration_ms =
+      expiration != stored.map().end() && expiration->second.is_int64()
+          ? expiration->second.int64_value()
+          : 0;
+  return true;
+}
+
+bool InstallationStore::Save(const InstallationData& data) const {
+  if (file_path_.empty()) return false;
+  Variant stored = Variant::EmptyMap();
+  stored.map()[kFidKey] = data.fid;
+  stored.map()[kRefreshTokenKey] = data.refresh_token;
+  stored.map()[kAuthTokenKey] = data.auth_token;
+  stored.map()[kAuthTokenExpirationKey] = data.auth_token_expiration_ms;
+  std::string json = util::VariantToJson(stored);
+  // Write under a temporary name and then move the file in place, so that a
+  // crash never leaves a partially written installation behind.
+  std::string temp_path = file_path_ + ".tmp";
+  if (!WritePrivateFile(temp_path, json)) {
+    LogError("Unable to write '%s'.", temp_path.c_str());
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  // Windows does not replace an existing file when renaming.
+  if (std::rename(temp_path.c_str(), file_path_.c_str()) != 0 &&
+      (std::remove(file_path_.c_str()) != 0 ||
+       std::rename(temp_path.c_str(), file_path_.c_str()) != 0)) {
+    LogError("Unable to move '%s' to '%s'.", temp_path.c_str(),
+             file_path_.c_str());
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void InstallationStore::Clear() const {
+  if (!file_path_.empty()) std::remove(file_path_.c_str());
+}
+
+}  // namespace internal
+}  // namespace installations
+}  // namespace firebase
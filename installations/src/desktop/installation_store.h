@@ -0,0 +1,82 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FIREBASE_INSTALLATIONS_SRC_DESKTOP_INSTALLATION_STORE_H_
+#define FIREBASE_INSTALLATIONS_SRC_DESKTOP_INSTALLATION_STORE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "firebase/app.h"
+
+namespace firebase {
+namespace installations {
+namespace internal {
+
+// Everything known about the installation of an app.
+struct InstallationData {
+  InstallationData() : auth_token_expiration_ms(0) {}
+
+  // Whether the backend knows about the installation.
+  bool registered() const { return !refresh_token.empty(); }
+
+  bool operator==(const InstallationData& other) const {
+    return fid == other.fid && refresh_token == other.refresh_token &&
+           auth_token == other.auth_token &&
+           auth_token_expiration_ms == other.auth_token_expiration_ms;
+  }
+
+  // Firebase installation ID.
+  std::string fid;
+  // Authenticates requests for new auth tokens. Only set once the
+  // installation is registered.
+  std::string refresh_token;
+  // The last auth token, and when it expires in milliseconds since the epoch.
+  std::string auth_token;
+  int64_t auth_token_expiration_ms;
+};
+
+// Persists the installation of an app in a file, so that it keeps the same
+// ID, and can reuse its auth token, across runs.
+class InstallationStore {
+ public:
+  // Uses a file in the app data directory, named after the app.
+  explicit InstallationStore(const App& app);
+
+  // Uses `file_path`.
+  explicit InstallationStore(const std::string& file_path);
+
+  // Reads the installation into `data`. Returns false, and leaves `data`
+  // untouched, if there is no stored installation or it cannot be read.
+  bool Load(InstallationData* data) const;
+
+  // Writes the installation, replacing the stored one. The file holds the
+  // refresh token, so only the user can read it, and it is replaced in one
+  // step so that a crash never leaves half of it behind.
+  bool Save(const InstallationData& data) const;
+
+  // Removes the stored installation.
+  void Clear() const;
+
+  const std::string& file_path() const { return file_path_; }
+
+ private:
+  std::string file_path_;
+};
+
+}  // namespace internal
+}  // namespace installations
+}  // namespace firebase
+
+#endif  // FIREBASE_INSTALLATIONS_SRC_DESKTOP_INSTALLATION_STORE_H_
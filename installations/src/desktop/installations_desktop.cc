@@ -0,0 +1,485 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "installations/src/desktop/installations_desktop.h"
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_builder.h"
+#include "app/rest/transport_curl.h"
+#include "app/rest/transport_interface.h"
+#include "app/rest/util.h"
+#include "app/src/base64.h"
+#include "app/src/callback.h"
+#include "app/src/function_registry.h"
+#include "app/src/include/firebase/version.h"
+#include "app/src/log.h"
+#include "app/src/time.h"
+#include "app/src/uuid.h"
+#include "app/src/variant_util.h"
+#include "firebase/variant.h"
+#include "installations/src/common.h"
+
+namespace firebase {
+namespace installations {
+namespace internal {
+
+namespace {
+
+const char kSdkVersion[] = "cpp:" FIREBASE_VERSION_NUMBER_STRING;
+
+// Length of a Firebase installation ID.
+const size_t kFidLength = 22;
+
+// The instances that serve the function registry of each app.
+Mutex g_instances_mutex;  // NOLINT
+std::map<const App*, InstallationsInternal*>* g_instances =  // NOLINT
+    nullptr;
+
+// Generates a new installation ID: 16 random bytes, with the top 4 bits set
+// to 0111, in url-safe base64 without padding.
+std::string GenerateFid() {
+  firebase::internal::Uuid uuid;
+  uuid.Generate();
+  uuid.data[0] = (uuid.data[0] & 0x0f) | 0x70;
+  std::string input(reinterpret_cast<char*>(uuid.data), sizeof(uuid.data));
+  std::string output;
+  if (!firebase::internal::Base64EncodeUrlSafe(input, &output)) return "";
+  return output.substr(0, kFidLength);
+}
+
+// Returns the string under `key` in a map, or an empty string.
+std::string GetString(const Variant& map, const char* key) {
+  if (!map.is_map()) return "";
+  auto it = map.map().find(Variant(key));
+  if (it == map.map().end() || !it->second.is_string()) return "";
+  return it->second.string_value();
+}
+
+// Assigns the auth token in `token`, from a response, to `data`.
+bool ParseAuthToken(const Variant& token, InstallationData* data) {
+  std::string auth_token = GetString(token, "token");
+  // Durations are strings with the number of seconds, e.g. "604800s".
+  std::string expires_in = GetString(token, "expiresIn");
+  if (auth_token.empty() || expires_in.empty()) return false;
+  data->auth_token = auth_token;
+  // The expiration is persisted, so it is kept in wall clock time rather
+  // than in time since the system started.
+  data->auth_token_expiration_ms =
+      static_cast<int64_t>(firebase::internal::GetTimestampEpoch()) +
+      std::strtoll(expires_in.c_str(), nullptr, 10) *
+          firebase::internal::kMillisecondsPerSecond;
+  return true;
+}
+
+void SetupRequest(const App& app, const std::string& url, const char* method,
+                  rest::Request* request) {
+  request->set_url(url.c_str());
+  request->set_method(method);
+  request->add_header(rest::util::kContentType, rest::util::kApplicationJson);
+  request->add_header(rest::util::kAccept, rest::util::kApplicationJson);
+  request->add_header(kApiKeyHeader, app.options().api_key());
+  request->options().timeout_ms = kInstallationsRequestTimeoutInMilliseconds;
+}
+
+std::string GetInstallationsURL(const App& app) {
+  return std::string(kInstallationsServerURL) + "/" +
+         app.options().project_id() + kInstallationsPath;
+}
+
+std::string GetStatusError(const char* action, int status) {
+  return std::string("Failed to ") + action + ": http code " +
+         std::to_string(status);
+}
+
+}  // namespace
+
+InstallationsInternal::InstallationsInternal(const firebase::App& app)
+    : app_(app),
+      store_(app),
+      future_impl_(kInstallationsFnCount),
+      force_refresh_(false),
+      requests_scheduled_(false),
+      safe_this_(this) {
+  Init();
+}
+
+InstallationsInternal::InstallationsInternal(const firebase::App& app,
+                                             const InstallationStore& store)
+    : app_(app),
+      store_(store),
+      future_impl_(kInstallationsFnCount),
+      force_refresh_(false),
+      requests_scheduled_(false),
+      safe_this_(this) {
+  Init();
+}
+
+void InstallationsInternal::Init() {
+  rest::InitTransportCurl();
+  store_.Load(&data_);
+
+  MutexLock lock(g_instances_mutex);
+  if (!g_instances) {
+    g_instances = new std::map<const App*, InstallationsInternal*>();
+  }
+  (*g_instances)[&app_] = this;
+  App* app = const_cast<App*>(&app_);
+  app->function_registry()->RegisterFunction(
+      ::firebase::internal::FnInstallationsGetIdAsync, GetIdAsyncForRegistry);
+  app->function_registry()->RegisterFunction(
+      ::firebase::internal::FnInstallationsGetTokenAsync,
+      GetTokenAsyncForRegistry);
+}
+
+InstallationsInternal::~InstallationsInternal() {
+  {
+    MutexLock lock(g_instances_mutex);
+    App* app = const_cast<App*>(&app_);
+    app->function_registry()->UnregisterFunction(
+        ::firebase::internal::FnInstallationsGetTokenAsync);
+    app->function_registry()->UnregisterFunction(
+        ::firebase::internal::FnInstallationsGetIdAsync);
+    g_instances->erase(&app_);
+  }
+  // Waits for a running request to finish.
+  safe_this_.ClearReference();
+  scheduler_.CancelAllAndShutdownWorkerThread();
+  rest::CleanupTransportCurl();
+}
+
+void InstallationsInternal::LogHeartbeat(const firebase::App& app) {}
+
+bool InstallationsInternal::Initialized() const { return true; }
+
+void InstallationsInternal::Cleanup() {}
+
+bool InstallationsInternal::GetIdAsyncForRegistry(App* app, void* /*unused*/,
+                                                  void* out) {
+  MutexLock lock(g_instances_mutex);
+  if (!g_instances) return false;
+  auto it = g_instances->find(app);
+  if (it == g_instances->end()) return false;
+  Future<std::string> future =
+      it->second->GetIdInternal(kInstallationsFnGetIdForRegistry);
+  if (out) *static_cast<Future<std::string>*>(out) = future;
+  return true;
+}
+
+bool InstallationsInternal::GetTokenAsyncForRegistry(App* app,
+                                                     void* force_refresh,
+                                                     void* out) {
+  MutexLock lock(g_instances_mutex);
+  if (!g_instances) return false;
+  auto it = g_instances->find(app);
+  if (it == g_instances->end()) return false;
+  Future<std::string> future = it->second->GetTokenInternal(
+      force_refresh && *static_cast<bool*>(force_refresh),
+      kInstallationsFnGetTokenForRegistry);
+  if (out) *static_cast<Future<std::string>*>(out) = future;
+  return true;
+}
+
+Future<std::string> InstallationsInternal::GetId() {
+  return GetIdInternal(kInstallationsFnGetId);
+}
+
+Future<std::string> InstallationsInternal::GetIdLastResult() {
+  return static_cast<const Future<std::string>&>(
+      future_impl_.LastResult(kInstallationsFnGetId));
+}
+
+Future<std::string> InstallationsInternal::GetToken(bool forceRefresh) {
+  return GetTokenInternal(forceRefresh, kInstallationsFnGetToken);
+}
+
+Future<std::string> InstallationsInternal::GetTokenLastResult() {
+  return static_cast<const Future<std::string>&>(
+      future_impl_.LastResult(kInstallationsFnGetToken));
+}
+
+Future<std::string> InstallationsInternal::GetIdInternal(int fn_idx) {
+  const auto handle = future_impl_.SafeAlloc<std::string>(fn_idx);
+  std::string fid;
+  {
+    MutexLock lock(mutex_);
+    if (data_.registered()) {
+      fid = data_.fid;
+    } else {
+      pending_id_handles_.push_back(handle);
+      ScheduleRequestsLocked();
+    }
+  }
+  // Completed outside the lock, as completion runs the future's callbacks.
+  if (!fid.empty()) {
+    future_impl_.CompleteWithResult(handle, kInstallationsErrorNone, "", fid);
+  }
+  return MakeFuture<std::string>(&future_impl_, handle);
+}
+
+Future<std::string> InstallationsInternal::GetTokenInternal(bool force_refresh,
+                                                           int fn_idx) {
+  const auto handle = future_impl_.SafeAlloc<std::string>(fn_idx);
+  std::string auth_token;
+  {
+    MutexLock lock(mutex_);
+    if (!force_refresh && data_.registered() && HasValidToken()) {
+      auth_token = data_.auth_token;
+    } else {
+      if (force_refresh) force_refresh_ = true;
+      pending_token_handles_.push_back(handle);
+      ScheduleRequestsLocked();
+    }
+  }
+  if (!auth_token.empty()) {
+    future_impl_.CompleteWithResult(handle, kInstallationsErrorNone, "",
+                                    auth_token);
+  }
+  return MakeFuture<std::string>(&future_impl_, handle);
+}
+
+bool InstallationsInternal::HasValidToken() const {
+  return !data_.auth_token.empty() &&
+         data_.auth_token_expiration_ms - kTokenRefreshBufferInMilliseconds >
+             static_cast<int64_t>(firebase::internal::GetTimestampEpoch());
+}
+
+void InstallationsInternal::ScheduleRequestsLocked() {
+  if (requests_scheduled_) return;
+  requests_scheduled_ = true;
+  scheduler_.Schedule(callback::NewCallback(
+      [](ThisRef ref) {
+        ThisRefLock lock(&ref);
+        if (lock.GetReference() != nullptr) {
+          lock.GetReference()->SendRequests();
+        }
+      },
+      safe_this_));
+}
+
+void InstallationsInternal::SendRequests() {
+  InstallationData data;
+  bool needs_token;
+  bool force_refresh;
+  {
+    MutexLock lock(mutex_);
+    data = data_;
+    needs_token = !pending_token_handles_.empty();
+    force_refresh = force_refresh_;
+    force_refresh_ = false;
+  }
+
+  bool success = true;
+  std::string error;
+  InstallationData original = data;
+  if (data.fid.empty()) data.fid = GenerateFid();
+  if (!data.registered()) {
+    success = CreateInstallation(&data, &error);
+  } else if (needs_token) {
+    bool token_valid;
+    {
+      MutexLock lock(mutex_);
+      token_valid = HasValidToken();
+    }
+    if (force_refresh || !token_valid) {
+      int status = 0;
+      success = GenerateAuthToken(&data, &status, &error);
+      if (!success && (status == rest::util::HttpUnauthorized ||
+                       status == rest::util::HttpNotFound)) {
+        // The backend no longer knows the installation, so start over with a
+        // new one.
+        LogDebug("Installation %s is no longer valid, creating a new one",
+                 data.fid.c_str());
+        data = InstallationData();
+        data.fid = GenerateFid();
+        success = CreateInstallation(&data, &error);
+      }
+    }
+  }
+  // Even a failed registration keeps its new ID, to retry with the same one.
+  bool changed = !(data == original);
+  if (changed) store_.Save(data);
+
+  std::vector<SafeFutureHandle<std::string>> id_handles;
+  std::vector<SafeFutureHandle<std::string>> token_handles;
+  {
+    MutexLock lock(mutex_);
+    if (changed) data_ = data;
+    requests_scheduled_ = false;
+    id_handles.swap(pending_id_handles_);
+    if (force_refresh_) {
+      // A new token was asked for after this one was requested, so the token
+      // futures wait for another round.
+      ScheduleRequestsLocked();
+    } else {
+      token_handles.swap(pending_token_handles_);
+    }
+  }
+
+  for (const auto& handle : id_handles) {
+    if (success) {
+      future_impl_.CompleteWithResult(handle, kInstallationsErrorNone, "",
+                                      data.fid);
+    } else {
+      future_impl_.Complete(handle, kInstallationsErrorFailure, error.c_str());
+    }
+  }
+  for (const auto& handle : token_handles) {
+    if (success) {
+      future_impl_.CompleteWithResult(handle, kInstallationsErrorNone, "",
+                                      data.auth_token);
+    } else {
+      future_impl_.Complete(handle, kInstallationsErrorFailure, error.c_str());
+    }
+  }
+}
+
+bool InstallationsInternal::CreateInstallation(InstallationData* data,
+                                               std::string* error) {
+  rest::Request request;
+  SetupRequest(app_, GetInstallationsURL(app_), rest::util::kPost, &request);
+  Variant body = Variant::EmptyMap();
+  body.map()["fid"] = data->fid;
+  body.map()["appId"] = app_.options().app_id();
+  body.map()["authVersion"] = kAuthVersion;
+  body.map()["sdkVersion"] = kSdkVersion;
+  std::string json = util::VariantToJson(body);
+  request.set_post_fields(json.c_str(), json.size());
+
+  rest::Response response;
+  rest::CreateTransport()->Perform(request, &response);
+  if (response.status() != rest::util::HttpSuccess) {
+    *error = GetStatusError("register installation", response.status());
+    LogError("%s %s", error->c_str(), response.GetBody());
+    return false;
+  }
+  Variant result = util::JsonToVariant(response.GetBody());
+  std::string refresh_token = GetString(result, "refreshToken");
+  InstallationData registered;
+  if (refresh_token.empty() || !result.is_map() ||
+      !ParseAuthToken(result.map()[Variant("authToken")], &registered)) {
+    *error = "Malformed response when registering installation";
+    LogError("%s", error->c_str());
+    return false;
+  }
+  // The backend can replace an ID it does not accept.
+  std::string fid = GetString(result, "fid");
+  if (!fid.empty()) data->fid = fid;
+  data->refresh_token = refresh_token;
+  data->auth_token = registered.auth_token;
+  data->auth_token_expiration_ms = registered.auth_token_expiration_ms;
+  return true;
+}
+
+bool InstallationsInternal::GenerateAuthToken(InstallationData* data,
+                                              int* status,
+                                              std::string* error) {
+  rest::Request request;
+  SetupRequest(app_,
+               GetInstallationsURL(app_) + "/" + data->fid +
+                   kGenerateAuthTokenMethod,
+               rest::util::kPost, &request);
+  request.add_header(
+      rest::util::kAuthorization,
+      (std::string(kAuthVersion) + " " + data->refresh_token).c_str());
+  Variant installation = Variant::EmptyMap();
+  installation.map()["sdkVersion"] = kSdkVersion;
+  Variant body = Variant::EmptyMap();
+  body.map()["installation"] = installation;
+  std::string json = util::VariantToJson(body);
+  request.set_post_fields(json.c_str(), json.size());
+
+  rest::Response response;
+  rest::CreateTransport()->Perform(request, &response);
+  *status = response.status();
+  if (response.status() != rest::util::HttpSuccess) {
+    *error = GetStatusError("get auth token", response.status());
+    LogError("%s %s", error->c_str(), response.GetBody());
+    return false;
+  }
+  if (!ParseAuthToken(util::JsonToVariant(response.GetBody()), data)) {
+    *error = "Malformed response when getting auth token";
+    LogError("%s", error->c_str());
+    return false;
+  }
+  return true;
+}
+
+bool InstallationsInternal::DeleteInstallation(const InstallationData& data,
+                                               std::string* error) {
+  rest::Request request;
+  SetupRequest(app_, GetInstallationsURL(app_) + "/" + data.fid,
+               kHttpMethodDelete, &request);
+  request.add_header(
+      rest::util::kAuthorization,
+      (std::string(kAuthVersion) + " " + data.refresh_token).c_str());
+
+  rest::Response response;
+  rest::CreateTransport()->Perform(request, &response);
+  // An installation the backend does not know about is already deleted.
+  if (response.status() != rest::util::HttpSuccess &&
+      response.status() != rest::util::HttpNotFound) {
+    *error = GetStatusError("delete installation", response.status());
+    LogError("%s %s", error->c_str(), response.GetBody());
+    return false;
+  }
+  return true;
+}
+
+Future<void> InstallationsInternal::Delete() {
+  const auto handle = future_impl_.SafeAlloc<void>(kInstallationsFnDelete);
+  // Runs after any request already scheduled, as the scheduler runs one
+  // callback at a time.
+  scheduler_.Schedule(callback::NewCallback(
+      [](ThisRef ref, SafeFutureHandle<void> handle) {
+        ThisRefLock lock(&ref);
+        InstallationsInternal* installations = lock.GetReference();
+        if (installations == nullptr) return;
+        InstallationData data;
+        {
+          MutexLock data_lock(installations->mutex_);
+          data = installations->data_;
+        }
+        std::string error;
+        if (data.registered() &&
+            !installations->DeleteInstallation(data, &error)) {
+          installations->future_impl_.Complete(
+              handle, kInstallationsErrorFailure, error.c_str());
+          return;
+        }
+        {
+          MutexLock data_lock(installations->mutex_);
+          installations->data_ = InstallationData();
+        }
+        installations->store_.Clear();
+        installations->future_impl_.Complete(handle, kInstallationsErrorNone);
+      },
+      safe_this_, handle));
+  return MakeFuture<void>(&future_impl_, handle);
+}
+
+Future<void> InstallationsInternal::DeleteLastResult() {
+  return static_cast<const Future<void>&>(
+      future_impl_.LastResult(kInstallationsFnDelete));
+}
+
+}  // namespace internal
+}  // namespace installations
+}  // namespace firebase
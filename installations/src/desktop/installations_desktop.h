@@ -0,0 +1,162 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FIREBASE_INSTALLATIONS_SRC_DESKTOP_INSTALLATIONS_DESKTOP_H_
+#define FIREBASE_INSTALLATIONS_SRC_DESKTOP_INSTALLATIONS_DESKTOP_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/reference_counted_future_impl.h"
+#include "app/src/safe_reference.h"
+#include "app/src/scheduler.h"
+#include "firebase/app.h"
+#include "firebase/future.h"
+#include "firebase/internal/common.h"
+#include "installations/src/desktop/installation_store.h"
+
+#ifdef FIREBASE_TESTING
+#include "gtest/gtest.h"
+#endif  // FIREBASE_TESTING
+
+namespace firebase {
+namespace installations {
+namespace internal {
+
+const char* const kInstallationsServerURL =
+    "https://firebaseinstallations.googleapis.com/v1/projects";
+const char* const kInstallationsPath = "/installations";
+const char* const kGenerateAuthTokenMethod = "/authTokens:generate";
+const char* const kApiKeyHeader = "X-Goog-Api-Key";
+const char* const kAuthVersion = "FIS_v2";
+const char* const kHttpMethodDelete = "DELETE";
+
+// Auth tokens are refreshed once they are this close to expiring, so that a
+// token handed out is still good for a while.
+const int64_t kTokenRefreshBufferInMilliseconds = 60 * 60 * 1000;
+
+const int kInstallationsRequestTimeoutInMilliseconds = 30 * 1000;
+
+// Installations Client implementation for desktop.
+//
+// The installation is registered with the Firebase Installations backend the
+// first time an ID or token is requested, and persisted so that it is kept
+// across runs. Requests run one at a time on a background thread: calls that
+// arrive while a request is in flight wait for its result instead of making
+// requests of their own.
+//
+// The ID and token are also shared with other products through the app's
+// function registry.
+//
+// This class implements functions from `firebase/installations.h` header.
+// See `firebase/installations.h` for all public functions documentation.
+class InstallationsInternal {
+ public:
+#ifdef FIREBASE_TESTING
+  friend class InstallationsDesktopTest;
+#endif  // FIREBASE_TESTING
+
+  explicit InstallationsInternal(const firebase::App& app);
+
+  // Persists the installation in `store` instead of the app data directory.
+  InstallationsInternal(const firebase::App& app,
+                        const InstallationStore& store);
+
+  ~InstallationsInternal();
+
+  // Platform-specific method that causes a heartbeat to be logged.
+  // See go/firebase-platform-logging-design for more information.
+  static void LogHeartbeat(const firebase::App& app);
+
+  Future<std::string> GetId();
+  Future<std::string> GetIdLastResult();
+
+  Future<void> Delete();
+  Future<void> DeleteLastResult();
+
+  Future<std::string> GetToken(bool forceRefresh);
+  Future<std::string> GetTokenLastResult();
+
+  bool Initialized() const;
+
+  void Cleanup();
+
+ private:
+  typedef firebase::internal::SafeReference<InstallationsInternal> ThisRef;
+  typedef firebase::internal::SafeReferenceLock<InstallationsInternal>
+      ThisRefLock;
+
+  void Init();
+
+  // Functions for the app's function registry. Both return a future for the
+  // result through `out`, which is a `Future<std::string>*`. Getting a token
+  // takes a `bool*` that forces a refresh.
+  static bool GetIdAsyncForRegistry(App* app, void* unused, void* out);
+  static bool GetTokenAsyncForRegistry(App* app, void* force_refresh,
+                                       void* out);
+
+  Future<std::string> GetIdInternal(int fn_idx);
+  Future<std::string> GetTokenInternal(bool force_refresh, int fn_idx);
+
+  // Returns true if the auth token does not need refreshing yet. Requires
+  // mutex_.
+  bool HasValidToken() const;
+
+  // Schedules SendRequests() unless it is already scheduled. Requires mutex_.
+  void ScheduleRequestsLocked();
+
+  // Runs on the scheduler. Registers the installation if needed and refreshes
+  // the auth token if requested, then completes every future waiting on them.
+  void SendRequests();
+
+  // Registers `data->fid` with the backend, and assigns the refresh token and
+  // first auth token. The backend may also assign a different ID.
+  bool CreateInstallation(InstallationData* data, std::string* error);
+
+  // Assigns a new auth token to `data`. Assigns the http status to `status`.
+  bool GenerateAuthToken(InstallationData* data, int* status,
+                         std::string* error);
+
+  // Removes the installation from the backend.
+  bool DeleteInstallation(const InstallationData& data, std::string* error);
+
+  const firebase::App& app_;  // NOLINT
+  InstallationStore store_;
+
+  /// Handle calls from Futures that the API returns.
+  ReferenceCountedFutureImpl future_impl_;
+
+  Mutex mutex_;
+  // The installation, as last loaded or updated.
+  InstallationData data_;
+  // Futures waiting for the ID or the token.
+  std::vector<SafeFutureHandle<std::string>> pending_id_handles_;
+  std::vector<SafeFutureHandle<std::string>> pending_token_handles_;
+  // Whether a waiting token future asked for a new token.
+  bool force_refresh_;
+  // Whether SendRequests() is scheduled or running.
+  bool requests_scheduled_;
+
+  scheduler::Scheduler scheduler_;
+
+  ThisRef safe_this_;
+};
+
+}  // namespace internal
+}  // namespace installations
+}  // namespace firebase
+
+#endif  // FIREBASE_INSTALLATIONS_SRC_DESKTOP_INSTALLATIONS_DESKTOP_H_
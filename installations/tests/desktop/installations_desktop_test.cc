@@ -0,0 +1,438 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "installations/src/desktop/installations_desktop.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_builder.h"
+#include "app/rest/transport_interface.h"
+#include "app/rest/util.h"
+#include "app/src/function_registry.h"
+#include "app/src/include/firebase/internal/platform.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/semaphore.h"
+#include "app/src/time.h"
+#include "app/src/variant_util.h"
+#include "app/tests/include/firebase/app_for_testing.h"
+#include "firebase/app.h"
+#include "firebase/future.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "installations/src/common.h"
+#include "installations/src/desktop/installation_store.h"
+
+#if !FIREBASE_PLATFORM_WINDOWS
+#include <sys/stat.h>
+#endif  // !FIREBASE_PLATFORM_WINDOWS
+
+namespace firebase {
+namespace installations {
+namespace internal {
+
+using ::testing::AllOf;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Le;
+using ::testing::Ne;
+using ::testing::SizeIs;
+
+const int kTimeoutInMilliseconds = 5000;
+
+// A request as seen by the fake backend.
+struct ReceivedRequest {
+  std::string method;
+  std::string url;
+  std::string authorization;
+  std::string body;
+};
+
+// Stands in for the Installations backend. Registers installations with the
+// ID they were sent with, and hands out numbered tokens.
+class FakeInstallationsBackend {
+ public:
+  FakeInstallationsBackend()
+      : create_status_(rest::util::HttpSuccess),
+        generate_status_(rest::util::HttpSuccess),
+        tokens_(0),
+        blocked_(false),
+        arrived_(0),
+        released_(0) {}
+
+  void Handle(rest::Request* request, rest::Response* response) {
+    ReceivedRequest received;
+    received.method = request->options().method;
+    received.url = request->options().url;
+    auto authorization =
+        request->options().header.find(rest::util::kAuthorization);
+    if (authorization != request->options().header.end()) {
+      received.authorization = authorization->second;
+    }
+    request->ReadBodyIntoString(&received.body);
+
+    bool blocked;
+    {
+      MutexLock lock(mutex_);
+      requests_.push_back(received);
+      blocked = blocked_;
+    }
+    if (blocked) {
+      arrived_.Post();
+      released_.Wait();
+    }
+
+    MutexLock lock(mutex_);
+    std::string body;
+    int status = rest::util::HttpSuccess;
+    if (received.method == kHttpMethodDelete) {
+      body = "{}";
+    } else if (EndsWith(received.url, kGenerateAuthTokenMethod)) {
+      status = generate_status_;
+      if (status == rest::util::HttpSuccess) body = TokenJson();
+    } else {
+      status = create_status_;
+      if (status == rest::util::HttpSuccess) {
+        Variant sent = util::JsonToVariant(received.body.c_str());
+        body = std::string("{\"fid\": \"") +
+               sent.map()[Variant("fid")].string_value() +
+               "\", \"refreshToken\": \"refresh-token\", \"authToken\": " +
+               TokenJson() + "}";
+      }
+    }
+    response->set_status(status);
+    response->ProcessBody(body.c_str(), body.size());
+    response->MarkCompleted();
+  }
+
+  // Makes requests wait until Release() is called.
+  void Block() {
+    MutexLock lock(mutex_);
+    blocked_ = true;
+  }
+
+  bool WaitForBlockedRequest() {
+    return arrived_.TimedWait(kTimeoutInMilliseconds);
+  }
+
+  void Release() {
+    {
+      MutexLock lock(mutex_);
+      blocked_ = false;
+    }
+    released_.Post();
+  }
+
+  void set_create_status(int status) {
+    MutexLock lock(mutex_);
+    create_status_ = status;
+  }
+
+  void set_generate_status(int status) {
+    MutexLock lock(mutex_);
+    generate_status_ = status;
+  }
+
+  std::vector<ReceivedRequest> requests() {
+    MutexLock lock(mutex_);
+    return requests_;
+  }
+
+ private:
+  static bool EndsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(),
+                         suffix) == 0;
+  }
+
+  // Requires mutex_.
+  std::string TokenJson() {
+    return "{\"token\": \"token-" + std::to_string(++tokens_) +
+           "\", \"expiresIn\": \"604800s\"}";
+  }
+
+  Mutex mutex_;
+  int create_status_;
+  int generate_status_;
+  int tokens_;
+  bool blocked_;
+  std::vector<ReceivedRequest> requests_;
+  Semaphore arrived_;
+  Semaphore released_;
+};
+
+FakeInstallationsBackend* g_backend = nullptr;
+
+class FakeInstallationsTransport : public rest::Transport {
+ private:
+  void PerformInternal(
+      rest::Request* request, rest::Response* response,
+      flatbuffers::unique_ptr<rest::Controller>* controller_out) override {
+    g_backend->Handle(request, response);
+  }
+};
+
+class InstallationsDesktopTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_backend = &backend_;
+    rest::SetTransportBuilder([]() -> flatbuffers::unique_ptr<rest::Transport> {
+      return flatbuffers::unique_ptr<rest::Transport>(
+          new FakeInstallationsTransport());
+    });
+    file_path_ =
+        ::testing::TempDir() + "installation-" +
+        ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::remove(file_path_.c_str());
+    app_.reset(testing::CreateApp());
+    CreateInstallations();
+  }
+
+  void TearDown() override {
+    installations_.reset(nullptr);
+    app_.reset(nullptr);
+    std::remove(file_path_.c_str());
+    g_backend = nullptr;
+  }
+
+  void CreateInstallations() {
+    installations_.reset(nullptr);
+    installations_.reset(
+        new InstallationsInternal(*app_, InstallationStore(file_path_)));
+  }
+
+  InstallationData data() {
+    MutexLock lock(installations_->mutex_);
+    return installations_->data_;
+  }
+
+  void set_data(const InstallationData& data) {
+    MutexLock lock(installations_->mutex_);
+    installations_->data_ = data;
+  }
+
+  template <typename T>
+  static void ExpectSuccess(const Future<T>& future) {
+    ASSERT_TRUE(future.Wait(kTimeoutInMilliseconds));
+    EXPECT_THAT(future.error(), Eq(kInstallationsErrorNone))
+        << future.error_message();
+  }
+
+  static std::string Result(const Future<std::string>& future) {
+    EXPECT_TRUE(future.Wait(kTimeoutInMilliseconds));
+    return future.result() ? *future.result() : std::string();
+  }
+
+  // Declared first, so that it outlives the installations using it.
+  FakeInstallationsBackend backend_;
+  std::string file_path_;
+  std::unique_ptr<App> app_;
+  std::unique_ptr<InstallationsInternal> installations_;
+};
+
+TEST_F(InstallationsDesktopTest, RegistersInstallation) {
+  Future<std::string> id = installations_->GetId();
+  ExpectSuccess(id);
+  EXPECT_THAT(*id.result(), SizeIs(22));
+  EXPECT_THAT((*id.result())[0], ::testing::AnyOf('c', 'd', 'e', 'f'));
+
+  std::vector<ReceivedRequest> requests = backend_.requests();
+  ASSERT_THAT(requests, SizeIs(1));
+  EXPECT_THAT(requests[0].url,
+              Eq(std::string(kInstallationsServerURL) + "/" +
+                 app_->options().project_id() + kInstallationsPath));
+  EXPECT_THAT(requests[0].body, HasSubstr(*id.result()));
+  EXPECT_THAT(requests[0].body, HasSubstr(app_->options().app_id()));
+  EXPECT_THAT(Result(installations_->GetToken(false)), Eq("token-1"));
+  EXPECT_THAT(backend_.requests(), SizeIs(1));
+}
+
+TEST_F(InstallationsDesktopTest, SharesRequestBetweenConcurrentCalls) {
+  backend_.Block();
+  std::vector<Future<std::string>> futures;
+  futures.push_back(installations_->GetToken(false));
+  ASSERT_TRUE(backend_.WaitForBlockedRequest());
+  futures.push_back(installations_->GetToken(false));
+  futures.push_back(installations_->GetId());
+  futures.push_back(installations_->GetToken(false));
+  backend_.Release();
+
+  EXPECT_THAT(Result(futures[0]), Eq("token-1"));
+  EXPECT_THAT(Result(futures[1]), Eq("token-1"));
+  EXPECT_THAT(Result(futures[2]), Eq(data().fid));
+  EXPECT_THAT(Result(futures[3]), Eq("token-1"));
+  EXPECT_THAT(backend_.requests(), SizeIs(1));
+}
+
+TEST_F(InstallationsDesktopTest, PersistsInstallation) {
+  std::string fid = Result(installations_->GetId());
+  InstallationData registered = data();
+  CreateInstallations();
+  EXPECT_THAT(data(), Eq(registered));
+  EXPECT_THAT(Result(installations_->GetId()), Eq(fid));
+  EXPECT_THAT(Result(installations_->GetToken(false)), Eq("token-1"));
+  EXPECT_THAT(backend_.requests(), SizeIs(1));
+}
+
+#if !FIREBASE_PLATFORM_WINDOWS
+TEST_F(InstallationsDesktopTest, OnlyTheUserCanReadTheStoredInstallation) {
+  // Replaces a file that others could read.
+  FILE* file = fopen(file_path_.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  fclose(file);
+  chmod(file_path_.c_str(), 0644);
+
+  InstallationData saved;
+  saved.fid = "fid";
+  saved.refresh_token = "refresh";
+  InstallationStore store(file_path_);
+  ASSERT_TRUE(store.Save(saved));
+
+  struct stat info;
+  ASSERT_EQ(stat(file_path_.c_str(), &info), 0);
+  EXPECT_THAT(info.st_mode & 0777, Eq(S_IRUSR | S_IWUSR));
+  EXPECT_NE(stat((file_path_ + ".tmp").c_str(), &info), 0);
+  InstallationData loaded;
+  ASSERT_TRUE(store.Load(&loaded));
+  EXPECT_THAT(loaded, Eq(saved));
+}
+#endif  // !FIREBASE_PLATFORM_WINDOWS
+
+TEST_F(InstallationsDesktopTest, TokenExpirationIsSinceTheEpoch) {
+  int64_t before =
+      static_cast<int64_t>(firebase::internal::GetTimestampEpoch());
+  ExpectSuccess(installations_->GetToken(false));
+  int64_t after = static_cast<int64_t>(firebase::internal::GetTimestampEpoch());
+  // The backend hands out tokens that are good for 604800 seconds.
+  const int64_t expires_in =
+      604800 * firebase::internal::kMillisecondsPerSecond;
+  EXPECT_THAT(data().auth_token_expiration_ms,
+              AllOf(Ge(before + expires_in), Le(after + expires_in)));
+}
+
+TEST_F(InstallationsDesktopTest, RefreshesTokenAheadOfExpiry) {
+  ExpectSuccess(installations_->GetToken(false));
+  InstallationData registered = data();
+  int64_t now = static_cast<int64_t>(firebase::internal::GetTimestampEpoch());
+
+  // Still good for longer than the refresh buffer.
+  registered.auth_token_expiration_ms =
+      now + 2 * kTokenRefreshBufferInMilliseconds;
+  set_data(registered);
+  EXPECT_THAT(Result(installations_->GetToken(false)), Eq("token-1"));
+  EXPECT_THAT(backend_.requests(), SizeIs(1));
+
+  // About to expire.
+  registered.auth_token_expiration_ms =
+      now + kTokenRefreshBufferInMilliseconds / 2;
+  set_data(registered);
+  EXPECT_THAT(Result(installations_->GetToken(false)), Eq("token-2"));
+  std::vector<ReceivedRequest> requests = backend_.requests();
+  ASSERT_THAT(requests, SizeIs(2));
+  EXPECT_THAT(requests[1].url,
+              HasSubstr(registered.fid + kGenerateAuthTokenMethod));
+  EXPECT_THAT(requests[1].authorization, Eq("FIS_v2 refresh-token"));
+  EXPECT_THAT(data().auth_token, Eq("token-2"));
+}
+
+TEST_F(InstallationsDesktopTest, ForceRefreshGetsNewToken) {
+  EXPECT_THAT(Result(installations_->GetToken(false)), Eq("token-1"));
+  EXPECT_THAT(Result(installations_->GetToken(true)), Eq("token-2"));
+  EXPECT_THAT(Result(installations_->GetToken(false)), Eq("token-2"));
+  EXPECT_THAT(backend_.requests(), SizeIs(2));
+}
+
+TEST_F(InstallationsDesktopTest, ForceRefreshDuringRequestGetsNewerToken) {
+  ExpectSuccess(installations_->GetToken(false));
+  backend_.Block();
+  Future<std::string> first = installations_->GetToken(true);
+  ASSERT_TRUE(backend_.WaitForBlockedRequest());
+  // Asked for after the first request was sent, so it needs another one.
+  Future<std::string> second = installations_->GetToken(true);
+  backend_.Release();
+  EXPECT_THAT(Result(first), Eq("token-3"));
+  EXPECT_THAT(Result(second), Eq("token-3"));
+  EXPECT_THAT(backend_.requests(), SizeIs(3));
+}
+
+TEST_F(InstallationsDesktopTest, RegistersAgainWhenInstallationIsUnknown) {
+  std::string fid = Result(installations_->GetId());
+  backend_.set_generate_status(404);
+  EXPECT_THAT(Result(installations_->GetToken(true)), Eq("token-2"));
+  EXPECT_THAT(data().fid, Ne(fid));
+  EXPECT_THAT(Result(installations_->GetId()), Eq(data().fid));
+  EXPECT_THAT(backend_.requests(), SizeIs(3));
+}
+
+TEST_F(InstallationsDesktopTest, RetriesFailedRegistrationWithSameId) {
+  backend_.set_create_status(503);
+  Future<std::string> id = installations_->GetId();
+  ASSERT_TRUE(id.Wait(kTimeoutInMilliseconds));
+  EXPECT_THAT(id.error(), Eq(kInstallationsErrorFailure));
+  std::string fid = data().fid;
+  EXPECT_THAT(fid, SizeIs(22));
+
+  backend_.set_create_status(200);
+  EXPECT_THAT(Result(installations_->GetId()), Eq(fid));
+  std::vector<ReceivedRequest> requests = backend_.requests();
+  ASSERT_THAT(requests, SizeIs(2));
+  EXPECT_THAT(requests[1].body, HasSubstr(fid));
+}
+
+TEST_F(InstallationsDesktopTest, DeleteRemovesInstallation) {
+  std::string fid = Result(installations_->GetId());
+  ExpectSuccess(installations_->Delete());
+  std::vector<ReceivedRequest> requests = backend_.requests();
+  ASSERT_THAT(requests, SizeIs(2));
+  EXPECT_THAT(requests[1].method, Eq(kHttpMethodDelete));
+  EXPECT_THAT(requests[1].url, HasSubstr(fid));
+  EXPECT_THAT(requests[1].authorization, Eq("FIS_v2 refresh-token"));
+  EXPECT_THAT(data().fid, IsEmpty());
+
+  // Nothing is left to load, so a new installation is registered.
+  CreateInstallations();
+  EXPECT_THAT(Result(installations_->GetId()), Ne(fid));
+}
+
+TEST_F(InstallationsDesktopTest, SharesTokenThroughFunctionRegistry) {
+  bool force_refresh = false;
+  Future<std::string> token;
+  ASSERT_TRUE(app_->function_registry()->CallFunction(
+      ::firebase::internal::FnInstallationsGetTokenAsync, app_.get(),
+      &force_refresh, &token));
+  EXPECT_THAT(Result(token), Eq("token-1"));
+  Future<std::string> id;
+  ASSERT_TRUE(app_->function_registry()->CallFunction(
+      ::firebase::internal::FnInstallationsGetIdAsync, app_.get(), nullptr,
+      &id));
+  EXPECT_THAT(Result(id), Eq(data().fid));
+  // The registry does not replace the results of the public calls.
+  EXPECT_THAT(installations_->GetTokenLastResult().status(),
+              Eq(kFutureStatusInvalid));
+
+  installations_.reset(nullptr);
+  EXPECT_FALSE(app_->function_registry()->CallFunction(
+      ::firebase::internal::FnInstallationsGetTokenAsync, app_.get(),
+      &force_refresh, &token));
+}
+
+}  // namespace internal
+}  // namespace installations
+}  // namespace firebase
@@ -39,6 +39,12 @@
 #undef __ANDROID__
 #endif  // defined(FIREBASE_ANDROID_FOR_DESKTOP)
 
+#if FIREBASE_PLATFORM_DESKTOP && !defined(FIREBASE_ANDROID_FOR_DESKTOP)
+#include "app/rest/transport_builder.h"
+#include "app/rest/transport_mock.h"
+#include "installations/src/desktop/installations_desktop.h"
+#endif  // FIREBASE_PLATFORM_DESKTOP && !defined(FIREBASE_ANDROID_FOR_DESKTOP)
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "testing/config.h"
@@ -55,7 +61,11 @@ class InstallationsTest : public ::testing::Test {
  protected:
   void SetUp() override {
     firebase::testing::cppsdk::TickerReset();
+#if FIREBASE_PLATFORM_DESKTOP && !defined(FIREBASE_ANDROID_FOR_DESKTOP)
+    SetUpFakeBackend();
+#else
     firebase::testing::cppsdk::ConfigSet("{}");
+#endif  // FIREBASE_PLATFORM_DESKTOP && !defined(FIREBASE_ANDROID_FOR_DESKTOP)
     reporter_.reset();
 
     firebase_app_ = testing::CreateApp();
@@ -70,6 +80,44 @@ class InstallationsTest : public ::testing::Test {
                 ::testing::Eq(reporter_.getExpectations()));
   }
 
+#if FIREBASE_PLATFORM_DESKTOP && !defined(FIREBASE_ANDROID_FOR_DESKTOP)
+  // Serves the same values as the Android and iOS fakes from the
+  // Installations backend.
+  void SetUpFakeBackend() {
+    rest::SetTransportBuilder([]() -> flatbuffers::unique_ptr<rest::Transport> {
+      return flatbuffers::unique_ptr<rest::Transport>(new rest::TransportMock);
+    });
+    std::string installations_url =
+        std::string(internal::kInstallationsServerURL) + "/" +
+        testing::MockAppOptions().project_id() + internal::kInstallationsPath;
+    char config[2000];
+    snprintf(config, sizeof(config),
+             "{"
+             "  config:["
+             "    {fake:'%s',"
+             "     httpresponse: {"
+             "       header: ['HTTP/1.1 200 Ok'],"
+             "       body: ['{\"fid\": \"FakeId\",',"
+             "              '\"refreshToken\": \"FakeRefreshToken\",',"
+             "              '\"authToken\": {\"token\": \"FakeToken\",',"
+             "              '\"expiresIn\": \"604800s\"}}']"
+             "     }"
+             "    },"
+             "    {fake:'%s/FakeId%s',"
+             "     httpresponse: {"
+             "       header: ['HTTP/1.1 200 Ok'],"
+             "       body: ['{\"token\": \"FakeTokenForceRefresh\",',"
+             "              '\"expiresIn\": \"604800s\"}']"
+             "     }"
+             "    }"
+             "  ]"
+             "}",
+             installations_url.c_str(), installations_url.c_str(),
+             internal::kGenerateAuthTokenMethod);
+    firebase::testing::cppsdk::ConfigSet(config);
+  }
+#endif  // FIREBASE_PLATFORM_DESKTOP && !defined(FIREBASE_ANDROID_FOR_DESKTOP)
+
   // Wait for a future up to the specified number of milliseconds.
   template <typename T>
   static void WaitForFutureWithTimeout(
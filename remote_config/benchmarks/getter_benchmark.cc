@@ -0,0 +1,162 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "app/src/include/firebase/app.h"
+#include "benchmark/benchmark.h"
+#include "remote_config/src/desktop/config_data.h"
+#include "remote_config/src/desktop/file_manager.h"
+#include "remote_config/src/desktop/metadata.h"
+#include "remote_config/src/desktop/remote_config_desktop.h"
+#include "remote_config/src/include/firebase/remote_config.h"
+
+namespace firebase {
+namespace remote_config {
+namespace internal {
+namespace {
+
+const char* const kNamespace = "firebase";
+const char* const kConfigFile = "remote_config_getter_benchmark_data";
+
+// Types the values are read as, in turn.
+const ValueType kTypes[] = {kValueTypeBoolean, kValueTypeLong,
+                            kValueTypeDouble, kValueTypeString};
+const char* const kValues[] = {"true", "12345", "0.5", "a string value"};
+const int kTypeCount = sizeof(kTypes) / sizeof(kTypes[0]);
+
+AppOptions MakeOptions() {
+  AppOptions options;
+  options.set_app_id("com.google.firebase.benchmark");
+  options.set_api_key("not_a_real_api_key");
+  options.set_project_id("not_a_real_project_id");
+  return options;
+}
+
+// Holds a Remote Config instance with `entry_count` keys, half of them
+// activated and the rest only set as defaults, like an app that fetched
+// values for some of its keys.
+class Fixture {
+ public:
+  explicit Fixture(int entry_count)
+      : app_(App::Create(MakeOptions(), "benchmark")),
+        file_manager_(kConfigFile) {
+    std::map<std::string, std::string> active;
+    std::map<std::string, std::string> defaults;
+    char key[32];
+    for (int i = 0; i < entry_count; ++i) {
+      snprintf(key, sizeof(key), "config_key_%d", i);
+      keys_.push_back(key);
+      values_.push_back(ConfigValue(nullptr, kTypes[i % kTypeCount]));
+      const char* value = kValues[i % kTypeCount];
+      defaults[key] = value;
+      if (i % 2 == 0) active[key] = value;
+    }
+    // The keys must outlive the ConfigValues pointing at them.
+    for (int i = 0; i < entry_count; ++i) values_[i].key = keys_[i].c_str();
+
+    LayeredConfigs configs(
+        NamespacedConfigData(),
+        NamespacedConfigData(NamespaceKeyValueMap({{kNamespace, active}}), 1),
+        NamespacedConfigData(NamespaceKeyValueMap({{kNamespace, defaults}}),
+                             1),
+        RemoteConfigMetadata());
+    file_manager_.Save(configs);
+    remote_config_ = new RemoteConfigInternal(*app_, file_manager_);
+  }
+
+  ~Fixture() {
+    delete remote_config_;
+    delete app_;
+    remove(kConfigFile);
+  }
+
+  RemoteConfigInternal* remote_config() { return remote_config_; }
+  std::vector<ConfigValue>& values() { return values_; }
+
+ private:
+  App* app_;
+  RemoteConfigFileManager file_manager_;
+  RemoteConfigInternal* remote_config_;
+  std::vector<std::string> keys_;
+  std::vector<ConfigValue> values_;
+};
+
+// Read range(0) keys one at a time with the getter for each type.
+void BM_RemoteConfigGetPerKey(benchmark::State& state) {
+  Fixture fixture(static_cast<int>(state.range(0)));
+  RemoteConfigInternal* remote_config = fixture.remote_config();
+  std::vector<ConfigValue>& values = fixture.values();
+  for (auto _ : state) {
+    for (ConfigValue& value : values) {
+      switch (value.type) {
+        case kValueTypeBoolean:
+          value.boolean_value =
+              remote_config->GetBoolean(value.key, &value.info);
+          break;
+        case kValueTypeLong:
+          value.long_value = remote_config->GetLong(value.key, &value.info);
+          break;
+        case kValueTypeDouble:
+          value.double_value =
+              remote_config->GetDouble(value.key, &value.info);
+          break;
+        case kValueTypeString:
+          value.string_value =
+              remote_config->GetString(value.key, &value.info);
+          break;
+        case kValueTypeData:
+          value.data_value = remote_config->GetData(value.key, &value.info);
+          break;
+      }
+    }
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RemoteConfigGetPerKey)->ArgName("keys")->Arg(10)->Arg(300);
+
+// Read the same keys with one GetValues() call, into reused storage.
+void BM_RemoteConfigGetValues(benchmark::State& state) {
+  Fixture fixture(static_cast<int>(state.range(0)));
+  RemoteConfigInternal* remote_config = fixture.remote_config();
+  std::vector<ConfigValue>& values = fixture.values();
+  for (auto _ : state) {
+    remote_config->GetValues(values.data(), values.size());
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RemoteConfigGetValues)->ArgName("keys")->Arg(10)->Arg(300);
+
+// Read every key with GetAll(), for comparison.
+void BM_RemoteConfigGetAll(benchmark::State& state) {
+  Fixture fixture(static_cast<int>(state.range(0)));
+  RemoteConfigInternal* remote_config = fixture.remote_config();
+  for (auto _ : state) {
+    std::map<std::string, Variant> all = remote_config->GetAll();
+    benchmark::DoNotOptimize(all);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RemoteConfigGetAll)->ArgName("keys")->Arg(10)->Arg(300);
+
+}  // namespace
+}  // namespace internal
+}  // namespace remote_config
+}  // namespace firebase
@@ -0,0 +1,138 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_builder.h"
+#include "app/rest/transport_interface.h"
+#include "app/rest/util.h"
+#include "app/src/include/firebase/app.h"
+#include "benchmark/benchmark.h"
+#include "remote_config/src/desktop/config_data.h"
+#include "remote_config/src/desktop/metadata.h"
+#include "remote_config/src/desktop/rest.h"
+#include "remote_config/src/include/firebase/remote_config.h"
+
+namespace firebase {
+namespace remote_config {
+namespace internal {
+namespace {
+
+const char* const kNamespace = "firebase";
+const char* const kTemplateEtag = "etag-benchmark";
+
+// Serves a fixed template, answering "not modified" to requests that carry
+// its ETag unless honor_etag is false, which is how the backend looked to a
+// client that never sent one.
+class FakeBackend : public rest::Transport {
+ public:
+  static void SetTemplate(int entry_count) {
+    body_ = "{\"entries\":{";
+    char entry[64];
+    for (int i = 0; i < entry_count; ++i) {
+      snprintf(entry, sizeof(entry), "%s\"key_%d\":\"value_%d\"",
+               i ? "," : "", i, i);
+      body_.append(entry);
+    }
+    body_.append("},\"state\":\"UPDATE\"}");
+  }
+
+  static bool honor_etag_;
+  static size_t bytes_served_;
+
+ private:
+  void PerformInternal(
+      rest::Request* request, rest::Response* response,
+      flatbuffers::unique_ptr<rest::Controller>* controller_out) override {
+    const std::map<std::string, std::string>& header =
+        request->options().header;
+    auto if_none_match = header.find(kIfNoneMatchHeader);
+    bool not_modified = honor_etag_ && if_none_match != header.end() &&
+                        if_none_match->second == kTemplateEtag;
+    AddHeader(response, not_modified ? "HTTP/1.1 304 Not Modified"
+                                     : "HTTP/1.1 200 OK");
+    std::string etag = std::string(kEtagHeader) + ": " + kTemplateEtag;
+    AddHeader(response, etag.c_str());
+    response->ProcessHeader(rest::util::kCrLf, strlen(rest::util::kCrLf));
+    if (!not_modified) {
+      response->ProcessBody(body_.data(), body_.size());
+      bytes_served_ += body_.size();
+    }
+    response->MarkCompleted();
+  }
+
+  static void AddHeader(rest::Response* response, const char* line) {
+    std::string header = std::string(line) + rest::util::kCrLf;
+    response->ProcessHeader(header.data(), header.size());
+  }
+
+  static std::string body_;
+};
+
+bool FakeBackend::honor_etag_ = true;
+size_t FakeBackend::bytes_served_ = 0;
+std::string FakeBackend::body_;  // NOLINT
+
+flatbuffers::unique_ptr<rest::Transport> CreateFakeBackend() {
+  return flatbuffers::unique_ptr<rest::Transport>(new FakeBackend());
+}
+
+AppOptions MakeOptions() {
+  AppOptions options;
+  options.set_app_id("com.google.firebase.benchmark");
+  options.set_api_key("not_a_real_api_key");
+  options.set_project_id("not_a_real_project_id");
+  return options;
+}
+
+// Fetch a template of range(0) entries that has not changed since the
+// previous fetch. With range(1) == 0 the backend ignores the ETag and sends
+// the whole template every time; otherwise it answers "not modified".
+void BM_RemoteConfigFetchUnchanged(benchmark::State& state) {
+  rest::SetTransportBuilder(CreateFakeBackend);
+  FakeBackend::SetTemplate(static_cast<int>(state.range(0)));
+  FakeBackend::honor_etag_ = state.range(1) != 0;
+  App* app = App::Create(MakeOptions(), "benchmark");
+
+  RemoteConfigREST rest(app->options(), LayeredConfigs(), kNamespace);
+  // The first fetch downloads the template and its ETag.
+  rest.Fetch(*app, kDefaultTimeoutInMilliseconds);
+  FakeBackend::bytes_served_ = 0;
+  int changed = 0;
+  for (auto _ : state) {
+    rest.Fetch(*app, kDefaultTimeoutInMilliseconds);
+    if (rest.fetched_config_changed()) ++changed;
+  }
+  state.counters["body_bytes_per_fetch"] =
+      benchmark::Counter(static_cast<double>(FakeBackend::bytes_served_),
+                         benchmark::Counter::kAvgIterations);
+  state.counters["changed_per_fetch"] = benchmark::Counter(
+      static_cast<double>(changed), benchmark::Counter::kAvgIterations);
+  delete app;
+  rest::SetTransportBuilder(nullptr);
+}
+BENCHMARK(BM_RemoteConfigFetchUnchanged)
+    ->ArgNames({"entries", "etag"})
+    ->ArgsProduct({{10, 1000}, {0, 1}});
+
+}  // namespace
+}  // namespace internal
+}  // namespace remote_config
+}  // namespace firebase
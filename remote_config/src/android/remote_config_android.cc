@@ -1058,6 +1058,10 @@ std::map<std::string, Variant> RemoteConfigInternal::GetAll() {
   return value;
 }
 
+void RemoteConfigInternal::GetValues(ConfigValue* values, size_t count) {
+  GetValuesOneByOne(this, values, count);
+}
+
 const ConfigInfo RemoteConfigInternal::GetInfo() const {
   JNIEnv* env = app_.GetJNIEnv();
   ConfigInfo info;
@@ -1071,6 +1075,17 @@ const ConfigInfo RemoteConfigInternal::GetInfo() const {
   return info;
 }
 
+ConfigUpdateListenerRegistration
+RemoteConfigInternal::AddOnConfigUpdateListener(
+    std::function<void(ConfigUpdate&&, RemoteConfigError)>
+        config_update_listener) {
+  // Documented as desktop-only in remote_config.h.
+  // TODO: forward to the Android SDK's config update listener.
+  LogWarning("Real-time config updates are not supported on Android yet.");
+  config_update_listener(ConfigUpdate(), kRemoteConfigErrorUnimplemented);
+  return ConfigUpdateListenerRegistration();
+}
+
 }  // namespace internal
 }  // namespace remote_config
 }  // namespace firebase
@@ -17,6 +17,7 @@
 
 #include "app/src/reference_counted_future_impl.h"
 #include "app/src/semaphore.h"
+#include "remote_config/src/include/firebase/remote_config.h"
 
 namespace firebase {
 namespace remote_config {
@@ -96,6 +97,33 @@ void WaitForFuture(const firebase::Future<T>& future, Semaphore* future_sem,
   }
 }
 
+// Reads each of `values` with the getter for its type. For platforms whose
+// SDK has no faster way to read many values.
+template <typename RemoteConfigInternal>
+void GetValuesOneByOne(RemoteConfigInternal* internal, ConfigValue* values,
+                       size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    ConfigValue& value = values[i];
+    switch (value.type) {
+      case kValueTypeBoolean:
+        value.boolean_value = internal->GetBoolean(value.key, &value.info);
+        break;
+      case kValueTypeLong:
+        value.long_value = internal->GetLong(value.key, &value.info);
+        break;
+      case kValueTypeDouble:
+        value.double_value = internal->GetDouble(value.key, &value.info);
+        break;
+      case kValueTypeString:
+        value.string_value = internal->GetString(value.key, &value.info);
+        break;
+      case kValueTypeData:
+        value.data_value = internal->GetData(value.key, &value.info);
+        break;
+    }
+  }
+}
+
 }  // namespace internal
 
 }  // namespace remote_config
@@ -66,6 +66,35 @@ void NamespacedConfigData::SetNamespace(
   config_[name_space] = map;
 }
 
+void NamespacedConfigData::RemoveNamespace(const std::string& name_space) {
+  config_.erase(name_space);
+}
+
+bool NamespacedConfigData::UpdateChangedNamespaces(
+    const NamespacedConfigData& other) {
+  bool changed = false;
+  for (auto it = config_.begin(); it != config_.end();) {
+    if (other.config_.find(it->first) == other.config_.end()) {
+      it = config_.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
+  for (const auto& name_space : other.config_) {
+    auto it = config_.find(name_space.first);
+    if (it == config_.end()) {
+      config_.insert(name_space);
+      changed = true;
+    } else if (it->second != name_space.second) {
+      it->second = name_space.second;
+      changed = true;
+    }
+  }
+  timestamp_ = other.timestamp_;
+  return changed;
+}
+
 bool NamespacedConfigData::HasValue(const std::string& key,
                                     const std::string& name_space) const {
   auto name_space_iter = config_.find(name_space);
@@ -92,6 +121,12 @@ std::string NamespacedConfigData::GetValue(
   return key_iter->second;
 }
 
+const std::map<std::string, std::string>* NamespacedConfigData::GetNamespace(
+    const std::string& name_space) const {
+  auto name_space_iter = config_.find(name_space);
+  return name_space_iter == config_.end() ? nullptr : &name_space_iter->second;
+}
+
 void NamespacedConfigData::GetKeysByPrefix(const std::string& prefix,
                                            const std::string& name_space,
                                            std::set<std::string>* keys) const {
@@ -105,6 +140,33 @@ void NamespacedConfigData::GetKeysByPrefix(const std::string& prefix,
   }
 }
 
+void NamespacedConfigData::GetChangedKeys(const NamespacedConfigData& other,
+                                          const std::string& name_space,
+                                          std::set<std::string>* keys) const {
+  static const std::map<std::string, std::string> kEmptyNamespace;
+  auto name_space_iter = config_.find(name_space);
+  const std::map<std::string, std::string>& ours =
+      name_space_iter == config_.end() ? kEmptyNamespace
+                                       : name_space_iter->second;
+  auto other_name_space_iter = other.config_.find(name_space);
+  const std::map<std::string, std::string>& theirs =
+      other_name_space_iter == other.config_.end()
+          ? kEmptyNamespace
+          : other_name_space_iter->second;
+  for (const auto& key_iter : ours) {
+    auto other_key_iter = theirs.find(key_iter.first);
+    if (other_key_iter == theirs.end() ||
+        other_key_iter->second != key_iter.second) {
+      keys->insert(key_iter.first);
+    }
+  }
+  for (const auto& key_iter : theirs) {
+    if (ours.find(key_iter.first) == ours.end()) {
+      keys->insert(key_iter.first);
+    }
+  }
+}
+
 const NamespaceKeyValueMap& NamespacedConfigData::config() const {
   return config_;
 }
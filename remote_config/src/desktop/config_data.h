@@ -52,6 +52,12 @@ class NamespacedConfigData {
   // Set key/value records from `map` by `namespace`.
   void SetNamespace(const std::map<std::string, std::string>& map,
                     const std::string& name_space);
+  // Remove all key/value records of `name_space`, including the namespace.
+  void RemoveNamespace(const std::string& name_space);
+
+  // Make this hold the same records and timestamp as `other`, copying only
+  // the namespaces that differ. Return true if any namespace changed.
+  bool UpdateChangedNamespaces(const NamespacedConfigData& other);
   // Return true if `config` contains value by namespace and key.
   bool HasValue(const std::string& key, const std::string& name_space) const;
 
@@ -60,13 +66,25 @@ class NamespacedConfigData {
   std::string GetValue(const std::string& key,
                        const std::string& name_space) const;
 
+  // Return the key/value records of `name_space`, or null if there is no
+  // such namespace. Valid until `config` is next changed.
+  const std::map<std::string, std::string>* GetNamespace(
+      const std::string& name_space) const;
+
   // Assign keys that start with `prefix` from `name_space` namespace to the
   // `keys` variable.
   void GetKeysByPrefix(const std::string& prefix, const std::string& name_space,
                        std::set<std::string>* keys) const;
 
+  // Assign keys of `name_space` whose values differ from `other`, including
+  // keys that only one of them has, to the `keys` variable.
+  void GetChangedKeys(const NamespacedConfigData& other,
+                      const std::string& name_space,
+                      std::set<std::string>* keys) const;
+
   const NamespaceKeyValueMap& config() const;
   uint64_t timestamp() const;
+  void set_timestamp(uint64_t timestamp) { timestamp_ = timestamp; }
 
   bool operator==(const NamespacedConfigData& right) const;
 
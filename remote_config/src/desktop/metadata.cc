@@ -25,7 +25,8 @@ namespace remote_config {
 namespace internal {
 
 RemoteConfigMetadata::RemoteConfigMetadata()
-    : info_({0, kLastFetchStatusSuccess, kFetchFailureReasonInvalid, 0}) {}
+    : info_({0, kLastFetchStatusSuccess, kFetchFailureReasonInvalid, 0}),
+      template_version_(0) {}
 
 std::string RemoteConfigMetadata::Serialize() const {
   flexbuffers::Builder fbb;
@@ -44,6 +45,8 @@ std::string RemoteConfigMetadata::Serialize() const {
 
     fbb.Add("digest_by_namespace", digest_by_namespace_);
 
+    fbb.Int("template_version", template_version_);
+
     fbb.Map("settings", [&]() {
       for (const auto& setting : settings_) {
         fbb.String(std::to_string(setting.first).c_str(), setting.second);
@@ -72,6 +75,9 @@ void RemoteConfigMetadata::Deserialize(const std::string& buffer) {
   flexbuffers::Map digests = struct_map["digest_by_namespace"].AsMap();
   DeserializeMap(&digest_by_namespace_, digests);
 
+  // Missing from files saved by older versions, which reads as 0.
+  template_version_ = struct_map["template_version"].AsInt64();
+
   settings_.clear();
   flexbuffers::Map settings = struct_map["settings"].AsMap();
   for (int i = 0, n = settings.size(); i < n; ++i) {
@@ -96,6 +102,7 @@ std::string RemoteConfigMetadata::GetSetting(
 
 bool RemoteConfigMetadata::operator==(const RemoteConfigMetadata& right) const {
   return digest_by_namespace_ == right.digest_by_namespace_ &&
+         template_version_ == right.template_version_ &&
          settings_ == right.settings_ &&
          info_.fetch_time == right.info_.fetch_time &&
          info_.last_fetch_status == right.info_.last_fetch_status &&
@@ -15,6 +15,7 @@
 #ifndef FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_METADATA_H_
 #define FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_METADATA_H_
 
+#include <cstdint>
 #include <map>
 #include <string>
 
@@ -56,6 +57,13 @@ class RemoteConfigMetadata {
     digest_by_namespace_ = digest_by_namespace;
   }
 
+  // Returns the version of the last fetched template, or 0 if it is not
+  // known.
+  int64_t template_version() const { return template_version_; }
+  void set_template_version(int64_t template_version) {
+    template_version_ = template_version;
+  }
+
   // Set setting with value.
   const MetaSettingsMap& settings() const { return settings_; }
   void AddSetting(const ConfigSetting& setting, const std::string& value);
@@ -75,6 +83,10 @@ class RemoteConfigMetadata {
   // response size (e.g. case when namespace doesn't have change).
   MetaDigestMap digest_by_namespace_;
 
+  // Version of the template that was last fetched. The real-time update
+  // stream reports it, so that only newer templates trigger a fetch.
+  int64_t template_version_;
+
   // Developers settings.
   //
   // For now it's only one key: kConfigSettingDeveloperMode. Set "1" to enable
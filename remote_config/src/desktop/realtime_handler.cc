@@ -0,0 +1,488 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "remote_config/src/desktop/realtime_handler.h"
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "app/rest/transport_curl.h"
+#include "app/rest/util.h"
+#include "app/src/log.h"
+#include "app/src/time.h"
+#include "app/src/variant_util.h"
+#include "remote_config/src/desktop/rest.h"
+
+namespace firebase {
+namespace remote_config {
+namespace internal {
+
+namespace {
+
+// How long to wait for a cancelled connection to end.
+const int kCancelTimeoutInMilliseconds = 5 * 1000;
+
+const char* const kTemplateVersionField = "latestTemplateVersionNumber";
+const char* const kFeatureDisabledField = "featureDisabled";
+const char* const kRetryIntervalField = "retryIntervalSeconds";
+
+// Statuses after which reconnecting may succeed. 0 means that there was no
+// response at all.
+bool IsRetryableStatus(int status) {
+  switch (status) {
+    case 0:
+    case 429:
+    case 500:
+    case 502:
+    case 503:
+    case 504:
+      return true;
+  }
+  return false;
+}
+
+// The server sends numbers both as JSON numbers and as strings.
+int64_t VariantToInt64(const Variant& value) {
+  if (value.is_int64()) return value.int64_value();
+  if (value.is_double()) return static_cast<int64_t>(value.double_value());
+  if (value.is_string()) return std::strtoll(value.string_value(), nullptr, 10);
+  return 0;
+}
+
+// The project number is the second part of the app id,
+// "1:<project number>:<platform>:<hash>".
+std::string GetProjectNumber(const AppOptions& app_options) {
+  std::string app_id(app_options.app_id());
+  size_t start = app_id.find(':');
+  size_t end = start == std::string::npos ? start : app_id.find(':', start + 1);
+  if (end == std::string::npos) return app_options.project_id();
+  return app_id.substr(start + 1, end - start - 1);
+}
+
+}  // namespace
+
+// Splits the body of the stream into messages as they arrive, and hands them
+// to the handler.
+//
+// The body is a JSON array that is never closed, with one object per message.
+// Objects can be split across chunks, so incomplete ones are kept until the
+// rest arrives.
+class RealtimeStreamResponse : public rest::Response {
+ public:
+  explicit RealtimeStreamResponse(ConfigRealtimeHandler* handler)
+      : handler_(handler) {}
+
+  bool ProcessBody(const char* buffer, size_t length) override {
+    if (status() != rest::util::HttpSuccess) {
+      // Keep error responses whole, for logging.
+      return rest::Response::ProcessBody(buffer, length);
+    }
+    pending_.append(buffer, length);
+    std::string message;
+    while (ExtractMessage(&message)) {
+      handler_->OnMessage(util::JsonToVariant(message.c_str()));
+    }
+    return true;
+  }
+
+  void MarkCompleted() override {
+    rest::Response::MarkCompleted();
+    handler_->OnStreamEnded();
+  }
+
+  void MarkFailed() override {
+    rest::Response::MarkFailed();
+    handler_->OnStreamEnded();
+  }
+
+ private:
+  // Removes the first complete object from the pending data and assigns it
+  // to `message`. Returns false if there is no complete object yet.
+  bool ExtractMessage(std::string* message) {
+    size_t start = pending_.find('{');
+    if (start == std::string::npos) {
+      // Only separators so far.
+      pending_.clear();
+      return false;
+    }
+    int depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+    for (size_t i = start; i < pending_.size(); ++i) {
+      char c = pending_[i];
+      if (in_string) {
+        if (escaped) {
+          escaped = false;
+        } else if (c == '\\') {
+          escaped = true;
+        } else if (c == '"') {
+          in_string = false;
+        }
+      } else if (c == '"') {
+        in_string = true;
+      } else if (c == '{') {
+        ++depth;
+      } else if (c == '}' && --depth == 0) {
+        message->assign(pending_, start, i + 1 - start);
+        pending_.erase(0, i + 1);
+        return true;
+      }
+    }
+    pending_.erase(0, start);
+    return false;
+  }
+
+  ConfigRealtimeHandler* handler_;
+  std::string pending_;
+};
+
+ConfigRealtimeHandler::ConfigRealtimeHandler(
+    const AppOptions& app_options, const std::string& name_space,
+    FetchFunction fetch, TemplateVersionFunction template_version,
+    InstallationsFunction installations, TransportBuilder transport_builder)
+    : api_key_(app_options.api_key()),
+      app_id_(app_options.app_id()),
+      project_number_(GetProjectNumber(app_options)),
+      name_space_(name_space),
+      fetch_(std::move(fetch)),
+      template_version_(std::move(template_version)),
+      installations_(std::move(installations)),
+      transport_builder_(transport_builder),
+      initial_backoff_ms_(kRealtimeInitialBackoffInMilliseconds),
+      max_backoff_ms_(kRealtimeMaxBackoffInMilliseconds),
+      next_listener_id_(0),
+      running_(false),
+      shutting_down_(false),
+      stream_failed_(false),
+      pending_template_version_(0),
+      feature_disabled_(false),
+      retry_interval_ms_(0),
+      stream_ended_(false),
+      event_(0),
+      random_(static_cast<uint32_t>(firebase::internal::GetTimestamp())) {
+  url_ = std::string(kRealtimeServerURL) + "/" + project_number_ +
+         "/namespaces/" + name_space_ + kRealtimeStreamMethod;
+}
+
+ConfigRealtimeHandler::~ConfigRealtimeHandler() {
+  {
+    MutexLock lock(mutex_);
+    shutting_down_ = true;
+    listeners_.clear();
+  }
+  event_.Post();
+  if (thread_.joinable()) thread_.join();
+}
+
+flatbuffers::unique_ptr<rest::Transport>
+ConfigRealtimeHandler::CreateCurlTransport() {
+  rest::TransportCurl* transport = new rest::TransportCurl();
+  transport->set_is_async(true);
+  return flatbuffers::unique_ptr<rest::Transport>(transport);
+}
+
+int ConfigRealtimeHandler::AddListener(Listener listener) {
+  MutexLock lock(mutex_);
+  int listener_id = next_listener_id_++;
+  listeners_[listener_id] = std::move(listener);
+  stream_failed_ = false;
+  if (running_) {
+    event_.Post();
+  } else {
+    // The previous stream thread, if any, has finished its work.
+    if (thread_.joinable()) thread_.join();
+    running_ = true;
+    thread_ = std::thread([this]() { Run(); });
+  }
+  return listener_id;
+}
+
+void ConfigRealtimeHandler::RemoveListener(int listener_id) {
+  MutexLock lock(mutex_);
+  listeners_.erase(listener_id);
+  if (listeners_.empty()) event_.Post();
+}
+
+bool ConfigRealtimeHandler::ShouldExit() const {
+  return shutting_down_ || listeners_.empty();
+}
+
+void ConfigRealtimeHandler::Run() {
+  int retries = 0;
+  int64_t delay_ms = 0;
+  while (WaitToConnect(delay_ms)) {
+    StreamResult result = Stream();
+    delay_ms = 0;
+    switch (result) {
+      case kStreamResultClosed:
+        retries = 0;
+        break;
+      case kStreamResultRetry:
+        if (++retries > kRealtimeMaxStreamRetries) {
+          LogWarning("Giving up on real-time config updates after %d retries",
+                     kRealtimeMaxStreamRetries);
+          retries = 0;
+          Fail(kRemoteConfigErrorConfigUpdateStreamError);
+        } else {
+          delay_ms = GetBackoffMilliseconds(retries);
+        }
+        break;
+      case kStreamResultFailed:
+        retries = 0;
+        Fail(kRemoteConfigErrorConfigUpdateStreamError);
+        break;
+      case kStreamResultUnavailable:
+        retries = 0;
+        Fail(kRemoteConfigErrorConfigUpdateUnavailable);
+        break;
+      case kStreamResultStopped:
+        break;
+    }
+    // The server can ask to wait longer before connecting again.
+    MutexLock lock(mutex_);
+    if (retry_interval_ms_ > delay_ms) delay_ms = retry_interval_ms_;
+  }
+}
+
+bool ConfigRealtimeHandler::WaitToConnect(int64_t delay_ms) {
+  uint64_t connect_time = firebase::internal::GetTimestamp() + delay_ms;
+  while (true) {
+    int64_t wait_ms = -1;
+    {
+      MutexLock lock(mutex_);
+      // Deciding to exit and clearing running_ happen under the same lock, so
+      // a listener added meanwhile starts a new thread.
+      if (ShouldExit()) {
+        running_ = false;
+        return false;
+      }
+      if (!stream_failed_) {
+        uint64_t now = firebase::internal::GetTimestamp();
+        if (now >= connect_time) return true;
+        wait_ms = static_cast<int64_t>(connect_time - now);
+      }
+    }
+    if (wait_ms < 0) {
+      event_.Wait();
+    } else {
+      event_.TimedWait(static_cast<int>(wait_ms));
+    }
+  }
+}
+
+bool ConfigRealtimeHandler::Sleep(int64_t delay_ms) {
+  uint64_t end_time = firebase::internal::GetTimestamp() + delay_ms;
+  while (true) {
+    {
+      MutexLock lock(mutex_);
+      if (ShouldExit()) return false;
+    }
+    uint64_t now = firebase::internal::GetTimestamp();
+    if (now >= end_time) return true;
+    event_.TimedWait(static_cast<int>(end_time - now));
+  }
+}
+
+ConfigRealtimeHandler::StreamResult ConfigRealtimeHandler::Stream() {
+  {
+    MutexLock lock(mutex_);
+    pending_template_version_ = 0;
+    feature_disabled_ = false;
+    retry_interval_ms_ = 0;
+    stream_ended_ = false;
+  }
+  rest::Request request;
+  SetupRequest(&request);
+  RealtimeStreamResponse response(this);
+  // Destroying the transport waits for the transfer to finish, so it must go
+  // before the request and response.
+  flatbuffers::unique_ptr<rest::Transport> transport = transport_builder_();
+  flatbuffers::unique_ptr<rest::Controller> controller;
+  transport->Perform(&request, &response, &controller);
+
+  bool cancelled = false;
+  bool feature_disabled = false;
+  while (true) {
+    int64_t template_version;
+    bool exit;
+    {
+      MutexLock lock(mutex_);
+      if (stream_ended_) break;
+      template_version = pending_template_version_;
+      pending_template_version_ = 0;
+      feature_disabled = feature_disabled_;
+      exit = ShouldExit();
+    }
+    if (!cancelled && (exit || feature_disabled)) {
+      cancelled = true;
+      if (controller) controller->Cancel();
+    }
+    if (cancelled) {
+      if (!event_.TimedWait(kCancelTimeoutInMilliseconds)) break;
+    } else if (template_version > 0) {
+      if (template_version > template_version_()) {
+        FetchTemplate(template_version);
+      }
+    } else {
+      event_.Wait();
+    }
+  }
+  transport.reset(nullptr);
+
+  if (feature_disabled) {
+    LogWarning("Real-time config updates are disabled for this project");
+    return kStreamResultUnavailable;
+  }
+  if (cancelled) return kStreamResultStopped;
+  int status = response.status();
+  if (status == rest::util::HttpSuccess ||
+      status == rest::util::HttpRequestTimeout) {
+    return kStreamResultClosed;
+  }
+  LogDebug("Real-time config update stream ended: http code %d", status);
+  return IsRetryableStatus(status) ? kStreamResultRetry : kStreamResultFailed;
+}
+
+void ConfigRealtimeHandler::SetupRequest(rest::Request* request) {
+  request->set_url(url_.c_str());
+  request->set_method(rest::util::kPost);
+  request->add_header(rest::util::kContentType, rest::util::kApplicationJson);
+  request->add_header(rest::util::kAccept, rest::util::kApplicationJson);
+  request->add_header(kApiKeyHeader, api_key_.c_str());
+  request->options().timeout_ms = kRealtimeStreamTimeoutInMilliseconds;
+
+  // The backend identifies the app instance by its installation, as fetches
+  // do. Without one the stream is still opened, and the server decides.
+  std::string installations_id;
+  std::string installations_token;
+  bool has_installation =
+      installations_(&installations_id, &installations_token);
+  if (has_installation) {
+    request->add_header(kInstallationsAuthTokenHeader,
+                        installations_token.c_str());
+  } else {
+    LogDebug("Opening the real-time config update stream without an "
+             "installation");
+  }
+
+  Variant body = Variant::EmptyMap();
+  body.map()["project"] = project_number_;
+  body.map()["namespace"] = name_space_;
+  body.map()["lastKnownVersionNumber"] = std::to_string(template_version_());
+  body.map()["appId"] = app_id_;
+  if (has_installation) body.map()["appInstanceId"] = installations_id;
+  std::string json = util::VariantToJson(body);
+  request->set_post_fields(json.c_str(), json.size());
+}
+
+void ConfigRealtimeHandler::FetchTemplate(int64_t template_version) {
+  for (int attempt = 0; attempt < kRealtimeMaxFetchAttempts; ++attempt) {
+    if (attempt > 0 && !Sleep(GetBackoffMilliseconds(attempt))) return;
+    std::vector<std::string> updated_keys;
+    if (fetch_(template_version, &updated_keys)) {
+      // A template can be published without changing any values.
+      if (!updated_keys.empty()) {
+        ConfigUpdate config_update;
+        config_update.updated_keys = std::move(updated_keys);
+        NotifyListeners(config_update, kRemoteConfigErrorNone);
+      }
+      return;
+    }
+  }
+  LogWarning("Failed to fetch config template version %lld",
+             static_cast<long long>(template_version));  // NOLINT
+  NotifyListeners(ConfigUpdate(), kRemoteConfigErrorConfigUpdateNotFetched);
+}
+
+void ConfigRealtimeHandler::Fail(RemoteConfigError error) {
+  {
+    MutexLock lock(mutex_);
+    stream_failed_ = true;
+  }
+  NotifyListeners(ConfigUpdate(), error);
+}
+
+void ConfigRealtimeHandler::NotifyListeners(const ConfigUpdate& config_update,
+                                            RemoteConfigError error) {
+  std::vector<int> listener_ids;
+  {
+    MutexLock lock(mutex_);
+    for (const auto& listener : listeners_) {
+      listener_ids.push_back(listener.first);
+    }
+  }
+  // Look up each listener just before calling it, so that listeners removed
+  // by an earlier one are skipped.
+  for (int listener_id : listener_ids) {
+    Listener listener;
+    {
+      MutexLock lock(mutex_);
+      auto it = listeners_.find(listener_id);
+      if (it == listeners_.end()) continue;
+      listener = it->second;
+    }
+    ConfigUpdate copy(config_update);
+    listener(std::move(copy), error);
+  }
+}
+
+int64_t ConfigRealtimeHandler::GetBackoffMilliseconds(int retries) {
+  int64_t backoff_ms = initial_backoff_ms_;
+  for (int i = 1; i < retries && backoff_ms < max_backoff_ms_; ++i) {
+    backoff_ms *= 2;
+  }
+  if (backoff_ms > max_backoff_ms_) backoff_ms = max_backoff_ms_;
+  // Spread out clients that lost their connections at the same time.
+  return backoff_ms / 2 +
+         static_cast<int64_t>(random_() % (backoff_ms / 2 + 1));
+}
+
+void ConfigRealtimeHandler::OnMessage(const Variant& message) {
+  if (!message.is_map()) {
+    LogWarning("Ignoring malformed real-time config update message");
+    return;
+  }
+  const std::map<Variant, Variant>& fields = message.map();
+  MutexLock lock(mutex_);
+  auto field = fields.find(Variant(kTemplateVersionField));
+  if (field != fields.end()) {
+    int64_t template_version = VariantToInt64(field->second);
+    if (template_version > pending_template_version_) {
+      pending_template_version_ = template_version;
+    }
+  }
+  field = fields.find(Variant(kFeatureDisabledField));
+  if (field != fields.end() && field->second.is_bool() &&
+      field->second.bool_value()) {
+    feature_disabled_ = true;
+  }
+  field = fields.find(Variant(kRetryIntervalField));
+  if (field != fields.end()) {
+    retry_interval_ms_ = VariantToInt64(field->second) *
+                         firebase::internal::kMillisecondsPerSecond;
+  }
+  event_.Post();
+}
+
+void ConfigRealtimeHandler::OnStreamEnded() {
+  MutexLock lock(mutex_);
+  stream_ended_ = true;
+  event_.Post();
+}
+
+}  // namespace internal
+}  // namespace remote_config
+}  // namespace firebase
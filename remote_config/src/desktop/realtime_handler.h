@@ -0,0 +1,231 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_REALTIME_HANDLER_H_
+#define FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_REALTIME_HANDLER_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "app/rest/request.h"
+#include "app/rest/response.h"
+#include "app/rest/transport_interface.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/semaphore.h"
+#include "firebase/app.h"
+#include "flatbuffers/stl_emulation.h"
+#include "remote_config/src/include/firebase/remote_config.h"
+
+#ifdef FIREBASE_TESTING
+#include "gtest/gtest.h"
+#endif  // FIREBASE_TESTING
+
+namespace firebase {
+namespace remote_config {
+namespace internal {
+
+const char* const kRealtimeServerURL =
+    "https://firebaseremoteconfigrealtime.googleapis.com/v1/projects";
+const char* const kRealtimeStreamMethod = ":streamFetchInvalidations";
+const char* const kApiKeyHeader = "X-Goog-Api-Key";
+
+// A single connection is closed after this long and opened again, so that a
+// connection that silently died is not waited on forever.
+const int64_t kRealtimeStreamTimeoutInMilliseconds = 10 * 60 * 1000;
+
+// Reconnecting after a failure waits exponentially longer, starting from the
+// initial backoff, and gives up after kRealtimeMaxStreamRetries failures in a
+// row.
+const int64_t kRealtimeInitialBackoffInMilliseconds = 2 * 1000;
+const int64_t kRealtimeMaxBackoffInMilliseconds = 5 * 60 * 1000;
+const int kRealtimeMaxStreamRetries = 7;
+
+// A new template is fetched up to this many times, with backoff, before the
+// listeners are told that it could not be fetched.
+const int kRealtimeMaxFetchAttempts = 3;
+
+class RealtimeStreamResponse;
+
+// Keeps a streaming connection to the Remote Config real-time backend open
+// while there are config update listeners.
+//
+// The backend sends a message with the latest template version whenever a
+// template is published. If it is newer than the last fetched template, the
+// template is fetched and the listeners are called with the keys that
+// changed. The connection is opened again when it ends, with exponential
+// backoff after failures.
+//
+// Listeners are called on the stream thread, without any lock held, so they
+// may add and remove listeners.
+class ConfigRealtimeHandler {
+ public:
+#ifdef FIREBASE_TESTING
+  friend class ConfigRealtimeHandlerTest;
+#endif  // FIREBASE_TESTING
+
+  typedef std::function<void(ConfigUpdate&&, RemoteConfigError)> Listener;
+
+  // Fetches a template at least as new as `template_version`. Returns false if
+  // the fetch failed or fetched an older template, otherwise assigns the keys
+  // that differ from the active config to `updated_keys`.
+  typedef std::function<bool(int64_t template_version,
+                             std::vector<std::string>* updated_keys)>
+      FetchFunction;
+
+  // Returns the version of the last fetched template, or 0 if none is known.
+  typedef std::function<int64_t()> TemplateVersionFunction;
+
+  // Gets the Installations ID and auth token that identify the app to the
+  // backend. Returns false if they are not available.
+  typedef std::function<bool(std::string* installations_id,
+                             std::string* installations_token)>
+      InstallationsFunction;
+
+  // Builds the transport for each connection. It must be asynchronous: Perform
+  // returns right away, and completes the response from another thread.
+  typedef flatbuffers::unique_ptr<rest::Transport> (*TransportBuilder)();
+
+  ConfigRealtimeHandler(const AppOptions& app_options,
+                        const std::string& name_space, FetchFunction fetch,
+                        TemplateVersionFunction template_version,
+                        InstallationsFunction installations,
+                        TransportBuilder transport_builder);
+
+  // Closes the connection and waits for the stream thread to finish. Must not
+  // be called from a listener.
+  ~ConfigRealtimeHandler();
+
+  // Adds a listener and returns its id. Opens the connection if it is not
+  // open, including after it failed.
+  int AddListener(Listener listener);
+
+  // Removes a listener. The connection is closed once there are none left.
+  void RemoveListener(int listener_id);
+
+  // Builds an asynchronous curl transport.
+  static flatbuffers::unique_ptr<rest::Transport> CreateCurlTransport();
+
+ private:
+  friend class RealtimeStreamResponse;
+
+  // How a connection ended.
+  enum StreamResult {
+    // The server closed the connection normally.
+    kStreamResultClosed,
+    // The connection failed in a way that is worth retrying.
+    kStreamResultRetry,
+    // The connection failed, and retrying will not help.
+    kStreamResultFailed,
+    // The server reported that real-time updates are disabled.
+    kStreamResultUnavailable,
+    // The connection was closed because there are no listeners left.
+    kStreamResultStopped,
+  };
+
+  // Loop of the stream thread: connects, and reconnects after the connection
+  // ends, until there are no listeners.
+  void Run();
+
+  // Waits `delay_ms`, or while the stream is failed, until it is time to
+  // connect. Returns false if the thread should exit instead.
+  bool WaitToConnect(int64_t delay_ms);
+
+  // Waits `delay_ms`. Returns false early if the thread should exit.
+  bool Sleep(int64_t delay_ms);
+
+  // Opens one connection and handles its messages until it ends.
+  StreamResult Stream();
+
+  // Sets up the request to open the stream.
+  void SetupRequest(rest::Request* request);
+
+  // Fetches the template with `template_version`, retrying with backoff, and
+  // calls the listeners with the result.
+  void FetchTemplate(int64_t template_version);
+
+  // Stops connecting until a listener is added, and calls the listeners with
+  // `error`.
+  void Fail(RemoteConfigError error);
+
+  // Calls each listener with a copy of `config_update` and `error`.
+  void NotifyListeners(const ConfigUpdate& config_update,
+                       RemoteConfigError error);
+
+  // Returns the delay before retry number `retries`, with jitter.
+  int64_t GetBackoffMilliseconds(int retries);
+
+  // Returns true if the stream thread should exit. Requires mutex_.
+  bool ShouldExit() const;
+
+  // Called by the response with each message from the server.
+  void OnMessage(const Variant& message);
+
+  // Called by the response when the connection ended.
+  void OnStreamEnded();
+
+  std::string url_;
+  std::string api_key_;
+  std::string app_id_;
+  std::string project_number_;
+  std::string name_space_;
+
+  FetchFunction fetch_;
+  TemplateVersionFunction template_version_;
+  InstallationsFunction installations_;
+  TransportBuilder transport_builder_;
+
+  // Backoff settings, which tests shorten.
+  int64_t initial_backoff_ms_;
+  int64_t max_backoff_ms_;
+
+  // Guards all the fields below.
+  Mutex mutex_;
+
+  std::map<int, Listener> listeners_;
+  int next_listener_id_;
+
+  // Whether the stream thread is running. The thread clears this just before
+  // it exits.
+  bool running_;
+  // Set by the destructor to make the stream thread exit.
+  bool shutting_down_;
+  // Set after a failure that retrying would not fix. No connection is opened
+  // until a listener is added.
+  bool stream_failed_;
+
+  // State of the open connection, set by the response.
+  int64_t pending_template_version_;
+  bool feature_disabled_;
+  int64_t retry_interval_ms_;
+  bool stream_ended_;
+
+  // Posted whenever any of the state above changes.
+  Semaphore event_;
+
+  // Jitter for the backoff. Only used by the stream thread.
+  std::minstd_rand random_;
+
+  std::thread thread_;
+};
+
+}  // namespace internal
+}  // namespace remote_config
+}  // namespace firebase
+
+#endif  // FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_REALTIME_HANDLER_H_
@@ -18,10 +18,13 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
+#include <map>
 #include <set>
 #include <sstream>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "app/src/callback.h"
@@ -72,7 +75,30 @@ RemoteConfigInternal::RemoteConfigInternal(
       future_impl_(kRemoteConfigFnCount),
       safe_this_(this),
       rest_(app.options(), configs_, kDefaultNamespace),
-      initialized_(false) {
+      initialized_(false),
+      realtime_(
+          app.options(), kDefaultNamespace,
+          [this](int64_t template_version,
+                 std::vector<std::string>* updated_keys) {
+            return FetchForConfigUpdate(template_version, updated_keys);
+          },
+          [this]() {
+            MutexLock lock(internal_mutex_);
+            return configs_.metadata.template_version();
+          },
+          [this](std::string* installations_id,
+                 std::string* installations_token) {
+            uint64_t timeout_in_milliseconds;
+            {
+              MutexLock lock(internal_mutex_);
+              timeout_in_milliseconds =
+                  config_settings_.fetch_timeout_in_milliseconds;
+            }
+            return GetInstallationsIdAndToken(app_, timeout_in_milliseconds,
+                                              installations_id,
+                                              installations_token);
+          },
+          ConfigRealtimeHandler::CreateCurlTransport) {
   InternalInit();
 }
 
@@ -83,7 +109,30 @@ RemoteConfigInternal::RemoteConfigInternal(const firebase::App& app)
       future_impl_(kRemoteConfigFnCount),
       safe_this_(this),
       rest_(app.options(), configs_, kDefaultNamespace),
-      initialized_(false) {
+      initialized_(false),
+      realtime_(
+          app.options(), kDefaultNamespace,
+          [this](int64_t template_version,
+                 std::vector<std::string>* updated_keys) {
+            return FetchForConfigUpdate(template_version, updated_keys);
+          },
+          [this]() {
+            MutexLock lock(internal_mutex_);
+            return configs_.metadata.template_version();
+          },
+          [this](std::string* installations_id,
+                 std::string* installations_token) {
+            uint64_t timeout_in_milliseconds;
+            {
+              MutexLock lock(internal_mutex_);
+              timeout_in_milliseconds =
+                  config_settings_.fetch_timeout_in_milliseconds;
+            }
+            return GetInstallationsIdAndToken(app_, timeout_in_milliseconds,
+                                              installations_id,
+                                              installations_token);
+          },
+          ConfigRealtimeHandler::CreateCurlTransport) {
   InternalInit();
 }
 
@@ -172,6 +221,9 @@ Future<bool> RemoteConfigInternal::FetchAndActivate() {
             MutexLock lock(handle->rc_internal->internal_mutex_);
 
             handle->rc_internal->FetchInternal();
+            // Cleared here rather than in FetchInternal, which real-time
+            // updates also call while a scheduled fetch may be pending.
+            handle->rc_internal->is_fetch_process_have_task_ = false;
 
             FutureStatus futureResult =
                 (handle->rc_internal->GetInfo().last_fetch_status ==
@@ -346,10 +398,12 @@ bool RemoteConfigInternal::CheckValueInConfig(
 
   {
     MutexLock lock(internal_mutex_);
-    if (!config.HasValue(key, kDefaultNamespace)) {
-      return false;
-    }
-    *value = config.GetValue(key, kDefaultNamespace);
+    const std::map<std::string, std::string>* values =
+        config.GetNamespace(kDefaultNamespace);
+    if (!values) return false;
+    auto it = values->find(key);
+    if (it == values->end()) return false;
+    *value = it->second;
   }
 
   if (info) info->source = source;
@@ -556,24 +610,110 @@ Variant RemoteConfigInternal::StringToVariant(const std::string& from) {
 
 std::map<std::string, Variant> RemoteConfigInternal::GetAll() {
   std::map<std::string, Variant> result;
-  for (const std::string& key : GetKeys()) {
-    std::string value =
-        GetString(key.c_str(), static_cast<ValueInfo*>(nullptr));
-
-    result[key] = StringToVariant(value);
+  MutexLock lock(internal_mutex_);
+  const std::map<std::string, std::string>* active =
+      configs_.active.GetNamespace(kDefaultNamespace);
+  const std::map<std::string, std::string>* defaults =
+      configs_.defaults.GetNamespace(kDefaultNamespace);
+  // Both maps are sorted, so every insertion goes at a known position.
+  if (active) {
+    for (const auto& entry : *active) {
+      result.emplace_hint(result.end(), entry.first,
+                          StringToVariant(entry.second));
+    }
+  }
+  if (defaults) {
+    for (const auto& entry : *defaults) {
+      // Active values take precedence over defaults.
+      auto it = result.lower_bound(entry.first);
+      if (it == result.end() || it->first != entry.first) {
+        result.emplace_hint(it, entry.first, StringToVariant(entry.second));
+      }
+    }
   }
   return result;
 }
 
+void RemoteConfigInternal::GetValues(ConfigValue* values, size_t count) {
+  MutexLock lock(internal_mutex_);
+  const std::map<std::string, std::string>* active =
+      configs_.active.GetNamespace(kDefaultNamespace);
+  const std::map<std::string, std::string>* defaults =
+      configs_.defaults.GetNamespace(kDefaultNamespace);
+  // Reused for every lookup, so that keys only allocate when they outgrow it.
+  std::string key;
+  for (size_t i = 0; i < count; ++i) {
+    ConfigValue& value = values[i];
+    const std::string* raw = nullptr;
+    ValueSource source = kValueSourceStaticValue;
+    if (value.key) {
+      key.assign(value.key);
+      std::map<std::string, std::string>::const_iterator it;
+      if (active && (it = active->find(key)) != active->end()) {
+        raw = &it->second;
+        source = kValueSourceRemoteValue;
+      } else if (defaults && (it = defaults->find(key)) != defaults->end()) {
+        raw = &it->second;
+        source = kValueSourceDefaultValue;
+      }
+    }
+    ConvertValue(raw, source, &value);
+  }
+}
+
+void RemoteConfigInternal::ConvertValue(const std::string* raw,
+                                        ValueSource source,
+                                        ConfigValue* value) {
+  value->info.source = source;
+  bool conversion_successful = true;
+  switch (value->type) {
+    case kValueTypeBoolean:
+      value->boolean_value = kDefaultValueForBool;
+      if (raw) {
+        conversion_successful = ConvertToBool(*raw, &value->boolean_value);
+      }
+      break;
+    case kValueTypeLong:
+      value->long_value = kDefaultValueForLong;
+      if (raw) conversion_successful = ConvertToLong(*raw, &value->long_value);
+      break;
+    case kValueTypeDouble:
+      value->double_value = kDefaultValueForDouble;
+      if (raw) {
+        conversion_successful = ConvertToDouble(*raw, &value->double_value);
+      }
+      break;
+    case kValueTypeString:
+      // Assigned rather than copied, to reuse the string's storage.
+      if (raw) {
+        value->string_value.assign(*raw);
+      } else {
+        value->string_value.assign(kDefaultValueForString);
+      }
+      break;
+    case kValueTypeData:
+      if (raw) {
+        value->data_value.assign(raw->begin(), raw->end());
+      } else {
+        value->data_value.clear();
+      }
+      break;
+  }
+  value->info.conversion_successful = conversion_successful;
+}
+
 bool RemoteConfigInternal::ActivateFetched() {
+  bool changed;
   {
     MutexLock lock(internal_mutex_);
     // Fetched config not found or already activated.
     if (configs_.fetched.timestamp() <= configs_.active.timestamp())
       return false;
-    configs_.active = configs_.fetched;
+    // Only copy the namespaces that changed. If none did, the newer fetch
+    // is still activated, but there is nothing new to save.
+    changed = configs_.active.UpdateChangedNamespaces(configs_.fetched);
   }
-  save_channel_.Put();
+  if (changed) save_channel_.Put();
   return true;
 }
 
@@ -585,15 +725,53 @@ const ConfigInfo RemoteConfigInternal::GetInfo() const {
 void RemoteConfigInternal::FetchInternal() {
   // Fetch fresh config from server.
   rest_.Fetch(app_, config_settings_.fetch_timeout_in_milliseconds);
-  // Need to copy everything to `configs_.fetched`.
-  configs_.fetched = rest_.fetched();
+  // Need to copy everything to `configs_.fetched`, unless the fetch found
+  // that nothing changed.
+  if (rest_.fetched_config_changed()) {
+    configs_.fetched = rest_.fetched();
+  } else if (rest_.metadata().info().last_fetch_status ==
+             kLastFetchStatusSuccess) {
+    configs_.fetched.set_timestamp(rest_.fetched().timestamp());
+  }
 
   // Need to copy only info and digests to `configs_.metadata`.
   const RemoteConfigMetadata& metadata = rest_.metadata();
   configs_.metadata.set_info(metadata.info());
   configs_.metadata.set_digest_by_namespace(metadata.digest_by_namespace());
+  configs_.metadata.set_template_version(metadata.template_version());
+}
 
-  is_fetch_process_have_task_ = false;
+bool RemoteConfigInternal::FetchForConfigUpdate(
+    int64_t template_version, std::vector<std::string>* updated_keys) {
+  MutexLock lock(internal_mutex_);
+  FetchInternal();
+  if (configs_.metadata.info().last_fetch_status != kLastFetchStatusSuccess) {
+    return false;
+  }
+  // A fetch can reach a server that has not seen the new template yet. The
+  // version is unknown if the server did not send one.
+  int64_t fetched_version = configs_.metadata.template_version();
+  if (fetched_version != 0 && fetched_version < template_version) {
+    return false;
+  }
+  std::set<std::string> keys;
+  configs_.fetched.GetChangedKeys(configs_.active, kDefaultNamespace, &keys);
+  updated_keys->assign(keys.begin(), keys.end());
+  return true;
+}
+
+ConfigUpdateListenerRegistration
+RemoteConfigInternal::AddOnConfigUpdateListener(
+    std::function<void(ConfigUpdate&&, RemoteConfigError)>
+        config_update_listener) {
+  int listener_id = realtime_.AddListener(std::move(config_update_listener));
+  ThisRef ref = safe_this_;
+  return ConfigUpdateListenerRegistration([ref, listener_id]() mutable {
+    ThisRefLock lock(&ref);
+    if (lock.GetReference() != nullptr) {
+      lock.GetReference()->realtime_.RemoveListener(listener_id);
+    }
+  });
 }
 
 Future<void> RemoteConfigInternal::Fetch(uint64_t cache_expiration_in_seconds) {
@@ -631,6 +809,7 @@ Future<void> RemoteConfigInternal::Fetch(uint64_t cache_expiration_in_seconds) {
             MutexLock lock(handle->rc_internal->internal_mutex_);
 
             handle->rc_internal->FetchInternal();
+            handle->rc_internal->is_fetch_process_have_task_ = false;
 
             FutureStatus futureResult =
                 (handle->rc_internal->GetInfo().last_fetch_status ==
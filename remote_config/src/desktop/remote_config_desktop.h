@@ -16,8 +16,10 @@
 #define FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_REMOTE_CONFIG_DESKTOP_H_
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "app/src/include/firebase/internal/mutex.h"
 #include "app/src/reference_counted_future_impl.h"
@@ -28,6 +30,7 @@
 #include "remote_config/src/desktop/config_data.h"
 #include "remote_config/src/desktop/file_manager.h"
 #include "remote_config/src/desktop/notification_channel.h"
+#include "remote_config/src/desktop/realtime_handler.h"
 #include "remote_config/src/desktop/rest.h"
 #include "remote_config/src/include/firebase/remote_config.h"
 
@@ -60,6 +63,8 @@ class RemoteConfigInternal {
   FRIEND_TEST(RemoteConfigDesktopTest, GetData);
   FRIEND_TEST(RemoteConfigDesktopTest, GetKeys);
   FRIEND_TEST(RemoteConfigDesktopTest, GetKeysByPrefix);
+  FRIEND_TEST(RemoteConfigDesktopTest, GetAll);
+  FRIEND_TEST(RemoteConfigDesktopTest, GetValues);
   FRIEND_TEST(RemoteConfigDesktopTest, FailedLoadFromFile);
   FRIEND_TEST(RemoteConfigDesktopTest, SuccessLoadFromFile);
   FRIEND_TEST(RemoteConfigDesktopTest, SuccessAsyncSaveToFile);
@@ -119,10 +124,18 @@ class RemoteConfigInternal {
 
   std::map<std::string, Variant> GetAll();
 
+  // Reads every value from one lookup of the active and default namespaces,
+  // under a single lock.
+  void GetValues(ConfigValue* values, size_t count);
+
   bool ActivateFetched();
 
   const ConfigInfo GetInfo() const;
 
+  ConfigUpdateListenerRegistration AddOnConfigUpdateListener(
+      std::function<void(ConfigUpdate&&, RemoteConfigError)>
+          config_update_listener);
+
   static bool IsBoolTrue(const std::string& str);
   static bool IsBoolFalse(const std::string& str);
   static bool ConvertToBool(const std::string& from, bool* out);
@@ -166,8 +179,19 @@ class RemoteConfigInternal {
                           ValueSource source, const char* key, ValueInfo* info,
                           std::string* value);
 
+  // Assigns `raw`, converted to the type of `value`, to the value and its
+  // info, or the static value for the type if `raw` is null.
+  static void ConvertValue(const std::string* raw, ValueSource source,
+                           ConfigValue* value);
+
   void FetchInternal();
 
+  // Fetches for the real-time handler. Returns false if the fetch failed or
+  // fetched a template older than `template_version`, otherwise assigns the
+  // keys that differ from the active config to `updated_keys`.
+  bool FetchForConfigUpdate(int64_t template_version,
+                            std::vector<std::string>* updated_keys);
+
   static const char* const kDefaultNamespace;
   static const char* const kDefaultValueForString;
   static const int64_t kDefaultValueForLong;
@@ -225,6 +249,11 @@ class RemoteConfigInternal {
   RemoteConfigREST rest_;
   bool initialized_;
   ConfigSettings config_settings_;
+
+  // Keeps the real-time stream open while there are config update listeners.
+  // Declared last, so that its thread is stopped before anything it uses is
+  // destroyed.
+  ConfigRealtimeHandler realtime_;
 };
 
 }  // namespace internal
@@ -16,6 +16,8 @@
 
 #include "remote_config/src/desktop/remote_config_response.h"
 
+#include <cstdlib>
+
 namespace firebase {
 namespace remote_config {
 namespace internal {
@@ -87,6 +89,16 @@ Variant FlexbufferToVariant(const flexbuffers::Reference& ref) {
 
 Variant RemoteConfigResponse::GetEntries() { return entries_; }
 
+int64_t RemoteConfigResponse::GetTemplateVersion() const {
+  // The version is a decimal number, sent as a string.
+  return std::strtoll(application_data_->templateVersion.c_str(), nullptr, 10);
+}
+
+void RemoteConfigResponse::Reset() {
+  ResponseJson::Reset();
+  entries_ = Variant::Null();
+}
+
 // Mark the response completed for both header and body.
 void RemoteConfigResponse::MarkCompleted() {
   ResponseJson::MarkCompleted();
@@ -17,6 +17,8 @@
 #ifndef FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_REMOTE_CONFIG_RESPONSE_H_
 #define FIREBASE_REMOTE_CONFIG_SRC_DESKTOP_REMOTE_CONFIG_RESPONSE_H_
 
+#include <cstdint>
+
 #include "app/rest/response_json.h"
 #include "app/src/include/firebase/variant.h"
 #include "remote_config/response_generated.h"
@@ -45,12 +47,18 @@ class RemoteConfigResponse
 
   void MarkCompleted() override;
 
+  void Reset() override;
+
   Variant GetEntries();
 
   bool StatusMatch(std::string status_name) {
     return application_data_->state == status_name;
   }
 
+  // Returns the version of the fetched template, or 0 if the response does
+  // not have one.
+  int64_t GetTemplateVersion() const;
+
  private:
   Variant entries_;
 };
@@ -16,8 +16,10 @@
 
 #include <chrono>  // NOLINT
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <sstream>
+#include <string>
 
 #include "app/meta/move.h"
 #include "app/rest/transport_builder.h"
@@ -26,10 +28,12 @@
 #include "app/rest/util.h"
 #include "app/src/app_common.h"
 #include "app/src/base64.h"
+#include "app/src/function_registry.h"
 #include "app/src/locale.h"
 #include "app/src/log.h"
 #include "app/src/uuid.h"
 #include "firebase/app.h"
+#include "firebase/future.h"
 #include "remote_config/src/common.h"
 #include "remote_config/src/desktop/config_data.h"
 
@@ -54,7 +58,8 @@ RemoteConfigREST::RemoteConfigREST(const firebase::AppOptions& app_options,
       api_key_(app_options.api_key()),
       namespaces_(std::move(namespaces)),
       configs_(configs),
-      fetch_future_sem_(0) {
+      fetch_future_sem_(0),
+      fetched_config_changed_(false) {
   rest::util::Initialize();
   firebase::rest::InitTransportCurl();
 }
@@ -66,9 +71,11 @@ RemoteConfigREST::~RemoteConfigREST() {
 
 void RemoteConfigREST::Fetch(const App& app,
                              uint64_t fetch_timeout_in_milliseconds) {
-  TryGetInstallationsAndToken(app);
+  TryGetInstallationsAndToken(app, fetch_timeout_in_milliseconds);
 
   SetupRestRequest(app, fetch_timeout_in_milliseconds);
+  // The response is reused between fetches, so drop the previous one.
+  rc_response_.Reset();
   firebase::rest::CreateTransport()->Perform(rc_request_, &rc_response_);
   ParseRestResponse();
 }
@@ -96,9 +103,46 @@ static std::string GenerateFakeId() {
   return "";  // Error encoding.
 }
 
-void RemoteConfigREST::TryGetInstallationsAndToken(const App& app) {
-  // Instance ID no longer supported.
-  // TODO: use Installations instead.
+bool GetInstallationsIdAndToken(const App& app,
+                                uint64_t timeout_in_milliseconds,
+                                std::string* installations_id,
+                                std::string* installations_token) {
+  // Installations shares its cached ID and token through the function
+  // registry, if the app uses it.
+  App* mutable_app = const_cast<App*>(&app);
+  firebase::internal::FunctionRegistry* registry =
+      mutable_app->function_registry();
+  bool force_refresh = false;
+  Future<std::string> token_future;
+  Future<std::string> id_future;
+  // The token comes first, as getting it also registers the installation.
+  if (registry->CallFunction(
+          firebase::internal::FnInstallationsGetTokenAsync, mutable_app,
+          &force_refresh, &token_future) &&
+      token_future.Wait(static_cast<int>(timeout_in_milliseconds)) &&
+      token_future.error() == 0 &&
+      registry->CallFunction(firebase::internal::FnInstallationsGetIdAsync,
+                             mutable_app, nullptr, &id_future) &&
+      id_future.Wait(static_cast<int>(timeout_in_milliseconds)) &&
+      id_future.error() == 0) {
+    *installations_id = *id_future.result();
+    *installations_token = *token_future.result();
+    return true;
+  }
+  return false;
+}
+
+void RemoteConfigREST::TryGetInstallationsAndToken(
+    const App& app, uint64_t timeout_in_milliseconds) {
+  if (GetInstallationsIdAndToken(app, timeout_in_milliseconds,
+                                 &app_instance_id_, &app_instance_id_token_)) {
+    rc_request_.options().header[kInstallationsAuthTokenHeader] =
+        app_instance_id_token_;
+    return;
+  }
+  // Without Installations, fall back to an ID that is only good for this
+  // fetch.
+  rc_request_.options().header.erase(kInstallationsAuthTokenHeader);
   app_instance_id_ = GenerateFakeId();
   app_instance_id_token_ = GenerateFakeId();
 }
@@ -120,12 +164,21 @@ void RemoteConfigREST::SetupRestRequest(
   rc_request_.add_header(kContentTypeHeaderName, kJSONContentTypeValue);
   rc_request_.add_header(kAcceptHeaderName, kJSONContentTypeValue);
   rc_request_.options().timeout_ms = fetch_timeout_in_milliseconds;
+  rc_request_.options().accept_encoding = kGzipEncodingValue;
+
+  // With the ETag of the last template, the server answers "not modified"
+  // without sending the template again if it has not changed since.
+  const MetaDigestMap& etags = configs_.metadata.digest_by_namespace();
+  auto etag = etags.find(namespaces_);
+  if (etag != etags.end() && !etag->second.empty()) {
+    rc_request_.options().header[kIfNoneMatchHeader] = etag->second;
+  } else {
+    rc_request_.options().header.erase(kIfNoneMatchHeader);
+  }
 
   rc_request_.SetAppId(app_gmp_project_id_);
-  rc_request_.SetAppInstanceId(
-      app_instance_id_);  // TODO(cynthiajiang) change to installations
-  rc_request_.SetAppInstanceIdToken(
-      app_instance_id_token_);  // TODO(cynthiajiang) change to installations
+  rc_request_.SetAppInstanceId(app_instance_id_);
+  rc_request_.SetAppInstanceIdToken(app_instance_id_token_);
 
   rc_request_.SetPlatformVersion("2");
   std::string locale = firebase::internal::GetLocale();
@@ -142,6 +195,15 @@ void RemoteConfigREST::SetupRestRequest(
 }
 
 void RemoteConfigREST::ParseRestResponse() {
+  fetched_config_changed_ = false;
+  if (rc_response_.status() == kHTTPStatusNotModified) {
+    // The fetched config is still current, so there is nothing to parse.
+    LogDebug("Not modified: ns=%s", namespaces_.c_str());
+    configs_.fetched.set_timestamp(MillisecondsSinceEpoch());
+    FetchSuccess(kLastFetchStatusSuccess);
+    return;
+  }
+
   if (rc_response_.status() != kHTTPStatusOk) {
     FetchFailure(kFetchFailureReasonError);
     LogError("fetching failure: http code %d", rc_response_.status());
@@ -156,28 +218,52 @@ void RemoteConfigREST::ParseRestResponse() {
 
   Variant entries = rc_response_.GetEntries();
 
-  NamespaceKeyValueMap config_map(configs_.fetched.config());
+  // Only the fetched namespace is replaced, and only if it changed.
   LogDebug("Parsing config response...");
   if (rc_response_.StatusMatch("NO_CHANGE")) {
     LogDebug("No change");
   } else if (rc_response_.StatusMatch("UPDATE")) {
-    config_map[namespaces_].clear();
+    std::map<std::string, std::string> key_values;
     for (const auto& keyvalue : entries.map()) {
-      config_map[namespaces_][keyvalue.first.mutable_string()] =
+      key_values[keyvalue.first.mutable_string()] =
           keyvalue.second.mutable_string();
       LogDebug("Update: ns=%s kv=(%s, %s)", namespaces_.c_str(),
                keyvalue.first.mutable_string().c_str(),
                keyvalue.second.mutable_string().c_str());
     }
+    const NamespaceKeyValueMap& config = configs_.fetched.config();
+    auto current = config.find(namespaces_);
+    if (current == config.end() || current->second != key_values) {
+      configs_.fetched.SetNamespace(key_values, namespaces_);
+      fetched_config_changed_ = true;
+    }
   } else if (rc_response_.StatusMatch("NO_TEMPLATE")) {
     LogDebug("NotAuthorized: ns=%s", namespaces_.c_str());
-    config_map.erase(namespaces_);
+    configs_.fetched.RemoveNamespace(namespaces_);
+    fetched_config_changed_ = true;
   } else if (rc_response_.StatusMatch("EMPTY_CONFIG")) {
     LogDebug("EmptyConfig: ns=%s", namespaces_.c_str());
-    config_map[namespaces_].clear();
+    configs_.fetched.SetNamespace(std::map<std::string, std::string>(),
+                                  namespaces_);
+    fetched_config_changed_ = true;
+  }
+
+  // Keep the ETag, so the next fetch can be conditional.
+  MetaDigestMap etags(configs_.metadata.digest_by_namespace());
+  const char* etag = rc_response_.GetHeader(kEtagHeader);
+  if (etag != nullptr) {
+    etags[namespaces_] = etag;
+  } else {
+    etags.erase(namespaces_);
+  }
+  configs_.metadata.set_digest_by_namespace(etags);
+
+  int64_t template_version = rc_response_.GetTemplateVersion();
+  if (template_version > 0) {
+    configs_.metadata.set_template_version(template_version);
   }
 
-  configs_.fetched = NamespacedConfigData(config_map, MillisecondsSinceEpoch());
+  configs_.fetched.set_timestamp(MillisecondsSinceEpoch());
   FetchSuccess(kLastFetchStatusSuccess);
 }
 
@@ -53,11 +53,13 @@ const char* const kContentTypeHeaderName = "Content-Type";
 const char* const kAcceptHeaderName = "Accept";
 const char* const kContentTypeValue = "application/x-protobuffer";
 const char* const kJSONContentTypeValue = "application/json";
+const char* const kGzipEncodingValue = "gzip";
 
 // Set this key with value `1` if settings[kConfigSettingDeveloperMode] == `1`
 const char* const kDeveloperModeKey = "_rcn_developer";
 
 const int kHTTPStatusOk = 200;
+const int kHTTPStatusNotModified = 304;
 
 // const char* const kApiKeyHeader = "X-Goog-Api-Key";
 const char* const kEtagHeader = "ETag";
@@ -68,6 +70,15 @@ const char* const kInstallationsAuthTokenHeader =
 const char* const kHTTPFetchKeyString = ":fetch?key=";
 const char* const kNameSpaceString = "namespaces";
 
+// Gets the Installations ID and auth token of `app` synchronously, if the app
+// uses Installations. Blocks the current thread for up to
+// `timeout_in_milliseconds` for each of them. Returns false if either could not
+// be got.
+bool GetInstallationsIdAndToken(const App& app,
+                                uint64_t timeout_in_milliseconds,
+                                std::string* installations_id,
+                                std::string* installations_token);
+
 class RemoteConfigREST {
  public:
 #ifdef FIREBASE_TESTING
@@ -77,6 +88,9 @@ class RemoteConfigREST {
   FRIEND_TEST(RemoteConfigRESTTest, Fetch);
   FRIEND_TEST(RemoteConfigRESTTest, ParseRestResponseProtoFailure);
   FRIEND_TEST(RemoteConfigRESTTest, ParseRestResponseSuccess);
+  FRIEND_TEST(RemoteConfigRESTTest, ParseRestResponseNotModified);
+  FRIEND_TEST(RemoteConfigRESTTest, SetupRESTRequestWithEtag);
+  FRIEND_TEST(RemoteConfigRESTTest, FetchNotModified);
 #endif  // FIREBASE_TESTING
 
   RemoteConfigREST(const firebase::AppOptions& app_options,
@@ -98,10 +112,16 @@ class RemoteConfigREST {
   // updated metadata.
   const RemoteConfigMetadata& metadata() const { return configs_.metadata; }
 
+  // Returns true if the last Fetch() changed the fetched config. When the
+  // server reports that nothing changed, only the fetched timestamp moves on.
+  bool fetched_config_changed() const { return fetched_config_changed_; }
+
  private:
   // Attempt to get Installations and Auth Token from app synchronously.  This
-  // will block the current thread and wait until the futures are complete.
-  void TryGetInstallationsAndToken(const App& app);
+  // will block the current thread and wait until the futures are complete, or
+  // for up to `timeout_in_milliseconds` each.
+  void TryGetInstallationsAndToken(const App& app,
+                                   uint64_t timeout_in_milliseconds);
 
   // Setup all values to make REST request. Call `SetupProtoRequest` to setup
   // post fields.
@@ -137,6 +157,8 @@ class RemoteConfigREST {
 
   RemoteConfigRequest rc_request_;
   RemoteConfigResponse rc_response_;
+
+  bool fetched_config_changed_;
 };
 
 }  // namespace internal
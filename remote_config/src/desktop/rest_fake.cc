@@ -15,6 +15,7 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "firebase/app.h"
 #include "remote_config/src/desktop/config_data.h"
@@ -24,6 +25,17 @@ namespace firebase {
 namespace remote_config {
 namespace internal {
 
+// The number of times Fetch() was called, for tests that check whether a
+// fetch reached the backend.
+int g_fake_fetch_count = 0;
+
+bool GetInstallationsIdAndToken(const App& app,
+                                uint64_t timeout_in_milliseconds,
+                                std::string* installations_id,
+                                std::string* installations_token) {
+  return false;
+}
+
 // Stub REST implementation.
 // The purpose of this class is to hold content and not actually do anything
 // with it when the normal API calls happen.
@@ -36,7 +48,8 @@ RemoteConfigREST::RemoteConfigREST(const firebase::AppOptions& app_options,
       api_key_(app_options.api_key()),
       namespaces_(std::move(namespaces)),
       configs_(configs),
-      fetch_future_sem_(0) {
+      fetch_future_sem_(0),
+      fetched_config_changed_(true) {
   configs_.fetched = NamespacedConfigData(
       NamespaceKeyValueMap({{"namespace", {{"key", "value"}}}}), 1000000);
 
@@ -49,7 +62,9 @@ RemoteConfigREST::RemoteConfigREST(const firebase::AppOptions& app_options,
 RemoteConfigREST::~RemoteConfigREST() {}
 
 void RemoteConfigREST::Fetch(const App& app,
-                             uint64_t fetch_timeout_in_milliseconds) {}
+                             uint64_t fetch_timeout_in_milliseconds) {
+  ++g_fake_fetch_count;
+}
 
 void RemoteConfigREST::SetupRestRequest(
     const App& app, uint64_t fetch_timeout_in_milliseconds) {}
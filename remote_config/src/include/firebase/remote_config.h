@@ -16,6 +16,7 @@
 #define FIREBASE_REMOTE_CONFIG_SRC_INCLUDE_FIREBASE_REMOTE_CONFIG_H_
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -159,6 +160,63 @@ struct ConfigKeyValueVariant {
   /// valid for the duration of the call to SetDefaults.
   Variant value;
 };
+
+/// @brief The types a value can be read as with RemoteConfig::GetValues().
+enum ValueType {
+  /// Read as with RemoteConfig::GetBoolean(), into `boolean_value`.
+  kValueTypeBoolean,
+  /// Read as with RemoteConfig::GetLong(), into `long_value`.
+  kValueTypeLong,
+  /// Read as with RemoteConfig::GetDouble(), into `double_value`.
+  kValueTypeDouble,
+  /// Read as with RemoteConfig::GetString(), into `string_value`.
+  kValueTypeString,
+  /// Read as with RemoteConfig::GetData(), into `data_value`.
+  kValueTypeData,
+};
+
+/// @brief A key to read with RemoteConfig::GetValues(), and the value read.
+///
+/// Only the value field for `type` is written, so an array of these can be
+/// kept and read into again, reusing the storage of string and data values.
+struct ConfigValue {
+  ConfigValue()
+      : key(nullptr),
+        type(kValueTypeString),
+        boolean_value(false),
+        long_value(0),
+        double_value(0.0) {}
+
+  /// Reads the value of `key` as `type`.
+  ConfigValue(const char* key, ValueType type)
+      : key(key),
+        type(type),
+        boolean_value(false),
+        long_value(0),
+        double_value(0.0) {}
+
+  /// The lookup key string.
+  ///
+  /// @note Ensure this string stays valid for the duration of the
+  /// call to GetValues.
+  const char* key;
+  /// The type to read the value as.
+  ValueType type;
+
+  /// The value, if `type` is kValueTypeBoolean.
+  bool boolean_value;
+  /// The value, if `type` is kValueTypeLong.
+  int64_t long_value;
+  /// The value, if `type` is kValueTypeDouble.
+  double double_value;
+  /// The value, if `type` is kValueTypeString.
+  std::string string_value;
+  /// The value, if `type` is kValueTypeData.
+  std::vector<unsigned char> data_value;
+
+  /// Where the value was retrieved from, and whether it converted to `type`.
+  ValueInfo info;
+};
 #endif  // SWIG
 
 /// @brief Configurations for Remote Config behavior.
@@ -178,10 +236,65 @@ struct ConfigSettings {
   uint64_t minimum_fetch_interval_in_milliseconds = kDefaultCacheExpiration;
 };
 
+#ifndef SWIG
+/// @brief Information about the updated config, passed to config update
+/// listeners.
+///
+/// @see RemoteConfig::AddOnConfigUpdateListener
+struct ConfigUpdate {
+  /// Keys of the parameters whose fetched values differ from the activated
+  /// values. Includes keys that were added and removed.
+  std::vector<std::string> updated_keys;
+};
+
+/// @brief Describes the errors passed to config update listeners.
+///
+/// @see RemoteConfig::AddOnConfigUpdateListener
+enum RemoteConfigError {
+  /// No error, the ConfigUpdate describes the new config.
+  kRemoteConfigErrorNone = 0,
+  /// The connection to the real-time update backend failed, and giving up
+  /// after retrying. Add a listener again to reconnect.
+  kRemoteConfigErrorConfigUpdateStreamError,
+  /// A new config was published, but it could not be fetched.
+  kRemoteConfigErrorConfigUpdateNotFetched,
+  /// The real-time update backend is not available for this project.
+  kRemoteConfigErrorConfigUpdateUnavailable,
+  /// Real-time config updates are not supported on this platform. They are
+  /// only supported on desktop.
+  kRemoteConfigErrorUnimplemented,
+};
+#endif  // SWIG
+
 namespace internal {
 class RemoteConfigInternal;
 }  // namespace internal
 
+#ifndef SWIG
+/// @brief Represents a config update listener that was added with
+/// RemoteConfig::AddOnConfigUpdateListener().
+class ConfigUpdateListenerRegistration {
+ public:
+  /// Creates a registration that does not refer to any listener. Calling
+  /// Remove() on it does nothing.
+  ConfigUpdateListenerRegistration();
+
+  /// @brief Removes the listener, so that it is no longer called.
+  ///
+  /// Once the last listener is removed, the connection to the real-time
+  /// update backend is closed. It is safe to call this more than once, and
+  /// after the RemoteConfig instance has been deleted.
+  void Remove();
+
+ private:
+  friend class internal::RemoteConfigInternal;
+
+  explicit ConfigUpdateListenerRegistration(std::function<void()> remove);
+
+  std::function<void()> remove_;
+};
+#endif  // SWIG
+
 #ifndef SWIG
 /// @brief Entry point for the Firebase C++ SDK for Remote Config.
 ///
@@ -480,6 +593,20 @@ class RemoteConfig {
   /// key. The default value, if the key was set with @ref SetDefaults().
   std::map<std::string, Variant> GetAll();
 
+#ifndef SWIG
+  /// @brief Reads the values of several keys at once.
+  ///
+  /// Each entry is read as by the getter for its `type`, but all of them are
+  /// read from the same config, even if another one is activated meanwhile.
+  /// Reading many keys this way is faster than calling the getters one by
+  /// one.
+  ///
+  /// @param[in,out] values Keys to read, and the types to read them as. The
+  /// value and ValueInfo of each key are written to its entry.
+  /// @param[in] count Number of entries in `values`.
+  void GetValues(ConfigValue* values, size_t count);
+#endif  // SWIG
+
   /// @brief Returns information about the last fetch request, in the form
   /// of a ConfigInfo struct.
   ///
@@ -487,6 +614,34 @@ class RemoteConfig {
   /// of the most recent fetch request.
   const ConfigInfo GetInfo();
 
+#ifndef SWIG
+  /// @brief Starts listening for config updates published to the Firebase
+  /// Remote Config backend.
+  ///
+  /// While at least one listener is added, a connection to the real-time
+  /// update backend stays open. When a config newer than the last fetched one
+  /// is published, it is fetched, and each listener is called with the keys
+  /// that differ from the activated config. Call @ref Activate() to make the
+  /// new values take effect.
+  ///
+  /// The listener is called on a background thread. If the connection fails
+  /// it is retried with exponential backoff, and the listener is only called
+  /// with an error once retrying gives up.
+  ///
+  /// @note Real-time config updates are only supported on desktop for now. On
+  /// Android and iOS the listener is called once, right away, with
+  /// @ref kRemoteConfigErrorUnimplemented, and the returned registration does
+  /// nothing.
+  ///
+  /// @param[in] config_update_listener Called with each config update, or
+  /// with the error that stopped updates.
+  ///
+  /// @return A registration that removes the listener.
+  ConfigUpdateListenerRegistration AddOnConfigUpdateListener(
+      std::function<void(ConfigUpdate&&, RemoteConfigError)>
+          config_update_listener);
+#endif  // SWIG
+
   /// Gets the App this remote config object is connected to.
   App* app() { return app_; }
 
@@ -83,8 +83,14 @@ class RemoteConfigInternal {
 
   std::map<std::string, Variant> GetAll();
 
+  void GetValues(ConfigValue* values, size_t count);
+
   const ConfigInfo GetInfo() const;
 
+  ConfigUpdateListenerRegistration AddOnConfigUpdateListener(
+      std::function<void(ConfigUpdate&&, RemoteConfigError)>
+          config_update_listener);
+
   bool Initialized() const;
 
   void Cleanup();
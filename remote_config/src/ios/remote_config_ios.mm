@@ -484,11 +484,26 @@ std::map<std::string, Variant> RemoteConfigInternal::GetAll() {
   return value;
 }
 
+void RemoteConfigInternal::GetValues(ConfigValue* values, size_t count) {
+  GetValuesOneByOne(this, values, count);
+}
+
 const ConfigInfo RemoteConfigInternal::GetInfo() const {
   ConfigInfo config_info;
   GetInfoFromFIRRemoteConfig(impl(), &config_info, throttled_end_time_in_sec_);
   return config_info;
 }
+
+ConfigUpdateListenerRegistration
+RemoteConfigInternal::AddOnConfigUpdateListener(
+    std::function<void(ConfigUpdate&&, RemoteConfigError)>
+        config_update_listener) {
+  // Documented as desktop-only in remote_config.h.
+  // TODO: forward to the iOS SDK's config update listener.
+  LogWarning("Real-time config updates are not supported on iOS yet.");
+  config_update_listener(ConfigUpdate(), kRemoteConfigErrorUnimplemented);
+  return ConfigUpdateListenerRegistration();
+}
 }  // namespace internal
 }  // namespace remote_config
 }  // namespace firebase
@@ -15,6 +15,8 @@
 #include "remote_config/src/include/firebase/remote_config.h"
 
 #include <cstdint>
+#include <functional>
+#include <utility>
 
 #include "app/src/cleanup_notifier.h"
 #include "app/src/include/firebase/internal/mutex.h"
@@ -230,8 +232,33 @@ std::map<std::string, Variant> RemoteConfig::GetAll() {
   return internal_->GetAll();
 }
 
+void RemoteConfig::GetValues(ConfigValue* values, size_t count) {
+  if (!values) return;
+  internal_->GetValues(values, count);
+}
+
 // TODO(b/147143718): Change to a more descriptive name.
 const ConfigInfo RemoteConfig::GetInfo() { return internal_->GetInfo(); }
 
+ConfigUpdateListenerRegistration RemoteConfig::AddOnConfigUpdateListener(
+    std::function<void(ConfigUpdate&&, RemoteConfigError)>
+        config_update_listener) {
+  return internal_->AddOnConfigUpdateListener(
+      std::move(config_update_listener));
+}
+
+ConfigUpdateListenerRegistration::ConfigUpdateListenerRegistration() {}
+
+ConfigUpdateListenerRegistration::ConfigUpdateListenerRegistration(
+    std::function<void()> remove)
+    : remove_(std::move(remove)) {}
+
+void ConfigUpdateListenerRegistration::Remove() {
+  if (remove_) {
+    remove_();
+    remove_ = nullptr;
+  }
+}
+
 }  // namespace remote_config
 }  // namespace firebase
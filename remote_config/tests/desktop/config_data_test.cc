@@ -14,6 +14,10 @@
 
 #include "remote_config/src/desktop/config_data.h"
 
+#include <map>
+#include <set>
+#include <string>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -21,6 +25,9 @@ namespace firebase {
 namespace remote_config {
 namespace internal {
 
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
 TEST(LayeredConfigsTest, Convertation) {
   NamespacedConfigData fetched(
       NamespaceKeyValueMap(
@@ -84,6 +91,67 @@ TEST(NamespacedConfigDataTest, SetNamespace) {
   EXPECT_EQ(holder.GetValue("key2", "namespace1"), "value2");
 }
 
+TEST(NamespacedConfigDataTest, RemoveNamespace) {
+  NamespaceKeyValueMap m({{"namespace1", {{"key1", "value1"}}},
+                          {"namespace2", {{"key2", "value2"}}}});
+  NamespacedConfigData holder(m, 0);
+  holder.RemoveNamespace("namespace1");
+  holder.RemoveNamespace("namespace3");
+
+  EXPECT_EQ(holder.config(),
+            NamespaceKeyValueMap({{"namespace2", {{"key2", "value2"}}}}));
+}
+
+TEST(NamespacedConfigDataTest, UpdateChangedNamespaces) {
+  NamespacedConfigData holder(
+      NamespaceKeyValueMap({{"unchanged", {{"key1", "value1"}}},
+                            {"changed", {{"key2", "value2"}}},
+                            {"removed", {{"key3", "value3"}}}}),
+      1000);
+  NamespacedConfigData other(
+      NamespaceKeyValueMap({{"unchanged", {{"key1", "value1"}}},
+                            {"changed", {{"key2", "new_value2"}}},
+                            {"added", {{"key4", "value4"}}}}),
+      2000);
+
+  EXPECT_TRUE(holder.UpdateChangedNamespaces(other));
+  EXPECT_EQ(holder, other);
+
+  // Nothing changes when the records are the same, but the timestamp is still
+  // taken.
+  other.set_timestamp(3000);
+  EXPECT_FALSE(holder.UpdateChangedNamespaces(other));
+  EXPECT_EQ(holder, other);
+}
+
+TEST(NamespacedConfigDataTest, GetChangedKeys) {
+  NamespacedConfigData fetched(
+      NamespaceKeyValueMap({{"namespace1",
+                             {{"same", "value"},
+                              {"changed", "new value"},
+                              {"added", "value"}}},
+                            {"namespace2", {{"key", "value"}}}}),
+      2000);
+  NamespacedConfigData active(
+      NamespaceKeyValueMap({{"namespace1",
+                             {{"same", "value"},
+                              {"changed", "old value"},
+                              {"removed", "value"}}}}),
+      1000);
+
+  std::set<std::string> keys;
+  fetched.GetChangedKeys(active, "namespace1", &keys);
+  EXPECT_THAT(keys, ElementsAre("added", "changed", "removed"));
+
+  keys.clear();
+  fetched.GetChangedKeys(active, "namespace2", &keys);
+  EXPECT_THAT(keys, ElementsAre("key"));
+
+  keys.clear();
+  fetched.GetChangedKeys(fetched, "namespace1", &keys);
+  EXPECT_THAT(keys, IsEmpty());
+}
+
 TEST(NamespacedConfigDataTest, HasValue) {
   NamespaceKeyValueMap m({{"namespace1", {{"key1", "value1"}}}});
   NamespacedConfigData holder(m, 0);
@@ -115,6 +183,16 @@ TEST(NamespacedConfigDataTest, GetValueEmpty) {
   EXPECT_EQ(holder.GetValue("key2", "namespace2"), "");
 }
 
+TEST(NamespacedConfigDataTest, GetNamespace) {
+  NamespaceKeyValueMap m({{"namespace1", {{"key1", "value1"}}}});
+  NamespacedConfigData holder(m, 0);
+  const std::map<std::string, std::string>* values =
+      holder.GetNamespace("namespace1");
+  ASSERT_NE(values, nullptr);
+  EXPECT_THAT(*values, ElementsAre(::testing::Pair("key1", "value1")));
+  EXPECT_EQ(holder.GetNamespace("namespace2"), nullptr);
+}
+
 TEST(NamespacedConfigDataTest, GetKeysByPrefix) {
   NamespaceKeyValueMap m(
       {{"namespace1",
@@ -38,6 +38,7 @@ TEST(RemoteConfigMetadataTest, Serialization) {
                   kFetchFailureReasonThrottled, 1498758888}));
   remote_config_metadata.set_digest_by_namespace(
       MetaDigestMap({{"namespace1", "digest1"}, {"namespace2", "digest2"}}));
+  remote_config_metadata.set_template_version(42);
   remote_config_metadata.AddSetting(kConfigSettingDeveloperMode, "0");
 
   std::string buffer = remote_config_metadata.Serialize();
@@ -70,6 +71,14 @@ TEST(RemoteConfigMetadataTest, SetAndGetDigest) {
   EXPECT_EQ(m.digest_by_namespace(), digest);
 }
 
+TEST(RemoteConfigMetadataTest, SetAndGetTemplateVersion) {
+  RemoteConfigMetadata m;
+  EXPECT_EQ(m.template_version(), 0);
+
+  m.set_template_version(42);
+  EXPECT_EQ(m.template_version(), 42);
+}
+
 TEST(RemoteConfigMetadataTest, SetAndGetSetting) {
   RemoteConfigMetadata m;
   EXPECT_EQ(m.GetSetting(kConfigSettingDeveloperMode), "0");
@@ -0,0 +1,396 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "remote_config/src/desktop/realtime_handler.h"
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "app/rest/controller_interface.h"
+#include "app/rest/transport_interface.h"
+#include "app/src/include/firebase/internal/mutex.h"
+#include "app/src/semaphore.h"
+#include "firebase/app.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace remote_config {
+namespace internal {
+
+using ::testing::Contains;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Key;
+using ::testing::Not;
+using ::testing::Pair;
+
+// How long to wait for something that is expected to happen.
+const int kTimeoutInMilliseconds = 5000;
+
+// Stands in for the real-time backend. Holds at most one open connection,
+// and lets the test send chunks of the stream and close it.
+class FakeStreamServer {
+ public:
+  FakeStreamServer() : response_(nullptr), connected_(0), disconnected_(0) {}
+
+  // Waits for the next connection, and assigns its request body to `body`
+  // and its headers to `headers`.
+  bool WaitForConnection(
+      std::string* body = nullptr,
+      std::map<std::string, std::string>* headers = nullptr) {
+    if (!connected_.TimedWait(kTimeoutInMilliseconds)) return false;
+    MutexLock lock(mutex_);
+    if (body) *body = body_;
+    if (headers) *headers = headers_;
+    return true;
+  }
+
+  // Waits for the open connection to be dropped by the client.
+  bool WaitForDisconnection() {
+    return disconnected_.TimedWait(kTimeoutInMilliseconds);
+  }
+
+  // Sends a chunk of the stream.
+  void Send(const char* chunk) {
+    MutexLock lock(mutex_);
+    if (!response_) return;
+    response_->set_status(200);
+    response_->ProcessBody(chunk, strlen(chunk));
+  }
+
+  // Ends the stream with `status`.
+  void Close(int status) {
+    MutexLock lock(mutex_);
+    if (!response_) return;
+    response_->set_status(status);
+    response_->MarkCompleted();
+    response_ = nullptr;
+  }
+
+  void Connect(rest::Request* request, rest::Response* response) {
+    MutexLock lock(mutex_);
+    response_ = response;
+    request->ReadBodyIntoString(&body_);
+    headers_ = request->options().header;
+    connected_.Post();
+  }
+
+  void Cancel(rest::Response* response) {
+    MutexLock lock(mutex_);
+    if (response_ != response) return;
+    response_->set_status(204);
+    response_->MarkFailed();
+    response_ = nullptr;
+  }
+
+  void Disconnect(rest::Response* response) {
+    MutexLock lock(mutex_);
+    if (response_ == response) response_ = nullptr;
+    disconnected_.Post();
+  }
+
+ private:
+  Mutex mutex_;
+  rest::Response* response_;
+  std::string body_;
+  std::map<std::string, std::string> headers_;
+  Semaphore connected_;
+  Semaphore disconnected_;
+};
+
+FakeStreamServer* g_server = nullptr;
+
+class FakeStreamController : public rest::Controller {
+ public:
+  explicit FakeStreamController(rest::Response* response)
+      : response_(response) {}
+
+  bool Pause() override { return false; }
+  bool Resume() override { return false; }
+  bool IsPaused() override { return false; }
+  bool Cancel() override {
+    g_server->Cancel(response_);
+    return true;
+  }
+  float Progress() override { return 0; }
+  int64_t TransferSize() override { return 0; }
+  int64_t BytesTransferred() override { return 0; }
+
+ private:
+  rest::Response* response_;
+};
+
+// An asynchronous transport connected to g_server.
+class FakeStreamTransport : public rest::Transport {
+ public:
+  FakeStreamTransport() : response_(nullptr) {}
+  ~FakeStreamTransport() override {
+    if (response_) g_server->Disconnect(response_);
+  }
+
+  static flatbuffers::unique_ptr<rest::Transport> Create() {
+    return flatbuffers::unique_ptr<rest::Transport>(new FakeStreamTransport());
+  }
+
+ private:
+  void PerformInternal(
+      rest::Request* request, rest::Response* response,
+      flatbuffers::unique_ptr<rest::Controller>* controller_out) override {
+    response_ = response;
+    if (controller_out) {
+      controller_out->reset(new FakeStreamController(response));
+    }
+    g_server->Connect(request, response);
+  }
+
+  rest::Response* response_;
+};
+
+class ConfigRealtimeHandlerTest : public ::testing::Test {
+ protected:
+  ConfigRealtimeHandlerTest()
+      : template_version_(1),
+        fetch_succeeds_(true),
+        has_installation_(true),
+        updated_(0) {}
+
+  void SetUp() override {
+    g_server = &server_;
+    AppOptions options;
+    options.set_app_id("1:123456789:android:abcdef");
+    options.set_api_key("api-key");
+    options.set_project_id("project-id");
+    handler_.reset(new ConfigRealtimeHandler(
+        options, "firebase",
+        [this](int64_t template_version,
+               std::vector<std::string>* updated_keys) {
+          MutexLock lock(mutex_);
+          fetched_versions_.push_back(template_version);
+          if (!fetch_succeeds_) return false;
+          template_version_ = template_version;
+          *updated_keys = {"changed_key"};
+          return true;
+        },
+        [this]() {
+          MutexLock lock(mutex_);
+          return template_version_;
+        },
+        [this](std::string* installations_id,
+               std::string* installations_token) {
+          MutexLock lock(mutex_);
+          if (!has_installation_) return false;
+          *installations_id = "installation-id";
+          *installations_token = "installation-token";
+          return true;
+        },
+        FakeStreamTransport::Create));
+    handler_->initial_backoff_ms_ = 1;
+    handler_->max_backoff_ms_ = 1;
+  }
+
+  void TearDown() override {
+    handler_.reset(nullptr);
+    g_server = nullptr;
+  }
+
+  int AddListener() {
+    return handler_->AddListener(
+        [this](ConfigUpdate&& config_update, RemoteConfigError error) {
+          {
+            MutexLock lock(mutex_);
+            updates_.push_back(std::move(config_update.updated_keys));
+            errors_.push_back(error);
+          }
+          updated_.Post();
+        });
+  }
+
+  void RemoveListener(int listener_id) {
+    handler_->RemoveListener(listener_id);
+  }
+
+  bool WaitForUpdate() { return updated_.TimedWait(kTimeoutInMilliseconds); }
+
+  void set_fetch_succeeds(bool fetch_succeeds) {
+    MutexLock lock(mutex_);
+    fetch_succeeds_ = fetch_succeeds;
+  }
+
+  void set_has_installation(bool has_installation) {
+    MutexLock lock(mutex_);
+    has_installation_ = has_installation;
+  }
+
+  std::vector<int64_t> fetched_versions() {
+    MutexLock lock(mutex_);
+    return fetched_versions_;
+  }
+
+  std::vector<std::vector<std::string>> updates() {
+    MutexLock lock(mutex_);
+    return updates_;
+  }
+
+  std::vector<RemoteConfigError> errors() {
+    MutexLock lock(mutex_);
+    return errors_;
+  }
+
+  // Declared before the handler, which uses it until it is destroyed.
+  FakeStreamServer server_;
+
+  Mutex mutex_;
+  int64_t template_version_;
+  bool fetch_succeeds_;
+  bool has_installation_;
+  std::vector<int64_t> fetched_versions_;
+  std::vector<std::vector<std::string>> updates_;
+  std::vector<RemoteConfigError> errors_;
+  Semaphore updated_;
+
+  std::unique_ptr<ConfigRealtimeHandler> handler_;
+};
+
+TEST_F(ConfigRealtimeHandlerTest, ConnectsWithLastKnownVersion) {
+  AddListener();
+  std::string body;
+  ASSERT_TRUE(server_.WaitForConnection(&body));
+  EXPECT_THAT(body, HasSubstr("\"project\":\"123456789\""));
+  EXPECT_THAT(body, HasSubstr("\"namespace\":\"firebase\""));
+  EXPECT_THAT(body, HasSubstr("\"lastKnownVersionNumber\":\"1\""));
+  EXPECT_THAT(body, HasSubstr("\"appId\":\"1:123456789:android:abcdef\""));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, ConnectsWithInstallation) {
+  AddListener();
+  std::string body;
+  std::map<std::string, std::string> headers;
+  ASSERT_TRUE(server_.WaitForConnection(&body, &headers));
+  EXPECT_THAT(body, HasSubstr("\"appInstanceId\":\"installation-id\""));
+  EXPECT_THAT(headers, Contains(Pair("X-Goog-Firebase-Installations-Auth",
+                                     "installation-token")));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, ConnectsWithoutInstallation) {
+  set_has_installation(false);
+  AddListener();
+  std::string body;
+  std::map<std::string, std::string> headers;
+  ASSERT_TRUE(server_.WaitForConnection(&body, &headers));
+  EXPECT_THAT(body, Not(HasSubstr("appInstanceId")));
+  EXPECT_THAT(headers,
+              Not(Contains(Key("X-Goog-Firebase-Installations-Auth"))));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, FetchesNewTemplate) {
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Send("[{\"latestTemplateVersionNumber\": \"2\"}");
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(fetched_versions(), ElementsAre(2));
+  EXPECT_THAT(updates(), ElementsAre(ElementsAre("changed_key")));
+  EXPECT_THAT(errors(), ElementsAre(kRemoteConfigErrorNone));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, IgnoresTemplatesThatAreNotNewer) {
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Send("[{\"latestTemplateVersionNumber\": \"1\"}");
+  server_.Send(",{\"latestTemplateVersionNumber\": \"3\"}");
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(fetched_versions(), ElementsAre(3));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, JoinsMessagesSplitAcrossChunks) {
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Send("[{\"latestTemplate");
+  server_.Send("VersionNumber\": 2, \"note\": \"}{\\\"\"");
+  server_.Send("}");
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(fetched_versions(), ElementsAre(2));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, DisconnectsWhenLastListenerIsRemoved) {
+  int first = AddListener();
+  int second = AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  RemoveListener(first);
+  server_.Send("[{\"latestTemplateVersionNumber\": \"2\"}");
+  ASSERT_TRUE(WaitForUpdate());
+  RemoveListener(second);
+  EXPECT_TRUE(server_.WaitForDisconnection());
+  EXPECT_THAT(updates(), ElementsAre(ElementsAre("changed_key")));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, ReconnectsAfterStreamEnds) {
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Close(200);
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Close(503);
+  ASSERT_TRUE(server_.WaitForConnection());
+  EXPECT_THAT(errors(), IsEmpty());
+}
+
+TEST_F(ConfigRealtimeHandlerTest, FailsAfterTooManyRetries) {
+  AddListener();
+  for (int i = 0; i <= kRealtimeMaxStreamRetries; ++i) {
+    ASSERT_TRUE(server_.WaitForConnection());
+    server_.Close(503);
+  }
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(errors(), ElementsAre(kRemoteConfigErrorConfigUpdateStreamError));
+}
+
+TEST_F(ConfigRealtimeHandlerTest, FailsAfterPermanentErrorUntilListenerAdded) {
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Close(403);
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(errors(), ElementsAre(kRemoteConfigErrorConfigUpdateStreamError));
+  AddListener();
+  EXPECT_TRUE(server_.WaitForConnection());
+}
+
+TEST_F(ConfigRealtimeHandlerTest, FailsWhenFeatureIsDisabled) {
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Send("[{\"featureDisabled\": true}");
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(errors(),
+              ElementsAre(kRemoteConfigErrorConfigUpdateUnavailable));
+  EXPECT_TRUE(server_.WaitForDisconnection());
+}
+
+TEST_F(ConfigRealtimeHandlerTest, ReportsTemplatesThatCannotBeFetched) {
+  set_fetch_succeeds(false);
+  AddListener();
+  ASSERT_TRUE(server_.WaitForConnection());
+  server_.Send("[{\"latestTemplateVersionNumber\": 2}");
+  ASSERT_TRUE(WaitForUpdate());
+  EXPECT_THAT(fetched_versions(), ElementsAre(2, 2, 2));
+  EXPECT_THAT(updates(), ElementsAre(IsEmpty()));
+  EXPECT_THAT(errors(), ElementsAre(kRemoteConfigErrorConfigUpdateNotFetched));
+}
+
+}  // namespace internal
+}  // namespace remote_config
+}  // namespace firebase
@@ -31,6 +31,9 @@ namespace firebase {
 namespace remote_config {
 namespace internal {
 
+// Counts the fetches made through the fake REST implementation.
+extern int g_fake_fetch_count;
+
 class RemoteConfigDesktopTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -284,6 +287,78 @@ TEST_F(RemoteConfigDesktopTest, GetKeysByPrefix) {
   }
 }
 
+TEST_F(RemoteConfigDesktopTest, GetAll) {
+  instance_->configs_.defaults.SetNamespace(
+      {{"key_long", "1"}, {"key_default", "bbb"}},
+      RemoteConfigInternal::kDefaultNamespace);
+  std::map<std::string, Variant> all = instance_->GetAll();
+  EXPECT_THAT(all, ::testing::ElementsAre(
+                       ::testing::Pair("key_bool", Variant(false)),
+                       ::testing::Pair("key_data", Variant("zzz")),
+                       ::testing::Pair("key_default", Variant("bbb")),
+                       ::testing::Pair("key_double", Variant(100.5)),
+                       ::testing::Pair("key_long", Variant(55555)),
+                       ::testing::Pair("key_string", Variant("aaa"))));
+}
+
+TEST_F(RemoteConfigDesktopTest, GetValues) {
+  instance_->configs_.defaults.SetNamespace(
+      {{"key_long", "1"}, {"key_default", "bbb"}},
+      RemoteConfigInternal::kDefaultNamespace);
+  ConfigValue values[] = {
+      ConfigValue("key_bool", kValueTypeBoolean),
+      ConfigValue("key_long", kValueTypeLong),
+      ConfigValue("key_double", kValueTypeDouble),
+      ConfigValue("key_string", kValueTypeString),
+      ConfigValue("key_data", kValueTypeData),
+      ConfigValue("key_default", kValueTypeString),
+      ConfigValue("key_missing", kValueTypeLong),
+      ConfigValue("key_string", kValueTypeLong),
+  };
+  values[0].boolean_value = true;
+  values[3].string_value = "stale value";
+  instance_->GetValues(values, sizeof(values) / sizeof(values[0]));
+
+  // Each entry matches the getter for its type.
+  for (const ConfigValue& value : values) {
+    ValueInfo info;
+    switch (value.type) {
+      case kValueTypeBoolean:
+        EXPECT_EQ(value.boolean_value, instance_->GetBoolean(value.key, &info));
+        break;
+      case kValueTypeLong:
+        EXPECT_EQ(value.long_value, instance_->GetLong(value.key, &info));
+        break;
+      case kValueTypeDouble:
+        EXPECT_EQ(value.double_value, instance_->GetDouble(value.key, &info));
+        break;
+      case kValueTypeString:
+        EXPECT_EQ(value.string_value, instance_->GetString(value.key, &info));
+        break;
+      case kValueTypeData:
+        EXPECT_EQ(value.data_value, instance_->GetData(value.key, &info));
+        break;
+    }
+    EXPECT_EQ(value.info.source, info.source) << value.key;
+    EXPECT_EQ(value.info.conversion_successful, info.conversion_successful)
+        << value.key;
+  }
+
+  EXPECT_FALSE(values[0].boolean_value);
+  EXPECT_EQ(values[1].long_value, 55555);
+  EXPECT_EQ(values[1].info.source, kValueSourceRemoteValue);
+  EXPECT_EQ(values[3].string_value, "aaa");
+  EXPECT_THAT(values[4].data_value,
+              ::testing::Eq(std::vector<unsigned char>{'z', 'z', 'z'}));
+  EXPECT_EQ(values[5].string_value, "bbb");
+  EXPECT_EQ(values[5].info.source, kValueSourceDefaultValue);
+  EXPECT_EQ(values[6].long_value, 0);
+  EXPECT_EQ(values[6].info.source, kValueSourceStaticValue);
+  EXPECT_TRUE(values[6].info.conversion_successful);
+  EXPECT_EQ(values[7].long_value, 0);
+  EXPECT_FALSE(values[7].info.conversion_successful);
+}
+
 TEST_F(RemoteConfigDesktopTest, GetInfo) {
   ConfigInfo info = instance_->GetInfo();
   EXPECT_EQ(info.fetch_time, 1498757224);
@@ -386,6 +461,19 @@ TEST_F(RemoteConfigDesktopTest, Fetch) {
   }
 }
 
+TEST_F(RemoteConfigDesktopTest, FetchTwice) {
+  // Both fetch, because a completed fetch does not leave one pending.
+  int fetch_count = g_fake_fetch_count;
+  Future<void> future = instance_->Fetch(0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(future.status(), firebase::kFutureStatusComplete);
+  future = instance_->Fetch(0);
+  EXPECT_EQ(future.status(), firebase::kFutureStatusPending);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(future.status(), firebase::kFutureStatusComplete);
+  EXPECT_EQ(g_fake_fetch_count, fetch_count + 2);
+}
+
 TEST_F(RemoteConfigDesktopTest, TestIsBoolTrue) {
   // Confirm all the values that ARE BoolTrue.
   EXPECT_TRUE(RemoteConfigInternal::IsBoolTrue("1"));
@@ -190,9 +190,30 @@ TEST_F(RemoteConfigRESTTest, SetupRESTRequest) {
               locale.substr(0, 2));
   }
 
+  EXPECT_EQ(request_options.accept_encoding, kGzipEncodingValue);
+  EXPECT_EQ(request_options.header.find(kIfNoneMatchHeader),
+            request_options.header.end());
+
   // TODO(cynthiajiang) verify installations id and token.
 }
 
+// Check that the ETag of the last fetch makes the request conditional.
+TEST_F(RemoteConfigRESTTest, SetupRESTRequestWithEtag) {
+  configs_.metadata.set_digest_by_namespace(
+      MetaDigestMap({{kTestNamespaces, "etag-1"}}));
+  RemoteConfigREST rest(app_->options(), configs_, kTestNamespaces);
+  rest.SetupRestRequest(*app_, kDefaultTimeoutInMilliseconds);
+
+  EXPECT_EQ(rest.rc_request_.options().header[kIfNoneMatchHeader],
+            "etag-1");
+
+  // Without an ETag the request is no longer conditional.
+  rest.configs_.metadata.set_digest_by_namespace(MetaDigestMap());
+  rest.SetupRestRequest(*app_, kDefaultTimeoutInMilliseconds);
+  EXPECT_EQ(rest.rc_request_.options().header.find(kIfNoneMatchHeader),
+            rest.rc_request_.options().header.end());
+}
+
 // Verify the rest request with mock project will return code 404
 TEST_F(RemoteConfigRESTTest, Fetch) {
   int codes[] = {404};
@@ -219,6 +240,55 @@ TEST_F(RemoteConfigRESTTest, Fetch) {
   }
 }
 
+// Verify that a not modified response keeps the fetched config.
+TEST_F(RemoteConfigRESTTest, FetchNotModified) {
+  char config[1000];
+  snprintf(config, sizeof(config),
+           "{"
+           "  config:["
+           "    {fake:'%s/%s/%s/%s%s%s',"
+           "     httpresponse: {"
+           "       header: ['HTTP/1.1 304 Not Modified','ETag:etag-1'],"
+           "       body: []"
+           "     }"
+           "    }"
+           "  ]"
+           "}",
+           kServerURL, app_->options().project_id(), kNameSpaceString,
+           kTestNamespaces, kHTTPFetchKeyString, app_->options().api_key());
+  firebase::testing::cppsdk::ConfigSet(config);
+
+  configs_.metadata.set_digest_by_namespace(
+      MetaDigestMap({{kTestNamespaces, "etag-1"}}));
+  RemoteConfigREST rest(app_->options(), configs_, kTestNamespaces);
+  rest.Fetch(*app_, 3600);
+
+  EXPECT_EQ(rest.rc_response_.status(), kHTTPStatusNotModified);
+  EXPECT_FALSE(rest.fetched_config_changed());
+  EXPECT_EQ(rest.fetched().config(), configs_.fetched.config());
+  EXPECT_GT(rest.fetched().timestamp(), configs_.fetched.timestamp());
+  EXPECT_EQ(rest.metadata().digest_by_namespace(),
+            configs_.metadata.digest_by_namespace());
+  EXPECT_EQ(rest.metadata().info().last_fetch_status, kLastFetchStatusSuccess);
+}
+
+TEST_F(RemoteConfigRESTTest, ParseRestResponseNotModified) {
+  std::string header = "HTTP/1.1 304 Not Modified";
+
+  RemoteConfigREST rest(app_->options(), configs_, kTestNamespaces);
+  rest.rc_response_.ProcessHeader(header.data(), header.length());
+  rest.rc_response_.MarkCompleted();
+
+  rest.ParseRestResponse();
+
+  EXPECT_FALSE(rest.fetched_config_changed());
+  EXPECT_EQ(rest.fetched().config(), configs_.fetched.config());
+  ConfigInfo info = rest.metadata().info();
+  EXPECT_EQ(info.last_fetch_status, kLastFetchStatusSuccess);
+  EXPECT_LE(info.fetch_time, MillisecondsSinceEpoch());
+  EXPECT_GE(info.fetch_time, MillisecondsSinceEpoch() - 10000);
+}
+
 TEST_F(RemoteConfigRESTTest, ParseRestResponseProtoFailure) {
   std::string header = "HTTP/1.1 200 Ok";
   std::string body = "";
@@ -237,14 +307,21 @@ TEST_F(RemoteConfigRESTTest, ParseRestResponseProtoFailure) {
 TEST_F(RemoteConfigRESTTest, ParseRestResponseSuccess) {
   std::string header = "HTTP/1.1 200 Ok";
 
+  std::string etag_header = "ETag: etag-2";
+
   RemoteConfigREST rest(app_->options(), configs_, kTestNamespaces);
   rest.rc_response_.ProcessHeader(header.data(), header.length());
+  rest.rc_response_.ProcessHeader(etag_header.data(), etag_header.length());
   rest.rc_response_.ProcessBody(response_body_.data(), response_body_.length());
   rest.rc_response_.MarkCompleted();
   EXPECT_EQ(rest.rc_response_.status(), 200);
 
   rest.ParseRestResponse();
 
+  EXPECT_TRUE(rest.fetched_config_changed());
+  EXPECT_EQ(rest.metadata().digest_by_namespace(),
+            MetaDigestMap({{kTestNamespaces, "etag-2"}}));
+
   std::map<std::string, std::string> empty_map;
   EXPECT_THAT(rest.fetched().config(),
               ::testing::ContainerEq(NamespaceKeyValueMap({
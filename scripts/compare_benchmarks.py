@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+
+# Copyright 2020 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Compares two sets of Google Benchmark results to detect regressions.
+
+Both files are the JSON written by a benchmark binary run with
+--benchmark_out=<file> --benchmark_out_format=json, for example by the
+run_firebase_app_benchmarks build target. Typically the first file comes from
+the base commit and the second from the change under test:
+
+  compare_benchmarks.py baseline.json firebase_app_benchmarks.json
+
+When the runs used --benchmark_repetitions, the median of the repetitions is
+compared, which is much less noisy than a single run.
+
+Returns:
+   0: No benchmark got slower by more than the threshold.
+   1: At least one benchmark got slower by more than the threshold.
+   2: The results could not be read.
+"""
+import json
+import sys
+
+from absl import app
+from absl import flags
+
+# Flag Definitions:
+FLAGS = flags.FLAGS
+
+flags.DEFINE_float('threshold', 10.0,
+  'Percentage by which a benchmark must slow down to count as a regression.')
+flags.DEFINE_enum('metric', 'real_time', ['real_time', 'cpu_time'],
+  'Which time to compare.')
+flags.DEFINE_string('filter', None,
+  'Only compare benchmarks whose name contains this string.')
+
+
+# Functions:
+def load_results(filename):
+  """Reads benchmark results, returning a map from name to time.
+
+  Args:
+    filename (string): path to a Google Benchmark JSON output file.
+
+  Returns:
+    dict: the time of each benchmark in nanoseconds, keyed by benchmark name.
+      If the file has repeated runs, the median of the repetitions is used.
+  """
+  with open(filename) as results_file:
+    results = json.load(results_file)
+
+  unit_to_ns = {'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+  times = {}
+  medians = {}
+  for benchmark in results.get('benchmarks', []):
+    if benchmark.get('error_occurred'):
+      continue
+    time = benchmark[FLAGS.metric] * unit_to_ns[benchmark.get('time_unit',
+                                                              'ns')]
+    if benchmark.get('run_type') == 'aggregate':
+      if benchmark.get('aggregate_name') == 'median':
+        medians[benchmark['run_name']] = time
+      continue
+    # Without aggregates, keep the first run of each benchmark.
+    times.setdefault(benchmark.get('run_name', benchmark['name']), time)
+  times.update(medians)
+  return times
+
+
+def format_time(ns):
+  """Formats a time in nanoseconds with a readable unit."""
+  for unit, scale in (('s', 1e9), ('ms', 1e6), ('us', 1e3)):
+    if ns >= scale:
+      return '%.3g %s' % (ns / scale, unit)
+  return '%.3g ns' % ns
+
+
+def main(argv):
+  if len(argv) != 3:
+    print('Usage: %s [flags] <baseline.json> <contender.json>' % argv[0],
+          file=sys.stderr)
+    return 2
+  try:
+    baseline = load_results(argv[1])
+    contender = load_results(argv[2])
+  except (IOError, ValueError, KeyError) as e:
+    print('Failed to read benchmark results: %s' % e, file=sys.stderr)
+    return 2
+
+  names = [name for name in baseline if name in contender and
+           (not FLAGS.filter or FLAGS.filter in name)]
+  if not names:
+    print('No benchmarks in common.', file=sys.stderr)
+    return 2
+
+  width = max(len(name) for name in names)
+  print('%-*s %12s %12s %9s' % (width, 'Benchmark', 'Baseline', 'Contender',
+                                'Change'))
+  regressions = []
+  for name in names:
+    before = baseline[name]
+    after = contender[name]
+    change = (after - before) * 100.0 / before if before else 0.0
+    marker = ''
+    if change > FLAGS.threshold:
+      regressions.append(name)
+      marker = '  REGRESSION'
+    elif change < -FLAGS.threshold:
+      marker = '  improvement'
+    print('%-*s %12s %12s %+8.1f%%%s' % (width, name, format_time(before),
+                                         format_time(after), change, marker))
+
+  for name in sorted(set(baseline) ^ set(contender)):
+    if not FLAGS.filter or FLAGS.filter in name:
+      print('%s: only in %s' % (name, 'baseline' if name in baseline
+                                 else 'contender'))
+
+  if regressions:
+    print('\n%d of %d benchmarks regressed by more than %g%%.' %
+          (len(regressions), len(names), FLAGS.threshold))
+    return 1
+  return 0
+
+
+if __name__ == '__main__':
+  app.run(main)